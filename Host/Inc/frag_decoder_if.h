@@ -0,0 +1,92 @@
+/**
+  ******************************************************************************
+  * @file    frag_decoder_if.h
+  * @author  MCD Application Team
+  * @brief   Host build: settings of the LoRa-Alliance fragmentation decoder
+  *
+  * Each setting can be overloaded from the build (-D) by a host target. The
+  * flash interface of the applications is replaced by the callbacks of the
+  * host tests.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FRAG_DECODER_IF_H__
+#define __FRAG_DECODER_IF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported defines ----------------------------------------------------------*/
+/*!
+  * Maximum number of fragment that can be handled.
+  */
+#ifndef FRAG_MAX_NB
+#define FRAG_MAX_NB                                 2151
+#endif /* FRAG_MAX_NB */
+
+/*!
+  * Maximum fragment size that can be handled.
+  */
+#ifndef FRAG_MAX_SIZE
+#define FRAG_MAX_SIZE                               240
+#endif /* FRAG_MAX_SIZE */
+
+/*!
+  * Minimum fragment size that can be handled.
+  */
+#ifndef FRAG_MIN_SIZE
+#define FRAG_MIN_SIZE                               40
+#endif /* FRAG_MIN_SIZE */
+
+/*!
+  * Maximum number of extra frames that can be handled.
+  */
+#ifndef FRAG_MAX_REDUNDANCY
+#define FRAG_MAX_REDUNDANCY                         216
+#endif /* FRAG_MAX_REDUNDANCY */
+
+/*!
+  * Size of the flash region of the sessions sharing the decoder of the fragmentation package.
+  */
+#ifndef FRAG_DECODER_DWL_REGION_SIZE
+#define FRAG_DECODER_DWL_REGION_SIZE                ( FRAG_MAX_NB * FRAG_MAX_SIZE )
+#endif /* FRAG_DECODER_DWL_REGION_SIZE */
+
+/*!
+  * Maximum number of coded fragments queued by the decoder.
+  */
+#ifndef FRAG_DECODER_MAX_PENDING
+#define FRAG_DECODER_MAX_PENDING                    4
+#endif /* FRAG_DECODER_MAX_PENDING */
+
+/*!
+  * Number of rows of the lost fragments kept in RAM by the decoder.
+  */
+#ifndef FRAG_DECODER_ROW_CACHE_SIZE
+#define FRAG_DECODER_ROW_CACHE_SIZE                 0
+#endif /* FRAG_DECODER_ROW_CACHE_SIZE */
+
+/*!
+  * Size of the aligned blocks in which the decoder combines its flash writes.
+  */
+#ifndef FRAG_DECODER_WRITE_BLOCK_SIZE
+#define FRAG_DECODER_WRITE_BLOCK_SIZE               0
+#endif /* FRAG_DECODER_WRITE_BLOCK_SIZE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRAG_DECODER_IF_H__ */
@@ -0,0 +1,131 @@
+/**
+  ******************************************************************************
+  * @file    lorawan_conf.h
+  * @author  MCD Application Team
+  * @brief   Host build: header for LoRaWAN middleware instances
+  *
+  * Each setting can be overloaded from the build (-D) by a host target.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LORAWAN_CONF_H__
+#define __LORAWAN_CONF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "utilities_conf.h"
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * @brief LoRaWAN version definition
+ */
+#ifndef LORAMAC_SPECIFICATION_VERSION
+#define LORAMAC_SPECIFICATION_VERSION                   0x01000400
+#endif /* LORAMAC_SPECIFICATION_VERSION */
+
+/*!
+ * @brief LoRaWAN Keys integrated in KMS Middleware
+ */
+#ifndef LORAWAN_KMS
+#define LORAWAN_KMS                                     0
+#endif /* LORAWAN_KMS */
+
+/*!
+ * @brief Enable the additional LoRaWAN packages
+ */
+#ifndef LORAWAN_DATA_DISTRIB_MGT
+#define LORAWAN_DATA_DISTRIB_MGT                        1
+#endif /* LORAWAN_DATA_DISTRIB_MGT */
+
+/*!
+ * @brief LoRaWAN packages version
+ */
+#ifndef LORAWAN_PACKAGES_VERSION
+#define LORAWAN_PACKAGES_VERSION                        2
+#endif /* LORAWAN_PACKAGES_VERSION */
+
+/* Region ------------------------------------*/
+/* A host target selects its regions with -DREGION_XXX, all of them are linked by default */
+#if !defined( REGION_AS923 ) && !defined( REGION_AU915 ) && !defined( REGION_CN470 ) && \
+    !defined( REGION_CN779 ) && !defined( REGION_EU433 ) && !defined( REGION_EU868 ) && \
+    !defined( REGION_KR920 ) && !defined( REGION_IN865 ) && !defined( REGION_US915 ) && \
+    !defined( REGION_RU864 )
+#define REGION_AS923
+#define REGION_AU915
+#define REGION_CN470
+#define REGION_CN779
+#define REGION_EU433
+#define REGION_EU868
+#define REGION_KR920
+#define REGION_IN865
+#define REGION_US915
+#define REGION_RU864
+#endif /* REGION_XXX */
+
+/*!
+ * @brief Default channel plan for region AS923
+ */
+#define REGION_AS923_DEFAULT_CHANNEL_PLAN              CHANNEL_PLAN_GROUP_AS923_1
+
+/*!
+ * @brief Limits the number usable channels by default for AU915, CN470 and US915 regions
+ */
+#define HYBRID_ENABLED                                  0
+
+/*!
+ * @brief Define the read access of the keys in memory
+ */
+#define KEY_EXTRACTABLE                                 1
+
+/*!
+ * @brief Enables/Disables the context storage management storage
+ */
+#define CONTEXT_MANAGEMENT_ENABLED                      1
+
+/* Class B ------------------------------------*/
+/*!
+ * @brief Enables/Disables the LoRaWAN Class B (Periodic ping downlink slots + Beacon for synchronization)
+ */
+#ifndef LORAMAC_CLASSB_ENABLED
+#define LORAMAC_CLASSB_ENABLED                          0
+#endif /* LORAMAC_CLASSB_ENABLED */
+
+#if ( LORAMAC_CLASSB_ENABLED == 1 )
+#define RTC_TEMP_COEFFICIENT                            ( -0.035 )
+#define RTC_TEMP_DEV_COEFFICIENT                        ( 0.0035 )
+#define RTC_TEMP_TURNOVER                               ( 25.0 )
+#define RTC_TEMP_DEV_TURNOVER                           ( 5.0 )
+#endif /* LORAMAC_CLASSB_ENABLED == 1 */
+
+/*!
+ * @brief Disable the ClassA receive windows after Tx
+ */
+#define DISABLE_LORAWAN_RX_WINDOW                       0
+
+/* Exported macro ------------------------------------------------------------*/
+#ifndef CRITICAL_SECTION_BEGIN
+#define CRITICAL_SECTION_BEGIN( )      UTILS_ENTER_CRITICAL_SECTION( )
+#endif /* !CRITICAL_SECTION_BEGIN */
+#ifndef CRITICAL_SECTION_END
+#define CRITICAL_SECTION_END( )        UTILS_EXIT_CRITICAL_SECTION( )
+#endif /* !CRITICAL_SECTION_END */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LORAWAN_CONF_H__ */
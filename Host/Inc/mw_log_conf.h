@@ -0,0 +1,40 @@
+/**
+  ******************************************************************************
+  * @file    mw_log_conf.h
+  * @author  MCD Application Team
+  * @brief   Host build: middleware log configuration
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MW_LOG_CONF_H__
+#define __MW_LOG_CONF_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include "utilities_conf.h"
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * @brief Verbose level of the middleware logs printed on stdout, VLEVEL_OFF by default
+ */
+#ifndef HOST_MW_LOG_LEVEL
+#define HOST_MW_LOG_LEVEL                  VLEVEL_OFF
+#endif /* HOST_MW_LOG_LEVEL */
+
+/* Exported macro ------------------------------------------------------------*/
+#define MW_LOG_ENABLED
+
+#define MW_LOG(TS,VL,...)   do{ if( ( VL ) <= HOST_MW_LOG_LEVEL ) { printf( __VA_ARGS__ ); } }while(0)
+
+#endif /*__MW_LOG_CONF_H__ */
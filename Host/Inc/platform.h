@@ -0,0 +1,28 @@
+/**
+  ******************************************************************************
+  * @file    platform.h
+  * @author  MCD Application Team
+  * @brief   Host build: common platform definitions
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PLATFORM_H__
+#define __PLATFORM_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#endif /* __PLATFORM_H__ */
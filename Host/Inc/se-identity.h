@@ -0,0 +1,26 @@
+/**
+  ******************************************************************************
+  * @file    se-identity.h
+  * @author  MCD Application Team
+  * @brief   Host build: secure element identity and keys
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __HOST_SE_IDENTITY_H__
+#define __HOST_SE_IDENTITY_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "se-identity_template.h"
+
+#endif /* __HOST_SE_IDENTITY_H__ */
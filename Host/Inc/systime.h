@@ -0,0 +1,26 @@
+/**
+  ******************************************************************************
+  * @file    systime.h
+  * @author  MCD Application Team
+  * @brief   Host build: map middleware systime
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SYSTIME_H__
+#define __SYSTIME_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32_systime.h"
+
+#endif /* __SYSTIME_H__ */
@@ -0,0 +1,26 @@
+/**
+  ******************************************************************************
+  * @file    timer.h
+  * @author  MCD Application Team
+  * @brief   Host build: wrapper to timer server
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __HOST_TIMER_H__
+#define __HOST_TIMER_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "timer_template.h"
+
+#endif /* __HOST_TIMER_H__ */
@@ -0,0 +1,92 @@
+/**
+  ******************************************************************************
+  * @file    utilities_conf.h
+  * @author  MCD Application Team
+  * @brief   Host build: configuration file to utilities
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UTILITIES_CONF_H__
+#define __UTILITIES_CONF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define VLEVEL_OFF    0  /*!< used to set UTIL_ADV_TRACE_SetVerboseLevel() (not as message param) */
+#define VLEVEL_ALWAYS 0  /*!< used as message params, if this level is given
+                              trace will be printed even when UTIL_ADV_TRACE_SetVerboseLevel(OFF) */
+#define VLEVEL_L 1       /*!< just essential traces */
+#define VLEVEL_M 2       /*!< functional traces */
+#define VLEVEL_H 3       /*!< all traces */
+
+#define TS_OFF 0         /*!< Log without TimeStamp */
+#define TS_ON 1          /*!< Log with TimeStamp */
+
+#define T_REG_OFF  0     /*!< Log without bitmask */
+
+/* Exported macros -----------------------------------------------------------*/
+/******************************************************************************
+  * common
+  ******************************************************************************/
+/**
+  * @brief Memory placement macro, no sections on the host
+  */
+#define UTIL_PLACE_IN_SECTION( __x__ )
+
+/**
+  * @brief Memory alignment macro
+  */
+#undef ALIGN
+#define ALIGN(n)             __attribute__((aligned(n)))
+
+/**
+  * @brief Critical section macros: the host build is single threaded and the
+  *        virtual radio and time events run from the main loop
+  */
+#define UTILS_INIT_CRITICAL_SECTION()
+#define UTILS_ENTER_CRITICAL_SECTION()
+#define UTILS_EXIT_CRITICAL_SECTION()
+
+/******************************************************************************
+  * sequencer
+  ******************************************************************************/
+/**
+  * @brief default number of tasks configured in sequencer
+  */
+#define UTIL_SEQ_CONF_TASK_NBR    32
+
+/**
+  * @brief default value of priority task
+  */
+#define UTIL_SEQ_CONF_PRIO_NBR    2
+
+/**
+  * @brief sequencer critical section and memset interfaces
+  */
+#define UTIL_SEQ_INIT_CRITICAL_SECTION( )    UTILS_INIT_CRITICAL_SECTION()
+#define UTIL_SEQ_ENTER_CRITICAL_SECTION( )   UTILS_ENTER_CRITICAL_SECTION()
+#define UTIL_SEQ_EXIT_CRITICAL_SECTION( )    UTILS_EXIT_CRITICAL_SECTION()
+#define UTIL_SEQ_MEMSET8( dest, value, size )   memset( dest, value, size )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__UTILITIES_CONF_H__ */
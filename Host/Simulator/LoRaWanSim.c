@@ -0,0 +1,1157 @@
+/*!
+ * \file      LoRaWanSim.c
+ *
+ * \brief     Multi-node LoRaWAN network simulator running the LoRaMac stack on a host
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \code
+ *                ______                              _
+ *               / _____)             _              | |
+ *              ( (____  _____ ____ _| |_ _____  ____| |__
+ *               \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ *               _____) ) ____| | | || |_| ____( (___| | | |
+ *              (______/|_____)_|_|_| \__)_____)\____)_| |_|
+ *              (C)2013-2017 Semtech
+ *
+ * \endcode
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * The file-static contexts of these modules make the state of one end-device.
+ * They are built in this translation unit so that the simulator can swap them.
+ */
+#include "LoRaMac.c"
+#include "LoRaMacCommands.c"
+#include "LoRaMacConfirmQueue.c"
+#include "soft-se.c"
+#include "stm32_timer.c"
+#include "radio_sim.c"
+
+#include "stm32_timer_if_sim.h"
+#include "cmac.h"
+#include "lorawan_aes.h"
+#include "LoRaWanSim.h"
+
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+#error "The network server of the simulator supports LoRaWAN 1.0.x end-devices only"
+#endif /* LORAMAC_VERSION */
+
+#if !defined( AES_DEC_PREKEYED )
+#error "The network server of the simulator encrypts the join-accepts with lorawan_aes_decrypt, define AES_DEC_PREKEYED"
+#endif /* AES_DEC_PREKEYED */
+
+/*!
+ * Maximum number of time server timers of one end-device (MAC and radio)
+ */
+#define LORAWAN_SIM_MAX_TIMERS                      12
+
+/*!
+ * Log-distance path loss model: loss at the reference distance [dB],
+ * reference distance [m] and path loss exponent
+ */
+#ifndef LORAWAN_SIM_PATH_LOSS_REF
+#define LORAWAN_SIM_PATH_LOSS_REF                   127.41
+#endif
+#ifndef LORAWAN_SIM_PATH_LOSS_REF_DISTANCE
+#define LORAWAN_SIM_PATH_LOSS_REF_DISTANCE          40.0
+#endif
+#ifndef LORAWAN_SIM_PATH_LOSS_EXPONENT
+#define LORAWAN_SIM_PATH_LOSS_EXPONENT              2.08
+#endif
+
+/*!
+ * Noise floor of the gateway in 125 kHz, 6 dB noise figure [dBm]
+ */
+#define LORAWAN_SIM_NOISE_FLOOR                     ( -117.0 )
+
+/*!
+ * Network server ADR: number of uplinks in the SNR history, installation
+ * margin [dB], highest datarate ( SF7 in 125 kHz in the supported regions )
+ * and highest TX power index ( lowest power )
+ */
+#define LORAWAN_SIM_ADR_HISTORY                     20
+#define LORAWAN_SIM_ADR_MARGIN                      10.0
+#define LORAWAN_SIM_ADR_MAX_DR                      DR_5
+#define LORAWAN_SIM_ADR_MAX_TX_POWER                TX_POWER_5
+
+/*!
+ * Number of uplinks after which the network server repeats a LinkAdrReq
+ * the end-device did not apply
+ */
+#define LORAWAN_SIM_ADR_RETRY                       3
+
+/*!
+ * Network identifier and device address prefix of the network server
+ */
+#define LORAWAN_SIM_NET_ID                          0x000013
+#define LORAWAN_SIM_DEV_ADDR_PREFIX                 0x26000000
+
+/*!
+ * Maximum size of a downlink built by the network server
+ */
+#define LORAWAN_SIM_DOWNLINK_MAX_SIZE               33
+
+/*!
+ * Timer of an end-device saved with the end-device image
+ */
+typedef struct sSimTimer
+{
+    UTIL_TIMER_Object_t* Timer;
+    uint32_t Expiry;
+    uint32_t ReloadValue;
+}SimTimer_t;
+
+/*!
+ * End-device: image of the MAC stack contexts, and network server state
+ */
+typedef struct sSimNode
+{
+    /*
+     * MAC stack image
+     */
+    LoRaMacCtx_t MacCtx;
+    LoRaMacNvmData_t Nvm;
+#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    Band_t RegionBands[REGION_NVM_MAX_NB_BANDS];
+#endif /* LORAMAC_VERSION */
+    TxDoneParams_t TxDoneParams;
+    RxDoneParams_t RxDoneParams;
+    LoRaMacCommandsCtx_t CommandsCtx;
+    LoRaMacConfirmQueueCtx_t ConfirmQueueCtx;
+#if (LORAWAN_KMS == 0)
+    AesCtxCacheItem_t AesCtxCache[SOFT_SE_AES_CTX_CACHE_NB];
+    uint32_t AesCtxCacheStamp;
+#endif /* LORAWAN_KMS == 0 */
+    RadioSim_t RadioSim;
+    uint8_t RadioSimBuffer[RADIO_SIM_BUF_SIZE];
+    SimTimer_t Timers[LORAWAN_SIM_MAX_TIMERS];
+    uint8_t NbTimers;
+    /*
+     * End-device
+     */
+    uint32_t Index;
+    uint8_t Key[16];
+    double PathLoss;
+    bool Joined;
+    uint32_t NextUplink;
+    uint32_t WakeStamp;
+    /*
+     * Network server
+     */
+    bool NsJoined;
+    uint32_t JoinTime;
+    uint32_t JoinNonce;
+    uint8_t NwkSKey[16];
+    uint32_t FCntUp;
+    uint32_t FCntDown;
+    int8_t CurrentDr;
+    int8_t TargetDr;
+    int8_t TxPower;
+    uint32_t LastDrChange;
+    uint8_t UplinksSinceLinkAdrReq;
+    uint8_t NbSnr;
+    double SnrHistory[LORAWAN_SIM_ADR_HISTORY];
+    double LastRssi;
+    double LastSnr;
+    uint8_t Downlink[LORAWAN_SIM_DOWNLINK_MAX_SIZE];
+    uint8_t DownlinkSize;
+    uint32_t DownlinkFrequency;
+    uint32_t DownlinkDatarate;
+}SimNode_t;
+
+/*!
+ * Frame on air, from an end-device to the gateway
+ */
+typedef struct sSimTx
+{
+    uint32_t End;
+    uint32_t Frequency;
+    uint32_t Bandwidth;
+    uint32_t Datarate;
+    double Rssi;
+    double Snr;
+    bool Interfered;
+    double Interference;
+    uint8_t Size;
+    uint8_t Payload[RADIO_SIM_BUF_SIZE];
+}SimTx_t;
+
+/*!
+ * Simulation event types
+ */
+typedef enum eSimEventType
+{
+    /*!
+     * An end-device has a timer or an application uplink due
+     */
+    SIM_EVENT_NODE,
+    /*!
+     * A frame ends at the gateway
+     */
+    SIM_EVENT_UPLINK_END,
+}SimEventType_t;
+
+/*!
+ * Simulation event
+ */
+typedef struct sSimEvent
+{
+    uint32_t Time;
+    uint32_t Seq;
+    SimEventType_t Type;
+    uint32_t Index;
+    uint32_t Stamp;
+}SimEvent_t;
+
+/*!
+ * Simulator context
+ */
+typedef struct sLoRaWanSimCtx
+{
+    LoRaWanSimParams_t Params;
+    LoRaWanSimStats_t Stats;
+    SimNode_t* Nodes;
+    /*!
+     * End-device whose image is in the MAC stack, NULL when none
+     */
+    SimNode_t* LiveNode;
+    /*!
+     * Events, binary heap ordered by time then by creation
+     */
+    SimEvent_t* Events;
+    uint32_t NbEvents;
+    uint32_t EventsSize;
+    uint32_t EventSeq;
+    /*!
+     * Frames on air: pool, free slots and frames not yet ended
+     */
+    SimTx_t* Txs;
+    uint32_t TxsSize;
+    uint32_t* FreeTxs;
+    uint32_t NbFreeTxs;
+    uint32_t* ActiveTxs;
+    uint32_t NbActiveTxs;
+    uint32_t Rng;
+}LoRaWanSimCtx_t;
+
+static LoRaWanSimCtx_t SimCtx;
+
+static void SimMcpsConfirm( McpsConfirm_t* mcpsConfirm );
+static void SimMcpsIndication( McpsIndication_t* mcpsIndication, LoRaMacRxStatus_t* rxStatus );
+static void SimMlmeConfirm( MlmeConfirm_t* mlmeConfirm );
+static void SimMlmeIndication( MlmeIndication_t* mlmeIndication, LoRaMacRxStatus_t* rxStatus );
+static void SimOnTxStart( const RadioSimParams_t* params, const uint8_t* payload, uint8_t size, uint32_t timeOnAir );
+static void SimOnRxStart( const RadioSimParams_t* params, uint32_t window );
+
+static LoRaMacPrimitives_t SimPrimitives =
+{
+    .MacMcpsConfirm = SimMcpsConfirm,
+    .MacMcpsIndication = SimMcpsIndication,
+    .MacMlmeConfirm = SimMlmeConfirm,
+    .MacMlmeIndication = SimMlmeIndication,
+};
+
+static LoRaMacCallback_t SimCallbacks;
+
+static const RadioSimObserver_t SimObserver =
+{
+    .TxStart = SimOnTxStart,
+    .RxStart = SimOnRxStart,
+};
+
+/*!
+ * Required demodulation SNR from SF7 to SF12 [dB]
+ */
+static const double SimRequiredSnr[] = { -7.5, -10.0, -12.5, -15.0, -17.5, -20.0 };
+
+static uint32_t SimRandom( void )
+{
+    SimCtx.Rng ^= SimCtx.Rng << 13;
+    SimCtx.Rng ^= SimCtx.Rng >> 17;
+    SimCtx.Rng ^= SimCtx.Rng << 5;
+    return SimCtx.Rng;
+}
+
+/*!
+ * \brief   Uniform random number in [0, 1)
+ */
+static double SimUniform( void )
+{
+    return ( double )( SimRandom( ) >> 8 ) / 16777216.0;
+}
+
+/*!
+ * \brief   Normal random number, Box-Muller transform
+ */
+static double SimGaussian( void )
+{
+    double u1 = 1.0 - SimUniform( );
+    double u2 = SimUniform( );
+
+    return sqrt( -2.0 * log( u1 ) ) * cos( 6.283185307179586 * u2 );
+}
+
+static uint32_t SimNow( void )
+{
+    return TIMER_IF_SIM_GetTimerValue( );
+}
+
+/*!
+ * \brief   Datarate of a frame, for the regions using the EU868 datarate table
+ */
+static int8_t SimDatarate( uint32_t modem, uint32_t bandwidth, uint32_t datarate )
+{
+    if( modem == MODEM_FSK )
+    {
+        return DR_7;
+    }
+    if( bandwidth == 1 )
+    {
+        return DR_6;
+    }
+    return 12 - ( int8_t )datarate;
+}
+
+static double SimRequiredSnrDr( int8_t dr )
+{
+    return SimRequiredSnr[( dr >= DR_5 ) ? 0 : ( DR_5 - dr )];
+}
+
+static void SimEventPush( SimEventType_t type, uint32_t time, uint32_t index, uint32_t stamp )
+{
+    if( SimCtx.NbEvents == SimCtx.EventsSize )
+    {
+        SimCtx.EventsSize = ( SimCtx.EventsSize == 0 ) ? 1024 : ( SimCtx.EventsSize * 2 );
+        SimCtx.Events = realloc( SimCtx.Events, SimCtx.EventsSize * sizeof( SimEvent_t ) );
+    }
+
+    SimEvent_t event = { .Time = time, .Seq = SimCtx.EventSeq++, .Type = type, .Index = index, .Stamp = stamp };
+    uint32_t i = SimCtx.NbEvents++;
+
+    while( i > 0 )
+    {
+        SimEvent_t* parent = &SimCtx.Events[( i - 1 ) / 2];
+
+        if( ( parent->Time < event.Time ) || ( ( parent->Time == event.Time ) && ( parent->Seq < event.Seq ) ) )
+        {
+            break;
+        }
+        SimCtx.Events[i] = *parent;
+        i = ( i - 1 ) / 2;
+    }
+    SimCtx.Events[i] = event;
+}
+
+static SimEvent_t SimEventPop( void )
+{
+    SimEvent_t top = SimCtx.Events[0];
+    SimEvent_t last = SimCtx.Events[--SimCtx.NbEvents];
+    uint32_t i = 0;
+
+    while( true )
+    {
+        uint32_t child = 2 * i + 1;
+
+        if( child >= SimCtx.NbEvents )
+        {
+            break;
+        }
+        if( ( child + 1 < SimCtx.NbEvents ) &&
+            ( ( SimCtx.Events[child + 1].Time < SimCtx.Events[child].Time ) ||
+              ( ( SimCtx.Events[child + 1].Time == SimCtx.Events[child].Time ) && ( SimCtx.Events[child + 1].Seq < SimCtx.Events[child].Seq ) ) ) )
+        {
+            child++;
+        }
+        if( ( last.Time < SimCtx.Events[child].Time ) ||
+            ( ( last.Time == SimCtx.Events[child].Time ) && ( last.Seq < SimCtx.Events[child].Seq ) ) )
+        {
+            break;
+        }
+        SimCtx.Events[i] = SimCtx.Events[child];
+        i = child;
+    }
+    if( SimCtx.NbEvents > 0 )
+    {
+        SimCtx.Events[i] = last;
+    }
+    return top;
+}
+
+/*!
+ * \brief   Moves the image of an end-device out of the MAC stack
+ *
+ * \remark  The timers of the end-device are stopped, their expiry is saved with the image.
+ */
+static void SimNodeSave( SimNode_t* node )
+{
+    uint32_t now = SimNow( );
+    UTIL_TIMER_Object_t* timer = TimerListHead;
+
+    node->NbTimers = 0;
+    while( timer != NULL )
+    {
+        uint32_t remaining = 0;
+
+        if( node->NbTimers == LORAWAN_SIM_MAX_TIMERS )
+        {
+            abort( );
+        }
+        UTIL_TIMER_GetRemainingTime( timer, &remaining );
+        node->Timers[node->NbTimers].Timer = timer;
+        node->Timers[node->NbTimers].Expiry = now + remaining;
+        node->Timers[node->NbTimers].ReloadValue = timer->ReloadValue;
+        node->NbTimers++;
+        timer = timer->Next;
+    }
+    for( uint8_t i = 0; i < node->NbTimers; i++ )
+    {
+        UTIL_TIMER_Stop( node->Timers[i].Timer );
+    }
+
+    memcpy( &node->MacCtx, &MacCtx, sizeof( MacCtx ) );
+    memcpy( &node->Nvm, &Nvm, sizeof( Nvm ) );
+#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    memcpy( node->RegionBands, RegionBands, sizeof( RegionBands ) );
+#endif /* LORAMAC_VERSION */
+    node->TxDoneParams = TxDoneParams;
+    node->RxDoneParams = RxDoneParams;
+    memcpy( &node->CommandsCtx, &CommandsCtx, sizeof( CommandsCtx ) );
+    memcpy( &node->ConfirmQueueCtx, &ConfirmQueueCtx, sizeof( ConfirmQueueCtx ) );
+#if (LORAWAN_KMS == 0)
+    memcpy( node->AesCtxCache, AesCtxCache, sizeof( AesCtxCache ) );
+    node->AesCtxCacheStamp = AesCtxCacheStamp;
+#endif /* LORAWAN_KMS == 0 */
+    node->RadioSim = RadioSim;
+    memcpy( node->RadioSimBuffer, RadioSimBuffer, sizeof( RadioSimBuffer ) );
+
+    SimCtx.LiveNode = NULL;
+}
+
+/*!
+ * \brief   Moves the image of an end-device into the MAC stack and restarts its timers
+ */
+static void SimNodeRestore( SimNode_t* node )
+{
+    uint32_t now = SimNow( );
+
+    memcpy( &MacCtx, &node->MacCtx, sizeof( MacCtx ) );
+    memcpy( &Nvm, &node->Nvm, sizeof( Nvm ) );
+#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    memcpy( RegionBands, node->RegionBands, sizeof( RegionBands ) );
+#endif /* LORAMAC_VERSION */
+    TxDoneParams = node->TxDoneParams;
+    RxDoneParams = node->RxDoneParams;
+    memcpy( &CommandsCtx, &node->CommandsCtx, sizeof( CommandsCtx ) );
+    memcpy( &ConfirmQueueCtx, &node->ConfirmQueueCtx, sizeof( ConfirmQueueCtx ) );
+#if (LORAWAN_KMS == 0)
+    memcpy( AesCtxCache, node->AesCtxCache, sizeof( AesCtxCache ) );
+    AesCtxCacheStamp = node->AesCtxCacheStamp;
+#endif /* LORAWAN_KMS == 0 */
+    RadioSim = node->RadioSim;
+    memcpy( RadioSimBuffer, node->RadioSimBuffer, sizeof( RadioSimBuffer ) );
+
+    for( uint8_t i = 0; i < node->NbTimers; i++ )
+    {
+        UTIL_TIMER_Object_t* timer = node->Timers[i].Timer;
+
+        timer->ReloadValue = ( ( int32_t )( node->Timers[i].Expiry - now ) > 0 ) ? ( node->Timers[i].Expiry - now ) : 0;
+        UTIL_TIMER_Start( timer );
+        timer->ReloadValue = node->Timers[i].ReloadValue;
+    }
+    node->NbTimers = 0;
+
+    SimCtx.LiveNode = node;
+}
+
+/*!
+ * \brief   Schedules the next event of an end-device which is not live
+ */
+static void SimNodeSchedule( SimNode_t* node )
+{
+    uint32_t wake = node->NextUplink;
+
+    for( uint8_t i = 0; i < node->NbTimers; i++ )
+    {
+        if( ( int32_t )( node->Timers[i].Expiry - wake ) < 0 )
+        {
+            wake = node->Timers[i].Expiry;
+        }
+    }
+    node->WakeStamp++;
+    SimEventPush( SIM_EVENT_NODE, wake, node->Index, node->WakeStamp );
+}
+
+/*!
+ * \brief   Runs the time server events of the live end-device which are due now
+ */
+static void SimNodeRunDueEvents( void )
+{
+    do
+    {
+        LoRaMacProcess( );
+    } while( ( TIMER_IF_SIM_GetNextEventDelay( ) == 0 ) && ( TIMER_IF_SIM_RunNextEvent( ) == true ) );
+}
+
+/*!
+ * \brief   Application of the live end-device: joins, then sends its uplinks
+ */
+static void SimNodeUplink( SimNode_t* node )
+{
+    LoRaMacStatus_t status;
+
+    if( node->Joined == false )
+    {
+        MlmeReq_t mlmeReq;
+
+        mlmeReq.Type = MLME_JOIN;
+        mlmeReq.Req.Join.NetworkActivation = ACTIVATION_TYPE_OTAA;
+        mlmeReq.Req.Join.Datarate = DR_0;
+        mlmeReq.Req.Join.TxPower = TX_POWER_0;
+        status = LoRaMacMlmeRequest( &mlmeReq );
+        if( status == LORAMAC_STATUS_OK )
+        {
+            SimCtx.Stats.JoinRequests++;
+        }
+    }
+    else
+    {
+        McpsReq_t mcpsReq;
+        uint8_t appData[LORAMAC_PHY_MAXPAYLOAD] = { 0 };
+
+        appData[0] = ( uint8_t )node->Index;
+        if( ( SimRandom( ) % 100 ) < SimCtx.Params.ConfirmedRatio )
+        {
+            mcpsReq.Type = MCPS_CONFIRMED;
+            mcpsReq.Req.Confirmed.fPort = 2;
+            mcpsReq.Req.Confirmed.fBuffer = appData;
+            mcpsReq.Req.Confirmed.fBufferSize = SimCtx.Params.AppDataSize;
+            mcpsReq.Req.Confirmed.Datarate = DR_0;
+        }
+        else
+        {
+            mcpsReq.Type = MCPS_UNCONFIRMED;
+            mcpsReq.Req.Unconfirmed.fPort = 2;
+            mcpsReq.Req.Unconfirmed.fBuffer = appData;
+            mcpsReq.Req.Unconfirmed.fBufferSize = SimCtx.Params.AppDataSize;
+            mcpsReq.Req.Unconfirmed.Datarate = DR_0;
+        }
+        SimCtx.Stats.UplinkRequests++;
+        status = LoRaMacMcpsRequest( &mcpsReq, false );
+    }
+
+    if( status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED )
+    {
+        SimCtx.Stats.DutyCycleRestricted++;
+    }
+    else if( status == LORAMAC_STATUS_BUSY )
+    {
+        SimCtx.Stats.Busy++;
+    }
+
+    node->NextUplink = SimNow( ) + ( SimCtx.Params.UplinkPeriod / 2 ) + ( SimRandom( ) % ( SimCtx.Params.UplinkPeriod + 1 ) );
+}
+
+static void SimNodeProcess( SimNode_t* node )
+{
+    SimNodeRestore( node );
+    SimNodeRunDueEvents( );
+    if( ( int32_t )( node->NextUplink - SimNow( ) ) <= 0 )
+    {
+        SimNodeUplink( node );
+        SimNodeRunDueEvents( );
+    }
+    SimNodeSave( node );
+    SimNodeSchedule( node );
+    SimCtx.Stats.NodeEvents++;
+}
+
+static void SimMcpsConfirm( McpsConfirm_t* mcpsConfirm )
+{
+    if( mcpsConfirm->McpsRequest == MCPS_CONFIRMED )
+    {
+        SimCtx.Stats.ConfirmedUplinks++;
+        if( mcpsConfirm->AckReceived == true )
+        {
+            SimCtx.Stats.ConfirmedAcked++;
+        }
+    }
+}
+
+static void SimMcpsIndication( McpsIndication_t* mcpsIndication, LoRaMacRxStatus_t* rxStatus )
+{
+    if( mcpsIndication->Status == LORAMAC_EVENT_INFO_STATUS_OK )
+    {
+        SimCtx.Stats.DownlinksReceived++;
+    }
+}
+
+static void SimMlmeConfirm( MlmeConfirm_t* mlmeConfirm )
+{
+    if( ( mlmeConfirm->MlmeRequest == MLME_JOIN ) && ( mlmeConfirm->Status == LORAMAC_EVENT_INFO_STATUS_OK ) )
+    {
+        SimCtx.LiveNode->Joined = true;
+        SimCtx.Stats.NodesJoined++;
+        SimCtx.Stats.DownlinksReceived++;
+    }
+}
+
+static void SimMlmeIndication( MlmeIndication_t* mlmeIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+/*!
+ * \brief   A frame of the live end-device is put on air: checks the collisions
+ *          with the frames still on air
+ */
+static void SimOnTxStart( const RadioSimParams_t* params, const uint8_t* payload, uint8_t size, uint32_t timeOnAir )
+{
+    SimNode_t* node = SimCtx.LiveNode;
+    uint32_t now = SimNow( );
+    uint32_t index;
+    SimTx_t* tx;
+
+    if( SimCtx.NbFreeTxs == 0 )
+    {
+        uint32_t txsSize = ( SimCtx.TxsSize == 0 ) ? 64 : ( SimCtx.TxsSize * 2 );
+
+        SimCtx.Txs = realloc( SimCtx.Txs, txsSize * sizeof( SimTx_t ) );
+        SimCtx.FreeTxs = realloc( SimCtx.FreeTxs, txsSize * sizeof( uint32_t ) );
+        SimCtx.ActiveTxs = realloc( SimCtx.ActiveTxs, txsSize * sizeof( uint32_t ) );
+        for( uint32_t i = txsSize; i > SimCtx.TxsSize; i-- )
+        {
+            SimCtx.FreeTxs[SimCtx.NbFreeTxs++] = i - 1;
+        }
+        SimCtx.TxsSize = txsSize;
+    }
+    index = SimCtx.FreeTxs[--SimCtx.NbFreeTxs];
+    tx = &SimCtx.Txs[index];
+
+    tx->End = now + timeOnAir;
+    tx->Frequency = params->Frequency;
+    tx->Bandwidth = params->Bandwidth;
+    tx->Datarate = params->Datarate;
+    tx->Rssi = params->Power - node->PathLoss;
+    tx->Snr = tx->Rssi - LORAWAN_SIM_NOISE_FLOOR;
+    tx->Interfered = false;
+    tx->Interference = 0;
+    tx->Size = size;
+    memcpy( tx->Payload, payload, size );
+
+    for( uint32_t i = 0; i < SimCtx.NbActiveTxs; i++ )
+    {
+        SimTx_t* other = &SimCtx.Txs[SimCtx.ActiveTxs[i]];
+
+        if( ( ( int32_t )( other->End - now ) > 0 ) && ( other->Frequency == tx->Frequency ) &&
+            ( other->Datarate == tx->Datarate ) && ( other->Bandwidth == tx->Bandwidth ) )
+        {
+            if( ( other->Interfered == false ) || ( other->Interference < tx->Rssi ) )
+            {
+                other->Interference = tx->Rssi;
+            }
+            if( ( tx->Interfered == false ) || ( tx->Interference < other->Rssi ) )
+            {
+                tx->Interference = other->Rssi;
+            }
+            other->Interfered = true;
+            tx->Interfered = true;
+        }
+    }
+    SimCtx.ActiveTxs[SimCtx.NbActiveTxs++] = index;
+    SimCtx.Stats.FramesSent++;
+
+    SimEventPush( SIM_EVENT_UPLINK_END, tx->End, index, 0 );
+}
+
+/*!
+ * \brief   The live end-device opens a reception window: delivers the pending
+ *          downlink in RX1
+ */
+static void SimOnRxStart( const RadioSimParams_t* params, uint32_t window )
+{
+    SimNode_t* node = SimCtx.LiveNode;
+
+    if( node->DownlinkSize == 0 )
+    {
+        return;
+    }
+    if( ( params->Frequency == node->DownlinkFrequency ) && ( params->Datarate == node->DownlinkDatarate ) &&
+        ( params->IqInverted == true ) )
+    {
+        if( RADIO_SIM_Deliver( params, node->Downlink, node->DownlinkSize, ( int16_t )node->LastRssi, ( int8_t )node->LastSnr ) == true )
+        {
+            SimCtx.Stats.DownlinksSent++;
+        }
+    }
+    node->DownlinkSize = 0;
+}
+
+static void SimComputeMic( const uint8_t* key, const uint8_t* b0, const uint8_t* msg, uint16_t size, uint8_t* mic )
+{
+    AES_CMAC_CTX cmacCtx;
+    uint8_t digest[AES_CMAC_DIGEST_LENGTH];
+
+    AES_CMAC_Init( &cmacCtx );
+    AES_CMAC_SetKey( &cmacCtx, key );
+    if( b0 != NULL )
+    {
+        AES_CMAC_Update( &cmacCtx, b0, 16 );
+    }
+    AES_CMAC_Update( &cmacCtx, msg, size );
+    AES_CMAC_Final( digest, &cmacCtx );
+    memcpy( mic, digest, 4 );
+}
+
+static void SimComputeDataMic( const uint8_t* key, uint8_t dir, uint32_t devAddr, uint32_t fCnt, const uint8_t* msg, uint16_t size, uint8_t* mic )
+{
+    uint8_t b0[16] = { 0x49, 0, 0, 0, 0, dir,
+                       devAddr & 0xFF, ( devAddr >> 8 ) & 0xFF, ( devAddr >> 16 ) & 0xFF, ( devAddr >> 24 ) & 0xFF,
+                       fCnt & 0xFF, ( fCnt >> 8 ) & 0xFF, ( fCnt >> 16 ) & 0xFF, ( fCnt >> 24 ) & 0xFF,
+                       0, ( uint8_t )size };
+
+    SimComputeMic( key, b0, msg, size, mic );
+}
+
+/*!
+ * \brief   Network server: answers a join-request with a join-accept
+ */
+static void SimNsOnJoinRequest( const SimTx_t* tx )
+{
+    lorawan_aes_context aesCtx;
+    uint8_t block[16];
+    uint8_t mic[4];
+    uint8_t* accept;
+    uint32_t devAddr;
+    uint32_t index = tx->Payload[9] | ( tx->Payload[10] << 8 ) | ( tx->Payload[11] << 16 ) | ( ( uint32_t )tx->Payload[12] << 24 );
+    SimNode_t* node;
+
+    if( ( tx->Size != 23 ) || ( index >= SimCtx.Params.NbNodes ) )
+    {
+        return;
+    }
+    node = &SimCtx.Nodes[index];
+    SimComputeMic( node->Key, NULL, tx->Payload, 19, mic );
+    if( memcmp( mic, &tx->Payload[19], 4 ) != 0 )
+    {
+        SimCtx.Stats.FramesRejected++;
+        return;
+    }
+
+    node->JoinNonce++;
+    devAddr = LORAWAN_SIM_DEV_ADDR_PREFIX | ( index + 1 );
+
+    accept = node->Downlink;
+    accept[0] = 0x20;
+    accept[1] = node->JoinNonce & 0xFF;
+    accept[2] = ( node->JoinNonce >> 8 ) & 0xFF;
+    accept[3] = ( node->JoinNonce >> 16 ) & 0xFF;
+    accept[4] = LORAWAN_SIM_NET_ID & 0xFF;
+    accept[5] = ( LORAWAN_SIM_NET_ID >> 8 ) & 0xFF;
+    accept[6] = ( LORAWAN_SIM_NET_ID >> 16 ) & 0xFF;
+    accept[7] = devAddr & 0xFF;
+    accept[8] = ( devAddr >> 8 ) & 0xFF;
+    accept[9] = ( devAddr >> 16 ) & 0xFF;
+    accept[10] = ( devAddr >> 24 ) & 0xFF;
+    accept[11] = 0x00;  // DLSettings: RX1DRoffset 0, RX2 datarate 0
+    accept[12] = 0x01;  // RxDelay 1 s
+    SimComputeMic( node->Key, NULL, accept, 13, &accept[13] );
+
+    // The network server encrypts the join-accept with an AES decrypt operation
+    lorawan_aes_set_key( node->Key, 16, &aesCtx );
+    lorawan_aes_decrypt( &accept[1], block, &aesCtx );
+    memcpy( &accept[1], block, 16 );
+    node->DownlinkSize = 17;
+    node->DownlinkFrequency = tx->Frequency;
+    node->DownlinkDatarate = tx->Datarate;
+
+    // 1.0.x session keys
+    memset( block, 0, sizeof( block ) );
+    block[0] = 0x01;
+    block[1] = node->JoinNonce & 0xFF;
+    block[2] = ( node->JoinNonce >> 8 ) & 0xFF;
+    block[3] = ( node->JoinNonce >> 16 ) & 0xFF;
+    block[4] = LORAWAN_SIM_NET_ID & 0xFF;
+    block[5] = ( LORAWAN_SIM_NET_ID >> 8 ) & 0xFF;
+    block[6] = ( LORAWAN_SIM_NET_ID >> 16 ) & 0xFF;
+    block[7] = tx->Payload[17];
+    block[8] = tx->Payload[18];
+    lorawan_aes_encrypt( block, node->NwkSKey, &aesCtx );
+
+    node->NsJoined = true;
+    node->JoinTime = SimNow( );
+    node->FCntUp = 0;
+    node->FCntDown = 0;
+    node->CurrentDr = -1;
+    node->TargetDr = -1;
+    node->TxPower = TX_POWER_0;
+    node->UplinksSinceLinkAdrReq = LORAWAN_SIM_ADR_RETRY;
+    node->NbSnr = 0;
+    SimCtx.Stats.JoinAccepts++;
+}
+
+/*!
+ * \brief   Network server ADR: computes the datarate and TX power of an end-device
+ *
+ * \retval  true when a LinkAdrReq has to be sent
+ */
+static bool SimNsAdr( SimNode_t* node, int8_t* dr, int8_t* txPower )
+{
+    double snrMax = node->SnrHistory[0];
+    int32_t nbStep;
+
+    for( uint8_t i = 1; i < node->NbSnr; i++ )
+    {
+        if( node->SnrHistory[i] > snrMax )
+        {
+            snrMax = node->SnrHistory[i];
+        }
+    }
+    nbStep = ( int32_t )floor( ( snrMax - SimRequiredSnrDr( node->CurrentDr ) - LORAWAN_SIM_ADR_MARGIN ) / 3.0 );
+
+    *dr = node->CurrentDr;
+    *txPower = node->TxPower;
+    while( ( nbStep > 0 ) && ( *dr < LORAWAN_SIM_ADR_MAX_DR ) )
+    {
+        ( *dr )++;
+        nbStep--;
+    }
+    while( ( nbStep > 0 ) && ( *txPower < LORAWAN_SIM_ADR_MAX_TX_POWER ) )
+    {
+        ( *txPower )++;
+        nbStep--;
+    }
+    while( ( nbStep < 0 ) && ( *txPower > TX_POWER_0 ) )
+    {
+        ( *txPower )--;
+        nbStep++;
+    }
+    node->TargetDr = *dr;
+    return ( *dr != node->CurrentDr ) || ( *txPower != node->TxPower );
+}
+
+/*!
+ * \brief   Network server: handles a data uplink, answers with an acknowledgement
+ *          and the ADR commands
+ */
+static void SimNsOnDataUp( const SimTx_t* tx, bool confirmed )
+{
+    uint32_t devAddr = tx->Payload[1] | ( tx->Payload[2] << 8 ) | ( tx->Payload[3] << 16 ) | ( ( uint32_t )tx->Payload[4] << 24 );
+    uint32_t index = ( devAddr & ~LORAWAN_SIM_DEV_ADDR_PREFIX ) - 1;
+    uint8_t fCtrl = tx->Payload[5];
+    uint8_t fOptsLen = fCtrl & 0x0F;
+    uint32_t fCnt;
+    uint8_t mic[4];
+    uint8_t fOpts[5];
+    uint8_t fOptsSize = 0;
+    SimNode_t* node;
+    int8_t dr;
+
+    if( ( tx->Size < 12 + fOptsLen ) || ( index >= SimCtx.Params.NbNodes ) || ( SimCtx.Nodes[index].NsJoined == false ) )
+    {
+        SimCtx.Stats.FramesRejected++;
+        return;
+    }
+    node = &SimCtx.Nodes[index];
+
+    fCnt = ( node->FCntUp & 0xFFFF0000 ) | tx->Payload[6] | ( tx->Payload[7] << 8 );
+    if( fCnt < node->FCntUp )
+    {
+        fCnt += 0x10000;
+    }
+    SimComputeDataMic( node->NwkSKey, 0, devAddr, fCnt, tx->Payload, tx->Size - 4, mic );
+    if( memcmp( mic, &tx->Payload[tx->Size - 4], 4 ) != 0 )
+    {
+        SimCtx.Stats.FramesRejected++;
+        return;
+    }
+    node->FCntUp = fCnt;
+    if( tx->Size > 12 + fOptsLen )
+    {
+        SimCtx.Stats.AppBytesReceived += tx->Size - 13 - fOptsLen;
+    }
+
+    // ADR
+    dr = SimDatarate( MODEM_LORA, tx->Bandwidth, tx->Datarate );
+    if( dr != node->CurrentDr )
+    {
+        if( node->CurrentDr >= 0 )
+        {
+            node->LastDrChange = SimNow( );
+        }
+        else
+        {
+            node->LastDrChange = node->JoinTime;
+        }
+        node->CurrentDr = dr;
+        node->NbSnr = 0;
+    }
+    if( node->NbSnr == LORAWAN_SIM_ADR_HISTORY )
+    {
+        memmove( node->SnrHistory, &node->SnrHistory[1], ( LORAWAN_SIM_ADR_HISTORY - 1 ) * sizeof( double ) );
+        node->NbSnr--;
+    }
+    node->SnrHistory[node->NbSnr++] = tx->Snr;
+    node->LastRssi = tx->Rssi;
+    node->LastSnr = tx->Snr;
+    if( node->UplinksSinceLinkAdrReq < LORAWAN_SIM_ADR_RETRY )
+    {
+        node->UplinksSinceLinkAdrReq++;
+    }
+
+    if( ( SimCtx.Params.AdrEnabled == true ) && ( ( fCtrl & 0x80 ) != 0 ) &&
+        ( node->NbSnr == LORAWAN_SIM_ADR_HISTORY ) && ( node->UplinksSinceLinkAdrReq == LORAWAN_SIM_ADR_RETRY ) )
+    {
+        int8_t txPower;
+
+        if( SimNsAdr( node, &dr, &txPower ) == true )
+        {
+            fOpts[0] = SRV_MAC_LINK_ADR_REQ;
+            fOpts[1] = ( dr << 4 ) | txPower;
+            fOpts[2] = 0x00;
+            fOpts[3] = 0x00;
+            fOpts[4] = 0x60;  // ChMaskCntl 6: all defined channels enabled, NbTrans 0: unchanged
+            fOptsSize = 5;
+            node->TxPower = txPower;
+            node->UplinksSinceLinkAdrReq = 0;
+            SimCtx.Stats.LinkAdrReqs++;
+        }
+    }
+
+    if( ( confirmed == true ) || ( fOptsSize > 0 ) || ( ( fCtrl & 0x40 ) != 0 ) )
+    {
+        uint8_t* downlink = node->Downlink;
+        uint8_t size = 0;
+
+        downlink[size++] = 0x60;
+        downlink[size++] = devAddr & 0xFF;
+        downlink[size++] = ( devAddr >> 8 ) & 0xFF;
+        downlink[size++] = ( devAddr >> 16 ) & 0xFF;
+        downlink[size++] = ( devAddr >> 24 ) & 0xFF;
+        downlink[size++] = ( SimCtx.Params.AdrEnabled ? 0x80 : 0x00 ) | ( confirmed ? 0x20 : 0x00 ) | fOptsSize;
+        downlink[size++] = node->FCntDown & 0xFF;
+        downlink[size++] = ( node->FCntDown >> 8 ) & 0xFF;
+        memcpy( &downlink[size], fOpts, fOptsSize );
+        size += fOptsSize;
+        SimComputeDataMic( node->NwkSKey, 1, devAddr, node->FCntDown, downlink, size, &downlink[size] );
+        size += 4;
+        node->FCntDown++;
+        node->DownlinkSize = size;
+        node->DownlinkFrequency = tx->Frequency;
+        node->DownlinkDatarate = tx->Datarate;
+    }
+}
+
+/*!
+ * \brief   A frame ends at the gateway: decides its reception
+ */
+static void SimOnUplinkEnd( uint32_t index )
+{
+    SimTx_t* tx = &SimCtx.Txs[index];
+
+    for( uint32_t i = 0; i < SimCtx.NbActiveTxs; i++ )
+    {
+        if( SimCtx.ActiveTxs[i] == index )
+        {
+            SimCtx.ActiveTxs[i] = SimCtx.ActiveTxs[--SimCtx.NbActiveTxs];
+            break;
+        }
+    }
+    SimCtx.FreeTxs[SimCtx.NbFreeTxs++] = index;
+
+    if( ( tx->Interfered == true ) &&
+        ( ( SimCtx.Params.CaptureThreshold == 0 ) || ( ( tx->Rssi - tx->Interference ) < SimCtx.Params.CaptureThreshold ) ) )
+    {
+        SimCtx.Stats.FramesCollided++;
+        return;
+    }
+    if( tx->Snr < SimRequiredSnrDr( SimDatarate( MODEM_LORA, tx->Bandwidth, tx->Datarate ) ) )
+    {
+        SimCtx.Stats.FramesBelowSensitivity++;
+        return;
+    }
+    SimCtx.Stats.FramesReceived++;
+
+    switch( tx->Payload[0] & 0xE0 )
+    {
+        case 0x00:
+            SimNsOnJoinRequest( tx );
+            break;
+        case 0x40:
+            SimNsOnDataUp( tx, false );
+            break;
+        case 0x80:
+            SimNsOnDataUp( tx, true );
+            break;
+        default:
+            SimCtx.Stats.FramesRejected++;
+            break;
+    }
+}
+
+static LoRaMacStatus_t SimNodeInit( SimNode_t* node, uint32_t index )
+{
+    MibRequestConfirm_t mibReq;
+    LoRaMacStatus_t status;
+    uint8_t devEui[8] = { 0x00, 0x80, 0xE1, 0x15, ( index >> 24 ) & 0xFF, ( index >> 16 ) & 0xFF, ( index >> 8 ) & 0xFF, index & 0xFF };
+    uint8_t joinEui[8] = { 0 };
+    double distance;
+
+    node->Index = index;
+    for( uint8_t i = 0; i < 16; i++ )
+    {
+        node->Key[i] = ( uint8_t )( 0x2B + i ) ^ ( uint8_t )( index >> ( 8 * ( i & 3 ) ) );
+    }
+    // Uniform placement in the disc, at least at the reference distance of the model
+    distance = SimCtx.Params.CellRadius * sqrt( SimUniform( ) );
+    if( distance < LORAWAN_SIM_PATH_LOSS_REF_DISTANCE )
+    {
+        distance = LORAWAN_SIM_PATH_LOSS_REF_DISTANCE;
+    }
+    node->PathLoss = LORAWAN_SIM_PATH_LOSS_REF +
+                     10.0 * LORAWAN_SIM_PATH_LOSS_EXPONENT * log10( distance / LORAWAN_SIM_PATH_LOSS_REF_DISTANCE ) +
+                     SimCtx.Params.Shadowing * SimGaussian( );
+    node->NextUplink = SimNow( ) + ( SimRandom( ) % ( SimCtx.Params.UplinkPeriod + 1 ) );
+    node->CurrentDr = -1;
+    node->TargetDr = -1;
+
+    RADIO_SIM_SetSeed( SimCtx.Params.Seed ^ ( ( index + 1 ) * 0x9E3779B9U ) );
+    status = LoRaMacInitialization( &SimPrimitives, &SimCallbacks, SimCtx.Params.Region );
+    if( status != LORAMAC_STATUS_OK )
+    {
+        return status;
+    }
+    SimCtx.LiveNode = node;
+
+    mibReq.Type = MIB_DEV_EUI;
+    mibReq.Param.DevEui = devEui;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_JOIN_EUI;
+    mibReq.Param.JoinEui = joinEui;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_APP_KEY;
+    mibReq.Param.AppKey = node->Key;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_NWK_KEY;
+    mibReq.Param.NwkKey = node->Key;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = SimCtx.Params.AdrEnabled;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+
+    status = LoRaMacStart( );
+    SimNodeSave( node );
+    SimNodeSchedule( node );
+    return status;
+}
+
+LoRaMacStatus_t LoRaWanSimInit( const LoRaWanSimParams_t* params )
+{
+    if( ( params == NULL ) || ( params->NbNodes == 0 ) || ( params->UplinkPeriod == 0 ) )
+    {
+        return LORAMAC_STATUS_PARAMETER_INVALID;
+    }
+    switch( params->Region )
+    {
+        case LORAMAC_REGION_AS923:
+        case LORAMAC_REGION_CN779:
+        case LORAMAC_REGION_EU433:
+        case LORAMAC_REGION_EU868:
+        case LORAMAC_REGION_IN865:
+        case LORAMAC_REGION_KR920:
+        case LORAMAC_REGION_RU864:
+            break;
+        default:
+            return LORAMAC_STATUS_REGION_NOT_SUPPORTED;
+    }
+
+    LoRaWanSimDeInit( );
+    SimCtx.Params = *params;
+    SimCtx.Rng = ( params->Seed != 0 ) ? params->Seed : 1;
+    SimCtx.Nodes = calloc( params->NbNodes, sizeof( SimNode_t ) );
+    if( SimCtx.Nodes == NULL )
+    {
+        return LORAMAC_STATUS_ERROR;
+    }
+
+    UTIL_TIMER_Init( );
+    RADIO_SIM_SetObserver( &SimObserver );
+    for( uint32_t i = 0; i < params->NbNodes; i++ )
+    {
+        LoRaMacStatus_t status = SimNodeInit( &SimCtx.Nodes[i], i );
+
+        if( status != LORAMAC_STATUS_OK )
+        {
+            LoRaWanSimDeInit( );
+            return status;
+        }
+    }
+    return LORAMAC_STATUS_OK;
+}
+
+void LoRaWanSimRun( uint32_t duration )
+{
+    uint32_t end = SimNow( ) + duration;
+
+    while( ( SimCtx.NbEvents > 0 ) && ( ( int32_t )( SimCtx.Events[0].Time - end ) <= 0 ) )
+    {
+        SimEvent_t event = SimEventPop( );
+        uint32_t now = SimNow( );
+
+        if( ( int32_t )( event.Time - now ) > 0 )
+        {
+            TIMER_IF_SIM_Advance( event.Time - now );
+        }
+        if( event.Type == SIM_EVENT_UPLINK_END )
+        {
+            SimOnUplinkEnd( event.Index );
+        }
+        else if( event.Stamp == SimCtx.Nodes[event.Index].WakeStamp )
+        {
+            SimNodeProcess( &SimCtx.Nodes[event.Index] );
+        }
+    }
+    if( ( int32_t )( end - SimNow( ) ) > 0 )
+    {
+        TIMER_IF_SIM_Advance( end - SimNow( ) );
+    }
+}
+
+void LoRaWanSimGetStats( LoRaWanSimStats_t* stats )
+{
+    uint64_t convergenceTimeSum = 0;
+
+    SimCtx.Stats.SimTime = SimNow( );
+    SimCtx.Stats.NodesConverged = 0;
+    memset( SimCtx.Stats.NodesPerDatarate, 0, sizeof( SimCtx.Stats.NodesPerDatarate ) );
+    for( uint32_t i = 0; i < SimCtx.Params.NbNodes; i++ )
+    {
+        SimNode_t* node = &SimCtx.Nodes[i];
+
+        if( node->CurrentDr < 0 )
+        {
+            continue;
+        }
+        SimCtx.Stats.NodesPerDatarate[node->CurrentDr]++;
+        if( ( node->TargetDr >= 0 ) && ( node->TargetDr == node->CurrentDr ) )
+        {
+            SimCtx.Stats.NodesConverged++;
+            convergenceTimeSum += node->LastDrChange - node->JoinTime;
+        }
+    }
+    SimCtx.Stats.AdrConvergenceTime = ( SimCtx.Stats.NodesConverged > 0 ) ?
+                                      ( uint32_t )( convergenceTimeSum / SimCtx.Stats.NodesConverged ) : 0;
+    *stats = SimCtx.Stats;
+}
+
+void LoRaWanSimDeInit( void )
+{
+    free( SimCtx.Nodes );
+    free( SimCtx.Events );
+    free( SimCtx.Txs );
+    free( SimCtx.FreeTxs );
+    free( SimCtx.ActiveTxs );
+    memset( &SimCtx, 0, sizeof( SimCtx ) );
+}
@@ -0,0 +1,231 @@
+/*!
+ * \file      LoRaWanSim.h
+ *
+ * \brief     Multi-node LoRaWAN network simulator running the LoRaMac stack on a host
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \code
+ *                ______                              _
+ *               / _____)             _              | |
+ *              ( (____  _____ ____ _| |_ _____  ____| |__
+ *               \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ *               _____) ) ____| | | || |_| ____( (___| | | |
+ *              (______/|_____)_|_|_| \__)_____)\____)_| |_|
+ *              (C)2013-2017 Semtech
+ *
+ * \endcode
+ *
+ * \defgroup  LORAWANSIM LoRaWAN network simulator
+ *            Runs N end-devices, each one an instance of the unmodified LoRaMac
+ *            stack, against a shared channel model and a scripted network server.
+ *
+ *            The MAC layer keeps its state in file-static contexts (MacCtx, Nvm,
+ *            MAC commands, confirm queue, secure element cache, radio and timers).
+ *            The simulator owns one image of these contexts per end-device and
+ *            swaps the image of the end-device which has an event to process
+ *            into the stack. Only one end-device is live at a time, and the
+ *            firmware build of the stack is left untouched.
+ *
+ *            The simulator is host only, Host/CMakeLists.txt builds it: the
+ *            lorawan_sim program (main.c) runs a scenario given on its command
+ *            line. LoRaWanSim.c includes LoRaMac.c, LoRaMacCommands.c,
+ *            LoRaMacConfirmQueue.c, soft-se.c, stm32_timer.c and radio_sim.c,
+ *            which must not be linked a second time. The rest of the stack
+ *            (LoRaMacAdr.c, LoRaMacClassB.c, LoRaMacCrypto.c, LoRaMacParser.c,
+ *            LoRaMacSerializer.c, Region/\*.c, cmac.c, lorawan_aes.c,
+ *            utilities.c, stm32_systime.c) and the virtual time backend
+ *            stm32_timer_if_sim.c are linked as usual. AES_DEC_PREKEYED must be
+ *            defined for the whole build, the network server encrypts the
+ *            join-accepts with an AES decryption.
+ *
+ *            Limitations:
+ *            - LoRaWAN 1.0.x end-devices in class A
+ *            - regions without file-static channel caches: AS923, CN779, EU433,
+ *              EU868, IN865, KR920 and RU864
+ *            - a single gateway with unlimited demodulators; downlinks are sent
+ *              in RX1 and are never lost
+ *            - the simulated time is kept by the 32-bit virtual clock, a run
+ *              must stay under 49 days
+ * \{
+ */
+#ifndef __LORAWAN_SIM_H__
+#define __LORAWAN_SIM_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "LoRaMac.h"
+
+/*!
+ * Number of datarates reported in \ref LoRaWanSimStats_t
+ */
+#define LORAWAN_SIM_NB_DATARATES                    16
+
+/*!
+ * Simulation parameters
+ */
+typedef struct sLoRaWanSimParams
+{
+    /*!
+     * Number of end-devices
+     */
+    uint32_t NbNodes;
+    /*!
+     * LoRaWAN region
+     */
+    LoRaMacRegion_t Region;
+    /*!
+     * Seed of the simulation, two runs with the same parameters give the same results
+     */
+    uint32_t Seed;
+    /*!
+     * Mean period of the application uplinks [ms]. Each end-device draws its
+     * periods uniformly in [UplinkPeriod / 2, 3 * UplinkPeriod / 2]
+     */
+    uint32_t UplinkPeriod;
+    /*!
+     * Application payload size [bytes]
+     */
+    uint8_t AppDataSize;
+    /*!
+     * Percentage of the application uplinks sent as confirmed frames
+     */
+    uint8_t ConfirmedRatio;
+    /*!
+     * Enables the ADR on the end-devices and in the network server
+     */
+    bool AdrEnabled;
+    /*!
+     * Radius of the disc in which the end-devices are placed around the gateway [m]
+     */
+    uint32_t CellRadius;
+    /*!
+     * Standard deviation of the log-normal shadowing [dB]
+     */
+    uint8_t Shadowing;
+    /*!
+     * Power difference with the strongest interferer above which a frame
+     * survives a collision [dB]. 0 disables the capture effect.
+     */
+    uint8_t CaptureThreshold;
+}LoRaWanSimParams_t;
+
+/*!
+ * Simulation results
+ */
+typedef struct sLoRaWanSimStats
+{
+    /*!
+     * Simulated time [ms]
+     */
+    uint32_t SimTime;
+    /*!
+     * Number of end-device events processed
+     */
+    uint32_t NodeEvents;
+    /*!
+     * Number of end-devices which have joined
+     */
+    uint32_t NodesJoined;
+    /*!
+     * Join-requests and join-accepts sent
+     */
+    uint32_t JoinRequests;
+    uint32_t JoinAccepts;
+    /*!
+     * Application uplinks requested, and the requests refused by the MAC
+     * because of the duty-cycle or because a previous exchange is running
+     */
+    uint32_t UplinkRequests;
+    uint32_t DutyCycleRestricted;
+    uint32_t Busy;
+    /*!
+     * Frames transmitted by the end-devices, retransmissions included
+     */
+    uint32_t FramesSent;
+    /*!
+     * Frames received by the gateway, lost in a collision, and lost below
+     * the demodulation floor
+     */
+    uint32_t FramesReceived;
+    uint32_t FramesCollided;
+    uint32_t FramesBelowSensitivity;
+    /*!
+     * Frames received by the gateway and dropped by the network server
+     * ( unknown end-device, MIC failure )
+     */
+    uint32_t FramesRejected;
+    /*!
+     * Application bytes received by the network server
+     */
+    uint32_t AppBytesReceived;
+    /*!
+     * Confirmed uplinks completed, and completed with an acknowledgement
+     */
+    uint32_t ConfirmedUplinks;
+    uint32_t ConfirmedAcked;
+    /*!
+     * Downlinks sent by the network server and received by the end-devices
+     */
+    uint32_t DownlinksSent;
+    uint32_t DownlinksReceived;
+    /*!
+     * LinkAdrReq commands sent by the network server
+     */
+    uint32_t LinkAdrReqs;
+    /*!
+     * End-devices running at the datarate targeted by the network server ADR,
+     * and mean time from their join-accept to their last datarate change [ms]
+     */
+    uint32_t NodesConverged;
+    uint32_t AdrConvergenceTime;
+    /*!
+     * Number of end-devices per datarate of their last uplink
+     */
+    uint32_t NodesPerDatarate[LORAWAN_SIM_NB_DATARATES];
+}LoRaWanSimStats_t;
+
+/*!
+ * \brief   Creates and initializes the end-devices and the network server
+ *
+ * \param   [in] params - Simulation parameters
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. Possible returns are:
+ *          \ref LORAMAC_STATUS_OK,
+ *          \ref LORAMAC_STATUS_PARAMETER_INVALID,
+ *          \ref LORAMAC_STATUS_REGION_NOT_SUPPORTED,
+ *          \ref LORAMAC_STATUS_ERROR.
+ */
+LoRaMacStatus_t LoRaWanSimInit( const LoRaWanSimParams_t* params );
+
+/*!
+ * \brief   Runs the simulation
+ *
+ * \param   [in] duration - Simulated time to run [ms]
+ */
+void LoRaWanSimRun( uint32_t duration );
+
+/*!
+ * \brief   Gets the results of the simulation
+ *
+ * \param   [out] stats - Simulation results
+ */
+void LoRaWanSimGetStats( LoRaWanSimStats_t* stats );
+
+/*!
+ * \brief   Releases the end-devices
+ */
+void LoRaWanSimDeInit( void );
+
+/*! \} defgroup LORAWANSIM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LORAWAN_SIM_H__
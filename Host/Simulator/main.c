@@ -0,0 +1,165 @@
+/*!
+ * \file      main.c
+ *
+ * \brief     LoRaWAN network simulator: runs a scenario given on the command line
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \code
+ *                ______                              _
+ *               / _____)             _              | |
+ *              ( (____  _____ ____ _| |_ _____  ____| |__
+ *               \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ *               _____) ) ____| | | || |_| ____( (___| | | |
+ *              (______/|_____)_|_|_| \__)_____)\____)_| |_|
+ *              (C)2013-2017 Semtech
+ *
+ * \endcode
+ *
+ * Usage: lorawan_sim [options]
+ *   -n <nodes>      number of end-devices (100)
+ *   -r <region>     AS923, CN779, EU433, EU868, IN865, KR920 or RU864 (EU868)
+ *   -p <seconds>    mean application uplink period (600)
+ *   -d <seconds>    simulated duration (21600)
+ *   -s <size>       application payload size (12)
+ *   -c <percent>    confirmed uplinks (10)
+ *   -a <0|1>        ADR (1)
+ *   -R <meters>     cell radius (500)
+ *   -S <dB>         shadowing standard deviation (3)
+ *   -C <dB>         capture threshold, 0 disables the capture effect (6)
+ *   -x <seed>       seed of the simulation (7)
+ *
+ * The program fails when the network server rejected a frame, i.e. when an
+ * end-device sent a frame the network server could not authenticate.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "LoRaWanSim.h"
+
+/*!
+ * Regions supported by the simulator
+ */
+static const struct
+{
+    const char* Name;
+    LoRaMacRegion_t Region;
+}Regions[] =
+{
+    { "AS923", LORAMAC_REGION_AS923 },
+    { "CN779", LORAMAC_REGION_CN779 },
+    { "EU433", LORAMAC_REGION_EU433 },
+    { "EU868", LORAMAC_REGION_EU868 },
+    { "IN865", LORAMAC_REGION_IN865 },
+    { "KR920", LORAMAC_REGION_KR920 },
+    { "RU864", LORAMAC_REGION_RU864 },
+};
+
+static double WallTime( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( double )ts.tv_sec + ( double )ts.tv_nsec / 1e9;
+}
+
+int main( int argc, char** argv )
+{
+    LoRaWanSimParams_t params =
+    {
+        .NbNodes = 100,
+        .Region = LORAMAC_REGION_EU868,
+        .Seed = 7,
+        .UplinkPeriod = 600000,
+        .AppDataSize = 12,
+        .ConfirmedRatio = 10,
+        .AdrEnabled = true,
+        .CellRadius = 500,
+        .Shadowing = 3,
+        .CaptureThreshold = 6,
+    };
+    uint32_t duration = 6 * 3600;
+    LoRaWanSimStats_t stats;
+    LoRaMacStatus_t status;
+    double start;
+    int opt;
+
+    while( ( opt = getopt( argc, argv, "n:r:p:d:s:c:a:R:S:C:x:" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'n': params.NbNodes = strtoul( optarg, NULL, 0 ); break;
+            case 'r':
+            {
+                size_t i;
+
+                for( i = 0; i < sizeof( Regions ) / sizeof( Regions[0] ); i++ )
+                {
+                    if( strcmp( optarg, Regions[i].Name ) == 0 )
+                    {
+                        params.Region = Regions[i].Region;
+                        break;
+                    }
+                }
+                if( i == sizeof( Regions ) / sizeof( Regions[0] ) )
+                {
+                    fprintf( stderr, "unsupported region %s\n", optarg );
+                    return 2;
+                }
+                break;
+            }
+            case 'p': params.UplinkPeriod = strtoul( optarg, NULL, 0 ) * 1000; break;
+            case 'd': duration = strtoul( optarg, NULL, 0 ); break;
+            case 's': params.AppDataSize = ( uint8_t )strtoul( optarg, NULL, 0 ); break;
+            case 'c': params.ConfirmedRatio = ( uint8_t )strtoul( optarg, NULL, 0 ); break;
+            case 'a': params.AdrEnabled = strtoul( optarg, NULL, 0 ) != 0; break;
+            case 'R': params.CellRadius = strtoul( optarg, NULL, 0 ); break;
+            case 'S': params.Shadowing = ( uint8_t )strtoul( optarg, NULL, 0 ); break;
+            case 'C': params.CaptureThreshold = ( uint8_t )strtoul( optarg, NULL, 0 ); break;
+            case 'x': params.Seed = strtoul( optarg, NULL, 0 ); break;
+            default:
+                fprintf( stderr, "usage: %s [-n nodes] [-r region] [-p period s] [-d duration s] [-s size] "
+                                 "[-c confirmed %%] [-a adr] [-R radius m] [-S shadowing dB] [-C capture dB] [-x seed]\n", argv[0] );
+                return 2;
+        }
+    }
+
+    start = WallTime( );
+    status = LoRaWanSimInit( &params );
+    if( status != LORAMAC_STATUS_OK )
+    {
+        fprintf( stderr, "LoRaWanSimInit failed: %d\n", status );
+        return 1;
+    }
+    LoRaWanSimRun( duration * 1000 );
+    LoRaWanSimGetStats( &stats );
+    LoRaWanSimDeInit( );
+
+    printf( "%u end-devices, %u s simulated in %.2f s, %u events\n",
+            params.NbNodes, stats.SimTime / 1000, WallTime( ) - start, stats.NodeEvents );
+    printf( "join:       %u/%u joined, %u join-requests, %u join-accepts\n",
+            stats.NodesJoined, params.NbNodes, stats.JoinRequests, stats.JoinAccepts );
+    printf( "uplinks:    %u requested, %u duty-cycle restricted, %u busy, %u frames sent\n",
+            stats.UplinkRequests, stats.DutyCycleRestricted, stats.Busy, stats.FramesSent );
+    printf( "gateway:    %u received, %u collided, %u below sensitivity, %u rejected\n",
+            stats.FramesReceived, stats.FramesCollided, stats.FramesBelowSensitivity, stats.FramesRejected );
+    printf( "throughput: %u application bytes, %.1f B/s\n",
+            stats.AppBytesReceived, ( stats.SimTime > 0 ) ? stats.AppBytesReceived * 1000.0 / stats.SimTime : 0.0 );
+    printf( "confirmed:  %u completed, %u acknowledged\n", stats.ConfirmedUplinks, stats.ConfirmedAcked );
+    printf( "downlinks:  %u sent, %u received\n", stats.DownlinksSent, stats.DownlinksReceived );
+    printf( "ADR:        %u LinkAdrReq, %u converged, %u s mean convergence time\n",
+            stats.LinkAdrReqs, stats.NodesConverged, stats.AdrConvergenceTime / 1000 );
+    printf( "datarates: " );
+    for( uint32_t dr = 0; dr < LORAWAN_SIM_NB_DATARATES; dr++ )
+    {
+        if( stats.NodesPerDatarate[dr] > 0 )
+        {
+            printf( " DR%u:%u", dr, stats.NodesPerDatarate[dr] );
+        }
+    }
+    printf( "\n" );
+
+    return ( stats.FramesRejected == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/*!
+ * \file      cmac_test.c
+ *
+ * \brief     Known-answer tests and benchmark of the AES-CMAC of cmac.c
+ *
+ * \remark    Checks the subkeys precomputed by AES_CMAC_SetKey and the
+ *            RFC 4493 examples of 0, 16, 40 and 64 bytes through
+ *            AES_CMAC_Update, fed in every chunk size, and through the
+ *            one-shot AES_CMAC_Compute, without and with a prefix block.
+ *            Random messages are then compared between both APIs, and the
+ *            CMAC of a B0 block and a LoRaWAN frame is timed through each.
+ *
+ *            Usage: cmac_test [messages]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "utilities.h"
+#include "cmac.h"
+
+/*!
+ * RFC 4493 section 4: key, subkeys and message of the examples
+ */
+static const uint8_t Key[16] =
+{
+    0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+};
+static const uint8_t K1[16] =
+{
+    0xFB, 0xEE, 0xD6, 0x18, 0x35, 0x71, 0x33, 0x66, 0x7C, 0x85, 0xE0, 0x8F, 0x72, 0x36, 0xA8, 0xDE
+};
+static const uint8_t K2[16] =
+{
+    0xF7, 0xDD, 0xAC, 0x30, 0x6A, 0xE2, 0x66, 0xCC, 0xF9, 0x0B, 0xC1, 0x1E, 0xE4, 0x6D, 0x51, 0x3B
+};
+static const uint8_t Message[64] =
+{
+    0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+    0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+    0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11, 0xE5, 0xFB, 0xC1, 0x19, 0x1A, 0x0A, 0x52, 0xEF,
+    0xF6, 0x9F, 0x24, 0x45, 0xDF, 0x4F, 0x9B, 0x17, 0xAD, 0x2B, 0x41, 0x7B, 0xE6, 0x6C, 0x37, 0x10
+};
+
+/*!
+ * RFC 4493 examples 1 to 4
+ */
+typedef struct sCmacKat
+{
+    uint32_t Size;
+    uint8_t Digest[16];
+}CmacKat_t;
+
+static const CmacKat_t Kats[] =
+{
+    { 0,  { 0xBB, 0x1D, 0x69, 0x29, 0xE9, 0x59, 0x37, 0x28, 0x7F, 0xA3, 0x7D, 0x12, 0x9B, 0x75, 0x67, 0x46 } },
+    { 16, { 0x07, 0x0A, 0x16, 0xB4, 0x6B, 0x4D, 0x41, 0x44, 0xF7, 0x9B, 0xDD, 0x9D, 0xD0, 0x4A, 0x28, 0x7C } },
+    { 40, { 0xDF, 0xA6, 0x67, 0x47, 0xDE, 0x9A, 0xE6, 0x30, 0x30, 0xCA, 0x32, 0x61, 0x14, 0x97, 0xC8, 0x27 } },
+    { 64, { 0x51, 0xF0, 0xBE, 0xBF, 0x7E, 0x3B, 0x9D, 0x92, 0xFC, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3C, 0xFE } },
+};
+
+/*!
+ * \brief   CMAC through AES_CMAC_Update, fed in chunks of chunkSize bytes
+ */
+static void IncrementalCmac( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t size, uint32_t chunkSize, uint8_t* digest )
+{
+    AES_CMAC_Init( ctx );
+    AES_CMAC_SetKey( ctx, Key );
+    for( uint32_t i = 0; i < size; i += chunkSize )
+    {
+        AES_CMAC_Update( ctx, &data[i], MIN( chunkSize, size - i ) );
+    }
+    AES_CMAC_Final( digest, ctx );
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbMessages = HostTestRuns( argc, argv, 100000 );
+    uint32_t seed = 0x434D4143;
+    AES_CMAC_CTX ctx;
+    uint8_t digest[16];
+    uint8_t oneShot[16];
+    uint8_t buffer[1 + 16 + 256];
+    double start;
+    double elapsed;
+
+    AES_CMAC_Init( &ctx );
+    AES_CMAC_SetKey( &ctx, Key );
+    HOST_TEST_CHECK( memcmp( ctx.K1, K1, 16 ) == 0 );
+    HOST_TEST_CHECK( memcmp( ctx.K2, K2, 16 ) == 0 );
+
+    for( uint32_t i = 0; i < sizeof( Kats ) / sizeof( Kats[0] ); i++ )
+    {
+        for( uint32_t chunkSize = 1; chunkSize <= MAX( Kats[i].Size, 1 ); chunkSize++ )
+        {
+            IncrementalCmac( &ctx, Message, Kats[i].Size, chunkSize, digest );
+            HOST_TEST_CHECK( memcmp( digest, Kats[i].Digest, 16 ) == 0 );
+        }
+
+        /* One-shot, the key set once for all the messages */
+        AES_CMAC_Compute( &ctx, NULL, Message, Kats[i].Size, oneShot );
+        HOST_TEST_CHECK( memcmp( oneShot, Kats[i].Digest, 16 ) == 0 );
+        if( Kats[i].Size >= 16 )
+        {
+            /* The first block as the B0/B1 prefix */
+            AES_CMAC_Compute( &ctx, Message, &Message[16], Kats[i].Size - 16, oneShot );
+            HOST_TEST_CHECK( memcmp( oneShot, Kats[i].Digest, 16 ) == 0 );
+        }
+    }
+
+    /* Random messages with a prefix block, unaligned buffers */
+    for( uint32_t n = 0; n < 10000; n++ )
+    {
+        uint32_t size = HostTestRand( &seed ) % 256;
+
+        for( uint32_t i = 0; i < ( 16 + size ); i++ )
+        {
+            buffer[1 + i] = ( uint8_t )HostTestRand( &seed );
+        }
+        IncrementalCmac( &ctx, &buffer[1], 16 + size, 1 + HostTestRand( &seed ) % 32, digest );
+        AES_CMAC_Compute( &ctx, &buffer[1], &buffer[1 + 16], size, oneShot );
+        HOST_TEST_CHECK( memcmp( oneShot, digest, 16 ) == 0 );
+    }
+
+    /* Benchmark: MIC of a B0 block and a 64 bytes frame */
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbMessages; n++ )
+    {
+        buffer[1] = ( uint8_t )n;
+        IncrementalCmac( &ctx, &buffer[1], 16 + 64, 16 + 64, digest );
+    }
+    elapsed = HostTestNow( ) - start;
+    printf( "Init/SetKey/Update/Final: %u messages, %.1f ns/message\n", nbMessages, elapsed / nbMessages );
+
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbMessages; n++ )
+    {
+        buffer[1] = ( uint8_t )n;
+        AES_CMAC_Compute( &ctx, &buffer[1], &buffer[1 + 16], 64, oneShot );
+    }
+    elapsed = HostTestNow( ) - start;
+    printf( "Compute, key set once:    %u messages, %.1f ns/message\n", nbMessages, elapsed / nbMessages );
+    HOST_TEST_CHECK( memcmp( oneShot, digest, 16 ) == 0 );
+
+    return HOST_TEST_RESULT( );
+}
@@ -0,0 +1,111 @@
+/*!
+ * \file      crc32_test.c
+ *
+ * \brief     Test and micro-benchmark of the CRC32 of utilities.c
+ *
+ * \remark    Built once for each CRC32_TABLE_SLICES option. Checks Crc32 and
+ *            Crc32Init/Crc32Update/Crc32Finalize against a bitwise reference
+ *            on unaligned buffers, then times the CRC of the seven groups of
+ *            LoRaMacNvmData_t checked by each LoRaMacHandleNvm call.
+ *
+ *            Usage: crc32_test [passes]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "utilities.h"
+#include "LoRaMacInterfaces.h"
+
+#ifndef CRC32_TABLE_SLICES
+#define CRC32_TABLE_SLICES                          1
+#endif
+
+/*!
+ * Size of the CRC computed over a NVM group, its Crc32 field excluded
+ */
+#define NVM_GROUP_CRC_SIZE( group )                 ( sizeof( ( ( LoRaMacNvmData_t* )0 )->group ) - sizeof( uint32_t ) )
+
+static const uint16_t NvmGroupSizes[] =
+{
+    NVM_GROUP_CRC_SIZE( Crypto ),
+    NVM_GROUP_CRC_SIZE( MacGroup1 ),
+    NVM_GROUP_CRC_SIZE( MacGroup2 ),
+    NVM_GROUP_CRC_SIZE( SecureElement ),
+    NVM_GROUP_CRC_SIZE( RegionGroup1 ),
+    NVM_GROUP_CRC_SIZE( RegionGroup2 ),
+    NVM_GROUP_CRC_SIZE( ClassB ),
+};
+
+static uint8_t Buffer[sizeof( LoRaMacNvmData_t ) + 4];
+
+/*!
+ * \brief   Reference CRC32, bit by bit
+ */
+static uint32_t RefCrc32( const uint8_t* buffer, uint32_t length )
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for( uint32_t i = 0; i < length; i++ )
+    {
+        crc ^= buffer[i];
+        for( uint32_t k = 0; k < 8; k++ )
+        {
+            crc = ( crc >> 1 ) ^ ( 0xEDB88320 & ( uint32_t ) - ( int32_t )( crc & 1 ) );
+        }
+    }
+    return ~crc;
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbPasses = HostTestRuns( argc, argv, 20000 );
+    uint32_t seed = 0x43524333;
+    uint32_t nvmSize = 0;
+    volatile uint32_t sink = 0;
+    double start;
+    double elapsed;
+
+    for( uint32_t i = 0; i < sizeof( Buffer ); i++ )
+    {
+        Buffer[i] = ( uint8_t )HostTestRand( &seed );
+    }
+
+    HOST_TEST_CHECK( Crc32( ( uint8_t* )"123456789", 9 ) == 0xCBF43926 );
+    HOST_TEST_CHECK( Crc32( Buffer, 0 ) == 0 );
+
+    for( uint32_t offset = 0; offset < 4; offset++ )
+    {
+        for( uint32_t length = 0; length < 1100; length += 7 )
+        {
+            uint32_t ref = RefCrc32( &Buffer[offset], length );
+            uint32_t split = length / 3;
+            uint32_t crc;
+
+            HOST_TEST_CHECK( Crc32( &Buffer[offset], length ) == ref );
+
+            crc = Crc32Update( Crc32Init( ), &Buffer[offset], split );
+            crc = Crc32Update( crc, &Buffer[offset + split], length - split );
+            HOST_TEST_CHECK( Crc32Finalize( crc ) == ref );
+        }
+    }
+
+    for( uint32_t g = 0; g < sizeof( NvmGroupSizes ) / sizeof( NvmGroupSizes[0] ); g++ )
+    {
+        HOST_TEST_CHECK( Crc32( Buffer, NvmGroupSizes[g] ) == RefCrc32( Buffer, NvmGroupSizes[g] ) );
+        nvmSize += NvmGroupSizes[g];
+    }
+
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbPasses; n++ )
+    {
+        for( uint32_t g = 0; g < sizeof( NvmGroupSizes ) / sizeof( NvmGroupSizes[0] ); g++ )
+        {
+            sink += Crc32( Buffer, NvmGroupSizes[g] );
+        }
+    }
+    elapsed = HostTestNow( ) - start;
+    printf( "CRC32_TABLE_SLICES %d: %u NVM groups, %u bytes, %.2f us per LoRaMacHandleNvm pass, %.2f ns/byte\n",
+            CRC32_TABLE_SLICES, ( unsigned )( sizeof( NvmGroupSizes ) / sizeof( NvmGroupSizes[0] ) ), nvmSize,
+            elapsed / nbPasses / 1000, elapsed / nbPasses / nvmSize );
+
+    return HOST_TEST_RESULT( );
+}
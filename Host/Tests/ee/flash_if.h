@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    flash_if.h
+  * @author  MCD Application Team
+  * @brief   Host build: flash interface of ee.c, implemented by the flash
+  *          simulator of sigfox_ee_test.c
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FLASH_IF_H__
+#define __FLASH_IF_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "platform.h"
+
+/* Exported constants --------------------------------------------------------*/
+/**
+  * @brief Flash page size of the STM32WL, from the HAL
+  */
+#define FLASH_PAGE_SIZE         0x00000800U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Flash status
+  */
+typedef enum
+{
+  FLASH_IF_PARAM_ERROR  = -6, /*!< Error Flash invalid parameter */
+  FLASH_IF_LOCK_ERROR   = -5, /*!< Error Flash not locked */
+  FLASH_IF_WRITE_ERROR  = -4, /*!< Error Flash write not possible */
+  FLASH_IF_READ_ERROR   = -3, /*!< Error Flash read not possible */
+  FLASH_IF_ERASE_ERROR  = -2, /*!< Error Flash erase not possible */
+  FLASH_IF_ERROR        = -1, /*!< Error Flash generic */
+  FLASH_IF_OK           = 0,  /*!< Flash Success */
+  FLASH_IF_BUSY         = 1   /*!< Flash not available */
+} FLASH_IF_StatusTypedef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+FLASH_IF_StatusTypedef FLASH_IF_Write(void *pDestination, const void *pSource, uint32_t uLength);
+FLASH_IF_StatusTypedef FLASH_IF_Erase(void *pStart, uint32_t uLength);
+
+#endif /* __FLASH_IF_H__ */
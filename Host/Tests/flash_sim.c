@@ -0,0 +1,228 @@
+/*!
+ * \file      flash_sim.c
+ *
+ * \brief     RAM flash simulator of the host tests
+ */
+#include <stdlib.h>
+#include <string.h>
+#ifdef FLASH_SIM_ADDRESS
+#include <sys/mman.h>
+#endif
+#include "host_test.h"
+#include "flash_sim.h"
+
+/*!
+ * Largest simulated flash
+ */
+#define FLASH_SIM_MAX_SIZE                          ( 64 * 1024 )
+
+/*!
+ * Smallest simulated page
+ */
+#define FLASH_SIM_MIN_PAGE_SIZE                     512
+
+FlashSimStats_t FlashSimStats;
+
+#ifdef FLASH_SIM_ADDRESS
+/*!
+ * Flash mapped at FLASH_SIM_ADDRESS, for the code addressing the flash
+ * through 32-bit addresses
+ */
+static uint8_t* Memory = NULL;
+#else
+static uint8_t MemoryBuffer[FLASH_SIM_MAX_SIZE];
+static uint8_t* Memory = MemoryBuffer;
+#endif
+static uint32_t PageErases[FLASH_SIM_MAX_SIZE / FLASH_SIM_MIN_PAGE_SIZE];
+static uint32_t Size;
+static uint32_t WriteSize;
+static uint32_t PageSize;
+static uint32_t Seed;
+
+/*!
+ * Remaining operations before the scheduled failures, negative when none is scheduled
+ */
+static int32_t PowerFailCountdown = -1;
+static int32_t ReadFailCountdown = -1;
+static int32_t WriteFailCountdown = -1;
+static bool PowerLost = false;
+
+/*!
+ * \brief   Counts down an operation
+ *
+ * \retval  true when the scheduled failure is reached
+ */
+static bool CountDown( int32_t* countdown )
+{
+    if( *countdown < 0 )
+    {
+        return false;
+    }
+    if( *countdown == 0 )
+    {
+        *countdown = -1;
+        return true;
+    }
+    ( *countdown )--;
+    return false;
+}
+
+static bool CheckRange( uint32_t offset, uint32_t size, uint32_t granularity )
+{
+    if( ( ( offset % granularity ) != 0 ) || ( ( size % granularity ) != 0 ) || ( offset > Size ) ||
+        ( size > Size - offset ) )
+    {
+        FlashSimStats.Violations++;
+        return false;
+    }
+    return true;
+}
+
+void FlashSimInit( uint32_t size, uint32_t writeSize, uint32_t pageSize, uint32_t seed )
+{
+    if( ( size > FLASH_SIM_MAX_SIZE ) || ( pageSize < FLASH_SIM_MIN_PAGE_SIZE ) || ( ( size % pageSize ) != 0 ) )
+    {
+        printf( "flash simulator: unsupported geometry\n" );
+        exit( 2 );
+    }
+#ifdef FLASH_SIM_ADDRESS
+    if( Memory == NULL )
+    {
+        Memory = mmap( ( void* )( uintptr_t )FLASH_SIM_ADDRESS, FLASH_SIM_MAX_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if( Memory != ( uint8_t* )( uintptr_t )FLASH_SIM_ADDRESS )
+        {
+            printf( "flash simulator: cannot map the flash at 0x%08lX\n", ( unsigned long )FLASH_SIM_ADDRESS );
+            exit( 2 );
+        }
+    }
+#endif
+    Size = size;
+    WriteSize = writeSize;
+    PageSize = pageSize;
+    Seed = seed;
+    memset( Memory, 0xFF, FLASH_SIM_MAX_SIZE );
+    memset( PageErases, 0, sizeof( PageErases ) );
+    memset( &FlashSimStats, 0, sizeof( FlashSimStats ) );
+    PowerFailCountdown = -1;
+    ReadFailCountdown = -1;
+    WriteFailCountdown = -1;
+    PowerLost = false;
+}
+
+void FlashSimClearStats( void )
+{
+    uint32_t violations = FlashSimStats.Violations;
+    uint32_t maxPageErases = FlashSimStats.MaxPageErases;
+
+    memset( &FlashSimStats, 0, sizeof( FlashSimStats ) );
+    FlashSimStats.Violations = violations;
+    FlashSimStats.MaxPageErases = maxPageErases;
+}
+
+uint8_t* FlashSimMemory( void )
+{
+    return Memory;
+}
+
+int32_t FlashSimRead( uint32_t offset, uint8_t* data, uint32_t size )
+{
+    if( ( PowerLost == true ) || ( CheckRange( offset, size, 1 ) == false ) || ( CountDown( &ReadFailCountdown ) == true ) )
+    {
+        return -1;
+    }
+    memcpy( data, &Memory[offset], size );
+    FlashSimStats.Reads++;
+    FlashSimStats.ReadBytes += size;
+    return 0;
+}
+
+int32_t FlashSimWrite( uint32_t offset, const uint8_t* data, uint32_t size )
+{
+    if( ( PowerLost == true ) || ( CheckRange( offset, size, WriteSize ) == false ) )
+    {
+        return -1;
+    }
+    for( uint32_t i = 0; i < size; i++ )
+    {
+        if( Memory[offset + i] != 0xFF )
+        {
+            FlashSimStats.Violations++;
+            return -1;
+        }
+    }
+    if( CountDown( &WriteFailCountdown ) == true )
+    {
+        return -1;
+    }
+
+    if( CountDown( &PowerFailCountdown ) == true )
+    {
+        /* The units before the torn one are programmed, the torn one holds a partial value */
+        uint32_t units = HostTestRand( &Seed ) % ( size / WriteSize );
+
+        memcpy( &Memory[offset], data, units * WriteSize );
+        for( uint32_t i = units * WriteSize; i < ( units + 1 ) * WriteSize; i++ )
+        {
+            Memory[offset + i] = data[i] | ( uint8_t )HostTestRand( &Seed );
+        }
+        PowerLost = true;
+        return -1;
+    }
+
+    memcpy( &Memory[offset], data, size );
+    FlashSimStats.Writes++;
+    FlashSimStats.WrittenBytes += size;
+    return 0;
+}
+
+int32_t FlashSimErase( uint32_t offset, uint32_t size )
+{
+    if( ( PowerLost == true ) || ( CheckRange( offset, size, PageSize ) == false ) )
+    {
+        return -1;
+    }
+
+    for( uint32_t page = offset / PageSize; page < ( offset + size ) / PageSize; page++ )
+    {
+        if( CountDown( &PowerFailCountdown ) == true )
+        {
+            /* The torn page is partially erased */
+            for( uint32_t i = 0; i < PageSize; i++ )
+            {
+                Memory[page * PageSize + i] |= ( uint8_t )HostTestRand( &Seed );
+            }
+            PowerLost = true;
+            return -1;
+        }
+        memset( &Memory[page * PageSize], 0xFF, PageSize );
+        if( ++PageErases[page] > FlashSimStats.MaxPageErases )
+        {
+            FlashSimStats.MaxPageErases = PageErases[page];
+        }
+    }
+    FlashSimStats.Erases++;
+    return 0;
+}
+
+void FlashSimPowerFailAfter( int32_t operations )
+{
+    PowerFailCountdown = operations;
+}
+
+bool FlashSimPowerLost( void )
+{
+    return PowerLost;
+}
+
+void FlashSimPowerOn( void )
+{
+    PowerLost = false;
+    PowerFailCountdown = -1;
+}
+
+void FlashSimFailAfter( int32_t reads, int32_t writes )
+{
+    ReadFailCountdown = reads;
+    WriteFailCountdown = writes;
+}
@@ -0,0 +1,96 @@
+/*!
+ * \file      flash_sim.h
+ *
+ * \brief     RAM flash simulator of the host tests
+ *
+ * \remark    Behaves like the internal flash of the STM32WL: programming is
+ *            only allowed on erased bytes, at offsets and sizes multiple of
+ *            the programming granularity, and erasing is done by pages. Each
+ *            rule violation is counted and the operation fails.
+ *
+ *            A power loss can be scheduled on a given program or erase
+ *            operation: that operation is torn, the following ones fail
+ *            until FlashSimPowerOn is called, which stands for the reset.
+ *
+ *            Built with FLASH_SIM_ADDRESS, the flash is mapped at that address
+ *            for the code reading the flash through 32-bit pointers.
+ */
+#ifndef __FLASH_SIM_H__
+#define __FLASH_SIM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*!
+ * Flash simulator statistics, cleared by FlashSimInit and FlashSimClearStats
+ */
+typedef struct sFlashSimStats
+{
+    uint32_t Reads;
+    uint32_t ReadBytes;
+    uint32_t Writes;
+    uint32_t WrittenBytes;
+    uint32_t Erases;
+    /*!
+     * Programming of non erased bytes, misaligned or out of range accesses
+     */
+    uint32_t Violations;
+    /*!
+     * Erase count of the most erased page
+     */
+    uint32_t MaxPageErases;
+}FlashSimStats_t;
+
+extern FlashSimStats_t FlashSimStats;
+
+/*!
+ * \brief   Initializes an erased flash
+ *
+ * \param   [IN] size      Flash size, multiple of pageSize
+ * \param   [IN] writeSize Programming granularity
+ * \param   [IN] pageSize  Erase granularity
+ * \param   [IN] seed      Seed of the torn operations, not 0
+ */
+void FlashSimInit( uint32_t size, uint32_t writeSize, uint32_t pageSize, uint32_t seed );
+
+/*!
+ * \brief   Clears the statistics, the violations and the erase counts of the pages are kept
+ */
+void FlashSimClearStats( void );
+
+/*!
+ * \brief   Content of the flash, for direct reads
+ */
+uint8_t* FlashSimMemory( void );
+
+int32_t FlashSimRead( uint32_t offset, uint8_t* data, uint32_t size );
+int32_t FlashSimWrite( uint32_t offset, const uint8_t* data, uint32_t size );
+int32_t FlashSimErase( uint32_t offset, uint32_t size );
+
+/*!
+ * \brief   Schedules a power loss
+ *
+ * \param   [IN] operations Number of program or erase operations completed
+ *                          before the torn one, negative to cancel
+ */
+void FlashSimPowerFailAfter( int32_t operations );
+
+/*!
+ * \brief   Set once the scheduled power loss happened
+ */
+bool FlashSimPowerLost( void );
+
+/*!
+ * \brief   Restores the power after a power loss
+ */
+void FlashSimPowerOn( void );
+
+/*!
+ * \brief   Makes a read or a program operation fail, without power loss
+ *
+ * \param   [IN] reads  Number of reads completed before the failing one, negative to cancel
+ * \param   [IN] writes Number of program operations completed before the failing one, negative to cancel
+ */
+void FlashSimFailAfter( int32_t reads, int32_t writes );
+
+#endif // __FLASH_SIM_H__
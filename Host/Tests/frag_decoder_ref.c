@@ -0,0 +1,30 @@
+/*!
+ * \file      frag_decoder_ref.c
+ *
+ * \brief     FragDecoder.c without row cache and write block, reference of the
+ *            frag_decoder_test builds which enable them
+ *
+ * \remark    The public functions are renamed with a Ref prefix so that both
+ *            builds of the decoder link into one test. FragDecoder_t does not
+ *            depend on the options, the reference shares the context type.
+ */
+#undef FRAG_DECODER_ROW_CACHE_SIZE
+#undef FRAG_DECODER_WRITE_BLOCK_SIZE
+#define FRAG_DECODER_ROW_CACHE_SIZE                 0
+#define FRAG_DECODER_WRITE_BLOCK_SIZE               0
+
+#define FragDecoderInit                             RefFragDecoderInit
+#define FragDecoderGetMaxFileSize                   RefFragDecoderGetMaxFileSize
+#define FragDecoderProcess                          RefFragDecoderProcess
+#define FragDecoderQueue                            RefFragDecoderQueue
+#define FragDecoderProcessPending                   RefFragDecoderProcessPending
+#define FragDecoderIsPending                        RefFragDecoderIsPending
+#define FragDecoderGetStatus                        RefFragDecoderGetStatus
+#define FragDecoderGetLeadingRows                   RefFragDecoderGetLeadingRows
+
+#include "FragDecoder.c"
+
+uint32_t RefFragDecoderStorageSize( uint16_t fragNb, uint8_t fragSize, uint16_t maxRedundancy )
+{
+    return FRAG_DECODER_STORAGE_SIZE( fragNb, fragSize, maxRedundancy );
+}
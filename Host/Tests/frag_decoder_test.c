@@ -0,0 +1,520 @@
+/*!
+ * \file      frag_decoder_test.c
+ *
+ * \brief     Lossy replay test and benchmark of FragDecoder.c, synchronous and
+ *            sliced decoding
+ *
+ * \remark    Encodes random files with the parity matrix of the fragmentation
+ *            package and replays the uncoded then the coded fragments to
+ *            FragDecoderProcess, dropping fragments at random. A session which
+ *            finishes without a matrix error shall have written the file, a
+ *            session which lost more fragments than the storage can recover
+ *            shall report a matrix error. The loss of the last uncoded
+ *            fragments, only counted on the first coded fragment, is replayed
+ *            on its own. Guard words behind the storage catch the decoder
+ *            writing out of it. Each random session is replayed a second time
+ *            through FragDecoderQueue and FragDecoderProcessPending, a slice of
+ *            a random number of rows after each frame, which shall give the
+ *            status, the flash accesses and the file of FragDecoderProcess.
+ *            Then times a session of 2000 fragments of 200 bytes with the loss
+ *            rate given on the command line, synchronous and sliced.
+ *
+ *            A config blob of 24 fragments of 40 bytes is decoded with a
+ *            storage of well under 1 KB, which recovers 2 lost fragments; a
+ *            storage which cannot recover one is refused by FragDecoderInit.
+ *
+ *            When built with FRAG_DECODER_ROW_CACHE_SIZE or
+ *            FRAG_DECODER_WRITE_BLOCK_SIZE, each session is first replayed on
+ *            the decoder built without them, frag_decoder_ref.c: the status
+ *            and the file shall be the same with no more flash reads and
+ *            writes, and fewer over all the sessions.
+ *
+ *            Usage: frag_decoder_test [sessions] [loss per thousand]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "utilities.h"
+#include "FragDecoder.h"
+#include "frag_decoder_if.h"
+
+/*!
+ * Config blob decoded with a small storage
+ */
+#define SMALL_NB                                    24
+#define SMALL_SIZE                                  40
+#define SMALL_REDUNDANCY                            2
+
+/*!
+ * Largest file of the random sessions
+ */
+#define TEST_MAX_NB                                 300
+#define TEST_MAX_SIZE                               64
+#define TEST_MAX_REDUNDANCY                         40
+
+/*!
+ * File of the benchmark
+ */
+#define BENCH_NB                                    2000
+#define BENCH_SIZE                                  200
+
+/*!
+ * Rows decoded by a slice of the benchmark, as FRAGMENTATION_PROCESS_SLICE_ROWS
+ */
+#define BENCH_SLICE_ROWS                            8
+
+/*!
+ * Coded fragments sent after the file
+ */
+#define NB_CODED( maxRedundancy )                   ( 2 * ( maxRedundancy ) + 20 )
+
+/*!
+ * Storage of the row cache and of the write block of a file of fragSize
+ * bytes fragments, see FRAG_DECODER_FILE_STORAGE_SIZE
+ */
+#define OPTIONS_STORAGE_SIZE( fragSize )                                                            \
+    ( FRAG_DECODER_ROW_CACHE_SIZE * FRAG_DECODER_LINE_SIZE( fragSize ) +                            \
+      FRAG_DECODER_ARRAY16_SIZE( FRAG_DECODER_ROW_CACHE_SIZE ) + 4 * FRAG_DECODER_ROW_CACHE_SIZE +  \
+      FRAG_DECODER_LINE_SIZE( FRAG_DECODER_WRITE_BLOCK_SIZE ) )
+
+/*!
+ * The sessions are compared with the decoder built without the options
+ */
+#define REFERENCE_ENABLED                           ( ( FRAG_DECODER_ROW_CACHE_SIZE > 0 ) || ( FRAG_DECODER_WRITE_BLOCK_SIZE > 0 ) )
+
+#define GUARD_WORDS                                 16
+#define GUARD                                       0xA5C3E187
+
+static uint8_t File[FRAG_MAX_NB * FRAG_MAX_SIZE];
+static uint8_t Flash[FRAG_MAX_NB * FRAG_MAX_SIZE];
+static uint32_t FlashSize;
+static uint32_t Reads;
+static uint32_t Writes;
+static uint32_t OutOfFlash;
+
+static bool Lost[FRAG_MAX_NB + NB_CODED( FRAG_MAX_REDUNDANCY )];
+static uint32_t Storage[FRAG_DECODER_STORAGE_SIZE( FRAG_MAX_NB, FRAG_MAX_SIZE, FRAG_MAX_REDUNDANCY ) / 4 + GUARD_WORDS];
+static FragDecoder_t Decoder;
+static uint32_t Seed = 0x46524147;
+
+#if REFERENCE_ENABLED
+/*!
+ * Decoder of frag_decoder_ref.c
+ */
+int32_t RefFragDecoderInit( FragDecoder_t *decoder, uint32_t *storage, uint32_t storageSize,
+                            uint16_t fragNb, uint8_t fragSize, FragDecoderCallbacks_t *callbacks, uint8_t fragPVer );
+int32_t RefFragDecoderProcess( FragDecoder_t *decoder, uint16_t fragCounter, uint8_t *rawData );
+FragDecoderStatus_t RefFragDecoderGetStatus( FragDecoder_t *decoder );
+uint32_t RefFragDecoderStorageSize( uint16_t fragNb, uint8_t fragSize, uint16_t maxRedundancy );
+
+/*!
+ * Flash accesses of the sessions with and without the options
+ */
+static uint32_t TotalReads;
+static uint32_t TotalWrites;
+static uint32_t RefTotalReads;
+static uint32_t RefTotalWrites;
+#endif /* REFERENCE_ENABLED */
+
+static int32_t FlashErase( void )
+{
+    memset( Flash, 0xFF, FlashSize );
+    return 0;
+}
+
+static int32_t FlashWrite( uint32_t addr, uint8_t* data, uint32_t size )
+{
+    Writes++;
+    if( ( addr + size ) > FlashSize )
+    {
+        OutOfFlash++;
+        return -1;
+    }
+    memcpy( &Flash[addr], data, size );
+    return 0;
+}
+
+static int32_t FlashRead( uint32_t addr, uint8_t* data, uint32_t size )
+{
+    Reads++;
+    if( ( addr + size ) > FlashSize )
+    {
+        OutOfFlash++;
+        return -1;
+    }
+    memcpy( data, &Flash[addr], size );
+    return 0;
+}
+
+static FragDecoderCallbacks_t Callbacks = { FlashErase, FlashWrite, FlashRead };
+
+static int32_t Prbs23( int32_t value )
+{
+    int32_t b0 = value & 1;
+    int32_t b1 = ( value & 0x20 ) >> 5;
+
+    return ( value >> 1 ) + ( ( b0 ^ b1 ) << 22 );
+}
+
+/*!
+ * \brief   Row n of the parity matrix of a file of m fragments, one byte per
+ *          fragment, as given by the fragmentation package specification
+ */
+static void GetParityRow( int32_t n, int32_t m, uint8_t* row, uint8_t fragPVer )
+{
+    int32_t mTemp = ( ( m & ( m - 1 ) ) == 0 ) ? 1 : 0;
+    int32_t x = 1 + ( 1001 * n );
+    int32_t nbCoeff = 0;
+    int32_t r;
+
+    memset( row, 0, m );
+    while( nbCoeff < ( m >> 1 ) )
+    {
+        r = 1 << 16;
+        while( r >= m )
+        {
+            x = Prbs23( x );
+            r = x % ( m + mTemp );
+        }
+        if( ( row[r] == 0 ) || ( fragPVer == 1 ) )
+        {
+            row[r] = 1;
+            nbCoeff++;
+        }
+    }
+}
+
+/*!
+ * \brief   Fragment fragCounter of the file, uncoded then coded
+ */
+static void GetFragment( uint16_t fragCounter, uint16_t fragNb, uint8_t fragSize, uint8_t fragPVer, uint8_t* frag )
+{
+    static uint8_t row[FRAG_MAX_NB];
+
+    if( fragCounter <= fragNb )
+    {
+        memcpy( frag, &File[( fragCounter - 1 ) * fragSize], fragSize );
+        return;
+    }
+    GetParityRow( fragCounter - fragNb, fragNb, row, fragPVer );
+    memset( frag, 0, fragSize );
+    for( uint16_t j = 0; j < fragNb; j++ )
+    {
+        if( row[j] != 0 )
+        {
+            for( uint8_t k = 0; k < fragSize; k++ )
+            {
+                frag[k] ^= File[j * fragSize + k];
+            }
+        }
+    }
+}
+
+/*!
+ * \brief   Starts a session on a storage sized to recover maxRedundancy lost
+ *          fragments, guard words behind it
+ */
+static void StartSession( uint16_t fragNb, uint8_t fragSize, uint16_t maxRedundancy, uint8_t fragPVer )
+{
+    uint32_t storageSize = FRAG_DECODER_STORAGE_SIZE( fragNb, fragSize, maxRedundancy );
+
+    for( uint32_t i = 0; i < GUARD_WORDS; i++ )
+    {
+        Storage[storageSize / 4 + i] = GUARD;
+    }
+    FlashSize = fragNb * fragSize;
+    Reads = 0;
+    Writes = 0;
+    OutOfFlash = 0;
+    HOST_TEST_CHECK( FragDecoderInit( &Decoder, Storage, storageSize, fragNb, fragSize, &Callbacks, fragPVer ) == 0 );
+}
+
+static bool GuardsIntact( uint16_t fragNb, uint8_t fragSize, uint16_t maxRedundancy )
+{
+    uint32_t storageSize = FRAG_DECODER_STORAGE_SIZE( fragNb, fragSize, maxRedundancy );
+
+    for( uint32_t i = 0; i < GUARD_WORDS; i++ )
+    {
+        if( Storage[storageSize / 4 + i] != GUARD )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief   Checks the end of a session against the fragments lost
+ */
+static void CheckSession( int32_t status, uint16_t fragNb, uint8_t fragSize, uint16_t maxRedundancy, uint16_t nbLost )
+{
+    FragDecoderStatus_t decoderStatus = FragDecoderGetStatus( &Decoder );
+
+    HOST_TEST_CHECK( GuardsIntact( fragNb, fragSize, maxRedundancy ) == true );
+    HOST_TEST_CHECK( OutOfFlash == 0 );
+    if( status < 0 )
+    {
+        // Not enough coded fragments to recover the lost ones
+        HOST_TEST_CHECK( nbLost > 0 );
+        return;
+    }
+    if( nbLost > Decoder.MaxRedundancy )
+    {
+        // The decoder stops counting once it cannot recover the file
+        HOST_TEST_CHECK( decoderStatus.MatrixError == 1 );
+        HOST_TEST_CHECK( ( decoderStatus.FragNbLost > Decoder.MaxRedundancy ) && ( decoderStatus.FragNbLost <= nbLost ) );
+    }
+    else
+    {
+        HOST_TEST_CHECK( decoderStatus.MatrixError == 0 );
+        HOST_TEST_CHECK( decoderStatus.FragNbLost == nbLost );
+        HOST_TEST_CHECK( memcmp( Flash, File, fragNb * fragSize ) == 0 );
+    }
+}
+
+/*!
+ * \brief   Draws a random file and the fragments lost: the uncoded fragments
+ *          from fragNb - tailLost + 1 and a random share of lossPerThousand
+ *          of all
+ *
+ * \retval  Number of uncoded fragments lost
+ */
+static uint16_t DrawSession( uint16_t fragNb, uint8_t fragSize, uint16_t nbCoded, uint32_t lossPerThousand, uint16_t tailLost )
+{
+    uint16_t nbLost = 0;
+
+    for( uint32_t i = 0; i < ( uint32_t )( fragNb * fragSize ); i++ )
+    {
+        File[i] = ( uint8_t )HostTestRand( &Seed );
+    }
+    for( uint16_t fragCounter = 1; fragCounter <= ( fragNb + nbCoded ); fragCounter++ )
+    {
+        Lost[fragCounter - 1] = ( ( HostTestRand( &Seed ) % 1000 ) < lossPerThousand ) ||
+                                ( ( fragCounter <= fragNb ) && ( fragCounter > ( fragNb - tailLost ) ) );
+        nbLost += ( ( Lost[fragCounter - 1] == true ) && ( fragCounter <= fragNb ) ) ? 1 : 0;
+    }
+    return nbLost;
+}
+
+/*!
+ * \brief   Replays the session drawn, with FragDecoderProcess when sliceRows
+ *          is 0, else with FragDecoderQueue and a slice of sliceRows rows
+ *          after each frame. The time of the longest call is added to longest.
+ *
+ * \retval  Status of the session
+ */
+static int32_t Replay( uint16_t fragNb, uint8_t fragSize, uint16_t maxRedundancy, uint8_t fragPVer,
+                       uint32_t sliceRows, double* longest )
+{
+    uint8_t frag[FRAG_MAX_SIZE];
+    int32_t status = FRAG_SESSION_ONGOING;
+    double start;
+    double elapsed;
+
+    StartSession( fragNb, fragSize, maxRedundancy, fragPVer );
+    for( uint16_t fragCounter = 1; ( fragCounter <= ( fragNb + NB_CODED( maxRedundancy ) ) ) && ( status < 0 ); fragCounter++ )
+    {
+        if( Lost[fragCounter - 1] == true )
+        {
+            continue;
+        }
+        GetFragment( fragCounter, fragNb, fragSize, fragPVer, frag );
+        start = HostTestNow( );
+        if( sliceRows == 0 )
+        {
+            status = FragDecoderProcess( &Decoder, fragCounter, frag );
+        }
+        else
+        {
+            status = FragDecoderQueue( &Decoder, fragCounter, frag );
+            if( status < 0 )
+            {
+                status = FragDecoderProcessPending( &Decoder, sliceRows );
+            }
+        }
+        elapsed = HostTestNow( ) - start;
+        *longest = ( elapsed > *longest ) ? elapsed : *longest;
+    }
+    /* The frames left in the queue */
+    while( ( status < 0 ) && ( FragDecoderIsPending( &Decoder ) == true ) )
+    {
+        status = FragDecoderProcessPending( &Decoder, sliceRows );
+    }
+    HOST_TEST_CHECK( FragDecoderIsPending( &Decoder ) == false );
+    return status;
+}
+
+#if REFERENCE_ENABLED
+/*!
+ * \brief   Replays the session drawn with FragDecoderProcess of the decoder
+ *          built without the options
+ *
+ * \retval  Status of the session
+ */
+static int32_t ReplayReference( uint16_t fragNb, uint8_t fragSize, uint16_t maxRedundancy, uint8_t fragPVer )
+{
+    uint8_t frag[FRAG_MAX_SIZE];
+    int32_t status = FRAG_SESSION_ONGOING;
+
+    FlashSize = fragNb * fragSize;
+    Reads = 0;
+    Writes = 0;
+    OutOfFlash = 0;
+    HOST_TEST_CHECK( RefFragDecoderInit( &Decoder, Storage, RefFragDecoderStorageSize( fragNb, fragSize, maxRedundancy ),
+                                         fragNb, fragSize, &Callbacks, fragPVer ) == 0 );
+    for( uint16_t fragCounter = 1; ( fragCounter <= ( fragNb + NB_CODED( maxRedundancy ) ) ) && ( status < 0 ); fragCounter++ )
+    {
+        if( Lost[fragCounter - 1] == false )
+        {
+            GetFragment( fragCounter, fragNb, fragSize, fragPVer, frag );
+            status = RefFragDecoderProcess( &Decoder, fragCounter, frag );
+        }
+    }
+    HOST_TEST_CHECK( OutOfFlash == 0 );
+    return status;
+}
+#endif /* REFERENCE_ENABLED */
+
+/*!
+ * \brief   Replays the session drawn synchronously then sliced, the sliced
+ *          decoding shall give the same results. With the options, the
+ *          decoder built without them shall give the same results with as
+ *          many flash accesses or more.
+ *
+ * \retval  Status of the session
+ */
+static int32_t ReplayBoth( uint16_t fragNb, uint8_t fragSize, uint16_t maxRedundancy, uint8_t fragPVer, uint32_t sliceRows )
+{
+    static uint8_t flash[FRAG_MAX_NB * FRAG_MAX_SIZE];
+    FragDecoderStatus_t decoderStatus;
+    uint32_t reads;
+    uint32_t writes;
+    int32_t status;
+    double longest = 0;
+#if REFERENCE_ENABLED
+    FragDecoderStatus_t refDecoderStatus;
+    int32_t refStatus;
+
+    refStatus = ReplayReference( fragNb, fragSize, maxRedundancy, fragPVer );
+    refDecoderStatus = RefFragDecoderGetStatus( &Decoder );
+    reads = Reads;
+    writes = Writes;
+    memcpy( flash, Flash, FlashSize );
+
+    status = Replay( fragNb, fragSize, maxRedundancy, fragPVer, 0, &longest );
+    HOST_TEST_CHECK( status == refStatus );
+    HOST_TEST_CHECK( FragDecoderGetStatus( &Decoder ).FragNbRx == refDecoderStatus.FragNbRx );
+    HOST_TEST_CHECK( FragDecoderGetStatus( &Decoder ).FragNbLost == refDecoderStatus.FragNbLost );
+    HOST_TEST_CHECK( FragDecoderGetStatus( &Decoder ).FragNbLastRx == refDecoderStatus.FragNbLastRx );
+    HOST_TEST_CHECK( FragDecoderGetStatus( &Decoder ).MatrixError == refDecoderStatus.MatrixError );
+    HOST_TEST_CHECK( memcmp( Flash, flash, FlashSize ) == 0 );
+    HOST_TEST_CHECK( ( Reads <= reads ) && ( Writes <= writes ) );
+    TotalReads += Reads;
+    TotalWrites += Writes;
+    RefTotalReads += reads;
+    RefTotalWrites += writes;
+#else
+    status = Replay( fragNb, fragSize, maxRedundancy, fragPVer, 0, &longest );
+#endif /* REFERENCE_ENABLED */
+    decoderStatus = FragDecoderGetStatus( &Decoder );
+    reads = Reads;
+    writes = Writes;
+    memcpy( flash, Flash, FlashSize );
+
+    HOST_TEST_CHECK( Replay( fragNb, fragSize, maxRedundancy, fragPVer, sliceRows, &longest ) == status );
+    HOST_TEST_CHECK( FragDecoderGetStatus( &Decoder ).FragNbRx == decoderStatus.FragNbRx );
+    HOST_TEST_CHECK( FragDecoderGetStatus( &Decoder ).FragNbLost == decoderStatus.FragNbLost );
+    HOST_TEST_CHECK( FragDecoderGetStatus( &Decoder ).FragNbLastRx == decoderStatus.FragNbLastRx );
+    HOST_TEST_CHECK( FragDecoderGetStatus( &Decoder ).MatrixError == decoderStatus.MatrixError );
+    HOST_TEST_CHECK( ( Reads == reads ) && ( Writes == writes ) );
+    HOST_TEST_CHECK( memcmp( Flash, flash, FlashSize ) == 0 );
+    return status;
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbSessions = HostTestRuns( argc, argv, 300 );
+    uint32_t lossPerThousand = ( argc > 2 ) ? ( uint32_t )strtoul( argv[2], NULL, 0 ) : 50;
+    uint32_t nbRecovered = 0;
+    uint32_t nbMatrixErrors = 0;
+    uint16_t nbLost;
+    int32_t status;
+    double start;
+    double elapsed;
+    double longest = 0;
+
+    /* The last uncoded fragments are lost: one more than the storage recovers, then just enough */
+    for( uint8_t fragPVer = 1; fragPVer <= 2; fragPVer++ )
+    {
+        nbLost = DrawSession( 40, 20, NB_CODED( 4 ), 0, 5 );
+        status = ReplayBoth( 40, 20, 4, fragPVer, 3 );
+        HOST_TEST_CHECK( ( status == FRAG_SESSION_FINISHED ) && ( FragDecoderGetStatus( &Decoder ).MatrixError == 1 ) );
+        HOST_TEST_CHECK( FragDecoderGetStatus( &Decoder ).FragNbRx == 41 );
+        CheckSession( status, 40, 20, 4, nbLost );
+
+        nbLost = DrawSession( 40, 20, NB_CODED( 4 ), 0, 4 );
+        status = ReplayBoth( 40, 20, 4, fragPVer, 3 );
+        HOST_TEST_CHECK( status == 4 );
+        CheckSession( status, 40, 20, 4, nbLost );
+    }
+
+    /* Small storage: refused when it cannot recover a lost fragment, else recovers what it can hold */
+    HOST_TEST_CHECK( ( FRAG_DECODER_STORAGE_SIZE( SMALL_NB, SMALL_SIZE, SMALL_REDUNDANCY ) - OPTIONS_STORAGE_SIZE( SMALL_SIZE ) ) < 1024 );
+    HOST_TEST_CHECK( FragDecoderInit( &Decoder, Storage, FRAG_DECODER_STORAGE_SIZE( SMALL_NB, SMALL_SIZE, 1 ) - 4,
+                                      SMALL_NB, SMALL_SIZE, &Callbacks, 2 ) == -1 );
+    HOST_TEST_CHECK( FragDecoderInit( &Decoder, Storage, FRAG_DECODER_STORAGE_SIZE( SMALL_NB, SMALL_SIZE, SMALL_REDUNDANCY + 1 ) - 4,
+                                      SMALL_NB, SMALL_SIZE, &Callbacks, 2 ) == 0 );
+    HOST_TEST_CHECK( Decoder.MaxRedundancy == SMALL_REDUNDANCY );
+    for( uint16_t tailLost = 0; tailLost <= ( SMALL_REDUNDANCY + 1 ); tailLost++ )
+    {
+        nbLost = DrawSession( SMALL_NB, SMALL_SIZE, NB_CODED( SMALL_REDUNDANCY ), 0, tailLost );
+        status = ReplayBoth( SMALL_NB, SMALL_SIZE, SMALL_REDUNDANCY, 2, 1 );
+        HOST_TEST_CHECK( Decoder.MaxRedundancy == SMALL_REDUNDANCY );
+        HOST_TEST_CHECK( ( tailLost > SMALL_REDUNDANCY ) ? ( FragDecoderGetStatus( &Decoder ).MatrixError == 1 ) : ( status == tailLost ) );
+        CheckSession( status, SMALL_NB, SMALL_SIZE, SMALL_REDUNDANCY, nbLost );
+    }
+
+    /* Random sessions, some of them losing their last uncoded fragments */
+    for( uint32_t n = 0; n < nbSessions; n++ )
+    {
+        uint16_t fragNb = 1 + HostTestRand( &Seed ) % TEST_MAX_NB;
+        uint8_t fragSize = 1 + HostTestRand( &Seed ) % TEST_MAX_SIZE;
+        uint16_t maxRedundancy = MIN( 1 + HostTestRand( &Seed ) % TEST_MAX_REDUNDANCY, fragNb );
+        uint8_t fragPVer = 1 + HostTestRand( &Seed ) % 2;
+        uint16_t tailLost = ( ( n % 4 ) == 0 ) ? MIN( HostTestRand( &Seed ) % ( maxRedundancy + 3 ), fragNb ) : 0;
+        uint32_t sliceRows = 1 + HostTestRand( &Seed ) % 16;
+
+        nbLost = DrawSession( fragNb, fragSize, NB_CODED( maxRedundancy ), lossPerThousand, tailLost );
+        status = ReplayBoth( fragNb, fragSize, maxRedundancy, fragPVer, sliceRows );
+        CheckSession( status, fragNb, fragSize, maxRedundancy, nbLost );
+        if( status >= 0 )
+        {
+            nbRecovered += ( FragDecoderGetStatus( &Decoder ).MatrixError == 0 ) ? 1 : 0;
+            nbMatrixErrors += FragDecoderGetStatus( &Decoder ).MatrixError;
+        }
+    }
+    printf( "%u sessions, %u per thousand lost: %u decoded, %u matrix errors\n", nbSessions, lossPerThousand,
+            nbRecovered, nbMatrixErrors );
+    HOST_TEST_CHECK( nbRecovered > 0 );
+#if REFERENCE_ENABLED
+    printf( "Row cache %u, write block %u: %u reads, %u writes, without: %u reads, %u writes\n",
+            FRAG_DECODER_ROW_CACHE_SIZE, FRAG_DECODER_WRITE_BLOCK_SIZE, TotalReads, TotalWrites, RefTotalReads, RefTotalWrites );
+    HOST_TEST_CHECK( ( FRAG_DECODER_ROW_CACHE_SIZE == 0 ) || ( TotalReads < RefTotalReads ) );
+    HOST_TEST_CHECK( ( FRAG_DECODER_WRITE_BLOCK_SIZE == 0 ) || ( TotalWrites < RefTotalWrites ) );
+#endif /* REFERENCE_ENABLED */
+
+    /* Benchmarks */
+    nbLost = DrawSession( BENCH_NB, BENCH_SIZE, NB_CODED( FRAG_MAX_REDUNDANCY ), lossPerThousand, 0 );
+    for( uint32_t sliceRows = 0; sliceRows <= BENCH_SLICE_ROWS; sliceRows += BENCH_SLICE_ROWS )
+    {
+        longest = 0;
+        start = HostTestNow( );
+        status = Replay( BENCH_NB, BENCH_SIZE, FRAG_MAX_REDUNDANCY, 2, sliceRows, &longest );
+        elapsed = HostTestNow( ) - start;
+        CheckSession( status, BENCH_NB, BENCH_SIZE, FRAG_MAX_REDUNDANCY, nbLost );
+        printf( "%u x %u bytes, %u lost, %s: status %d, %.2f ms/session, longest call %.3f ms, %u reads, %u writes\n",
+                BENCH_NB, BENCH_SIZE, nbLost, ( sliceRows == 0 ) ? "synchronous" : "slices of 8 rows", ( int )status,
+                elapsed / 1e6, longest / 1e6, Reads, Writes );
+    }
+
+    return HOST_TEST_RESULT( );
+}
@@ -0,0 +1,87 @@
+/*!
+ * \file      host_test.h
+ *
+ * \brief     Helpers shared by the host tests of the LoRaWAN middleware
+ *
+ * \remark    Each host test is one program: it counts the failed checks and
+ *            returns HOST_TEST_RESULT( ) from main, 0 when every check passed.
+ */
+#ifndef __HOST_TEST_H__
+#define __HOST_TEST_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*!
+ * Number of failed checks of the test program, unused by the helper sources
+ * such as the flash simulator
+ */
+static uint32_t HostTestFailures __attribute__( ( unused ) ) = 0;
+
+/*!
+ * Checks a condition, reports the first failures
+ */
+#define HOST_TEST_CHECK( cond )                                                         \
+    do                                                                                  \
+    {                                                                                   \
+        if( !( cond ) )                                                                 \
+        {                                                                               \
+            if( HostTestFailures++ < 10 )                                               \
+            {                                                                           \
+                printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond );       \
+            }                                                                           \
+        }                                                                               \
+    } while( 0 )
+
+/*!
+ * Prints the verdict, value to return from main
+ */
+#define HOST_TEST_RESULT( )                                                             \
+    ( printf( "%s: %u failed checks\n", ( HostTestFailures == 0 ) ? "PASS" : "FAIL",    \
+              ( unsigned )HostTestFailures ), ( HostTestFailures == 0 ) ? 0 : 1 )
+
+/*!
+ * \brief   Monotonic wall clock for the benchmarks
+ *
+ * \retval  Time [ns]
+ */
+static inline double HostTestNow( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( double )ts.tv_sec * 1e9 + ( double )ts.tv_nsec;
+}
+
+/*!
+ * \brief   Reproducible xorshift32 random generator
+ *
+ * \param   [IN/OUT] state Generator state, must not be 0
+ * \retval  Next random value
+ */
+static inline uint32_t HostTestRand( uint32_t* state )
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/*!
+ * \brief   Run count of a test, from its first command line argument
+ *
+ * \param   [IN] argc, argv  Command line of the test
+ * \param   [IN] defaultRuns Run count when none is given
+ * \retval  Run count
+ */
+static inline uint32_t HostTestRuns( int argc, char** argv, uint32_t defaultRuns )
+{
+    return ( argc > 1 ) ? ( uint32_t )strtoul( argv[1], NULL, 0 ) : defaultRuns;
+}
+
+#endif // __HOST_TEST_H__
@@ -0,0 +1,192 @@
+/*!
+ * \file      kms_if.h
+ *
+ * \brief     Host mock of the Key Management Services PKCS #11 interface
+ *
+ * \remark    Declares the subset of the PKCS #11 types, constants and C_*
+ *            functions used by the secure element (soft-se.c) when it is built
+ *            with LORAWAN_KMS == 1. The functions are implemented by
+ *            kms_mock.c on top of the software AES and CMAC of the middleware:
+ *            they follow the PKCS #11 rules on the active operations of a
+ *            session and count their calls, see KmsMockCalls.
+ */
+#ifndef __KMS_IF_H__
+#define __KMS_IF_H__
+
+#include <stdint.h>
+
+/*!
+ * PKCS #11 types, CK_ULONG is 32-bit as on the target
+ */
+typedef uint32_t CK_ULONG;
+typedef CK_ULONG *CK_ULONG_PTR;
+typedef CK_ULONG CK_RV;
+typedef CK_ULONG CK_FLAGS;
+typedef CK_ULONG CK_SLOT_ID;
+typedef CK_ULONG CK_SESSION_HANDLE;
+typedef CK_ULONG CK_OBJECT_HANDLE;
+typedef CK_ULONG CK_MECHANISM_TYPE;
+typedef CK_ULONG CK_ATTRIBUTE_TYPE;
+typedef CK_ULONG CK_NOTIFICATION;
+typedef unsigned char CK_BYTE;
+typedef CK_BYTE *CK_BYTE_PTR;
+typedef CK_BYTE CK_BBOOL;
+typedef void *CK_VOID_PTR;
+typedef CK_SESSION_HANDLE *CK_SESSION_HANDLE_PTR;
+typedef CK_OBJECT_HANDLE *CK_OBJECT_HANDLE_PTR;
+typedef CK_RV ( *CK_NOTIFY )( CK_SESSION_HANDLE hSession, CK_NOTIFICATION event, CK_VOID_PTR pApplication );
+
+typedef struct
+{
+    CK_MECHANISM_TYPE mechanism;
+    CK_VOID_PTR pParameter;
+    CK_ULONG ulParameterLen;
+} CK_MECHANISM;
+typedef CK_MECHANISM *CK_MECHANISM_PTR;
+
+typedef struct
+{
+    CK_ATTRIBUTE_TYPE type;
+    CK_VOID_PTR pValue;
+    CK_ULONG ulValueLen;
+} CK_ATTRIBUTE;
+typedef CK_ATTRIBUTE *CK_ATTRIBUTE_PTR;
+
+/*!
+ * PKCS #11 constants
+ */
+#define CK_TRUE                                     1U
+#define CK_FALSE                                    0U
+
+#define CKR_OK                                      0x000UL
+#define CKR_GENERAL_ERROR                           0x005UL
+#define CKR_ARGUMENTS_BAD                           0x007UL
+#define CKR_DATA_LEN_RANGE                          0x021UL
+#define CKR_KEY_HANDLE_INVALID                      0x060UL
+#define CKR_OBJECT_HANDLE_INVALID                   0x082UL
+#define CKR_OPERATION_ACTIVE                        0x090UL
+#define CKR_OPERATION_NOT_INITIALIZED               0x091UL
+#define CKR_SESSION_COUNT                           0x0B1UL
+#define CKR_SESSION_HANDLE_INVALID                  0x0B3UL
+#define CKR_SIGNATURE_INVALID                       0x0C0UL
+#define CKR_BUFFER_TOO_SMALL                        0x150UL
+
+#define CKF_SERIAL_SESSION                          0x004UL
+
+#define CKA_CLASS                                   0x000UL
+#define CKA_LABEL                                   0x003UL
+#define CKA_VALUE                                   0x011UL
+#define CKA_KEY_TYPE                                0x100UL
+#define CKA_EXTRACTABLE                             0x162UL
+
+#define CKO_SECRET_KEY                              0x004UL
+#define CKK_AES                                     0x01FUL
+
+#define CKM_AES_ECB                                 0x1081UL
+#define CKM_AES_CMAC                                0x108AUL
+#define CKM_AES_ECB_ENCRYPT_DATA                    0x1104UL
+
+/*!
+ * Embedded key objects provisioned in the mock, their values are KmsMockEmbeddedKeys
+ */
+#define KMS_APP_KEY_OBJECT_HANDLE                   1UL
+#define KMS_NWK_KEY_OBJECT_HANDLE                   2UL
+#define KMS_DEVJOINEUIADDR_KEY_OBJECT_HANDLE        3UL
+#define KMS_NWK_S_KEY_OBJECT_HANDLE                 4UL
+#define KMS_APP_S_KEY_OBJECT_HANDLE                 5UL
+#define KMS_ZERO_KEY_OBJECT_HANDLE                  6UL
+
+/*!
+ * Number of embedded key objects
+ */
+#define KMS_MOCK_NB_EMBEDDED_KEYS                   6
+
+/*!
+ * C_* functions counted by the mock, index of KmsMockCalls
+ */
+typedef enum eKmsMockCall
+{
+    KMS_MOCK_OPEN_SESSION,
+    KMS_MOCK_CLOSE_SESSION,
+    KMS_MOCK_ENCRYPT_INIT,
+    KMS_MOCK_ENCRYPT_UPDATE,
+    KMS_MOCK_ENCRYPT_FINAL,
+    KMS_MOCK_SIGN_INIT,
+    KMS_MOCK_SIGN,
+    KMS_MOCK_SIGN_UPDATE,
+    KMS_MOCK_SIGN_FINAL,
+    KMS_MOCK_VERIFY_INIT,
+    KMS_MOCK_VERIFY,
+    KMS_MOCK_FIND_OBJECTS_INIT,
+    KMS_MOCK_FIND_OBJECTS,
+    KMS_MOCK_FIND_OBJECTS_FINAL,
+    KMS_MOCK_CREATE_OBJECT,
+    KMS_MOCK_DESTROY_OBJECT,
+    KMS_MOCK_GET_ATTRIBUTE_VALUE,
+    KMS_MOCK_DERIVE_KEY,
+    KMS_MOCK_NB_CALLS
+}KmsMockCall_t;
+
+/*!
+ * Number of calls of each C_* function since the last KmsMockReset
+ */
+extern uint32_t KmsMockCalls[KMS_MOCK_NB_CALLS];
+
+/*!
+ * Values of the embedded key objects, KMS_APP_KEY_OBJECT_HANDLE first
+ */
+extern const uint8_t KmsMockEmbeddedKeys[KMS_MOCK_NB_EMBEDDED_KEYS][16];
+
+/*!
+ * \brief   Closes all the sessions, destroys the created objects and clears the counters
+ */
+void KmsMockReset( void );
+
+/*!
+ * \brief   Clears the call counters
+ */
+void KmsMockClearCalls( void );
+
+/*!
+ * \brief   Makes the next call of a C_* function fail with CKR_GENERAL_ERROR
+ *
+ * \remark  A failed C_*Update or C_*Final terminates the active operation of
+ *          the session, as required by PKCS #11
+ *
+ * \param   [IN] call Function to fail
+ */
+void KmsMockInjectFailure( KmsMockCall_t call );
+
+/*!
+ * \brief   Number of opened sessions
+ */
+uint32_t KmsMockOpenSessions( void );
+
+CK_RV C_OpenSession( CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY Notify,
+                     CK_SESSION_HANDLE_PTR phSession );
+CK_RV C_CloseSession( CK_SESSION_HANDLE hSession );
+CK_RV C_EncryptInit( CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey );
+CK_RV C_EncryptUpdate( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen,
+                       CK_BYTE_PTR pEncryptedPart, CK_ULONG_PTR pulEncryptedPartLen );
+CK_RV C_EncryptFinal( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pLastEncryptedPart, CK_ULONG_PTR pulLastEncryptedPartLen );
+CK_RV C_SignInit( CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey );
+CK_RV C_Sign( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pSignature,
+              CK_ULONG_PTR pulSignatureLen );
+CK_RV C_SignUpdate( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen );
+CK_RV C_SignFinal( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULONG_PTR pulSignatureLen );
+CK_RV C_VerifyInit( CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey );
+CK_RV C_Verify( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pSignature,
+                CK_ULONG ulSignatureLen );
+CK_RV C_FindObjectsInit( CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount );
+CK_RV C_FindObjects( CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE_PTR phObject, CK_ULONG ulMaxObjectCount,
+                     CK_ULONG_PTR pulObjectCount );
+CK_RV C_FindObjectsFinal( CK_SESSION_HANDLE hSession );
+CK_RV C_CreateObject( CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount,
+                      CK_OBJECT_HANDLE_PTR phObject );
+CK_RV C_DestroyObject( CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject );
+CK_RV C_GetAttributeValue( CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate,
+                           CK_ULONG ulCount );
+CK_RV C_DeriveKey( CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hBaseKey,
+                   CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulAttributeCount, CK_OBJECT_HANDLE_PTR phKey );
+
+#endif // __KMS_IF_H__
@@ -0,0 +1,667 @@
+/*!
+ * \file      kms_mock.c
+ *
+ * \brief     Host mock of the Key Management Services PKCS #11 interface
+ *
+ * \remark    The key objects and the sessions live in RAM. AES ECB and AES
+ *            CMAC are computed with lorawan_aes.c and cmac.c. Like a PKCS #11
+ *            token the mock refuses to start an operation in a session that
+ *            already runs one, and to use an operation that was not started,
+ *            so that a leaked or a missing C_*Init is reported as an error.
+ */
+#include <stdbool.h>
+#include <string.h>
+#include "kms_if.h"
+#include "lorawan_aes.h"
+#include "cmac.h"
+
+/*!
+ * Maximum number of key objects, embedded ones included
+ */
+#define KMS_MOCK_NB_OBJECTS                         48
+
+/*!
+ * Maximum number of sessions opened at the same time
+ */
+#define KMS_MOCK_NB_SESSIONS                        4
+
+/*!
+ * Maximum size of an object value and of an object label
+ */
+#define KMS_MOCK_VALUE_SIZE                         32
+#define KMS_MOCK_LABEL_SIZE                         8
+
+/*!
+ * Operation active in a session
+ */
+typedef enum eKmsMockOperation
+{
+    KMS_MOCK_OP_NONE,
+    KMS_MOCK_OP_ENCRYPT,
+    KMS_MOCK_OP_SIGN,
+    KMS_MOCK_OP_VERIFY,
+    KMS_MOCK_OP_FIND,
+}KmsMockOperation_t;
+
+typedef struct sKmsMockObject
+{
+    bool Used;
+    uint8_t Value[KMS_MOCK_VALUE_SIZE];
+    uint8_t Label[KMS_MOCK_LABEL_SIZE];
+    CK_ULONG LabelSize;
+}KmsMockObject_t;
+
+typedef struct sKmsMockSession
+{
+    bool Opened;
+    KmsMockOperation_t Operation;
+    CK_OBJECT_HANDLE Key;
+    lorawan_aes_context Aes;
+    AES_CMAC_CTX Cmac;
+    /*!
+     * Label searched by the find operation and next object to check
+     */
+    uint8_t FindLabel[KMS_MOCK_LABEL_SIZE];
+    CK_ULONG FindLabelSize;
+    CK_OBJECT_HANDLE FindNext;
+}KmsMockSession_t;
+
+uint32_t KmsMockCalls[KMS_MOCK_NB_CALLS];
+
+const uint8_t KmsMockEmbeddedKeys[KMS_MOCK_NB_EMBEDDED_KEYS][16] =
+{
+    { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C },
+    { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C },
+    { 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    { 0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A },
+    { 0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51 },
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+};
+
+/*!
+ * Key objects, indexed by their handle, handle 0 is not used
+ */
+static KmsMockObject_t Objects[KMS_MOCK_NB_OBJECTS];
+
+/*!
+ * Sessions, indexed by their handle minus 1
+ */
+static KmsMockSession_t Sessions[KMS_MOCK_NB_SESSIONS];
+
+/*!
+ * Set for each C_* function whose next call shall fail
+ */
+static bool FailNext[KMS_MOCK_NB_CALLS];
+
+/*!
+ * \brief   Counts a call and consumes an injected failure
+ *
+ * \retval  true when the call shall fail
+ */
+static bool Enter( KmsMockCall_t call )
+{
+    bool fail = FailNext[call];
+
+    KmsMockCalls[call]++;
+    FailNext[call] = false;
+    return fail;
+}
+
+static KmsMockSession_t* GetSession( CK_SESSION_HANDLE hSession )
+{
+    if( ( hSession == 0 ) || ( hSession > KMS_MOCK_NB_SESSIONS ) || ( Sessions[hSession - 1].Opened == false ) )
+    {
+        return NULL;
+    }
+    return &Sessions[hSession - 1];
+}
+
+static KmsMockObject_t* GetObject( CK_OBJECT_HANDLE hObject )
+{
+    if( ( hObject == 0 ) || ( hObject >= KMS_MOCK_NB_OBJECTS ) || ( Objects[hObject].Used == false ) )
+    {
+        return NULL;
+    }
+    return &Objects[hObject];
+}
+
+static CK_ATTRIBUTE_PTR FindAttribute( CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, CK_ATTRIBUTE_TYPE type )
+{
+    for( CK_ULONG i = 0; i < ulCount; i++ )
+    {
+        if( pTemplate[i].type == type )
+        {
+            return &pTemplate[i];
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * \brief   Creates a key object
+ *
+ * \param   [IN] value     Key value, 16 bytes
+ * \param   [IN] label     CKA_LABEL attribute of the object, may be NULL
+ * \param   [OUT] phObject Handle of the object
+ */
+static CK_RV NewObject( const uint8_t* value, CK_ATTRIBUTE_PTR label, CK_OBJECT_HANDLE_PTR phObject )
+{
+    if( ( label != NULL ) && ( label->ulValueLen > KMS_MOCK_LABEL_SIZE ) )
+    {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    for( CK_OBJECT_HANDLE h = KMS_MOCK_NB_EMBEDDED_KEYS + 1; h < KMS_MOCK_NB_OBJECTS; h++ )
+    {
+        if( Objects[h].Used == false )
+        {
+            memset( &Objects[h], 0, sizeof( KmsMockObject_t ) );
+            Objects[h].Used = true;
+            memcpy( Objects[h].Value, value, 16 );
+            if( label != NULL )
+            {
+                memcpy( Objects[h].Label, label->pValue, label->ulValueLen );
+                Objects[h].LabelSize = label->ulValueLen;
+            }
+            *phObject = h;
+            return CKR_OK;
+        }
+    }
+    return CKR_GENERAL_ERROR;
+}
+
+/*!
+ * \brief   Starts an AES operation of a session
+ */
+static CK_RV OperationInit( CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey,
+                            KmsMockOperation_t operation, CK_MECHANISM_TYPE mechanism )
+{
+    KmsMockSession_t* session = GetSession( hSession );
+    KmsMockObject_t* key = GetObject( hKey );
+
+    if( session == NULL )
+    {
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    if( session->Operation != KMS_MOCK_OP_NONE )
+    {
+        return CKR_OPERATION_ACTIVE;
+    }
+    if( key == NULL )
+    {
+        return CKR_KEY_HANDLE_INVALID;
+    }
+    if( ( pMechanism == NULL ) || ( pMechanism->mechanism != mechanism ) )
+    {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    if( operation == KMS_MOCK_OP_ENCRYPT )
+    {
+        lorawan_aes_set_key( key->Value, 16, &session->Aes );
+    }
+    else
+    {
+        AES_CMAC_Init( &session->Cmac );
+        AES_CMAC_SetKey( &session->Cmac, key->Value );
+    }
+    session->Key = hKey;
+    session->Operation = operation;
+    return CKR_OK;
+}
+
+/*!
+ * \brief   Gets the session running an operation, terminates the operation on failure
+ */
+static KmsMockSession_t* GetOperation( CK_SESSION_HANDLE hSession, KmsMockOperation_t operation, bool fail,
+                                       CK_RV* rv )
+{
+    KmsMockSession_t* session = GetSession( hSession );
+
+    if( session == NULL )
+    {
+        *rv = CKR_SESSION_HANDLE_INVALID;
+        return NULL;
+    }
+    if( session->Operation != operation )
+    {
+        *rv = CKR_OPERATION_NOT_INITIALIZED;
+        return NULL;
+    }
+    if( ( fail == true ) || ( GetObject( session->Key ) == NULL ) )
+    {
+        session->Operation = KMS_MOCK_OP_NONE;
+        *rv = ( fail == true ) ? CKR_GENERAL_ERROR : CKR_KEY_HANDLE_INVALID;
+        return NULL;
+    }
+    *rv = CKR_OK;
+    return session;
+}
+
+void KmsMockReset( void )
+{
+    memset( Objects, 0, sizeof( Objects ) );
+    memset( Sessions, 0, sizeof( Sessions ) );
+    memset( FailNext, 0, sizeof( FailNext ) );
+    for( CK_OBJECT_HANDLE h = 1; h <= KMS_MOCK_NB_EMBEDDED_KEYS; h++ )
+    {
+        Objects[h].Used = true;
+        memcpy( Objects[h].Value, KmsMockEmbeddedKeys[h - 1], 16 );
+    }
+    KmsMockClearCalls( );
+}
+
+void KmsMockClearCalls( void )
+{
+    memset( KmsMockCalls, 0, sizeof( KmsMockCalls ) );
+}
+
+void KmsMockInjectFailure( KmsMockCall_t call )
+{
+    FailNext[call] = true;
+}
+
+uint32_t KmsMockOpenSessions( void )
+{
+    uint32_t nb = 0;
+
+    for( uint32_t i = 0; i < KMS_MOCK_NB_SESSIONS; i++ )
+    {
+        nb += ( Sessions[i].Opened == true ) ? 1 : 0;
+    }
+    return nb;
+}
+
+CK_RV C_OpenSession( CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY Notify,
+                     CK_SESSION_HANDLE_PTR phSession )
+{
+    if( Enter( KMS_MOCK_OPEN_SESSION ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    if( phSession == NULL )
+    {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    for( CK_SESSION_HANDLE i = 0; i < KMS_MOCK_NB_SESSIONS; i++ )
+    {
+        if( Sessions[i].Opened == false )
+        {
+            memset( &Sessions[i], 0, sizeof( KmsMockSession_t ) );
+            Sessions[i].Opened = true;
+            *phSession = i + 1;
+            return CKR_OK;
+        }
+    }
+    return CKR_SESSION_COUNT;
+}
+
+CK_RV C_CloseSession( CK_SESSION_HANDLE hSession )
+{
+    KmsMockSession_t* session = GetSession( hSession );
+
+    if( Enter( KMS_MOCK_CLOSE_SESSION ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    if( session == NULL )
+    {
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    session->Opened = false;
+    session->Operation = KMS_MOCK_OP_NONE;
+    return CKR_OK;
+}
+
+CK_RV C_EncryptInit( CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey )
+{
+    if( Enter( KMS_MOCK_ENCRYPT_INIT ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    return OperationInit( hSession, pMechanism, hKey, KMS_MOCK_OP_ENCRYPT, CKM_AES_ECB );
+}
+
+CK_RV C_EncryptUpdate( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen,
+                       CK_BYTE_PTR pEncryptedPart, CK_ULONG_PTR pulEncryptedPartLen )
+{
+    CK_RV rv;
+    KmsMockSession_t* session = GetOperation( hSession, KMS_MOCK_OP_ENCRYPT, Enter( KMS_MOCK_ENCRYPT_UPDATE ), &rv );
+
+    if( session == NULL )
+    {
+        return rv;
+    }
+    if( ( ulPartLen % 16 ) != 0 )
+    {
+        session->Operation = KMS_MOCK_OP_NONE;
+        return CKR_DATA_LEN_RANGE;
+    }
+    if( *pulEncryptedPartLen < ulPartLen )
+    {
+        return CKR_BUFFER_TOO_SMALL;
+    }
+
+    for( CK_ULONG i = 0; i < ulPartLen; i += 16 )
+    {
+        lorawan_aes_encrypt( &pPart[i], &pEncryptedPart[i], &session->Aes );
+    }
+    *pulEncryptedPartLen = ulPartLen;
+    return CKR_OK;
+}
+
+CK_RV C_EncryptFinal( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pLastEncryptedPart, CK_ULONG_PTR pulLastEncryptedPartLen )
+{
+    CK_RV rv;
+    KmsMockSession_t* session = GetSession( hSession );
+
+    if( Enter( KMS_MOCK_ENCRYPT_FINAL ) == true )
+    {
+        rv = CKR_GENERAL_ERROR;
+    }
+    else if( session == NULL )
+    {
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    else if( session->Operation != KMS_MOCK_OP_ENCRYPT )
+    {
+        return CKR_OPERATION_NOT_INITIALIZED;
+    }
+    else
+    {
+        *pulLastEncryptedPartLen = 0;
+        rv = CKR_OK;
+    }
+
+    if( session != NULL )
+    {
+        session->Operation = KMS_MOCK_OP_NONE;
+    }
+    return rv;
+}
+
+CK_RV C_SignInit( CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey )
+{
+    if( Enter( KMS_MOCK_SIGN_INIT ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    return OperationInit( hSession, pMechanism, hKey, KMS_MOCK_OP_SIGN, CKM_AES_CMAC );
+}
+
+CK_RV C_SignUpdate( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen )
+{
+    CK_RV rv;
+    KmsMockSession_t* session = GetOperation( hSession, KMS_MOCK_OP_SIGN, Enter( KMS_MOCK_SIGN_UPDATE ), &rv );
+
+    if( session != NULL )
+    {
+        AES_CMAC_Update( &session->Cmac, pPart, ulPartLen );
+    }
+    return rv;
+}
+
+CK_RV C_SignFinal( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULONG_PTR pulSignatureLen )
+{
+    CK_RV rv;
+    KmsMockSession_t* session = GetOperation( hSession, KMS_MOCK_OP_SIGN, Enter( KMS_MOCK_SIGN_FINAL ), &rv );
+
+    if( session == NULL )
+    {
+        return rv;
+    }
+    if( *pulSignatureLen < 16 )
+    {
+        return CKR_BUFFER_TOO_SMALL;
+    }
+
+    AES_CMAC_Final( pSignature, &session->Cmac );
+    *pulSignatureLen = 16;
+    session->Operation = KMS_MOCK_OP_NONE;
+    return CKR_OK;
+}
+
+CK_RV C_Sign( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pSignature,
+              CK_ULONG_PTR pulSignatureLen )
+{
+    CK_RV rv;
+    KmsMockSession_t* session = GetOperation( hSession, KMS_MOCK_OP_SIGN, Enter( KMS_MOCK_SIGN ), &rv );
+
+    if( session == NULL )
+    {
+        return rv;
+    }
+    if( *pulSignatureLen < 16 )
+    {
+        return CKR_BUFFER_TOO_SMALL;
+    }
+
+    AES_CMAC_Update( &session->Cmac, pData, ulDataLen );
+    AES_CMAC_Final( pSignature, &session->Cmac );
+    *pulSignatureLen = 16;
+    session->Operation = KMS_MOCK_OP_NONE;
+    return CKR_OK;
+}
+
+CK_RV C_VerifyInit( CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey )
+{
+    if( Enter( KMS_MOCK_VERIFY_INIT ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    return OperationInit( hSession, pMechanism, hKey, KMS_MOCK_OP_VERIFY, CKM_AES_CMAC );
+}
+
+CK_RV C_Verify( CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pSignature,
+                CK_ULONG ulSignatureLen )
+{
+    CK_RV rv;
+    KmsMockSession_t* session = GetOperation( hSession, KMS_MOCK_OP_VERIFY, Enter( KMS_MOCK_VERIFY ), &rv );
+    uint8_t signature[16];
+
+    if( session == NULL )
+    {
+        return rv;
+    }
+
+    AES_CMAC_Update( &session->Cmac, pData, ulDataLen );
+    AES_CMAC_Final( signature, &session->Cmac );
+    session->Operation = KMS_MOCK_OP_NONE;
+
+    if( ( ulSignatureLen > 16 ) || ( memcmp( signature, pSignature, ulSignatureLen ) != 0 ) )
+    {
+        return CKR_SIGNATURE_INVALID;
+    }
+    return CKR_OK;
+}
+
+CK_RV C_FindObjectsInit( CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount )
+{
+    KmsMockSession_t* session = GetSession( hSession );
+    CK_ATTRIBUTE_PTR label = FindAttribute( pTemplate, ulCount, CKA_LABEL );
+
+    if( Enter( KMS_MOCK_FIND_OBJECTS_INIT ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    if( session == NULL )
+    {
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    if( session->Operation != KMS_MOCK_OP_NONE )
+    {
+        return CKR_OPERATION_ACTIVE;
+    }
+    if( ( label == NULL ) || ( label->ulValueLen > KMS_MOCK_LABEL_SIZE ) )
+    {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    memcpy( session->FindLabel, label->pValue, label->ulValueLen );
+    session->FindLabelSize = label->ulValueLen;
+    session->FindNext = 1;
+    session->Operation = KMS_MOCK_OP_FIND;
+    return CKR_OK;
+}
+
+CK_RV C_FindObjects( CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE_PTR phObject, CK_ULONG ulMaxObjectCount,
+                     CK_ULONG_PTR pulObjectCount )
+{
+    CK_RV rv;
+    KmsMockSession_t* session;
+
+    if( Enter( KMS_MOCK_FIND_OBJECTS ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    session = GetSession( hSession );
+    if( session == NULL )
+    {
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    rv = ( session->Operation == KMS_MOCK_OP_FIND ) ? CKR_OK : CKR_OPERATION_NOT_INITIALIZED;
+
+    *pulObjectCount = 0;
+    while( ( rv == CKR_OK ) && ( *pulObjectCount < ulMaxObjectCount ) && ( session->FindNext < KMS_MOCK_NB_OBJECTS ) )
+    {
+        KmsMockObject_t* object = &Objects[session->FindNext];
+
+        if( ( object->Used == true ) && ( object->LabelSize == session->FindLabelSize ) &&
+            ( memcmp( object->Label, session->FindLabel, session->FindLabelSize ) == 0 ) )
+        {
+            phObject[( *pulObjectCount )++] = session->FindNext;
+        }
+        session->FindNext++;
+    }
+    return rv;
+}
+
+CK_RV C_FindObjectsFinal( CK_SESSION_HANDLE hSession )
+{
+    KmsMockSession_t* session = GetSession( hSession );
+
+    if( Enter( KMS_MOCK_FIND_OBJECTS_FINAL ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    if( session == NULL )
+    {
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    if( session->Operation != KMS_MOCK_OP_FIND )
+    {
+        return CKR_OPERATION_NOT_INITIALIZED;
+    }
+    session->Operation = KMS_MOCK_OP_NONE;
+    return CKR_OK;
+}
+
+CK_RV C_CreateObject( CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount,
+                      CK_OBJECT_HANDLE_PTR phObject )
+{
+    CK_ATTRIBUTE_PTR value = FindAttribute( pTemplate, ulCount, CKA_VALUE );
+    uint8_t key[16];
+
+    if( Enter( KMS_MOCK_CREATE_OBJECT ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    if( GetSession( hSession ) == NULL )
+    {
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    if( ( value == NULL ) || ( value->ulValueLen != sizeof( key ) ) )
+    {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    /* The value is given as big endian 32-bit words */
+    for( uint32_t i = 0; i < 4; i++ )
+    {
+        uint32_t word = ( ( uint32_t* )value->pValue )[i];
+
+        key[4 * i] = ( uint8_t )( word >> 24 );
+        key[4 * i + 1] = ( uint8_t )( word >> 16 );
+        key[4 * i + 2] = ( uint8_t )( word >> 8 );
+        key[4 * i + 3] = ( uint8_t )word;
+    }
+    return NewObject( key, FindAttribute( pTemplate, ulCount, CKA_LABEL ), phObject );
+}
+
+CK_RV C_DestroyObject( CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject )
+{
+    if( Enter( KMS_MOCK_DESTROY_OBJECT ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    if( GetSession( hSession ) == NULL )
+    {
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    if( ( hObject <= KMS_MOCK_NB_EMBEDDED_KEYS ) || ( GetObject( hObject ) == NULL ) )
+    {
+        return CKR_OBJECT_HANDLE_INVALID;
+    }
+    Objects[hObject].Used = false;
+    return CKR_OK;
+}
+
+CK_RV C_GetAttributeValue( CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate,
+                           CK_ULONG ulCount )
+{
+    KmsMockObject_t* object = GetObject( hObject );
+
+    if( Enter( KMS_MOCK_GET_ATTRIBUTE_VALUE ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    if( GetSession( hSession ) == NULL )
+    {
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    if( object == NULL )
+    {
+        return CKR_OBJECT_HANDLE_INVALID;
+    }
+
+    for( CK_ULONG i = 0; i < ulCount; i++ )
+    {
+        if( ( pTemplate[i].type != CKA_VALUE ) || ( pTemplate[i].ulValueLen > KMS_MOCK_VALUE_SIZE ) )
+        {
+            return CKR_ARGUMENTS_BAD;
+        }
+        memcpy( pTemplate[i].pValue, object->Value, pTemplate[i].ulValueLen );
+    }
+    return CKR_OK;
+}
+
+CK_RV C_DeriveKey( CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hBaseKey,
+                   CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulAttributeCount, CK_OBJECT_HANDLE_PTR phKey )
+{
+    KmsMockObject_t* base = GetObject( hBaseKey );
+    lorawan_aes_context aes;
+    uint8_t key[16];
+
+    if( Enter( KMS_MOCK_DERIVE_KEY ) == true )
+    {
+        return CKR_GENERAL_ERROR;
+    }
+    if( GetSession( hSession ) == NULL )
+    {
+        return CKR_SESSION_HANDLE_INVALID;
+    }
+    if( base == NULL )
+    {
+        return CKR_KEY_HANDLE_INVALID;
+    }
+    if( ( pMechanism == NULL ) || ( pMechanism->mechanism != CKM_AES_ECB_ENCRYPT_DATA ) ||
+        ( pMechanism->ulParameterLen != sizeof( key ) ) )
+    {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    lorawan_aes_set_key( base->Value, 16, &aes );
+    lorawan_aes_encrypt( pMechanism->pParameter, key, &aes );
+    return NewObject( key, FindAttribute( pTemplate, ulAttributeCount, CKA_LABEL ), phKey );
+}
@@ -0,0 +1,698 @@
+/*!
+ * \file      lmhp_fragmentation_mic_test.c
+ *
+ * \brief     Test of the data block MIC of the fragmentation package, computed
+ *            along the reception of the FUOTA sessions
+ *
+ * \remark    Plays the server of random sessions to LmhpFragmentation.c, on
+ *            the secure element in software and the time server on the
+ *            virtual time: FragSessionSetupReq with AckReception, uncoded
+ *            fragments lost, duplicated or received out of order, then coded
+ *            fragments until the file is decoded, and a last fragment padded
+ *            with random bytes which are not part of the file. The package
+ *            shall write the file and answer FragDataBlockReceivedReq with the
+ *            MIC status: a MIC computed by the test on the file shall be
+ *            accepted, a corrupted MIC rejected. A session without loss shall
+ *            not read the file back.
+ *
+ *            Then a session whose file cannot be read back, a session deleted
+ *            and a session set up again before their end, and two sessions
+ *            decoded concurrently. SecureElementAesCmacStreamStart and
+ *            SecureElementAesCmacStreamFinish are wrapped at link time: each
+ *            MIC started shall be finished or dropped.
+ *
+ *            Usage: lmhp_fragmentation_mic_test [sessions]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "radio.h"
+#include "utilities.h"
+#include "stm32_timer.h"
+#include "stm32_timer_if_sim.h"
+#include "cmac.h"
+#include "secure-element.h"
+#include "secure-element-nvm.h"
+#include "LoRaMacCrypto.h"
+#include "LmHandler.h"
+#include "LmhpFragmentation.h"
+#include "frag_decoder_if.h"
+
+/*!
+ * Port and commands of the fragmentation package
+ */
+#define FRAGMENTATION_PORT                          201
+#define FRAG_SESSION_SETUP_REQ                      0x02
+#define FRAG_SESSION_DELETE_REQ                     0x03
+#define FRAG_DATA_BLOCK_RECEIVED_ANS                0x04
+#define FRAG_DATA_FRAGMENT                          0x08
+
+/*!
+ * Answers of the package
+ */
+#define FRAG_SESSION_SETUP_ANS                      0x02
+#define FRAG_SESSION_DELETE_ANS                     0x03
+#define FRAG_DATA_BLOCK_RECEIVED_REQ                0x04
+#define FRAG_DATA_BLOCK_MIC_ERROR                   0x04
+
+/*!
+ * AckReception bit of the Control field of FragSessionSetupReq
+ */
+#define FRAG_CONTROL_ACK_RECEPTION                  0x40
+
+/*!
+ * Largest file of the random sessions
+ */
+#define TEST_MAX_NB                                 150
+#define TEST_MAX_SIZE                               100
+
+/*!
+ * Flash region and decoder storage of the session decoded concurrently
+ */
+#define TEST_OWN_INDEX                              1
+#define TEST_OWN_REDUNDANCY                         40
+
+/*!
+ * Timer events run before an answer is expected
+ */
+#define TEST_MAX_EVENTS                             20
+
+static uint32_t Seed = 0x46554F54;
+
+static uint32_t TestRandom( void )
+{
+    return HostTestRand( &Seed );
+}
+
+/*!
+ * The secure element only uses the random generator of the radio
+ */
+const struct Radio_s Radio =
+{
+    .Random = TestRandom,
+};
+
+static SecureElementNvmData_t SeNvm;
+
+static const uint8_t DataBlockIntKey[16] =
+{
+    0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+};
+
+/*!
+ * File of a session, as sent by the server, padding of the last fragment included
+ */
+typedef struct
+{
+    uint8_t Index;
+    uint16_t FragNb;
+    uint8_t FragSize;
+    uint8_t Padding;
+    uint16_t SessionCnt;
+    uint32_t Descriptor;
+    uint32_t Mic;
+    uint8_t Data[TEST_MAX_NB * TEST_MAX_SIZE];
+    uint8_t Flash[TEST_MAX_NB * TEST_MAX_SIZE];
+    uint32_t FlashSize;
+    uint32_t Reads;
+    bool Done;
+}File_t;
+
+static File_t Files[2];
+
+/*!
+ * Reads of the files fail once they are decoded
+ */
+static bool FailReads = false;
+
+/*!
+ * MICs started and not finished
+ */
+static int32_t OpenStreams = 0;
+
+/*!
+ * Package under test, its answer buffer, its answers sent
+ */
+static LmhPackage_t *Package;
+static uint8_t DataBuffer[242];
+static uint8_t Answer[242];
+static uint8_t AnswerSize;
+static uint32_t Answers = 0;
+static bool ProcessPending = false;
+
+/*!
+ * Last session counter used, the package rejects a replayed one
+ */
+static uint16_t SessionCnt = 0;
+
+SecureElementStatus_t __real_SecureElementAesCmacStreamStart( CmacStreamCtx_t* ctx, uint8_t* micBxBuffer, KeyIdentifier_t keyID );
+SecureElementStatus_t __real_SecureElementAesCmacStreamFinish( CmacStreamCtx_t* ctx, uint32_t* cmac );
+
+SecureElementStatus_t __wrap_SecureElementAesCmacStreamStart( CmacStreamCtx_t* ctx, uint8_t* micBxBuffer, KeyIdentifier_t keyID )
+{
+    SecureElementStatus_t status = __real_SecureElementAesCmacStreamStart( ctx, micBxBuffer, keyID );
+
+    if( status == SECURE_ELEMENT_SUCCESS )
+    {
+        OpenStreams++;
+    }
+    return status;
+}
+
+SecureElementStatus_t __wrap_SecureElementAesCmacStreamFinish( CmacStreamCtx_t* ctx, uint32_t* cmac )
+{
+    OpenStreams--;
+    return __real_SecureElementAesCmacStreamFinish( ctx, cmac );
+}
+
+/*
+ * LoRaMac.c services used by the package
+ */
+LoRaMacStatus_t LoRaMacStartMicForDatablock( CmacStreamCtx_t *ctx, uint32_t size, uint16_t sessionCnt, uint8_t fragIndex, uint32_t descriptor )
+{
+    if( LoRaMacCryptoStartDataBlock( ctx, size, sessionCnt, fragIndex, descriptor ) != LORAMAC_CRYPTO_SUCCESS )
+    {
+        return LORAMAC_STATUS_CRYPTO_ERROR;
+    }
+    return LORAMAC_STATUS_OK;
+}
+
+LoRaMacStatus_t LoRaMacUpdateMicForDatablock( CmacStreamCtx_t *ctx, uint8_t *buffer, uint32_t size )
+{
+    if( LoRaMacCryptoUpdateDataBlock( ctx, buffer, size ) != LORAMAC_CRYPTO_SUCCESS )
+    {
+        return LORAMAC_STATUS_CRYPTO_ERROR;
+    }
+    return LORAMAC_STATUS_OK;
+}
+
+LoRaMacStatus_t LoRaMacFinishMicForDatablock( CmacStreamCtx_t *ctx, uint32_t *mic )
+{
+    if( LoRaMacCryptoFinishDataBlock( ctx, mic ) != LORAMAC_CRYPTO_SUCCESS )
+    {
+        return LORAMAC_STATUS_CRYPTO_ERROR;
+    }
+    return LORAMAC_STATUS_OK;
+}
+
+uint8_t LoRaMacMcChannelGetGroupId( uint32_t mcAddress )
+{
+    return 0xFF;
+}
+
+/*
+ * LmHandler.c services used by the package
+ */
+LmHandlerErrorStatus_t LmHandlerSend( LmHandlerAppData_t *appData, LmHandlerMsgTypes_t isTxConfirmed, bool allowDelayedTx )
+{
+    HOST_TEST_CHECK( appData->Port == FRAGMENTATION_PORT );
+    memcpy( Answer, appData->Buffer, appData->BufferSize );
+    AnswerSize = appData->BufferSize;
+    Answers++;
+    return LORAMAC_HANDLER_SUCCESS;
+}
+
+static void OnPackageProcessEvent( void )
+{
+    ProcessPending = true;
+}
+
+/*
+ * Flash regions of the sessions
+ */
+static int32_t FlashErase( File_t* file )
+{
+    memset( file->Flash, 0xFF, sizeof( file->Flash ) );
+    return 0;
+}
+
+static int32_t FlashWrite( File_t* file, uint32_t addr, uint8_t* data, uint32_t size )
+{
+    if( ( addr + size ) > file->FlashSize )
+    {
+        return -1;
+    }
+    memcpy( &file->Flash[addr], data, size );
+    return 0;
+}
+
+static int32_t FlashRead( File_t* file, uint32_t addr, uint8_t* data, uint32_t size )
+{
+    if( ( ( addr + size ) > file->FlashSize ) || ( ( FailReads == true ) && ( file->Done == true ) ) )
+    {
+        return -1;
+    }
+    file->Reads++;
+    memcpy( data, &file->Flash[addr], size );
+    return 0;
+}
+
+static int32_t SharedErase( void )
+{
+    return FlashErase( &Files[0] );
+}
+
+static int32_t SharedWrite( uint32_t addr, uint8_t* data, uint32_t size )
+{
+    return FlashWrite( &Files[0], addr, data, size );
+}
+
+static int32_t SharedRead( uint32_t addr, uint8_t* data, uint32_t size )
+{
+    return FlashRead( &Files[0], addr, data, size );
+}
+
+static int32_t OwnErase( void )
+{
+    return FlashErase( &Files[1] );
+}
+
+static int32_t OwnWrite( uint32_t addr, uint8_t* data, uint32_t size )
+{
+    return FlashWrite( &Files[1], addr, data, size );
+}
+
+static int32_t OwnRead( uint32_t addr, uint8_t* data, uint32_t size )
+{
+    return FlashRead( &Files[1], addr, data, size );
+}
+
+static void OnDone( File_t* file, int32_t status, uint32_t size )
+{
+    HOST_TEST_CHECK( status >= FRAG_SESSION_FINISHED );
+    HOST_TEST_CHECK( size == ( ( uint32_t )file->FragNb * file->FragSize ) - file->Padding );
+    file->Done = true;
+}
+
+static void SharedOnDone( int32_t status, uint32_t size, uint32_t *addr )
+{
+    OnDone( &Files[0], status, size );
+}
+
+static void OwnOnDone( int32_t status, uint32_t size, uint32_t *addr )
+{
+    OnDone( &Files[1], status, size );
+}
+
+static uint32_t OwnStorage[FRAG_DECODER_STORAGE_SIZE( TEST_MAX_NB, TEST_MAX_SIZE, TEST_OWN_REDUNDANCY ) / 4];
+
+static const LmhpFragmentationSessionParams_t OwnSessionParams =
+{
+    .DecoderCallbacks = { OwnErase, OwnWrite, OwnRead },
+    .RegionSize = TEST_MAX_NB * TEST_MAX_SIZE,
+    .DecoderStorage = OwnStorage,
+    .DecoderStorageSize = sizeof( OwnStorage ),
+    .OnDone = OwnOnDone,
+};
+
+static LmhpFragmentationParams_t Params =
+{
+    .DecoderCallbacks = { SharedErase, SharedWrite, SharedRead },
+    .OnDone = SharedOnDone,
+    .Sessions = { [TEST_OWN_INDEX] = &OwnSessionParams },
+};
+
+static void Prbs23( int32_t* value )
+{
+    int32_t b0 = *value & 1;
+    int32_t b1 = ( *value & 0x20 ) >> 5;
+
+    *value = ( *value >> 1 ) + ( ( b0 ^ b1 ) << 22 );
+}
+
+/*!
+ * \brief   Fragment fragCounter of a file: the rows of the file, then rows of
+ *          the parity matrix of the fragmentation package specification v2
+ */
+static void GetFragment( const File_t* file, uint16_t fragCounter, uint8_t* frag )
+{
+    static uint8_t row[TEST_MAX_NB];
+    int32_t m = file->FragNb;
+    int32_t mTemp = ( ( m & ( m - 1 ) ) == 0 ) ? 1 : 0;
+    int32_t x = 1 + ( 1001 * ( fragCounter - m ) );
+    int32_t nbCoeff = 0;
+    int32_t r;
+
+    if( fragCounter <= file->FragNb )
+    {
+        memcpy( frag, &file->Data[( fragCounter - 1 ) * file->FragSize], file->FragSize );
+        return;
+    }
+    memset( row, 0, m );
+    while( nbCoeff < ( m >> 1 ) )
+    {
+        r = 1 << 16;
+        while( r >= m )
+        {
+            Prbs23( &x );
+            r = x % ( m + mTemp );
+        }
+        if( row[r] == 0 )
+        {
+            row[r] = 1;
+            nbCoeff++;
+        }
+    }
+    memset( frag, 0, file->FragSize );
+    for( int32_t j = 0; j < m; j++ )
+    {
+        if( row[j] != 0 )
+        {
+            for( uint8_t k = 0; k < file->FragSize; k++ )
+            {
+                frag[k] ^= file->Data[j * file->FragSize + k];
+            }
+        }
+    }
+}
+
+/*!
+ * \brief   MIC of a file computed by the server, B0 block of LoRaMacCrypto.c
+ */
+static uint32_t ServerMic( const File_t* file )
+{
+    uint32_t size = ( ( uint32_t )file->FragNb * file->FragSize ) - file->Padding;
+    uint8_t b0[16] = { 0x49, file->SessionCnt & 0xFF, file->SessionCnt >> 8, file->Index };
+    AES_CMAC_CTX ctx;
+    uint8_t tag[16];
+
+    memcpy( &b0[4], &file->Descriptor, 4 );
+    memcpy( &b0[12], &size, 4 );
+    AES_CMAC_Init( &ctx );
+    AES_CMAC_SetKey( &ctx, DataBlockIntKey );
+    AES_CMAC_Update( &ctx, b0, 16 );
+    AES_CMAC_Update( &ctx, file->Data, size );
+    AES_CMAC_Final( tag, &ctx );
+    return ( uint32_t )tag[0] | ( ( uint32_t )tag[1] << 8 ) | ( ( uint32_t )tag[2] << 16 ) | ( ( uint32_t )tag[3] << 24 );
+}
+
+/*!
+ * \brief   Runs the package process requested by its events
+ */
+static void RunProcess( void )
+{
+    while( ProcessPending == true )
+    {
+        ProcessPending = false;
+        Package->Process( );
+    }
+}
+
+/*!
+ * \brief   Downlink on the port of the package
+ */
+static void Downlink( uint8_t* buffer, uint8_t size )
+{
+    McpsIndication_t indication;
+
+    memset( &indication, 0, sizeof( indication ) );
+    indication.Port = FRAGMENTATION_PORT;
+    indication.Buffer = buffer;
+    indication.BufferSize = size;
+    Package->OnMcpsIndicationProcess( &indication );
+    RunProcess( );
+}
+
+/*!
+ * \brief   Runs the timers until the package sends an answer
+ *
+ * \retval  true when an answer has been sent
+ */
+static bool WaitAnswer( void )
+{
+    uint32_t answers = Answers;
+
+    for( uint32_t i = 0; ( i < TEST_MAX_EVENTS ) && ( Answers == answers ); i++ )
+    {
+        if( TIMER_IF_SIM_RunNextEvent( ) == false )
+        {
+            break;
+        }
+        RunProcess( );
+    }
+    return Answers != answers;
+}
+
+/*!
+ * \brief   Draws the file of a session and sets it up with AckReception
+ *
+ * \param [in] corruptMic The MIC sent is not the MIC of the file
+ */
+static void SetupSession( File_t* file, uint8_t index, uint16_t fragNb, uint8_t fragSize, uint8_t padding, bool corruptMic )
+{
+    uint8_t req[] = { FRAG_SESSION_SETUP_REQ, ( index << 4 ) | 0x01, 0, 0, 0, FRAG_CONTROL_ACK_RECEPTION, 0,
+                      0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    file->Index = index;
+    file->FragNb = fragNb;
+    file->FragSize = fragSize;
+    file->Padding = padding;
+    file->SessionCnt = ++SessionCnt;
+    file->Descriptor = TestRandom( );
+    file->FlashSize = ( uint32_t )fragNb * fragSize;
+    file->Reads = 0;
+    file->Done = false;
+    // The padding of the last fragment is random too
+    for( uint32_t i = 0; i < file->FlashSize; i++ )
+    {
+        file->Data[i] = ( uint8_t )TestRandom( );
+    }
+    file->Mic = ServerMic( file ) ^ ( corruptMic ? ( 1U << ( TestRandom( ) % 32 ) ) : 0 );
+
+    req[2] = fragNb & 0xFF;
+    req[3] = fragNb >> 8;
+    req[4] = fragSize;
+    req[6] = padding;
+    memcpy( &req[7], &file->Descriptor, 4 );
+    req[11] = file->SessionCnt & 0xFF;
+    req[12] = file->SessionCnt >> 8;
+    memcpy( &req[13], &file->Mic, 4 );
+    Downlink( req, sizeof( req ) );
+
+    HOST_TEST_CHECK( WaitAnswer( ) == true );
+    HOST_TEST_CHECK( ( AnswerSize == 2 ) && ( Answer[0] == FRAG_SESSION_SETUP_ANS ) && ( Answer[1] == ( index << 6 ) ) );
+    HOST_TEST_CHECK( OpenStreams >= 1 );
+}
+
+/*!
+ * \brief   Sends the fragment fragCounter of a file
+ */
+static void SendFragment( const File_t* file, uint16_t fragCounter )
+{
+    uint8_t frame[3 + TEST_MAX_SIZE];
+
+    frame[0] = FRAG_DATA_FRAGMENT;
+    frame[1] = fragCounter & 0xFF;
+    frame[2] = ( ( fragCounter >> 8 ) & 0x3F ) | ( file->Index << 6 );
+    GetFragment( file, fragCounter, &frame[3] );
+    Downlink( frame, 3 + file->FragSize );
+}
+
+/*!
+ * \brief   Waits for the FragDataBlockReceivedReq of a decoded file and
+ *          acknowledges it
+ *
+ * \retval  MIC status of the answer, 0xFF without answer
+ */
+static uint8_t DataBlockReceived( const File_t* file )
+{
+    uint8_t ans[] = { FRAG_DATA_BLOCK_RECEIVED_ANS, file->Index };
+    uint8_t status = 0xFF;
+    uint32_t answers;
+
+    RunProcess( );
+    if( ( WaitAnswer( ) == true ) && ( AnswerSize == 2 ) && ( Answer[0] == FRAG_DATA_BLOCK_RECEIVED_REQ ) &&
+        ( ( Answer[1] & 0x03 ) == file->Index ) )
+    {
+        status = Answer[1] & FRAG_DATA_BLOCK_MIC_ERROR;
+    }
+    // The answer is no longer sent once acknowledged
+    Downlink( ans, sizeof( ans ) );
+    answers = Answers;
+    HOST_TEST_CHECK( WaitAnswer( ) == false );
+    HOST_TEST_CHECK( Answers == answers );
+    return status;
+}
+
+/*!
+ * \brief   Random session on the shared decoder: uncoded fragments lost,
+ *          duplicated or swapped with the next one, then coded fragments,
+ *          also lost, until the file is decoded
+ *
+ * \retval  true when the package wrote the file and answered the MIC status
+ */
+static bool RandomSession( bool corruptMic, uint32_t lossPerThousand, uint32_t swapPerThousand )
+{
+    File_t* file = &Files[0];
+    uint16_t fragNb = 1 + TestRandom( ) % TEST_MAX_NB;
+    uint8_t fragSize = FRAG_MIN_SIZE + TestRandom( ) % ( TEST_MAX_SIZE - FRAG_MIN_SIZE + 1 );
+    uint16_t fragCounter = 1;
+    uint16_t maxCounter;
+    uint32_t size;
+    uint8_t status;
+
+    SetupSession( file, 0, fragNb, fragSize, TestRandom( ) % fragSize, corruptMic );
+    size = file->FlashSize - file->Padding;
+    maxCounter = ( 3 * fragNb ) + 50;
+    while( ( file->Done == false ) && ( fragCounter <= maxCounter ) )
+    {
+        if( ( fragCounter < fragNb ) && ( ( TestRandom( ) % 1000 ) < swapPerThousand ) )
+        {
+            SendFragment( file, fragCounter + 1 );
+            if( file->Done == false )
+            {
+                SendFragment( file, fragCounter );
+            }
+            fragCounter += 2;
+            continue;
+        }
+        if( ( TestRandom( ) % 1000 ) >= lossPerThousand )
+        {
+            SendFragment( file, fragCounter );
+            if( ( file->Done == false ) && ( ( TestRandom( ) % 8 ) == 0 ) )
+            {
+                // Retransmission of the same frame
+                SendFragment( file, fragCounter );
+            }
+        }
+        fragCounter++;
+    }
+    // The server stops once the file is decoded: a downlink on the port of the
+    // package clears the answer pending
+    HOST_TEST_CHECK( file->Done == true );
+    if( file->Done == false )
+    {
+        return false;
+    }
+    status = DataBlockReceived( file );
+    HOST_TEST_CHECK( memcmp( file->Flash, file->Data, size ) == 0 );
+    HOST_TEST_CHECK( status == ( corruptMic ? FRAG_DATA_BLOCK_MIC_ERROR : 0 ) );
+    HOST_TEST_CHECK( OpenStreams == 0 );
+    if( ( lossPerThousand == 0 ) && ( swapPerThousand == 0 ) )
+    {
+        // The MIC is complete when the last fragment arrives
+        HOST_TEST_CHECK( file->Reads == 0 );
+    }
+    return ( memcmp( file->Flash, file->Data, size ) == 0 ) && ( status == ( corruptMic ? FRAG_DATA_BLOCK_MIC_ERROR : 0 ) );
+}
+
+/*!
+ * \brief   Sessions ended before their file is decoded, file which cannot be
+ *          read back, concurrent sessions
+ */
+static void CheckSessionEnds( void )
+{
+    uint8_t del[] = { FRAG_SESSION_DELETE_REQ, 0 };
+    uint16_t counter[2] = { 1, 1 };
+
+    // Deleted: its MIC is dropped
+    SetupSession( &Files[0], 0, 20, 50, 7, false );
+    for( uint16_t i = 1; i <= 10; i++ )
+    {
+        SendFragment( &Files[0], i );
+    }
+    Downlink( del, sizeof( del ) );
+    HOST_TEST_CHECK( WaitAnswer( ) == true );
+    HOST_TEST_CHECK( ( AnswerSize == 2 ) && ( Answer[0] == FRAG_SESSION_DELETE_ANS ) && ( Answer[1] == 0 ) );
+    HOST_TEST_CHECK( OpenStreams == 0 );
+
+    // Set up again: the MIC of the first session is dropped, the second one is checked
+    SetupSession( &Files[0], 0, 20, 50, 0, false );
+    SendFragment( &Files[0], 1 );
+    SendFragment( &Files[0], 3 );
+    SetupSession( &Files[0], 0, 30, 60, 59, false );
+    HOST_TEST_CHECK( OpenStreams == 1 );
+    for( uint16_t i = 1; Files[0].Done == false; i++ )
+    {
+        SendFragment( &Files[0], i );
+    }
+    HOST_TEST_CHECK( DataBlockReceived( &Files[0] ) == 0 );
+    HOST_TEST_CHECK( Files[0].Reads == 0 );
+    HOST_TEST_CHECK( OpenStreams == 0 );
+
+    // Lost fragments and the file cannot be read back: the MIC cannot be computed
+    FailReads = true;
+    SetupSession( &Files[0], 0, 40, 45, 3, false );
+    for( uint16_t i = 1; Files[0].Done == false; i++ )
+    {
+        if( ( i != 5 ) && ( i != 17 ) )
+        {
+            SendFragment( &Files[0], i );
+        }
+    }
+    HOST_TEST_CHECK( DataBlockReceived( &Files[0] ) == FRAG_DATA_BLOCK_MIC_ERROR );
+    HOST_TEST_CHECK( memcmp( Files[0].Flash, Files[0].Data, Files[0].FlashSize - Files[0].Padding ) == 0 );
+    HOST_TEST_CHECK( OpenStreams == 0 );
+    FailReads = false;
+
+    // Two sessions with their MIC on the same key, their fragments interleaved
+    SetupSession( &Files[0], 0, 60, 80, 11, false );
+    SetupSession( &Files[1], TEST_OWN_INDEX, 45, 70, 0, false );
+    HOST_TEST_CHECK( OpenStreams == 2 );
+    while( ( Files[0].Done == false ) || ( Files[1].Done == false ) )
+    {
+        for( uint8_t f = 0; f < 2; f++ )
+        {
+            if( Files[f].Done == false )
+            {
+                // The fragment 10 of each file is lost
+                if( counter[f] != 10 )
+                {
+                    SendFragment( &Files[f], counter[f] );
+                }
+                counter[f]++;
+                if( Files[f].Done == true )
+                {
+                    HOST_TEST_CHECK( DataBlockReceived( &Files[f] ) == 0 );
+                    HOST_TEST_CHECK( memcmp( Files[f].Flash, Files[f].Data, Files[f].FlashSize - Files[f].Padding ) == 0 );
+                    HOST_TEST_CHECK( Files[f].Reads > 0 );
+                }
+            }
+        }
+    }
+    HOST_TEST_CHECK( OpenStreams == 0 );
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbSessions = HostTestRuns( argc, argv, 60 );
+    uint32_t accepted = 0;
+    uint32_t rejected = 0;
+    uint32_t readBack = 0;
+
+    UTIL_TIMER_Init( );
+    HOST_TEST_CHECK( SecureElementInit( &SeNvm ) == SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( SecureElementSetKey( DATABLOCK_INT_KEY, ( uint8_t* )DataBlockIntKey ) == SECURE_ELEMENT_SUCCESS );
+
+    Package = LmhpFragmentationPackageFactory( );
+    Package->OnPackageProcessEvent = OnPackageProcessEvent;
+    Package->Init( &Params, DataBuffer, sizeof( DataBuffer ) );
+    HOST_TEST_CHECK( Package->IsInitialized( ) == true );
+
+    for( uint32_t i = 0; i < nbSessions; i++ )
+    {
+        bool corruptMic = ( i % 4 ) == 3;
+        // One session in three without loss nor reordering
+        uint32_t loss = ( ( i % 3 ) == 0 ) ? 0 : ( TestRandom( ) % 150 );
+        uint32_t swap = ( ( i % 3 ) == 0 ) ? 0 : ( TestRandom( ) % 50 );
+
+        if( RandomSession( corruptMic, loss, swap ) == true )
+        {
+            if( corruptMic == true )
+            {
+                rejected++;
+            }
+            else
+            {
+                accepted++;
+            }
+            readBack += ( Files[0].Reads > 0 ) ? 1 : 0;
+        }
+    }
+    HOST_TEST_CHECK( ( accepted + rejected ) == nbSessions );
+    printf( "%u sessions: %u MICs accepted, %u corrupted MICs rejected, %u files read back for the MIC\n",
+            ( unsigned )nbSessions, ( unsigned )accepted, ( unsigned )rejected, ( unsigned )readBack );
+
+    CheckSessionEnds( );
+
+    return HOST_TEST_RESULT( );
+}
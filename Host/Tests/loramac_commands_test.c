@@ -0,0 +1,316 @@
+/*!
+ * \file      loramac_commands_test.c
+ *
+ * \brief     Test and benchmark of the MAC command list of LoRaMacCommands.c
+ *
+ * \remark    Checks random add, remove, serialize and remove sticky/non sticky
+ *            sequences against a reference list, the links of the list and the
+ *            slot pool of utilities.c, then times the uplink cycle of the MAC
+ *            layer with 8 answers: add, serialize, remove non sticky.
+ *
+ *            Usage: loramac_commands_test [operations]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "utilities.h"
+#include "LoRaMacVersion.h"
+#include "LoRaMacCommands.h"
+
+/*!
+ * Slot count of the pool of LoRaMacCommands.c
+ */
+#if ( LORAMAC_VERSION == 0x01000300 )
+#define NB_SLOTS                                    15
+#else
+#define NB_SLOTS                                    32
+#endif
+
+/*!
+ * Answers added by an uplink cycle of the benchmark
+ */
+#define NB_CYCLE_ANSWERS                            8
+
+/*!
+ * Reference list, in the order of the MAC command list
+ */
+static struct
+{
+    uint8_t Cid;
+    uint8_t PayloadSize;
+    uint8_t Payload[LORAMAC_COMMADS_MAX_NUM_OF_PARAMS];
+    bool IsSticky;
+    bool IsConfirmationRequired;
+}Model[NB_SLOTS];
+static uint8_t ModelSize = 0;
+static uint32_t Seed = 0x434D4453;
+
+static void ModelRemove( uint8_t index )
+{
+    memmove( &Model[index], &Model[index + 1], ( ModelSize - index - 1 ) * sizeof( Model[0] ) );
+    ModelSize--;
+}
+
+/*!
+ * \brief   Head of the MAC command list: the first model entry is the first
+ *          command of the list with its CID
+ */
+static MacCommand_t* GetFirst( void )
+{
+    MacCommand_t* cmd = NULL;
+
+    if( ModelSize > 0 )
+    {
+        LoRaMacCommandsGetCmd( Model[0].Cid, &cmd );
+    }
+    return cmd;
+}
+
+/*!
+ * \brief   Checks the list, its links and its serialized size against the model
+ */
+static bool CheckList( void )
+{
+    MacCommand_t* cmd = GetFirst( );
+    MacCommand_t* prev = NULL;
+    size_t size = 0;
+    size_t expected = 0;
+
+    for( uint8_t i = 0; i < ModelSize; i++ )
+    {
+        if( ( cmd == NULL ) || ( cmd->Prev != prev ) || ( cmd->CID != Model[i].Cid ) ||
+            ( cmd->PayloadSize != Model[i].PayloadSize ) ||
+            ( memcmp( cmd->Payload, Model[i].Payload, Model[i].PayloadSize ) != 0 ) )
+        {
+            printf( "command %u differs from the model\n", i );
+            return false;
+        }
+        expected += 1 + Model[i].PayloadSize;
+        prev = cmd;
+        cmd = cmd->Next;
+    }
+    LoRaMacCommandsGetSizeSerializedCmds( &size );
+    return ( cmd == NULL ) && ( size == expected );
+}
+
+static void CheckAdd( void )
+{
+    uint8_t cid = 0x02 + HostTestRand( &Seed ) % 0x12;
+    uint8_t payload[LORAMAC_COMMADS_MAX_NUM_OF_PARAMS] = { ( uint8_t )HostTestRand( &Seed ), ( uint8_t )HostTestRand( &Seed ) };
+    uint8_t payloadSize = HostTestRand( &Seed ) % ( LORAMAC_COMMADS_MAX_NUM_OF_PARAMS + 1 );
+    LoRaMacCommandStatus_t status = LoRaMacCommandsAddCmd( cid, payload, payloadSize );
+    MacCommand_t* cmd = GetFirst( );
+
+    if( ModelSize == NB_SLOTS )
+    {
+        HOST_TEST_CHECK( status == LORAMAC_COMMANDS_ERROR_MEMORY );
+        return;
+    }
+    HOST_TEST_CHECK( status == LORAMAC_COMMANDS_SUCCESS );
+
+    /* The sticky and confirmation flags are the ones of the CID, taken from the new last command */
+    while( ( cmd != NULL ) && ( cmd->Next != NULL ) )
+    {
+        cmd = cmd->Next;
+    }
+    if( ( cmd == NULL ) && ( ModelSize == 0 ) )
+    {
+        LoRaMacCommandsGetCmd( cid, &cmd );
+    }
+    HOST_TEST_CHECK( cmd != NULL );
+    if( cmd != NULL )
+    {
+        Model[ModelSize].Cid = cid;
+        Model[ModelSize].PayloadSize = payloadSize;
+        memcpy( Model[ModelSize].Payload, payload, payloadSize );
+        Model[ModelSize].IsSticky = cmd->IsSticky;
+        Model[ModelSize].IsConfirmationRequired = cmd->IsConfirmationRequired;
+        ModelSize++;
+    }
+}
+
+static void CheckRemove( void )
+{
+    uint8_t index = HostTestRand( &Seed ) % ModelSize;
+    MacCommand_t* cmd = NULL;
+
+    /* LoRaMacCommandsGetCmd returns the first command with the CID */
+    for( uint8_t i = 0; i < index; i++ )
+    {
+        if( Model[i].Cid == Model[index].Cid )
+        {
+            index = i;
+            break;
+        }
+    }
+    HOST_TEST_CHECK( LoRaMacCommandsGetCmd( Model[index].Cid, &cmd ) == LORAMAC_COMMANDS_SUCCESS );
+    HOST_TEST_CHECK( LoRaMacCommandsRemoveCmd( cmd ) == LORAMAC_COMMANDS_SUCCESS );
+    ModelRemove( index );
+
+    /* A removed command is not in the pool any more */
+    HOST_TEST_CHECK( LoRaMacCommandsRemoveCmd( cmd ) == LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND );
+}
+
+static void CheckSerialize( void )
+{
+    uint8_t buffer[NB_SLOTS * ( 1 + LORAMAC_COMMADS_MAX_NUM_OF_PARAMS )];
+    size_t availableSize = HostTestRand( &Seed ) % 40;
+    size_t effectiveSize = 0;
+    size_t pos = 0;
+    uint8_t i = 0;
+
+    HOST_TEST_CHECK( LoRaMacCommandsSerializeCmds( availableSize, &effectiveSize, buffer ) == LORAMAC_COMMANDS_SUCCESS );
+
+    /* The commands fitting in the buffer are serialized in order, the following ones are removed */
+    for( ; ( i < ModelSize ) && ( ( availableSize - pos ) >= ( 1u + Model[i].PayloadSize ) ); i++ )
+    {
+        HOST_TEST_CHECK( buffer[pos] == Model[i].Cid );
+        HOST_TEST_CHECK( memcmp( &buffer[pos + 1], Model[i].Payload, Model[i].PayloadSize ) == 0 );
+        pos += 1 + Model[i].PayloadSize;
+    }
+    ModelSize = i;
+    HOST_TEST_CHECK( effectiveSize == pos );
+}
+
+static void CheckRemoveNoneSticky( bool stickyAns )
+{
+    uint8_t i = 0;
+
+    if( stickyAns == true )
+    {
+        HOST_TEST_CHECK( LoRaMacCommandsRemoveStickyAnsCmds( ) == LORAMAC_COMMANDS_SUCCESS );
+    }
+    else
+    {
+        HOST_TEST_CHECK( LoRaMacCommandsRemoveNoneStickyCmds( ) == LORAMAC_COMMANDS_SUCCESS );
+    }
+    while( i < ModelSize )
+    {
+        if( ( stickyAns == true ) ? ( ( Model[i].IsSticky == true ) && ( Model[i].IsConfirmationRequired == false ) )
+                                  : ( Model[i].IsSticky == false ) )
+        {
+            ModelRemove( i );
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+/*!
+ * \brief   Slot pool of two map words, against a bit per slot
+ */
+static void CheckSlotPool( void )
+{
+    uint32_t freeMap[SLOT_POOL_MAP_SIZE( 40 )];
+    bool allocated[40] = { false };
+
+    SlotPoolInit( freeMap, 40 );
+    for( uint32_t n = 0; n < 10000; n++ )
+    {
+        uint16_t slot = HostTestRand( &Seed ) % 40;
+
+        if( ( HostTestRand( &Seed ) % 2 ) == 0 )
+        {
+            int16_t lowest = -1;
+            int16_t index;
+
+            for( int16_t i = 39; i >= 0; i-- )
+            {
+                if( allocated[i] == false )
+                {
+                    lowest = i;
+                }
+            }
+            index = SlotPoolAlloc( freeMap, 40 );
+            HOST_TEST_CHECK( index == lowest );
+            if( index >= 0 )
+            {
+                allocated[index] = true;
+            }
+        }
+        else if( allocated[slot] == true )
+        {
+            SlotPoolFree( freeMap, slot );
+            allocated[slot] = false;
+        }
+        HOST_TEST_CHECK( SlotPoolIsAllocated( freeMap, slot ) == allocated[slot] );
+    }
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbOperations = HostTestRuns( argc, argv, 200000 );
+    uint8_t payload[LORAMAC_COMMADS_MAX_NUM_OF_PARAMS] = { 0x01, 0x02 };
+    uint8_t buffer[242];
+    size_t effectiveSize = 0;
+    MacCommand_t foreign = { 0 };
+    double start;
+    double elapsed;
+
+    CheckSlotPool( );
+
+    HOST_TEST_CHECK( LoRaMacCommandsInit( ) == LORAMAC_COMMANDS_SUCCESS );
+    for( uint32_t n = 0; n < nbOperations; n++ )
+    {
+        uint32_t op = HostTestRand( &Seed ) % 16;
+
+        if( op < 8 )
+        {
+            CheckAdd( );
+        }
+        else if( ( op < 13 ) && ( ModelSize > 0 ) )
+        {
+            CheckRemove( );
+        }
+        else if( op == 13 )
+        {
+            CheckSerialize( );
+        }
+        else if( op >= 14 )
+        {
+            CheckRemoveNoneSticky( op == 15 );
+        }
+        if( CheckList( ) == false )
+        {
+            HOST_TEST_CHECK( false );
+            break;
+        }
+    }
+
+    /* Pointers out of the slots are rejected */
+    HOST_TEST_CHECK( LoRaMacCommandsRemoveCmd( &foreign ) == LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND );
+    HOST_TEST_CHECK( LoRaMacCommandsRemoveCmd( NULL ) == LORAMAC_COMMANDS_ERROR_NPE );
+    HOST_TEST_CHECK( CheckList( ) == true );
+
+    /* Full pool */
+    for( uint8_t i = 0; i <= NB_SLOTS; i++ )
+    {
+        CheckAdd( );
+    }
+    HOST_TEST_CHECK( CheckList( ) == true );
+
+    /* Uplink cycles, behind 4 sticky answers waiting for a downlink */
+    LoRaMacCommandsInit( );
+    for( uint8_t i = 0; i < 4; i++ )
+    {
+        LoRaMacCommandsAddCmd( MOTE_MAC_DL_CHANNEL_ANS, payload, 1 );
+    }
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbOperations; n++ )
+    {
+        for( uint8_t i = 0; i < NB_CYCLE_ANSWERS; i++ )
+        {
+            LoRaMacCommandsAddCmd( MOTE_MAC_LINK_ADR_ANS, payload, 1 );
+        }
+        LoRaMacCommandsSerializeCmds( sizeof( buffer ), &effectiveSize, buffer );
+        LoRaMacCommandsRemoveNoneStickyCmds( );
+    }
+    elapsed = HostTestNow( ) - start;
+    HOST_TEST_CHECK( effectiveSize == ( 4 + NB_CYCLE_ANSWERS ) * 2 );
+    LoRaMacCommandsGetSizeSerializedCmds( &effectiveSize );
+    HOST_TEST_CHECK( effectiveSize == 4 * 2 );
+    printf( "%u uplink cycles of %u answers: %.1f ns/cycle\n", nbOperations, NB_CYCLE_ANSWERS, elapsed / nbOperations );
+
+    return HOST_TEST_RESULT( );
+}
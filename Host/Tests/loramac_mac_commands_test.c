@@ -0,0 +1,352 @@
+/*!
+ * \file      loramac_mac_commands_test.c
+ *
+ * \brief     Fuzz test and benchmark of the downlink MAC command parser of LoRaMac.c
+ *
+ * \remark    Built once for each LoRaWAN version, on EU868. Feeds random
+ *            FOpts and port 0 payloads to ProcessMacCommands: known, unknown
+ *            and truncated commands, LinkAdrReq blocks, with random pending
+ *            MLME requests and ADR setting. A reference walk of each payload
+ *            with the command sizes of the specification gives the commands
+ *            to be processed, and the answers queued are checked against it.
+ *            Then times the parser over the FOpts and the port 0 payloads.
+ *
+ *            Usage: loramac_mac_commands_test [payloads]
+ */
+#include <string.h>
+#include "host_test.h"
+
+/*
+ * ProcessMacCommands and the MAC context are private to LoRaMac.c
+ */
+#include "LoRaMac.c"
+
+/*!
+ * Battery level reported by the DevStatusAns
+ */
+#define TEST_BATTERY_LEVEL                          77
+
+/*!
+ * Largest MAC command identifier generated, besides the random CIDs
+ */
+#define TEST_MAX_CID                                0x13
+
+/*!
+ * MAC command slots of LoRaMacCommands.c
+ */
+#if ( LORAMAC_VERSION == 0x01000300 )
+#define TEST_NB_SLOTS                               15
+#else
+#define TEST_NB_SLOTS                               32
+#endif
+
+/*!
+ * Size of the server commands, CID included, 0 when unknown
+ */
+static const uint8_t CmdSizes[LORAMAC_COMMANDS_MAX_CID + 1] =
+{
+#if ( LORAMAC_VERSION == 0x01010100 )
+    [SRV_MAC_RESET_CONF] = 2,
+    [SRV_MAC_REKEY_CONF] = 2,
+    [SRV_MAC_ADR_PARAM_SETUP_REQ] = 2,
+    [SRV_MAC_FORCE_REJOIN_REQ] = 3,
+    [SRV_MAC_REJOIN_PARAM_REQ] = 2,
+    [SRV_MAC_DEVICE_MODE_CONF] = 2,
+#endif
+    [SRV_MAC_LINK_CHECK_ANS] = 3,
+    [SRV_MAC_LINK_ADR_REQ] = 5,
+    [SRV_MAC_DUTY_CYCLE_REQ] = 2,
+    [SRV_MAC_RX_PARAM_SETUP_REQ] = 5,
+    [SRV_MAC_DEV_STATUS_REQ] = 1,
+    [SRV_MAC_NEW_CHANNEL_REQ] = 6,
+    [SRV_MAC_RX_TIMING_SETUP_REQ] = 2,
+    [SRV_MAC_TX_PARAM_SETUP_REQ] = 2,
+    [SRV_MAC_DL_CHANNEL_REQ] = 5,
+    [SRV_MAC_DEVICE_TIME_ANS] = 6,
+    [SRV_MAC_PING_SLOT_INFO_ANS] = 1,
+    [SRV_MAC_PING_SLOT_CHANNEL_REQ] = 5,
+    [SRV_MAC_BEACON_TIMING_ANS] = 4,
+    [SRV_MAC_BEACON_FREQ_REQ] = 4,
+};
+
+/*!
+ * Answer of each server command on EU868, 0 when none. TxParamSetupReq is not
+ * supported by EU868.
+ */
+static const uint8_t Answers[LORAMAC_COMMANDS_MAX_CID + 1] =
+{
+#if ( LORAMAC_VERSION == 0x01010100 )
+    [SRV_MAC_ADR_PARAM_SETUP_REQ] = MOTE_MAC_ADR_PARAM_SETUP_ANS,
+    [SRV_MAC_REJOIN_PARAM_REQ] = MOTE_MAC_REJOIN_PARAM_ANS,
+#endif
+    [SRV_MAC_LINK_ADR_REQ] = MOTE_MAC_LINK_ADR_ANS,
+    [SRV_MAC_DUTY_CYCLE_REQ] = MOTE_MAC_DUTY_CYCLE_ANS,
+    [SRV_MAC_RX_PARAM_SETUP_REQ] = MOTE_MAC_RX_PARAM_SETUP_ANS,
+    [SRV_MAC_DEV_STATUS_REQ] = MOTE_MAC_DEV_STATUS_ANS,
+    [SRV_MAC_NEW_CHANNEL_REQ] = MOTE_MAC_NEW_CHANNEL_ANS,
+    [SRV_MAC_RX_TIMING_SETUP_REQ] = MOTE_MAC_RX_TIMING_SETUP_ANS,
+    [SRV_MAC_DL_CHANNEL_REQ] = MOTE_MAC_DL_CHANNEL_ANS,
+    [SRV_MAC_PING_SLOT_CHANNEL_REQ] = 0x11,
+    [SRV_MAC_BEACON_FREQ_REQ] = MOTE_MAC_BEACON_FREQ_ANS,
+};
+
+static uint32_t Seed = 0x4D414343;
+
+static void OnMcpsConfirm( McpsConfirm_t* mcpsConfirm )
+{
+}
+
+static void OnMcpsIndication( McpsIndication_t* mcpsIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+static void OnMlmeConfirm( MlmeConfirm_t* mlmeConfirm )
+{
+}
+
+static void OnMlmeIndication( MlmeIndication_t* mlmeIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+static uint8_t GetBatteryLevel( void )
+{
+    return TEST_BATTERY_LEVEL;
+}
+
+static LoRaMacPrimitives_t Primitives =
+{
+    .MacMcpsConfirm = OnMcpsConfirm,
+    .MacMcpsIndication = OnMcpsIndication,
+    .MacMlmeConfirm = OnMlmeConfirm,
+    .MacMlmeIndication = OnMlmeIndication,
+};
+
+static LoRaMacCallback_t Callbacks =
+{
+    .GetBatteryLevel = GetBatteryLevel,
+};
+
+static LoRaMacNvmData_t InitialNvm;
+
+/*!
+ * \brief   Builds random MAC commands, LinkAdrReq being frequent
+ *
+ * \retval  Size of the payload
+ */
+static uint8_t BuildPayload( uint8_t* payload, uint8_t maxSize )
+{
+    uint8_t size = 0;
+
+    while( size < maxSize )
+    {
+        uint32_t draw = HostTestRand( &Seed ) % 100;
+        uint8_t cid = ( draw < 3 ) ? ( uint8_t )HostTestRand( &Seed ) :
+                      ( draw < 25 ) ? SRV_MAC_LINK_ADR_REQ : 1 + HostTestRand( &Seed ) % TEST_MAX_CID;
+        uint8_t cmdSize;
+
+#if ( LORAMAC_VERSION == 0x01010100 )
+        // A ForceRejoinReq sends a rejoin request
+        if( cid == SRV_MAC_FORCE_REJOIN_REQ )
+        {
+            cid = SRV_MAC_LINK_ADR_REQ;
+        }
+#endif
+        cmdSize = ( ( cid <= LORAMAC_COMMANDS_MAX_CID ) && ( CmdSizes[cid] != 0 ) ) ? CmdSizes[cid] : 1;
+        if( ( size + cmdSize ) > maxSize )
+        {
+            // Truncated command. The region parses LinkAdrReq blocks on its own, keep them complete.
+            if( cid == SRV_MAC_LINK_ADR_REQ )
+            {
+                cid = SRV_MAC_NEW_CHANNEL_REQ;
+            }
+            cmdSize = maxSize - size;
+        }
+
+        payload[size] = cid;
+        for( uint8_t i = 1; i < cmdSize; i++ )
+        {
+            payload[size + i] = ( uint8_t )HostTestRand( &Seed );
+        }
+        if( ( cid == SRV_MAC_LINK_ADR_REQ ) && ( cmdSize == 5 ) )
+        {
+            // Valid ChMaskCntl, half of the requests with a disabled channel mask
+            payload[size + 4] &= 0x0F;
+            if( ( HostTestRand( &Seed ) % 2 ) == 0 )
+            {
+                payload[size + 3] = 0;
+            }
+        }
+        size += cmdSize;
+        if( ( HostTestRand( &Seed ) % 8 ) == 0 )
+        {
+            break;
+        }
+    }
+    return size;
+}
+
+/*!
+ * \brief   Reference walk of the payload: answers of the processed commands,
+ *          the answer of a second LinkAdrReq block being dropped
+ *
+ * \retval  Number of answers, at most TEST_NB_SLOTS
+ */
+static uint8_t ExpectedAnswers( const uint8_t* payload, uint8_t size, uint8_t* answers, const uint8_t** lastLinkCheck )
+{
+    uint8_t nbAnswers = 0;
+    uint8_t index = 0;
+    bool adrBlockDone = false;
+    bool inAdrBlock = false;
+
+    *lastLinkCheck = NULL;
+    while( index < size )
+    {
+        uint8_t cid = payload[index];
+        uint8_t cmdSize = ( cid <= LORAMAC_COMMANDS_MAX_CID ) ? CmdSizes[cid] : 0;
+
+        if( ( cmdSize == 0 ) || ( ( index + cmdSize ) > size ) )
+        {
+            break;
+        }
+        if( cid == SRV_MAC_LINK_ADR_REQ )
+        {
+            if( ( inAdrBlock == false ) && ( adrBlockDone == true ) )
+            {
+                index += cmdSize;
+                continue;
+            }
+            inAdrBlock = true;
+            adrBlockDone = true;
+        }
+        else
+        {
+            inAdrBlock = false;
+        }
+        if( cid == SRV_MAC_LINK_CHECK_ANS )
+        {
+            *lastLinkCheck = &payload[index];
+        }
+        if( ( Answers[cid] != 0 ) && ( nbAnswers < TEST_NB_SLOTS ) )
+        {
+            answers[nbAnswers++] = Answers[cid];
+        }
+        index += cmdSize;
+    }
+    return nbAnswers;
+}
+
+/*!
+ * \brief   Resets the MAC layer state between two payloads
+ */
+static void Reset( bool linkCheckPending )
+{
+    Nvm = InitialNvm;
+    Nvm.MacGroup2.AdrCtrlOn = ( HostTestRand( &Seed ) % 2 ) == 0;
+    LoRaMacCommandsInit( );
+    LoRaMacConfirmQueueInit( &Primitives );
+    MacCtx.MlmeConfirm.DemodMargin = 0;
+    MacCtx.MlmeConfirm.NbGateways = 0;
+    if( linkCheckPending == true )
+    {
+        MlmeConfirmQueue_t request = { .Request = MLME_LINK_CHECK, .Status = LORAMAC_EVENT_INFO_STATUS_ERROR };
+
+        LoRaMacConfirmQueueAdd( &request );
+    }
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbPayloads = HostTestRuns( argc, argv, 100000 );
+    uint8_t payload[LORAMAC_PHY_MAXPAYLOAD];
+    uint8_t answers[256];
+    uint8_t expected[TEST_NB_SLOTS];
+    uint32_t nbCommands = 0;
+    uint32_t nbAnswers = 0;
+
+    HOST_TEST_CHECK( LoRaMacInitialization( &Primitives, &Callbacks, LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_OK );
+    InitialNvm = Nvm;
+
+    for( uint32_t n = 0; n < nbPayloads; n++ )
+    {
+        bool linkCheckPending = ( HostTestRand( &Seed ) % 2 ) == 0;
+        uint8_t size = BuildPayload( payload, ( ( n % 2 ) == 0 ) ? LORA_MAC_COMMAND_MAX_FOPTS_LENGTH : 242 );
+        int8_t snr = ( int8_t )HostTestRand( &Seed );
+        const uint8_t* lastLinkCheck = NULL;
+        uint8_t nbExpected = ExpectedAnswers( payload, size, expected, &lastLinkCheck );
+        size_t answersSize = 0;
+        uint8_t index = 0;
+        uint8_t k = 0;
+        MacCommand_t* devStatusAns = NULL;
+
+        Reset( linkCheckPending );
+        ProcessMacCommands( payload, 0, size, snr, RX_SLOT_WIN_1 );
+
+        // The answers are queued in the order of the requests
+        LoRaMacCommandsSerializeCmds( sizeof( answers ), &answersSize, answers );
+        while( index < answersSize )
+        {
+            uint8_t cid = answers[index];
+            MacCommand_t* cmd = NULL;
+
+            HOST_TEST_CHECK( ( k < nbExpected ) && ( cid == expected[k] ) );
+            if( ( k >= nbExpected ) || ( cid != expected[k] ) )
+            {
+                break;
+            }
+            LoRaMacCommandsGetCmd( cid, &cmd );
+            index += 1 + cmd->PayloadSize;
+            k++;
+        }
+        HOST_TEST_CHECK( k == nbExpected );
+
+        if( LoRaMacCommandsGetCmd( MOTE_MAC_DEV_STATUS_ANS, &devStatusAns ) == LORAMAC_COMMANDS_SUCCESS )
+        {
+            HOST_TEST_CHECK( devStatusAns->Payload[0] == TEST_BATTERY_LEVEL );
+            HOST_TEST_CHECK( devStatusAns->Payload[1] == ( snr & 0x3F ) );
+        }
+        if( ( linkCheckPending == true ) && ( lastLinkCheck != NULL ) )
+        {
+            HOST_TEST_CHECK( MacCtx.MlmeConfirm.DemodMargin == lastLinkCheck[1] );
+            HOST_TEST_CHECK( MacCtx.MlmeConfirm.NbGateways == lastLinkCheck[2] );
+        }
+        else
+        {
+            HOST_TEST_CHECK( MacCtx.MlmeConfirm.NbGateways == 0 );
+        }
+        nbCommands += size;
+        nbAnswers += nbExpected;
+
+#if ( LORAMAC_VERSION != 0x01000300 )
+        // MAC commands are only processed in the class A windows
+        Reset( false );
+        ProcessMacCommands( payload, 0, size, snr, RX_SLOT_WIN_CLASS_C );
+        LoRaMacCommandsGetSizeSerializedCmds( &answersSize );
+        HOST_TEST_CHECK( answersSize == 0 );
+#endif
+    }
+    printf( "LoRaWAN 0x%08X: %u payloads, %u bytes of MAC commands, %u answers\n", LORAMAC_VERSION, nbPayloads,
+            nbCommands, nbAnswers );
+
+    /* Benchmark of the FOpts and the port 0 payloads */
+    for( uint8_t maxSize = LORA_MAC_COMMAND_MAX_FOPTS_LENGTH; maxSize != 0; maxSize = ( maxSize == 242 ) ? 0 : 242 )
+    {
+        double elapsed = 0;
+        double worst = 0;
+
+        for( uint32_t n = 0; n < nbPayloads; n++ )
+        {
+            uint8_t size = BuildPayload( payload, maxSize );
+            double start;
+
+            Reset( ( HostTestRand( &Seed ) % 2 ) == 0 );
+            start = HostTestNow( );
+            ProcessMacCommands( payload, 0, size, 0, RX_SLOT_WIN_1 );
+            start = HostTestNow( ) - start;
+            elapsed += start;
+            worst = ( start > worst ) ? start : worst;
+        }
+        printf( "  payloads of up to %u bytes: %.0f ns/payload, worst %.0f ns\n", maxSize, elapsed / nbPayloads, worst );
+    }
+
+    return HOST_TEST_RESULT( );
+}
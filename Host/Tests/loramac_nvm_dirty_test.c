@@ -0,0 +1,444 @@
+/*!
+ * \file      loramac_nvm_dirty_test.c
+ *
+ * \brief     Test of the NVM dirty flags of LoRaMac.c on the virtual radio and
+ *            the virtual time
+ *
+ * \remark    Built with class B, run on EU868 and US915. MIB sets and MAC
+ *            commands shall flag exactly the NVM groups they write, and the
+ *            next pass of LoRaMacHandleNvm shall compute one CRC per flagged
+ *            group: Crc32 is wrapped at link time to count them. An idle
+ *            pass with nothing flagged computes no CRC. Uplinks are then
+ *            sent to a test network server which answers with MAC commands
+ *            in FOpts. After each pass the CRC of every group is recomputed:
+ *            a stored CRC which does not match the group reveals a write
+ *            which was not flagged.
+ *
+ *            Usage: loramac_nvm_dirty_test [uplinks]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "radio_sim.h"
+#include "stm32_timer_if_sim.h"
+#include "cmac.h"
+
+/*
+ * The dirty flags and the MAC command parser are private to LoRaMac.c
+ */
+#include "LoRaMac.c"
+
+/*!
+ * Device address, application port of the test uplinks
+ */
+#define TEST_DEV_ADDR                               0x26011234
+#define TEST_PORT                                   2
+
+/*!
+ * Period of the uplinks [ms], longer than the duty cycle off time
+ */
+#define TEST_UPLINK_PERIOD                          120000
+
+/*!
+ * Maximum number of time server events processed for one MAC request
+ */
+#define TEST_MAX_EVENTS                             100
+
+/*!
+ * Session keys, NwkSKey and AppSKey of LoRaWAN 1.0.x
+ */
+static const uint8_t NwkSKey[16] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                                     0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+static const uint8_t AppSKey[16] = { 0x3C, 0x4F, 0xCF, 0x09, 0x88, 0x15, 0xF7, 0xAB,
+                                     0xA6, 0xD2, 0xAE, 0x28, 0x16, 0x15, 0x7E, 0x2B };
+
+/*!
+ * MAC commands of the downlinks: RxTimingSetupReq, DutyCycleReq
+ */
+static const uint8_t DownlinkFOpts[] = { SRV_MAC_RX_TIMING_SETUP_REQ, 0x01, SRV_MAC_DUTY_CYCLE_REQ, 0x00 };
+
+/*!
+ * Test network server state
+ */
+static struct
+{
+    uint32_t FCntDown;
+    uint32_t UplinksReceived;
+    uint8_t Downlink[32];
+    uint8_t DownlinkSize;
+    bool Rx1;
+    bool Silent;
+    uint32_t Downlinks;
+}Ns;
+
+static uint32_t CrcCalls = 0;
+static uint16_t Notified = LORAMAC_NVM_NOTIFY_FLAG_NONE;
+static uint32_t McpsConfirms = 0;
+
+uint32_t __real_Crc32( uint8_t *buffer, uint16_t length );
+
+uint32_t __wrap_Crc32( uint8_t *buffer, uint16_t length )
+{
+    CrcCalls++;
+    return __real_Crc32( buffer, length );
+}
+
+static void ComputeDataMic( uint8_t dir, uint32_t fCnt, const uint8_t* msg, uint16_t size, uint8_t* mic )
+{
+    AES_CMAC_CTX cmacCtx;
+    uint8_t digest[AES_CMAC_DIGEST_LENGTH];
+    uint8_t b0[16] = { 0x49, 0, 0, 0, 0, dir,
+                       TEST_DEV_ADDR & 0xFF, ( TEST_DEV_ADDR >> 8 ) & 0xFF, ( TEST_DEV_ADDR >> 16 ) & 0xFF, ( TEST_DEV_ADDR >> 24 ) & 0xFF,
+                       fCnt & 0xFF, ( fCnt >> 8 ) & 0xFF, ( fCnt >> 16 ) & 0xFF, ( fCnt >> 24 ) & 0xFF,
+                       0, ( uint8_t )size };
+
+    AES_CMAC_Init( &cmacCtx );
+    AES_CMAC_SetKey( &cmacCtx, NwkSKey );
+    AES_CMAC_Update( &cmacCtx, b0, 16 );
+    AES_CMAC_Update( &cmacCtx, msg, size );
+    AES_CMAC_Final( digest, &cmacCtx );
+    memcpy( mic, digest, 4 );
+}
+
+/*!
+ * \brief   Test network server: answers each uplink with the MAC commands of
+ *          DownlinkFOpts
+ */
+static void OnTxStart( const RadioSimParams_t* params, const uint8_t* payload, uint8_t size, uint32_t timeOnAir )
+{
+    uint8_t* frame = Ns.Downlink;
+    uint8_t n = 0;
+
+    Ns.UplinksReceived++;
+    Ns.DownlinkSize = 0;
+    Ns.Rx1 = true;
+    if( Ns.Silent == true )
+    {
+        return;
+    }
+    frame[n++] = 0x60;
+    frame[n++] = TEST_DEV_ADDR & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 8 ) & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 16 ) & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 24 ) & 0xFF;
+    // ACK of the confirmed uplinks
+    frame[n++] = ( ( payload[0] == 0x80 ) ? 0x20 : 0x00 ) | sizeof( DownlinkFOpts );
+    frame[n++] = Ns.FCntDown & 0xFF;
+    frame[n++] = ( Ns.FCntDown >> 8 ) & 0xFF;
+    memcpy( &frame[n], DownlinkFOpts, sizeof( DownlinkFOpts ) );
+    n += sizeof( DownlinkFOpts );
+    ComputeDataMic( 1, Ns.FCntDown, frame, n, &frame[n] );
+    Ns.FCntDown++;
+    Ns.DownlinkSize = n + 4;
+}
+
+static void OnRxStart( const RadioSimParams_t* params, uint32_t window )
+{
+    // Answers in the first window opened after the uplink
+    if( ( Ns.Rx1 == true ) && ( Ns.DownlinkSize > 0 ) )
+    {
+        HOST_TEST_CHECK( RADIO_SIM_Deliver( params, Ns.Downlink, Ns.DownlinkSize, -60, 8 ) == true );
+        Ns.DownlinkSize = 0;
+        Ns.Downlinks++;
+    }
+    Ns.Rx1 = false;
+}
+
+static const RadioSimObserver_t Observer = { OnTxStart, OnRxStart };
+
+static void OnMcpsConfirm( McpsConfirm_t* mcpsConfirm )
+{
+    McpsConfirms++;
+}
+
+static void OnMcpsIndication( McpsIndication_t* mcpsIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+static void OnMlmeConfirm( MlmeConfirm_t* mlmeConfirm )
+{
+}
+
+static void OnMlmeIndication( MlmeIndication_t* mlmeIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+static void OnNvmDataChange( uint16_t notifyFlags )
+{
+    Notified |= notifyFlags;
+}
+
+static LoRaMacPrimitives_t Primitives = { OnMcpsConfirm, OnMcpsIndication, OnMlmeConfirm, OnMlmeIndication };
+static LoRaMacCallback_t Callbacks = { .NvmDataChange = OnNvmDataChange };
+
+/*!
+ * \brief   Groups which stored CRC does not match their content
+ */
+static uint16_t StaleGroups( void )
+{
+    uint16_t stale = LORAMAC_NVM_NOTIFY_FLAG_NONE;
+
+#define CHECK_GROUP( group, flag )                                                            \
+    if( __real_Crc32( ( uint8_t* )&Nvm.group, sizeof( Nvm.group ) - sizeof( uint32_t ) ) != \
+        Nvm.group.Crc32 )                                                                     \
+    {                                                                                         \
+        stale |= flag;                                                                        \
+    }
+    CHECK_GROUP( Crypto, LORAMAC_NVM_NOTIFY_FLAG_CRYPTO );
+    CHECK_GROUP( MacGroup1, LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
+    CHECK_GROUP( MacGroup2, LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+    CHECK_GROUP( SecureElement, LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
+    CHECK_GROUP( RegionGroup1, LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 );
+    CHECK_GROUP( RegionGroup2, LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
+    CHECK_GROUP( ClassB, LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
+#undef CHECK_GROUP
+    return stale;
+}
+
+static uint32_t CountGroups( uint16_t flags )
+{
+    uint32_t count = 0;
+
+    for( ; flags != 0; flags &= flags - 1 )
+    {
+        count++;
+    }
+    return count;
+}
+
+/*!
+ * \brief   Runs an idle pass of the MAC with the NVM handling. The groups
+ *          flagged before the pass shall be exactly the expected ones, one
+ *          CRC is computed per group and no group is left stale.
+ *
+ * \retval  Groups notified as changed by the pass
+ */
+static uint16_t NvmPass( uint16_t expected )
+{
+    HOST_TEST_CHECK( MacCtx.NvmDirtyFlags == expected );
+    CrcCalls = 0;
+    Notified = LORAMAC_NVM_NOTIFY_FLAG_NONE;
+    MacCtx.MacFlags.Bits.NvmHandle = 1;
+    LoRaMacProcess( );
+    HOST_TEST_CHECK( CrcCalls == CountGroups( expected ) );
+    HOST_TEST_CHECK( StaleGroups( ) == LORAMAC_NVM_NOTIFY_FLAG_NONE );
+    HOST_TEST_CHECK( ( Notified & ~expected ) == 0 );
+    return Notified;
+}
+
+/*!
+ * \brief   Runs the MAC and the virtual time until the MAC is idle
+ */
+static bool RunUntilIdle( void )
+{
+    for( uint32_t i = 0; i < TEST_MAX_EVENTS; i++ )
+    {
+        LoRaMacProcess( );
+        if( LoRaMacIsBusy( ) == false )
+        {
+            return true;
+        }
+        if( TIMER_IF_SIM_RunNextEvent( ) == false )
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+static LoRaMacStatus_t MibSet( MibRequestConfirm_t* mibReq )
+{
+    return LoRaMacMibSetRequestConfirm( mibReq );
+}
+
+/*!
+ * \brief   Initializes the MAC in a region and activates the ABP session
+ */
+static void Start( LoRaMacRegion_t region )
+{
+    MibRequestConfirm_t mibReq;
+
+    HOST_TEST_CHECK( LoRaMacInitialization( &Primitives, &Callbacks, region ) == LORAMAC_STATUS_OK );
+    mibReq.Type = MIB_NET_ID;
+    mibReq.Param.NetID = 0x000013;
+    MibSet( &mibReq );
+    mibReq.Type = MIB_DEV_ADDR;
+    mibReq.Param.DevAddr = TEST_DEV_ADDR;
+    MibSet( &mibReq );
+    mibReq.Type = MIB_NWK_S_KEY;
+    mibReq.Param.NwkSKey = ( uint8_t* )NwkSKey;
+    MibSet( &mibReq );
+    mibReq.Type = MIB_APP_S_KEY;
+    mibReq.Param.AppSKey = ( uint8_t* )AppSKey;
+    MibSet( &mibReq );
+    mibReq.Type = MIB_NETWORK_ACTIVATION;
+    mibReq.Param.NetworkActivation = ACTIVATION_TYPE_ABP;
+    MibSet( &mibReq );
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = true;
+    MibSet( &mibReq );
+    mibReq.Type = MIB_CHANNELS_DATARATE;
+    mibReq.Param.ChannelsDatarate = DR_3;
+    MibSet( &mibReq );
+    HOST_TEST_CHECK( LoRaMacStart( ) == LORAMAC_STATUS_OK );
+    // The initialization flags all the groups
+    HOST_TEST_CHECK( NvmPass( LORAMAC_NVM_ALL_GROUPS ) == LORAMAC_NVM_ALL_GROUPS );
+    Ns.FCntDown = 0;
+}
+
+/*!
+ * \brief   Sends one uplink and runs it through its RX windows
+ */
+static void Uplink( Mcps_t type )
+{
+    McpsReq_t mcpsReq;
+    uint32_t confirms = McpsConfirms;
+
+    TIMER_IF_SIM_Advance( TEST_UPLINK_PERIOD );
+    mcpsReq.Type = type;
+    mcpsReq.Req.Unconfirmed.fPort = TEST_PORT;
+    mcpsReq.Req.Unconfirmed.fBuffer = "ping";
+    mcpsReq.Req.Unconfirmed.fBufferSize = 4;
+    mcpsReq.Req.Unconfirmed.Datarate = DR_3;
+    HOST_TEST_CHECK( LoRaMacMcpsRequest( &mcpsReq, true ) == LORAMAC_STATUS_OK );
+    HOST_TEST_CHECK( RunUntilIdle( ) == true );
+    HOST_TEST_CHECK( McpsConfirms == ( confirms + 1 ) );
+}
+
+/*!
+ * \brief   Parses MAC commands received in RX1 and checks the flagged groups
+ */
+static void MacCommands( const uint8_t* payload, uint8_t size, uint16_t expected )
+{
+    ProcessMacCommands( ( uint8_t* )payload, 0, size, 8, RX_SLOT_WIN_1 );
+    LoRaMacCommandsRemoveNoneStickyCmds( );
+    LoRaMacCommandsRemoveStickyAnsCmds( );
+    NvmPass( expected );
+}
+
+static void Run( LoRaMacRegion_t region, uint32_t nbUplinks )
+{
+    MibRequestConfirm_t mibReq;
+    uint16_t notified;
+    uint8_t devEui[8] = { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x00, 0x01 };
+    uint16_t channelsMask[REGION_NVM_CHANNELS_MASK_SIZE];
+
+    memset( &Ns, 0, sizeof( Ns ) );
+    Start( region );
+
+    // Idle pass with nothing flagged: no CRC
+    NvmPass( LORAMAC_NVM_NOTIFY_FLAG_NONE );
+    NvmPass( LORAMAC_NVM_NOTIFY_FLAG_NONE );
+
+    // MIB sets
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = false;
+    HOST_TEST_CHECK( MibSet( &mibReq ) == LORAMAC_STATUS_OK );
+    HOST_TEST_CHECK( NvmPass( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 ) == LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+    // Same value: flagged, the CRC is unchanged and not notified
+    HOST_TEST_CHECK( MibSet( &mibReq ) == LORAMAC_STATUS_OK );
+    HOST_TEST_CHECK( NvmPass( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 ) == LORAMAC_NVM_NOTIFY_FLAG_NONE );
+    mibReq.Param.AdrEnable = true;
+    HOST_TEST_CHECK( MibSet( &mibReq ) == LORAMAC_STATUS_OK );
+    NvmPass( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+
+    mibReq.Type = MIB_CHANNELS_TX_POWER;
+    mibReq.Param.ChannelsTxPower = TX_POWER_1;
+    HOST_TEST_CHECK( MibSet( &mibReq ) == LORAMAC_STATUS_OK );
+    HOST_TEST_CHECK( NvmPass( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 ) == LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
+
+    mibReq.Type = MIB_DEV_EUI;
+    mibReq.Param.DevEui = devEui;
+    HOST_TEST_CHECK( MibSet( &mibReq ) == LORAMAC_STATUS_OK );
+    HOST_TEST_CHECK( NvmPass( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT ) == LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
+
+    mibReq.Type = MIB_APP_S_KEY;
+    mibReq.Param.AppSKey = ( uint8_t* )AppSKey;
+    HOST_TEST_CHECK( MibSet( &mibReq ) == LORAMAC_STATUS_OK );
+    HOST_TEST_CHECK( NvmPass( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT ) == LORAMAC_NVM_NOTIFY_FLAG_NONE );
+
+    mibReq.Type = MIB_CHANNELS_MASK;
+    HOST_TEST_CHECK( LoRaMacMibGetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK );
+    memcpy( channelsMask, mibReq.Param.ChannelsMask, sizeof( channelsMask ) );
+    mibReq.Param.ChannelsMask = channelsMask;
+    HOST_TEST_CHECK( MibSet( &mibReq ) == LORAMAC_STATUS_OK );
+    NvmPass( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
+
+    mibReq.Type = MIB_ABP_LORAWAN_VERSION;
+    mibReq.Param.AbpLrWanVersion.Value = 0x01000400;
+    HOST_TEST_CHECK( MibSet( &mibReq ) == LORAMAC_STATUS_OK );
+    NvmPass( LORAMAC_NVM_NOTIFY_FLAG_CRYPTO | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+
+    mibReq.Type = MIB_PING_SLOT_DATARATE;
+    mibReq.Param.PingSlotDatarate = DR_1;
+    HOST_TEST_CHECK( MibSet( &mibReq ) == LORAMAC_STATUS_OK );
+    HOST_TEST_CHECK( NvmPass( LORAMAC_NVM_NOTIFY_FLAG_CLASS_B ) == LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
+
+    // The NVM contexts handed to the application may be modified anywhere
+    mibReq.Type = MIB_NVM_CTXS;
+    HOST_TEST_CHECK( LoRaMacMibGetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK );
+    NvmPass( LORAMAC_NVM_ALL_GROUPS );
+
+    // MAC commands
+    {
+        const uint8_t rxTimingSetupReq[] = { SRV_MAC_RX_TIMING_SETUP_REQ, 0x02 };
+        const uint8_t dutyCycleReq[] = { SRV_MAC_DUTY_CYCLE_REQ, 0x00 };
+        // EU868: DR_5, channels 0 to 2. US915: DR_3, all the channels enabled.
+        const uint8_t linkAdrReq[] = { SRV_MAC_LINK_ADR_REQ,
+                                       ( region == LORAMAC_REGION_EU868 ) ? 0x50 : 0x30,
+                                       ( region == LORAMAC_REGION_EU868 ) ? 0x07 : 0xFF, 0x00,
+                                       ( region == LORAMAC_REGION_EU868 ) ? 0x01 : 0x61 };
+        // Channel 3 at 867.1 MHz, DR_0 to DR_5
+        const uint8_t newChannelReq[] = { SRV_MAC_NEW_CHANNEL_REQ, 3, 0x18, 0x4F, 0x84, 0x50 };
+
+        MacCommands( rxTimingSetupReq, sizeof( rxTimingSetupReq ), LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+        MacCommands( dutyCycleReq, sizeof( dutyCycleReq ), LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+        MacCommands( linkAdrReq, sizeof( linkAdrReq ),
+                     LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 |
+                     LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
+        if( region == LORAMAC_REGION_EU868 )
+        {
+            MacCommands( newChannelReq, sizeof( newChannelReq ), LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
+        }
+    }
+    NvmPass( LORAMAC_NVM_NOTIFY_FLAG_NONE );
+
+    // Uplinks answered with MAC commands, then unanswered confirmed uplinks
+    // with retransmissions
+    for( uint32_t i = 0; i < nbUplinks; i++ )
+    {
+        Notified = LORAMAC_NVM_NOTIFY_FLAG_NONE;
+        Uplink( ( ( i & 1 ) == 0 ) ? MCPS_UNCONFIRMED : MCPS_CONFIRMED );
+        // Uplink and downlink frame counters, handled at the end of the uplink
+        notified = Notified;
+        HOST_TEST_CHECK( ( notified & LORAMAC_NVM_NOTIFY_FLAG_CRYPTO ) != 0 );
+        NvmPass( MacCtx.NvmDirtyFlags );
+        NvmPass( LORAMAC_NVM_NOTIFY_FLAG_NONE );
+    }
+    mibReq.Type = MIB_CHANNELS_NB_TRANS;
+    mibReq.Param.ChannelsNbTrans = 3;
+    HOST_TEST_CHECK( MibSet( &mibReq ) == LORAMAC_STATUS_OK );
+    NvmPass( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+    Ns.Silent = true;
+    for( uint32_t i = 0; i < nbUplinks; i++ )
+    {
+        Uplink( MCPS_CONFIRMED );
+        NvmPass( MacCtx.NvmDirtyFlags );
+        NvmPass( LORAMAC_NVM_NOTIFY_FLAG_NONE );
+    }
+    HOST_TEST_CHECK( Ns.Downlinks == nbUplinks );
+    printf( "%s: %u uplinks, %u downlinks\n", ( region == LORAMAC_REGION_EU868 ) ? "EU868" : "US915",
+            ( unsigned )Ns.UplinksReceived, ( unsigned )Ns.Downlinks );
+    HOST_TEST_CHECK( LoRaMacDeInitialization( ) == LORAMAC_STATUS_OK );
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbUplinks = HostTestRuns( argc, argv, 10 );
+
+    RADIO_SIM_SetObserver( &Observer );
+    RADIO_SIM_SetSeed( 7 );
+    UTIL_TIMER_Init( );
+    Run( LORAMAC_REGION_EU868, nbUplinks );
+    Run( LORAMAC_REGION_US915, nbUplinks );
+    return HOST_TEST_RESULT( );
+}
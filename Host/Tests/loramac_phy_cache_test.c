@@ -0,0 +1,334 @@
+/*!
+ * \file      loramac_phy_cache_test.c
+ *
+ * \brief     Test of the PHY parameters snapshot of LoRaMac.c on the virtual
+ *            radio and the virtual time
+ *
+ * \remark    One ABP end-device sends uplink cycles on AS923, the test network
+ *            server answers in RX1. The snapshot is rebuilt once for the
+ *            first uplink, then the rebuild count shall stay flat across
+ *            uplinks, downlinks and datarate changes, which are keyed per
+ *            datarate in the snapshot. It shall increment exactly once on
+ *            the next uplink after each invalidating event: a TxParamSetupReq
+ *            which changes the dwell times, a change of the repeater support
+ *            through the MIB, and a change of region. A TxParamSetupReq which
+ *            repeats the current dwell times does not invalidate it.
+ *
+ *            Usage: loramac_phy_cache_test [uplink cycles]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "LoRaMac.h"
+#include "LoRaMacTest.h"
+#include "radio_sim.h"
+#include "stm32_timer_if_sim.h"
+#include "lorawan_aes.h"
+#include "cmac.h"
+
+/*!
+ * Device address, application port of the test uplinks
+ */
+#define TEST_DEV_ADDR                               0x26011234
+#define TEST_PORT                                   2
+
+/*!
+ * Period of the uplink cycles [ms]
+ */
+#define TEST_UPLINK_PERIOD                          30000
+
+/*!
+ * Maximum number of time server events processed for one MAC request
+ */
+#define TEST_MAX_EVENTS                             100
+
+/*!
+ * Session keys, NwkSKey and AppSKey of LoRaWAN 1.0.x
+ */
+static const uint8_t NwkSKey[16] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                                     0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+static const uint8_t AppSKey[16] = { 0x3C, 0x4F, 0xCF, 0x09, 0x88, 0x15, 0xF7, 0xAB,
+                                     0xA6, 0xD2, 0xAE, 0x28, 0x16, 0x15, 0x7E, 0x2B };
+
+/*!
+ * Test network server state
+ */
+static struct
+{
+    uint32_t FCntDown;
+    uint32_t UplinksReceived;
+    uint32_t UplinksRejected;
+    uint8_t FOpts[15];
+    uint8_t FOptsSize;
+    uint8_t Downlink[32];
+    uint8_t DownlinkSize;
+    RadioSimParams_t Uplink;
+    bool Rx1;
+    uint32_t Downlinks;
+}Ns;
+
+static uint32_t McpsConfirms = 0;
+
+static void ComputeDataMic( uint8_t dir, uint32_t fCnt, const uint8_t* msg, uint16_t size, uint8_t* mic )
+{
+    AES_CMAC_CTX cmacCtx;
+    uint8_t digest[AES_CMAC_DIGEST_LENGTH];
+    uint8_t b0[16] = { 0x49, 0, 0, 0, 0, dir,
+                       TEST_DEV_ADDR & 0xFF, ( TEST_DEV_ADDR >> 8 ) & 0xFF, ( TEST_DEV_ADDR >> 16 ) & 0xFF, ( TEST_DEV_ADDR >> 24 ) & 0xFF,
+                       fCnt & 0xFF, ( fCnt >> 8 ) & 0xFF, ( fCnt >> 16 ) & 0xFF, ( fCnt >> 24 ) & 0xFF,
+                       0, ( uint8_t )size };
+
+    AES_CMAC_Init( &cmacCtx );
+    AES_CMAC_SetKey( &cmacCtx, NwkSKey );
+    AES_CMAC_Update( &cmacCtx, b0, 16 );
+    AES_CMAC_Update( &cmacCtx, msg, size );
+    AES_CMAC_Final( digest, &cmacCtx );
+    memcpy( mic, digest, 4 );
+}
+
+/*!
+ * \brief   Test network server: checks a data uplink and answers it, with the
+ *          pending MAC commands in FOpts
+ */
+static void NsOnDataUp( const uint8_t* payload, uint8_t size )
+{
+    uint8_t mic[4];
+    uint32_t fCnt = payload[6] | ( payload[7] << 8 );
+    uint8_t* frame = Ns.Downlink;
+    uint8_t n = 0;
+
+    ComputeDataMic( 0, fCnt, payload, size - 4, mic );
+    if( memcmp( mic, &payload[size - 4], 4 ) != 0 )
+    {
+        Ns.UplinksRejected++;
+        return;
+    }
+    Ns.UplinksReceived++;
+
+    frame[n++] = 0x60;
+    frame[n++] = TEST_DEV_ADDR & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 8 ) & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 16 ) & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 24 ) & 0xFF;
+    frame[n++] = Ns.FOptsSize;
+    frame[n++] = Ns.FCntDown & 0xFF;
+    frame[n++] = ( Ns.FCntDown >> 8 ) & 0xFF;
+    memcpy( &frame[n], Ns.FOpts, Ns.FOptsSize );
+    n += Ns.FOptsSize;
+    ComputeDataMic( 1, Ns.FCntDown, frame, n, &frame[n] );
+    Ns.FCntDown++;
+    Ns.DownlinkSize = n + 4;
+    Ns.FOptsSize = 0;
+}
+
+static void OnTxStart( const RadioSimParams_t* params, const uint8_t* payload, uint8_t size, uint32_t timeOnAir )
+{
+    Ns.Uplink = *params;
+    Ns.Rx1 = true;
+    Ns.DownlinkSize = 0;
+    NsOnDataUp( payload, size );
+}
+
+static void OnRxStart( const RadioSimParams_t* params, uint32_t window )
+{
+    // Answers in RX1: same channel and datarate as the uplink
+    if( ( Ns.Rx1 == true ) && ( Ns.DownlinkSize > 0 ) && ( params->Frequency == Ns.Uplink.Frequency ) &&
+        ( params->Datarate == Ns.Uplink.Datarate ) && ( params->IqInverted == true ) )
+    {
+        HOST_TEST_CHECK( RADIO_SIM_Deliver( params, Ns.Downlink, Ns.DownlinkSize, -60, 8 ) == true );
+        Ns.DownlinkSize = 0;
+        Ns.Downlinks++;
+    }
+    Ns.Rx1 = false;
+}
+
+static const RadioSimObserver_t Observer = { OnTxStart, OnRxStart };
+
+static void OnMcpsConfirm( McpsConfirm_t* mcpsConfirm )
+{
+    McpsConfirms++;
+}
+
+static void OnMcpsIndication( McpsIndication_t* mcpsIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+static void OnMlmeConfirm( MlmeConfirm_t* mlmeConfirm )
+{
+}
+
+static void OnMlmeIndication( MlmeIndication_t* mlmeIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+static LoRaMacPrimitives_t Primitives = { OnMcpsConfirm, OnMcpsIndication, OnMlmeConfirm, OnMlmeIndication };
+static LoRaMacCallback_t Callbacks = { 0 };
+
+/*!
+ * \brief   Runs the MAC and the virtual time until the MAC is idle
+ *
+ * \retval  true when the MAC went idle
+ */
+static bool RunUntilIdle( void )
+{
+    for( uint32_t i = 0; i < TEST_MAX_EVENTS; i++ )
+    {
+        LoRaMacProcess( );
+        if( LoRaMacIsBusy( ) == false )
+        {
+            return true;
+        }
+        if( TIMER_IF_SIM_RunNextEvent( ) == false )
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief   Initializes the MAC in a region and activates the ABP session
+ */
+static void Start( LoRaMacRegion_t region )
+{
+    MibRequestConfirm_t mibReq;
+
+    HOST_TEST_CHECK( LoRaMacInitialization( &Primitives, &Callbacks, region ) == LORAMAC_STATUS_OK );
+    mibReq.Type = MIB_NET_ID;
+    mibReq.Param.NetID = 0x000013;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_DEV_ADDR;
+    mibReq.Param.DevAddr = TEST_DEV_ADDR;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_NWK_S_KEY;
+    mibReq.Param.NwkSKey = ( uint8_t* )NwkSKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_APP_S_KEY;
+    mibReq.Param.AppSKey = ( uint8_t* )AppSKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_NETWORK_ACTIVATION;
+    mibReq.Param.NetworkActivation = ACTIVATION_TYPE_ABP;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = false;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    HOST_TEST_CHECK( LoRaMacStart( ) == LORAMAC_STATUS_OK );
+    Ns.FCntDown = 0;
+}
+
+/*!
+ * \brief   Sends one unconfirmed uplink and runs it through its RX windows
+ */
+static void Uplink( int8_t datarate )
+{
+    McpsReq_t mcpsReq;
+    uint32_t confirms = McpsConfirms;
+
+    TIMER_IF_SIM_Advance( TEST_UPLINK_PERIOD );
+    mcpsReq.Type = MCPS_UNCONFIRMED;
+    mcpsReq.Req.Unconfirmed.fPort = TEST_PORT;
+    mcpsReq.Req.Unconfirmed.fBuffer = "ping";
+    mcpsReq.Req.Unconfirmed.fBufferSize = 4;
+    mcpsReq.Req.Unconfirmed.Datarate = datarate;
+    HOST_TEST_CHECK( LoRaMacMcpsRequest( &mcpsReq, true ) == LORAMAC_STATUS_OK );
+    HOST_TEST_CHECK( RunUntilIdle( ) == true );
+    HOST_TEST_CHECK( McpsConfirms == ( confirms + 1 ) );
+}
+
+/*!
+ * \brief   Sends uplink cycles over the datarates and checks that the
+ *          snapshot is not rebuilt
+ */
+static void UplinksFlat( uint32_t cycles, int8_t minDatarate, int8_t maxDatarate )
+{
+    uint32_t rebuilds = LoRaMacTestGetPhyCacheRebuildCount( );
+    MibRequestConfirm_t mibReq;
+
+    for( uint32_t c = 0; c < cycles; c++ )
+    {
+        int8_t datarate = minDatarate + ( c % ( maxDatarate - minDatarate + 1 ) );
+
+        // Datarate of the MAC changed through the MIB, the uplink on another one
+        mibReq.Type = MIB_CHANNELS_DATARATE;
+        mibReq.Param.ChannelsDatarate = datarate;
+        HOST_TEST_CHECK( LoRaMacMibSetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK );
+        Uplink( maxDatarate - ( datarate - minDatarate ) );
+    }
+    HOST_TEST_CHECK( LoRaMacTestGetPhyCacheRebuildCount( ) == rebuilds );
+}
+
+/*!
+ * \brief   Queues a TxParamSetupReq for the next downlink, sends the uplink
+ *          which receives it and the uplink which follows
+ */
+static void TxParamSetup( uint8_t uplinkDwellTime, uint8_t downlinkDwellTime )
+{
+    Ns.FOpts[0] = SRV_MAC_TX_PARAM_SETUP_REQ;
+    // DownlinkDwellTime, UplinkDwellTime, MaxEIRP 16 dBm
+    Ns.FOpts[1] = ( downlinkDwellTime << 5 ) | ( uplinkDwellTime << 4 ) | 0x05;
+    Ns.FOptsSize = 2;
+    Uplink( DR_5 );
+    Uplink( DR_5 );
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t cycles = HostTestRuns( argc, argv, 20 );
+    uint32_t rebuilds;
+    MibRequestConfirm_t mibReq;
+
+    RADIO_SIM_SetObserver( &Observer );
+    RADIO_SIM_SetSeed( 42 );
+    UTIL_TIMER_Init( );
+    Start( LORAMAC_REGION_AS923 );
+
+    // The first uplink builds the snapshot
+    HOST_TEST_CHECK( LoRaMacTestGetPhyCacheRebuildCount( ) == 0 );
+    Uplink( DR_5 );
+    HOST_TEST_CHECK( LoRaMacTestGetPhyCacheRebuildCount( ) == 1 );
+    UplinksFlat( cycles, DR_2, DR_5 );
+
+    // TxParamSetupReq which changes the dwell times
+    rebuilds = LoRaMacTestGetPhyCacheRebuildCount( );
+    TxParamSetup( 0, 0 );
+    HOST_TEST_CHECK( LoRaMacTestGetPhyCacheRebuildCount( ) == ( rebuilds + 1 ) );
+    UplinksFlat( cycles, DR_0, DR_5 );
+    rebuilds = LoRaMacTestGetPhyCacheRebuildCount( );
+    TxParamSetup( 1, 0 );
+    HOST_TEST_CHECK( LoRaMacTestGetPhyCacheRebuildCount( ) == ( rebuilds + 1 ) );
+    UplinksFlat( cycles, DR_2, DR_5 );
+
+    // TxParamSetupReq which repeats the current dwell times
+    rebuilds = LoRaMacTestGetPhyCacheRebuildCount( );
+    TxParamSetup( 1, 0 );
+    HOST_TEST_CHECK( LoRaMacTestGetPhyCacheRebuildCount( ) == rebuilds );
+
+    // Repeater support set and cleared through the MIB
+    for( uint8_t i = 0; i < 2; i++ )
+    {
+        rebuilds = LoRaMacTestGetPhyCacheRebuildCount( );
+        mibReq.Type = MIB_REPEATER_SUPPORT;
+        mibReq.Param.EnableRepeaterSupport = ( i == 0 );
+        HOST_TEST_CHECK( LoRaMacMibSetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK );
+        Uplink( DR_5 );
+        HOST_TEST_CHECK( LoRaMacTestGetPhyCacheRebuildCount( ) == ( rebuilds + 1 ) );
+        UplinksFlat( cycles, DR_2, DR_5 );
+    }
+
+    HOST_TEST_CHECK( Ns.UplinksReceived == McpsConfirms );
+    HOST_TEST_CHECK( Ns.Downlinks == McpsConfirms );
+    printf( "AS923: %u uplinks, %u snapshot rebuilds\n", ( unsigned )McpsConfirms,
+            ( unsigned )LoRaMacTestGetPhyCacheRebuildCount( ) );
+
+    // Change of region: the MAC context starts over, one rebuild for the new region
+    HOST_TEST_CHECK( LoRaMacDeInitialization( ) == LORAMAC_STATUS_OK );
+    Start( LORAMAC_REGION_EU868 );
+    HOST_TEST_CHECK( LoRaMacTestGetPhyCacheRebuildCount( ) == 0 );
+    Uplink( DR_5 );
+    HOST_TEST_CHECK( LoRaMacTestGetPhyCacheRebuildCount( ) == 1 );
+    UplinksFlat( cycles, DR_0, DR_5 );
+    printf( "EU868: %u uplinks, %u snapshot rebuilds\n", ( unsigned )McpsConfirms,
+            ( unsigned )LoRaMacTestGetPhyCacheRebuildCount( ) );
+
+    HOST_TEST_CHECK( Ns.UplinksRejected == 0 );
+    return HOST_TEST_RESULT( );
+}
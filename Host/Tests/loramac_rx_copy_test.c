@@ -0,0 +1,298 @@
+/*!
+ * \file      loramac_rx_copy_test.c
+ *
+ * \brief     Test of the downlink buffer of LoRaMac.c: bytes copied per frame
+ *            and lifetime of McpsIndication.Buffer
+ *
+ * \remark    Feeds encrypted ABP downlinks on EU868 of several payload sizes,
+ *            with and without FOpts, to OnRadioRxDone, in class A and in
+ *            class C. memcpy1 is wrapped at link time to count the bytes
+ *            copied before the indication. In class A the frame is parsed
+ *            and decrypted in place: Buffer points into the radio buffer and
+ *            the copies do not depend on the payload size. In class C the
+ *            radio keeps listening: the radio buffer is overwritten between
+ *            the processing of the frame and the indication, which shall
+ *            still deliver the data from the copy of the MAC layer.
+ *
+ *            Usage: loramac_rx_copy_test [frames]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "lorawan_aes.h"
+#include "cmac.h"
+
+/*
+ * The processing of a frame and its indication are run apart through the
+ * private functions of LoRaMac.c
+ */
+#include "LoRaMac.c"
+
+/*!
+ * Device address, application port of the downlinks
+ */
+#define TEST_DEV_ADDR                               0x26011234
+#define TEST_PORT                                   2
+
+/*!
+ * Session keys, NwkSKey and AppSKey of LoRaWAN 1.0.x
+ */
+static const uint8_t NwkSKey[16] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                                     0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+static const uint8_t AppSKey[16] = { 0x3C, 0x4F, 0xCF, 0x09, 0x88, 0x15, 0xF7, 0xAB,
+                                     0xA6, 0xD2, 0xAE, 0x28, 0x16, 0x15, 0x7E, 0x2B };
+
+/*!
+ * Radio reception buffer
+ */
+static uint8_t RadioBuffer[LORAMAC_PHY_MAXPAYLOAD];
+
+static uint32_t Copied = 0;
+static uint32_t CopiedAtIndication = 0;
+
+/*!
+ * Last indication
+ */
+static struct
+{
+    uint32_t Count;
+    LoRaMacEventInfoStatus_t Status;
+    uint8_t Port;
+    bool InRadioBuffer;
+    uint8_t Size;
+    uint8_t Data[LORAMAC_PHY_MAXPAYLOAD];
+}Indication;
+
+void __real_memcpy1( uint8_t* dst, const uint8_t* src, uint16_t size );
+
+void __wrap_memcpy1( uint8_t* dst, const uint8_t* src, uint16_t size )
+{
+    Copied += size;
+    __real_memcpy1( dst, src, size );
+}
+
+static void ComputeDataMic( uint32_t fCnt, const uint8_t* msg, uint16_t size, uint8_t* mic )
+{
+    AES_CMAC_CTX cmacCtx;
+    uint8_t digest[AES_CMAC_DIGEST_LENGTH];
+    uint8_t b0[16] = { 0x49, 0, 0, 0, 0, 1,
+                       TEST_DEV_ADDR & 0xFF, ( TEST_DEV_ADDR >> 8 ) & 0xFF, ( TEST_DEV_ADDR >> 16 ) & 0xFF, ( TEST_DEV_ADDR >> 24 ) & 0xFF,
+                       fCnt & 0xFF, ( fCnt >> 8 ) & 0xFF, ( fCnt >> 16 ) & 0xFF, ( fCnt >> 24 ) & 0xFF,
+                       0, ( uint8_t )size };
+
+    AES_CMAC_Init( &cmacCtx );
+    AES_CMAC_SetKey( &cmacCtx, NwkSKey );
+    AES_CMAC_Update( &cmacCtx, b0, 16 );
+    AES_CMAC_Update( &cmacCtx, msg, size );
+    AES_CMAC_Final( digest, &cmacCtx );
+    memcpy( mic, digest, 4 );
+}
+
+static void CryptPayload( uint32_t fCnt, uint8_t* buffer, uint8_t size )
+{
+    lorawan_aes_context aesCtx;
+    uint8_t a[16] = { 0x01, 0, 0, 0, 0, 1,
+                      TEST_DEV_ADDR & 0xFF, ( TEST_DEV_ADDR >> 8 ) & 0xFF, ( TEST_DEV_ADDR >> 16 ) & 0xFF, ( TEST_DEV_ADDR >> 24 ) & 0xFF,
+                      fCnt & 0xFF, ( fCnt >> 8 ) & 0xFF, ( fCnt >> 16 ) & 0xFF, ( fCnt >> 24 ) & 0xFF, 0, 0 };
+    uint8_t s[16];
+
+    lorawan_aes_set_key( AppSKey, 16, &aesCtx );
+    for( uint8_t i = 0; i < size; i++ )
+    {
+        if( ( i & 0x0F ) == 0 )
+        {
+            a[15] = ( i >> 4 ) + 1;
+            lorawan_aes_encrypt( a, s, &aesCtx );
+        }
+        buffer[i] ^= s[i & 0x0F];
+    }
+}
+
+/*!
+ * \brief   Builds an unconfirmed downlink in the radio buffer, FOpts made of
+ *          LinkCheckAns
+ *
+ * \retval  Size of the frame
+ */
+static uint8_t BuildDownlink( uint32_t fCnt, uint8_t fOptsLen, const uint8_t* data, uint8_t size )
+{
+    uint8_t n = 0;
+
+    RadioBuffer[n++] = 0x60;
+    RadioBuffer[n++] = TEST_DEV_ADDR & 0xFF;
+    RadioBuffer[n++] = ( TEST_DEV_ADDR >> 8 ) & 0xFF;
+    RadioBuffer[n++] = ( TEST_DEV_ADDR >> 16 ) & 0xFF;
+    RadioBuffer[n++] = ( TEST_DEV_ADDR >> 24 ) & 0xFF;
+    RadioBuffer[n++] = fOptsLen;
+    RadioBuffer[n++] = fCnt & 0xFF;
+    RadioBuffer[n++] = ( fCnt >> 8 ) & 0xFF;
+    for( uint8_t i = 0; i < fOptsLen; i += 3 )
+    {
+        RadioBuffer[n++] = SRV_MAC_LINK_CHECK_ANS;
+        RadioBuffer[n++] = 20;
+        RadioBuffer[n++] = 1;
+    }
+    if( size > 0 )
+    {
+        RadioBuffer[n++] = TEST_PORT;
+        memcpy( &RadioBuffer[n], data, size );
+        CryptPayload( fCnt, &RadioBuffer[n], size );
+        n += size;
+    }
+    ComputeDataMic( fCnt, RadioBuffer, n, &RadioBuffer[n] );
+    return n + 4;
+}
+
+static void OnMcpsConfirm( McpsConfirm_t* mcpsConfirm )
+{
+}
+
+static void OnMcpsIndication( McpsIndication_t* mcpsIndication, LoRaMacRxStatus_t* rxStatus )
+{
+    CopiedAtIndication = Copied;
+    Indication.Count++;
+    Indication.Status = mcpsIndication->Status;
+    Indication.Port = mcpsIndication->Port;
+    Indication.Size = mcpsIndication->BufferSize;
+    Indication.InRadioBuffer = ( mcpsIndication->Buffer >= RadioBuffer ) &&
+                               ( mcpsIndication->Buffer < &RadioBuffer[sizeof( RadioBuffer )] );
+    if( mcpsIndication->Buffer != NULL )
+    {
+        memcpy( Indication.Data, mcpsIndication->Buffer, mcpsIndication->BufferSize );
+    }
+}
+
+static void OnMlmeConfirm( MlmeConfirm_t* mlmeConfirm )
+{
+}
+
+static void OnMlmeIndication( MlmeIndication_t* mlmeIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+static LoRaMacPrimitives_t Primitives = { OnMcpsConfirm, OnMcpsIndication, OnMlmeConfirm, OnMlmeIndication };
+static LoRaMacCallback_t Callbacks = { 0 };
+
+/*!
+ * \brief   Receives a frame of the radio buffer, then delivers its indication.
+ *          In class C the next frame overwrites the radio buffer in between.
+ */
+static void Receive( DeviceClass_t deviceClass, uint8_t size )
+{
+    Nvm.MacGroup2.DeviceClass = deviceClass;
+    MacCtx.RxSlot = ( deviceClass == CLASS_C ) ? RX_SLOT_WIN_CLASS_C : RX_SLOT_WIN_1;
+    MacCtx.MacState = LORAMAC_IDLE;
+    // Window opened at DR_5, which takes the largest frames
+    MacCtx.McpsIndication.RxDatarate = DR_5;
+    Indication.Count = 0;
+    Copied = 0;
+    CopiedAtIndication = 0;
+
+    OnRadioRxDone( RadioBuffer, size, -60, 8 );
+    LoRaMacHandleIrqEvents( );
+    if( deviceClass == CLASS_C )
+    {
+        memset( RadioBuffer, 0xA5, sizeof( RadioBuffer ) );
+    }
+    LoRaMacProcess( );
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbFrames = HostTestRuns( argc, argv, 1000 );
+    const uint8_t sizes[] = { 0, 1, 16, 51, 222 };
+    const uint8_t fOptsLens[] = { 0, 3, 15 };
+    uint32_t fCnt = 1;
+    MibRequestConfirm_t mibReq;
+
+    UTIL_TIMER_Init( );
+    HOST_TEST_CHECK( LoRaMacInitialization( &Primitives, &Callbacks, LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_OK );
+    mibReq.Type = MIB_NET_ID;
+    mibReq.Param.NetID = 0x000013;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_DEV_ADDR;
+    mibReq.Param.DevAddr = TEST_DEV_ADDR;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_NWK_S_KEY;
+    mibReq.Param.NwkSKey = ( uint8_t* )NwkSKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_APP_S_KEY;
+    mibReq.Param.AppSKey = ( uint8_t* )AppSKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_NETWORK_ACTIVATION;
+    mibReq.Param.NetworkActivation = ACTIVATION_TYPE_ABP;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    HOST_TEST_CHECK( LoRaMacStart( ) == LORAMAC_STATUS_OK );
+
+    for( uint8_t f = 0; f < sizeof( fOptsLens ); f++ )
+    {
+        uint32_t classACopied = 0;
+
+        for( uint8_t s = 0; s < sizeof( sizes ); s++ )
+        {
+            uint8_t size = sizes[s];
+            uint8_t data[LORAMAC_PHY_MAXPAYLOAD];
+            uint32_t copied[2] = { 0 };
+            double elapsed[2] = { 0 };
+
+            if( ( size + fOptsLens[f] ) > 242 )
+            {
+                continue;
+            }
+            for( uint8_t i = 0; i < size; i++ )
+            {
+                data[i] = ( uint8_t )( i * 7 + s );
+            }
+            for( uint32_t n = 0; n < nbFrames; n++ )
+            {
+                for( uint8_t c = 0; c < 2; c++ )
+                {
+                    DeviceClass_t deviceClass = ( c == 0 ) ? CLASS_A : CLASS_C;
+                    uint8_t frameSize = BuildDownlink( fCnt++, fOptsLens[f], data, size );
+                    double start = HostTestNow( );
+
+                    Receive( deviceClass, frameSize );
+                    elapsed[c] += HostTestNow( ) - start;
+                    copied[c] = CopiedAtIndication;
+
+                    HOST_TEST_CHECK( ( Indication.Count == 1 ) && ( Indication.Status == LORAMAC_EVENT_INFO_STATUS_OK ) );
+                    HOST_TEST_CHECK( Indication.Size == size );
+                    HOST_TEST_CHECK( memcmp( Indication.Data, data, size ) == 0 );
+                    if( size > 0 )
+                    {
+                        HOST_TEST_CHECK( Indication.Port == TEST_PORT );
+                        HOST_TEST_CHECK( Indication.InRadioBuffer == ( deviceClass == CLASS_A ) );
+                    }
+                    if( ( Indication.Count != 1 ) || ( memcmp( Indication.Data, data, size ) != 0 ) )
+                    {
+                        printf( "class %c, FOpts %u, payload %u: frame not delivered\n", ( c == 0 ) ? 'A' : 'C',
+                                fOptsLens[f], size );
+                        return HOST_TEST_RESULT( );
+                    }
+                }
+            }
+
+            // In class A the copies do not depend on the payload size, class C adds the frame
+            if( s == 1 )
+            {
+                classACopied = copied[0];
+            }
+            HOST_TEST_CHECK( ( s == 0 ) || ( copied[0] == classACopied ) );
+            HOST_TEST_CHECK( copied[1] == ( copied[0] + 8 + fOptsLens[f] + ( ( size > 0 ) ? ( 1 + size ) : 0 ) + 4 ) );
+            printf( "FOpts %2u, payload %3u: class A %3u bytes copied %.0f ns, class C %3u bytes copied %.0f ns\n",
+                    fOptsLens[f], size, copied[0], elapsed[0] / nbFrames, copied[1], elapsed[1] / nbFrames );
+        }
+    }
+
+    // A corrupted MIC is rejected in both classes
+    for( uint8_t c = 0; c < 2; c++ )
+    {
+        uint8_t frameSize = BuildDownlink( fCnt++, 0, ( const uint8_t* )"pong", 4 );
+
+        RadioBuffer[frameSize - 1] ^= 0x01;
+        Receive( ( c == 0 ) ? CLASS_A : CLASS_C, frameSize );
+        HOST_TEST_CHECK( MacCtx.McpsIndication.Status == LORAMAC_EVENT_INFO_STATUS_MIC_FAIL );
+        HOST_TEST_CHECK( ( Indication.Count == 0 ) || ( Indication.Status != LORAMAC_EVENT_INFO_STATUS_OK ) );
+    }
+
+    return HOST_TEST_RESULT( );
+}
@@ -0,0 +1,522 @@
+/*!
+ * \file      loramac_uplink_frame_test.c
+ *
+ * \brief     Byte-identity test of the uplink data frames assembled in place
+ *            in the radio buffer of LoRaMac.c
+ *
+ * \remark    Built once for each LoRaWAN version, on EU868 with ABP sessions.
+ *            Every frame put on the virtual radio is compared with a
+ *            reference frame built by the test from the frame layout of the
+ *            specification: MHDR, FHDR and FOpts, FPort, encrypted FRMPayload
+ *            and MIC. The uplinks cover application payloads of 0 to 242
+ *            bytes, MAC commands in FOpts, MAC commands in a port 0
+ *            FRMPayload, MAC commands too long for FOpts next to an
+ *            application payload (LORAMAC_STATUS_SKIPPED_APP_DATA: the
+ *            payload is sent without FOpts and the commands are dropped), and
+ *            the retransmissions of NbTrans 3, which shall resend the
+ *            encrypted payload and FOpts as is. The LoRaWAN 1.1 build runs a
+ *            1.0.4 session, FOpts in clear, and a 1.1.1 session, FOpts
+ *            encrypted and MIC made of the B1 and B0 CMACs.
+ *
+ *            Usage: loramac_uplink_frame_test [uplinks per case]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "LoRaMac.h"
+#include "LoRaMacTest.h"
+#include "LoRaMacCommands.h"
+#include "radio_sim.h"
+#include "stm32_timer_if_sim.h"
+#include "lorawan_aes.h"
+#include "cmac.h"
+
+/*!
+ * Device address of the test sessions
+ */
+#define TEST_DEV_ADDR                               0x26011234
+
+/*!
+ * Datarate of the uplinks, largest application payload at this datarate
+ */
+#define TEST_DATARATE                               DR_5
+#define TEST_MAX_PAYLOAD                            242
+
+/*!
+ * Largest FOpts field
+ */
+#define TEST_MAX_FOPTS                              15
+
+/*!
+ * Frames captured for one MAC request, NbTrans of the retransmission case
+ */
+#define TEST_MAX_FRAMES                             4
+#define TEST_NB_TRANS                               3
+
+/*!
+ * Maximum number of time server events processed for one MAC request
+ */
+#define TEST_MAX_EVENTS                             100
+
+/*!
+ * Session keys. NwkSEncKey is the NwkSKey of the 1.0.x sessions.
+ */
+static const uint8_t NwkSEncKey[16] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                                        0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+static const uint8_t AppSKey[16] = { 0x3C, 0x4F, 0xCF, 0x09, 0x88, 0x15, 0xF7, 0xAB,
+                                     0xA6, 0xD2, 0xAE, 0x28, 0x16, 0x15, 0x7E, 0x2B };
+#if ( LORAMAC_VERSION == 0x01010100 )
+static const uint8_t FNwkSIntKey[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                         0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF };
+static const uint8_t SNwkSIntKey[16] = { 0xFF, 0xEE, 0xDD, 0xCC, 0xBB, 0xAA, 0x99, 0x88,
+                                         0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00 };
+#endif
+
+/*!
+ * Uplink expected from the MAC, before encryption
+ */
+typedef struct
+{
+    uint32_t FCnt;
+    uint8_t FOpts[TEST_MAX_FOPTS];
+    uint8_t FOptsLen;
+    uint8_t Port;
+    uint8_t Payload[255];
+    uint8_t Size;
+}RefUplink_t;
+
+/*!
+ * Frames put on the virtual radio
+ */
+static struct
+{
+    uint8_t Frame[TEST_MAX_FRAMES][255];
+    uint8_t Size[TEST_MAX_FRAMES];
+    RadioSimParams_t Params[TEST_MAX_FRAMES];
+    uint8_t Count;
+}Tx;
+
+/*!
+ * LoRaWAN version of the session, frame counter of the last uplink
+ */
+static uint32_t SessionVersion = 0;
+static uint32_t FCntUp = 0;
+
+/*!
+ * MAC commands queued by the test and not sent yet, serialized
+ */
+static uint8_t Cmds[64];
+static uint8_t CmdsLen = 0;
+
+/*!
+ * Frames identical to their reference
+ */
+static uint32_t FramesIdentical = 0;
+
+static uint32_t Seed = 1;
+
+/*!
+ * \brief   Encrypts a buffer with the A blocks of the uplinks, numbered from
+ *          ctrStart
+ */
+static void CryptUplink( const uint8_t* key, uint8_t a4, uint8_t ctrStart, uint32_t fCnt, uint8_t* buffer, uint8_t size )
+{
+    lorawan_aes_context aesCtx;
+    uint8_t a[16] = { 0x01, 0, 0, 0, a4, 0,
+                      TEST_DEV_ADDR & 0xFF, ( TEST_DEV_ADDR >> 8 ) & 0xFF, ( TEST_DEV_ADDR >> 16 ) & 0xFF, ( TEST_DEV_ADDR >> 24 ) & 0xFF,
+                      fCnt & 0xFF, ( fCnt >> 8 ) & 0xFF, ( fCnt >> 16 ) & 0xFF, ( fCnt >> 24 ) & 0xFF, 0, 0 };
+    uint8_t s[16];
+
+    lorawan_aes_set_key( key, 16, &aesCtx );
+    for( uint8_t i = 0; i < size; i++ )
+    {
+        if( ( i & 0x0F ) == 0 )
+        {
+            a[15] = ctrStart + ( i >> 4 );
+            lorawan_aes_encrypt( a, s, &aesCtx );
+        }
+        buffer[i] ^= s[i & 0x0F];
+    }
+}
+
+/*!
+ * \brief   CMAC of a B0 or B1 block followed by the frame
+ */
+static void ComputeCmac( const uint8_t* key, const uint8_t* block, const uint8_t* msg, uint16_t size, uint8_t* digest )
+{
+    AES_CMAC_CTX cmacCtx;
+
+    AES_CMAC_Init( &cmacCtx );
+    AES_CMAC_SetKey( &cmacCtx, key );
+    AES_CMAC_Update( &cmacCtx, block, 16 );
+    AES_CMAC_Update( &cmacCtx, msg, size );
+    AES_CMAC_Final( digest, &cmacCtx );
+}
+
+/*!
+ * \brief   Builds the reference frame of an unconfirmed uplink
+ *
+ * \param [in] txDr     Datarate of the transmission, B1 block of LoRaWAN 1.1
+ * \param [in] txCh     Channel index of the transmission, B1 block of LoRaWAN 1.1
+ *
+ * \retval  Size of the frame
+ */
+static uint8_t BuildFrame( const RefUplink_t* up, uint8_t txDr, uint8_t txCh, uint8_t* frame )
+{
+    uint8_t digest[AES_CMAC_DIGEST_LENGTH];
+    uint8_t b0[16] = { 0x49, 0, 0, 0, 0, 0,
+                       TEST_DEV_ADDR & 0xFF, ( TEST_DEV_ADDR >> 8 ) & 0xFF, ( TEST_DEV_ADDR >> 16 ) & 0xFF, ( TEST_DEV_ADDR >> 24 ) & 0xFF,
+                       up->FCnt & 0xFF, ( up->FCnt >> 8 ) & 0xFF, ( up->FCnt >> 16 ) & 0xFF, ( up->FCnt >> 24 ) & 0xFF, 0, 0 };
+    uint8_t n = 0;
+
+    frame[n++] = FRAME_TYPE_DATA_UNCONFIRMED_UP << 5;
+    frame[n++] = TEST_DEV_ADDR & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 8 ) & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 16 ) & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 24 ) & 0xFF;
+    frame[n++] = up->FOptsLen;
+    frame[n++] = up->FCnt & 0xFF;
+    frame[n++] = ( up->FCnt >> 8 ) & 0xFF;
+    memcpy( &frame[n], up->FOpts, up->FOptsLen );
+#if ( LORAMAC_VERSION == 0x01010100 )
+    if( SessionVersion == 0x01010100 )
+    {
+        // LoRaWAN 1.1.1: one A block, numbered 1, with 0x01 in byte 4
+        CryptUplink( NwkSEncKey, 0x01, 1, up->FCnt, &frame[n], up->FOptsLen );
+    }
+#endif
+    n += up->FOptsLen;
+    if( up->Size > 0 )
+    {
+        frame[n++] = up->Port;
+        memcpy( &frame[n], up->Payload, up->Size );
+        CryptUplink( ( up->Port == 0 ) ? NwkSEncKey : AppSKey, 0, 1, up->FCnt, &frame[n], up->Size );
+        n += up->Size;
+    }
+
+    b0[15] = n;
+#if ( LORAMAC_VERSION == 0x01010100 )
+    if( SessionVersion == 0x01010100 )
+    {
+        uint8_t b1[16];
+
+        // MIC = cmacS[0..1] | cmacF[0..1]
+        memcpy( b1, b0, 16 );
+        b1[3] = txDr;
+        b1[4] = txCh;
+        ComputeCmac( SNwkSIntKey, b1, frame, n, digest );
+        memcpy( &frame[n], digest, 2 );
+        ComputeCmac( FNwkSIntKey, b0, frame, n, digest );
+        memcpy( &frame[n + 2], digest, 2 );
+        return n + 4;
+    }
+#endif
+    ComputeCmac( NwkSEncKey, b0, frame, n, digest );
+    memcpy( &frame[n], digest, 4 );
+    return n + 4;
+}
+
+static void OnTxStart( const RadioSimParams_t* params, const uint8_t* payload, uint8_t size, uint32_t timeOnAir )
+{
+    HOST_TEST_CHECK( Tx.Count < TEST_MAX_FRAMES );
+    if( Tx.Count < TEST_MAX_FRAMES )
+    {
+        memcpy( Tx.Frame[Tx.Count], payload, size );
+        Tx.Size[Tx.Count] = size;
+        Tx.Params[Tx.Count] = *params;
+        Tx.Count++;
+    }
+}
+
+static void OnRxStart( const RadioSimParams_t* params, uint32_t window )
+{
+}
+
+static const RadioSimObserver_t Observer = { OnTxStart, OnRxStart };
+
+static void OnMcpsConfirm( McpsConfirm_t* mcpsConfirm )
+{
+}
+
+static void OnMcpsIndication( McpsIndication_t* mcpsIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+static void OnMlmeConfirm( MlmeConfirm_t* mlmeConfirm )
+{
+}
+
+static void OnMlmeIndication( MlmeIndication_t* mlmeIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+static LoRaMacPrimitives_t Primitives = { OnMcpsConfirm, OnMcpsIndication, OnMlmeConfirm, OnMlmeIndication };
+static LoRaMacCallback_t Callbacks = { 0 };
+
+/*!
+ * \brief   Runs the MAC and the virtual time until the MAC is idle
+ *
+ * \retval  true when the MAC went idle
+ */
+static bool RunUntilIdle( void )
+{
+    for( uint32_t i = 0; i < TEST_MAX_EVENTS; i++ )
+    {
+        LoRaMacProcess( );
+        if( LoRaMacIsBusy( ) == false )
+        {
+            return true;
+        }
+        if( TIMER_IF_SIM_RunNextEvent( ) == false )
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief   Initializes the MAC on EU868 and activates an ABP session of the
+ *          given LoRaWAN version
+ */
+static void Start( uint32_t version )
+{
+    MibRequestConfirm_t mibReq;
+
+    HOST_TEST_CHECK( LoRaMacInitialization( &Primitives, &Callbacks, LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_OK );
+    mibReq.Type = MIB_ABP_LORAWAN_VERSION;
+    mibReq.Param.AbpLrWanVersion.Value = version;
+    HOST_TEST_CHECK( LoRaMacMibSetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK );
+    mibReq.Type = MIB_NET_ID;
+    mibReq.Param.NetID = 0x000013;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_DEV_ADDR;
+    mibReq.Param.DevAddr = TEST_DEV_ADDR;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+#if ( LORAMAC_VERSION == 0x01010100 )
+    mibReq.Type = MIB_F_NWK_S_INT_KEY;
+    mibReq.Param.FNwkSIntKey = ( uint8_t* )FNwkSIntKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_S_NWK_S_INT_KEY;
+    mibReq.Param.SNwkSIntKey = ( uint8_t* )SNwkSIntKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_NWK_S_ENC_KEY;
+    mibReq.Param.NwkSEncKey = ( uint8_t* )NwkSEncKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+#else
+    mibReq.Type = MIB_NWK_S_KEY;
+    mibReq.Param.NwkSKey = ( uint8_t* )NwkSEncKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+#endif
+    mibReq.Type = MIB_APP_S_KEY;
+    mibReq.Param.AppSKey = ( uint8_t* )AppSKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_NETWORK_ACTIVATION;
+    mibReq.Param.NetworkActivation = ACTIVATION_TYPE_ABP;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = false;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    HOST_TEST_CHECK( LoRaMacStart( ) == LORAMAC_STATUS_OK );
+    LoRaMacTestSetDutyCycleOn( false );
+
+    SessionVersion = version;
+    FCntUp = 0;
+    CmdsLen = 0;
+}
+
+/*!
+ * \brief   Sets the number of transmissions of the unconfirmed uplinks
+ */
+static void SetNbTrans( uint8_t nbTrans )
+{
+    MibRequestConfirm_t mibReq;
+
+    mibReq.Type = MIB_CHANNELS_NB_TRANS;
+    mibReq.Param.ChannelsNbTrans = nbTrans;
+    HOST_TEST_CHECK( LoRaMacMibSetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK );
+}
+
+/*!
+ * \brief   Queues MAC commands of the given serialized size: DevStatusAns,
+ *          completed with LinkCheckReq. Both are non-sticky.
+ */
+static void QueueCmds( uint8_t size )
+{
+    uint8_t payload[2];
+
+    while( size > 0 )
+    {
+        if( size >= 3 )
+        {
+            payload[0] = HostTestRand( &Seed ) & 0xFF;
+            payload[1] = HostTestRand( &Seed ) & 0x3F;
+            HOST_TEST_CHECK( LoRaMacCommandsAddCmd( MOTE_MAC_DEV_STATUS_ANS, payload, 2 ) == LORAMAC_COMMANDS_SUCCESS );
+            Cmds[CmdsLen++] = MOTE_MAC_DEV_STATUS_ANS;
+            Cmds[CmdsLen++] = payload[0];
+            Cmds[CmdsLen++] = payload[1];
+            size -= 3;
+        }
+        else
+        {
+            HOST_TEST_CHECK( LoRaMacCommandsAddCmd( MOTE_MAC_LINK_CHECK_REQ, payload, 0 ) == LORAMAC_COMMANDS_SUCCESS );
+            Cmds[CmdsLen++] = MOTE_MAC_LINK_CHECK_REQ;
+            size -= 1;
+        }
+    }
+}
+
+/*!
+ * \brief   Sends one unconfirmed uplink and compares every frame put on air
+ *          with its reference
+ *
+ * \param [in] nbFrames Frames expected on air, NbTrans
+ */
+static void Uplink( uint8_t port, uint8_t size, uint8_t nbFrames )
+{
+    McpsReq_t mcpsReq;
+    RefUplink_t ref;
+    uint8_t data[255];
+    uint8_t frame[255];
+
+    for( uint8_t i = 0; i < size; i++ )
+    {
+        data[i] = HostTestRand( &Seed ) & 0xFF;
+    }
+
+    // Reference frame of the baseline layout
+    memset( &ref, 0, sizeof( ref ) );
+    ref.FCnt = FCntUp + 1;
+    ref.Port = port;
+    if( ( size > 0 ) && ( CmdsLen <= TEST_MAX_FOPTS ) )
+    {
+        memcpy( ref.FOpts, Cmds, CmdsLen );
+        ref.FOptsLen = CmdsLen;
+    }
+    if( size > 0 )
+    {
+        // MAC commands too long for FOpts are dropped
+        memcpy( ref.Payload, data, size );
+        ref.Size = size;
+    }
+    else if( CmdsLen > 0 )
+    {
+        ref.Port = 0;
+        memcpy( ref.Payload, Cmds, CmdsLen );
+        ref.Size = CmdsLen;
+    }
+
+    Tx.Count = 0;
+    mcpsReq.Type = MCPS_UNCONFIRMED;
+    mcpsReq.Req.Unconfirmed.fPort = port;
+    mcpsReq.Req.Unconfirmed.fBuffer = ( size > 0 ) ? data : NULL;
+    mcpsReq.Req.Unconfirmed.fBufferSize = size;
+    mcpsReq.Req.Unconfirmed.Datarate = TEST_DATARATE;
+    if( ( ref.FOptsLen + ref.Size ) > TEST_MAX_PAYLOAD )
+    {
+        // The commands stay queued
+        HOST_TEST_CHECK( LoRaMacMcpsRequest( &mcpsReq, false ) == LORAMAC_STATUS_LENGTH_ERROR );
+        HOST_TEST_CHECK( Tx.Count == 0 );
+        return;
+    }
+    HOST_TEST_CHECK( LoRaMacMcpsRequest( &mcpsReq, false ) == LORAMAC_STATUS_OK );
+    HOST_TEST_CHECK( RunUntilIdle( ) == true );
+    HOST_TEST_CHECK( Tx.Count == nbFrames );
+
+    for( uint8_t i = 0; i < Tx.Count; i++ )
+    {
+        // EU868 default channels 868.1, 868.3 and 868.5 MHz, LoRa 125 kHz
+        uint8_t txCh = ( Tx.Params[i].Frequency - 868100000 ) / 200000;
+        uint8_t txDr = 12 - Tx.Params[i].Datarate;
+        uint8_t frameSize;
+
+        HOST_TEST_CHECK( txDr == TEST_DATARATE );
+        frameSize = BuildFrame( &ref, txDr, txCh, frame );
+        HOST_TEST_CHECK( Tx.Size[i] == frameSize );
+        HOST_TEST_CHECK( memcmp( Tx.Frame[i], frame, frameSize ) == 0 );
+        if( ( Tx.Size[i] == frameSize ) && ( memcmp( Tx.Frame[i], frame, frameSize ) == 0 ) )
+        {
+            FramesIdentical++;
+        }
+    }
+    FCntUp = ref.FCnt;
+    CmdsLen = 0;
+}
+
+/*!
+ * \brief   Runs the uplink cases on one session
+ */
+static void Session( uint32_t version, uint32_t runs )
+{
+    Start( version );
+
+    // Application payloads of 0 to 242 bytes, one more is rejected
+    for( uint16_t size = 0; size <= ( TEST_MAX_PAYLOAD + 1 ); size++ )
+    {
+        Uplink( 1 + ( size % 223 ), size, 1 );
+    }
+
+    for( uint32_t r = 0; r < runs; r++ )
+    {
+        uint8_t port = 1 + ( HostTestRand( &Seed ) % 223 );
+        uint8_t cmdsSize = 1 + ( HostTestRand( &Seed ) % TEST_MAX_FOPTS );
+
+        // MAC commands in FOpts, a payload one byte too long keeps them queued
+        QueueCmds( cmdsSize );
+        Uplink( port, TEST_MAX_PAYLOAD - cmdsSize + 1, 1 );
+        Uplink( port, TEST_MAX_PAYLOAD - cmdsSize, 1 );
+        QueueCmds( cmdsSize );
+        Uplink( port, 1 + ( HostTestRand( &Seed ) % ( TEST_MAX_PAYLOAD - cmdsSize ) ), 1 );
+        HOST_TEST_CHECK( CmdsLen == 0 );
+
+        // MAC commands in a port 0 FRMPayload, up to the FOpts size and over it
+        QueueCmds( cmdsSize );
+        Uplink( port, 0, 1 );
+        QueueCmds( TEST_MAX_FOPTS + cmdsSize );
+        Uplink( port, 0, 1 );
+
+        // MAC commands too long for FOpts next to an application payload
+        QueueCmds( TEST_MAX_FOPTS + cmdsSize );
+        Uplink( port, 1 + ( HostTestRand( &Seed ) % ( TEST_MAX_PAYLOAD - TEST_MAX_FOPTS - cmdsSize ) ), 1 );
+    }
+
+    // Retransmissions, with and without MAC commands
+    SetNbTrans( TEST_NB_TRANS );
+    for( uint32_t r = 0; r < runs; r++ )
+    {
+        uint8_t cmdsSize = 1 + ( HostTestRand( &Seed ) % TEST_MAX_FOPTS );
+
+        Uplink( 2, 1 + ( HostTestRand( &Seed ) % TEST_MAX_PAYLOAD ), TEST_NB_TRANS );
+        QueueCmds( cmdsSize );
+        Uplink( 2, 1 + ( HostTestRand( &Seed ) % ( TEST_MAX_PAYLOAD - cmdsSize ) ), TEST_NB_TRANS );
+        QueueCmds( cmdsSize );
+        Uplink( 2, 0, TEST_NB_TRANS );
+    }
+    if( version != 0x01010100 )
+    {
+        // Without the B1 block, the frame does not depend on the channel
+        HOST_TEST_CHECK( memcmp( Tx.Frame[0], Tx.Frame[1], Tx.Size[0] ) == 0 );
+        HOST_TEST_CHECK( memcmp( Tx.Frame[0], Tx.Frame[2], Tx.Size[0] ) == 0 );
+    }
+    SetNbTrans( 1 );
+
+    HOST_TEST_CHECK( LoRaMacDeInitialization( ) == LORAMAC_STATUS_OK );
+    printf( "LoRaWAN %u.%u.%u session: %u frames identical to the reference\n", ( unsigned )( version >> 24 ),
+            ( unsigned )( ( version >> 16 ) & 0xFF ), ( unsigned )( ( version >> 8 ) & 0xFF ), ( unsigned )FramesIdentical );
+    FramesIdentical = 0;
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t runs = HostTestRuns( argc, argv, 20 );
+
+    RADIO_SIM_SetObserver( &Observer );
+    RADIO_SIM_SetSeed( 42 );
+    UTIL_TIMER_Init( );
+
+    Session( 0x01000400, runs );
+#if ( LORAMAC_VERSION == 0x01010100 )
+    Session( 0x01010100, runs );
+#endif
+
+    return HOST_TEST_RESULT( );
+}
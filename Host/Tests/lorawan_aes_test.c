@@ -0,0 +1,167 @@
+/*!
+ * \file      lorawan_aes_test.c
+ *
+ * \brief     Known-answer tests and benchmark of lorawan_aes_encrypt
+ *
+ * \remark    Built once for each AES_T_TABLES option of lorawan_aes.c. Checks
+ *            the FIPS-197 and SP 800-38A vectors, checks random keys and
+ *            blocks against the decryption, whose rounds do not depend on
+ *            AES_T_TABLES, then times the encryption of a block.
+ *
+ *            Usage: lorawan_aes_test [blocks]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "lorawan_aes.h"
+
+#ifndef AES_T_TABLES
+#define AES_T_TABLES                                0
+#endif
+
+/*!
+ * Known-answer vector
+ */
+typedef struct sAesKat
+{
+    uint8_t KeySize;
+    uint8_t Key[32];
+    uint8_t Plain[16];
+    uint8_t Cipher[16];
+}AesKat_t;
+
+static const AesKat_t Kats[] =
+{
+    /* FIPS-197 appendix C.1, AES-128 */
+    {
+        16,
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F },
+        { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF },
+        { 0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A },
+    },
+    /* FIPS-197 appendix C.2, AES-192 */
+    {
+        24,
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+          0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 },
+        { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF },
+        { 0xDD, 0xA9, 0x7C, 0xA4, 0x86, 0x4C, 0xDF, 0xE0, 0x6E, 0xAF, 0x70, 0xA0, 0xEC, 0x0D, 0x71, 0x91 },
+    },
+    /* FIPS-197 appendix C.3, AES-256 */
+    {
+        32,
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+          0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F },
+        { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF },
+        { 0x8E, 0xA2, 0xB7, 0xCA, 0x51, 0x67, 0x45, 0xBF, 0xEA, 0xFC, 0x49, 0x90, 0x4B, 0x49, 0x60, 0x89 },
+    },
+    /* SP 800-38A F.1.1, ECB-AES128 block 1 */
+    {
+        16,
+        { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C },
+        { 0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A },
+        { 0x3A, 0xD7, 0x7B, 0xB4, 0x0D, 0x7A, 0x36, 0x60, 0xA8, 0x9E, 0xCA, 0xF3, 0x24, 0x66, 0xEF, 0x97 },
+    },
+    /* SP 800-38A F.1.1, ECB-AES128 block 4 */
+    {
+        16,
+        { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C },
+        { 0xF6, 0x9F, 0x24, 0x45, 0xDF, 0x4F, 0x9B, 0x17, 0xAD, 0x2B, 0x41, 0x7B, 0xE6, 0x6C, 0x37, 0x10 },
+        { 0x7B, 0x0C, 0x78, 0x5E, 0x27, 0xE8, 0xAD, 0x3F, 0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5D, 0xD4 },
+    },
+};
+
+/*!
+ * SP 800-38A F.2.1, CBC-AES128: IV and the first two blocks
+ */
+static const uint8_t CbcIv[16] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+};
+static const uint8_t CbcPlain[32] =
+{
+    0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+    0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51
+};
+static const uint8_t CbcCipher[32] =
+{
+    0x76, 0x49, 0xAB, 0xAC, 0x81, 0x19, 0xB2, 0x46, 0xCE, 0xE9, 0x8E, 0x9B, 0x12, 0xE9, 0x19, 0x7D,
+    0x50, 0x86, 0xCB, 0x9B, 0x50, 0x72, 0x19, 0xEE, 0x95, 0xDB, 0x11, 0x3A, 0x91, 0x76, 0x78, 0xB2
+};
+
+int main( int argc, char** argv )
+{
+    uint32_t nbBlocks = HostTestRuns( argc, argv, 200000 );
+    uint32_t seed = 0x41455331;
+    lorawan_aes_context ctx;
+    uint8_t key[32];
+    uint8_t in[16];
+    uint8_t out[16];
+    uint8_t back[16];
+    uint8_t iv[16];
+    uint8_t cbc[32];
+    double start;
+    double elapsed;
+
+    for( uint32_t i = 0; i < sizeof( Kats ) / sizeof( Kats[0] ); i++ )
+    {
+        HOST_TEST_CHECK( lorawan_aes_set_key( Kats[i].Key, Kats[i].KeySize, &ctx ) == 0 );
+        lorawan_aes_encrypt( Kats[i].Plain, out, &ctx );
+        HOST_TEST_CHECK( memcmp( out, Kats[i].Cipher, 16 ) == 0 );
+
+        /* In place */
+        memcpy( out, Kats[i].Plain, 16 );
+        lorawan_aes_encrypt( out, out, &ctx );
+        HOST_TEST_CHECK( memcmp( out, Kats[i].Cipher, 16 ) == 0 );
+
+        lorawan_aes_decrypt( Kats[i].Cipher, back, &ctx );
+        HOST_TEST_CHECK( memcmp( back, Kats[i].Plain, 16 ) == 0 );
+    }
+
+    HOST_TEST_CHECK( lorawan_aes_set_key( Kats[3].Key, 16, &ctx ) == 0 );
+    memcpy( iv, CbcIv, sizeof( iv ) );
+    lorawan_aes_cbc_encrypt( CbcPlain, cbc, 2, iv, &ctx );
+    HOST_TEST_CHECK( memcmp( cbc, CbcCipher, sizeof( cbc ) ) == 0 );
+
+    /* Random keys and blocks, unaligned buffers */
+    for( uint32_t n = 0; n < 10000; n++ )
+    {
+        uint8_t buffer[17];
+        uint8_t keySize = ( n % 3 == 0 ) ? 32 : 16;
+
+        for( uint32_t i = 0; i < keySize; i++ )
+        {
+            key[i] = ( uint8_t )HostTestRand( &seed );
+        }
+        for( uint32_t i = 0; i < 16; i++ )
+        {
+            in[i] = ( uint8_t )HostTestRand( &seed );
+        }
+        lorawan_aes_set_key( key, keySize, &ctx );
+        lorawan_aes_encrypt( in, &buffer[1], &ctx );
+        lorawan_aes_decrypt( &buffer[1], back, &ctx );
+        HOST_TEST_CHECK( memcmp( back, in, 16 ) == 0 );
+        HOST_TEST_CHECK( memcmp( &buffer[1], in, 16 ) != 0 );
+    }
+
+    /* Benchmark: chained blocks with a LoRaWAN session key */
+    lorawan_aes_set_key( Kats[3].Key, 16, &ctx );
+    memcpy( out, Kats[3].Plain, 16 );
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbBlocks; n++ )
+    {
+        lorawan_aes_encrypt( out, out, &ctx );
+    }
+    elapsed = HostTestNow( ) - start;
+    printf( "AES_T_TABLES %d: %u blocks, %.1f ns/block (%02X)\n", AES_T_TABLES, nbBlocks, elapsed / nbBlocks, out[0] );
+
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbBlocks / 10; n++ )
+    {
+        key[0] = ( uint8_t )n;
+        lorawan_aes_set_key( key, 16, &ctx );
+    }
+    elapsed = HostTestNow( ) - start;
+    printf( "AES_T_TABLES %d: %u key schedules, %.1f ns/key\n", AES_T_TABLES, nbBlocks / 10, elapsed / ( nbBlocks / 10 ) );
+
+    return HOST_TEST_RESULT( );
+}
@@ -0,0 +1,74 @@
+/*!
+ * \file      lorawan_sim_test.c
+ *
+ * \brief     Test of the LoRaWAN network simulator: sanity and reproducibility of a run
+ *
+ * \remark    Runs a small EU868 network twice with the same seed, and once
+ *            with another seed. The two first runs must give the same results.
+ *
+ *            Usage: lorawan_sim_test [end-devices]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "LoRaWanSim.h"
+
+/*!
+ * Simulated duration of a run [ms]
+ */
+#define TEST_DURATION                               ( 3 * 3600000UL )
+
+static void RunScenario( LoRaWanSimParams_t* params, LoRaWanSimStats_t* stats )
+{
+    memset( stats, 0, sizeof( LoRaWanSimStats_t ) );
+    HOST_TEST_CHECK( LoRaWanSimInit( params ) == LORAMAC_STATUS_OK );
+    LoRaWanSimRun( TEST_DURATION );
+    LoRaWanSimGetStats( stats );
+    LoRaWanSimDeInit( );
+}
+
+int main( int argc, char** argv )
+{
+    LoRaWanSimParams_t params =
+    {
+        .NbNodes = HostTestRuns( argc, argv, 50 ),
+        .Region = LORAMAC_REGION_EU868,
+        .Seed = 7,
+        .UplinkPeriod = 300000,
+        .AppDataSize = 12,
+        .ConfirmedRatio = 20,
+        .AdrEnabled = true,
+        .CellRadius = 300,
+        .Shadowing = 3,
+        .CaptureThreshold = 6,
+    };
+    LoRaWanSimStats_t first;
+    LoRaWanSimStats_t second;
+    LoRaWanSimStats_t other;
+
+    RunScenario( &params, &first );
+    RunScenario( &params, &second );
+    params.Seed = 8;
+    RunScenario( &params, &other );
+
+    printf( "%u end-devices: %u joined, %u frames sent, %u received, %u collided, %u confirmed (%u acked), "
+            "%u downlinks, %u LinkAdrReq\n",
+            params.NbNodes, first.NodesJoined, first.FramesSent, first.FramesReceived, first.FramesCollided,
+            first.ConfirmedUplinks, first.ConfirmedAcked, first.DownlinksReceived, first.LinkAdrReqs );
+
+    HOST_TEST_CHECK( first.SimTime == TEST_DURATION );
+    HOST_TEST_CHECK( first.NodesJoined == params.NbNodes );
+    HOST_TEST_CHECK( first.JoinAccepts >= params.NbNodes );
+    HOST_TEST_CHECK( first.FramesRejected == 0 );
+    HOST_TEST_CHECK( first.FramesReceived > first.JoinAccepts );
+    HOST_TEST_CHECK( first.FramesReceived + first.FramesCollided + first.FramesBelowSensitivity == first.FramesSent );
+    HOST_TEST_CHECK( first.AppBytesReceived > 0 );
+    HOST_TEST_CHECK( first.ConfirmedAcked > 0 );
+    HOST_TEST_CHECK( first.ConfirmedAcked <= first.ConfirmedUplinks );
+    HOST_TEST_CHECK( first.DownlinksReceived <= first.DownlinksSent );
+    HOST_TEST_CHECK( first.LinkAdrReqs > 0 );
+
+    // Same seed, same results
+    HOST_TEST_CHECK( memcmp( &first, &second, sizeof( first ) ) == 0 );
+    HOST_TEST_CHECK( memcmp( &first, &other, sizeof( first ) ) != 0 );
+    return HOST_TEST_RESULT( );
+}
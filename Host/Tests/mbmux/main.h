@@ -0,0 +1,16 @@
+/*!
+ * \file      main.h
+ *
+ * \brief     Host stub of the main.h of the dual-core projects
+ *
+ * \remark    Error_Handler is implemented by the test, it returns.
+ */
+#ifndef __MAIN_H__
+#define __MAIN_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+void Error_Handler( void );
+
+#endif /* __MAIN_H__ */
@@ -0,0 +1,16 @@
+/*!
+ * \file      radio_conf.h
+ *
+ * \brief     Host stub of the CM0PLUS radio_conf.h of the dual-core projects
+ */
+#ifndef __RADIO_CONF_H__
+#define __RADIO_CONF_H__
+
+#include "platform.h"
+
+/*!
+ * Size of the buffer of the received frames shared with CM4
+ */
+#define RADIO_RX_BUF_SIZE                           255
+
+#endif /* __RADIO_CONF_H__ */
@@ -0,0 +1,19 @@
+/*!
+ * \file      stm32wlxx_hal_ipcc.h
+ *
+ * \brief     Host stub of the IPCC HAL, for the MBMUX tables of the
+ *            dual-core projects
+ */
+#ifndef __STM32WLxx_HAL_IPCC_H
+#define __STM32WLxx_HAL_IPCC_H
+
+#include <stdint.h>
+
+#define __IO                                        volatile
+
+/*!
+ * Number of IPCC channels of the STM32WL
+ */
+#define IPCC_CHANNEL_NUMBER                         6U
+
+#endif /* __STM32WLxx_HAL_IPCC_H */
@@ -0,0 +1,14 @@
+/*!
+ * \file      sys_app.h
+ *
+ * \brief     Host stub of the sys_app.h of the dual-core projects: traces
+ *            are discarded
+ */
+#ifndef __SYS_APP_H__
+#define __SYS_APP_H__
+
+#include "main.h"
+
+#define APP_LOG( TS, VL, ... )
+
+#endif /* __SYS_APP_H__ */
@@ -0,0 +1,285 @@
+/*!
+ * \file      nvm_data_log_test.c
+ *
+ * \brief     Test of the NVM context log of NvmDataMgmt.c on a simulated flash
+ *
+ * \remark    Built once for each NVM_DATA_LOG_WRITE_SIZE option. Stores random
+ *            updates of the NVM groups and checks the context rebuilt after
+ *            each simulated reboot, then checks that a power loss during an
+ *            append or a compaction restores each group to its old or new
+ *            value, and that write and read errors are reported without
+ *            losing the modified groups.
+ *
+ *            Usage: nvm_data_log_test [stores]
+ */
+#include <stddef.h>
+#include <string.h>
+#include "host_test.h"
+#include "flash_sim.h"
+#include "LoRaMac.h"
+#include "NvmDataMgmt.h"
+
+#ifndef NVM_DATA_LOG_AREA_SIZE
+#define NVM_DATA_LOG_AREA_SIZE                      4096
+#endif
+
+#ifndef NVM_DATA_LOG_WRITE_SIZE
+#define NVM_DATA_LOG_WRITE_SIZE                     8
+#endif
+
+/*!
+ * Erase granularity of the STM32WL flash
+ */
+#define FLASH_PAGE_SIZE                             2048
+
+#define NB_GROUPS                                   7
+
+#define NVM_GROUP( group )                          { offsetof( LoRaMacNvmData_t, group ), sizeof( ( ( LoRaMacNvmData_t* )0 )->group ) }
+
+static const struct
+{
+    uint16_t Offset;
+    uint16_t Size;
+}Groups[NB_GROUPS] =
+{
+    NVM_GROUP( Crypto ),
+    NVM_GROUP( MacGroup1 ),
+    NVM_GROUP( MacGroup2 ),
+    NVM_GROUP( SecureElement ),
+    NVM_GROUP( RegionGroup1 ),
+    NVM_GROUP( RegionGroup2 ),
+    NVM_GROUP( ClassB ),
+};
+
+/*!
+ * Erase operations requested by the log, torn ones included
+ */
+static uint32_t EraseRequests = 0;
+
+static int32_t Erase( uint32_t offset, uint32_t size )
+{
+    EraseRequests++;
+    return FlashSimErase( offset, size );
+}
+
+static const NvmDataMgmtLogCallbacks_t Callbacks =
+{
+    .Read = FlashSimRead,
+    .Write = FlashSimWrite,
+    .Erase = Erase,
+};
+
+static LoRaMacNvmData_t Nvm;
+static LoRaMacNvmData_t Restored;
+static uint32_t Seed = 0x4E564D31;
+
+LoRaMacStatus_t LoRaMacStop( void )
+{
+    return LORAMAC_STATUS_OK;
+}
+
+LoRaMacStatus_t LoRaMacStart( void )
+{
+    return LORAMAC_STATUS_OK;
+}
+
+static bool GroupEqual( const LoRaMacNvmData_t* a, const LoRaMacNvmData_t* b, uint8_t index )
+{
+    return memcmp( ( const uint8_t* )a + Groups[index].Offset, ( const uint8_t* )b + Groups[index].Offset,
+                   Groups[index].Size ) == 0;
+}
+
+static bool ContextEqual( const LoRaMacNvmData_t* a, const LoRaMacNvmData_t* b )
+{
+    for( uint8_t i = 0; i < NB_GROUPS; i++ )
+    {
+        if( GroupEqual( a, b, i ) == false )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief   Modifies groups of the context, MacGroup1 is the most frequent as
+ *          it holds the frame counters
+ */
+static uint16_t Modify( LoRaMacNvmData_t* nvm )
+{
+    uint16_t flags = LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1;
+
+    if( ( HostTestRand( &Seed ) % 4 ) == 0 )
+    {
+        flags |= 1 << ( HostTestRand( &Seed ) % NB_GROUPS );
+    }
+    for( uint8_t i = 0; i < NB_GROUPS; i++ )
+    {
+        if( ( flags & ( 1 << i ) ) != 0 )
+        {
+            for( uint16_t k = 0; k < Groups[i].Size; k++ )
+            {
+                ( ( uint8_t* )nvm )[Groups[i].Offset + k] = ( uint8_t )HostTestRand( &Seed );
+            }
+        }
+    }
+    return flags;
+}
+
+/*!
+ * \brief   Store sequence of LmHandlerNvmDataStore
+ */
+static int32_t Store( LoRaMacNvmData_t* nvm, uint16_t flags )
+{
+    int32_t status;
+
+    NvmDataMgmtEvent( flags );
+    status = NvmDataMgmtStoreBegin( );
+    if( status != NVM_DATA_OK )
+    {
+        return status;
+    }
+    status = NvmDataMgmtStore( nvm );
+    NvmDataMgmtStoreEnd( );
+    return status;
+}
+
+/*!
+ * \brief   Restores the context into Restored, as done at startup
+ */
+static int32_t Reboot( void )
+{
+    FlashSimPowerOn( );
+    NvmDataMgmtLogInit( &Callbacks );
+    memset( &Restored, 0, sizeof( Restored ) );
+    return NvmDataMgmtRestore( &Restored );
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbStores = HostTestRuns( argc, argv, 2000 );
+    uint32_t appendLosses = 0;
+    uint32_t compactionLosses = 0;
+    uint32_t restoreReads;
+
+    FlashSimInit( 2 * NVM_DATA_LOG_AREA_SIZE, NVM_DATA_LOG_WRITE_SIZE, FLASH_PAGE_SIZE, 0x464C5348 );
+
+    NvmDataMgmtLogInit( NULL );
+    HOST_TEST_CHECK( NvmDataMgmtStore( &Nvm ) == NVM_DATA_DISABLED );
+    HOST_TEST_CHECK( NvmDataMgmtRestore( &Restored ) == NVM_DATA_DISABLED );
+
+    HOST_TEST_CHECK( Reboot( ) == NVM_DATA_NOT_AVAILABLE );
+    HOST_TEST_CHECK( NvmDataMgmtStoreBegin( ) == NVM_DATA_NO_UPDATED_DATA );
+
+    /* The first store writes the whole context */
+    Modify( &Nvm );
+    HOST_TEST_CHECK( Store( &Nvm, ( 1 << NB_GROUPS ) - 1 ) == NVM_DATA_OK );
+    HOST_TEST_CHECK( Reboot( ) == NVM_DATA_OK );
+    HOST_TEST_CHECK( ContextEqual( &Restored, &Nvm ) == true );
+
+    /* Stores of random updates */
+    FlashSimClearStats( );
+    for( uint32_t n = 0; n < nbStores; n++ )
+    {
+        HOST_TEST_CHECK( Store( &Nvm, Modify( &Nvm ) ) == NVM_DATA_OK );
+        if( ( n % 97 ) == 0 )
+        {
+            HOST_TEST_CHECK( Reboot( ) == NVM_DATA_OK );
+            HOST_TEST_CHECK( ContextEqual( &Restored, &Nvm ) == true );
+        }
+    }
+    printf( "NVM_DATA_LOG_WRITE_SIZE %d: %u stores, %.1f bytes programmed per store (context %u bytes), "
+            "%u area erases, %u erases of the most erased page\n",
+            NVM_DATA_LOG_WRITE_SIZE, nbStores, ( double )FlashSimStats.WrittenBytes / nbStores,
+            ( unsigned )sizeof( LoRaMacNvmData_t ), FlashSimStats.Erases, FlashSimStats.MaxPageErases );
+
+    HOST_TEST_CHECK( Reboot( ) == NVM_DATA_OK );
+    HOST_TEST_CHECK( ContextEqual( &Restored, &Nvm ) == true );
+
+    /* Power loss during a store: each group holds its old or its new value */
+    for( uint32_t n = 0; ( n < nbStores ) || ( compactionLosses < 10 ); n++ )
+    {
+        LoRaMacNvmData_t previous = Nvm;
+        uint16_t flags = Modify( &Nvm );
+        uint32_t erases = EraseRequests;
+        int32_t status;
+
+        FlashSimPowerFailAfter( HostTestRand( &Seed ) % 24 );
+        status = Store( &Nvm, flags );
+        if( FlashSimPowerLost( ) == false )
+        {
+            FlashSimPowerFailAfter( -1 );
+            HOST_TEST_CHECK( status == NVM_DATA_OK );
+            continue;
+        }
+
+        HOST_TEST_CHECK( status == NVM_DATA_ERROR );
+        if( EraseRequests != erases )
+        {
+            compactionLosses++;
+        }
+        else
+        {
+            appendLosses++;
+        }
+
+        HOST_TEST_CHECK( Reboot( ) == NVM_DATA_OK );
+        for( uint8_t i = 0; i < NB_GROUPS; i++ )
+        {
+            HOST_TEST_CHECK( ( GroupEqual( &Restored, &previous, i ) == true ) ||
+                             ( GroupEqual( &Restored, &Nvm, i ) == true ) );
+        }
+
+        /* Continue from the restored context */
+        Nvm = Restored;
+        HOST_TEST_CHECK( Store( &Nvm, Modify( &Nvm ) ) == NVM_DATA_OK );
+        HOST_TEST_CHECK( Reboot( ) == NVM_DATA_OK );
+        HOST_TEST_CHECK( ContextEqual( &Restored, &Nvm ) == true );
+    }
+    printf( "NVM_DATA_LOG_WRITE_SIZE %d: %u power losses during an append, %u during a compaction\n",
+            NVM_DATA_LOG_WRITE_SIZE, appendLosses, compactionLosses );
+    HOST_TEST_CHECK( appendLosses > 0 );
+
+    /* Write error: the modified groups are kept for the next store, which compacts the log */
+    for( uint32_t n = 0; n < 40; n++ )
+    {
+        FlashSimFailAfter( -1, n % 2 );
+        HOST_TEST_CHECK( Store( &Nvm, Modify( &Nvm ) ) == NVM_DATA_ERROR );
+        if( ( n % 4 ) == 3 )
+        {
+            /* Write error during the compaction */
+            FlashSimFailAfter( -1, HostTestRand( &Seed ) % ( 2 * NB_GROUPS ) );
+            HOST_TEST_CHECK( NvmDataMgmtStoreBegin( ) == NVM_DATA_OK );
+            HOST_TEST_CHECK( NvmDataMgmtStore( &Nvm ) == NVM_DATA_ERROR );
+            HOST_TEST_CHECK( NvmDataMgmtStoreEnd( ) == NVM_DATA_OK );
+        }
+        FlashSimFailAfter( -1, -1 );
+
+        HOST_TEST_CHECK( NvmDataMgmtStoreBegin( ) == NVM_DATA_OK );
+        HOST_TEST_CHECK( NvmDataMgmtStore( &Nvm ) == NVM_DATA_OK );
+        HOST_TEST_CHECK( NvmDataMgmtStoreEnd( ) == NVM_DATA_OK );
+        HOST_TEST_CHECK( NvmDataMgmtStoreBegin( ) == NVM_DATA_NO_UPDATED_DATA );
+
+        HOST_TEST_CHECK( Reboot( ) == NVM_DATA_OK );
+        HOST_TEST_CHECK( ContextEqual( &Restored, &Nvm ) == true );
+    }
+
+    /* Read error during the replay: the context is reported incomplete */
+    FlashSimClearStats( );
+    HOST_TEST_CHECK( Reboot( ) == NVM_DATA_OK );
+    restoreReads = FlashSimStats.Reads;
+    for( uint32_t reads = 0; reads < restoreReads; reads += 1 + restoreReads / 64 )
+    {
+        FlashSimFailAfter( reads, -1 );
+        HOST_TEST_CHECK( Reboot( ) == NVM_DATA_ERROR );
+        FlashSimFailAfter( -1, -1 );
+
+        /* The log is scanned again by the next store */
+        HOST_TEST_CHECK( Store( &Nvm, Modify( &Nvm ) ) == NVM_DATA_OK );
+        HOST_TEST_CHECK( Reboot( ) == NVM_DATA_OK );
+        HOST_TEST_CHECK( ContextEqual( &Restored, &Nvm ) == true );
+    }
+
+    HOST_TEST_CHECK( FlashSimStats.Violations == 0 );
+    return HOST_TEST_RESULT( );
+}
@@ -0,0 +1,538 @@
+/*!
+ * \file      radio_batch_test.c
+ *
+ * \brief     Test of the radio command batches of the dual-core MBMUX wrapper
+ *
+ * \remark    Links the CM4 radio_mbwrapper.c, which encodes the commands and
+ *            the batches, with the CM0PLUS radio_mbwrapper.c, which decodes
+ *            them, on a mock MBMUX and a mock radio. The CM0PLUS Radio is
+ *            renamed Cm0Radio at build time. The mock MBMUX executes a
+ *            command sent without waiting (MBMUXIF_RadioSendCmdAsync) only
+ *            when CM4 next waits for the com buffer, and checks that CM4 did
+ *            not write to the batch buffer meanwhile.
+ *
+ *            The PingPong sequences, run with and without batches, shall
+ *            give the same radio calls on CM0PLUS and the same return values
+ *            on CM4, with fewer IPCC commands. Batches larger than the batch
+ *            buffer are split. Then CM0PLUS shall stop a batch at the first
+ *            command returning a non-zero value, stop before a truncated
+ *            record, and reject a batch outside the shared memory, and CM4
+ *            shall detect the count mismatch of the executed commands.
+ *
+ *            The wrappers exchange the buffer addresses as 32-bit words: the
+ *            test is linked as a non-PIE program, with static buffers.
+ *
+ *            Usage: radio_batch_test [PingPong rounds]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "radio.h"
+#include "mbmux.h"
+#include "msg_id.h"
+#include "radio_mbwrapper.h"
+
+/*!
+ * Radio calls logged by the mock radio
+ */
+#define TEST_MAX_LOG                                512
+
+/*!
+ * Wake up time returned by the mock radio, RX timeout of the PingPong sequence
+ */
+#define TEST_WAKEUP_TIME                            3
+#define TEST_RX_TIMEOUT                             3000
+
+/*!
+ * Batch buffer of the CM4 wrapper, records made of a MsgId | ParamCnt << 16
+ * header word followed by ParamCnt parameters
+ */
+extern uint32_t aRadioBatchBuff[MAX_PARAM_OF_RADIO_BATCH_FUNCTIONS];
+
+/*!
+ * CM0PLUS entry point of the radio commands, see CM0PLUS/MbMux/radio_mbwrapper.h
+ */
+void Process_Radio_Cmd( MBMUX_ComParam_t *ComObj );
+
+/*!
+ * Radio call on CM0PLUS
+ */
+typedef struct
+{
+    uint32_t Id;
+    uint32_t Args[4];
+}RadioCall_t;
+
+/*!
+ * Radio calls on CM0PLUS
+ */
+static RadioCall_t Log[TEST_MAX_LOG];
+static uint32_t LogCnt = 0;
+
+/*!
+ * Status returned by the mock Radio.Send
+ */
+static radio_status_t SendStatus = RADIO_STATUS_OK;
+
+/*!
+ * Mock MBMUX: com buffer of the radio commands, IPCC commands sent by CM4,
+ * responses sent by CM0PLUS
+ */
+static uint32_t CmdBuff[MAX_PARAM_OF_RADIO_CMD_FUNCTIONS];
+static MBMUX_ComParam_t CmdComObj = { .BufSize = sizeof( CmdBuff ), .ParamBuf = CmdBuff };
+static uint32_t NotifBuff[MAX_PARAM_OF_RADIO_NOTIF_FUNCTIONS];
+static MBMUX_ComParam_t NotifComObj = { .BufSize = sizeof( NotifBuff ), .ParamBuf = NotifBuff };
+static uint32_t IpccCmds = 0;
+static uint32_t Responses = 0;
+
+/*!
+ * Command sent without waiting, not executed yet by CM0PLUS, and the batch
+ * buffer when it was sent
+ */
+static bool RespPending = false;
+static uint32_t PendingBatch[MAX_PARAM_OF_RADIO_BATCH_FUNCTIONS];
+
+/*!
+ * Alteration of the pending batch before its execution, batch buffer
+ * rejected by MBMUX_SEC_VerifySramBufferPtr
+ */
+static void ( *AlterBatch )( void ) = NULL;
+static bool RejectBatch = false;
+
+/*!
+ * Error_Handler calls of the wrappers
+ */
+static uint32_t Errors = 0;
+
+static void LogCall( uint32_t id, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3 )
+{
+    HOST_TEST_CHECK( LogCnt < TEST_MAX_LOG );
+    if( LogCnt < TEST_MAX_LOG )
+    {
+        Log[LogCnt].Id = id;
+        Log[LogCnt].Args[0] = a0;
+        Log[LogCnt].Args[1] = a1;
+        Log[LogCnt].Args[2] = a2;
+        Log[LogCnt].Args[3] = a3;
+        LogCnt++;
+    }
+}
+
+static void MockInit( RadioEvents_t *events )
+{
+    LogCall( RADIO_INIT_ID, 0, 0, 0, 0 );
+}
+
+static RadioState_t MockGetStatus( void )
+{
+    LogCall( RADIO_GET_STATUS_ID, 0, 0, 0, 0 );
+    return RF_RX_RUNNING;
+}
+
+static void MockSetChannel( uint32_t freq )
+{
+    LogCall( RADIO_SET_CHANNEL_ID, freq, 0, 0, 0 );
+}
+
+static uint32_t MockRandom( void )
+{
+    LogCall( RADIO_RANDOM_ID, 0, 0, 0, 0 );
+    return 0x12345678 + LogCnt;
+}
+
+static void MockSetRxConfig( RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                             uint32_t bandwidthAfc, uint16_t preambleLen, uint16_t symbTimeout, bool fixLen,
+                             uint8_t payloadLen, bool crcOn, bool freqHopOn, uint8_t hopPeriod,
+                             bool iqInverted, bool rxContinuous )
+{
+    LogCall( RADIO_SET_RX_CONFIG_ID, modem, bandwidth, datarate, ( symbTimeout << 16 ) | ( rxContinuous << 1 ) | iqInverted );
+}
+
+static void MockSetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev, uint32_t bandwidth, uint32_t datarate,
+                             uint8_t coderate, uint16_t preambleLen, bool fixLen, bool crcOn, bool freqHopOn,
+                             uint8_t hopPeriod, bool iqInverted, uint32_t timeout )
+{
+    LogCall( RADIO_SET_TX_CONFIG_ID, modem, ( uint8_t )power, datarate, timeout );
+}
+
+static radio_status_t MockSend( uint8_t *buffer, uint8_t size )
+{
+    LogCall( RADIO_SEND_ID, ( uint32_t )( uintptr_t )buffer, size, buffer[0], 0 );
+    return SendStatus;
+}
+
+static void MockSleep( void )
+{
+    LogCall( RADIO_SLEEP_ID, 0, 0, 0, 0 );
+}
+
+static void MockStandby( void )
+{
+    LogCall( RADIO_STANDBY_ID, 0, 0, 0, 0 );
+}
+
+static void MockRx( uint32_t timeout )
+{
+    LogCall( RADIO_RX_ID, timeout, 0, 0, 0 );
+}
+
+static void MockSetMaxPayloadLength( RadioModems_t modem, uint8_t max )
+{
+    LogCall( RADIO_SET_MAX_PAYLOAD_LENGTH_ID, modem, max, 0, 0 );
+}
+
+static uint32_t MockGetWakeupTime( void )
+{
+    LogCall( RADIO_GET_WAKEUP_TIME_ID, 0, 0, 0, 0 );
+    return TEST_WAKEUP_TIME;
+}
+
+/*!
+ * Radio driver of CM0PLUS
+ */
+const struct Radio_s Cm0Radio =
+{
+    .Init = MockInit,
+    .GetStatus = MockGetStatus,
+    .SetChannel = MockSetChannel,
+    .Random = MockRandom,
+    .SetRxConfig = MockSetRxConfig,
+    .SetTxConfig = MockSetTxConfig,
+    .Send = MockSend,
+    .Sleep = MockSleep,
+    .Standby = MockStandby,
+    .Rx = MockRx,
+    .SetMaxPayloadLength = MockSetMaxPayloadLength,
+    .GetWakeupTime = MockGetWakeupTime,
+};
+
+void Error_Handler( void )
+{
+    Errors++;
+}
+
+/*
+ * Mock MBMUX, CM4 side
+ */
+MBMUX_ComParam_t *MBMUXIF_GetRadioFeatureCmdComPtr( void )
+{
+    if( RespPending == true )
+    {
+        // CM0PLUS executes the command now, the batch buffer is unchanged
+        HOST_TEST_CHECK( memcmp( PendingBatch, aRadioBatchBuff, sizeof( PendingBatch ) ) == 0 );
+        if( AlterBatch != NULL )
+        {
+            AlterBatch( );
+            AlterBatch = NULL;
+        }
+        RespPending = false;
+        Process_Radio_Cmd( &CmdComObj );
+    }
+    return &CmdComObj;
+}
+
+void MBMUXIF_RadioSendCmd( void )
+{
+    IpccCmds++;
+    Process_Radio_Cmd( &CmdComObj );
+}
+
+void MBMUXIF_RadioSendCmdAsync( void )
+{
+    IpccCmds++;
+    memcpy( PendingBatch, aRadioBatchBuff, sizeof( PendingBatch ) );
+    RespPending = true;
+}
+
+uint32_t MBMUX_AcknowledgeSnd( FEAT_INFO_IdTypeDef e_featID )
+{
+    return 0;
+}
+
+/*
+ * Mock MBMUX, CM0PLUS side
+ */
+uint32_t *MBMUX_SEC_VerifySramBufferPtr( uint32_t *pBufferAddress, uint32_t bufferSize )
+{
+    const uint32_t *shared[] = { CmdBuff, aRadioBatchBuff };
+    const uint32_t sizes[] = { sizeof( CmdBuff ), sizeof( aRadioBatchBuff ) };
+
+    if( ( RejectBatch == true ) && ( pBufferAddress == aRadioBatchBuff ) )
+    {
+        return NULL;
+    }
+    for( uint8_t i = 0; i < 2; i++ )
+    {
+        if( ( ( uint8_t* )pBufferAddress >= ( const uint8_t* )shared[i] ) &&
+            ( ( ( uint8_t* )pBufferAddress + bufferSize ) <= ( ( const uint8_t* )shared[i] + sizes[i] ) ) )
+        {
+            return pBufferAddress;
+        }
+    }
+    return NULL;
+}
+
+uint32_t MBMUX_ResponseSnd( FEAT_INFO_IdTypeDef e_featID )
+{
+    Responses++;
+    return 0;
+}
+
+MBMUX_ComParam_t *MBMUXIF_GetRadioFeatureNotifComPtr( void )
+{
+    return &NotifComObj;
+}
+
+void MBMUXIF_RadioSendNotif( void )
+{
+}
+
+/*!
+ * Frames sent by the PingPong sequence
+ */
+static uint8_t Ping[4] = "PING";
+static uint8_t Pong[4] = "PONG";
+
+/*!
+ * Radio events of the CM4 application
+ */
+static RadioEvents_t Events;
+
+/*!
+ * \brief   Radio calls of the PingPong application on CM4: initialization,
+ *          then its PingPong_Process for the Send and the Rx transitions
+ *
+ * \param [in] batched  Calls grouped in batches as in the application
+ * \param [out] results Values returned on CM4, one per call returning a value
+ *
+ * \retval  Number of values returned
+ */
+static uint32_t PingPong( bool batched, uint32_t rounds, uint32_t* results )
+{
+    uint32_t n = 0;
+
+    Radio.Init( &Events );
+    results[n++] = Radio.Random( );
+    if( batched == true )
+    {
+        Radio_Batch_Start( );
+    }
+    Radio.SetChannel( 868000000 );
+    Radio.SetTxConfig( MODEM_LORA, 14, 0, 0, 7, 1, 8, false, true, 0, 0, false, 3000 );
+    Radio.SetRxConfig( MODEM_LORA, 0, 7, 1, 0, 8, 5, false, 0, true, 0, 0, false, true );
+    Radio.SetMaxPayloadLength( MODEM_LORA, 255 );
+    Radio.Rx( TEST_RX_TIMEOUT + 512 );
+    if( batched == true )
+    {
+        Radio_Batch_Send( );
+    }
+
+    for( uint32_t r = 0; r < rounds; r++ )
+    {
+        // Master: RX done, sends the next PING after the wake up time
+        if( batched == true )
+        {
+            Radio_Batch_Start( );
+        }
+        Radio.Sleep( );
+        results[n++] = Radio.GetWakeupTime( );
+        results[n++] = Radio.Send( ( r & 1 ) ? Pong : Ping, sizeof( Ping ) );
+        if( batched == true )
+        {
+            Radio_Batch_Send( );
+        }
+
+        // TX done: RX
+        if( batched == true )
+        {
+            Radio_Batch_Start( );
+        }
+        Radio.Sleep( );
+        Radio.Rx( TEST_RX_TIMEOUT + r );
+        if( batched == true )
+        {
+            Radio_Batch_Send( );
+        }
+    }
+    results[n++] = Radio.GetStatus( );
+    return n;
+}
+
+/*!
+ * \brief   PingPong sequences with and without batches
+ */
+static void CheckPingPong( uint32_t rounds )
+{
+    static RadioCall_t refLog[TEST_MAX_LOG];
+    static uint32_t refResults[TEST_MAX_LOG];
+    static uint32_t results[TEST_MAX_LOG];
+    uint32_t refLogCnt;
+    uint32_t refIpcc;
+    uint32_t n;
+
+    LogCnt = 0;
+    IpccCmds = 0;
+    Responses = 0;
+    n = PingPong( false, rounds, refResults );
+    memcpy( refLog, Log, sizeof( Log ) );
+    refLogCnt = LogCnt;
+    refIpcc = IpccCmds;
+    HOST_TEST_CHECK( Responses == IpccCmds );
+    HOST_TEST_CHECK( refLogCnt == refIpcc );
+
+    LogCnt = 0;
+    IpccCmds = 0;
+    Responses = 0;
+    HOST_TEST_CHECK( PingPong( true, rounds, results ) == n );
+    HOST_TEST_CHECK( RespPending == false );
+    HOST_TEST_CHECK( Responses == IpccCmds );
+    HOST_TEST_CHECK( LogCnt == refLogCnt );
+    HOST_TEST_CHECK( memcmp( Log, refLog, refLogCnt * sizeof( RadioCall_t ) ) == 0 );
+    HOST_TEST_CHECK( memcmp( results, refResults, n * sizeof( uint32_t ) ) == 0 );
+    // Init, Random, configuration batch, then 3 commands per round instead of 5
+    HOST_TEST_CHECK( IpccCmds == ( 3 + ( 3 * rounds ) + 1 ) );
+    HOST_TEST_CHECK( Errors == 0 );
+    printf( "PingPong, %u rounds: %u radio calls, %u IPCC commands unbatched, %u batched\n", ( unsigned )rounds,
+            ( unsigned )refLogCnt, ( unsigned )refIpcc, ( unsigned )IpccCmds );
+}
+
+/*!
+ * \brief   Waits for the response of the batch sent by Radio_Batch_Send, as
+ *          the next batch of the application: CM0PLUS executes the batch,
+ *          then CM4 checks the number of commands executed
+ */
+static void WaitBatch( void )
+{
+    Radio_Batch_Start( );
+    Radio_Batch_Send( );
+}
+
+/*!
+ * \brief   A batch is executed when CM4 next waits for the com buffer, a
+ *          batch larger than the batch buffer is split, an error status is
+ *          returned to CM4
+ */
+static void CheckBatches( void )
+{
+    uint32_t cmds = 0;
+
+    LogCnt = 0;
+    Radio_Batch_Start( );
+    Radio.Sleep( );
+    Radio.Rx( TEST_RX_TIMEOUT );
+    Radio_Batch_Send( );
+    HOST_TEST_CHECK( ( RespPending == true ) && ( LogCnt == 0 ) );
+    HOST_TEST_CHECK( Radio.GetStatus( ) == RF_RX_RUNNING );
+    HOST_TEST_CHECK( LogCnt == 3 );
+    HOST_TEST_CHECK( ( Log[0].Id == RADIO_SLEEP_ID ) && ( Log[1].Id == RADIO_RX_ID ) && ( Log[2].Id == RADIO_GET_STATUS_ID ) );
+
+    // SetTxConfig takes 13 parameters, 14 words
+    LogCnt = 0;
+    IpccCmds = 0;
+    Radio_Batch_Start( );
+    while( ( cmds * 14 ) <= ( 2 * MAX_PARAM_OF_RADIO_BATCH_FUNCTIONS ) )
+    {
+        Radio.SetTxConfig( MODEM_LORA, 14, 0, 0, 7 + ( cmds % 6 ), 1, 8, false, true, 0, 0, false, cmds );
+        cmds++;
+    }
+    Radio_Batch_Send( );
+    WaitBatch( );
+    HOST_TEST_CHECK( LogCnt == cmds );
+    for( uint32_t i = 0; i < LogCnt; i++ )
+    {
+        HOST_TEST_CHECK( ( Log[i].Id == RADIO_SET_TX_CONFIG_ID ) && ( Log[i].Args[3] == i ) );
+    }
+    HOST_TEST_CHECK( IpccCmds == ( ( cmds * 14 + MAX_PARAM_OF_RADIO_BATCH_FUNCTIONS - 1 ) / MAX_PARAM_OF_RADIO_BATCH_FUNCTIONS ) );
+
+    // The last command of a batch returns its status
+    LogCnt = 0;
+    SendStatus = RADIO_STATUS_ERROR;
+    Radio_Batch_Start( );
+    Radio.Sleep( );
+    HOST_TEST_CHECK( Radio.Send( Ping, sizeof( Ping ) ) == RADIO_STATUS_ERROR );
+    Radio_Batch_Send( );
+    HOST_TEST_CHECK( ( LogCnt == 2 ) && ( Log[1].Id == RADIO_SEND_ID ) );
+    SendStatus = RADIO_STATUS_OK;
+    HOST_TEST_CHECK( Errors == 0 );
+}
+
+static void FirstRecordReturnsValue( void )
+{
+    // Sleep has no parameter, like GetWakeupTime
+    aRadioBatchBuff[0] = ( aRadioBatchBuff[0] & 0xFFFF0000 ) | RADIO_GET_WAKEUP_TIME_ID;
+}
+
+static void LastRecordTruncated( void )
+{
+    // Sleep, Rx, then Standby given one parameter beyond the batch
+    aRadioBatchBuff[3] = aRadioBatchBuff[3] | ( 1 << 16 );
+}
+
+/*!
+ * \brief   Sends the batch Sleep, Rx, Standby, altered before its execution
+ *
+ * \retval  Number of commands executed by CM0PLUS
+ */
+static uint32_t SendAlteredBatch( void ( *alter )( void ), bool reject )
+{
+    uint32_t responses = Responses;
+    uint32_t cmdNb;
+
+    LogCnt = 0;
+    AlterBatch = alter;
+    RejectBatch = reject;
+    Radio_Batch_Start( );
+    Radio.Sleep( );
+    Radio.Rx( TEST_RX_TIMEOUT );
+    Radio.Standby( );
+    Radio_Batch_Send( );
+    WaitBatch( );
+    RejectBatch = false;
+    HOST_TEST_CHECK( Responses == ( responses + 1 ) );
+    cmdNb = ( CmdComObj.ParamCnt == 1 ) ? CmdComObj.ParamBuf[0] : 0;
+    HOST_TEST_CHECK( cmdNb == LogCnt );
+    return cmdNb;
+}
+
+/*!
+ * \brief   Batches not executed completely by CM0PLUS
+ */
+static void CheckErrors( void )
+{
+    // Stop at the first command returning a non-zero value
+    Errors = 0;
+    HOST_TEST_CHECK( SendAlteredBatch( FirstRecordReturnsValue, false ) == 1 );
+    HOST_TEST_CHECK( ( Log[0].Id == RADIO_GET_WAKEUP_TIME_ID ) && ( CmdComObj.ReturnVal == TEST_WAKEUP_TIME ) );
+    HOST_TEST_CHECK( Errors == 1 );
+
+    // Stop before a record which does not fit in the batch
+    Errors = 0;
+    HOST_TEST_CHECK( SendAlteredBatch( LastRecordTruncated, false ) == 2 );
+    HOST_TEST_CHECK( ( Log[0].Id == RADIO_SLEEP_ID ) && ( Log[1].Id == RADIO_RX_ID ) );
+    HOST_TEST_CHECK( Errors == 1 );
+
+    // Batch buffer rejected, no command executed
+    Errors = 0;
+    HOST_TEST_CHECK( SendAlteredBatch( NULL, true ) == 0 );
+    HOST_TEST_CHECK( CmdComObj.ReturnVal == 0xFFFFFFFF );
+    HOST_TEST_CHECK( Errors == 1 );
+
+    // The batch without alteration
+    Errors = 0;
+    HOST_TEST_CHECK( SendAlteredBatch( NULL, false ) == 3 );
+    HOST_TEST_CHECK( Errors == 0 );
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t rounds = HostTestRuns( argc, argv, 50 );
+
+    // The 32-bit buffer addresses exchanged by the wrappers
+    HOST_TEST_CHECK( ( uintptr_t )aRadioBatchBuff <= UINT32_MAX );
+    HOST_TEST_CHECK( ( uintptr_t )Ping <= UINT32_MAX );
+
+    CheckPingPong( ( rounds < 100 ) ? rounds : 100 );
+    CheckBatches( );
+    CheckErrors( );
+
+    return HOST_TEST_RESULT( );
+}
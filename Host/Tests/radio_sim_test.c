@@ -0,0 +1,424 @@
+/*!
+ * \file      radio_sim_test.c
+ *
+ * \brief     Smoke test of the LoRaMac stack on the virtual radio and the virtual time
+ *
+ * \remark    One end-device joins over the air on EU868, then sends uplink
+ *            cycles with the duty cycle enforced. The test plays the network
+ *            server from the observer of the virtual radio: it checks every
+ *            uplink, acknowledges the confirmed ones and answers every other
+ *            unconfirmed uplink in RX1.
+ *
+ *            Usage: radio_sim_test [uplink cycles]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "LoRaMac.h"
+#include "LoRaMacTest.h"
+#include "radio_sim.h"
+#include "stm32_timer_if_sim.h"
+#include "lorawan_aes.h"
+#include "cmac.h"
+
+/*!
+ * Network identifier and device address given by the test network server
+ */
+#define TEST_NET_ID                                 0x000013
+#define TEST_DEV_ADDR                               0x26011234
+
+/*!
+ * Application port of the test uplinks and downlinks
+ */
+#define TEST_PORT                                   2
+
+/*!
+ * Period of the uplink cycles [ms]
+ */
+#define TEST_UPLINK_PERIOD                          30000
+
+/*!
+ * Maximum number of time server events processed for one MAC request
+ */
+#define TEST_MAX_EVENTS                             100
+
+/*!
+ * Root key of the end-device, AppKey and NwkKey in LoRaWAN 1.0.x
+ */
+static const uint8_t RootKey[16] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                                     0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+
+/*!
+ * Test network server state
+ */
+static struct
+{
+    uint32_t JoinNonce;
+    uint8_t NwkSKey[16];
+    uint8_t AppSKey[16];
+    bool Joined;
+    uint32_t FCntUp;
+    uint32_t FCntDown;
+    uint32_t UplinksReceived;
+    uint32_t UplinksRejected;
+    bool Answer;
+    uint8_t Downlink[32];
+    uint8_t DownlinkSize;
+    RadioSimParams_t Uplink;
+    bool Rx1;
+}Ns;
+
+/*!
+ * End-device events
+ */
+static struct
+{
+    uint32_t JoinAccepted;
+    uint32_t McpsConfirms;
+    uint32_t Acked;
+    uint32_t Downlinks;
+    uint32_t BadDownlinks;
+}Dev;
+
+static void ComputeMic( const uint8_t* key, const uint8_t* b0, const uint8_t* msg, uint16_t size, uint8_t* mic )
+{
+    AES_CMAC_CTX cmacCtx;
+    uint8_t digest[AES_CMAC_DIGEST_LENGTH];
+
+    AES_CMAC_Init( &cmacCtx );
+    AES_CMAC_SetKey( &cmacCtx, key );
+    if( b0 != NULL )
+    {
+        AES_CMAC_Update( &cmacCtx, b0, 16 );
+    }
+    AES_CMAC_Update( &cmacCtx, msg, size );
+    AES_CMAC_Final( digest, &cmacCtx );
+    memcpy( mic, digest, 4 );
+}
+
+static void ComputeDataMic( uint8_t dir, uint32_t fCnt, const uint8_t* msg, uint16_t size, uint8_t* mic )
+{
+    uint8_t b0[16] = { 0x49, 0, 0, 0, 0, dir,
+                       TEST_DEV_ADDR & 0xFF, ( TEST_DEV_ADDR >> 8 ) & 0xFF, ( TEST_DEV_ADDR >> 16 ) & 0xFF, ( TEST_DEV_ADDR >> 24 ) & 0xFF,
+                       fCnt & 0xFF, ( fCnt >> 8 ) & 0xFF, ( fCnt >> 16 ) & 0xFF, ( fCnt >> 24 ) & 0xFF,
+                       0, ( uint8_t )size };
+
+    ComputeMic( Ns.NwkSKey, b0, msg, size, mic );
+}
+
+static void CryptPayload( uint8_t dir, uint32_t fCnt, uint8_t* buffer, uint8_t size )
+{
+    lorawan_aes_context aesCtx;
+    uint8_t a[16] = { 0x01, 0, 0, 0, 0, dir,
+                      TEST_DEV_ADDR & 0xFF, ( TEST_DEV_ADDR >> 8 ) & 0xFF, ( TEST_DEV_ADDR >> 16 ) & 0xFF, ( TEST_DEV_ADDR >> 24 ) & 0xFF,
+                      fCnt & 0xFF, ( fCnt >> 8 ) & 0xFF, ( fCnt >> 16 ) & 0xFF, ( fCnt >> 24 ) & 0xFF, 0, 0 };
+    uint8_t s[16];
+
+    lorawan_aes_set_key( Ns.AppSKey, 16, &aesCtx );
+    for( uint8_t i = 0; i < size; i++ )
+    {
+        if( ( i & 0x0F ) == 0 )
+        {
+            a[15] = ( i >> 4 ) + 1;
+            lorawan_aes_encrypt( a, s, &aesCtx );
+        }
+        buffer[i] ^= s[i & 0x0F];
+    }
+}
+
+/*!
+ * \brief   Test network server: answers a join-request with a join-accept
+ */
+static void NsOnJoinRequest( const uint8_t* payload, uint8_t size )
+{
+    lorawan_aes_context aesCtx;
+    uint8_t block[16];
+    uint8_t mic[4];
+    uint8_t* accept = Ns.Downlink;
+
+    ComputeMic( RootKey, NULL, payload, 19, mic );
+    if( ( size != 23 ) || ( memcmp( mic, &payload[19], 4 ) != 0 ) )
+    {
+        Ns.UplinksRejected++;
+        return;
+    }
+    Ns.JoinNonce++;
+    accept[0] = 0x20;
+    accept[1] = Ns.JoinNonce & 0xFF;
+    accept[2] = ( Ns.JoinNonce >> 8 ) & 0xFF;
+    accept[3] = ( Ns.JoinNonce >> 16 ) & 0xFF;
+    accept[4] = TEST_NET_ID & 0xFF;
+    accept[5] = ( TEST_NET_ID >> 8 ) & 0xFF;
+    accept[6] = ( TEST_NET_ID >> 16 ) & 0xFF;
+    accept[7] = TEST_DEV_ADDR & 0xFF;
+    accept[8] = ( TEST_DEV_ADDR >> 8 ) & 0xFF;
+    accept[9] = ( TEST_DEV_ADDR >> 16 ) & 0xFF;
+    accept[10] = ( TEST_DEV_ADDR >> 24 ) & 0xFF;
+    accept[11] = 0x00;  // DLSettings: RX1DRoffset 0, RX2 datarate 0
+    accept[12] = 0x01;  // RxDelay 1 s
+    ComputeMic( RootKey, NULL, accept, 13, &accept[13] );
+
+    // The network server encrypts the join-accept with an AES decrypt operation
+    lorawan_aes_set_key( RootKey, 16, &aesCtx );
+    lorawan_aes_decrypt( &accept[1], block, &aesCtx );
+    memcpy( &accept[1], block, 16 );
+    Ns.DownlinkSize = 17;
+
+    // 1.0.x session keys
+    for( uint8_t k = 0; k < 2; k++ )
+    {
+        memset( block, 0, sizeof( block ) );
+        block[0] = k + 1;
+        block[1] = Ns.JoinNonce & 0xFF;
+        block[2] = ( Ns.JoinNonce >> 8 ) & 0xFF;
+        block[3] = ( Ns.JoinNonce >> 16 ) & 0xFF;
+        block[4] = TEST_NET_ID & 0xFF;
+        block[5] = ( TEST_NET_ID >> 8 ) & 0xFF;
+        block[6] = ( TEST_NET_ID >> 16 ) & 0xFF;
+        block[7] = payload[17];
+        block[8] = payload[18];
+        lorawan_aes_encrypt( block, ( k == 0 ) ? Ns.NwkSKey : Ns.AppSKey, &aesCtx );
+    }
+    Ns.Joined = true;
+    Ns.FCntUp = 0;
+    Ns.FCntDown = 0;
+}
+
+/*!
+ * \brief   Test network server: checks a data uplink and prepares the answer
+ */
+static void NsOnDataUp( const uint8_t* payload, uint8_t size )
+{
+    uint8_t frame[64];
+    uint8_t mic[4];
+    uint8_t fOptsLen = payload[5] & 0x0F;
+    uint8_t portIndex = 8 + fOptsLen;
+    uint32_t fCnt = payload[6] | ( payload[7] << 8 );
+    bool confirmed = ( payload[0] & 0xE0 ) == 0x80;
+    uint8_t n = 0;
+
+    ComputeDataMic( 0, fCnt, payload, size - 4, mic );
+    if( ( Ns.Joined == false ) || ( memcmp( mic, &payload[size - 4], 4 ) != 0 ) ||
+        ( ( Ns.UplinksReceived > 0 ) && ( fCnt != ( ( Ns.FCntUp + 1 ) & 0xFFFF ) ) ) )
+    {
+        Ns.UplinksRejected++;
+        return;
+    }
+    Ns.UplinksReceived++;
+    Ns.FCntUp = fCnt;
+    if( ( size > portIndex + 4 ) && ( payload[portIndex] == TEST_PORT ) )
+    {
+        uint8_t data[16];
+        uint8_t dataSize = size - portIndex - 5;
+
+        memcpy( data, &payload[portIndex + 1], dataSize );
+        CryptPayload( 0, fCnt, data, dataSize );
+        if( ( dataSize != 4 ) || ( memcmp( data, "ping", 4 ) != 0 ) )
+        {
+            Ns.UplinksRejected++;
+        }
+    }
+    if( ( confirmed == false ) && ( Ns.Answer == false ) )
+    {
+        return;
+    }
+
+    frame[n++] = 0x60;
+    frame[n++] = TEST_DEV_ADDR & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 8 ) & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 16 ) & 0xFF;
+    frame[n++] = ( TEST_DEV_ADDR >> 24 ) & 0xFF;
+    frame[n++] = confirmed ? 0x20 : 0x00;
+    frame[n++] = Ns.FCntDown & 0xFF;
+    frame[n++] = ( Ns.FCntDown >> 8 ) & 0xFF;
+    if( Ns.Answer == true )
+    {
+        frame[n++] = TEST_PORT;
+        memcpy( &frame[n], "pong", 4 );
+        CryptPayload( 1, Ns.FCntDown, &frame[n], 4 );
+        n += 4;
+    }
+    ComputeDataMic( 1, Ns.FCntDown, frame, n, &frame[n] );
+    n += 4;
+    Ns.FCntDown++;
+    memcpy( Ns.Downlink, frame, n );
+    Ns.DownlinkSize = n;
+}
+
+static void OnTxStart( const RadioSimParams_t* params, const uint8_t* payload, uint8_t size, uint32_t timeOnAir )
+{
+    Ns.Uplink = *params;
+    Ns.Rx1 = true;
+    Ns.DownlinkSize = 0;
+    if( payload[0] == 0x00 )
+    {
+        NsOnJoinRequest( payload, size );
+    }
+    else
+    {
+        NsOnDataUp( payload, size );
+    }
+}
+
+static void OnRxStart( const RadioSimParams_t* params, uint32_t window )
+{
+    // Answers in RX1: same channel and datarate as the uplink
+    if( ( Ns.Rx1 == true ) && ( Ns.DownlinkSize > 0 ) && ( params->Frequency == Ns.Uplink.Frequency ) &&
+        ( params->Datarate == Ns.Uplink.Datarate ) && ( params->IqInverted == true ) )
+    {
+        HOST_TEST_CHECK( RADIO_SIM_Deliver( params, Ns.Downlink, Ns.DownlinkSize, -60, 8 ) == true );
+        Ns.DownlinkSize = 0;
+    }
+    Ns.Rx1 = false;
+}
+
+static const RadioSimObserver_t Observer = { OnTxStart, OnRxStart };
+
+static void OnMcpsConfirm( McpsConfirm_t* mcpsConfirm )
+{
+    Dev.McpsConfirms++;
+    if( mcpsConfirm->AckReceived == true )
+    {
+        Dev.Acked++;
+    }
+}
+
+static void OnMcpsIndication( McpsIndication_t* mcpsIndication, LoRaMacRxStatus_t* rxStatus )
+{
+    if( ( mcpsIndication->Status != LORAMAC_EVENT_INFO_STATUS_OK ) || ( mcpsIndication->RxData == false ) )
+    {
+        return;
+    }
+    if( ( mcpsIndication->Port == TEST_PORT ) && ( mcpsIndication->BufferSize == 4 ) &&
+        ( memcmp( mcpsIndication->Buffer, "pong", 4 ) == 0 ) )
+    {
+        Dev.Downlinks++;
+    }
+    else
+    {
+        Dev.BadDownlinks++;
+    }
+}
+
+static void OnMlmeConfirm( MlmeConfirm_t* mlmeConfirm )
+{
+    if( ( mlmeConfirm->MlmeRequest == MLME_JOIN ) && ( mlmeConfirm->Status == LORAMAC_EVENT_INFO_STATUS_OK ) )
+    {
+        Dev.JoinAccepted++;
+    }
+}
+
+static void OnMlmeIndication( MlmeIndication_t* mlmeIndication, LoRaMacRxStatus_t* rxStatus )
+{
+}
+
+static LoRaMacPrimitives_t Primitives = { OnMcpsConfirm, OnMcpsIndication, OnMlmeConfirm, OnMlmeIndication };
+static LoRaMacCallback_t Callbacks = { 0 };
+
+/*!
+ * \brief   Runs the MAC and the virtual time until the MAC is idle
+ *
+ * \retval  true when the MAC went idle
+ */
+static bool RunUntilIdle( void )
+{
+    for( uint32_t i = 0; i < TEST_MAX_EVENTS; i++ )
+    {
+        LoRaMacProcess( );
+        if( LoRaMacIsBusy( ) == false )
+        {
+            return true;
+        }
+        if( TIMER_IF_SIM_RunNextEvent( ) == false )
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t cycles = HostTestRuns( argc, argv, 200 );
+    uint8_t devEui[8] = { 0x00, 0x80, 0xE1, 0x15, 0x00, 0x00, 0x00, 0x01 };
+    uint8_t joinEui[8] = { 0 };
+    uint32_t confirmed = 0;
+    uint32_t answered = 0;
+    MibRequestConfirm_t mibReq;
+    MlmeReq_t mlmeReq;
+
+    RADIO_SIM_SetObserver( &Observer );
+    RADIO_SIM_SetSeed( 42 );
+    UTIL_TIMER_Init( );
+    HOST_TEST_CHECK( LoRaMacInitialization( &Primitives, &Callbacks, LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_OK );
+
+    mibReq.Type = MIB_DEV_EUI;
+    mibReq.Param.DevEui = devEui;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_JOIN_EUI;
+    mibReq.Param.JoinEui = joinEui;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_APP_KEY;
+    mibReq.Param.AppKey = ( uint8_t* )RootKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_NWK_KEY;
+    mibReq.Param.NwkKey = ( uint8_t* )RootKey;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = false;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    LoRaMacTestSetDutyCycleOn( true );
+    HOST_TEST_CHECK( LoRaMacStart( ) == LORAMAC_STATUS_OK );
+
+    // Over the air activation
+    mlmeReq.Type = MLME_JOIN;
+    mlmeReq.Req.Join.NetworkActivation = ACTIVATION_TYPE_OTAA;
+    mlmeReq.Req.Join.Datarate = DR_0;
+    mlmeReq.Req.Join.TxPower = TX_POWER_0;
+    HOST_TEST_CHECK( LoRaMacMlmeRequest( &mlmeReq ) == LORAMAC_STATUS_OK );
+    HOST_TEST_CHECK( RunUntilIdle( ) == true );
+    HOST_TEST_CHECK( Dev.JoinAccepted == 1 );
+    mibReq.Type = MIB_DEV_ADDR;
+    HOST_TEST_CHECK( ( LoRaMacMibGetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK ) && ( mibReq.Param.DevAddr == TEST_DEV_ADDR ) );
+
+    // Uplink cycles: one confirmed uplink out of four, an answer to every other unconfirmed one
+    for( uint32_t c = 0; c < cycles; c++ )
+    {
+        McpsReq_t mcpsReq;
+        bool isConfirmed = ( c % 4 ) == 3;
+
+        TIMER_IF_SIM_Advance( TEST_UPLINK_PERIOD );
+        Ns.Answer = ( isConfirmed == false ) && ( ( c % 2 ) == 0 );
+        answered += ( Ns.Answer == true ) ? 1 : 0;
+        confirmed += ( isConfirmed == true ) ? 1 : 0;
+        if( isConfirmed == true )
+        {
+            mcpsReq.Type = MCPS_CONFIRMED;
+            mcpsReq.Req.Confirmed.fPort = TEST_PORT;
+            mcpsReq.Req.Confirmed.fBuffer = "ping";
+            mcpsReq.Req.Confirmed.fBufferSize = 4;
+            mcpsReq.Req.Confirmed.Datarate = DR_5;
+        }
+        else
+        {
+            mcpsReq.Type = MCPS_UNCONFIRMED;
+            mcpsReq.Req.Unconfirmed.fPort = TEST_PORT;
+            mcpsReq.Req.Unconfirmed.fBuffer = "ping";
+            mcpsReq.Req.Unconfirmed.fBufferSize = 4;
+            mcpsReq.Req.Unconfirmed.Datarate = DR_5;
+        }
+        HOST_TEST_CHECK( LoRaMacMcpsRequest( &mcpsReq, true ) == LORAMAC_STATUS_OK );
+        HOST_TEST_CHECK( RunUntilIdle( ) == true );
+    }
+
+    printf( "joined %u, uplinks %u/%u (rejected %u), confirmed %u acked %u, downlinks %u/%u, simulated %u s\n",
+            ( unsigned )Dev.JoinAccepted, ( unsigned )Ns.UplinksReceived, ( unsigned )cycles,
+            ( unsigned )Ns.UplinksRejected, ( unsigned )confirmed, ( unsigned )Dev.Acked,
+            ( unsigned )Dev.Downlinks, ( unsigned )answered, ( unsigned )( TIMER_IF_SIM_GetTimerValue( ) / 1000 ) );
+    HOST_TEST_CHECK( Ns.UplinksReceived == cycles );
+    HOST_TEST_CHECK( Ns.UplinksRejected == 0 );
+    HOST_TEST_CHECK( Dev.McpsConfirms == cycles );
+    HOST_TEST_CHECK( Dev.Acked == confirmed );
+    HOST_TEST_CHECK( Dev.Downlinks == answered );
+    HOST_TEST_CHECK( Dev.BadDownlinks == 0 );
+    return HOST_TEST_RESULT( );
+}
@@ -0,0 +1,272 @@
+/*!
+ * \file      region_channels_test.c
+ *
+ * \brief     Test and benchmark of the channel selection of US915, AU915 and
+ *            CN470 from per-datarate channel bitmasks
+ *
+ * \remark    Takes the default channels of each region, then draws random
+ *            channels masks, datarates, band states, join masks and channel
+ *            changes. RegionCommonCountNbOfEnabledChannels with the bitmask of
+ *            RegionCommonChanDrMaskBuild shall give the channels, in the same
+ *            order, and the restricted channels count of the per-channel path.
+ *            The fully masked and the single channel masks, and the
+ *            datarates out of the range of the region, are drawn on purpose.
+ *            Then times both paths on the US915 sub-band 2.
+ *
+ *            Usage: region_channels_test [cases per region]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "utilities.h"
+#include "Region.h"
+#include "RegionNvm.h"
+#include "RegionCommon.h"
+#include "RegionUS915.h"
+#include "RegionAU915.h"
+#include "RegionCN470.h"
+
+#define MASK_SIZE                                   DIVC( REGION_NVM_MAX_NB_CHANNELS, 16 )
+
+/*!
+ * Regions tested and the range of their uplink datarates
+ */
+typedef struct sRegionUnderTest
+{
+    LoRaMacRegion_t Region;
+    const char* Name;
+    int8_t MinDatarate;
+    int8_t MaxDatarate;
+}RegionUnderTest_t;
+
+static const RegionUnderTest_t Regions[] =
+{
+    { LORAMAC_REGION_US915, "US915", US915_TX_MIN_DATARATE, US915_TX_MAX_DATARATE },
+    { LORAMAC_REGION_AU915, "AU915", AU915_TX_MIN_DATARATE, AU915_TX_MAX_DATARATE },
+    { LORAMAC_REGION_CN470, "CN470", CN470_TX_MIN_DATARATE, CN470_TX_MAX_DATARATE },
+};
+
+static RegionNvmDataGroup1_t NvmGroup1;
+static RegionNvmDataGroup2_t NvmGroup2;
+#if (defined( REGION_VERSION ) && (( REGION_VERSION == 0x02010001 ) || ( REGION_VERSION == 0x02010003 )))
+static Band_t RegionBands[REGION_NVM_MAX_NB_BANDS];
+#endif /* REGION_VERSION */
+static ChannelParams_t Channels[REGION_NVM_MAX_NB_CHANNELS];
+static Band_t Bands[REGION_NVM_MAX_NB_BANDS];
+static uint32_t Seed = 0x4348414E;
+
+/*!
+ * \brief   Default channels of a region
+ *
+ * \retval  Number of channels
+ */
+static uint16_t GetDefaultChannels( LoRaMacRegion_t region )
+{
+    InitDefaultsParams_t params = { 0 };
+    GetPhyParams_t getPhy = { 0 };
+    uint16_t nbChannels;
+
+    params.NvmGroup1 = &NvmGroup1;
+    params.NvmGroup2 = &NvmGroup2;
+#if (defined( REGION_VERSION ) && (( REGION_VERSION == 0x02010001 ) || ( REGION_VERSION == 0x02010003 )))
+    params.Bands = RegionBands;
+#endif /* REGION_VERSION */
+    params.Type = INIT_TYPE_DEFAULTS;
+    RegionInitDefaults( region, &params );
+
+    /* The NVM of the 2.x regions holds 72 channels, the CN470 plans use fewer than its 96 */
+    getPhy.Attribute = PHY_MAX_NB_CHANNELS;
+    nbChannels = MIN( RegionGetPhyParam( region, &getPhy ).Value, REGION_NVM_MAX_NB_CHANNELS );
+    getPhy.Attribute = PHY_CHANNELS;
+    memcpy( Channels, RegionGetPhyParam( region, &getPhy ).Channels, nbChannels * sizeof( ChannelParams_t ) );
+    return nbChannels;
+}
+
+/*!
+ * \brief   Random channels mask of nbChannels channels: fully masked, one
+ *          channel, all channels or random words
+ */
+static void DrawMask( uint16_t* mask, uint16_t nbChannels )
+{
+    uint32_t kind = HostTestRand( &Seed ) % 8;
+
+    for( uint8_t k = 0; k < MASK_SIZE; k++ )
+    {
+        mask[k] = ( kind == 0 ) ? 0 : ( kind == 1 ) ? 0xFFFF : ( uint16_t )HostTestRand( &Seed );
+        if( kind >= 5 )
+        {
+            /* Sparse */
+            mask[k] &= ( uint16_t )HostTestRand( &Seed );
+        }
+    }
+    if( kind == 2 )
+    {
+        uint16_t channel = HostTestRand( &Seed ) % nbChannels;
+
+        memset( mask, 0, MASK_SIZE * sizeof( uint16_t ) );
+        mask[channel / 16] = 1 << ( channel % 16 );
+    }
+    /* The regions never enable a channel above their number of channels, the
+       per-channel path would read past their channels */
+    for( uint16_t channel = nbChannels; channel < ( MASK_SIZE * 16 ); channel++ )
+    {
+        mask[channel / 16] &= ~( 1 << ( channel % 16 ) );
+    }
+}
+
+/*!
+ * \brief   Counts the enabled channels through both paths and compares them
+ *
+ * \retval  Number of enabled channels
+ */
+static uint8_t CompareCount( RegionCommonCountNbOfEnabledChannelsParams_t* params, uint16_t* datarateChannels )
+{
+    uint8_t enabledChannels[REGION_NVM_MAX_NB_CHANNELS];
+    uint8_t refEnabledChannels[REGION_NVM_MAX_NB_CHANNELS];
+    uint8_t nbEnabled = 0xFF;
+    uint8_t nbRestricted = 0xFF;
+    uint8_t refNbEnabled = 0xFE;
+    uint8_t refNbRestricted = 0xFE;
+
+    params->DatarateChannels = NULL;
+    RegionCommonCountNbOfEnabledChannels( params, refEnabledChannels, &refNbEnabled, &refNbRestricted );
+
+    RegionCommonChanDrMaskBuild( params->Channels, params->MaxNbChannels, params->Datarate, datarateChannels );
+    params->DatarateChannels = datarateChannels;
+    RegionCommonCountNbOfEnabledChannels( params, enabledChannels, &nbEnabled, &nbRestricted );
+
+    HOST_TEST_CHECK( nbEnabled == refNbEnabled );
+    HOST_TEST_CHECK( nbRestricted == refNbRestricted );
+    HOST_TEST_CHECK( memcmp( enabledChannels, refEnabledChannels, refNbEnabled ) == 0 );
+    return refNbEnabled;
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbCases = HostTestRuns( argc, argv, 70000 );
+    uint16_t channelsMask[MASK_SIZE];
+    uint16_t joinChannels[MASK_SIZE];
+    uint16_t datarateChannels[MASK_SIZE];
+    uint8_t enabledChannels[REGION_NVM_MAX_NB_CHANNELS];
+    uint8_t nbEnabled;
+    uint8_t nbRestricted;
+    RegionCommonCountNbOfEnabledChannelsParams_t params = { 0 };
+    double start;
+    double perChannel;
+    double bitmask;
+
+    for( uint8_t r = 0; r < ( sizeof( Regions ) / sizeof( Regions[0] ) ); r++ )
+    {
+        uint16_t nbChannels = GetDefaultChannels( Regions[r].Region );
+        uint32_t nbEmpty = 0;
+        uint32_t nbRestrictedCases = 0;
+
+        HOST_TEST_CHECK( ( nbChannels > 0 ) && ( nbChannels <= REGION_NVM_MAX_NB_CHANNELS ) );
+        params.Channels = Channels;
+        params.Bands = Bands;
+        params.MaxNbChannels = nbChannels;
+
+        /* Every channel of the default plan, masked one at a time */
+        for( int8_t dr = Regions[r].MinDatarate; dr <= Regions[r].MaxDatarate; dr++ )
+        {
+            memset( Bands, 0, sizeof( Bands ) );
+            Bands[0].ReadyForTransmission = true;
+            params.Joined = true;
+            params.Datarate = dr;
+            params.ChannelsMask = channelsMask;
+            params.JoinChannels = NULL;
+            for( uint16_t channel = 0; channel < nbChannels; channel++ )
+            {
+                memset( channelsMask, 0, sizeof( channelsMask ) );
+                channelsMask[channel / 16] = 1 << ( channel % 16 );
+                CompareCount( &params, datarateChannels );
+            }
+            memset( channelsMask, 0, sizeof( channelsMask ) );
+            HOST_TEST_CHECK( CompareCount( &params, datarateChannels ) == 0 );
+        }
+
+        for( uint32_t n = 0; n < nbCases; n++ )
+        {
+            if( ( n % 64 ) == 0 )
+            {
+                /* Back to the default plan, then change some channels as a new plan would */
+                GetDefaultChannels( Regions[r].Region );
+                for( uint16_t i = 0; ( ( n / 64 ) % 2 ) && ( i < nbChannels ); i++ )
+                {
+                    uint32_t change = HostTestRand( &Seed ) % 8;
+
+                    if( change == 0 )
+                    {
+                        Channels[i].Frequency = 0;
+                    }
+                    else if( change == 1 )
+                    {
+                        uint8_t min = HostTestRand( &Seed ) % 16;
+
+                        Channels[i].DrRange.Fields.Min = min;
+                        Channels[i].DrRange.Fields.Max = min + HostTestRand( &Seed ) % ( 16 - min );
+                    }
+                    else if( change == 2 )
+                    {
+                        Channels[i].Band = HostTestRand( &Seed ) % REGION_NVM_MAX_NB_BANDS;
+                    }
+                }
+            }
+            for( uint8_t i = 0; i < REGION_NVM_MAX_NB_BANDS; i++ )
+            {
+                Bands[i].ReadyForTransmission = ( HostTestRand( &Seed ) % 4 ) != 0;
+            }
+            DrawMask( channelsMask, nbChannels );
+            DrawMask( joinChannels, nbChannels );
+            params.Joined = ( HostTestRand( &Seed ) % 2 ) == 0;
+            params.JoinChannels = ( ( HostTestRand( &Seed ) % 2 ) == 0 ) ? joinChannels : NULL;
+            params.ChannelsMask = channelsMask;
+            /* Mostly the uplink datarates, sometimes one out of the range of the region */
+            params.Datarate = ( ( n % 16 ) == 0 ) ? ( HostTestRand( &Seed ) % 16 ) :
+                              ( Regions[r].MinDatarate + HostTestRand( &Seed ) % ( Regions[r].MaxDatarate - Regions[r].MinDatarate + 1 ) );
+
+            nbEmpty += ( CompareCount( &params, datarateChannels ) == 0 ) ? 1 : 0;
+            RegionCommonCountNbOfEnabledChannels( &params, enabledChannels, &nbEnabled, &nbRestricted );
+            nbRestrictedCases += ( nbRestricted > 0 ) ? 1 : 0;
+        }
+        printf( "%s: %u channels, %u cases, %u without channel, %u with restricted channels\n", Regions[r].Name,
+                nbChannels, nbCases, nbEmpty, nbRestrictedCases );
+        HOST_TEST_CHECK( ( nbEmpty > 0 ) && ( nbEmpty < nbCases ) && ( nbRestrictedCases > 0 ) );
+    }
+
+    /* Benchmark: US915 sub-band 2, DR_0, all the bands ready */
+    nbCases *= 10;
+    GetDefaultChannels( LORAMAC_REGION_US915 );
+    memset( channelsMask, 0, sizeof( channelsMask ) );
+    channelsMask[0] = 0xFF00;
+    channelsMask[4] = 0x0002;
+    memset( Bands, 0, sizeof( Bands ) );
+    Bands[0].ReadyForTransmission = true;
+    params.Joined = true;
+    params.Datarate = DR_0;
+    params.ChannelsMask = channelsMask;
+    params.JoinChannels = NULL;
+    params.MaxNbChannels = US915_MAX_NB_CHANNELS;
+    RegionCommonChanDrMaskBuild( Channels, US915_MAX_NB_CHANNELS, DR_0, datarateChannels );
+
+    params.DatarateChannels = NULL;
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbCases; n++ )
+    {
+        RegionCommonCountNbOfEnabledChannels( &params, enabledChannels, &nbEnabled, &nbRestricted );
+    }
+    perChannel = ( HostTestNow( ) - start ) / nbCases;
+    HOST_TEST_CHECK( nbEnabled == 8 );
+
+    params.DatarateChannels = datarateChannels;
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbCases; n++ )
+    {
+        RegionCommonCountNbOfEnabledChannels( &params, enabledChannels, &nbEnabled, &nbRestricted );
+    }
+    bitmask = ( HostTestNow( ) - start ) / nbCases;
+    HOST_TEST_CHECK( nbEnabled == 8 );
+
+    printf( "US915 sub-band 2: per channel %.1f ns/call, bitmask %.1f ns/call\n", perChannel, bitmask );
+
+    return HOST_TEST_RESULT( );
+}
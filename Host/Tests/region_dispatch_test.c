@@ -0,0 +1,106 @@
+/*!
+ * \file      region_dispatch_test.c
+ *
+ * \brief     Test and benchmark of the region dispatch of Region.c
+ *
+ * \remark    Built with EU868 alone, with and without
+ *            REGION_SINGLE_STATIC_DISPATCH, and with all the regions. Checks
+ *            that the Region* entry points return the values of the EU868
+ *            functions and that only the built regions are active, then
+ *            times a RegionGetPhyParam call against the direct call of
+ *            RegionEU868GetPhyParam. The size of Region.c in each build is
+ *            reported by the region_dispatch_size test.
+ *
+ *            Usage: region_dispatch_test [calls]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "Region.h"
+#include "RegionEU868.h"
+
+#ifndef REGION_SINGLE_STATIC_DISPATCH
+#define REGION_SINGLE_STATIC_DISPATCH               1
+#endif
+
+/*!
+ * EU868 attributes which do not depend on the region context
+ */
+static const PhyAttribute_t Attributes[] =
+{
+    PHY_MIN_RX_DR, PHY_MIN_TX_DR, PHY_DEF_TX_DR, PHY_MAX_TX_POWER, PHY_DEF_TX_POWER, PHY_DEF_ADR_ACK_LIMIT,
+    PHY_DEF_ADR_ACK_DELAY, PHY_MAX_PAYLOAD, PHY_DUTY_CYCLE, PHY_MAX_RX_WINDOW, PHY_RECEIVE_DELAY1,
+    PHY_RECEIVE_DELAY2, PHY_JOIN_ACCEPT_DELAY1, PHY_JOIN_ACCEPT_DELAY2, PHY_DEF_DR1_OFFSET, PHY_DEF_RX2_FREQUENCY,
+    PHY_DEF_RX2_DR, PHY_MAX_NB_CHANNELS, PHY_DEF_UPLINK_DWELL_TIME, PHY_DEF_MAX_EIRP, PHY_DEF_ANTENNA_GAIN,
+    PHY_SF_FROM_DR, PHY_BW_FROM_DR,
+};
+
+#define NB_ATTRIBUTES                               ( sizeof( Attributes ) / sizeof( Attributes[0] ) )
+
+int main( int argc, char** argv )
+{
+    uint32_t nbCalls = HostTestRuns( argc, argv, 10000000 );
+    GetPhyParams_t getPhy = { 0 };
+    volatile uint32_t sink = 0;
+    uint8_t nbActive = 0;
+    double start;
+    double dispatched;
+    double direct;
+
+    /* Only the built regions are active, whatever the dispatch */
+    for( LoRaMacRegion_t region = LORAMAC_REGION_AS923; region <= LORAMAC_REGION_RU864; region++ )
+    {
+        nbActive += ( RegionIsActive( region ) == true ) ? 1 : 0;
+    }
+    HOST_TEST_CHECK( RegionIsActive( LORAMAC_REGION_EU868 ) == true );
+#if defined( REGION_US915 )
+    HOST_TEST_CHECK( nbActive == 10 );
+#else
+    HOST_TEST_CHECK( nbActive == 1 );
+#endif
+
+    /* The dispatch returns the values of the region */
+    for( uint8_t i = 0; i < NB_ATTRIBUTES; i++ )
+    {
+        for( int8_t dr = DR_0; dr <= DR_7; dr++ )
+        {
+            PhyParam_t expected;
+            PhyParam_t phyParam;
+
+            getPhy.Attribute = Attributes[i];
+            getPhy.Datarate = dr;
+            expected = RegionEU868GetPhyParam( &getPhy );
+            phyParam = RegionGetPhyParam( LORAMAC_REGION_EU868, &getPhy );
+            HOST_TEST_CHECK( memcmp( &phyParam, &expected, sizeof( phyParam ) ) == 0 );
+        }
+    }
+    for( int8_t dr = DR_0; dr <= DR_7; dr++ )
+    {
+        for( int8_t drOffset = 0; drOffset <= 5; drOffset++ )
+        {
+            HOST_TEST_CHECK( RegionApplyDrOffset( LORAMAC_REGION_EU868, 0, dr, drOffset ) ==
+                             RegionEU868ApplyDrOffset( 0, dr, drOffset ) );
+        }
+    }
+
+    /* Benchmarks */
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbCalls; n++ )
+    {
+        getPhy.Attribute = ( ( n & 1 ) != 0 ) ? PHY_MAX_RX_WINDOW : PHY_RECEIVE_DELAY1;
+        sink += RegionGetPhyParam( LORAMAC_REGION_EU868, &getPhy ).Value;
+    }
+    dispatched = ( HostTestNow( ) - start ) / nbCalls;
+
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbCalls; n++ )
+    {
+        getPhy.Attribute = ( ( n & 1 ) != 0 ) ? PHY_MAX_RX_WINDOW : PHY_RECEIVE_DELAY1;
+        sink += RegionEU868GetPhyParam( &getPhy ).Value;
+    }
+    direct = ( HostTestNow( ) - start ) / nbCalls;
+
+    printf( "%u regions, REGION_SINGLE_STATIC_DISPATCH %d: RegionGetPhyParam %.2f ns/call, "
+            "RegionEU868GetPhyParam %.2f ns/call\n", nbActive, REGION_SINGLE_STATIC_DISPATCH, dispatched, direct );
+
+    return HOST_TEST_RESULT( );
+}
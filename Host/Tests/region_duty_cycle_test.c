@@ -0,0 +1,273 @@
+/*!
+ * \file      region_duty_cycle_test.c
+ *
+ * \brief     Deterministic test of the band duty cycle of RegionCommon.c
+ *
+ * \remark    Built once for the LoRaWAN 1.0.3 sliding window and once for the
+ *            1.0.4 observation window. Runs days of random uplinks on three
+ *            bands against a fake TimerGetCurrentTime, the join backoff
+ *            first, and checks each RegionCommonUpdateBandTimeOff call of the
+ *            joined device against a reference model of the band credits:
+ *            the ready bands and the returned time to wait. The clock starts
+ *            close to the 32-bit wrap, then counts the timer reads and times
+ *            the call.
+ *
+ *            Usage: region_duty_cycle_test [hours]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "radio.h"
+#include "stm32_systime.h"
+#include "RegionCommon.h"
+
+/*!
+ * Credits of a joined band and their observation period
+ */
+#if ( REGION_VERSION == 0x02010003 )
+#define MAX_TIME_CREDITS                            3600000
+#else
+#define MAX_TIME_CREDITS                            1800000
+#endif
+
+#define NB_BANDS                                    3
+
+/*!
+ * Hours before the join
+ */
+#define JOIN_HOURS                                  2
+
+/*!
+ * Fake time server [ms], started close to the wrap
+ */
+static TimerTime_t Now = 0xFFFFFFFF - 3600000;
+static TimerTime_t StartTime;
+static uint32_t TimerReads = 0;
+
+/*!
+ * Reference model of a joined band: credits at Time
+ */
+static struct
+{
+    TimerTime_t Credits;
+    TimerTime_t Time;
+}Model[NB_BANDS];
+
+static uint32_t Seed = 0x44435943;
+
+const struct Radio_s Radio;
+
+static void SysTimeDriverSet( uint32_t seconds )
+{
+    ( void )seconds;
+}
+
+static uint32_t SysTimeDriverGet( void )
+{
+    return 0;
+}
+
+static uint32_t SysTimeDriverGetTime( uint16_t* subSeconds )
+{
+    *subSeconds = 0;
+    return 0;
+}
+
+const UTIL_SYSTIM_Driver_s UTIL_SYSTIMDriver =
+{
+    SysTimeDriverSet, SysTimeDriverGet, SysTimeDriverSet, SysTimeDriverGet, SysTimeDriverGetTime,
+};
+
+uint32_t UTIL_TIMER_GetCurrentTime( void )
+{
+    TimerReads++;
+    return Now;
+}
+
+uint32_t UTIL_TIMER_GetElapsedTime( uint32_t past )
+{
+    TimerReads++;
+    return Now - past;
+}
+
+static SysTime_t Uptime( void )
+{
+    TimerTime_t uptime = Now - StartTime;
+    SysTime_t sysTime = { .Seconds = uptime / 1000, .SubSeconds = uptime % 1000 };
+
+    return sysTime;
+}
+
+/*!
+ * \brief   Credits of a band of the model at Now. The observation window is
+ *          refilled when it ends, as done by RegionCommonUpdateBandTimeOff.
+ */
+static TimerTime_t ModelCredits( uint8_t band )
+{
+    TimerTime_t elapsed = Now - Model[band].Time;
+
+#if ( REGION_VERSION == 0x02010003 )
+    if( elapsed >= MAX_TIME_CREDITS )
+    {
+        Model[band].Credits = MAX_TIME_CREDITS;
+        Model[band].Time = Now;
+    }
+    return Model[band].Credits;
+#else
+    return MIN( Model[band].Credits + elapsed, MAX_TIME_CREDITS );
+#endif
+}
+
+/*!
+ * \brief   Time to wait before a band of the model has the credits of a
+ *          transmission
+ */
+static TimerTime_t ModelTimeToWait( uint8_t band, TimerTime_t credits, TimerTime_t costs )
+{
+#if ( REGION_VERSION == 0x02010003 )
+    ( void )credits;
+    ( void )costs;
+    return MAX_TIME_CREDITS - ( Now - Model[band].Time );
+#else
+    ( void )band;
+    return costs - credits;
+#endif
+}
+
+static void ModelTxDone( uint8_t band, TimerTime_t costs )
+{
+    TimerTime_t credits = ModelCredits( band );
+
+#if ( REGION_VERSION != 0x02010003 )
+    /* The sliding window collects the credits of the band before spending them */
+    Model[band].Time = Now;
+#endif
+    Model[band].Credits = ( credits > costs ) ? ( credits - costs ) : 0;
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t hours = HostTestRuns( argc, argv, 96 );
+    Band_t bands[NB_BANDS] =
+    {
+        { .DCycle = 100 },
+        { .DCycle = 1000 },
+        { .DCycle = 10 },
+    };
+    TimerTime_t airTime[NB_BANDS] = { 0 };
+    TimerTime_t joinTime;
+    uint32_t trace = 5381;
+    uint32_t nbTx = 0;
+    uint32_t nbCalls = 0;
+    uint32_t nbChecks = 0;
+    uint32_t reads;
+    bool joined = false;
+    double start;
+    double elapsed;
+
+    StartTime = Now;
+    joinTime = StartTime + JOIN_HOURS * 3600000;
+
+    while( ( Now - StartTime ) < hours * 3600000 )
+    {
+        TimerTime_t timeOnAir = 50 + HostTestRand( &Seed ) % 1400;
+        TimerTime_t timeToWait;
+        uint8_t ready[NB_BANDS];
+        uint8_t nbReady = 0;
+
+        if( ( joined == false ) && ( ( Now - StartTime ) >= ( joinTime - StartTime ) ) )
+        {
+            joined = true;
+            RegionCommonUpdateBandTimeOff( joined, bands, NB_BANDS, true, false, Uptime( ), timeOnAir );
+            for( uint8_t i = 0; i < NB_BANDS; i++ )
+            {
+                HOST_TEST_CHECK( bands[i].MaxTimeCredits == MAX_TIME_CREDITS );
+                Model[i].Credits = bands[i].TimeCredits;
+                Model[i].Time = bands[i].LastBandUpdateTime;
+            }
+        }
+
+        timeToWait = RegionCommonUpdateBandTimeOff( joined, bands, NB_BANDS, true, joined == false, Uptime( ), timeOnAir );
+        nbCalls++;
+
+        if( joined == true )
+        {
+            TimerTime_t expectedTimeToWait = TIMERTIME_T_MAX;
+            uint8_t validBands = 0;
+
+            for( uint8_t i = 0; i < NB_BANDS; i++ )
+            {
+                TimerTime_t costs = timeOnAir * bands[i].DCycle;
+                TimerTime_t credits = ModelCredits( i );
+                bool isReady = credits > costs;
+
+                HOST_TEST_CHECK( bands[i].ReadyForTransmission == isReady );
+                if( isReady == true )
+                {
+                    validBands++;
+                }
+                else if( MAX_TIME_CREDITS > costs )
+                {
+                    validBands++;
+                    expectedTimeToWait = MIN( expectedTimeToWait, ModelTimeToWait( i, credits, costs ) );
+                }
+            }
+            HOST_TEST_CHECK( timeToWait == ( ( validBands == 0 ) ? TIMERTIME_T_MAX : expectedTimeToWait ) );
+            nbChecks++;
+        }
+
+        for( uint8_t i = 0; i < NB_BANDS; i++ )
+        {
+            if( bands[i].ReadyForTransmission == true )
+            {
+                ready[nbReady++] = i;
+            }
+        }
+        if( nbReady > 0 )
+        {
+            uint8_t band = ready[HostTestRand( &Seed ) % nbReady];
+
+            trace = ( trace * 33 ) ^ ( band + ( Now - StartTime ) * 7 + timeOnAir * 13 );
+            Now += timeOnAir;
+            RegionCommonSetBandTxDone( &bands[band], timeOnAir, joined, Uptime( ) );
+            if( joined == true )
+            {
+                ModelTxDone( band, timeOnAir * bands[band].DCycle );
+                airTime[band] += timeOnAir;
+            }
+            nbTx++;
+            Now += 1000 + HostTestRand( &Seed ) % 3000;
+        }
+        else if( ( timeToWait == TIMERTIME_T_MAX ) || ( timeToWait > 60000 ) )
+        {
+            Now += 1000 + HostTestRand( &Seed ) % 5000;
+        }
+        else
+        {
+            /* Retry right when the band is expected to be ready, or earlier */
+            Now += ( ( HostTestRand( &Seed ) % 2 ) == 0 ) ? ( timeToWait + 1 ) : ( 1 + HostTestRand( &Seed ) % 2000 );
+        }
+    }
+
+    printf( "REGION_VERSION 0x%08X: %u transmissions, %u calls, %u checked, trace %08X\n", REGION_VERSION, nbTx,
+            nbCalls, nbChecks, trace );
+    for( uint8_t i = 0; i < NB_BANDS; i++ )
+    {
+        printf( "  band 1/%u: %.3f%% of the joined time on air\n", bands[i].DCycle,
+                100.0 * airTime[i] / ( Now - joinTime ) );
+    }
+    HOST_TEST_CHECK( nbChecks > 0 );
+
+    /* Scheduling attempts of a joined device, the bands under pressure */
+    reads = TimerReads;
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < hours * 10000; n++ )
+    {
+        RegionCommonUpdateBandTimeOff( true, bands, NB_BANDS, true, false, Uptime( ), 3000 );
+        Now++;
+    }
+    elapsed = HostTestNow( ) - start;
+    printf( "  RegionCommonUpdateBandTimeOff: %.1f ns/call, %.2f timer reads/call\n", elapsed / ( hours * 10000 ),
+            ( double )( TimerReads - reads ) / ( hours * 10000 ) );
+
+    return HOST_TEST_RESULT( );
+}
@@ -0,0 +1,193 @@
+/*!
+ * \file      sigfox_ee_test.c
+ *
+ * \brief     Test and benchmark of the EEPROM emulation of the Sigfox
+ *            applications on a simulated flash
+ *
+ * \remark    Built once for each CFG_EE_RAM_INDEX option, with the ee_conf.h
+ *            of the Sigfox applications: one bank of two pages at
+ *            EE_BASE_ADRESS. Checks random writes of the EE_ID_COUNT virtual
+ *            addresses against a model through reboots and pool transfers,
+ *            checks that a power loss during a write, a transfer or a clean
+ *            is recovered by EE_Init with the old or the new value of each
+ *            address, then times EE_Read and EE_Write.
+ *
+ *            Usage: sigfox_ee_test [writes]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "flash_sim.h"
+#include "ee.h"
+#include "ee_conf.h"
+#include "flash_if.h"
+
+/*!
+ * Virtual addresses used by sgfx_eeprom_if.c, EE_ID_COUNT
+ */
+#define NB_ADDR                                     39
+
+/*!
+ * EE_Init format argument and bank of sgfx_eeprom_if.c
+ */
+#define NO_FORMAT                                   0
+#define FORMAT                                      1
+#define EE_BANK_0                                   0
+
+#if ( FLASH_SIM_ADDRESS != EE_BASE_ADRESS )
+#error "the simulated flash shall be mapped at EE_BASE_ADRESS"
+#endif
+
+static uint32_t Model[NB_ADDR];
+static bool Written[NB_ADDR];
+static uint32_t Seed = 0x53474658;
+
+FLASH_IF_StatusTypedef FLASH_IF_Write( void* pDestination, const void* pSource, uint32_t uLength )
+{
+    uint32_t offset = ( uint32_t )( ( uintptr_t )pDestination - EE_BASE_ADRESS );
+
+    return ( FlashSimWrite( offset, pSource, uLength ) == 0 ) ? FLASH_IF_OK : FLASH_IF_WRITE_ERROR;
+}
+
+FLASH_IF_StatusTypedef FLASH_IF_Erase( void* pStart, uint32_t uLength )
+{
+    uint32_t offset = ( uint32_t )( ( uintptr_t )pStart - EE_BASE_ADRESS );
+
+    return ( FlashSimErase( offset, uLength ) == 0 ) ? FLASH_IF_OK : FLASH_IF_ERASE_ERROR;
+}
+
+/*!
+ * \brief   Write sequence of sgfx_eeprom_if.c: the clean follows the transfer
+ */
+static int32_t Write( uint16_t addr, uint32_t data )
+{
+    int32_t status = EE_Write( EE_BANK_0, addr, data );
+
+    if( status == EE_CLEAN_NEEDED )
+    {
+        status = EE_Clean( EE_BANK_0 );
+    }
+    return status;
+}
+
+static bool CheckAll( void )
+{
+    for( uint16_t addr = 0; addr < NB_ADDR; addr++ )
+    {
+        uint32_t data = 0;
+        int32_t status = EE_Read( EE_BANK_0, addr, &data );
+
+        if( ( Written[addr] == true ) ? ( ( status != EE_OK ) || ( data != Model[addr] ) ) : ( status != EE_NOT_FOUND ) )
+        {
+            printf( "address %u: status %d, 0x%08X\n", addr, ( int )status, ( unsigned )data );
+            return false;
+        }
+    }
+    return true;
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbWrites = HostTestRuns( argc, argv, 20000 );
+    uint32_t losses = 0;
+    uint32_t transferLosses = 0;
+    volatile uint32_t sink = 0;
+    double start;
+    double elapsed;
+
+    FlashSimInit( CFG_EE_BANK0_SIZE, HW_FLASH_WIDTH, HW_FLASH_PAGE_SIZE, 0x45455052 );
+
+    /* Startup of sgfx_eeprom_if.c on a blank flash */
+    HOST_TEST_CHECK( EE_Init( FORMAT, EE_BASE_ADRESS ) == EE_OK );
+    HOST_TEST_CHECK( CheckAll( ) == true );
+
+    /* Random writes, through pool transfers and reboots */
+    for( uint32_t n = 0; n < nbWrites; n++ )
+    {
+        uint16_t addr = HostTestRand( &Seed ) % NB_ADDR;
+        uint32_t data = HostTestRand( &Seed );
+
+        HOST_TEST_CHECK( Write( addr, data ) == EE_OK );
+        Model[addr] = data;
+        Written[addr] = true;
+        if( ( n % 97 ) == 0 )
+        {
+            HOST_TEST_CHECK( CheckAll( ) == true );
+        }
+        if( ( n % 1013 ) == 0 )
+        {
+            HOST_TEST_CHECK( EE_Init( NO_FORMAT, EE_BASE_ADRESS ) == EE_OK );
+            HOST_TEST_CHECK( CheckAll( ) == true );
+        }
+    }
+    HOST_TEST_CHECK( EE_Init( NO_FORMAT, EE_BASE_ADRESS ) == EE_OK );
+    HOST_TEST_CHECK( CheckAll( ) == true );
+
+    /* Power loss during a write: EE_Init recovers the old or the new value */
+    for( uint32_t n = 0; n < nbWrites; n++ )
+    {
+        uint16_t addr = HostTestRand( &Seed ) % NB_ADDR;
+        uint32_t data = HostTestRand( &Seed );
+        uint32_t writes = FlashSimStats.Writes;
+        uint32_t read = 0;
+        int32_t status;
+
+        /* Either the element itself or a later step of a transfer */
+        FlashSimPowerFailAfter( ( ( HostTestRand( &Seed ) % 2 ) == 0 ) ? 0 : HostTestRand( &Seed ) % 48 );
+        status = Write( addr, data );
+        if( FlashSimPowerLost( ) == false )
+        {
+            FlashSimPowerFailAfter( -1 );
+            HOST_TEST_CHECK( status == EE_OK );
+            Model[addr] = data;
+            Written[addr] = true;
+            continue;
+        }
+
+        losses++;
+        if( FlashSimStats.Writes != writes )
+        {
+            /* Words were programmed before the loss: it hit a transfer or a clean */
+            transferLosses++;
+        }
+
+        FlashSimPowerOn( );
+        HOST_TEST_CHECK( EE_Init( NO_FORMAT, EE_BASE_ADRESS ) == EE_OK );
+        if( ( EE_Read( EE_BANK_0, addr, &read ) == EE_OK ) && ( read == data ) )
+        {
+            Model[addr] = data;
+            Written[addr] = true;
+        }
+        HOST_TEST_CHECK( CheckAll( ) == true );
+    }
+    printf( "CFG_EE_RAM_INDEX %d: %u power losses, %u during a transfer or a clean\n",
+            CFG_EE_RAM_INDEX, losses, transferLosses );
+    HOST_TEST_CHECK( losses > 0 );
+    HOST_TEST_CHECK( transferLosses > 0 );
+    HOST_TEST_CHECK( FlashSimStats.Violations == 0 );
+
+    /* Benchmarks */
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbWrites * 10; n++ )
+    {
+        uint32_t data;
+
+        EE_Read( EE_BANK_0, n % NB_ADDR, &data );
+        sink += data;
+    }
+    elapsed = HostTestNow( ) - start;
+    printf( "CFG_EE_RAM_INDEX %d: %u reads, %.1f ns/read\n", CFG_EE_RAM_INDEX, nbWrites * 10, elapsed / ( nbWrites * 10 ) );
+
+    start = HostTestNow( );
+    for( uint32_t n = 0; n < nbWrites; n++ )
+    {
+        Write( n % NB_ADDR, n );
+        Model[n % NB_ADDR] = n;
+        Written[n % NB_ADDR] = true;
+    }
+    elapsed = HostTestNow( ) - start;
+    printf( "CFG_EE_RAM_INDEX %d: %u writes, %.1f ns/write, transfers included\n", CFG_EE_RAM_INDEX, nbWrites,
+            elapsed / nbWrites );
+    HOST_TEST_CHECK( CheckAll( ) == true );
+
+    return HOST_TEST_RESULT( );
+}
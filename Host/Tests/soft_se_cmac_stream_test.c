@@ -0,0 +1,297 @@
+/*!
+ * \file      soft_se_cmac_stream_test.c
+ *
+ * \brief     Test of the CMAC streams of the secure element and of the data
+ *            block MIC of LoRaMacCrypto.c
+ *
+ * \remark    Runs the secure element (soft-se.c) in software, or on the host
+ *            mock of the KMS (kms/kms_mock.c) with LORAWAN_KMS == 1. For each
+ *            chunk size from 1 to 250 bytes, two streams on two keys are fed
+ *            in turns, one with the chunk size and one with its complement to
+ *            251, and a one-shot CMAC on a third key runs between the chunks:
+ *            with SOFT_SE_AES_CTX_CACHE_NB == 1 each chunk reloads a stream
+ *            into a key schedule evicted by the other keys. Each stream shall
+ *            give the one-shot CMAC of SecureElementComputeAesCmac and the
+ *            reference CMAC of cmac.c.
+ *
+ *            Then LoRaMacCryptoStartDataBlock/UpdateDataBlock/FinishDataBlock
+ *            on random data blocks cut in random parts shall give the MIC of
+ *            LoRaMacCryptoComputeDataBlock and the reference MIC. A stream
+ *            finished without data, or dropped, shall release its KMS session.
+ *
+ *            Usage: soft_se_cmac_stream_test [data blocks]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "radio.h"
+#include "utilities.h"
+#include "cmac.h"
+#include "secure-element.h"
+#include "secure-element-nvm.h"
+#include "LoRaMacCrypto.h"
+#if ( LORAWAN_KMS == 1 )
+#include "kms_if.h"
+#endif /* LORAWAN_KMS */
+
+/*!
+ * Largest chunk size of the streams
+ */
+#define TEST_MAX_CHUNK                              250
+
+/*!
+ * Largest message of the streams and of the one-shot CMAC
+ */
+#define TEST_MAX_SIZE                               800
+
+/*!
+ * Largest data block
+ */
+#define TEST_MAX_BLOCK                              2000
+
+static uint32_t RandomState = 0x434D4143;
+
+static uint32_t TestRandom( void )
+{
+    return HostTestRand( &RandomState );
+}
+
+/*!
+ * The secure element only uses the random generator of the radio
+ */
+const struct Radio_s Radio =
+{
+    .Random = TestRandom,
+};
+
+static SecureElementNvmData_t SeNvm;
+
+static const uint8_t NwkSKey[16] =
+{
+    0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87, 0x78, 0x69, 0x5A, 0x4B, 0x3C, 0x2D, 0x1E, 0x0F
+};
+static const uint8_t AppSKey[16] =
+{
+    0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x00
+};
+static const uint8_t DataBlockIntKey[16] =
+{
+    0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+};
+
+/*!
+ * Messages of the two streams and of the one-shot CMAC between their chunks
+ */
+static uint8_t Msg[3][TEST_MAX_SIZE];
+static uint8_t Block[TEST_MAX_BLOCK];
+
+/*!
+ * \brief   Reference MIC
+ */
+static uint32_t RefCmac( const uint8_t* key, const uint8_t* b0, const uint8_t* buffer, uint32_t size )
+{
+    AES_CMAC_CTX ctx;
+    uint8_t tag[16];
+
+    AES_CMAC_Init( &ctx );
+    AES_CMAC_SetKey( &ctx, key );
+    if( b0 != NULL )
+    {
+        AES_CMAC_Update( &ctx, b0, 16 );
+    }
+    AES_CMAC_Update( &ctx, buffer, size );
+    AES_CMAC_Final( tag, &ctx );
+    return ( uint32_t )tag[0] | ( ( uint32_t )tag[1] << 8 ) | ( ( uint32_t )tag[2] << 16 ) | ( ( uint32_t )tag[3] << 24 );
+}
+
+static void RandomBytes( uint8_t* buffer, uint32_t size )
+{
+    for( uint32_t i = 0; i < size; i++ )
+    {
+        buffer[i] = ( uint8_t )TestRandom( );
+    }
+}
+
+/*!
+ * \brief   One-shot CMAC of a random message on DATABLOCK_INT_KEY
+ *
+ * \retval  true when the secure element gave the reference CMAC
+ */
+static bool OneShot( void )
+{
+    uint32_t size = 1 + TestRandom( ) % TEST_MAX_SIZE;
+    uint32_t cmac = 0;
+
+    RandomBytes( Msg[2], size );
+    return ( SecureElementComputeAesCmac( NULL, Msg[2], size, DATABLOCK_INT_KEY, &cmac ) == SECURE_ELEMENT_SUCCESS ) &&
+           ( cmac == RefCmac( DataBlockIntKey, NULL, Msg[2], size ) );
+}
+
+/*!
+ * \brief   Two interleaved streams, with a B0 block on NWK_S_KEY and without
+ *          on APP_S_KEY, fed by chunks of chunkSize and 251 - chunkSize bytes
+ *
+ * \retval  true when both streams gave the one-shot and the reference CMAC
+ */
+static bool InterleavedStreams( uint32_t chunkSize )
+{
+    CmacStreamCtx_t ctx[2];
+    uint8_t b0[16];
+    uint32_t size[2];
+    uint32_t done[2] = { 0, 0 };
+    uint32_t chunk[2] = { chunkSize, ( TEST_MAX_CHUNK + 1 ) - chunkSize };
+    uint32_t cmac[2] = { 0, 0 };
+    uint32_t oneShot = 0;
+    bool ok = true;
+
+    RandomBytes( b0, sizeof( b0 ) );
+    for( uint8_t s = 0; s < 2; s++ )
+    {
+        // Whole chunks and a last partial one, block aligned or not
+        size[s] = ( TestRandom( ) % ( TEST_MAX_SIZE - TEST_MAX_CHUNK ) ) + ( TestRandom( ) % 2 ) * chunk[s];
+        RandomBytes( Msg[s], size[s] );
+    }
+    ok &= SecureElementAesCmacStreamStart( &ctx[0], b0, NWK_S_KEY ) == SECURE_ELEMENT_SUCCESS;
+    ok &= SecureElementAesCmacStreamStart( &ctx[1], NULL, APP_S_KEY ) == SECURE_ELEMENT_SUCCESS;
+    ok &= OneShot( );
+    while( ( done[0] < size[0] ) || ( done[1] < size[1] ) )
+    {
+        for( uint8_t s = 0; s < 2; s++ )
+        {
+            uint32_t n = MIN( chunk[s], size[s] - done[s] );
+
+            if( ( n == 0 ) && ( ( TestRandom( ) % 4 ) != 0 ) )
+            {
+                continue;
+            }
+            ok &= SecureElementAesCmacStreamUpdate( &ctx[s], &Msg[s][done[s]], n ) == SECURE_ELEMENT_SUCCESS;
+            done[s] += n;
+            ok &= OneShot( );
+        }
+    }
+    ok &= SecureElementAesCmacStreamFinish( &ctx[0], &cmac[0] ) == SECURE_ELEMENT_SUCCESS;
+    ok &= SecureElementAesCmacStreamFinish( &ctx[1], &cmac[1] ) == SECURE_ELEMENT_SUCCESS;
+
+    ok &= cmac[0] == RefCmac( NwkSKey, b0, Msg[0], size[0] );
+    ok &= cmac[1] == RefCmac( AppSKey, NULL, Msg[1], size[1] );
+    ok &= ( SecureElementComputeAesCmac( b0, Msg[0], size[0], NWK_S_KEY, &oneShot ) == SECURE_ELEMENT_SUCCESS ) &&
+          ( cmac[0] == oneShot );
+    if( size[1] > 0 )
+    {
+        ok &= ( SecureElementComputeAesCmac( NULL, Msg[1], size[1], APP_S_KEY, &oneShot ) == SECURE_ELEMENT_SUCCESS ) &&
+              ( cmac[1] == oneShot );
+    }
+    return ok;
+}
+
+/*!
+ * \brief   MIC of a random data block of a fragmentation session, streamed in
+ *          random parts, as in LmhpFragmentation.c
+ *
+ * \retval  true when the stream gave the MIC of LoRaMacCryptoComputeDataBlock
+ *          and the reference MIC
+ */
+static bool DataBlock( void )
+{
+    CmacStreamCtx_t ctx;
+    uint32_t size = 1 + TestRandom( ) % TEST_MAX_BLOCK;
+    uint16_t sessionCnt = ( uint16_t )TestRandom( );
+    uint8_t fragIndex = TestRandom( ) % 4;
+    uint32_t descriptor = TestRandom( );
+    uint8_t b0[16] = { 0x49 };
+    uint32_t mic = 0;
+    uint32_t oneShot = 0;
+    uint32_t done = 0;
+    bool ok = true;
+
+    RandomBytes( Block, size );
+    b0[1] = sessionCnt & 0xFF;
+    b0[2] = sessionCnt >> 8;
+    b0[3] = fragIndex;
+    memcpy( &b0[4], &descriptor, 4 );
+    memcpy( &b0[12], &size, 4 );
+
+    ok &= LoRaMacCryptoStartDataBlock( &ctx, size, sessionCnt, fragIndex, descriptor ) == LORAMAC_CRYPTO_SUCCESS;
+    while( done < size )
+    {
+        uint32_t n = 1 + TestRandom( ) % TEST_MAX_CHUNK;
+
+        n = MIN( n, size - done );
+
+        ok &= LoRaMacCryptoUpdateDataBlock( &ctx, &Block[done], n ) == LORAMAC_CRYPTO_SUCCESS;
+        done += n;
+        if( ( TestRandom( ) % 8 ) == 0 )
+        {
+            ok &= OneShot( );
+        }
+    }
+    ok &= LoRaMacCryptoFinishDataBlock( &ctx, &mic ) == LORAMAC_CRYPTO_SUCCESS;
+    ok &= ( LoRaMacCryptoComputeDataBlock( Block, size, sessionCnt, fragIndex, descriptor, &oneShot ) == LORAMAC_CRYPTO_SUCCESS ) &&
+          ( mic == oneShot );
+    ok &= mic == RefCmac( DataBlockIntKey, b0, Block, size );
+    return ok;
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbBlocks = HostTestRuns( argc, argv, 200 );
+    uint32_t streamsOk = 0;
+    uint32_t blocksOk = 0;
+    CmacStreamCtx_t ctx;
+    uint8_t b0[16] = { 0x49 };
+    uint32_t cmac = 0;
+#if ( LORAWAN_KMS == 1 )
+    uint32_t openSessions;
+
+    KmsMockReset( );
+#endif /* LORAWAN_KMS */
+
+    HOST_TEST_CHECK( SecureElementInit( &SeNvm ) == SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( SecureElementSetKey( NWK_S_KEY, ( uint8_t* )NwkSKey ) == SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( SecureElementSetKey( APP_S_KEY, ( uint8_t* )AppSKey ) == SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( SecureElementSetKey( DATABLOCK_INT_KEY, ( uint8_t* )DataBlockIntKey ) == SECURE_ELEMENT_SUCCESS );
+    // Opens the sessions kept by the secure element
+    HOST_TEST_CHECK( OneShot( ) == true );
+#if ( LORAWAN_KMS == 1 )
+    openSessions = KmsMockOpenSessions( );
+#endif /* LORAWAN_KMS */
+
+    for( uint32_t chunkSize = 1; chunkSize <= TEST_MAX_CHUNK; chunkSize++ )
+    {
+        if( InterleavedStreams( chunkSize ) == true )
+        {
+            streamsOk++;
+        }
+    }
+    HOST_TEST_CHECK( streamsOk == TEST_MAX_CHUNK );
+
+    for( uint32_t i = 0; i < nbBlocks; i++ )
+    {
+        if( DataBlock( ) == true )
+        {
+            blocksOk++;
+        }
+    }
+    HOST_TEST_CHECK( blocksOk == nbBlocks );
+    printf( "%u chunk sizes: interleaved CMAC streams identical to the one-shot CMAC\n", ( unsigned )streamsOk );
+    printf( "%u data blocks: streamed MIC identical to LoRaMacCryptoComputeDataBlock\n", ( unsigned )blocksOk );
+
+    // A stream of the B0 block alone
+    HOST_TEST_CHECK( SecureElementAesCmacStreamStart( &ctx, b0, DATABLOCK_INT_KEY ) == SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( SecureElementAesCmacStreamUpdate( &ctx, NULL, 0 ) == SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( SecureElementAesCmacStreamFinish( &ctx, &cmac ) == SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( cmac == RefCmac( DataBlockIntKey, b0, NULL, 0 ) );
+
+    // A dropped data block MIC
+    HOST_TEST_CHECK( LoRaMacCryptoStartDataBlock( &ctx, 100, 1, 0, 0 ) == LORAMAC_CRYPTO_SUCCESS );
+    HOST_TEST_CHECK( LoRaMacCryptoUpdateDataBlock( &ctx, Block, 37 ) == LORAMAC_CRYPTO_SUCCESS );
+    HOST_TEST_CHECK( LoRaMacCryptoFinishDataBlock( &ctx, &cmac ) == LORAMAC_CRYPTO_SUCCESS );
+    HOST_TEST_CHECK( LoRaMacCryptoStartDataBlock( NULL, 100, 1, 0, 0 ) == LORAMAC_CRYPTO_ERROR_NPE );
+    HOST_TEST_CHECK( SecureElementAesCmacStreamStart( &ctx, NULL, MC_KE_KEY ) == SECURE_ELEMENT_ERROR_INVALID_KEY_ID );
+
+#if ( LORAWAN_KMS == 1 )
+    // Each stream ran in a session of its own, all released
+    HOST_TEST_CHECK( KmsMockOpenSessions( ) == openSessions );
+#endif /* LORAWAN_KMS */
+
+    return HOST_TEST_RESULT( );
+}
@@ -0,0 +1,262 @@
+/*!
+ * \file      soft_se_kms_test.c
+ *
+ * \brief     Test of the secure element on the KMS PKCS #11 interface
+ *
+ * \remark    Runs the secure element (soft-se.c, LORAWAN_KMS == 1) on the host
+ *            mock of the KMS (kms/kms_mock.c). Checks the results against the
+ *            software AES and CMAC, and counts the C_* calls of a series of
+ *            uplinks: the KMS sessions and the AES ECB operation shall be
+ *            reused from one frame to the next, and released after a failure.
+ *
+ *            Usage: soft_se_kms_test [uplinks]
+ */
+#include <string.h>
+#include "host_test.h"
+#include "radio.h"
+#include "kms_if.h"
+#include "lorawan_aes.h"
+#include "cmac.h"
+#include "secure-element.h"
+#include "secure-element-nvm.h"
+
+#ifndef SOFT_SE_KMS_SIGN_UPDATE
+#define SOFT_SE_KMS_SIGN_UPDATE                     0
+#endif
+
+static uint32_t RandomState = 0x4B4D5331;
+
+static uint32_t TestRandom( void )
+{
+    return HostTestRand( &RandomState );
+}
+
+/*!
+ * The secure element only uses the random generator of the radio
+ */
+const struct Radio_s Radio =
+{
+    .Random = TestRandom,
+};
+
+static SecureElementNvmData_t SeNvm;
+
+static const uint8_t AppSKey[16] =
+{
+    0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x00
+};
+static const uint8_t NwkSKey[16] =
+{
+    0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87, 0x78, 0x69, 0x5A, 0x4B, 0x3C, 0x2D, 0x1E, 0x0F
+};
+
+/*!
+ * \brief   Reference LoRaWAN payload encryption
+ */
+static void RefCtrXor( const uint8_t* key, const uint8_t* aBlock, uint8_t ctr, uint8_t* buffer, uint32_t size )
+{
+    lorawan_aes_context aes;
+    uint8_t block[16];
+    uint8_t s[16];
+
+    lorawan_aes_set_key( key, 16, &aes );
+    memcpy( block, aBlock, 16 );
+    for( uint32_t i = 0; i < size; i += 16 )
+    {
+        block[15] = ctr++;
+        lorawan_aes_encrypt( block, s, &aes );
+        for( uint32_t j = 0; ( j < 16 ) && ( i + j < size ); j++ )
+        {
+            buffer[i + j] ^= s[j];
+        }
+    }
+}
+
+/*!
+ * \brief   Reference MIC
+ */
+static uint32_t RefCmac( const uint8_t* key, const uint8_t* b0, const uint8_t* buffer, uint32_t size )
+{
+    AES_CMAC_CTX ctx;
+    uint8_t tag[16];
+
+    AES_CMAC_Init( &ctx );
+    AES_CMAC_SetKey( &ctx, key );
+    if( b0 != NULL )
+    {
+        AES_CMAC_Update( &ctx, b0, 16 );
+    }
+    AES_CMAC_Update( &ctx, buffer, size );
+    AES_CMAC_Final( tag, &ctx );
+    return ( uint32_t )tag[0] | ( ( uint32_t )tag[1] << 8 ) | ( ( uint32_t )tag[2] << 16 ) | ( ( uint32_t )tag[3] << 24 );
+}
+
+/*!
+ * \brief   Encrypts a random payload and computes its MIC as LoRaMacCrypto does for an uplink
+ *
+ * \retval  true when the secure element gave the reference results
+ */
+static bool Uplink( uint32_t fCnt, const uint8_t* appSKey )
+{
+    uint8_t aBlock[16] = { 0x01, 0, 0, 0, 0, 0x00, 0x04, 0x03, 0x02, 0x01 };
+    uint8_t b0[16] = { 0x49, 0, 0, 0, 0, 0x00, 0x04, 0x03, 0x02, 0x01 };
+    uint8_t payload[64];
+    uint8_t expected[64];
+    uint32_t size = 1 + TestRandom( ) % 60;
+    uint32_t mic = 0;
+
+    for( uint32_t i = 0; i < size; i++ )
+    {
+        payload[i] = ( uint8_t )TestRandom( );
+    }
+    memcpy( &aBlock[10], &fCnt, 4 );
+    memcpy( &b0[10], &fCnt, 4 );
+    b0[15] = ( uint8_t )size;
+
+    memcpy( expected, payload, size );
+    RefCtrXor( appSKey, aBlock, 1, expected, size );
+    if( ( SecureElementAesCtrXor( APP_S_KEY, aBlock, 1, payload, size ) != SECURE_ELEMENT_SUCCESS ) ||
+        ( memcmp( payload, expected, size ) != 0 ) )
+    {
+        return false;
+    }
+
+    if( ( SecureElementComputeAesCmac( b0, payload, size, NWK_S_KEY, &mic ) != SECURE_ELEMENT_SUCCESS ) ||
+        ( mic != RefCmac( NwkSKey, b0, payload, size ) ) )
+    {
+        return false;
+    }
+
+    /* Downlink of the same frame */
+    return SecureElementVerifyAesCmac( payload, size, RefCmac( NwkSKey, NULL, payload, size ), NWK_S_KEY ) ==
+           SECURE_ELEMENT_SUCCESS;
+}
+
+int main( int argc, char** argv )
+{
+    uint32_t nbUplinks = HostTestRuns( argc, argv, 10 );
+    uint8_t newAppSKey[16];
+    uint8_t block[16] = { 0 };
+    uint8_t enc[16];
+    uint8_t ref[16];
+    uint32_t fCnt = 0;
+    bool ok = true;
+
+    KmsMockReset( );
+    HOST_TEST_CHECK( SecureElementInit( &SeNvm ) == SECURE_ELEMENT_SUCCESS );
+    /* One session for all the key look-ups */
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_OPEN_SESSION] == 1 );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_FIND_OBJECTS_INIT] == NUM_OF_KEYS );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_CLOSE_SESSION] == 0 );
+
+    HOST_TEST_CHECK( SecureElementSetKey( APP_S_KEY, ( uint8_t* )AppSKey ) == SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( SecureElementSetKey( NWK_S_KEY, ( uint8_t* )NwkSKey ) == SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_CREATE_OBJECT] == 2 );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_OPEN_SESSION] == 1 );
+
+    /* Uplinks: the cipher session is opened and its AES ECB operation initialized once */
+    KmsMockClearCalls( );
+    for( uint32_t i = 0; i < nbUplinks; i++ )
+    {
+        ok &= Uplink( fCnt++, AppSKey );
+    }
+    HOST_TEST_CHECK( ok == true );
+    printf( "%u uplinks: %u C_OpenSession, %u C_CloseSession, %u C_EncryptInit, %u C_EncryptUpdate, "
+            "%u C_EncryptFinal, %u C_SignInit, %u C_Sign, %u C_SignUpdate, %u C_SignFinal, %u C_VerifyInit\n",
+            nbUplinks, KmsMockCalls[KMS_MOCK_OPEN_SESSION], KmsMockCalls[KMS_MOCK_CLOSE_SESSION],
+            KmsMockCalls[KMS_MOCK_ENCRYPT_INIT], KmsMockCalls[KMS_MOCK_ENCRYPT_UPDATE],
+            KmsMockCalls[KMS_MOCK_ENCRYPT_FINAL], KmsMockCalls[KMS_MOCK_SIGN_INIT], KmsMockCalls[KMS_MOCK_SIGN],
+            KmsMockCalls[KMS_MOCK_SIGN_UPDATE], KmsMockCalls[KMS_MOCK_SIGN_FINAL], KmsMockCalls[KMS_MOCK_VERIFY_INIT] );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_OPEN_SESSION] == 1 );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_CLOSE_SESSION] == 0 );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_ENCRYPT_INIT] == 1 );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_ENCRYPT_UPDATE] == nbUplinks );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_ENCRYPT_FINAL] == 0 );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_SIGN_INIT] == nbUplinks );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_VERIFY_INIT] == nbUplinks );
+#if ( SOFT_SE_KMS_SIGN_UPDATE == 1 )
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_SIGN] == 0 );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_SIGN_FINAL] == nbUplinks );
+#else
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_SIGN] == nbUplinks );
+#endif /* SOFT_SE_KMS_SIGN_UPDATE */
+    HOST_TEST_CHECK( KmsMockOpenSessions( ) == 2 );
+
+    /* Key change: the AES ECB operation is finalized and initialized again */
+    KmsMockClearCalls( );
+    HOST_TEST_CHECK( SecureElementAesEncrypt( block, 16, NWK_S_KEY, enc ) == SECURE_ELEMENT_SUCCESS );
+    memset( ref, 0, sizeof( ref ) );
+    RefCtrXor( NwkSKey, block, 0, ref, 16 );
+    HOST_TEST_CHECK( memcmp( enc, ref, 16 ) == 0 );
+    HOST_TEST_CHECK( Uplink( fCnt++, AppSKey ) == true );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_ENCRYPT_FINAL] == 2 );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_ENCRYPT_INIT] == 2 );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_OPEN_SESSION] == 0 );
+
+    /* New key value: the operation on the destroyed key object is not reused */
+    for( uint32_t i = 0; i < 16; i++ )
+    {
+        newAppSKey[i] = ( uint8_t )TestRandom( );
+    }
+    HOST_TEST_CHECK( SecureElementSetKey( APP_S_KEY, newAppSKey ) == SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_DESTROY_OBJECT] == 1 );
+    HOST_TEST_CHECK( Uplink( fCnt++, newAppSKey ) == true );
+
+    /* A failure closes the session, the next call opens a new one */
+    KmsMockClearCalls( );
+    KmsMockInjectFailure( KMS_MOCK_ENCRYPT_UPDATE );
+    HOST_TEST_CHECK( Uplink( fCnt++, newAppSKey ) == false );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_CLOSE_SESSION] == 1 );
+    HOST_TEST_CHECK( KmsMockOpenSessions( ) == 1 );
+    HOST_TEST_CHECK( Uplink( fCnt++, newAppSKey ) == true );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_OPEN_SESSION] == 1 );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_ENCRYPT_INIT] == 1 );
+
+    KmsMockClearCalls( );
+    KmsMockInjectFailure( KMS_MOCK_SIGN_INIT );
+    HOST_TEST_CHECK( Uplink( fCnt++, newAppSKey ) == false );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_CLOSE_SESSION] == 1 );
+    HOST_TEST_CHECK( Uplink( fCnt++, newAppSKey ) == true );
+    HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_OPEN_SESSION] == 1 );
+    HOST_TEST_CHECK( KmsMockOpenSessions( ) == 2 );
+
+    /* A wrong MIC is reported as such */
+    KmsMockClearCalls( );
+    HOST_TEST_CHECK( SecureElementVerifyAesCmac( enc, 16, RefCmac( NwkSKey, NULL, enc, 16 ) ^ 1, NWK_S_KEY ) !=
+                     SECURE_ELEMENT_SUCCESS );
+    HOST_TEST_CHECK( SecureElementVerifyAesCmac( enc, 16, RefCmac( NwkSKey, NULL, enc, 16 ), NWK_S_KEY ) ==
+                     SECURE_ELEMENT_SUCCESS );
+
+#if ( SOFT_SE_KMS_SIGN_UPDATE == 1 )
+    /* CMAC streams run in a session of their own */
+    {
+        CmacStreamCtx_t ctx;
+        uint8_t b0[16] = { 0x49 };
+        uint8_t data[100];
+        uint32_t cmac = 0;
+
+        for( uint32_t i = 0; i < sizeof( data ); i++ )
+        {
+            data[i] = ( uint8_t )TestRandom( );
+        }
+        KmsMockClearCalls( );
+        HOST_TEST_CHECK( SecureElementAesCmacStreamStart( &ctx, b0, NWK_S_KEY ) == SECURE_ELEMENT_SUCCESS );
+        HOST_TEST_CHECK( SecureElementAesCmacStreamUpdate( &ctx, data, 37 ) == SECURE_ELEMENT_SUCCESS );
+        HOST_TEST_CHECK( SecureElementAesCmacStreamUpdate( &ctx, &data[37], sizeof( data ) - 37 ) ==
+                         SECURE_ELEMENT_SUCCESS );
+        HOST_TEST_CHECK( SecureElementAesCmacStreamFinish( &ctx, &cmac ) == SECURE_ELEMENT_SUCCESS );
+        HOST_TEST_CHECK( cmac == RefCmac( NwkSKey, b0, data, sizeof( data ) ) );
+        HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_OPEN_SESSION] == 1 );
+        HOST_TEST_CHECK( KmsMockCalls[KMS_MOCK_CLOSE_SESSION] == 1 );
+
+        /* A failed update releases the session of the stream */
+        HOST_TEST_CHECK( SecureElementAesCmacStreamStart( &ctx, b0, NWK_S_KEY ) == SECURE_ELEMENT_SUCCESS );
+        KmsMockInjectFailure( KMS_MOCK_SIGN_UPDATE );
+        HOST_TEST_CHECK( SecureElementAesCmacStreamUpdate( &ctx, data, 37 ) != SECURE_ELEMENT_SUCCESS );
+        HOST_TEST_CHECK( SecureElementAesCmacStreamFinish( &ctx, &cmac ) != SECURE_ELEMENT_SUCCESS );
+        HOST_TEST_CHECK( KmsMockOpenSessions( ) == 2 );
+    }
+#endif /* SOFT_SE_KMS_SIGN_UPDATE */
+
+    return HOST_TEST_RESULT( );
+}
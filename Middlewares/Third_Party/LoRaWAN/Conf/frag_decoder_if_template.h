@@ -98,6 +98,31 @@ extern "C" {
 
 #endif /* INTEROP_TEST_MODE */
 
+/*!
+  * Maximum number of coded fragments queued by the decoder, they are decoded
+  * out of the reception of the frames.
+  *
+  * \remark This parameter has an impact on the memory footprint.
+  */
+#define FRAG_DECODER_MAX_PENDING                    4
+
+/*!
+  * Number of rows of the lost fragments kept in RAM by the decoder to save
+  * flash reads, 0 to disable the cache.
+  *
+  * \remark This parameter has an impact on the memory footprint.
+  */
+#define FRAG_DECODER_ROW_CACHE_SIZE                 0
+
+/*!
+  * Size of the aligned blocks in which the decoder combines its flash writes,
+  * 0 to write each fragment on its own.
+  *
+  * \remark This parameter has an impact on the memory footprint.
+  * \note Set it to the flash page size to write whole pages
+  */
+#define FRAG_DECODER_WRITE_BLOCK_SIZE               0
+
 #define FRAG_DECODER_SWAP_REGION_START              ((uint32_t)(SlotStartAdd[SLOT_SWAP]))
 
 #define FRAG_DECODER_SWAP_REGION_SIZE               ((uint32_t)(SlotEndAdd[SLOT_SWAP] - SlotStartAdd[SLOT_SWAP] + 1U))
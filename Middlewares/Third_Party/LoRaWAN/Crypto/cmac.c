@@ -45,32 +45,63 @@ DEALINGS WITH THE SOFTWARE
         ( r )[15] = ( v )[15] << 1;                       \
     } while( 0 )
 
-#define XOR( v, r )                         \
-    do                                      \
-    {                                       \
-        int32_t i;                          \
-        for( i = 0; i < 16; i++ )           \
-        {                                   \
-            ( r )[i] = ( r )[i] ^ ( v )[i]; \
-        }                                   \
-    } while( 0 )
+/* r = r ^ v, word wide when both blocks are word aligned */
+static void cmac_xor( const uint8_t* v, uint8_t* r )
+{
+    int32_t i;
+
+    if( ( ( ( uintptr_t )v | ( uintptr_t )r ) & 0x3UL ) == 0UL )
+    {
+        const uint32_t* v32 = ( const uint32_t* )v;
+        uint32_t*       r32 = ( uint32_t* )r;
+
+        r32[0] ^= v32[0];
+        r32[1] ^= v32[1];
+        r32[2] ^= v32[2];
+        r32[3] ^= v32[3];
+    }
+    else
+    {
+        for( i = 0; i < 16; i++ )
+        {
+            r[i] = r[i] ^ v[i];
+        }
+    }
+}
+
+/* K = K.x in GF(2^128), used to derive the subkeys */
+static void cmac_double( const uint8_t* v, uint8_t* r )
+{
+    uint8_t msb = v[0] & 0x80;
+
+    LSHIFT( v, r );
+    if( msb != 0 )
+        r[15] ^= 0x87;
+}
 
 void AES_CMAC_Init( AES_CMAC_CTX* ctx )
 {
     memset1( ctx->X, 0, sizeof ctx->X );
     ctx->M_n = 0;
+    memset1( ctx->K1, 0, sizeof ctx->K1 );
+    memset1( ctx->K2, 0, sizeof ctx->K2 );
     memset1( ctx->rijndael.ksch, '\0', 240 );
 }
 
 void AES_CMAC_SetKey( AES_CMAC_CTX* ctx, const uint8_t key[AES_CMAC_KEY_LENGTH] )
 {
     lorawan_aes_set_key( key, AES_CMAC_KEY_LENGTH, &ctx->rijndael );
+
+    /* generate subkeys K1 and K2 once per key */
+    memset1( ctx->K1, '\0', 16 );
+    lorawan_aes_encrypt( ctx->K1, ctx->K1, &ctx->rijndael );
+    cmac_double( ctx->K1, ctx->K1 );
+    cmac_double( ctx->K1, ctx->K2 );
 }
 
 void AES_CMAC_Update( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t len )
 {
     uint32_t mlen;
-    uint8_t  in[16];
 
     if( ctx->M_n > 0 )
     {
@@ -79,11 +110,8 @@ void AES_CMAC_Update( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t len )
         ctx->M_n += mlen;
         if( ctx->M_n < 16 || len == mlen )
             return;
-        XOR( ctx->M_last, ctx->X );
-
-        memcpy1( in, &ctx->X[0], 16 );  // Otherwise it does not look good
-        lorawan_aes_encrypt( in, in, &ctx->rijndael );
-        memcpy1( &ctx->X[0], in, 16 );
+        cmac_xor( ctx->M_last, ctx->X );
+        lorawan_aes_encrypt( ctx->X, ctx->X, &ctx->rijndael );
 
         data += mlen;
         len -= mlen;
@@ -91,11 +119,8 @@ void AES_CMAC_Update( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t len )
     while( len > 16 )
     { /* not last block */
 
-        XOR( data, ctx->X );
-
-        memcpy1( in, &ctx->X[0], 16 );  // Otherwise it does not look good
-        lorawan_aes_encrypt( in, in, &ctx->rijndael );
-        memcpy1( &ctx->X[0], in, 16 );
+        cmac_xor( data, ctx->X );
+        lorawan_aes_encrypt( ctx->X, ctx->X, &ctx->rijndael );
 
         data += 16;
         len -= 16;
@@ -107,47 +132,68 @@ void AES_CMAC_Update( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t len )
 
 void AES_CMAC_Final( uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX* ctx )
 {
-    uint8_t K[16];
-    uint8_t in[16];
-    /* generate subkey K1 */
-    memset1( K, '\0', 16 );
-
-    lorawan_aes_encrypt( K, K, &ctx->rijndael );
-
-    if( K[0] & 0x80 )
-    {
-        LSHIFT( K, K );
-        K[15] ^= 0x87;
-    }
-    else
-        LSHIFT( K, K );
-
     if( ctx->M_n == 16 )
     {
         /* last block was a complete block */
-        XOR( K, ctx->M_last );
+        cmac_xor( ctx->K1, ctx->M_last );
     }
     else
     {
-        /* generate subkey K2 */
-        if( K[0] & 0x80 )
-        {
-            LSHIFT( K, K );
-            K[15] ^= 0x87;
-        }
-        else
-            LSHIFT( K, K );
-
         /* padding(M_last) */
         ctx->M_last[ctx->M_n] = 0x80;
         while( ++ctx->M_n < 16 )
             ctx->M_last[ctx->M_n] = 0;
 
-        XOR( K, ctx->M_last );
+        cmac_xor( ctx->K2, ctx->M_last );
+    }
+    cmac_xor( ctx->M_last, ctx->X );
+
+    lorawan_aes_encrypt( ctx->X, digest, &ctx->rijndael );
+}
+
+void AES_CMAC_Compute( AES_CMAC_CTX* ctx, const uint8_t* prefix, const uint8_t* data, uint32_t len,
+                       uint8_t digest[AES_CMAC_DIGEST_LENGTH] )
+{
+    uint32_t i;
+
+    memset1( ctx->X, 0, sizeof ctx->X );
+    ctx->M_n = 0;
+
+    if( prefix != NULL )
+    {
+        cmac_xor( prefix, ctx->X );
+        if( len == 0 )
+        {
+            /* the prefix is the last, complete, block */
+            cmac_xor( ctx->K1, ctx->X );
+            lorawan_aes_encrypt( ctx->X, digest, &ctx->rijndael );
+            return;
+        }
+        lorawan_aes_encrypt( ctx->X, ctx->X, &ctx->rijndael );
+    }
+    while( len > 16 )
+    { /* not last block, processed in place */
+
+        cmac_xor( data, ctx->X );
+        lorawan_aes_encrypt( ctx->X, ctx->X, &ctx->rijndael );
+
+        data += 16;
+        len -= 16;
+    }
+
+    if( len == 16 )
+    {
+        cmac_xor( data, ctx->X );
+        cmac_xor( ctx->K1, ctx->X );
+    }
+    else
+    {
+        /* padding(M_last) folded directly into X */
+        for( i = 0; i < len; i++ )
+            ctx->X[i] ^= data[i];
+        ctx->X[len] ^= 0x80;
+        cmac_xor( ctx->K2, ctx->X );
     }
-    XOR( ctx->M_last, ctx->X );
 
-    memcpy1( in, &ctx->X[0], 16 );  // Otherwise it does not look good
-    lorawan_aes_encrypt( in, digest, &ctx->rijndael );
-    memset1( K, 0, sizeof K );
+    lorawan_aes_encrypt( ctx->X, digest, &ctx->rijndael );
 }
@@ -45,10 +45,13 @@ extern "C" {
 #define AES_CMAC_KEY_LENGTH     16
 #define AES_CMAC_DIGEST_LENGTH  16
  
+/* the 16-byte blocks come first so that they are word aligned */
 typedef struct _AES_CMAC_CTX {
-            lorawan_aes_context    rijndael;
             uint8_t        X[16];
             uint8_t        M_last[16];
+            uint8_t        K1[16];
+            uint8_t        K2[16];
+            lorawan_aes_context    rijndael;
             uint32_t       M_n;
     } AES_CMAC_CTX;
    
@@ -61,6 +64,10 @@ void     AES_CMAC_Update(AES_CMAC_CTX * ctx, const uint8_t * data, uint32_t len)
           //          __attribute__((__bounded__(__string__,2,3)));
 void     AES_CMAC_Final(uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX  * ctx);
             //     __attribute__((__bounded__(__minbytes__,1,AES_CMAC_DIGEST_LENGTH)));
+/* one-shot CMAC of an optional 16-byte prefix block (B0/B1) followed by
+   the message, the context only needs a key set with AES_CMAC_SetKey   */
+void     AES_CMAC_Compute(AES_CMAC_CTX * ctx, const uint8_t * prefix, const uint8_t * data, uint32_t len,
+                          uint8_t digest[AES_CMAC_DIGEST_LENGTH]);
 //__END_DECLS
 
 #ifdef __cplusplus
@@ -55,6 +55,18 @@
 #  define USE_TABLES
 #endif
 
+/* define the 32-bit word oriented encryption rounds (needs USE_TABLES):
+   0: byte oriented rounds (smallest, used on Cortex-M0/M0+)
+   1: one 1 KB T-table, rotated on the fly for the other columns
+   4: four 1 KB T-tables (fastest)                                      */
+#if !defined( AES_T_TABLES )
+#  if ( __CORTEX_M != 0 ) // if Cortex is different from M0/M0+
+#    define AES_T_TABLES    1
+#  else
+#    define AES_T_TABLES    0
+#  endif
+#endif
+
 /*  On Intel Core 2 duo VERSION_1 is faster */
 
 /* alternative versions (test for performance on your system) */
@@ -207,6 +219,28 @@ static const uint8_t gfmul_d[256] = mm_data(fd);
 static const uint8_t gfmul_e[256] = mm_data(fe);
 #endif
 
+#if ( AES_T_TABLES != 0 )
+
+/* T-table words hold the MixColumns multiples of the S Box value, the
+   byte i of the word being the row i of the output column             */
+#define t0_w(p) ( ((uint32_t)f2(p) <<  0) | ((uint32_t)f1(p) <<  8) \
+                | ((uint32_t)f1(p) << 16) | ((uint32_t)f3(p) << 24) )
+#define t1_w(p) ( ((uint32_t)f3(p) <<  0) | ((uint32_t)f2(p) <<  8) \
+                | ((uint32_t)f1(p) << 16) | ((uint32_t)f1(p) << 24) )
+#define t2_w(p) ( ((uint32_t)f1(p) <<  0) | ((uint32_t)f3(p) <<  8) \
+                | ((uint32_t)f2(p) << 16) | ((uint32_t)f1(p) << 24) )
+#define t3_w(p) ( ((uint32_t)f1(p) <<  0) | ((uint32_t)f1(p) <<  8) \
+                | ((uint32_t)f3(p) << 16) | ((uint32_t)f2(p) << 24) )
+
+static const uint32_t t_fn0[256] = sb_data(t0_w);
+#if ( AES_T_TABLES == 4 )
+static const uint32_t t_fn1[256] = sb_data(t1_w);
+static const uint32_t t_fn2[256] = sb_data(t2_w);
+static const uint32_t t_fn3[256] = sb_data(t3_w);
+#endif
+
+#endif
+
 #define s_box(x)     sbox[(x)]
 #if defined( AES_DEC_PREKEYED )
 #define is_box(x)    isbox[(x)]
@@ -293,6 +327,9 @@ static uint8_t inv_affine(const uint8_t x)
 #endif
 }
 
+#undef  AES_T_TABLES
+#define AES_T_TABLES    0
+
 #define s_box(x)   fwd_affine(gf_inv(x))
 #define is_box(x)  gf_inv(inv_affine(x))
 #define gfm2_sb(x) f2(s_box(x))
@@ -473,6 +510,52 @@ static void inv_shift_sub_rows( uint8_t st[N_BLOCK] )
     dt[15] = gfm3_sb(st[12]) ^ s_box(st[1]) ^ s_box(st[6]) ^ gfm2_sb(st[11]);
   }
 
+#if ( AES_T_TABLES != 0 )
+
+/* the state is held as 4 column words, row 0 in the low byte */
+
+#define word_in(x, c)   ( ((uint32_t)(x)[4 * (c) + 0] <<  0) | ((uint32_t)(x)[4 * (c) + 1] <<  8) \
+                        | ((uint32_t)(x)[4 * (c) + 2] << 16) | ((uint32_t)(x)[4 * (c) + 3] << 24) )
+#define word_out(x, c, v)   { (x)[4 * (c) + 0] = (uint8_t)((v) >>  0); (x)[4 * (c) + 1] = (uint8_t)((v) >>  8); \
+                              (x)[4 * (c) + 2] = (uint8_t)((v) >> 16); (x)[4 * (c) + 3] = (uint8_t)((v) >> 24); }
+
+#define bval(x, n)      ((uint8_t)((x) >> (8 * (n))))
+#define rot1(x)         (((x) <<  8) | ((x) >> 24))
+#define rot2(x)         (((x) << 16) | ((x) >> 16))
+#define rot3(x)         (((x) << 24) | ((x) >>  8))
+
+#if ( AES_T_TABLES == 4 )
+#  define t_fn(n, x)    t_fn##n[(x)]
+#else
+#  define t_fn_0(x)     t_fn0[(x)]
+#  define t_fn_1(x)     rot1(t_fn0[(x)])
+#  define t_fn_2(x)     rot2(t_fn0[(x)])
+#  define t_fn_3(x)     rot3(t_fn0[(x)])
+#  define t_fn(n, x)    t_fn_##n(x)
+#endif
+
+/* one full round: SubBytes, ShiftRows, MixColumns and AddRoundKey */
+#define fwd_rnd(x, k, c)    ( t_fn(0, bval(x[(c)], 0)) ^ t_fn(1, bval(x[((c) + 1) & 3], 1)) \
+                            ^ t_fn(2, bval(x[((c) + 2) & 3], 2)) ^ t_fn(3, bval(x[((c) + 3) & 3], 3)) \
+                            ^ word_in(k, c) )
+
+/* last round: SubBytes, ShiftRows and AddRoundKey */
+#define fwd_lrnd(x, k, c)   ( ( (uint32_t)s_box(bval(x[(c)], 0)) \
+                            | ((uint32_t)s_box(bval(x[((c) + 1) & 3], 1)) <<  8) \
+                            | ((uint32_t)s_box(bval(x[((c) + 2) & 3], 2)) << 16) \
+                            | ((uint32_t)s_box(bval(x[((c) + 3) & 3], 3)) << 24) ) \
+                            ^ word_in(k, c) )
+
+static void enc_round( uint32_t y[N_COL], const uint32_t x[N_COL], const uint8_t k[N_BLOCK] )
+{
+    y[0] = fwd_rnd(x, k, 0);
+    y[1] = fwd_rnd(x, k, 1);
+    y[2] = fwd_rnd(x, k, 2);
+    y[3] = fwd_rnd(x, k, 3);
+}
+
+#endif
+
 #if defined( AES_DEC_PREKEYED )
 
 #if defined( VERSION_1 )
@@ -567,6 +650,38 @@ return_type lorawan_aes_set_key( const uint8_t key[], length_type keylen, lorawa
 
 return_type lorawan_aes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK], const lorawan_aes_context ctx[1] )
 {
+#if ( AES_T_TABLES != 0 )
+    if( ctx->rnd )
+    {
+        uint32_t s1[N_COL], s2[N_COL], t;
+        uint8_t r;
+
+        s1[0] = word_in(in, 0) ^ word_in(ctx->ksch, 0);
+        s1[1] = word_in(in, 1) ^ word_in(ctx->ksch, 1);
+        s1[2] = word_in(in, 2) ^ word_in(ctx->ksch, 2);
+        s1[3] = word_in(in, 3) ^ word_in(ctx->ksch, 3);
+
+        for( r = 1 ; r + 1 < ctx->rnd ; r += 2 )
+        {
+            enc_round( s2, s1, ctx->ksch + r * N_BLOCK );
+            enc_round( s1, s2, ctx->ksch + (r + 1) * N_BLOCK );
+        }
+        if( r < ctx->rnd )
+        {
+            enc_round( s2, s1, ctx->ksch + r * N_BLOCK );
+            s1[0] = s2[0]; s1[1] = s2[1]; s1[2] = s2[2]; s1[3] = s2[3];
+            ++r;
+        }
+
+        t = fwd_lrnd(s1, ctx->ksch + r * N_BLOCK, 0); word_out(out, 0, t);
+        t = fwd_lrnd(s1, ctx->ksch + r * N_BLOCK, 1); word_out(out, 1, t);
+        t = fwd_lrnd(s1, ctx->ksch + r * N_BLOCK, 2); word_out(out, 2, t);
+        t = fwd_lrnd(s1, ctx->ksch + r * N_BLOCK, 3); word_out(out, 3, t);
+    }
+    else
+        return ( uint8_t )-1;
+    return 0;
+#else
     if( ctx->rnd )
     {
         uint8_t s1[N_BLOCK], r;
@@ -590,6 +705,7 @@ return_type lorawan_aes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK
     else
         return ( uint8_t )-1;
     return 0;
+#endif
 }
 
 /* CBC encrypt a number of blocks (input and return an IV) */
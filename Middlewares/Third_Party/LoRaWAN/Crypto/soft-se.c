@@ -70,9 +70,32 @@
                                         + LORAMAC_JOIN_EUI_FIELD_SIZE + DEV_NONCE_SIZE + LORAMAC_MHDR_FIELD_SIZE )
 
 #if (LORAWAN_KMS == 0)
+/*!
+ * Number of expanded AES key schedules, with their CMAC subkeys, kept in RAM
+ * \remark Can be overloaded in lorawan_conf.h, shall be at least 1
+ */
+#ifndef SOFT_SE_AES_CTX_CACHE_NB
+#define SOFT_SE_AES_CTX_CACHE_NB             2U
+#endif /* SOFT_SE_AES_CTX_CACHE_NB */
+
+#if ( SOFT_SE_AES_CTX_CACHE_NB < 1 )
+#error "SOFT_SE_AES_CTX_CACHE_NB shall be at least 1"
+#endif /* SOFT_SE_AES_CTX_CACHE_NB */
 #else /* LORAWAN_KMS == 1 */
 #define DERIVED_OBJECT_HANDLE_RESET_VAL      0x0UL
 #define PAYLOAD_MAX_SIZE     270UL  /* 270 PHYPayload: 1+(22+1+242)+4 */
+/* Largest key stream chunk computed in a single KMS call: whole blocks fitting in the aligned buffers */
+#define CTR_CHUNK_MAX_SIZE   ( ( PAYLOAD_MAX_SIZE / SE_KEY_SIZE ) * SE_KEY_SIZE )
+#define KMS_SESSION_CLOSED   0UL    /* handle value of a session not opened */
+
+/*!
+ * Computes CMAC with C_SignUpdate/C_SignFinal on the caller buffers instead of a single C_Sign
+ * on a copy of the message
+ * \remark Can be overloaded in lorawan_conf.h, requires the KMS multi-part signature support
+ */
+#ifndef SOFT_SE_KMS_SIGN_UPDATE
+#define SOFT_SE_KMS_SIGN_UPDATE  0
+#endif /* SOFT_SE_KMS_SIGN_UPDATE */
 #endif /* LORAWAN_KMS */
 
 /* Private macro -------------------------------------------------------------*/
@@ -131,6 +154,35 @@ typedef struct SecureElementKeyLabel
     char *keyStr;
 } SecureElementKeyLabel_t;
 
+#if (LORAWAN_KMS == 0)
+/*!
+ * Expanded AES key schedule cache item
+ */
+typedef struct sAesCtxCacheItem
+{
+    /*!
+     * Expanded key schedule and CMAC subkeys
+     */
+    AES_CMAC_CTX CmacContext;
+    /*!
+     * Key identifier the schedule belongs to
+     */
+    KeyIdentifier_t KeyID;
+    /*!
+     * Key value the schedule has been expanded from
+     */
+    uint8_t KeyValue[SE_KEY_SIZE];
+    /*!
+     * Usage stamp for least recently used replacement
+     */
+    uint32_t LastUse;
+    /*!
+     * Set when the schedule is usable
+     */
+    bool IsValid;
+} AesCtxCacheItem_t;
+#endif /* LORAWAN_KMS == 0 */
+
 /* Private variables ---------------------------------------------------------*/
 /*!
  * Secure element context
@@ -194,6 +246,17 @@ static const SecureElementNvmData_t seNvmInit =
     .KeyList = SOFT_SE_KEY_LIST,
 };
 SOFT_SE_PLACE_IN_NVM_STOP
+
+/*
+ * Expanded AES key schedules, avoids to run the key expansion for each encrypted block
+ * and the CMAC subkeys generation for each MIC
+ */
+static AesCtxCacheItem_t AesCtxCache[SOFT_SE_AES_CTX_CACHE_NB];
+
+/*
+ * Usage stamp of the last AES key schedule cache access
+ */
+static uint32_t AesCtxCacheStamp = 0;
 #else /* LORAWAN_KMS == 1 */
 static Key_t KeyList[NUM_OF_KEYS] =
 {
@@ -249,6 +312,26 @@ static uint8_t input_align_combined_buf[PAYLOAD_MAX_SIZE + SE_KEY_SIZE] ALIGN( 4
 static uint8_t output_align[PAYLOAD_MAX_SIZE] ALIGN( 4 );
 
 static uint8_t tag[SE_KEY_SIZE] ALIGN( 4 ) = {0};
+
+/*
+ * Persistent KMS session, opened on first use and closed only on failure
+ */
+static CK_SESSION_HANDLE KmsSession = KMS_SESSION_CLOSED;
+
+/*
+ * Persistent KMS session dedicated to AES ECB, keeps its encrypt operation active between calls
+ */
+static CK_SESSION_HANDLE KmsCipherSession = KMS_SESSION_CLOSED;
+
+/*
+ * Key object the AES ECB operation of KmsCipherSession is initialized with
+ */
+static CK_OBJECT_HANDLE KmsCipherKey;
+
+/*
+ * Set when the AES ECB operation of KmsCipherSession is initialized
+ */
+static bool KmsCipherReady = false;
 #endif /* LORAWAN_KMS */
 
 /* Private functions prototypes ---------------------------------------------------*/
@@ -261,6 +344,31 @@ static uint8_t tag[SE_KEY_SIZE] ALIGN( 4 ) = {0};
  * \retval                    - Status of the operation
  */
 static SecureElementStatus_t GetKeyByID( KeyIdentifier_t keyID, Key_t **keyItem );
+
+/*
+ * Gets the expanded AES key schedule and CMAC subkeys of a key, computes them on cache miss
+ *
+ * \param [in] keyID          - Key identifier
+ * \param [out] cmacContext   - Expanded key schedule and CMAC subkeys reference
+ * \retval                    - Status of the operation
+ */
+static SecureElementStatus_t GetCmacContextByID( KeyIdentifier_t keyID, AES_CMAC_CTX **cmacContext );
+
+/*
+ * Drops the expanded AES key schedule of a key
+ *
+ * \param [in] keyID          - Key identifier
+ */
+static void InvalidateAesContext( KeyIdentifier_t keyID );
+
+/*
+ * Gets the CMAC context of the key of a stream, loaded with the stream chaining state
+ *
+ * \param [in] ctx            - CMAC stream context
+ * \param [out] cmacContext   - Loaded CMAC context reference
+ * \retval                    - Status of the operation
+ */
+static SecureElementStatus_t LoadCmacStream( CmacStreamCtx_t *ctx, AES_CMAC_CTX **cmacContext );
 #else /* LORAWAN_KMS == 1 */
 /*
  * Gets key index from key list in KMS table
@@ -279,6 +387,54 @@ static SecureElementStatus_t GetKeyIndexByID( KeyIdentifier_t keyID, CK_OBJECT_H
  * \retval                    - Status of the operation
  */
 static SecureElementStatus_t GetSpecificLabelByID( KeyIdentifier_t keyID, uint32_t *keyLabel );
+
+/*
+ * Gets the persistent KMS session, opens it if needed
+ *
+ * \param [out] session       - Session handle
+ * \retval                    - Status of the operation
+ */
+static CK_RV GetKmsSession( CK_SESSION_HANDLE *session );
+
+/*
+ * Closes the persistent KMS session after a failed operation, next call opens a fresh one
+ *
+ * \param [in] rv             - Status of the last operation done in the session
+ */
+static void ReleaseKmsSession( CK_RV rv );
+
+/*
+ * Gets the KMS cipher session with an AES ECB operation initialized with the given key
+ *
+ * \param [in] keyHandle      - Key object handle
+ * \param [out] session       - Session handle
+ * \retval                    - Status of the operation
+ */
+static CK_RV PrepareKmsCipher( CK_OBJECT_HANDLE keyHandle, CK_SESSION_HANDLE *session );
+
+/*
+ * Terminates the AES ECB operation of the KMS cipher session
+ */
+static void FinalizeKmsCipher( void );
+
+/*
+ * Closes the KMS cipher session after a failed operation, next call opens a fresh one
+ *
+ * \param [in] rv             - Status of the last operation done in the session
+ */
+static void ReleaseKmsCipher( CK_RV rv );
+
+#if (SOFT_SE_KMS_SIGN_UPDATE == 1)
+/*
+ * Signs the next part of a message, through the aligned buffer when the data is not 32-bit aligned
+ *
+ * \param [in] session        - Session handle with an active sign operation
+ * \param [in] buffer         - Data buffer
+ * \param [in] size           - Data buffer size
+ * \retval                    - Status of the operation
+ */
+static CK_RV KmsSignUpdate( CK_SESSION_HANDLE session, uint8_t *buffer, uint32_t size );
+#endif /* SOFT_SE_KMS_SIGN_UPDATE */
 #endif /* LORAWAN_KMS */
 
 /*
@@ -295,6 +451,15 @@ static void PrintKey( KeyIdentifier_t keyID );
  */
 static void PrintIds( ActivationType_t mode );
 
+/*
+ * XORs a buffer with a key stream, word-wide when the buffer is 32-bit aligned
+ *
+ * \param [in,out] buffer     - Data buffer
+ * \param [in] keyStream      - 32-bit aligned key stream
+ * \param [in] size           - Number of bytes to process
+ */
+static void XorKeyStream( uint8_t *buffer, const uint32_t *keyStream, uint32_t size );
+
 /*
  * Computes a CMAC of a message using provided initial Bx block
  *
@@ -378,6 +543,75 @@ static SecureElementStatus_t GetKeyByID( KeyIdentifier_t keyID, Key_t **keyItem
     return SECURE_ELEMENT_ERROR_INVALID_KEY_ID;
 }
 
+static SecureElementStatus_t GetCmacContextByID( KeyIdentifier_t keyID, AES_CMAC_CTX **cmacContext )
+{
+    Key_t *keyItem;
+    AesCtxCacheItem_t *cacheItem = &AesCtxCache[0];
+    SecureElementStatus_t retval = GetKeyByID( keyID, &keyItem );
+
+    if( retval != SECURE_ELEMENT_SUCCESS )
+    {
+        return retval;
+    }
+
+    AesCtxCacheStamp++;
+
+    for( uint8_t i = 0; i < SOFT_SE_AES_CTX_CACHE_NB; i++ )
+    {
+        if( ( AesCtxCache[i].IsValid == true ) && ( AesCtxCache[i].KeyID == keyID ) )
+        {
+            cacheItem = &AesCtxCache[i];
+            break;
+        }
+        /* Otherwise replace a free or the least recently used item */
+        if( ( cacheItem->IsValid == true ) &&
+            ( ( AesCtxCache[i].IsValid == false ) || ( AesCtxCache[i].LastUse < cacheItem->LastUse ) ) )
+        {
+            cacheItem = &AesCtxCache[i];
+        }
+    }
+
+    /* The key value is compared as the key list may be restored from NVM without SecureElementSetKey */
+    if( ( cacheItem->IsValid == false ) || ( cacheItem->KeyID != keyID ) ||
+        ( memcmp( cacheItem->KeyValue, keyItem->KeyValue, SE_KEY_SIZE ) != 0 ) )
+    {
+        AES_CMAC_SetKey( &cacheItem->CmacContext, keyItem->KeyValue );
+        memcpy1( cacheItem->KeyValue, keyItem->KeyValue, SE_KEY_SIZE );
+        cacheItem->KeyID = keyID;
+        cacheItem->IsValid = true;
+    }
+
+    cacheItem->LastUse = AesCtxCacheStamp;
+    *cmacContext = &cacheItem->CmacContext;
+
+    return SECURE_ELEMENT_SUCCESS;
+}
+
+static void InvalidateAesContext( KeyIdentifier_t keyID )
+{
+    for( uint8_t i = 0; i < SOFT_SE_AES_CTX_CACHE_NB; i++ )
+    {
+        if( AesCtxCache[i].KeyID == keyID )
+        {
+            memset1( ( uint8_t * )&AesCtxCache[i], 0, sizeof( AesCtxCacheItem_t ) );
+        }
+    }
+}
+
+static SecureElementStatus_t LoadCmacStream( CmacStreamCtx_t *ctx, AES_CMAC_CTX **cmacContext )
+{
+    /* The cached context may have been reused by other keys since the last call */
+    SecureElementStatus_t retval = GetCmacContextByID( ctx->KeyID, cmacContext );
+
+    if( retval == SECURE_ELEMENT_SUCCESS )
+    {
+        memcpy1( ( *cmacContext )->X, ctx->X, sizeof( ctx->X ) );
+        memcpy1( ( *cmacContext )->M_last, ctx->Last, sizeof( ctx->Last ) );
+        ( *cmacContext )->M_n = ctx->LastSize;
+    }
+    return retval;
+}
+
 #else /* LORAWAN_KMS == 1 */
 static SecureElementStatus_t GetKeyIndexByID( KeyIdentifier_t keyID, CK_OBJECT_HANDLE *keyIndex )
 {
@@ -414,8 +648,144 @@ static SecureElementStatus_t GetSpecificLabelByID( KeyIdentifier_t keyID, uint32
     }
     return SECURE_ELEMENT_ERROR_INVALID_KEY_ID;
 }
+
+static CK_RV GetKmsSession( CK_SESSION_HANDLE *session )
+{
+    CK_RV rv = CKR_OK;
+
+    if( KmsSession == KMS_SESSION_CLOSED )
+    {
+        rv = C_OpenSession( 0, CKF_SERIAL_SESSION, NULL, 0, &KmsSession );
+        if( rv != CKR_OK )
+        {
+            KmsSession = KMS_SESSION_CLOSED;
+        }
+    }
+
+    *session = KmsSession;
+    return rv;
+}
+
+static void ReleaseKmsSession( CK_RV rv )
+{
+    /* A failed operation may still be pending in the session */
+    if( ( rv != CKR_OK ) && ( KmsSession != KMS_SESSION_CLOSED ) )
+    {
+        ( void )C_CloseSession( KmsSession );
+        KmsSession = KMS_SESSION_CLOSED;
+    }
+}
+
+static CK_RV PrepareKmsCipher( CK_OBJECT_HANDLE keyHandle, CK_SESSION_HANDLE *session )
+{
+    CK_RV rv = CKR_OK;
+    CK_MECHANISM aes_ecb_mechanism = { CKM_AES_ECB, ( CK_VOID_PTR * ) NULL, 0 };
+
+    if( KmsCipherSession == KMS_SESSION_CLOSED )
+    {
+        rv = C_OpenSession( 0, CKF_SERIAL_SESSION, NULL, 0, &KmsCipherSession );
+        if( rv != CKR_OK )
+        {
+            KmsCipherSession = KMS_SESSION_CLOSED;
+            return rv;
+        }
+    }
+
+    if( ( KmsCipherReady == false ) || ( KmsCipherKey != keyHandle ) )
+    {
+        FinalizeKmsCipher( );
+
+        /* Configure session to encrypt message in AES ECB with settings included into the mechanism */
+        rv = C_EncryptInit( KmsCipherSession, &aes_ecb_mechanism, keyHandle );
+        if( rv == CKR_OK )
+        {
+            KmsCipherKey = keyHandle;
+            KmsCipherReady = true;
+        }
+    }
+
+    *session = KmsCipherSession;
+    return rv;
+}
+
+static void FinalizeKmsCipher( void )
+{
+    uint8_t dummy_tag[SE_KEY_SIZE] = {0};
+    uint32_t dummy_tag_length = sizeof( dummy_tag );
+
+    if( KmsCipherReady == true )
+    {
+        /* In this case C_EncryptFinal is just called to Free the Alloc mem */
+        ( void )C_EncryptFinal( KmsCipherSession, &dummy_tag[0], ( CK_ULONG_PTR )&dummy_tag_length );
+        KmsCipherReady = false;
+    }
+}
+
+static void ReleaseKmsCipher( CK_RV rv )
+{
+    /* Closing the session also terminates its active operation */
+    if( ( rv != CKR_OK ) && ( KmsCipherSession != KMS_SESSION_CLOSED ) )
+    {
+        ( void )C_CloseSession( KmsCipherSession );
+        KmsCipherSession = KMS_SESSION_CLOSED;
+        KmsCipherReady = false;
+    }
+}
+
+#if (SOFT_SE_KMS_SIGN_UPDATE == 1)
+static CK_RV KmsSignUpdate( CK_SESSION_HANDLE session, uint8_t *buffer, uint32_t size )
+{
+    CK_RV rv = CKR_OK;
+    uint32_t max_allocated_size = 0;
+
+    if( ( ( uintptr_t )buffer & 0x3UL ) == 0UL ) /* buffer address is aligned */
+    {
+        /* Sign the full message */
+        return C_SignUpdate( session, ( CK_BYTE_PTR )buffer, size );
+    }
+
+    /* Sign the message by block */
+    while( ( size != 0 ) && ( rv == CKR_OK ) )
+    {
+        if( size > sizeof( input_align_combined_buf ) )
+        {
+            max_allocated_size = sizeof( input_align_combined_buf );
+        }
+        else
+        {
+            max_allocated_size = size;
+        }
+
+        memcpy1( ( uint8_t * ) input_align_combined_buf, ( uint8_t * ) buffer, max_allocated_size );
+        rv = C_SignUpdate( session, ( CK_BYTE_PTR )input_align_combined_buf, max_allocated_size );
+        buffer += max_allocated_size;
+        size -= max_allocated_size;
+    }
+    return rv;
+}
+#endif /* SOFT_SE_KMS_SIGN_UPDATE */
 #endif /* LORAWAN_KMS */
 
+static void XorKeyStream( uint8_t *buffer, const uint32_t *keyStream, uint32_t size )
+{
+    uint32_t i = 0;
+
+    if( ( ( uintptr_t )buffer & 0x3UL ) == 0UL )
+    {
+        uint32_t *buffer32 = ( uint32_t * )buffer;
+
+        for( ; ( i + sizeof( uint32_t ) ) <= size; i += sizeof( uint32_t ) )
+        {
+            buffer32[i / sizeof( uint32_t )] ^= keyStream[i / sizeof( uint32_t )];
+        }
+    }
+
+    for( ; i < size; i++ )
+    {
+        buffer[i] ^= ( ( const uint8_t * )keyStream )[i];
+    }
+}
+
 static SecureElementStatus_t ComputeCmac( uint8_t *micBxBuffer, uint8_t *buffer, uint32_t size, KeyIdentifier_t keyID,
                                           uint32_t *cmac )
 {
@@ -426,25 +796,13 @@ static SecureElementStatus_t ComputeCmac( uint8_t *micBxBuffer, uint8_t *buffer,
 
 #if (LORAWAN_KMS == 0)
     uint8_t Cmac[16];
-    AES_CMAC_CTX aesCmacCtx[1];
-
-    AES_CMAC_Init( aesCmacCtx );
-
-    Key_t                *keyItem;
-    SecureElementStatus_t retval = GetKeyByID( keyID, &keyItem );
+    AES_CMAC_CTX         *cmacContext;
+    SecureElementStatus_t retval = GetCmacContextByID( keyID, &cmacContext );
 
     if( retval == SECURE_ELEMENT_SUCCESS )
     {
-        AES_CMAC_SetKey( aesCmacCtx, keyItem->KeyValue );
-
-        if( micBxBuffer != NULL )
-        {
-            AES_CMAC_Update( aesCmacCtx, micBxBuffer, MIC_BLOCK_BX_SIZE );
-        }
-
-        AES_CMAC_Update( aesCmacCtx, buffer, size );
-
-        AES_CMAC_Final( Cmac, aesCmacCtx );
+        /* The micBxBuffer block, when present, is processed ahead of the buffer without copy */
+        AES_CMAC_Compute( cmacContext, micBxBuffer, buffer, size, Cmac );
 
         /* Bring into the required format */
         *cmac = GET_UINT32_LE( Cmac, 0 );
@@ -452,13 +810,8 @@ static SecureElementStatus_t ComputeCmac( uint8_t *micBxBuffer, uint8_t *buffer,
 #else /* LORAWAN_KMS == 1 */
     CK_RV rv;
     CK_SESSION_HANDLE session;
-    CK_FLAGS session_flags = CKF_SERIAL_SESSION;    /* Read ONLY session */
     uint32_t tag_length = sizeof( tag );
     CK_OBJECT_HANDLE key_handle;
-#if 0 /* require C_SignUpdate and C_SignFinal KMS implementation */
-    uint32_t max_allocated_size = 0;
-    uint32_t buffer_addr = ( uint32_t )buffer;
-#endif /* 0 */
 
     /* AES CMAC Authentication variables */
     CK_MECHANISM aes_cmac_mechanism = { CKM_AES_CMAC, ( CK_VOID_PTR )NULL, 0 };
@@ -469,8 +822,8 @@ static SecureElementStatus_t ComputeCmac( uint8_t *micBxBuffer, uint8_t *buffer,
         return retval;
     }
 
-    /* Open session with KMS */
-    rv = C_OpenSession( 0,    session_flags, NULL, 0, &session );
+    /* Get the persistent session with KMS */
+    rv = GetKmsSession( &session );
 
     /* Configure session to Authentication message in AES CMAC with settings included into the mechanism */
     if( rv == CKR_OK )
@@ -478,10 +831,10 @@ static SecureElementStatus_t ComputeCmac( uint8_t *micBxBuffer, uint8_t *buffer,
         rv = C_SignInit( session, &aes_cmac_mechanism, key_handle );
     }
 
-#if 1 /* require C_SignUpdate and C_SignFinal KMS implementation */
+#if (SOFT_SE_KMS_SIGN_UPDATE == 0)
 #if (LORAWAN_PACKAGES_VERSION == 2)
-#warning the current implementation of ComputeCmac is not functional for LoRaMacProcessMicForDatablock method called by LmhpFragmentation due to memcpy overflow. \
-need to replace this code as below with C_SignUpdate and C_SignFinal methods usage.
+#warning the CMAC streams used by LmhpFragmentation for the data block MIC are not available without C_SignUpdate. \
+set SOFT_SE_KMS_SIGN_UPDATE to use C_SignUpdate and C_SignFinal methods.
 #endif /* LORAWAN_PACKAGES_VERSION */
     /* Encrypt clear message */
     if( rv == CKR_OK )
@@ -521,32 +874,10 @@ need to replace this code as below with C_SignUpdate and C_SignFinal methods usa
         }
     }
 
-    if( ( buffer_addr % 4 ) == 0 ) /* buffer address is aligned */
+    /* Sign the message */
+    if( rv == CKR_OK )
     {
-        /* Sign the full message */
-        if( rv == CKR_OK )
-        {
-            rv = C_SignUpdate( session, ( CK_BYTE_PTR )buffer, size );
-        }
-    }
-    else
-    {
-        /* Sign the message by block */
-        while( ( size != 0 ) && ( rv == CKR_OK ) )
-        {
-            if( size > sizeof( input_align_combined_buf ) )
-            {
-                max_allocated_size = sizeof( input_align_combined_buf );
-            }
-            else
-            {
-                max_allocated_size = size;
-            }
-
-            memcpy1( ( uint8_t * ) input_align_combined_buf, ( uint8_t * ) buffer, max_allocated_size );
-            rv = C_SignUpdate( session, ( CK_BYTE_PTR )input_align_combined_buf, max_allocated_size );
-            size -= max_allocated_size;
-        }
+        rv = KmsSignUpdate( session, buffer, size );
     }
 
     /* Finishes a multiple-part signature operation */
@@ -554,10 +885,10 @@ need to replace this code as below with C_SignUpdate and C_SignFinal methods usa
     {
         rv = C_SignFinal( session, tag, ( CK_ULONG_PTR )&tag_length );
     }
-#endif /* 0 */
+#endif /* SOFT_SE_KMS_SIGN_UPDATE */
 
-    /* Close session with KMS */
-    ( void )C_CloseSession( session );
+    /* Keep the session open unless it failed */
+    ReleaseKmsSession( rv );
 
     /* combine to a 32bit authentication word (MIC) */
     *cmac = GET_UINT32_LE( tag, 0 );
@@ -587,18 +918,23 @@ SecureElementStatus_t SecureElementInit( SecureElementNvmData_t *nvm )
 #if (LORAWAN_KMS == 0)
     /* Initialize data */
     memcpy1( ( uint8_t * )SeNvm, ( uint8_t * )&seNvmInit, sizeof( seNvmInit ) );
+
+    /* Drop all expanded key schedules */
+    memset1( ( uint8_t * )AesCtxCache, 0, sizeof( AesCtxCache ) );
 #else /* LORAWAN_KMS == 1 */
     SeNvm->reserved = 0;
     CK_RV rv;
     CK_SESSION_HANDLE session;
     uint32_t ulCount;
-    CK_FLAGS session_flags = CKF_SERIAL_SESSION;  /* Read ONLY session */
     CK_OBJECT_HANDLE hObject[NUM_OF_KEYS];
     CK_ULONG local_template_label[] = {GlobalTemplateLabel, 0UL};
     CK_ATTRIBUTE key_template = {CKA_LABEL, ( CK_VOID_PTR )local_template_label, sizeof( local_template_label )};
 
-    /* Open session with KMS */
-    rv = C_OpenSession( 0, session_flags, NULL, 0, &session );
+    /* Key object handles are looked up again */
+    FinalizeKmsCipher( );
+
+    /* Get the persistent session with KMS */
+    rv = GetKmsSession( &session );
 
     for( uint8_t itr = 0; itr < NUM_OF_KEYS; itr++ )
     {
@@ -628,11 +964,8 @@ SecureElementStatus_t SecureElementInit( SecureElementNvmData_t *nvm )
             }
         }
     }
-    /* Close sessions */
-    if( session > 0 )
-    {
-        ( void )C_CloseSession( session );
-    }
+    /* Keep the session open unless it failed */
+    ReleaseKmsSession( rv );
 
 #endif /* LORAWAN_KMS */
 
@@ -697,7 +1030,6 @@ SecureElementStatus_t SecureElementGetKeyByID( KeyIdentifier_t keyID, uint8_t *e
 {
     CK_RV rv;
     CK_SESSION_HANDLE session;
-    CK_FLAGS session_flags = CKF_SERIAL_SESSION;  /* Read ONLY session */
     CK_OBJECT_HANDLE key_handle = ( CK_OBJECT_HANDLE )( ~0UL );
     CK_ULONG derive_key_template_class = CKO_SECRET_KEY;
     uint32_t size = SE_KEY_SIZE;
@@ -718,8 +1050,8 @@ SecureElementStatus_t SecureElementGetKeyByID( KeyIdentifier_t keyID, uint8_t *e
         return SECURE_ELEMENT_ERROR_INVALID_KEY_ID;
     }
 
-    /* Open session with KMS */
-    rv = C_OpenSession( 0, session_flags, NULL, 0, &session );
+    /* Get the persistent session with KMS */
+    rv = GetKmsSession( &session );
 
     /* Get key to display */
     if( rv == CKR_OK )
@@ -728,8 +1060,8 @@ SecureElementStatus_t SecureElementGetKeyByID( KeyIdentifier_t keyID, uint8_t *e
         rv = C_GetAttributeValue( session, key_handle, &key_attribute_template, 1UL );
     }
 
-    /* Close sessions */
-    ( void )C_CloseSession( session );
+    /* Keep the session open unless it failed */
+    ReleaseKmsSession( rv );
 
     if( rv != CKR_OK )
     {
@@ -781,7 +1113,6 @@ SecureElementStatus_t SecureElementDeleteDynamicKey( KeyIdentifier_t keyID, uint
 #else /* LORAWAN_KMS == 1 */
     CK_RV rv;
     CK_SESSION_HANDLE session;
-    CK_FLAGS session_flags = CKF_SERIAL_SESSION;    /* Read ONLY session */
     CK_OBJECT_HANDLE hObject[NUM_OF_KEYS];
     CK_ULONG local_template_label[] = {GlobalTemplateLabel, 0UL};
     CK_ATTRIBUTE dynamic_key_template =
@@ -801,8 +1132,11 @@ SecureElementStatus_t SecureElementDeleteDynamicKey( KeyIdentifier_t keyID, uint
     }
     *key_label = local_template_label[1];
 
-    /* Open session with KMS */
-    rv = C_OpenSession( 0,    session_flags, NULL, 0, &session );
+    /* The key object may be the one the cipher session operation is initialized with */
+    FinalizeKmsCipher( );
+
+    /* Get the persistent session with KMS */
+    rv = GetKmsSession( &session );
 
     /* Search from Template pattern */
     if( rv == CKR_OK )
@@ -832,11 +1166,8 @@ SecureElementStatus_t SecureElementDeleteDynamicKey( KeyIdentifier_t keyID, uint
         }
     }
 
-    /* Close sessions */
-    if( session > 0 )
-    {
-        ( void )C_CloseSession( session );
-    }
+    /* Keep the session open unless it failed */
+    ReleaseKmsSession( rv );
 
     if( rv != CKR_OK )
     {
@@ -888,11 +1219,13 @@ SecureElementStatus_t SecureElementSetKey( KeyIdentifier_t keyID, uint8_t *key )
                 retval = SecureElementAesEncrypt( key, SE_KEY_SIZE, MC_KE_KEY, decryptedKey );
 
                 memcpy1( SeNvm->KeyList[i].KeyValue, decryptedKey, SE_KEY_SIZE );
+                InvalidateAesContext( keyID );
                 return retval;
             }
             else
             {
                 memcpy1( SeNvm->KeyList[i].KeyValue, key, SE_KEY_SIZE );
+                InvalidateAesContext( keyID );
                 return SECURE_ELEMENT_SUCCESS;
             }
         }
@@ -903,7 +1236,6 @@ SecureElementStatus_t SecureElementSetKey( KeyIdentifier_t keyID, uint8_t *key )
     SecureElementStatus_t retval = SECURE_ELEMENT_ERROR;
     CK_RV rv;
     CK_SESSION_HANDLE session;
-    CK_FLAGS session_flags = CKF_SERIAL_SESSION;  /* Read ONLY session */
     CK_OBJECT_HANDLE key_handle;
     CK_ULONG template_class = CKO_SECRET_KEY;
     CK_ULONG template_type = CKK_AES;
@@ -963,8 +1295,8 @@ SecureElementStatus_t SecureElementSetKey( KeyIdentifier_t keyID, uint8_t *key )
         return SECURE_ELEMENT_ERROR;
     }
 
-    /* Open session with KMS */
-    rv = C_OpenSession( 0, session_flags, NULL, 0, &session );
+    /* Get the persistent session with KMS */
+    rv = GetKmsSession( &session );
 
     /* Get key to display */
     if( rv == CKR_OK )
@@ -978,8 +1310,8 @@ SecureElementStatus_t SecureElementSetKey( KeyIdentifier_t keyID, uint8_t *key )
         retval = SecureElementSetObjHandler( keyID, key_handle );
     }
 
-    /* Close sessions */
-    ( void )C_CloseSession( session );
+    /* Keep the session open unless it failed */
+    ReleaseKmsSession( rv );
 
     if( rv != CKR_OK )
     {
@@ -998,7 +1330,6 @@ SecureElementStatus_t SecureElementSetID( SecureElementNvmDevJoinAddrKey_t *KMSK
     CK_RV rv;
     CK_SESSION_HANDLE session;
     KeyIdentifier_t keyID = DEV_JOIN_EUI_ADDR_KEY;
-    CK_FLAGS session_flags = CKF_SERIAL_SESSION;  /* Read ONLY session */
     CK_OBJECT_HANDLE key_handle;
     CK_ULONG template_class = CKO_SECRET_KEY;
     CK_ULONG template_type = CKK_AES;
@@ -1039,8 +1370,8 @@ SecureElementStatus_t SecureElementSetID( SecureElementNvmDevJoinAddrKey_t *KMSK
         return SECURE_ELEMENT_ERROR;
     }
 
-    /* Open session with KMS */
-    rv = C_OpenSession( 0, session_flags, NULL, 0, &session );
+    /* Get the persistent session with KMS */
+    rv = GetKmsSession( &session );
 
     /* Get key to display */
     if( rv == CKR_OK )
@@ -1054,8 +1385,8 @@ SecureElementStatus_t SecureElementSetID( SecureElementNvmDevJoinAddrKey_t *KMSK
         retval = SecureElementSetObjHandler( keyID, key_handle );
     }
 
-    /* Close sessions */
-    ( void )C_CloseSession( session );
+    /* Keep the session open unless it failed */
+    ReleaseKmsSession( rv );
 
     if( rv != CKR_OK )
     {
@@ -1077,6 +1408,159 @@ SecureElementStatus_t SecureElementComputeAesCmac( uint8_t *micBxBuffer, uint8_t
     return ComputeCmac( micBxBuffer, buffer, size, keyID, cmac );
 }
 
+SecureElementStatus_t SecureElementAesCmacStreamStart( CmacStreamCtx_t *ctx, uint8_t *micBxBuffer, KeyIdentifier_t keyID )
+{
+    if( ctx == NULL )
+    {
+        return SECURE_ELEMENT_ERROR_NPE;
+    }
+    if( keyID >= MC_KE_KEY )
+    {
+        /* Never accept multicast key identifier for cmac computation */
+        return SECURE_ELEMENT_ERROR_INVALID_KEY_ID;
+    }
+
+    memset1( ( uint8_t * )ctx, 0, sizeof( CmacStreamCtx_t ) );
+    ctx->KeyID = keyID;
+
+#if (LORAWAN_KMS == 0)
+    AES_CMAC_CTX *cmacContext;
+
+    if( micBxBuffer != NULL )
+    {
+        return SecureElementAesCmacStreamUpdate( ctx, micBxBuffer, MIC_BLOCK_BX_SIZE );
+    }
+    /* Only checks the key */
+    return GetCmacContextByID( keyID, &cmacContext );
+#elif (SOFT_SE_KMS_SIGN_UPDATE == 1)
+    CK_RV rv;
+    CK_SESSION_HANDLE session = KMS_SESSION_CLOSED;
+    CK_OBJECT_HANDLE key_handle;
+
+    /* AES CMAC Authentication variables */
+    CK_MECHANISM aes_cmac_mechanism = { CKM_AES_CMAC, ( CK_VOID_PTR )NULL, 0 };
+
+    SecureElementStatus_t retval = GetKeyIndexByID( keyID, &key_handle );
+    if( retval != SECURE_ELEMENT_SUCCESS )
+    {
+        return retval;
+    }
+
+    /* The sign operation stays active between the calls in a session of its own */
+    rv = C_OpenSession( 0, CKF_SERIAL_SESSION, NULL, 0, &session );
+    if( rv != CKR_OK )
+    {
+        return SECURE_ELEMENT_ERROR;
+    }
+
+    rv = C_SignInit( session, &aes_cmac_mechanism, key_handle );
+
+    /* Sign the partial start message if exists */
+    if( ( rv == CKR_OK ) && ( micBxBuffer != NULL ) )
+    {
+        rv = KmsSignUpdate( session, micBxBuffer, MIC_BLOCK_BX_SIZE );
+    }
+
+    if( rv != CKR_OK )
+    {
+        ( void )C_CloseSession( session );
+        return SECURE_ELEMENT_ERROR;
+    }
+    ctx->Session = ( uint32_t )session;
+    return SECURE_ELEMENT_SUCCESS;
+#else
+    /* The streams need the KMS multi-part signature, see SOFT_SE_KMS_SIGN_UPDATE */
+    ( void )micBxBuffer;
+    return SECURE_ELEMENT_ERROR;
+#endif /* LORAWAN_KMS */
+}
+
+SecureElementStatus_t SecureElementAesCmacStreamUpdate( CmacStreamCtx_t *ctx, uint8_t *buffer, uint32_t size )
+{
+    if( ( ctx == NULL ) || ( ( buffer == NULL ) && ( size != 0 ) ) )
+    {
+        return SECURE_ELEMENT_ERROR_NPE;
+    }
+
+#if (LORAWAN_KMS == 0)
+    AES_CMAC_CTX *cmacContext;
+    SecureElementStatus_t retval = LoadCmacStream( ctx, &cmacContext );
+
+    if( retval == SECURE_ELEMENT_SUCCESS )
+    {
+        AES_CMAC_Update( cmacContext, buffer, size );
+
+        /* Only the chaining state is kept, the cached context is shared by all the CMACs of the key */
+        memcpy1( ctx->X, cmacContext->X, sizeof( ctx->X ) );
+        memcpy1( ctx->Last, cmacContext->M_last, sizeof( ctx->Last ) );
+        ctx->LastSize = ( uint8_t )cmacContext->M_n;
+    }
+    return retval;
+#elif (SOFT_SE_KMS_SIGN_UPDATE == 1)
+    if( ctx->Session == KMS_SESSION_CLOSED )
+    {
+        return SECURE_ELEMENT_ERROR;
+    }
+
+    if( KmsSignUpdate( ( CK_SESSION_HANDLE )ctx->Session, buffer, size ) != CKR_OK )
+    {
+        ( void )C_CloseSession( ( CK_SESSION_HANDLE )ctx->Session );
+        ctx->Session = KMS_SESSION_CLOSED;
+        return SECURE_ELEMENT_ERROR;
+    }
+    return SECURE_ELEMENT_SUCCESS;
+#else
+    return SECURE_ELEMENT_ERROR;
+#endif /* LORAWAN_KMS */
+}
+
+SecureElementStatus_t SecureElementAesCmacStreamFinish( CmacStreamCtx_t *ctx, uint32_t *cmac )
+{
+    if( ( ctx == NULL ) || ( cmac == NULL ) )
+    {
+        return SECURE_ELEMENT_ERROR_NPE;
+    }
+
+#if (LORAWAN_KMS == 0)
+    uint8_t Cmac[16];
+    AES_CMAC_CTX *cmacContext;
+    SecureElementStatus_t retval = LoadCmacStream( ctx, &cmacContext );
+
+    if( retval == SECURE_ELEMENT_SUCCESS )
+    {
+        AES_CMAC_Final( Cmac, cmacContext );
+
+        /* Bring into the required format */
+        *cmac = GET_UINT32_LE( Cmac, 0 );
+    }
+    return retval;
+#elif (SOFT_SE_KMS_SIGN_UPDATE == 1)
+    CK_RV rv;
+    uint32_t tag_length = sizeof( tag );
+
+    if( ctx->Session == KMS_SESSION_CLOSED )
+    {
+        return SECURE_ELEMENT_ERROR;
+    }
+
+    /* Finishes the multiple-part signature operation and releases its session */
+    rv = C_SignFinal( ( CK_SESSION_HANDLE )ctx->Session, tag, ( CK_ULONG_PTR )&tag_length );
+    ( void )C_CloseSession( ( CK_SESSION_HANDLE )ctx->Session );
+    ctx->Session = KMS_SESSION_CLOSED;
+
+    if( rv != CKR_OK )
+    {
+        return SECURE_ELEMENT_ERROR;
+    }
+
+    /* combine to a 32bit authentication word (MIC) */
+    *cmac = GET_UINT32_LE( tag, 0 );
+    return SECURE_ELEMENT_SUCCESS;
+#else
+    return SECURE_ELEMENT_ERROR;
+#endif /* LORAWAN_KMS */
+}
+
 SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t *buffer, uint32_t size, uint32_t expectedCmac,
                                                   KeyIdentifier_t keyID )
 {
@@ -1101,7 +1585,6 @@ SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t *buffer, uint32_t size
 #else /* LORAWAN_KMS == 1 */
     CK_RV rv;
     CK_SESSION_HANDLE session;
-    CK_FLAGS session_flags = CKF_SERIAL_SESSION;    /* Read ONLY session */
     CK_OBJECT_HANDLE object_handle;
 
     if( buffer == NULL )
@@ -1118,8 +1601,8 @@ SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t *buffer, uint32_t size
         return retval;
     }
 
-    /* Open session with KMS */
-    rv = C_OpenSession( 0,    session_flags, NULL, 0, &session );
+    /* Get the persistent session with KMS */
+    rv = GetKmsSession( &session );
 
     /* Configure session to Verify the message in AES CMAC with settings included into the mechanism */
     if( rv == CKR_OK )
@@ -1134,7 +1617,8 @@ SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t *buffer, uint32_t size
         rv = C_Verify( session, ( CK_BYTE_PTR )input_align_combined_buf, size, ( CK_BYTE_PTR )&expectedCmac, 4 );
     }
 
-    ( void )C_CloseSession( session );
+    /* Keep the session open unless it failed */
+    ReleaseKmsSession( rv );
 
     if( rv != CKR_OK )
     {
@@ -1161,21 +1645,16 @@ SecureElementStatus_t SecureElementAesEncrypt( uint8_t *buffer, uint32_t size, K
     }
 
 #if (LORAWAN_KMS == 0)
-    lorawan_aes_context aesContext;
-    memset1( aesContext.ksch, '\0', 240 );
-
-    Key_t                *pItem;
-    SecureElementStatus_t retval = GetKeyByID( keyID, &pItem );
+    AES_CMAC_CTX         *cmacContext;
+    SecureElementStatus_t retval = GetCmacContextByID( keyID, &cmacContext );
 
     if( retval == SECURE_ELEMENT_SUCCESS )
     {
-        lorawan_aes_set_key( pItem->KeyValue, SE_KEY_SIZE, &aesContext );
-
         uint8_t block = 0;
 
         while( size != 0 )
         {
-            lorawan_aes_encrypt( &buffer[block], &encBuffer[block], &aesContext );
+            lorawan_aes_encrypt( &buffer[block], &encBuffer[block], &cmacContext->rijndael );
             block = block + 16;
             size  = size - 16;
         }
@@ -1183,13 +1662,8 @@ SecureElementStatus_t SecureElementAesEncrypt( uint8_t *buffer, uint32_t size, K
 #else /* LORAWAN_KMS == 1 */
     CK_RV rv;
     CK_SESSION_HANDLE session;
-    CK_FLAGS session_flags = CKF_SERIAL_SESSION;    /* Read ONLY session */
     uint32_t encrypted_length = 0;
     CK_OBJECT_HANDLE object_handle;
-    uint8_t dummy_tag[SE_KEY_SIZE] = {0};
-    uint32_t dummy_tag_length = 0;
-
-    CK_MECHANISM aes_ecb_mechanism = { CKM_AES_ECB, ( CK_VOID_PTR * ) NULL, 0 };
 
     SecureElementStatus_t retval = GetKeyIndexByID( keyID, &object_handle );
     if( retval != SECURE_ELEMENT_SUCCESS )
@@ -1197,14 +1671,8 @@ SecureElementStatus_t SecureElementAesEncrypt( uint8_t *buffer, uint32_t size, K
         return retval;
     }
 
-    /* Open session with KMS */
-    rv = C_OpenSession( 0,    session_flags, NULL, 0, &session );
-
-    /* Configure session to encrypt message in AES ECB with settings included into the mechanism */
-    if( rv == CKR_OK )
-    {
-        rv = C_EncryptInit( session, &aes_ecb_mechanism, object_handle );
-    }
+    /* Get the cipher session with KMS, AES ECB is initialized again only when the key changes */
+    rv = PrepareKmsCipher( object_handle, &session );
 
     /* Encrypt clear message */
     if( rv == CKR_OK )
@@ -1216,15 +1684,96 @@ SecureElementStatus_t SecureElementAesEncrypt( uint8_t *buffer, uint32_t size, K
         memcpy1( encBuffer, output_align, size );
     }
 
-    /* In this case C_EncryptFinal is just called to Free the Alloc mem */
-    if( rv == CKR_OK )
+    /* Keep the cipher operation active unless it failed */
+    ReleaseKmsCipher( rv );
+
+    if( rv != CKR_OK )
     {
-        dummy_tag_length = sizeof( tag );
-        rv = C_EncryptFinal( session, &dummy_tag[0], ( CK_ULONG_PTR )&dummy_tag_length );
+        retval = SECURE_ELEMENT_ERROR;
+    }
+#endif /* LORAWAN_KMS */
+
+    return retval;
+}
+
+SecureElementStatus_t SecureElementAesCtrXor( KeyIdentifier_t keyID, uint8_t *aBlock, uint8_t ctrStart,
+                                              uint8_t *buffer, uint32_t size )
+{
+    if( ( aBlock == NULL ) || ( buffer == NULL ) )
+    {
+        return SECURE_ELEMENT_ERROR_NPE;
+    }
+
+    SecureElementStatus_t retval = SECURE_ELEMENT_SUCCESS;
+    uint8_t ctr = ctrStart;
+    uint32_t bufferIndex = 0;
+
+#if (LORAWAN_KMS == 0)
+    uint32_t ctrBlock[SE_KEY_SIZE / sizeof( uint32_t )];
+    uint32_t sBlock[SE_KEY_SIZE / sizeof( uint32_t )];
+    AES_CMAC_CTX *cmacContext;
+
+    /* One key schedule for the whole buffer */
+    retval = GetCmacContextByID( keyID, &cmacContext );
+    if( retval != SECURE_ELEMENT_SUCCESS )
+    {
+        return retval;
+    }
+
+    memcpy1( ( uint8_t * )ctrBlock, aBlock, SE_KEY_SIZE );
+
+    while( size > 0 )
+    {
+        uint32_t blockSize = ( size > SE_KEY_SIZE ) ? SE_KEY_SIZE : size;
+
+        ( ( uint8_t * )ctrBlock )[SE_KEY_SIZE - 1] = ctr++;
+        lorawan_aes_encrypt( ( uint8_t * )ctrBlock, ( uint8_t * )sBlock, &cmacContext->rijndael );
+
+        XorKeyStream( &buffer[bufferIndex], sBlock, blockSize );
+        size -= blockSize;
+        bufferIndex += blockSize;
+    }
+#else /* LORAWAN_KMS == 1 */
+    CK_RV rv;
+    CK_SESSION_HANDLE session;
+    uint32_t encrypted_length = 0;
+    CK_OBJECT_HANDLE object_handle;
+
+    retval = GetKeyIndexByID( keyID, &object_handle );
+    if( retval != SECURE_ELEMENT_SUCCESS )
+    {
+        return retval;
+    }
+
+    /* Get the cipher session with KMS, AES ECB is initialized again only when the key changes */
+    rv = PrepareKmsCipher( object_handle, &session );
+
+    /* Encrypt all the counter blocks fitting in the aligned buffers at once */
+    while( ( size > 0 ) && ( rv == CKR_OK ) )
+    {
+        uint32_t chunkSize = ( size > CTR_CHUNK_MAX_SIZE ) ? CTR_CHUNK_MAX_SIZE : size;
+        uint32_t nbBlocks = ( chunkSize + SE_KEY_SIZE - 1 ) / SE_KEY_SIZE;
+
+        for( uint32_t i = 0; i < nbBlocks; i++ )
+        {
+            memcpy1( &input_align_combined_buf[i * SE_KEY_SIZE], aBlock, SE_KEY_SIZE );
+            input_align_combined_buf[( i * SE_KEY_SIZE ) + SE_KEY_SIZE - 1] = ctr++;
+        }
+
+        encrypted_length = sizeof( output_align );
+        rv = C_EncryptUpdate( session, ( CK_BYTE_PTR )input_align_combined_buf, nbBlocks * SE_KEY_SIZE,
+                              output_align, ( CK_ULONG_PTR )&encrypted_length );
+
+        if( rv == CKR_OK )
+        {
+            XorKeyStream( &buffer[bufferIndex], ( uint32_t * )output_align, chunkSize );
+        }
+        size -= chunkSize;
+        bufferIndex += chunkSize;
     }
 
-    /* Close session with KMS */
-    ( void )C_CloseSession( session );
+    /* Keep the cipher operation active unless it failed */
+    ReleaseKmsCipher( rv );
 
     if( rv != CKR_OK )
     {
@@ -1274,7 +1823,6 @@ SecureElementStatus_t SecureElementDeriveAndStoreKey( uint8_t *input, KeyIdentif
 #else /* LORAWAN_KMS == 1 */
     CK_RV rv;
     CK_SESSION_HANDLE session;
-    CK_FLAGS session_flags = CKF_SERIAL_SESSION;    /* Read ONLY session */
     /* Key derivation */
     CK_MECHANISM            mech = {CKM_AES_ECB_ENCRYPT_DATA, input, SE_KEY_SIZE};
     CK_OBJECT_HANDLE  derived_object_handle;
@@ -1298,8 +1846,8 @@ SecureElementStatus_t SecureElementDeriveAndStoreKey( uint8_t *input, KeyIdentif
         return SECURE_ELEMENT_ERROR;
     }
 
-    /* Open session with KMS */
-    rv = C_OpenSession( 0,    session_flags, NULL, 0, &session );
+    /* Get the persistent session with KMS */
+    rv = GetKmsSession( &session );
 
     /* Derive key with pass phrase */
     if( rv == CKR_OK )
@@ -1314,8 +1862,8 @@ SecureElementStatus_t SecureElementDeriveAndStoreKey( uint8_t *input, KeyIdentif
         retval = SecureElementSetObjHandler( targetKeyID, derived_object_handle );
     }
 
-    /* Close session with KMS */
-    ( void )C_CloseSession( session );
+    /* Keep the session open unless it failed */
+    ReleaseKmsSession( rv );
 
     if( rv != CKR_OK )
     {
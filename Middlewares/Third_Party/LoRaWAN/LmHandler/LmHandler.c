@@ -418,16 +418,19 @@ LmHandlerErrorStatus_t LmHandlerConfigure( LmHandlerParams_t *handlerParams )
     }
     else
     {
-        /* Restore context data backup from user callback (stored in FLASH) */
+        int32_t nvmStatus;
+
+        /* Restore context data backup from the NVM log, or from user callback (stored in FLASH) */
         mibReq.Type = MIB_NVM_BKP_CTXS;
-        if( LmHandlerCallbacks->OnRestoreContextRequest != NULL )
+        LoRaMacMibGetRequestConfirm( &mibReq );
+        nvmStatus = NvmDataMgmtRestore( mibReq.Param.BackupContexts );
+        if( ( nvmStatus == NVM_DATA_DISABLED ) && ( LmHandlerCallbacks->OnRestoreContextRequest != NULL ) )
         {
-            LoRaMacMibGetRequestConfirm( &mibReq );
             LmHandlerCallbacks->OnRestoreContextRequest( mibReq.Param.BackupContexts, sizeof( LoRaMacNvmData_t ) );
         }
-        /* Restore context data from backup to main nvm structure */
+        /* Restore context data from backup to main nvm structure, unless the NVM log could not be read */
         mibReq.Type = MIB_NVM_CTXS;
-        if( LoRaMacMibSetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK )
+        if( ( nvmStatus != NVM_DATA_ERROR ) && ( LoRaMacMibSetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK ) )
         {
             mibReq.Type = MIB_NETWORK_ACTIVATION;
             LoRaMacMibGetRequestConfirm( &mibReq );
@@ -2103,7 +2106,7 @@ LmHandlerErrorStatus_t LmHandlerNvmDataStore( void )
         {
             lmhStatus = LORAMAC_HANDLER_NVM_DATA_UP_TO_DATE;
         }
-        else if( ( status != NVM_DATA_OK ) || ( LmHandlerCallbacks->OnStoreContextRequest == NULL ) )
+        else if( status != NVM_DATA_OK )
         {
             lmhStatus = LORAMAC_HANDLER_ERROR;
         }
@@ -2113,8 +2116,25 @@ LmHandlerErrorStatus_t LmHandlerNvmDataStore( void )
             mibReq.Type = MIB_NVM_CTXS;
             LoRaMacMibGetRequestConfirm( &mibReq );
             nvm = ( LoRaMacNvmData_t * )mibReq.Param.Contexts;
-            nvm_size = ( ( sizeof( LoRaMacNvmData_t ) + 7 ) & ~0x07 );
-            LmHandlerCallbacks->OnStoreContextRequest( nvm, nvm_size );
+
+            /* Append the modified groups to the NVM log, or store the whole context from user callback */
+            status = NvmDataMgmtStore( nvm );
+            if( status == NVM_DATA_DISABLED )
+            {
+                if( LmHandlerCallbacks->OnStoreContextRequest != NULL )
+                {
+                    nvm_size = ( ( sizeof( LoRaMacNvmData_t ) + 7 ) & ~0x07 );
+                    LmHandlerCallbacks->OnStoreContextRequest( nvm, nvm_size );
+                }
+                else
+                {
+                    lmhStatus = LORAMAC_HANDLER_ERROR;
+                }
+            }
+            else if( status != NVM_DATA_OK )
+            {
+                lmhStatus = LORAMAC_HANDLER_ERROR;
+            }
         }
 
         if( NvmDataMgmtStoreEnd() != NVM_DATA_OK )
@@ -243,6 +243,8 @@ typedef struct LmHandlerCallbacks_s
     /*!
      * Notifies the upper layer that an applicative frame has been received
      *
+     * \remark appData->Buffer is only valid during the call
+     *
      * \param [in] appData Received applicative data
      * \param [in] params notification parameters
      */
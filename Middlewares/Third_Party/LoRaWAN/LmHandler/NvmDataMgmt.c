@@ -40,6 +40,7 @@
   * @brief   NVM context management implementation
   ******************************************************************************
   */
+#include <stddef.h>
 #include "utilities.h"
 #include "LoRaMac.h"
 #include "NvmDataMgmt.h"
@@ -52,7 +53,185 @@
 #endif /* CONTEXT_MANAGEMENT_ENABLED */
 
 #if ( CONTEXT_MANAGEMENT_ENABLED == 1 )
+/*!
+ * Size of one of the two NVM context log areas, multiple of the flash page size.
+ * Shall hold the area header and one record of each NVM group.
+ * \remark Can be overloaded in lorawan_conf.h
+ */
+#ifndef NVM_DATA_LOG_AREA_SIZE
+#define NVM_DATA_LOG_AREA_SIZE             4096
+#endif /* NVM_DATA_LOG_AREA_SIZE */
+
+/*!
+ * Flash programming granularity of the NVM context log, power of 2
+ * \remark Can be overloaded in lorawan_conf.h
+ */
+#ifndef NVM_DATA_LOG_WRITE_SIZE
+#define NVM_DATA_LOG_WRITE_SIZE            8
+#endif /* NVM_DATA_LOG_WRITE_SIZE */
+
+#if ( ( NVM_DATA_LOG_WRITE_SIZE & ( NVM_DATA_LOG_WRITE_SIZE - 1 ) ) != 0 )
+#error "NVM_DATA_LOG_WRITE_SIZE shall be a power of 2"
+#endif /* NVM_DATA_LOG_WRITE_SIZE */
+
+/*!
+ * Marks a valid log area header
+ */
+#define NVM_DATA_LOG_MAGIC                 0x4C4D564EUL
+
+/*!
+ * Value of erased flash words
+ */
+#define NVM_DATA_LOG_ERASED                0xFFFFFFFFUL
+
+/*!
+ * No valid log area
+ */
+#define NVM_DATA_LOG_NO_AREA               0xFF
+
+/*!
+ * Number of NVM groups, one per LORAMAC_NVM_NOTIFY_FLAG_XXX
+ */
+#define NVM_DATA_LOG_NB_GROUPS             7
+
+/*!
+ * Size of the chunks used to read back the records
+ */
+#define NVM_DATA_LOG_CHUNK_SIZE            32
+
+#define NVM_DATA_LOG_ALIGN( size )         ( ( ( size ) + NVM_DATA_LOG_WRITE_SIZE - 1 ) & ~( NVM_DATA_LOG_WRITE_SIZE - 1 ) )
+
+/*!
+ * Log area header, written once the area holds a full copy of the context
+ */
+typedef struct sNvmDataLogArea
+{
+    uint32_t Magic;
+    uint32_t Sequence;
+} NvmDataLogArea_t;
+
+/*!
+ * Log record header, followed by the NVM group data padded to NVM_DATA_LOG_WRITE_SIZE
+ */
+typedef struct sNvmDataLogRecord
+{
+    /*!
+     * LORAMAC_NVM_NOTIFY_FLAG_XXX of the group
+     */
+    uint16_t Group;
+    /*!
+     * Size of the group data
+     */
+    uint16_t Size;
+    /*!
+     * CRC32 of Group, Size and the group data
+     */
+    uint32_t Crc32;
+} NvmDataLogRecord_t;
+
+/*!
+ * Flash size of the area and record headers, padded with erased bytes to the programming granularity
+ */
+#define NVM_DATA_LOG_AREA_HEADER_SIZE      NVM_DATA_LOG_ALIGN( sizeof( NvmDataLogArea_t ) )
+#define NVM_DATA_LOG_RECORD_HEADER_SIZE    NVM_DATA_LOG_ALIGN( sizeof( NvmDataLogRecord_t ) )
+
+/*!
+ * Location of the NVM groups in the context
+ */
+typedef struct sNvmDataLogGroup
+{
+    uint16_t Offset;
+    uint16_t Size;
+} NvmDataLogGroup_t;
+
+static const NvmDataLogGroup_t NvmDataLogGroups[NVM_DATA_LOG_NB_GROUPS] =
+{
+    { offsetof( LoRaMacNvmData_t, Crypto ), sizeof( LoRaMacCryptoNvmData_t ) },
+    { offsetof( LoRaMacNvmData_t, MacGroup1 ), sizeof( LoRaMacNvmDataGroup1_t ) },
+    { offsetof( LoRaMacNvmData_t, MacGroup2 ), sizeof( LoRaMacNvmDataGroup2_t ) },
+    { offsetof( LoRaMacNvmData_t, SecureElement ), sizeof( SecureElementNvmData_t ) },
+    { offsetof( LoRaMacNvmData_t, RegionGroup1 ), sizeof( RegionNvmDataGroup1_t ) },
+    { offsetof( LoRaMacNvmData_t, RegionGroup2 ), sizeof( RegionNvmDataGroup2_t ) },
+    { offsetof( LoRaMacNvmData_t, ClassB ), sizeof( LoRaMacClassBNvmData_t ) },
+};
+
 static uint16_t NvmNotifyFlags = 0;
+
+/*!
+ * Flash callbacks of the log, NULL when the log is not used
+ */
+static const NvmDataMgmtLogCallbacks_t *NvmLogCallbacks = NULL;
+
+/*!
+ * Active log area, NVM_DATA_LOG_NO_AREA until the log has been scanned and written
+ */
+static uint8_t NvmLogArea = NVM_DATA_LOG_NO_AREA;
+
+/*!
+ * Sequence number of the active log area
+ */
+static uint32_t NvmLogSequence = 0;
+
+/*!
+ * Offset of the next record in the active log area
+ */
+static uint32_t NvmLogOffset = 0;
+
+/*!
+ * Set once the log areas have been scanned
+ */
+static bool NvmLogScanned = false;
+
+/*!
+ * Set when the last NvmDataMgmtStore failed, the notification flags are then kept for the next store
+ */
+static bool NvmLogStoreFailed = false;
+
+/*!
+ * \brief Computes the CRC of a log record
+ *
+ * \param [in] record    Record header, Crc32 is not used
+ * \param [in] data      Group data, read from the flash when NULL
+ * \param [in] offset    Flash offset of the group data when data is NULL
+ * \param [out] crc      Computed CRC
+ * \retval               0 on success
+ */
+static int32_t NvmLogRecordCrc( const NvmDataLogRecord_t *record, uint8_t *data, uint32_t offset, uint32_t *crc );
+
+/*!
+ * \brief Scans the log areas for the active one and its end
+ *
+ * \param [out] nvm      Context to replay the records into, may be NULL
+ * \retval               0 on success, -1 when the log flash could not be read
+ */
+static int32_t NvmLogScan( LoRaMacNvmData_t *nvm );
+
+/*!
+ * \brief Writes an area or a record header padded to NVM_DATA_LOG_WRITE_SIZE
+ *
+ * \param [in] offset    Flash offset of the header
+ * \param [in] header    Header
+ * \param [in] size      Header size
+ * \retval               0 on success
+ */
+static int32_t NvmLogWriteHeader( uint32_t offset, const void *header, uint32_t size );
+
+/*!
+ * \brief Writes a record of a group at the current log offset
+ *
+ * \param [in] nvm       Current NVM context
+ * \param [in] index     Group index
+ * \retval               0 on success
+ */
+static int32_t NvmLogWriteRecord( LoRaMacNvmData_t *nvm, uint8_t index );
+
+/*!
+ * \brief Writes a full copy of the context in the other log area and makes it active
+ *
+ * \param [in] nvm       Current NVM context
+ * \retval               0 on success
+ */
+static int32_t NvmLogCompact( LoRaMacNvmData_t *nvm );
 #endif /* CONTEXT_MANAGEMENT_ENABLED == 1 */
 
 void NvmDataMgmtEvent( uint16_t notifyFlags )
@@ -84,8 +263,12 @@ int32_t NvmDataMgmtStoreBegin( void )
 int32_t NvmDataMgmtStoreEnd( void )
 {
 #if ( CONTEXT_MANAGEMENT_ENABLED == 1 )
-    /* Reset notification flags */
-    NvmNotifyFlags = LORAMAC_NVM_NOTIFY_FLAG_NONE;
+    /* Reset notification flags, unless the modified groups could not be written to the log */
+    if( NvmLogStoreFailed == false )
+    {
+        NvmNotifyFlags = LORAMAC_NVM_NOTIFY_FLAG_NONE;
+    }
+    NvmLogStoreFailed = false;
 
     /* Resume LoRaMac */
     LoRaMacStart( );
@@ -94,3 +277,292 @@ int32_t NvmDataMgmtStoreEnd( void )
     return NVM_DATA_DISABLED;
 #endif /* CONTEXT_MANAGEMENT_ENABLED */
 }
+
+void NvmDataMgmtLogInit( const NvmDataMgmtLogCallbacks_t *callbacks )
+{
+#if ( CONTEXT_MANAGEMENT_ENABLED == 1 )
+    NvmLogCallbacks = callbacks;
+    NvmLogArea = NVM_DATA_LOG_NO_AREA;
+    NvmLogScanned = false;
+#endif /* CONTEXT_MANAGEMENT_ENABLED == 1 */
+}
+
+int32_t NvmDataMgmtStore( LoRaMacNvmData_t *nvm )
+{
+#if ( CONTEXT_MANAGEMENT_ENABLED == 1 )
+    int32_t status = NVM_DATA_OK;
+    uint32_t size = 0;
+
+    if( NvmLogCallbacks == NULL )
+    {
+        return NVM_DATA_DISABLED;
+    }
+
+    if( ( NvmLogScanned == false ) && ( NvmLogScan( NULL ) != 0 ) )
+    {
+        /* Nothing is written while the active area is unknown */
+        status = NVM_DATA_ERROR;
+    }
+    else
+    {
+        if( NvmLogArea != NVM_DATA_LOG_NO_AREA )
+        {
+            /* Room needed by the records of the modified groups */
+            for( uint8_t i = 0; i < NVM_DATA_LOG_NB_GROUPS; i++ )
+            {
+                if( ( NvmNotifyFlags & ( 1 << i ) ) != 0 )
+                {
+                    size += NVM_DATA_LOG_RECORD_HEADER_SIZE + NVM_DATA_LOG_ALIGN( NvmDataLogGroups[i].Size );
+                }
+            }
+        }
+
+        if( ( NvmLogArea == NVM_DATA_LOG_NO_AREA ) || ( ( NvmLogOffset + size ) > NVM_DATA_LOG_AREA_SIZE ) )
+        {
+            status = ( NvmLogCompact( nvm ) == 0 ) ? NVM_DATA_OK : NVM_DATA_ERROR;
+        }
+        else
+        {
+            for( uint8_t i = 0; ( i < NVM_DATA_LOG_NB_GROUPS ) && ( status == NVM_DATA_OK ); i++ )
+            {
+                if( ( ( NvmNotifyFlags & ( 1 << i ) ) != 0 ) && ( NvmLogWriteRecord( nvm, i ) != 0 ) )
+                {
+                    /* The end of the area is unknown, start a new area on next store */
+                    NvmLogOffset = NVM_DATA_LOG_AREA_SIZE;
+                    status = NVM_DATA_ERROR;
+                }
+            }
+        }
+    }
+
+    /* The modified groups are stored again by the next store */
+    NvmLogStoreFailed = ( status != NVM_DATA_OK );
+    return status;
+#else
+    return NVM_DATA_DISABLED;
+#endif /* CONTEXT_MANAGEMENT_ENABLED */
+}
+
+int32_t NvmDataMgmtRestore( LoRaMacNvmData_t *nvm )
+{
+#if ( CONTEXT_MANAGEMENT_ENABLED == 1 )
+    if( NvmLogCallbacks == NULL )
+    {
+        return NVM_DATA_DISABLED;
+    }
+
+    if( NvmLogScan( nvm ) != 0 )
+    {
+        return NVM_DATA_ERROR;
+    }
+
+    return ( NvmLogArea != NVM_DATA_LOG_NO_AREA ) ? NVM_DATA_OK : NVM_DATA_NOT_AVAILABLE;
+#else
+    return NVM_DATA_DISABLED;
+#endif /* CONTEXT_MANAGEMENT_ENABLED */
+}
+
+#if ( CONTEXT_MANAGEMENT_ENABLED == 1 )
+static int32_t NvmLogRecordCrc( const NvmDataLogRecord_t *record, uint8_t *data, uint32_t offset, uint32_t *crc )
+{
+    uint8_t chunk[NVM_DATA_LOG_CHUNK_SIZE];
+    uint32_t value = Crc32Init( );
+
+    value = Crc32Update( value, ( uint8_t * )record, offsetof( NvmDataLogRecord_t, Crc32 ) );
+
+    if( data != NULL )
+    {
+        value = Crc32Update( value, data, record->Size );
+    }
+    else
+    {
+        for( uint32_t i = 0; i < record->Size; i += NVM_DATA_LOG_CHUNK_SIZE )
+        {
+            uint32_t size = MIN( NVM_DATA_LOG_CHUNK_SIZE, record->Size - i );
+
+            if( NvmLogCallbacks->Read( offset + i, chunk, size ) != 0 )
+            {
+                return -1;
+            }
+            value = Crc32Update( value, chunk, ( uint16_t )size );
+        }
+    }
+
+    *crc = Crc32Finalize( value );
+    return 0;
+}
+
+static int32_t NvmLogScan( LoRaMacNvmData_t *nvm )
+{
+    NvmDataLogArea_t area;
+    NvmDataLogRecord_t record;
+    uint32_t base;
+    uint32_t crc;
+
+    NvmLogArea = NVM_DATA_LOG_NO_AREA;
+
+    /* The active area is the valid one with the highest sequence number */
+    for( uint8_t i = 0; i < 2; i++ )
+    {
+        if( NvmLogCallbacks->Read( i * NVM_DATA_LOG_AREA_SIZE, ( uint8_t * )&area, sizeof( area ) ) != 0 )
+        {
+            /* An unreadable area may be the newest one */
+            NvmLogArea = NVM_DATA_LOG_NO_AREA;
+            return -1;
+        }
+        if( ( area.Magic == NVM_DATA_LOG_MAGIC ) &&
+            ( ( NvmLogArea == NVM_DATA_LOG_NO_AREA ) || ( ( int32_t )( area.Sequence - NvmLogSequence ) > 0 ) ) )
+        {
+            NvmLogArea = i;
+            NvmLogSequence = area.Sequence;
+        }
+    }
+
+    NvmLogScanned = true;
+    if( NvmLogArea == NVM_DATA_LOG_NO_AREA )
+    {
+        return 0;
+    }
+
+    /* Replay the records, the last record of a group holds its current value */
+    base = NvmLogArea * NVM_DATA_LOG_AREA_SIZE;
+    NvmLogOffset = NVM_DATA_LOG_AREA_HEADER_SIZE;
+    while( ( NvmLogOffset + NVM_DATA_LOG_RECORD_HEADER_SIZE ) <= NVM_DATA_LOG_AREA_SIZE )
+    {
+        uint8_t index = 0;
+
+        if( NvmLogCallbacks->Read( base + NvmLogOffset, ( uint8_t * )&record, sizeof( record ) ) != 0 )
+        {
+            break;
+        }
+        if( ( record.Crc32 == NVM_DATA_LOG_ERASED ) && ( record.Group == 0xFFFF ) && ( record.Size == 0xFFFF ) )
+        {
+            /* End of the log */
+            return 0;
+        }
+
+        while( ( index < NVM_DATA_LOG_NB_GROUPS ) && ( record.Group != ( 1 << index ) ) )
+        {
+            index++;
+        }
+        if( ( index == NVM_DATA_LOG_NB_GROUPS ) || ( record.Size != NvmDataLogGroups[index].Size ) ||
+            ( ( NvmLogOffset + NVM_DATA_LOG_RECORD_HEADER_SIZE + record.Size ) > NVM_DATA_LOG_AREA_SIZE ) )
+        {
+            /* Interrupted write, nothing can be appended after it */
+            NvmLogOffset = NVM_DATA_LOG_AREA_SIZE;
+            return 0;
+        }
+        if( NvmLogRecordCrc( &record, NULL, base + NvmLogOffset + NVM_DATA_LOG_RECORD_HEADER_SIZE, &crc ) != 0 )
+        {
+            break;
+        }
+        if( crc != record.Crc32 )
+        {
+            /* Interrupted write, nothing can be appended after it */
+            NvmLogOffset = NVM_DATA_LOG_AREA_SIZE;
+            return 0;
+        }
+
+        if( ( nvm != NULL ) &&
+            ( NvmLogCallbacks->Read( base + NvmLogOffset + NVM_DATA_LOG_RECORD_HEADER_SIZE,
+                                     ( uint8_t * )nvm + NvmDataLogGroups[index].Offset, record.Size ) != 0 ) )
+        {
+            break;
+        }
+        NvmLogOffset += NVM_DATA_LOG_RECORD_HEADER_SIZE + NVM_DATA_LOG_ALIGN( record.Size );
+    }
+
+    if( ( NvmLogOffset + NVM_DATA_LOG_RECORD_HEADER_SIZE ) <= NVM_DATA_LOG_AREA_SIZE )
+    {
+        /* Read error: the context is incomplete and the end of the log is unknown */
+        NvmLogScanned = false;
+        NvmLogArea = NVM_DATA_LOG_NO_AREA;
+        return -1;
+    }
+
+    /* The area is full: the next store starts a new area */
+    NvmLogOffset = NVM_DATA_LOG_AREA_SIZE;
+    return 0;
+}
+
+static int32_t NvmLogWriteHeader( uint32_t offset, const void *header, uint32_t size )
+{
+    uint8_t buffer[NVM_DATA_LOG_RECORD_HEADER_SIZE];
+
+    memset1( buffer, 0xFF, sizeof( buffer ) );
+    memcpy1( buffer, ( const uint8_t * )header, ( uint16_t )size );
+    return NvmLogCallbacks->Write( offset, buffer, NVM_DATA_LOG_ALIGN( size ) );
+}
+
+static int32_t NvmLogWriteRecord( LoRaMacNvmData_t *nvm, uint8_t index )
+{
+    NvmDataLogRecord_t record;
+    uint8_t *data = ( uint8_t * )nvm + NvmDataLogGroups[index].Offset;
+    uint32_t offset = NvmLogArea * NVM_DATA_LOG_AREA_SIZE + NvmLogOffset;
+    uint32_t size = NvmDataLogGroups[index].Size;
+    uint32_t aligned = size & ~( NVM_DATA_LOG_WRITE_SIZE - 1 );
+    uint8_t tail[NVM_DATA_LOG_WRITE_SIZE];
+
+    record.Group = ( uint16_t )( 1 << index );
+    record.Size = ( uint16_t )size;
+    if( ( NvmLogRecordCrc( &record, data, 0, &record.Crc32 ) != 0 ) ||
+        ( NvmLogWriteHeader( offset, &record, sizeof( record ) ) != 0 ) )
+    {
+        return -1;
+    }
+    offset += NVM_DATA_LOG_RECORD_HEADER_SIZE;
+
+    if( ( aligned > 0 ) && ( NvmLogCallbacks->Write( offset, data, aligned ) != 0 ) )
+    {
+        return -1;
+    }
+    if( aligned < size )
+    {
+        /* Pad the last write with erased bytes */
+        memset1( tail, 0xFF, sizeof( tail ) );
+        memcpy1( tail, data + aligned, ( uint16_t )( size - aligned ) );
+        if( NvmLogCallbacks->Write( offset + aligned, tail, sizeof( tail ) ) != 0 )
+        {
+            return -1;
+        }
+    }
+
+    NvmLogOffset += NVM_DATA_LOG_RECORD_HEADER_SIZE + NVM_DATA_LOG_ALIGN( size );
+    return 0;
+}
+
+static int32_t NvmLogCompact( LoRaMacNvmData_t *nvm )
+{
+    NvmDataLogArea_t area;
+    uint8_t target = ( NvmLogArea == 0 ) ? 1 : 0;
+
+    if( NvmLogCallbacks->Erase( target * NVM_DATA_LOG_AREA_SIZE, NVM_DATA_LOG_AREA_SIZE ) != 0 )
+    {
+        return -1;
+    }
+
+    NvmLogArea = target;
+    NvmLogOffset = NVM_DATA_LOG_AREA_HEADER_SIZE;
+    for( uint8_t i = 0; i < NVM_DATA_LOG_NB_GROUPS; i++ )
+    {
+        if( ( ( NvmLogOffset + NVM_DATA_LOG_RECORD_HEADER_SIZE + NVM_DATA_LOG_ALIGN( NvmDataLogGroups[i].Size ) ) > NVM_DATA_LOG_AREA_SIZE ) ||
+            ( NvmLogWriteRecord( nvm, i ) != 0 ) )
+        {
+            /* The previous area, if any, stays the valid one */
+            NvmLogScanned = false;
+            return -1;
+        }
+    }
+
+    /* The area becomes valid once it holds all the groups */
+    area.Magic = NVM_DATA_LOG_MAGIC;
+    area.Sequence = NvmLogSequence + 1;
+    if( NvmLogWriteHeader( target * NVM_DATA_LOG_AREA_SIZE, &area, sizeof( area ) ) != 0 )
+    {
+        NvmLogScanned = false;
+        return -1;
+    }
+    NvmLogSequence = area.Sequence;
+    return 0;
+}
+#endif /* CONTEXT_MANAGEMENT_ENABLED == 1 */
@@ -42,6 +42,8 @@ extern "C"
 {
 #endif
 
+#include "LoRaMacInterfaces.h"
+
 typedef enum NvmDataErrorStatus_e
 {
     NVM_DATA_ERROR = -1,
@@ -53,6 +55,40 @@ typedef enum NvmDataErrorStatus_e
 
 } NvmDataErrorStatus_t;
 
+/*!
+ * Flash access callbacks of the NVM context log.
+ * The log uses two areas of NVM_DATA_LOG_AREA_SIZE bytes, the offsets are
+ * relative to the start of the first area. Writes are done on erased flash
+ * only, with offsets and sizes multiple of NVM_DATA_LOG_WRITE_SIZE.
+ * Each callback returns 0 on success.
+ */
+typedef struct NvmDataMgmtLogCallbacks_s
+{
+    /*!
+     * Reads data from the log flash
+     *
+     * \param [in]  offset  Offset in the log flash
+     * \param [out] data    Read data
+     * \param [in]  size    Number of bytes to read
+     */
+    int32_t ( *Read )( uint32_t offset, uint8_t *data, uint32_t size );
+    /*!
+     * Programs erased log flash
+     *
+     * \param [in] offset   Offset in the log flash
+     * \param [in] data     Data to write
+     * \param [in] size     Number of bytes to write
+     */
+    int32_t ( *Write )( uint32_t offset, const uint8_t *data, uint32_t size );
+    /*!
+     * Erases one log area
+     *
+     * \param [in] offset   Offset of the area in the log flash
+     * \param [in] size     Area size, NVM_DATA_LOG_AREA_SIZE
+     */
+    int32_t ( *Erase )( uint32_t offset, uint32_t size );
+} NvmDataMgmtLogCallbacks_t;
+
 /*!
  * \brief NVM Management event.
  *
@@ -69,12 +105,44 @@ void NvmDataMgmtEvent( uint16_t notifyFlags );
 int32_t NvmDataMgmtStoreBegin( void );
 
 /*!
- * \brief Clean the NVM Flag status and resume LoRaMAC process
+ * \brief Clean the NVM Flag status and resume LoRaMAC process.
+ *        The flags are kept when the last NvmDataMgmtStore failed, so that
+ *        the next store writes the modified groups again.
  *
  * \retval status NVM_DATA_OK, NVM_DATA_DISABLED
  */
 int32_t NvmDataMgmtStoreEnd( void );
 
+/*!
+ * \brief Registers the flash callbacks of the NVM context log. Once registered,
+ *        NvmDataMgmtStore appends only the modified NVM groups to the log
+ *        instead of the whole context being rewritten by the application.
+ *
+ * \param [in] callbacks Flash access callbacks, NULL to disable the log
+ */
+void NvmDataMgmtLogInit( const NvmDataMgmtLogCallbacks_t *callbacks );
+
+/*!
+ * \brief Appends the NVM groups modified since the last store to the log,
+ *        the log is compacted into the other area when full.
+ *        To be called between NvmDataMgmtStoreBegin and NvmDataMgmtStoreEnd.
+ *
+ * \param [in] nvm       Current NVM context
+ *
+ * \retval status NVM_DATA_OK, NVM_DATA_DISABLED, NVM_DATA_ERROR
+ */
+int32_t NvmDataMgmtStore( LoRaMacNvmData_t *nvm );
+
+/*!
+ * \brief Rebuilds the NVM context from the log
+ *
+ * \param [out] nvm      NVM context to restore, the backup context of the MAC
+ *
+ * \retval status NVM_DATA_OK, NVM_DATA_DISABLED, NVM_DATA_NOT_AVAILABLE,
+ *                NVM_DATA_ERROR when the log could not be read, nvm is then incomplete
+ */
+int32_t NvmDataMgmtRestore( LoRaMacNvmData_t *nvm );
+
 /*! \} defgroup NVMDATAMGMT */
 
 #ifdef __cplusplus
@@ -41,46 +41,132 @@
  *=============================================================================
  */
 
-typedef struct
-{
-    FragDecoderCallbacks_t *Callbacks;
-    uint16_t FragNb;
-    uint8_t FragSize;
+/*
+ * Number of 32 bits words of a bit array of nbBits bits
+ *
+ * \remark Bit i of a bit array is stored at bit ( i % 32 ) of word ( i / 32 )
+ */
+#define FRAG_BIT_ARRAY_WORDS( nbBits )              DIVC( ( nbBits ), 32 )
 
-    uint32_t M2BLine;
-    uint8_t MatrixM2B[( ( FRAG_MAX_REDUNDANCY >> 3 ) + 1 ) * FRAG_MAX_REDUNDANCY];
-    uint16_t FragNbMissingIndex[FRAG_MAX_NB];
+/*
+ * Maximum number of fragments waiting in the queue of FragDecoderQueue
+ *
+ * \remark This parameter has an impact on the memory footprint.
+ */
+#ifndef FRAG_DECODER_MAX_PENDING
+#define FRAG_DECODER_MAX_PENDING                    4
+#endif /* FRAG_DECODER_MAX_PENDING */
 
-    uint8_t S[( FRAG_MAX_REDUNDANCY >> 3 ) + 1];
+/*
+ * Number of rows of the lost frags kept in RAM to save flash reads, 0 to
+ * disable the cache. These rows are read again on each elimination and
+ * back-substitution step.
+ *
+ * \remark This parameter has an impact on the memory footprint.
+ */
+#ifndef FRAG_DECODER_ROW_CACHE_SIZE
+#define FRAG_DECODER_ROW_CACHE_SIZE                 0
+#endif /* FRAG_DECODER_ROW_CACHE_SIZE */
 
-    FragDecoderStatus_t Status;
-} FragDecoder_t;
+/*
+ * Size of the aligned blocks in which consecutive row writes are combined,
+ * 0 to write each row on its own
+ *
+ * \remark This parameter has an impact on the memory footprint.
+ */
+#ifndef FRAG_DECODER_WRITE_BLOCK_SIZE
+#define FRAG_DECODER_WRITE_BLOCK_SIZE               0
+#endif /* FRAG_DECODER_WRITE_BLOCK_SIZE */
 
 /*
- * Global variables
-*/
-static uint8_t matrixRow[( FRAG_MAX_NB >> 3 ) + 1];
-static uint8_t matrixDataTemp[FRAG_MAX_SIZE];
-static uint8_t dataTempVector[( FRAG_MAX_REDUNDANCY >> 3 ) + 1];
-static uint8_t dataTempVector2[( FRAG_MAX_REDUNDANCY >> 3 ) + 1];
+ * Row of a free entry of the row cache
+ */
+#define FRAG_ROW_CACHE_FREE                         UINT16_MAX
+
+/*
+ * Steps of the decoding of a coded fragment
+ */
+typedef enum eFragDecoderStep
+{
+    FRAG_STEP_IDLE,
+    FRAG_STEP_COLLECT,          /* XOR the received frags of the coded row */
+    FRAG_STEP_ELIMINATE,        /* XOR the diagonalized rows of the M2B matrix */
+    FRAG_STEP_BACK_SUBSTITUTE,  /* Solve the lost frags, last one first */
+} FragDecoderStep_t;
+
+/*!
+ * \brief Takes size bytes of a storage, rounded up to 32 bits words
+ *
+ * \param [in,out] storage Next free word of the storage
+ * \param [in]     size    Number of bytes to be taken
+ *
+ * \retval buffer          The taken buffer
+ */
+static uint32_t *FragTakeStorage( uint32_t **storage, uint32_t size );
 
 /*!
  * \brief Sets a row from source into file destination
  *
- * \param [in] src  Source buffer pointer
- * \param [in] row  Destination index of the row to be copied
- * \param [in] size Source number of bytes to be copied
+ * \param [in] decoder Decoder context
+ * \param [in] src     Source buffer pointer
+ * \param [in] row     Destination index of the row to be copied
+ * \param [in] size    Source number of bytes to be copied
  */
-static void SetRow( uint8_t *src, uint16_t row, uint16_t size );
+static void SetRow( FragDecoder_t *decoder, uint8_t *src, uint16_t row, uint16_t size );
 
 /*!
  * \brief Gets a row from source and stores it into file destination
  *
- * \param [in] src  Source buffer pointer
- * \param [in] row  Source index of the row to be copied
- * \param [in] size Source number of bytes to be copied
+ * \param [in] decoder Decoder context
+ * \param [in] src     Source buffer pointer
+ * \param [in] row     Source index of the row to be copied
+ * \param [in] size    Source number of bytes to be copied
+ */
+static void GetRow( FragDecoder_t *decoder, uint8_t *src, uint16_t row, uint16_t size );
+
+#if ( FRAG_DECODER_ROW_CACHE_SIZE > 0 )
+/*!
+ * \brief Gets a row from the row cache
+ *
+ * \param [in]  decoder Decoder context
+ * \param [out] dst     Destination buffer pointer
+ * \param [in]  row     Index of the row
+ * \param [in]  size    Number of bytes of the row
+ *
+ * \retval status       [true: row found, false: row not cached]
+ */
+static bool RowCacheGet( FragDecoder_t *decoder, uint8_t *dst, uint16_t row, uint16_t size );
+
+/*!
+ * \brief Stores a row into the row cache, in place of the least recently used one
+ *
+ * \param [in] decoder Decoder context
+ * \param [in] src     Source buffer pointer
+ * \param [in] row     Index of the row
+ * \param [in] size    Number of bytes of the row
  */
-static void GetRow( uint8_t *src, uint16_t row, uint16_t size );
+static void RowCachePut( FragDecoder_t *decoder, uint8_t *src, uint16_t row, uint16_t size );
+#endif /* FRAG_DECODER_ROW_CACHE_SIZE > 0 */
+
+#if ( FRAG_DECODER_WRITE_BLOCK_SIZE > 0 )
+/*!
+ * \brief Adds data to the write block, the block is written when it is full
+ *        or when the data does not follow the pending bytes
+ *
+ * \param [in] decoder Decoder context
+ * \param [in] addr    Destination address
+ * \param [in] src     Source buffer pointer
+ * \param [in] size    Number of bytes to be written
+ */
+static void WriteBlockAdd( FragDecoder_t *decoder, uint32_t addr, uint8_t *src, uint32_t size );
+#endif /* FRAG_DECODER_WRITE_BLOCK_SIZE > 0 */
+
+/*!
+ * \brief Writes the pending bytes of the write block
+ *
+ * \param [in] decoder Decoder context
+ */
+static void WriteBlockFlush( FragDecoder_t *decoder );
 
 /*!
  * \brief Gets the parity value from a given row of the parity matrix
@@ -90,7 +176,7 @@ static void GetRow( uint8_t *src, uint16_t row, uint16_t size );
  *
  * \retval parity         Parity value at the given index
  */
-static uint8_t GetParity( uint16_t index, uint8_t *matrixRow );
+static uint8_t GetParity( uint16_t index, uint32_t *matrixRow );
 
 /*!
  * \brief Sets the parity value on the given row of the parity matrix
@@ -99,7 +185,7 @@ static uint8_t GetParity( uint16_t index, uint8_t *matrixRow );
  * \param [in,out] matrixRow Pointer to the parity matrix.
  * \param [in]     parity    The parity value to be set in the parity matrix
  */
-static void SetParity( uint16_t index, uint8_t *matrixRow, uint8_t parity );
+static void SetParity( uint16_t index, uint32_t *matrixRow, uint8_t parity );
 
 /*!
  * \brief Check if the provided value is a power of 2
@@ -115,22 +201,22 @@ static bool IsPowerOfTwo( uint32_t x );
  *
  * \param [in,out]  line1  1st Data line to be XORed
  * \param [in]  line2  2nd Data line to be XORed
- * \param [in]  size   Number of elements in line1
+ * \param [in]  size   Number of bytes in line1
  *
- * \note result XOR( line1, line2 ) result stored in line1
+ * \note result XOR( line1, line2 ) result stored in line1, 32 bits at a time
  */
-static void XorDataLine( uint8_t *line1, uint8_t *line2, int32_t size );
+static void XorDataLine( uint32_t *line1, uint32_t *line2, int32_t size );
 
 /*!
  * \brief XORs two parity lines
  *
  * \param [in,out]  line1  1st Parity line to be XORed
  * \param [in]  line2  2nd Parity line to be XORed
- * \param [in]  size   Number of elements in line1
+ * \param [in]  size   Number of bits in line1
  *
- * \note result XOR( line1, line2 ) result stored in line1
+ * \note result XOR( line1, line2 ) result stored in line1, 32 bits at a time
  */
-static void XorParityLine( uint8_t *line1, uint8_t *line2, int32_t size );
+static void XorParityLine( uint32_t *line1, uint32_t *line2, int32_t size );
 
 /*!
  * \brief Generates a pseudo random number : PRBS23
@@ -147,8 +233,9 @@ static int32_t FragPrbs23( int32_t value );
  * \param [in]  n         Fragment N
  * \param [in]  m         Fragment number
  * \param [out] matrixRow Parity matrix
+ * \param [in]  fragPVer  Fragmentation Package version
  */
-static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t *matrixRow );
+static void FragGetParityMatrixRow( int32_t n, int32_t m, uint32_t *matrixRow, uint8_t fragPVer );
 
 /*!
  * \brief Finds the index of the first one in a bit array
@@ -157,7 +244,7 @@ static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t *matrixRow );
  * \param [in] size     Bit array size
  * \retval index        The index of the first 1 in the bit array
  */
-static uint16_t BitArrayFindFirstOne( uint8_t *bitArray, uint16_t size );
+static uint16_t BitArrayFindFirstOne( uint32_t *bitArray, uint16_t size );
 
 /*!
  * \brief Checks if the provided bit array only contains zeros
@@ -166,42 +253,69 @@ static uint16_t BitArrayFindFirstOne( uint8_t *bitArray, uint16_t size );
  * \param [in] size     Bit array size
  * \retval isAllZeros   [0: Contains ones, 1: Contains all zeros]
  */
-static uint8_t BitArrayIsAllZeros( uint8_t *bitArray, uint16_t  size );
+static uint8_t BitArrayIsAllZeros( uint32_t *bitArray, uint16_t  size );
 
 /*!
  * \brief Finds & marks missing fragments
  *
+ * \param [in]  decoder Decoder context
  * \param [in]  counter Current fragment counter
- * \note FragDecoder.FragNbMissingIndex[] array is updated in place
+ * \note decoder->FragNbMissingIndex[] array is updated in place
  */
-static void FragFindMissingFrags( uint16_t counter );
+static void FragFindMissingFrags( FragDecoder_t *decoder, uint16_t counter );
 
 /*!
  * \brief Finds the index (frag counter) of the x th missing frag
  *
- * \param [in] x   x th missing frag
+ * \param [in] decoder Decoder context
+ * \param [in] x       x th missing frag
  *
- * \retval counter The counter value associated to the x th missing frag
+ * \retval counter     The counter value associated to the x th missing frag
  */
-static uint16_t FragFindMissingIndex( uint16_t x );
+static uint16_t FragFindMissingIndex( FragDecoder_t *decoder, uint16_t x );
 
 /*!
- * \brief Extracts a row from the binary matrix and expands it to a bitArray
+ * \brief Starts the decoding of a fragment
  *
- * \param [in] bitArray  Pointer to the bit array
- * \param [in] rowIndex  Matrix row index
- * \param [in] bitsInRow Number of bits in one row
+ * \param [in] decoder     Decoder context
+ * \param [in] fragCounter Fragment counter
+ * \param [in] rawData     Pointer to the fragment to be processed
+ *
+ * \retval status          Process status, the decoding of a coded fragment
+ *                         goes on with \ref FragDecoderRun when decoder->Step
+ *                         is not FRAG_STEP_IDLE
+ */
+static int32_t FragDecoderStart( FragDecoder_t *decoder, uint16_t fragCounter, uint8_t *rawData );
+
+/*!
+ * \brief Resumes the decoding of the current coded fragment
+ *
+ * \param [in]     decoder Decoder context
+ * \param [in,out] budget  Number of row accesses left to the caller
+ *
+ * \retval status          Process status, FRAG_SESSION_ONGOING when the budget
+ *                         ran out before the end of the decoding
  */
-static void FragExtractLineFromBinaryMatrix( uint8_t *bitArray, uint16_t rowIndex, uint16_t bitsInRow );
+static int32_t FragDecoderRun( FragDecoder_t *decoder, uint32_t *budget );
 
 /*!
- * \brief Collapses and Pushs a row of a bit array to the matrix
+ * \brief Takes one row access ( GetRow or SetRow ) from a budget
  *
+ * \param [in,out] budget Number of row accesses left
+ *
+ * \retval status         [true: access granted, false: budget exhausted]
+ */
+static bool FragTakeRowAccess( uint32_t *budget );
+
+/*!
+ * \brief Pushs a row of a bit array to the matrix
+ *
+ * \param [in] decoder   Decoder context
  * \param [in] bitArray  Pointer to the bit array
  * \param [in] rowIndex  Matrix row index
  * \param [in] bitsInRow Number of bits in one row
  */
-static void FragPushLineToBinaryMatrix( uint8_t *bitArray, uint16_t rowIndex, uint16_t bitsInRow );
+static void FragPushLineToBinaryMatrix( FragDecoder_t *decoder, uint32_t *bitArray, uint16_t rowIndex, uint16_t bitsInRow );
 
 /*
  *=============================================================================
@@ -209,44 +323,91 @@ static void FragPushLineToBinaryMatrix( uint8_t *bitArray, uint16_t rowIndex, ui
  *=============================================================================
  */
 
-static FragDecoder_t FragDecoder;
+int32_t FragDecoderInit( FragDecoder_t *decoder, uint32_t *storage, uint32_t storageSize,
+                         uint16_t fragNb, uint8_t fragSize, FragDecoderCallbacks_t *callbacks, uint8_t fragPVer )
+{
+    uint32_t recoverySize;
+
+    if( ( fragNb == 0 ) || ( storage == NULL ) || ( storageSize < FRAG_DECODER_STORAGE_SIZE( fragNb, fragSize, 1 ) ) )
+    {
+        return -1;
+    }
 
-static uint8_t FragmentationPackageVersion = 0;
+    /* The storage left by the file buffers sets the number of lost frags which can be recovered */
+    recoverySize = storageSize - FRAG_DECODER_FILE_STORAGE_SIZE( fragNb, fragSize );
+    decoder->MaxRedundancy = 1;
+    while( ( decoder->MaxRedundancy < fragNb ) &&
+           ( FRAG_DECODER_RECOVERY_STORAGE_SIZE( decoder->MaxRedundancy + 1 ) <= recoverySize ) )
+    {
+        decoder->MaxRedundancy++;
+    }
 
-void FragDecoderInit( uint16_t fragNb, uint8_t fragSize, FragDecoderCallbacks_t *callbacks, uint8_t fragPVer )
-{
-    FragmentationPackageVersion = fragPVer;
-    FragDecoder.Callbacks = callbacks;
-    FragDecoder.FragNb = fragNb;                                /* FragNb = FRAG_MAX_SIZE */
-    FragDecoder.FragSize = fragSize;                            /* number of byte on a row */
-    FragDecoder.Status.FragNbLastRx = 0;
-    FragDecoder.Status.FragNbLost = 0;
-    FragDecoder.M2BLine = 0;
+    decoder->FragNbMissingIndex = ( uint16_t * )FragTakeStorage( &storage, FRAG_DECODER_ARRAY16_SIZE( fragNb ) );
+    decoder->MatrixRow = FragTakeStorage( &storage, FRAG_DECODER_BIT_ARRAY_SIZE( fragNb ) );
+    decoder->MatrixDataTemp = FragTakeStorage( &storage, FRAG_DECODER_LINE_SIZE( fragSize ) );
+    decoder->DataLine = FragTakeStorage( &storage, FRAG_DECODER_LINE_SIZE( fragSize ) );
+    decoder->PendingCounters = ( uint16_t * )FragTakeStorage( &storage, FRAG_DECODER_ARRAY16_SIZE( FRAG_DECODER_MAX_PENDING ) );
+    decoder->PendingData = FragTakeStorage( &storage, FRAG_DECODER_MAX_PENDING * FRAG_DECODER_LINE_SIZE( fragSize ) );
+    decoder->RowCacheRows = ( uint16_t * )FragTakeStorage( &storage, FRAG_DECODER_ARRAY16_SIZE( FRAG_DECODER_ROW_CACHE_SIZE ) );
+    decoder->RowCacheLastUse = FragTakeStorage( &storage, 4 * FRAG_DECODER_ROW_CACHE_SIZE );
+    decoder->RowCacheData = FragTakeStorage( &storage, FRAG_DECODER_ROW_CACHE_SIZE * FRAG_DECODER_LINE_SIZE( fragSize ) );
+    decoder->WriteBlockData = ( uint8_t * )FragTakeStorage( &storage, FRAG_DECODER_LINE_SIZE( FRAG_DECODER_WRITE_BLOCK_SIZE ) );
+    decoder->MatrixM2B = FragTakeStorage( &storage, decoder->MaxRedundancy * FRAG_DECODER_BIT_ARRAY_SIZE( decoder->MaxRedundancy ) );
+    decoder->S = FragTakeStorage( &storage, FRAG_DECODER_BIT_ARRAY_SIZE( decoder->MaxRedundancy ) );
+    decoder->DataTempVector = FragTakeStorage( &storage, FRAG_DECODER_BIT_ARRAY_SIZE( decoder->MaxRedundancy ) );
+    decoder->MissingFragIndex = ( uint16_t * )FragTakeStorage( &storage, FRAG_DECODER_ARRAY16_SIZE( decoder->MaxRedundancy ) );
+
+    decoder->FragPVer = fragPVer;
+    decoder->Callbacks = callbacks;
+    decoder->FragNb = fragNb;                                   /* FragNb = FRAG_MAX_SIZE */
+    decoder->FragSize = fragSize;                               /* number of byte on a row */
+    decoder->Status.FragNbRx = 0;
+    decoder->Status.FragNbLastRx = 0;
+    decoder->Status.FragNbLost = 0;
+    decoder->Status.MatrixError = 0;
+    decoder->M2BLine = 0;
+    decoder->PendingHead = 0;
+    decoder->PendingNb = 0;
+    decoder->Step = FRAG_STEP_IDLE;
+#if ( FRAG_DECODER_ROW_CACHE_SIZE > 0 )
+    for( uint16_t i = 0; i < FRAG_DECODER_ROW_CACHE_SIZE; i++ )
+    {
+        decoder->RowCacheRows[i] = FRAG_ROW_CACHE_FREE;
+        decoder->RowCacheLastUse[i] = 0;
+    }
+#endif /* FRAG_DECODER_ROW_CACHE_SIZE > 0 */
+    decoder->RowCacheUse = 0;
+    decoder->WriteBlockAddr = 0;
+    decoder->WriteBlockStart = 0;
+    decoder->WriteBlockEnd = 0;
 
     /* Initialize missing fragments index array */
-    for( uint16_t i = 0; i < FRAG_MAX_NB; i++ )
+    for( uint16_t i = 0; i < fragNb; i++ )
+    {
+        decoder->FragNbMissingIndex[i] = 1;
+    }
+    for( uint16_t i = 0; i < decoder->MaxRedundancy; i++ )
     {
-        FragDecoder.FragNbMissingIndex[i] = 1;
+        decoder->MissingFragIndex[i] = 0;
     }
 
     /* Initialize parity matrix */
-    for( uint32_t i = 0; i < ( ( FRAG_MAX_REDUNDANCY >> 3 ) + 1 ); i++ )
+    for( uint32_t i = 0; i < FRAG_BIT_ARRAY_WORDS( decoder->MaxRedundancy ); i++ )
     {
-        FragDecoder.S[i] = 0;
+        decoder->S[i] = 0;
     }
 
-    for( uint32_t i = 0; i < ( ( ( FRAG_MAX_REDUNDANCY >> 3 ) + 1 ) * FRAG_MAX_REDUNDANCY ); i++ )
+    for( uint32_t i = 0; i < ( decoder->MaxRedundancy * FRAG_BIT_ARRAY_WORDS( decoder->MaxRedundancy ) ); i++ )
     {
-        FragDecoder.MatrixM2B[i] = 0xFF;
+        decoder->MatrixM2B[i] = 0;
     }
 
-    /* Initialize final uncoded data buffer ( FRAG_MAX_NB * FRAG_MAX_SIZE ) */
-    if( FragDecoder.Callbacks->FragDecoderErase != NULL )
+    /* Initialize final uncoded data buffer ( fragNb * fragSize ) */
+    if( decoder->Callbacks->FragDecoderErase != NULL )
     {
-        FragDecoder.Callbacks->FragDecoderErase();
+        decoder->Callbacks->FragDecoderErase();
     }
-    FragDecoder.Status.FragNbLost = 0;
-    FragDecoder.Status.FragNbLastRx = 0;
+    return 0;
 }
 
 uint32_t FragDecoderGetMaxFileSize( void )
@@ -254,164 +415,347 @@ uint32_t FragDecoderGetMaxFileSize( void )
     return FRAG_MAX_NB * FRAG_MAX_SIZE;
 }
 
-int32_t FragDecoderProcess( uint16_t fragCounter, uint8_t *rawData )
+int32_t FragDecoderProcess( FragDecoder_t *decoder, uint16_t fragCounter, uint8_t *rawData )
+{
+    uint32_t budget = UINT32_MAX;
+    int32_t status;
+
+    /* Decode at first the queued fragments */
+    if( FragDecoderIsPending( decoder ) == true )
+    {
+        status = FragDecoderProcessPending( decoder, UINT32_MAX );
+        if( status >= 0 )
+        {
+            return status;
+        }
+    }
+
+    status = FragDecoderStart( decoder, fragCounter, rawData );
+    if( decoder->Step != FRAG_STEP_IDLE )
+    {
+        status = FragDecoderRun( decoder, &budget );
+    }
+    if( status >= 0 )
+    {
+        /* The file is complete */
+        WriteBlockFlush( decoder );
+    }
+    return status;
+}
+
+int32_t FragDecoderQueue( FragDecoder_t *decoder, uint16_t fragCounter, uint8_t *rawData )
+{
+    uint8_t slot;
+
+    if( ( FragDecoderIsPending( decoder ) == false ) && ( fragCounter <= decoder->FragNb ) )
+    {
+        /* An uncoded fragment only takes a row write */
+        return FragDecoderProcess( decoder, fragCounter, rawData );
+    }
+
+    if( decoder->PendingNb == FRAG_DECODER_MAX_PENDING )
+    {
+        /* The queue is full, decode the fragments received before this one */
+        int32_t status = FragDecoderProcessPending( decoder, UINT32_MAX );
+
+        if( status >= 0 )
+        {
+            return status;
+        }
+    }
+
+    slot = ( decoder->PendingHead + decoder->PendingNb ) % FRAG_DECODER_MAX_PENDING;
+    decoder->PendingCounters[slot] = fragCounter;
+    memcpy1( ( uint8_t * )&decoder->PendingData[slot * DIVC( decoder->FragSize, 4 )], rawData, decoder->FragSize );
+    decoder->PendingNb++;
+    return FRAG_SESSION_ONGOING;
+}
+
+int32_t FragDecoderProcessPending( FragDecoder_t *decoder, uint32_t maxRowAccesses )
+{
+    int32_t status = FRAG_SESSION_ONGOING;
+    uint32_t budget = maxRowAccesses;
+
+    while( ( budget > 0 ) && ( FragDecoderIsPending( decoder ) == true ) )
+    {
+        if( decoder->Step == FRAG_STEP_IDLE )
+        {
+            /* The fragment is consumed by FragDecoderStart before its slot can be reused */
+            uint8_t slot = decoder->PendingHead;
+
+            decoder->PendingHead = ( decoder->PendingHead + 1 ) % FRAG_DECODER_MAX_PENDING;
+            decoder->PendingNb--;
+            budget--;
+            status = FragDecoderStart( decoder, decoder->PendingCounters[slot],
+                                       ( uint8_t * )&decoder->PendingData[slot * DIVC( decoder->FragSize, 4 )] );
+        }
+        if( decoder->Step != FRAG_STEP_IDLE )
+        {
+            status = FragDecoderRun( decoder, &budget );
+        }
+        if( status >= 0 )
+        {
+            /* The session is finished, the fragments left are not needed */
+            decoder->PendingNb = 0;
+            WriteBlockFlush( decoder );
+            break;
+        }
+    }
+    return status;
+}
+
+bool FragDecoderIsPending( FragDecoder_t *decoder )
 {
-    uint16_t firstOneInRow = 0;
-    int32_t first = 0;
-    int32_t noInfo = 0;
+    return ( decoder->Step != FRAG_STEP_IDLE ) || ( decoder->PendingNb > 0 );
+}
+
+FragDecoderStatus_t FragDecoderGetStatus( FragDecoder_t *decoder )
+{
+    return decoder->Status;
+}
+
+uint16_t FragDecoderGetLeadingRows( FragDecoder_t *decoder )
+{
+    if( decoder->Status.FragNbLost > 0 )
+    {
+        /* The first lost frag is always within the recovery resources */
+        return decoder->MissingFragIndex[0];
+    }
+    /* Uncoded frags are only taken in order, all the rows up to the last one received are there */
+    return MIN( decoder->Status.FragNbLastRx, decoder->FragNb );
+}
 
-    memset1( matrixRow, 0, ( FRAG_MAX_NB >> 3 ) + 1 );
-    memset1( matrixDataTemp, 0, FRAG_MAX_SIZE );
-    memset1( dataTempVector, 0, ( FRAG_MAX_REDUNDANCY >> 3 ) + 1 );
-    memset1( dataTempVector2, 0, ( FRAG_MAX_REDUNDANCY >> 3 ) + 1 );
+static int32_t FragDecoderStart( FragDecoder_t *decoder, uint16_t fragCounter, uint8_t *rawData )
+{
+    memset1( ( uint8_t * )decoder->MatrixRow, 0, FRAG_DECODER_BIT_ARRAY_SIZE( decoder->FragNb ) );
+    memset1( ( uint8_t * )decoder->DataTempVector, 0, FRAG_DECODER_BIT_ARRAY_SIZE( decoder->MaxRedundancy ) );
 
-    FragDecoder.Status.FragNbRx = fragCounter;
+    decoder->Status.FragNbRx = fragCounter;
 
-    if( fragCounter < FragDecoder.Status.FragNbLastRx )
+    if( fragCounter < decoder->Status.FragNbLastRx )
     {
         return FRAG_SESSION_ONGOING;  /* Drop frame out of order */
     }
 
     /* The M (FragNb) first packets aren't encoded or in other words they are */
     /* encoded with the unitary matrix */
-    if( fragCounter < ( FragDecoder.FragNb + 1 ) )
+    if( fragCounter < ( decoder->FragNb + 1 ) )
     {
         /* The M first frame are not encoded store them */
-        SetRow( rawData, fragCounter - 1, FragDecoder.FragSize );
+        SetRow( decoder, rawData, fragCounter - 1, decoder->FragSize );
 
-        FragDecoder.FragNbMissingIndex[fragCounter - 1] = 0;
+        decoder->FragNbMissingIndex[fragCounter - 1] = 0;
 
-        /* Update the FragDecoder.FragNbMissingIndex with the losing frame */
-        FragFindMissingFrags( fragCounter );
+        /* Update the decoder->FragNbMissingIndex with the losing frame */
+        FragFindMissingFrags( decoder, fragCounter );
 
-        if( ( fragCounter == FragDecoder.FragNb ) && ( FragDecoder.Status.FragNbLost == 0U ) )
+        if( ( fragCounter == decoder->FragNb ) && ( decoder->Status.FragNbLost == 0U ) )
         {
             return FRAG_SESSION_FINISHED;
         }
     }
     else
     {
-        if( FragDecoder.Status.FragNbLost > FRAG_MAX_REDUNDANCY )
+        if( decoder->Status.FragNbLost > decoder->MaxRedundancy )
         {
-            FragDecoder.Status.MatrixError = 1;
+            decoder->Status.MatrixError = 1;
             return FRAG_SESSION_FINISHED;
         }
         /* At this point we receive encoded frames and the number of losing frames */
-        /* is well known: FragDecoder.FragNbLost - 1; */
+        /* is well known: decoder->FragNbLost - 1; */
 
         /* In case of the end of true data is missing */
-        FragFindMissingFrags( fragCounter );
+        FragFindMissingFrags( decoder, fragCounter );
+
+        /* The last uncoded frags may have been lost, the recovery resources are checked again */
+        if( decoder->Status.FragNbLost > decoder->MaxRedundancy )
+        {
+            decoder->Status.MatrixError = 1;
+            return FRAG_SESSION_FINISHED;
+        }
 
-        if( FragDecoder.Status.FragNbLost == 0 )
+        if( decoder->Status.FragNbLost == 0 )
         {
             /* the case : all the M(FragNb) first rows have been transmitted with no error */
-            return FragDecoder.Status.FragNbLost;
+            return decoder->Status.FragNbLost;
         }
 
-        /* fragCounter - FragDecoder.FragNb */
-        FragGetParityMatrixRow( fragCounter - FragDecoder.FragNb, FragDecoder.FragNb, matrixRow );
+        /* Work on a word aligned copy of the coded frag */
+        memcpy1( ( uint8_t * )decoder->DataLine, rawData, decoder->FragSize );
+
+        /* fragCounter - decoder->FragNb */
+        FragGetParityMatrixRow( fragCounter - decoder->FragNb, decoder->FragNb, decoder->MatrixRow, decoder->FragPVer );
+
+        decoder->Step = FRAG_STEP_COLLECT;
+        decoder->StepWord = 0;
+        decoder->StepParityWord = decoder->MatrixRow[0];
+    }
+    return FRAG_SESSION_ONGOING;
+}
+
+static int32_t FragDecoderRun( FragDecoder_t *decoder, uint32_t *budget )
+{
+    uint16_t rowWords = FRAG_BIT_ARRAY_WORDS( decoder->MaxRedundancy );
+    int32_t li;
+    int32_t lj;
 
-        for( int32_t i = 0; i < FragDecoder.FragNb; i++ )
+    if( decoder->Step == FRAG_STEP_COLLECT )
+    {
+        while( 1 )
         {
-            if( GetParity( i, matrixRow ) == 1 )
+            while( decoder->StepParityWord != 0 )
             {
-                if( FragDecoder.FragNbMissingIndex[i] == 0 )
+                uint16_t i = ( decoder->StepWord << 5 ) + CountTrailingZeros( decoder->StepParityWord );
+
+                if( decoder->FragNbMissingIndex[i] == 0 )
                 {
+                    if( FragTakeRowAccess( budget ) == false )
+                    {
+                        return FRAG_SESSION_ONGOING;
+                    }
                     /* XOR with already receive frag */
-                    SetParity( i, matrixRow, 0 );
-                    GetRow( matrixDataTemp, i, FragDecoder.FragSize );
-                    XorDataLine( rawData, matrixDataTemp, FragDecoder.FragSize );
+                    GetRow( decoder, ( uint8_t * )decoder->MatrixDataTemp, i, decoder->FragSize );
+                    XorDataLine( decoder->DataLine, decoder->MatrixDataTemp, decoder->FragSize );
                 }
                 else
                 {
                     /* Fill the "little" boolean matrix m2b */
-                    SetParity( FragDecoder.FragNbMissingIndex[i] - 1, dataTempVector, 1 );
-                    if( first == 0 )
-                    {
-                        first = 1;
-                    }
+                    SetParity( decoder->FragNbMissingIndex[i] - 1, decoder->DataTempVector, 1 );
                 }
+                decoder->StepParityWord &= decoder->StepParityWord - 1;
+            }
+            if( ++decoder->StepWord >= FRAG_BIT_ARRAY_WORDS( decoder->FragNb ) )
+            {
+                break;
             }
+            decoder->StepParityWord = decoder->MatrixRow[decoder->StepWord];
         }
 
-        firstOneInRow = BitArrayFindFirstOne( dataTempVector, FragDecoder.Status.FragNbLost );
-
-        if( first > 0 )
+        if( BitArrayIsAllZeros( decoder->DataTempVector, decoder->Status.FragNbLost ) )
         {
-            int32_t li;
-            int32_t lj;
+            /* The coded frag only covers received frags */
+            decoder->Step = FRAG_STEP_IDLE;
+            return FRAG_SESSION_ONGOING;
+        }
+        decoder->FirstOneInRow = BitArrayFindFirstOne( decoder->DataTempVector, decoder->Status.FragNbLost );
+        decoder->NoInfo = false;
+        decoder->Step = FRAG_STEP_ELIMINATE;
+    }
 
-            /* Manage a new line in MatrixM2B */
-            while( GetParity( firstOneInRow, FragDecoder.S ) == 1 )
+    if( decoder->Step == FRAG_STEP_ELIMINATE )
+    {
+        /* Manage a new line in MatrixM2B */
+        while( ( decoder->NoInfo == false ) && ( GetParity( decoder->FirstOneInRow, decoder->S ) == 1 ) )
+        {
+            if( FragTakeRowAccess( budget ) == false )
             {
-                /* Row already diagonalized exist & ( FragDecoder.MatrixM2B[firstOneInRow][0] ) */
-                FragExtractLineFromBinaryMatrix( dataTempVector2, firstOneInRow, FragDecoder.Status.FragNbLost );
-                XorParityLine( dataTempVector, dataTempVector2, FragDecoder.Status.FragNbLost );
-                /* Have to store it in the mi th position of the missing frag */
-                li = FragFindMissingIndex( firstOneInRow );
-                GetRow( matrixDataTemp, li, FragDecoder.FragSize );
-                XorDataLine( rawData, matrixDataTemp, FragDecoder.FragSize );
-                if( BitArrayIsAllZeros( dataTempVector, FragDecoder.Status.FragNbLost ) )
-                {
-                    noInfo = 1;
-                    break;
-                }
-                firstOneInRow = BitArrayFindFirstOne( dataTempVector, FragDecoder.Status.FragNbLost );
+                return FRAG_SESSION_ONGOING;
             }
-
-            if( noInfo == 0 )
+            /* Row already diagonalized exist & ( decoder->MatrixM2B[firstOneInRow][0] ) */
+            XorParityLine( decoder->DataTempVector, &decoder->MatrixM2B[decoder->FirstOneInRow * rowWords], decoder->Status.FragNbLost );
+            /* Have to store it in the mi th position of the missing frag */
+            li = FragFindMissingIndex( decoder, decoder->FirstOneInRow );
+            GetRow( decoder, ( uint8_t * )decoder->MatrixDataTemp, li, decoder->FragSize );
+            XorDataLine( decoder->DataLine, decoder->MatrixDataTemp, decoder->FragSize );
+            if( BitArrayIsAllZeros( decoder->DataTempVector, decoder->Status.FragNbLost ) )
+            {
+                decoder->NoInfo = true;
+            }
+            else
             {
-                FragPushLineToBinaryMatrix( dataTempVector, firstOneInRow, FragDecoder.Status.FragNbLost );
-                li = FragFindMissingIndex( firstOneInRow );
-                SetRow( rawData, li, FragDecoder.FragSize );
-                SetParity( firstOneInRow, FragDecoder.S, 1 );
-                FragDecoder.M2BLine++;
+                decoder->FirstOneInRow = BitArrayFindFirstOne( decoder->DataTempVector, decoder->Status.FragNbLost );
             }
+        }
 
-            if( FragDecoder.M2BLine == FragDecoder.Status.FragNbLost )
+        if( decoder->NoInfo == false )
+        {
+            if( FragTakeRowAccess( budget ) == false )
             {
-                /* Then last step diagonalized */
-                if( FragDecoder.Status.FragNbLost > 1 )
-                {
-                    int32_t i;
-                    int32_t j;
+                return FRAG_SESSION_ONGOING;
+            }
+            FragPushLineToBinaryMatrix( decoder, decoder->DataTempVector, decoder->FirstOneInRow, decoder->Status.FragNbLost );
+            li = FragFindMissingIndex( decoder, decoder->FirstOneInRow );
+            SetRow( decoder, ( uint8_t * )decoder->DataLine, li, decoder->FragSize );
+            SetParity( decoder->FirstOneInRow, decoder->S, 1 );
+            decoder->M2BLine++;
+        }
 
-                    for( i = ( FragDecoder.Status.FragNbLost - 2 ); i >= 0 ; i-- )
-                    {
-                        li = FragFindMissingIndex( i );
-                        GetRow( matrixDataTemp, li, FragDecoder.FragSize );
-                        for( j = ( FragDecoder.Status.FragNbLost - 1 ); j > i; j-- )
-                        {
-                            FragExtractLineFromBinaryMatrix( dataTempVector2, i, FragDecoder.Status.FragNbLost );
-                            FragExtractLineFromBinaryMatrix( dataTempVector, j, FragDecoder.Status.FragNbLost );
-                            if( GetParity( j, dataTempVector2 ) == 1 )
-                            {
-                                XorParityLine( dataTempVector2, dataTempVector, FragDecoder.Status.FragNbLost );
-
-                                lj = FragFindMissingIndex( j );
-
-                                GetRow( rawData, lj, FragDecoder.FragSize );
-                                XorDataLine( matrixDataTemp, rawData, FragDecoder.FragSize );
-                            }
-                        }
-                        SetRow( matrixDataTemp, li, FragDecoder.FragSize );
-                    }
-                    return FragDecoder.Status.FragNbLost;
-                }
-                else
+        if( decoder->M2BLine != decoder->Status.FragNbLost )
+        {
+            decoder->Step = FRAG_STEP_IDLE;
+            return FRAG_SESSION_ONGOING;
+        }
+        if( decoder->Status.FragNbLost <= 1 )
+        {
+            /* If not ( decoder->FragNbLost > 1 ) */
+            decoder->Step = FRAG_STEP_IDLE;
+            return decoder->Status.FragNbLost;
+        }
+        /* Then last step diagonalized */
+        decoder->StepRow = decoder->Status.FragNbLost - 2;
+        decoder->StepRowLoaded = false;
+        decoder->Step = FRAG_STEP_BACK_SUBSTITUTE;
+    }
+
+    /* Row i only depends on the rows j > i, which are already solved */
+    while( decoder->StepRow >= 0 )
+    {
+        int32_t i = decoder->StepRow;
+        uint32_t *m2bRow = &decoder->MatrixM2B[i * rowWords];
+
+        li = FragFindMissingIndex( decoder, i );
+        if( decoder->StepRowLoaded == false )
+        {
+            if( FragTakeRowAccess( budget ) == false )
+            {
+                return FRAG_SESSION_ONGOING;
+            }
+            GetRow( decoder, ( uint8_t * )decoder->MatrixDataTemp, li, decoder->FragSize );
+            decoder->StepRowLoaded = true;
+            decoder->StepWord = i >> 5;
+            /* Skip the diagonal one and the zeros on its left */
+            decoder->StepParityWord = m2bRow[decoder->StepWord] & ~( ( 2UL << ( i & 0x1F ) ) - 1 );
+        }
+        while( 1 )
+        {
+            while( decoder->StepParityWord != 0 )
+            {
+                if( FragTakeRowAccess( budget ) == false )
                 {
-                    /* If not ( FragDecoder.FragNbLost > 1 ) */
-                    return FragDecoder.Status.FragNbLost;
+                    return FRAG_SESSION_ONGOING;
                 }
+                lj = FragFindMissingIndex( decoder, ( decoder->StepWord << 5 ) + CountTrailingZeros( decoder->StepParityWord ) );
+                decoder->StepParityWord &= decoder->StepParityWord - 1;
+
+                GetRow( decoder, ( uint8_t * )decoder->DataLine, lj, decoder->FragSize );
+                XorDataLine( decoder->MatrixDataTemp, decoder->DataLine, decoder->FragSize );
+            }
+            if( ++decoder->StepWord >= FRAG_BIT_ARRAY_WORDS( decoder->Status.FragNbLost ) )
+            {
+                break;
             }
+            decoder->StepParityWord = m2bRow[decoder->StepWord];
+        }
+        if( FragTakeRowAccess( budget ) == false )
+        {
+            return FRAG_SESSION_ONGOING;
         }
+        SetRow( decoder, ( uint8_t * )decoder->MatrixDataTemp, li, decoder->FragSize );
+        decoder->StepRowLoaded = false;
+        decoder->StepRow--;
     }
-    return FRAG_SESSION_ONGOING;
+    decoder->Step = FRAG_STEP_IDLE;
+    return decoder->Status.FragNbLost;
 }
 
-FragDecoderStatus_t FragDecoderGetStatus( void )
+static bool FragTakeRowAccess( uint32_t *budget )
 {
-    return FragDecoder.Status;
+    if( *budget == 0 )
+    {
+        return false;
+    }
+    *budget -= 1;
+    return true;
 }
 
 /*
@@ -420,35 +764,158 @@ FragDecoderStatus_t FragDecoderGetStatus( void )
  *=============================================================================
  */
 
-static void SetRow( uint8_t *src, uint16_t row, uint16_t size )
+static uint32_t *FragTakeStorage( uint32_t **storage, uint32_t size )
+{
+    uint32_t *buffer = *storage;
+
+    *storage += DIVC( size, 4 );
+    return buffer;
+}
+
+static void SetRow( FragDecoder_t *decoder, uint8_t *src, uint16_t row, uint16_t size )
+{
+#if ( FRAG_DECODER_ROW_CACHE_SIZE > 0 )
+    if( decoder->FragNbMissingIndex[row] != 0 )
+    {
+        RowCachePut( decoder, src, row, size );
+    }
+#endif /* FRAG_DECODER_ROW_CACHE_SIZE > 0 */
+#if ( FRAG_DECODER_WRITE_BLOCK_SIZE > 0 )
+    WriteBlockAdd( decoder, ( uint32_t )row * size, src, size );
+#else
+    if( ( decoder->Callbacks != NULL ) && ( decoder->Callbacks->FragDecoderWrite != NULL ) )
+    {
+        decoder->Callbacks->FragDecoderWrite( row * size, src, size );
+    }
+#endif /* FRAG_DECODER_WRITE_BLOCK_SIZE > 0 */
+}
+
+static void GetRow( FragDecoder_t *decoder, uint8_t *dst, uint16_t row, uint16_t size )
+{
+#if ( FRAG_DECODER_ROW_CACHE_SIZE > 0 )
+    if( RowCacheGet( decoder, dst, row, size ) == true )
+    {
+        return;
+    }
+#endif /* FRAG_DECODER_ROW_CACHE_SIZE > 0 */
+#if ( FRAG_DECODER_WRITE_BLOCK_SIZE > 0 )
+    /* The row may still be in the write block */
+    if( ( ( decoder->WriteBlockAddr + decoder->WriteBlockStart ) < ( ( uint32_t )row * size + size ) ) &&
+        ( ( ( uint32_t )row * size ) < ( decoder->WriteBlockAddr + decoder->WriteBlockEnd ) ) )
+    {
+        WriteBlockFlush( decoder );
+    }
+#endif /* FRAG_DECODER_WRITE_BLOCK_SIZE > 0 */
+    if( ( decoder->Callbacks != NULL ) && ( decoder->Callbacks->FragDecoderRead != NULL ) )
+    {
+        decoder->Callbacks->FragDecoderRead( row * size, dst, size );
+    }
+}
+
+#if ( FRAG_DECODER_ROW_CACHE_SIZE > 0 )
+static bool RowCacheGet( FragDecoder_t *decoder, uint8_t *dst, uint16_t row, uint16_t size )
+{
+    for( uint16_t i = 0; i < FRAG_DECODER_ROW_CACHE_SIZE; i++ )
+    {
+        if( decoder->RowCacheRows[i] == row )
+        {
+            decoder->RowCacheLastUse[i] = ++decoder->RowCacheUse;
+            memcpy1( dst, ( uint8_t * )&decoder->RowCacheData[i * DIVC( size, 4 )], size );
+            return true;
+        }
+    }
+    return false;
+}
+
+static void RowCachePut( FragDecoder_t *decoder, uint8_t *src, uint16_t row, uint16_t size )
+{
+    uint16_t entry = 0;
+
+    for( uint16_t i = 0; i < FRAG_DECODER_ROW_CACHE_SIZE; i++ )
+    {
+        if( decoder->RowCacheRows[i] == row )
+        {
+            entry = i;
+            break;
+        }
+        if( decoder->RowCacheLastUse[i] < decoder->RowCacheLastUse[entry] )
+        {
+            entry = i;
+        }
+    }
+    decoder->RowCacheRows[entry] = row;
+    decoder->RowCacheLastUse[entry] = ++decoder->RowCacheUse;
+    memcpy1( ( uint8_t * )&decoder->RowCacheData[entry * DIVC( size, 4 )], src, size );
+}
+#endif /* FRAG_DECODER_ROW_CACHE_SIZE > 0 */
+
+#if ( FRAG_DECODER_WRITE_BLOCK_SIZE > 0 )
+static void WriteBlockAdd( FragDecoder_t *decoder, uint32_t addr, uint8_t *src, uint32_t size )
 {
-    if( ( FragDecoder.Callbacks != NULL ) && ( FragDecoder.Callbacks->FragDecoderWrite != NULL ) )
+    while( size > 0 )
     {
-        FragDecoder.Callbacks->FragDecoderWrite( row * size, src, size );
+        uint32_t offset = addr % FRAG_DECODER_WRITE_BLOCK_SIZE;
+        uint32_t length = MIN( size, FRAG_DECODER_WRITE_BLOCK_SIZE - offset );
+
+        if( ( decoder->WriteBlockEnd != decoder->WriteBlockStart ) &&
+            ( ( decoder->WriteBlockAddr != ( addr - offset ) ) || ( decoder->WriteBlockEnd != offset ) ) )
+        {
+            /* Not contiguous with the pending bytes */
+            WriteBlockFlush( decoder );
+        }
+        if( decoder->WriteBlockEnd == decoder->WriteBlockStart )
+        {
+            decoder->WriteBlockAddr = addr - offset;
+            decoder->WriteBlockStart = offset;
+            decoder->WriteBlockEnd = offset;
+        }
+        memcpy1( &decoder->WriteBlockData[offset], src, length );
+        decoder->WriteBlockEnd += length;
+        if( decoder->WriteBlockEnd == FRAG_DECODER_WRITE_BLOCK_SIZE )
+        {
+            WriteBlockFlush( decoder );
+        }
+        addr += length;
+        src += length;
+        size -= length;
     }
 }
+#endif /* FRAG_DECODER_WRITE_BLOCK_SIZE > 0 */
 
-static void GetRow( uint8_t *dst, uint16_t row, uint16_t size )
+static void WriteBlockFlush( FragDecoder_t *decoder )
 {
-    if( ( FragDecoder.Callbacks != NULL ) && ( FragDecoder.Callbacks->FragDecoderRead != NULL ) )
+#if ( FRAG_DECODER_WRITE_BLOCK_SIZE > 0 )
+    if( ( decoder->WriteBlockEnd != decoder->WriteBlockStart ) &&
+        ( decoder->Callbacks != NULL ) && ( decoder->Callbacks->FragDecoderWrite != NULL ) )
     {
-        FragDecoder.Callbacks->FragDecoderRead( row * size, dst, size );
+        decoder->Callbacks->FragDecoderWrite( decoder->WriteBlockAddr + decoder->WriteBlockStart,
+                                              &decoder->WriteBlockData[decoder->WriteBlockStart],
+                                              decoder->WriteBlockEnd - decoder->WriteBlockStart );
     }
+    decoder->WriteBlockStart = 0;
+    decoder->WriteBlockEnd = 0;
+#else
+    ( void )decoder;
+#endif /* FRAG_DECODER_WRITE_BLOCK_SIZE > 0 */
 }
 
-static uint8_t GetParity( uint16_t index, uint8_t *matrixRow )
+static uint8_t GetParity( uint16_t index, uint32_t *matrixRow )
 {
-    uint8_t parity;
-    parity = matrixRow[index >> 3];
-    parity = ( parity >> ( 7 - ( index % 8 ) ) ) & 0x01;
-    return parity;
+    return ( matrixRow[index >> 5] >> ( index & 0x1F ) ) & 0x01;
 }
 
-static void SetParity( uint16_t index, uint8_t *matrixRow, uint8_t parity )
+static void SetParity( uint16_t index, uint32_t *matrixRow, uint8_t parity )
 {
-    uint8_t mask = 0xFF - ( 1 << ( 7 - ( index % 8 ) ) );
-    parity = parity << ( 7 - ( index % 8 ) );
-    matrixRow[index >> 3] = ( matrixRow[index >> 3] & mask ) + parity;
+    uint32_t mask = 1UL << ( index & 0x1F );
+
+    if( parity != 0 )
+    {
+        matrixRow[index >> 5] |= mask;
+    }
+    else
+    {
+        matrixRow[index >> 5] &= ~mask;
+    }
 }
 
 static bool IsPowerOfTwo( uint32_t x )
@@ -466,19 +933,20 @@ static bool IsPowerOfTwo( uint32_t x )
     return false;
 }
 
-static void XorDataLine( uint8_t *line1, uint8_t *line2, int32_t size )
+static void XorDataLine( uint32_t *line1, uint32_t *line2, int32_t size )
 {
-    for( int32_t i = 0; i < size; i++ )
+    /* The bytes beyond size are scratch, the lines are rounded up to 32 bits words */
+    for( int32_t i = 0; i < DIVC( size, 4 ); i++ )
     {
         line1[i] = line1[i] ^ line2[i];
     }
 }
 
-static void XorParityLine( uint8_t *line1, uint8_t *line2, int32_t size )
+static void XorParityLine( uint32_t *line1, uint32_t *line2, int32_t size )
 {
-    for( int32_t i = 0; i < size; i++ )
+    for( int32_t i = 0; i < FRAG_BIT_ARRAY_WORDS( size ); i++ )
     {
-        SetParity( i, line1, ( GetParity( i, line1 ) ^ GetParity( i, line2 ) ) );
+        line1[i] = line1[i] ^ line2[i];
     }
 }
 
@@ -489,7 +957,7 @@ static int32_t FragPrbs23( int32_t value )
     return ( value >> 1 ) + ( ( b0 ^ b1 ) << 22 );
 }
 
-static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t *matrixRow )
+static void FragGetParityMatrixRow( int32_t n, int32_t m, uint32_t *matrixRow, uint8_t fragPVer )
 {
     int32_t mTemp;
     int32_t x;
@@ -506,7 +974,7 @@ static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t *matrixRow )
     }
 
     x = 1 + ( 1001 * n );
-    for( uint16_t i = 0; i < ( ( m >> 3 ) + 1 ); i++ )
+    for( uint16_t i = 0; i < FRAG_BIT_ARRAY_WORDS( m ); i++ )
     {
         matrixRow[i] = 0;
     }
@@ -520,7 +988,7 @@ static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t *matrixRow )
         }
 
         /* FEC algorithm optimization in V2.0.0 */
-        if( ( GetParity( r, matrixRow ) == 0 ) || ( FragmentationPackageVersion == 1U ) )
+        if( ( GetParity( r, matrixRow ) == 0 ) || ( fragPVer == 1U ) )
         {
             SetParity( r, matrixRow, 1 );
             nbCoeff += 1;
@@ -528,23 +996,24 @@ static void FragGetParityMatrixRow( int32_t n, int32_t m, uint8_t *matrixRow )
     }
 }
 
-static uint16_t BitArrayFindFirstOne( uint8_t *bitArray, uint16_t size )
+static uint16_t BitArrayFindFirstOne( uint32_t *bitArray, uint16_t size )
 {
-    for( uint16_t i = 0; i < size; i++ )
+    /* The bits beyond size are kept to 0 */
+    for( uint16_t i = 0; i < FRAG_BIT_ARRAY_WORDS( size ); i++ )
     {
-        if( GetParity( i, bitArray ) == 1 )
+        if( bitArray[i] != 0 )
         {
-            return i;
+            return ( i << 5 ) + CountTrailingZeros( bitArray[i] );
         }
     }
     return 0;
 }
 
-static uint8_t BitArrayIsAllZeros( uint8_t *bitArray, uint16_t  size )
+static uint8_t BitArrayIsAllZeros( uint32_t *bitArray, uint16_t  size )
 {
-    for( uint16_t i = 0; i < size; i++ )
+    for( uint16_t i = 0; i < FRAG_BIT_ARRAY_WORDS( size ); i++ )
     {
-        if( GetParity( i, bitArray ) == 1 )
+        if( bitArray[i] != 0 )
         {
             return 0;
         }
@@ -552,93 +1021,42 @@ static uint8_t BitArrayIsAllZeros( uint8_t *bitArray, uint16_t  size )
     return 1;
 }
 
-static void FragFindMissingFrags( uint16_t counter )
+static void FragFindMissingFrags( FragDecoder_t *decoder, uint16_t counter )
 {
     int32_t i;
-    for( i = FragDecoder.Status.FragNbLastRx; i < ( counter - 1 ); i++ )
+    for( i = decoder->Status.FragNbLastRx; i < ( counter - 1 ); i++ )
     {
-        if( i < FragDecoder.FragNb )
+        if( i < decoder->FragNb )
         {
-            FragDecoder.Status.FragNbLost++;
-            FragDecoder.FragNbMissingIndex[i] = FragDecoder.Status.FragNbLost;
+            decoder->Status.FragNbLost++;
+            decoder->FragNbMissingIndex[i] = decoder->Status.FragNbLost;
+            if( decoder->Status.FragNbLost <= decoder->MaxRedundancy )
+            {
+                decoder->MissingFragIndex[decoder->Status.FragNbLost - 1] = i;
+            }
         }
     }
-    if( i < FragDecoder.FragNb )
+    if( i < decoder->FragNb )
     {
-        FragDecoder.Status.FragNbLastRx = counter;
+        decoder->Status.FragNbLastRx = counter;
     }
     else
     {
-        FragDecoder.Status.FragNbLastRx = FragDecoder.FragNb + 1;
-    }
-}
-
-static uint16_t FragFindMissingIndex( uint16_t x )
-{
-    for( uint16_t i = 0; i < FragDecoder.FragNb; i++ )
-    {
-        if( FragDecoder.FragNbMissingIndex[i] == ( x + 1 ) )
-        {
-            return i;
-        }
+        decoder->Status.FragNbLastRx = decoder->FragNb + 1;
     }
-    return 0;
 }
 
-static void FragExtractLineFromBinaryMatrix( uint8_t *bitArray, uint16_t rowIndex, uint16_t bitsInRow )
+static uint16_t FragFindMissingIndex( FragDecoder_t *decoder, uint16_t x )
 {
-    uint32_t findByte = 0;
-    uint32_t findBitInByte = 0;
-
-    if( rowIndex > 0 )
-    {
-        findByte      = ( rowIndex * bitsInRow - ( ( rowIndex * ( rowIndex - 1 ) ) >> 1 ) ) >> 3;
-        findBitInByte = ( rowIndex * bitsInRow - ( ( rowIndex * ( rowIndex - 1 ) ) >> 1 ) ) % 8;
-    }
-    if( rowIndex > 0 )
-    {
-        for( uint16_t i = 0; i < rowIndex; i++ )
-        {
-            SetParity( i, bitArray, 0 );
-        }
-    }
-    for( uint16_t i = rowIndex; i < bitsInRow; i++ )
-    {
-        SetParity( i,
-                   bitArray,
-                   ( FragDecoder.MatrixM2B[findByte] >> ( 7 - findBitInByte ) ) & 0x01 );
-
-        findBitInByte++;
-        if( findBitInByte == 8 )
-        {
-            findBitInByte = 0;
-            findByte++;
-        }
-    }
+    /* Only called on a recovery, when FragNbLost <= MaxRedundancy */
+    return decoder->MissingFragIndex[x];
 }
 
-static void FragPushLineToBinaryMatrix( uint8_t *bitArray, uint16_t rowIndex, uint16_t bitsInRow )
+static void FragPushLineToBinaryMatrix( FragDecoder_t *decoder, uint32_t *bitArray, uint16_t rowIndex, uint16_t bitsInRow )
 {
-    uint32_t findByte = 0;
-    uint32_t findBitInByte = 0;
-
-    if( rowIndex > 0 )
-    {
-        findByte      = ( rowIndex * bitsInRow - ( ( rowIndex * ( rowIndex - 1 ) ) >> 1 ) ) >> 3;
-        findBitInByte = ( rowIndex * bitsInRow - ( ( rowIndex * ( rowIndex - 1 ) ) >> 1 ) ) % 8;
-
-    }
-    for( uint16_t i = rowIndex; i < bitsInRow; i++ )
+    /* The bits before rowIndex are 0, the row is stored as is */
+    for( uint16_t i = 0; i < FRAG_BIT_ARRAY_WORDS( bitsInRow ); i++ )
     {
-        if( GetParity( i, bitArray ) == 0 )
-        {
-            FragDecoder.MatrixM2B[findByte] = FragDecoder.MatrixM2B[findByte] & ( 0xFF - ( 1 << ( 7 - findBitInByte ) ) );
-        }
-        findBitInByte++;
-        if( findBitInByte == 8 )
-        {
-            findBitInByte = 0;
-            findByte++;
-        }
+        decoder->MatrixM2B[rowIndex * FRAG_BIT_ARRAY_WORDS( decoder->MaxRedundancy ) + i] = bitArray[i];
     }
 }
@@ -82,14 +82,123 @@ typedef struct sFragDecoderCallbacks
 } FragDecoderCallbacks_t;
 
 /*!
- * \brief Initializes the fragmentation decoder
+ * Size of a storage of nb 16 bits values, bit array of nbBits bits and data
+ * line of size bytes of the decoder, rounded up to 32 bits words [bytes]
+ */
+#define FRAG_DECODER_ARRAY16_SIZE( nb )             ( ( ( ( uint32_t )( nb ) + 1 ) >> 1 ) << 2 )
+#define FRAG_DECODER_BIT_ARRAY_SIZE( nbBits )       ( ( ( ( uint32_t )( nbBits ) + 31 ) >> 5 ) << 2 )
+#define FRAG_DECODER_LINE_SIZE( size )              ( ( ( ( uint32_t )( size ) + 3 ) >> 2 ) << 2 )
+
+/*!
+ * Storage of the decoder buffers which depend on the file [bytes]
+ *
+ * Missing frags index, parity matrix row, 2 data lines, queued fragments, row
+ * cache and write block
+ */
+#define FRAG_DECODER_FILE_STORAGE_SIZE( fragNb, fragSize )                                          \
+    ( FRAG_DECODER_ARRAY16_SIZE( fragNb ) + FRAG_DECODER_BIT_ARRAY_SIZE( fragNb ) +                 \
+      ( 2 + FRAG_DECODER_MAX_PENDING + FRAG_DECODER_ROW_CACHE_SIZE ) * FRAG_DECODER_LINE_SIZE( fragSize ) + \
+      FRAG_DECODER_ARRAY16_SIZE( FRAG_DECODER_MAX_PENDING ) +                                       \
+      FRAG_DECODER_ARRAY16_SIZE( FRAG_DECODER_ROW_CACHE_SIZE ) + 4 * FRAG_DECODER_ROW_CACHE_SIZE +  \
+      FRAG_DECODER_LINE_SIZE( FRAG_DECODER_WRITE_BLOCK_SIZE ) )
+
+/*!
+ * Storage of the decoder buffers which depend on the number of lost fragments
+ * to be recovered [bytes]
+ *
+ * M2B matrix, S and temporary vectors, lost frags index
+ */
+#define FRAG_DECODER_RECOVERY_STORAGE_SIZE( maxRedundancy )                                         \
+    ( ( ( uint32_t )( maxRedundancy ) + 2 ) * FRAG_DECODER_BIT_ARRAY_SIZE( maxRedundancy ) +        \
+      FRAG_DECODER_ARRAY16_SIZE( maxRedundancy ) )
+
+/*!
+ * Size of the storage a decoder needs to recover maxRedundancy lost fragments
+ * of a file of fragNb fragments of fragSize bytes [bytes]
+ *
+ * \remark Uses FRAG_DECODER_MAX_PENDING, FRAG_DECODER_ROW_CACHE_SIZE and
+ *         FRAG_DECODER_WRITE_BLOCK_SIZE, frag_decoder_if.h must be included
+ *         where the macro is used.
+ */
+#define FRAG_DECODER_STORAGE_SIZE( fragNb, fragSize, maxRedundancy )                                \
+    ( FRAG_DECODER_FILE_STORAGE_SIZE( fragNb, fragSize ) + FRAG_DECODER_RECOVERY_STORAGE_SIZE( maxRedundancy ) )
+
+/*!
+ * Fragmentation decoder context
  *
- * \param [in] fragNb     Number of expected fragments (without redundancy packets)
- * \param [in] fragSize   Size of a fragment
- * \param [in] callbacks  Pointer to the Write/Read functions.
- * \param [in] fragPVer   Fragmentation Package version to adapt the LDPC matrix usage
+ * \remark The members are private to the decoder. The buffers are carved out
+ *         of the storage given to \ref FragDecoderInit, the context can be
+ *         copied as long as the storage stays in place.
  */
-void FragDecoderInit( uint16_t fragNb, uint8_t fragSize, FragDecoderCallbacks_t *callbacks, uint8_t fragPVer );
+typedef struct sFragDecoder
+{
+    FragDecoderCallbacks_t *Callbacks;
+    uint16_t FragNb;
+    uint8_t FragSize;
+    uint8_t FragPVer;
+    /* Number of lost frags the storage can recover */
+    uint16_t MaxRedundancy;
+    uint32_t M2BLine;
+
+    /* Row i of the upper triangular matrix has its first one at column i, rows of FRAG_BIT_ARRAY_WORDS( MaxRedundancy ) words */
+    uint32_t *MatrixM2B;
+    uint16_t *FragNbMissingIndex;
+    /* Frag index of the x th missing frag, reverse of FragNbMissingIndex */
+    uint16_t *MissingFragIndex;
+    uint32_t *S;
+    uint32_t *MatrixRow;
+    uint32_t *MatrixDataTemp;
+    uint32_t *DataLine;
+    uint32_t *DataTempVector;
+
+    /* Fragments waiting to be decoded, oldest first */
+    uint16_t *PendingCounters;
+    uint32_t *PendingData;
+    uint8_t PendingHead;
+    uint8_t PendingNb;
+
+    /* Resume point of the decoding of the current coded fragment */
+    uint8_t Step;
+    bool StepRowLoaded;
+    bool NoInfo;
+    uint16_t StepWord;
+    uint16_t FirstOneInRow;
+    uint32_t StepParityWord;
+    int32_t StepRow;
+
+    /* Least recently used rows of the lost frags */
+    uint16_t *RowCacheRows;
+    uint32_t *RowCacheLastUse;
+    uint32_t *RowCacheData;
+    uint32_t RowCacheUse;
+
+    /* Row writes not yet given to FragDecoderWrite */
+    uint8_t *WriteBlockData;
+    uint32_t WriteBlockAddr;
+    uint32_t WriteBlockStart;
+    uint32_t WriteBlockEnd;
+
+    FragDecoderStatus_t Status;
+} FragDecoder_t;
+
+/*!
+ * \brief Initializes a fragmentation decoder
+ *
+ * \remark The number of lost fragments the decoder can recover is the largest
+ *         one the storage can hold, see \ref FRAG_DECODER_STORAGE_SIZE.
+ *
+ * \param [out] decoder    Decoder context
+ * \param [in] storage     Storage of the decoder buffers, kept by the decoder until the next FragDecoderInit
+ * \param [in] storageSize Size of the storage [bytes]
+ * \param [in] fragNb      Number of expected fragments (without redundancy packets)
+ * \param [in] fragSize    Size of a fragment
+ * \param [in] callbacks   Pointer to the Write/Read functions.
+ * \param [in] fragPVer    Fragmentation Package version to adapt the LDPC matrix usage
+ *
+ * \retval status          [0: Success, -1: the storage cannot recover a lost fragment]
+ */
+int32_t FragDecoderInit( FragDecoder_t *decoder, uint32_t *storage, uint32_t storageSize,
+                         uint16_t fragNb, uint8_t fragSize, FragDecoderCallbacks_t *callbacks, uint8_t fragPVer );
 
 /*!
  * \brief Gets the maximum file size that can be received
@@ -102,6 +211,7 @@ uint32_t FragDecoderGetMaxFileSize( void );
  * \brief Function to decode and reconstruct the binary file
  *        Called for each receive frame
  *
+ * \param [in] decoder     Decoder context
  * \param [in] fragCounter Fragment counter [1..(FragDecoder.FragNb + FragDecoder.Redundancy)]
  * \param [in] rawData     Pointer to the fragment to be processed (length = FragDecoder.FragSize)
  *
@@ -109,14 +219,70 @@ uint32_t FragDecoderGetMaxFileSize( void );
  *                                          FRAG_SESSION_FINISHED or
  *                                          FragDecoder.Status.FragNbLost]
  */
-int32_t FragDecoderProcess( uint16_t fragCounter, uint8_t *rawData );
+int32_t FragDecoderProcess( FragDecoder_t *decoder, uint16_t fragCounter, uint8_t *rawData );
+
+/*!
+ * \brief Queues a received frame, to be decoded later by \ref FragDecoderProcessPending
+ *
+ * \remark Uncoded frames received while nothing is pending are decoded at
+ *         once, they only take a row write. When the queue is full, the queued
+ *         frames are decoded before the new one is queued.
+ *
+ * \param [in] decoder     Decoder context
+ * \param [in] fragCounter Fragment counter [1..(FragDecoder.FragNb + FragDecoder.Redundancy)]
+ * \param [in] rawData     Pointer to the fragment to be processed (length = FragDecoder.FragSize),
+ *                         copied by the decoder
+ *
+ * \retval status          Process status. [FRAG_SESSION_ONGOING,
+ *                                          FRAG_SESSION_FINISHED or
+ *                                          FragDecoder.Status.FragNbLost]
+ */
+int32_t FragDecoderQueue( FragDecoder_t *decoder, uint16_t fragCounter, uint8_t *rawData );
+
+/*!
+ * \brief Decodes the queued frames for a bounded amount of work
+ *
+ * The decoding of a coded frame is resumed where the previous call stopped.
+ * The results are the same as calling \ref FragDecoderProcess for each frame.
+ *
+ * \param [in] decoder        Decoder context
+ * \param [in] maxRowAccesses Maximum number of fragment rows read or written
+ *
+ * \retval status          Process status. [FRAG_SESSION_ONGOING,
+ *                                          FRAG_SESSION_FINISHED or
+ *                                          FragDecoder.Status.FragNbLost]
+ */
+int32_t FragDecoderProcessPending( FragDecoder_t *decoder, uint32_t maxRowAccesses );
+
+/*!
+ * \brief Checks if queued frames are still to be decoded
+ *
+ * \param [in] decoder Decoder context
+ *
+ * \retval status [true: frames pending, false: nothing to decode]
+ */
+bool FragDecoderIsPending( FragDecoder_t *decoder );
 
 /*!
  * \brief Gets the current fragmentation status
  *
+ * \param [in] decoder Decoder context
+ *
  * \retval status Fragmentation decoder status
  */
-FragDecoderStatus_t FragDecoderGetStatus( void );
+FragDecoderStatus_t FragDecoderGetStatus( FragDecoder_t *decoder );
+
+/*!
+ * \brief Gets the number of rows at the start of the file which are final,
+ *        no fragment before them is lost
+ *
+ * \param [in] decoder Decoder context
+ *
+ * \retval rowsNb      Number of rows, only meaningful while the session is ongoing
+ *
+ * \note The rows may be held in the write block until the session is finished
+ */
+uint16_t FragDecoderGetLeadingRows( FragDecoder_t *decoder );
 
 #ifdef __cplusplus
 }
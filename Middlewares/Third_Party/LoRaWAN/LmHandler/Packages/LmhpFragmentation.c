@@ -51,7 +51,14 @@
 #define FRAGMENTATION_VERSION                       2
 #endif /* LORAWAN_PACKAGES_VERSION */
 
-#define FRAGMENTATION_MAX_SESSIONS                  4
+/*!
+ * Maximum number of fragment rows read or written by the decoder on each
+ * package process call, the decoding of the coded fragments is spread over
+ * several calls
+ */
+#ifndef FRAGMENTATION_PROCESS_SLICE_ROWS
+#define FRAGMENTATION_PROCESS_SLICE_ROWS            32
+#endif /* FRAGMENTATION_PROCESS_SLICE_ROWS */
 
 /*!
  * Package current context
@@ -138,6 +145,54 @@ static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication
  */
 static void OnFragmentProcessTimer( void *context );
 
+/*!
+ * Notifies the progress of a fragmentation session and completes the session
+ * when the decoder is done
+ *
+ * \param [in]     fragIndex       Fragmentation session index
+ * \param [in,out] dataBufferIndex Index of the next answer byte in DataBuffer
+ *
+ * \retval isAnswerDelayed         true when a delayed answer has been added
+ */
+static bool LmhpFragmentationOnDecoderStatus( uint8_t fragIndex, uint8_t *dataBufferIndex );
+
+/*!
+ * Schedules the transmission of the answer prepared in DataBuffer
+ *
+ * \param [in] dataBufferIndex Size of the answer
+ * \param [in] isAnswerDelayed Sends the answer after a random delay
+ */
+static void LmhpFragmentationScheduleAnswer( uint8_t dataBufferIndex, bool isAnswerDelayed );
+
+#if ( FRAGMENTATION_VERSION == 2 )
+/*!
+ * Adds a row of the file to the MIC of a fragmentation session
+ *
+ * \param [in] fragIndex Fragmentation session index
+ * \param [in] rowData   Data of the next row not yet in the MIC
+ */
+static void LmhpFragmentationMicUpdate( uint8_t fragIndex, uint8_t *rowData );
+
+/*!
+ * Adds the rows left to the MIC of a finished fragmentation session, read back
+ * from the file, and answers the data block reception once all are in
+ *
+ * \param [in]     fragIndex       Fragmentation session index
+ * \param [in]     maxRows         Maximum number of rows read back on this call
+ * \param [in,out] dataBufferIndex Index of the next answer byte in DataBuffer
+ *
+ * \retval isAnswerDelayed         true when the answer has been added
+ */
+static bool LmhpFragmentationMicProcess( uint8_t fragIndex, uint16_t maxRows, uint8_t *dataBufferIndex );
+
+/*!
+ * Drops the MIC of a fragmentation session
+ *
+ * \param [in] fragIndex Fragmentation session index
+ */
+static void LmhpFragmentationMicRelease( uint8_t fragIndex );
+#endif /* FRAGMENTATION_VERSION */
+
 static LmhpFragmentationState_t LmhpFragmentationState =
 {
     .Initialized = false,
@@ -191,12 +246,50 @@ typedef struct FragGroupData_s
 typedef struct FragSessionData_s
 {
     FragGroupData_t FragGroupData;
+    FragDecoder_t FragDecoder;
     FragDecoderStatus_t FragDecoderStatus;
     int32_t FragDecoderProcessStatus;
+#if ( FRAGMENTATION_VERSION == 2 )
+    /*!
+     * MIC of the file, the rows are added in order as soon as they are final
+     */
+    CmacStreamCtx_t MicCtx;
+    /*!
+     * Number of rows of the file added to the MIC
+     */
+    uint16_t MicRowNb;
+    bool IsMicStarted;
+    /*!
+     * The session is finished, the rows left are read back from the file by LmhpFragmentationProcess
+     */
+    bool IsMicPending;
+#endif /* FRAGMENTATION_VERSION */
 } FragSessionData_t;
 
 static FragSessionData_t FragSessionData[FRAGMENTATION_MAX_SESSIONS];
 
+/*!
+ * Storage of the decoder shared by the sessions without their own resources
+ */
+static uint32_t FragDecoderStorage[FRAG_DECODER_STORAGE_SIZE( FRAG_MAX_NB, FRAG_MAX_SIZE, FRAG_MAX_REDUNDANCY ) / 4];
+
+/*!
+ * Resources of the sessions without their own resources, built from the package parameters
+ */
+static LmhpFragmentationSessionParams_t SharedSessionParams;
+
+/*!
+ * Decoding resources of each session
+ */
+static const LmhpFragmentationSessionParams_t *SessionParams[FRAGMENTATION_MAX_SESSIONS];
+
+#if ( FRAGMENTATION_VERSION == 2 )
+/*!
+ * Row of a file read back for its MIC
+ */
+static uint32_t MicRowBuffer[DIVC( FRAG_MAX_SIZE, 4 )];
+#endif /* FRAGMENTATION_VERSION */
+
 static LmhPackage_t LmhpFragmentationPackage =
 {
     .Port = FRAGMENTATION_PORT,
@@ -228,7 +321,7 @@ static uint8_t BlockAckDelay = 0;
 
 #if ( FRAGMENTATION_VERSION == 2 )
 /* fragmentation counter session */
-static int32_t SessionCntPrev[FRAGMENTATION_MAX_SESSIONS] = {-1, -1, -1, -1};
+static int32_t SessionCntPrev[FRAGMENTATION_MAX_SESSIONS];
 #endif /* FRAGMENTATION_VERSION */
 
 /*!
@@ -263,6 +356,24 @@ static void LmhpFragmentationInit( void *params, uint8_t *dataBuffer, uint8_t da
         TxDelayTime = 0;
         /* Initialize Fragmentation delay timer. */
         TimerInit( &FragmentProcessTimer, OnFragmentProcessTimer );
+
+        SharedSessionParams.DecoderCallbacks = LmhpFragmentationParams->DecoderCallbacks;
+        SharedSessionParams.RegionSize = FRAG_DECODER_DWL_REGION_SIZE;
+        SharedSessionParams.DecoderStorage = FragDecoderStorage;
+        SharedSessionParams.DecoderStorageSize = sizeof( FragDecoderStorage );
+        SharedSessionParams.OnProgress = LmhpFragmentationParams->OnProgress;
+        SharedSessionParams.OnDone = LmhpFragmentationParams->OnDone;
+        for( uint8_t i = 0; i < FRAGMENTATION_MAX_SESSIONS; i++ )
+        {
+            if( LmhpFragmentationParams->Sessions[i] != NULL )
+            {
+                SessionParams[i] = LmhpFragmentationParams->Sessions[i];
+            }
+            else
+            {
+                SessionParams[i] = &SharedSessionParams;
+            }
+        }
     }
     else
     {
@@ -273,6 +384,12 @@ static void LmhpFragmentationInit( void *params, uint8_t *dataBuffer, uint8_t da
 
     /* initialize the global fragmentation session buffer */
     memset1( ( uint8_t * )FragSessionData, 0, sizeof( FragSessionData ) );
+#if ( FRAGMENTATION_VERSION == 2 )
+    for( uint8_t i = 0; i < FRAGMENTATION_MAX_SESSIONS; i++ )
+    {
+        SessionCntPrev[i] = -1;
+    }
+#endif /* FRAGMENTATION_VERSION */
 }
 
 static bool LmhpFragmentationIsInitialized( void )
@@ -287,6 +404,50 @@ static bool LmhpFragmentationIsTxPending( void )
 
 static void LmhpFragmentationProcess( void )
 {
+    bool isProcessPending = false;
+
+    for( uint8_t fragIndex = 0; fragIndex < FRAGMENTATION_MAX_SESSIONS; fragIndex++ )
+    {
+        FragDecoder_t *decoder = &FragSessionData[fragIndex].FragDecoder;
+
+        if( ( FragSessionData[fragIndex].FragGroupData.IsActive == true ) && ( FragDecoderIsPending( decoder ) == true ) )
+        {
+            /* Decode the queued fragments a slice at a time, out of the MAC indications */
+            uint8_t dataBufferIndex = LmhpFragmentationState.DataBufferSize;
+
+            FragSessionData[fragIndex].FragDecoderProcessStatus = FragDecoderProcessPending( decoder, FRAGMENTATION_PROCESS_SLICE_ROWS );
+            if( LmhpFragmentationOnDecoderStatus( fragIndex, &dataBufferIndex ) == true )
+            {
+                LmhpFragmentationScheduleAnswer( dataBufferIndex, true );
+            }
+            if( FragDecoderIsPending( decoder ) == true )
+            {
+                isProcessPending = true;
+            }
+        }
+#if ( FRAGMENTATION_VERSION == 2 )
+        else if( ( FragSessionData[fragIndex].FragGroupData.IsActive == true ) && ( FragSessionData[fragIndex].IsMicPending == true ) )
+        {
+            /* Read back a slice of the rows left out of the MIC */
+            uint8_t dataBufferIndex = LmhpFragmentationState.DataBufferSize;
+
+            if( LmhpFragmentationMicProcess( fragIndex, FRAGMENTATION_PROCESS_SLICE_ROWS, &dataBufferIndex ) == true )
+            {
+                LmhpFragmentationScheduleAnswer( dataBufferIndex, true );
+            }
+            if( FragSessionData[fragIndex].IsMicPending == true )
+            {
+                isProcessPending = true;
+            }
+        }
+#endif /* FRAGMENTATION_VERSION */
+    }
+    if( ( isProcessPending == true ) && ( LmhpFragmentationPackage.OnPackageProcessEvent != NULL ) )
+    {
+        /* Each session with queued fragments or rows to read back gets a slice per call */
+        LmhpFragmentationPackage.OnPackageProcessEvent();
+    }
+
     if( LmhpFragmentationState.IsTxPending == true )
     {
         /* Send the reply. */
@@ -317,9 +478,6 @@ static void LmhpFragmentationProcess( void )
     }
 }
 
-
-static uint8_t buffer[FRAG_MAX_SIZE];
-
 static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication )
 {
     uint8_t cmdIndex = 0;
@@ -355,7 +513,7 @@ static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication
                     uint8_t participants = fragIndex & 0x01;
 
                     fragIndex = ( fragIndex >> 1 ) & 0x03;
-                    FragSessionData[fragIndex].FragDecoderStatus = FragDecoderGetStatus( );
+                    FragSessionData[fragIndex].FragDecoderStatus = FragDecoderGetStatus( &FragSessionData[fragIndex].FragDecoder );
 
                     if( ( participants == 1 ) ||
                         ( ( participants == 0 ) && ( FragSessionData[fragIndex].FragDecoderStatus.FragNbLost > 0 ) ) )
@@ -418,7 +576,8 @@ static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication
                     if( ( fragSessionData.FragGroupData.FragNb > FRAG_MAX_NB ) ||
                         ( fragSessionData.FragGroupData.FragSize > FRAG_MAX_SIZE ) ||
                         ( fragSessionData.FragGroupData.FragSize < FRAG_MIN_SIZE ) ||
-                        ( ( fragSessionData.FragGroupData.FragNb * fragSessionData.FragGroupData.FragSize ) > FRAG_DECODER_DWL_REGION_SIZE ) )
+                        ( ( fragSessionData.FragGroupData.FragNb * fragSessionData.FragGroupData.FragSize ) >
+                          SessionParams[fragSessionData.FragGroupData.FragSession.Fields.FragIndex]->RegionSize ) )
                     {
                         status |= 0x02; /* Not enough Memory */
                     }
@@ -449,14 +608,56 @@ static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication
                     if( ( status & 0x1F ) == 0 )
                     {
 #endif /* FRAGMENTATION_VERSION */
-                        /* The FragSessionSetup is accepted */
-                        fragSessionData.FragGroupData.IsActive = true;
-                        fragSessionData.FragDecoderProcessStatus = FRAG_SESSION_ONGOING;
-                        FragSessionData[fragSessionData.FragGroupData.FragSession.Fields.FragIndex] = fragSessionData;
-                        FragDecoderInit( fragSessionData.FragGroupData.FragNb,
-                                         fragSessionData.FragGroupData.FragSize,
-                                         &LmhpFragmentationParams->DecoderCallbacks,
-                                         FRAGMENTATION_VERSION );
+                        uint8_t fragIndex = fragSessionData.FragGroupData.FragSession.Fields.FragIndex;
+                        const LmhpFragmentationSessionParams_t *sessionParams = SessionParams[fragIndex];
+
+                        if( FragDecoderInit( &fragSessionData.FragDecoder,
+                                             sessionParams->DecoderStorage,
+                                             sessionParams->DecoderStorageSize,
+                                             fragSessionData.FragGroupData.FragNb,
+                                             fragSessionData.FragGroupData.FragSize,
+                                             ( FragDecoderCallbacks_t * )&sessionParams->DecoderCallbacks,
+                                             FRAGMENTATION_VERSION ) != 0 )
+                        {
+                            status |= 0x02; /* Not enough Memory */
+                        }
+                        else
+                        {
+                            if( sessionParams == &SharedSessionParams )
+                            {
+                                /* The shared decoder now belongs to this session */
+                                for( uint8_t i = 0; i < FRAGMENTATION_MAX_SESSIONS; i++ )
+                                {
+                                    if( ( i != fragIndex ) && ( SessionParams[i] == &SharedSessionParams ) )
+                                    {
+                                        FragSessionData[i].FragGroupData.IsActive = false;
+#if ( FRAGMENTATION_VERSION == 2 )
+                                        LmhpFragmentationMicRelease( i );
+#endif /* FRAGMENTATION_VERSION */
+                                    }
+                                }
+                            }
+#if ( FRAGMENTATION_VERSION == 2 )
+                            LmhpFragmentationMicRelease( fragIndex );
+                            fragSessionData.MicRowNb = 0;
+                            fragSessionData.IsMicStarted = false;
+                            fragSessionData.IsMicPending = false;
+                            if( fragSessionData.FragGroupData.Control.Fields.AckReception == 1 )
+                            {
+                                /* The MIC is computed along the reception, the file needs not be memory mapped */
+                                fragSessionData.IsMicStarted = ( LoRaMacStartMicForDatablock( &fragSessionData.MicCtx,
+                                                                                              ( fragSessionData.FragGroupData.FragNb * fragSessionData.FragGroupData.FragSize ) -
+                                                                                              fragSessionData.FragGroupData.Padding,
+                                                                                              fragSessionData.FragGroupData.SessionCnt,
+                                                                                              fragIndex,
+                                                                                              fragSessionData.FragGroupData.Descriptor ) == LORAMAC_STATUS_OK );
+                            }
+#endif /* FRAGMENTATION_VERSION */
+                            /* The FragSessionSetup is accepted */
+                            fragSessionData.FragGroupData.IsActive = true;
+                            fragSessionData.FragDecoderProcessStatus = FRAG_SESSION_ONGOING;
+                            FragSessionData[fragIndex] = fragSessionData;
+                        }
                     }
                     LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FRAGMENTATION_FRAG_SESSION_SETUP_ANS;
                     LmhpFragmentationState.DataBuffer[dataBufferIndex++] = status;
@@ -482,6 +683,9 @@ static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication
                     {
                         /* Delete session */
                         FragSessionData[id].FragGroupData.IsActive = false;
+#if ( FRAGMENTATION_VERSION == 2 )
+                        LmhpFragmentationMicRelease( id );
+#endif /* FRAGMENTATION_VERSION */
                     }
                     LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FRAGMENTATION_FRAG_SESSION_DELETE_ANS;
                     LmhpFragmentationState.DataBuffer[dataBufferIndex++] = status;
@@ -540,63 +744,32 @@ static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication
 
                     if( FragSessionData[fragIndex].FragDecoderProcessStatus == FRAG_SESSION_ONGOING )
                     {
-                        memcpy(buffer, (void *)&mcpsIndication->Buffer[cmdIndex], FragSessionData[fragIndex].FragGroupData.FragSize);
-                        FragSessionData[fragIndex].FragDecoderProcessStatus = FragDecoderProcess( fragCounter, buffer );
-                        FragSessionData[fragIndex].FragDecoderStatus = FragDecoderGetStatus( );
-                        if( LmhpFragmentationParams->OnProgress != NULL )
-                        {
-                            LmhpFragmentationParams->OnProgress( FragSessionData[fragIndex].FragDecoderStatus.FragNbRx,
-                                                                 FragSessionData[fragIndex].FragGroupData.FragNb,
-                                                                 FragSessionData[fragIndex].FragGroupData.FragSize,
-                                                                 FragSessionData[fragIndex].FragDecoderStatus.FragNbLost );
-                        }
-
-                        if( FragSessionData[fragIndex].FragDecoderProcessStatus >= 0 )
-                        {
-                            uint32_t UnfragmentedBufferAddr;
-                            /* Fragmentation successfully done */
-                            if( LmhpFragmentationParams->OnDone != NULL )
-                            {
-                                LmhpFragmentationParams->OnDone( FragSessionData[fragIndex].FragDecoderProcessStatus,
-                                                                 ( FragSessionData[fragIndex].FragGroupData.FragNb * FragSessionData[fragIndex].FragGroupData.FragSize ) -
-                                                                 FragSessionData[fragIndex].FragGroupData.Padding,
-                                                                 &UnfragmentedBufferAddr );
-                            }
-
 #if ( FRAGMENTATION_VERSION == 2 )
-                            /*If AckReception = 0, the end-device SHALL do nothing */
-                            if( FragSessionData[fragIndex].FragGroupData.Control.Fields.AckReception == 1 )
-                            {
-                                uint8_t status = 0x00;
-                                uint32_t micComputed = 0;
-
-                                status = fragIndex;
-
-                                /* Compute MIC */
-                                LoRaMacProcessMicForDatablock( ( uint8_t * )UnfragmentedBufferAddr,
-                                                               ( FragSessionData[fragIndex].FragGroupData.FragNb * FragSessionData[fragIndex].FragGroupData.FragSize ) -
-                                                               FragSessionData[fragIndex].FragGroupData.Padding,
-                                                               FragSessionData[fragIndex].FragGroupData.SessionCnt,
-                                                               fragIndex,
-                                                               FragSessionData[fragIndex].FragGroupData.Descriptor,
-                                                               &micComputed );
-                                MW_LOG( TS_OFF, VLEVEL_M, "MIC         : %08X\r\n", micComputed );
-
-                                /* check if the MIC computed is equal to the MIC received */
-                                if( micComputed != FragSessionData[fragIndex].FragGroupData.Mic )
-                                {
-                                    status |= 0x04;
-                                }
-
-                                LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FRAGMENTATION_FRAG_DATA_BLOCK_RECEIVED_REQ;
-                                LmhpFragmentationState.DataBuffer[dataBufferIndex++] = status;
-                                BlockAckDelay = FragSessionData[fragIndex].FragGroupData.Control.Fields.BlockAckDelay;
-                                isAnswerDelayed = true;
-                                LmhpFragmentationState.FragDataBlockAnsRequired = true;
-                            }
+                        /* An uncoded fragment is stored right away when nothing is queued */
+                        bool isMicNextRow = ( FragSessionData[fragIndex].IsMicStarted == true ) &&
+                                            ( fragCounter == ( FragSessionData[fragIndex].MicRowNb + 1 ) ) &&
+                                            ( FragDecoderIsPending( &FragSessionData[fragIndex].FragDecoder ) == false );
 #endif /* FRAGMENTATION_VERSION */
 
-                            FragSessionData[fragIndex].FragDecoderProcessStatus = FRAG_SESSION_NOT_STARTED;
+                        /* The coded fragments are decoded later on by LmhpFragmentationProcess */
+                        FragSessionData[fragIndex].FragDecoderProcessStatus = FragDecoderQueue( &FragSessionData[fragIndex].FragDecoder, fragCounter,
+                                                                                                &mcpsIndication->Buffer[cmdIndex] );
+#if ( FRAGMENTATION_VERSION == 2 )
+                        if( ( isMicNextRow == true ) &&
+                            ( FragDecoderGetLeadingRows( &FragSessionData[fragIndex].FragDecoder ) >= fragCounter ) )
+                        {
+                            /* The row is final, it is added to the MIC from the frame buffer */
+                            LmhpFragmentationMicUpdate( fragIndex, &mcpsIndication->Buffer[cmdIndex] );
+                        }
+#endif /* FRAGMENTATION_VERSION */
+                        if( LmhpFragmentationOnDecoderStatus( fragIndex, &dataBufferIndex ) == true )
+                        {
+                            isAnswerDelayed = true;
+                        }
+                        if( ( FragDecoderIsPending( &FragSessionData[fragIndex].FragDecoder ) == true ) &&
+                            ( LmhpFragmentationPackage.OnPackageProcessEvent != NULL ) )
+                        {
+                            LmhpFragmentationPackage.OnPackageProcessEvent();
                         }
                     }
                     cmdIndex += FragSessionData[fragIndex].FragGroupData.FragSize;
@@ -613,6 +786,151 @@ static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication
         }
     }
 
+    LmhpFragmentationScheduleAnswer( dataBufferIndex, isAnswerDelayed );
+}
+
+static bool LmhpFragmentationOnDecoderStatus( uint8_t fragIndex, uint8_t *dataBufferIndex )
+{
+    bool isAnswerDelayed = false;
+    const LmhpFragmentationSessionParams_t *sessionParams = SessionParams[fragIndex];
+
+    if( ( FragSessionData[fragIndex].FragDecoderProcessStatus < 0 ) && ( FragDecoderIsPending( &FragSessionData[fragIndex].FragDecoder ) == true ) )
+    {
+        /* The progress is notified once the queued fragments are decoded */
+        return false;
+    }
+
+    FragSessionData[fragIndex].FragDecoderStatus = FragDecoderGetStatus( &FragSessionData[fragIndex].FragDecoder );
+    if( sessionParams->OnProgress != NULL )
+    {
+        sessionParams->OnProgress( FragSessionData[fragIndex].FragDecoderStatus.FragNbRx,
+                                   FragSessionData[fragIndex].FragGroupData.FragNb,
+                                   FragSessionData[fragIndex].FragGroupData.FragSize,
+                                   FragSessionData[fragIndex].FragDecoderStatus.FragNbLost );
+    }
+
+    if( FragSessionData[fragIndex].FragDecoderProcessStatus >= 0 )
+    {
+        uint32_t UnfragmentedBufferAddr;
+        /* Fragmentation successfully done */
+        if( sessionParams->OnDone != NULL )
+        {
+            sessionParams->OnDone( FragSessionData[fragIndex].FragDecoderProcessStatus,
+                                   ( FragSessionData[fragIndex].FragGroupData.FragNb * FragSessionData[fragIndex].FragGroupData.FragSize ) -
+                                   FragSessionData[fragIndex].FragGroupData.Padding,
+                                   &UnfragmentedBufferAddr );
+        }
+
+#if ( FRAGMENTATION_VERSION == 2 )
+        /*If AckReception = 0, the end-device SHALL do nothing */
+        if( FragSessionData[fragIndex].FragGroupData.Control.Fields.AckReception == 1 )
+        {
+            /* Without lost fragment the MIC is complete, otherwise the rows from the
+               first lost one are read back from the file by LmhpFragmentationProcess */
+            FragSessionData[fragIndex].IsMicPending = true;
+            isAnswerDelayed = LmhpFragmentationMicProcess( fragIndex, 0, dataBufferIndex );
+            if( ( FragSessionData[fragIndex].IsMicPending == true ) && ( LmhpFragmentationPackage.OnPackageProcessEvent != NULL ) )
+            {
+                LmhpFragmentationPackage.OnPackageProcessEvent();
+            }
+        }
+#endif /* FRAGMENTATION_VERSION */
+
+        FragSessionData[fragIndex].FragDecoderProcessStatus = FRAG_SESSION_NOT_STARTED;
+    }
+    return isAnswerDelayed;
+}
+
+#if ( FRAGMENTATION_VERSION == 2 )
+static void LmhpFragmentationMicUpdate( uint8_t fragIndex, uint8_t *rowData )
+{
+    FragSessionData_t *fragSession = &FragSessionData[fragIndex];
+    uint32_t addr = ( uint32_t )fragSession->MicRowNb * fragSession->FragGroupData.FragSize;
+    uint32_t fileSize = ( ( uint32_t )fragSession->FragGroupData.FragNb * fragSession->FragGroupData.FragSize ) -
+                        fragSession->FragGroupData.Padding;
+    uint32_t size = 0;
+
+    /* The padding of the last row is not part of the file */
+    if( addr < fileSize )
+    {
+        size = MIN( fragSession->FragGroupData.FragSize, fileSize - addr );
+    }
+    if( LoRaMacUpdateMicForDatablock( &fragSession->MicCtx, rowData, size ) != LORAMAC_STATUS_OK )
+    {
+        LmhpFragmentationMicRelease( fragIndex );
+        return;
+    }
+    fragSession->MicRowNb++;
+}
+
+static bool LmhpFragmentationMicProcess( uint8_t fragIndex, uint16_t maxRows, uint8_t *dataBufferIndex )
+{
+    FragSessionData_t *fragSession = &FragSessionData[fragIndex];
+    const LmhpFragmentationSessionParams_t *sessionParams = SessionParams[fragIndex];
+    uint8_t status = fragIndex;
+    uint32_t micComputed = 0;
+
+    while( ( fragSession->IsMicStarted == true ) && ( fragSession->MicRowNb < fragSession->FragGroupData.FragNb ) )
+    {
+        if( maxRows == 0 )
+        {
+            /* Carries on at the next call */
+            return false;
+        }
+        maxRows--;
+
+        if( ( sessionParams->DecoderCallbacks.FragDecoderRead == NULL ) ||
+            ( sessionParams->DecoderCallbacks.FragDecoderRead( ( uint32_t )fragSession->MicRowNb * fragSession->FragGroupData.FragSize,
+                                                               ( uint8_t * )MicRowBuffer, fragSession->FragGroupData.FragSize ) != 0 ) )
+        {
+            LmhpFragmentationMicRelease( fragIndex );
+            break;
+        }
+        LmhpFragmentationMicUpdate( fragIndex, ( uint8_t * )MicRowBuffer );
+    }
+    fragSession->IsMicPending = false;
+
+    if( ( fragSession->IsMicStarted == false ) ||
+        ( LoRaMacFinishMicForDatablock( &fragSession->MicCtx, &micComputed ) != LORAMAC_STATUS_OK ) )
+    {
+        /* The MIC could not be computed */
+        status |= 0x04;
+    }
+    else
+    {
+        MW_LOG( TS_OFF, VLEVEL_M, "MIC         : %08X\r\n", micComputed );
+
+        /* check if the MIC computed is equal to the MIC received */
+        if( micComputed != fragSession->FragGroupData.Mic )
+        {
+            status |= 0x04;
+        }
+    }
+    fragSession->IsMicStarted = false;
+
+    LmhpFragmentationState.DataBuffer[( *dataBufferIndex )++] = FRAGMENTATION_FRAG_DATA_BLOCK_RECEIVED_REQ;
+    LmhpFragmentationState.DataBuffer[( *dataBufferIndex )++] = status;
+    BlockAckDelay = fragSession->FragGroupData.Control.Fields.BlockAckDelay;
+    LmhpFragmentationState.FragDataBlockAnsRequired = true;
+    return true;
+}
+
+static void LmhpFragmentationMicRelease( uint8_t fragIndex )
+{
+    uint32_t mic;
+
+    if( FragSessionData[fragIndex].IsMicStarted == true )
+    {
+        /* Ending the MIC releases its secure element resources */
+        ( void )LoRaMacFinishMicForDatablock( &FragSessionData[fragIndex].MicCtx, &mic );
+        FragSessionData[fragIndex].IsMicStarted = false;
+    }
+    FragSessionData[fragIndex].IsMicPending = false;
+}
+#endif /* FRAGMENTATION_VERSION */
+
+static void LmhpFragmentationScheduleAnswer( uint8_t dataBufferIndex, bool isAnswerDelayed )
+{
     /* After processing the commands, if the end-node has to reply back then a flag is checked if the */
     /* reply is to be sent immediately or with a delay. */
     /* In some scenarios it is not desired that multiple end-notes send uplinks at the same time to */
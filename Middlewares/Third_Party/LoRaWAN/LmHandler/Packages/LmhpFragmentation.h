@@ -38,6 +38,61 @@ extern "C"
  */
 #define PACKAGE_ID_FRAGMENTATION                    3
 
+/*!
+ * Maximum number of fragmentation sessions
+ *
+ * \remark Only the sessions given their own resources in
+ *         LmhpFragmentationParams_t.Sessions are decoded concurrently.
+ */
+#define FRAGMENTATION_MAX_SESSIONS                  4
+
+/*!
+ * Decoding resources of a fragmentation session
+ *
+ * \remark The resources of a session must not be given to another session.
+ */
+typedef struct LmhpFragmentationSessionParams_s
+{
+    /*!
+     * FragDecoder Write/Read function callbacks, on the flash region of the session
+     *
+     * \remark FragDecoderRead also reads back the rows recovered from the coded
+     *         fragments for the data block MIC, the region needs not be memory mapped.
+     */
+    FragDecoderCallbacks_t DecoderCallbacks;
+    /*!
+     * Size of the flash region of the session [bytes]
+     */
+    uint32_t RegionSize;
+    /*!
+     * Storage of the decoder of the session, see \ref FRAG_DECODER_STORAGE_SIZE
+     */
+    uint32_t *DecoderStorage;
+    /*!
+     * Size of DecoderStorage [bytes]
+     */
+    uint32_t DecoderStorageSize;
+    /*!
+     * Notifies the progress of the fragmentation session
+     *
+     * \param [in] fragCounter Fragment counter
+     * \param [in] fragNb      Number of fragments
+     * \param [in] fragSize    Size of fragments
+     * \param [in] fragNbLost  Number of lost fragments
+     */
+    void ( *OnProgress )( uint16_t fragCounter, uint16_t fragNb, uint8_t fragSize, uint16_t fragNbLost );
+    /*!
+     * Notifies that the fragmentation session is finished
+     *
+     * \param [in] status Fragmentation session status [FRAG_SESSION_ONGOING,
+     *                                                  FRAG_SESSION_FINISHED or
+     *                                                  FragDecoder.Status.FragNbLost]
+     * \param [in] size   Received file size
+     * \param [out] addr  Pointer address of the unfragmented datablock
+     */
+    void ( *OnDone )( int32_t status, uint32_t size, uint32_t *addr );
+} LmhpFragmentationSessionParams_t;
+
 /*!
  * Fragmentation package parameters
  */
@@ -45,6 +100,9 @@ typedef struct LmhpFragmentationParams_s
 {
     /*!
      * FragDecoder Write/Read function callbacks
+     *
+     * \remark FragDecoderRead also reads back the rows recovered from the coded
+     *         fragments for the data block MIC, the region needs not be memory mapped.
      */
     FragDecoderCallbacks_t DecoderCallbacks;
     /*!
@@ -66,6 +124,18 @@ typedef struct LmhpFragmentationParams_s
      * \param [out] addr  Pointer address of the unfragmented datablock
      */
     void ( *OnDone )( int32_t status, uint32_t size, uint32_t *addr );
+    /*!
+     * Decoding resources of the fragmentation sessions, indexed by FragIndex.
+     * The sessions with their own resources are decoded concurrently.
+     *
+     * \remark The sessions without resources ( NULL ) use the members above and
+     *         share the decoder of the package: the setup of one of them ends
+     *         the others.
+     * \remark By default all the entries are NULL, as in the FUOTA applications:
+     *         one session is decoded at a time. To decode sessions concurrently,
+     *         give each of them a flash region and a decoder storage.
+     */
+    const LmhpFragmentationSessionParams_t *Sessions[FRAGMENTATION_MAX_SESSIONS];
 } LmhpFragmentationParams_t;
 
 LmhPackage_t *LmhpFragmentationPackageFactory( void );
@@ -71,6 +71,13 @@
  */
 #define LORA_MAC_COMMAND_MAX_FOPTS_LENGTH           15
 
+/*!
+ * Offset of FRMPayload in an uplink data frame without FOpts
+ *
+ * MHDR(1) + FHDR(7) + Port(1)
+ */
+#define LORAMAC_FRAME_PAYLOAD_OFFSET                ( LORAMAC_FRAME_PAYLOAD_OVERHEAD_SIZE - LORAMAC_MIC_FIELD_SIZE )
+
 /*!
  * LoRaMac duty cycle for the back-off procedure during the first hour.
  */
@@ -96,6 +103,17 @@
  */
 #define ABP_JOIN_PENDING_DELAY_MS                   10
 
+/*!
+ * All the NVM groups, flagged when the whole context may have been modified
+ */
+#define LORAMAC_NVM_ALL_GROUPS                      ( LORAMAC_NVM_NOTIFY_FLAG_CRYPTO |         \
+                                                      LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 |     \
+                                                      LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 |     \
+                                                      LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT | \
+                                                      LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 |  \
+                                                      LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 |  \
+                                                      LORAMAC_NVM_NOTIFY_FLAG_CLASS_B )
+
 #if defined(__ICCARM__)
 #ifndef __NO_INIT
 #define __NO_INIT __no_init
@@ -141,6 +159,70 @@ typedef enum eLoRaMacRequestHandling
     LORAMAC_REQUEST_HANDLING_ON = !LORAMAC_REQUEST_HANDLING_OFF
 }LoRaMacRequestHandling_t;
 
+/*!
+ * Number of datarates held by the PHY parameters snapshot
+ */
+#define LORAMAC_PHY_CACHE_NB_DR                     16
+
+/*!
+ * Snapshot of the PHY parameters read on the TX/RX path. The values only
+ * depend on the region, the dwell times and the repeater support, so they are
+ * kept until one of these changes.
+ */
+typedef struct sLoRaMacPhyCache
+{
+    /*!
+     * Set once the snapshot has been built
+     */
+    bool Valid;
+    /*!
+     * Region of the snapshot
+     */
+    LoRaMacRegion_t Region;
+    /*!
+     * Uplink dwell time of the snapshot
+     */
+    uint8_t UplinkDwellTime;
+    /*!
+     * Downlink dwell time of the snapshot
+     */
+    uint8_t DownlinkDwellTime;
+    /*!
+     * Repeater support of the snapshot
+     */
+    bool RepeaterSupport;
+    /*!
+     * Bitmap of the datarates of UplinkMaxPayload holding the region value
+     */
+    uint16_t UplinkMaxPayloadMask;
+    /*!
+     * Bitmap of the datarates of DownlinkMaxPayload holding the region value
+     */
+    uint16_t DownlinkMaxPayloadMask;
+    /*!
+     * Maximum payload length of each uplink datarate
+     */
+    uint8_t UplinkMaxPayload[LORAMAC_PHY_CACHE_NB_DR];
+    /*!
+     * Maximum payload length of each downlink datarate
+     */
+    uint8_t DownlinkMaxPayload[LORAMAC_PHY_CACHE_NB_DR];
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
+    /*!
+     * Maximum frame counter gap
+     */
+    uint32_t MaxFCntGap;
+    /*!
+     * Set when MaxFCntGap holds the region value
+     */
+    bool MaxFCntGapValid;
+#endif /* LORAMAC_VERSION */
+    /*!
+     * Number of times the snapshot has been rebuilt, for debug purposes
+     */
+    uint32_t RebuildCnt;
+}LoRaMacPhyCache_t;
+
 typedef struct sLoRaMacCtx
 {
     /*!
@@ -155,16 +237,14 @@ typedef struct sLoRaMacCtx
      * Current processed transmit message
      */
     LoRaMacMessage_t TxMsg;
-    /*!
-     * Buffer containing the data received by the application.
-     */
-    uint8_t AppData[LORAMAC_PHY_MAXPAYLOAD];
     /*!
      * Size of buffer containing the application data.
      */
     uint8_t AppDataSize;
     /*!
-     * Buffer containing the upper layer data.
+     * Copy of the frame received in class C. The radio keeps listening in
+     * class C and may receive the next frame into its buffer before the
+     * indication of the current one is delivered.
      */
     uint8_t RxPayload[LORAMAC_PHY_MAXPAYLOAD];
     SysTime_t LastTxSysTime;
@@ -322,10 +402,18 @@ typedef struct sLoRaMacCtx
      */
     TimerEvent_t AbpJoinPendingTimer;
 #endif /* LORAMAC_VERSION */
+    /*!
+     * NVM groups possibly modified since the last LoRaMacHandleNvm call
+     */
+    uint16_t NvmDirtyFlags;
     /*!
      * Buffer containing the MAC layer commands
      */
     uint8_t MacCommandsBuffer[LORA_MAC_COMMAND_MAX_LENGTH];
+    /*!
+     * Snapshot of the PHY parameters read on the TX/RX path
+     */
+    LoRaMacPhyCache_t PhyCache;
 }LoRaMacCtx_t;
 
 /*!
@@ -551,6 +639,31 @@ static LoRaMacStatus_t SwitchClass( DeviceClass_t deviceClass );
  */
 static uint8_t GetMaxAppPayloadWithoutFOptsLength( int8_t datarate );
 
+/*!
+ * \brief Gets the maximum payload length of a downlink datarate.
+ *
+ * \param [in] datarate        Downlink datarate
+ *
+ * \retval                    Max length
+ */
+static uint8_t GetMaxDownlinkPayloadLength( int8_t datarate );
+
+/*!
+ * \brief Gets the acknowledgement (v1.0.3) or retransmission timeout.
+ *
+ * \retval                    Timeout
+ */
+static uint32_t GetRetransmitTimeout( void );
+
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
+/*!
+ * \brief Gets the maximum frame counter gap.
+ *
+ * \retval                    Max gap
+ */
+static uint32_t GetMaxFCntGap( void );
+#endif /* LORAMAC_VERSION */
+
 /*!
  * \brief Validates if the payload fits into the frame, taking the datarate
  *        into account.
@@ -569,6 +682,50 @@ static uint8_t GetMaxAppPayloadWithoutFOptsLength( int8_t datarate );
  */
 static bool ValidatePayloadLength( uint8_t lenN, int8_t datarate, uint8_t fOptsLen );
 
+/*!
+ * Context of the downlink MAC commands being processed
+ */
+typedef struct sMacCommandsParseCtx
+{
+    /*!
+     * Buffer holding the MAC commands
+     */
+    uint8_t* Payload;
+    /*!
+     * Size of the MAC commands in the buffer
+     */
+    uint8_t Size;
+    /*!
+     * Index of the MAC command being processed
+     */
+    uint8_t Index;
+    /*!
+     * MAC command being processed, starting with its CID. The command is complete.
+     */
+    uint8_t* Cmd;
+    /*!
+     * Size of the MAC command being processed, see LoRaMacCommandsGetCmdSize
+     */
+    uint8_t CmdSize;
+    /*!
+     * SNR of the frame carrying the MAC commands
+     */
+    int8_t Snr;
+    /*!
+     * Set to true once a block of LinkAdrReq has been processed
+     */
+    bool AdrBlockFound;
+}MacCommandsParseCtx_t;
+
+/*!
+ * \brief Processes the downlink MAC command ctx->Cmd
+ *
+ * \param [in] ctx     Context of the MAC commands being processed
+ *
+ * \retval Number of bytes processed, at least ctx->CmdSize
+ */
+typedef uint8_t ( *MacCommandHandler_t )( MacCommandsParseCtx_t* ctx );
+
 /*!
  * \brief Decodes MAC commands in the fOpts field and in the payload
  *
@@ -902,6 +1059,22 @@ static void LoRaMacHandleRejoinEvents( void );
  */
 static void LoRaMacHandleNvm( LoRaMacNvmData_t* nvmData );
 
+/*!
+ * \brief Flags NVM groups as possibly modified, LoRaMacHandleNvm only computes
+ *        the CRC of the flagged groups
+ *
+ * \param [in] notifyFlags LORAMAC_NVM_NOTIFY_FLAG_XXX of the modified groups
+ */
+static void LoRaMacNvmSetDirty( uint16_t notifyFlags );
+
+/*!
+ * \brief Flags the region groups when the channels mask differs from a copy
+ *        taken before a region call which may reactivate the default channels
+ *
+ * \param [in] channelsMask Copy of the channels mask taken before the call
+ */
+static void LoRaMacNvmCheckChannelsMask( const uint16_t* channelsMask );
+
 #if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
 /*!
  * \brief This function verifies if the response timeout has been elapsed. If
@@ -1008,8 +1181,6 @@ static void UpdateRxSlotIdleState( void )
 
 static void ProcessRadioTxDone( void )
 {
-    GetPhyParams_t getPhy;
-    PhyParam_t phyParam;
     SetBandTxDoneParams_t txDone;
 
     if( Nvm.MacGroup2.DeviceClass != CLASS_C )
@@ -1047,17 +1218,13 @@ static void ProcessRadioTxDone( void )
 #if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
     if( ( Nvm.MacGroup2.DeviceClass == CLASS_C ) || ( MacCtx.NodeAckRequested == true ) )
     {
-        getPhy.Attribute = PHY_ACK_TIMEOUT;
-        phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
-        TimerSetValue( &MacCtx.AckTimeoutTimer, MacCtx.RxWindow2Delay + phyParam.Value );
+        TimerSetValue( &MacCtx.AckTimeoutTimer, MacCtx.RxWindow2Delay + GetRetransmitTimeout( ) );
         TimerStart( &MacCtx.AckTimeoutTimer );
     }
 #elif (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
     if( MacCtx.NodeAckRequested == true )
     {
-        getPhy.Attribute = PHY_RETRANSMIT_TIMEOUT;
-        phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
-        TimerSetValue( &MacCtx.RetransmitTimeoutTimer, MacCtx.RxWindow2Delay + phyParam.Value );
+        TimerSetValue( &MacCtx.RetransmitTimeoutTimer, MacCtx.RxWindow2Delay + GetRetransmitTimeout( ) );
         TimerStart( &MacCtx.RetransmitTimeoutTimer );
     }
     else
@@ -1082,6 +1249,7 @@ static void ProcessRadioTxDone( void )
     }
 
     RegionSetBandTxDone( Nvm.MacGroup2.Region, &txDone );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 );
 
 #if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
     if( MacCtx.NodeAckRequested == false )
@@ -1114,8 +1282,6 @@ static void ProcessRadioRxDone( void )
 {
     LoRaMacHeader_t macHdr;
     ApplyCFListParams_t applyCFList;
-    GetPhyParams_t getPhy;
-    PhyParam_t phyParam;
     LoRaMacCryptoStatus_t macCryptoStatus = LORAMAC_CRYPTO_ERROR;
 
     LoRaMacMessageData_t macMsgData;
@@ -1162,6 +1328,14 @@ static void ProcessRadioRxDone( void )
 
     Radio.Sleep( );
 
+    // In class C the frame is processed from a copy, see MacCtx.RxPayload.
+    // Class A and B frames are parsed and decrypted in place in the radio buffer.
+    if( ( Nvm.MacGroup2.DeviceClass == CLASS_C ) && ( size <= LORAMAC_PHY_MAXPAYLOAD ) )
+    {
+        memcpy1( MacCtx.RxPayload, payload, size );
+        payload = MacCtx.RxPayload;
+    }
+
 #if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
     TimerStop( &MacCtx.RxWindowTimer2 );
 #elif (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
@@ -1264,6 +1438,8 @@ static void ProcessRadioRxDone( void )
                 joinType = MLME_REJOIN_2;
             }
 #endif /* LORAMAC_VERSION */
+            // Join nonce, frame counters and session keys
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CRYPTO | LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
 #if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
             if( LORAMAC_CRYPTO_SUCCESS == macCryptoStatus )
             {
@@ -1355,6 +1531,8 @@ static void ProcessRadioRxDone( void )
 #endif /* LORAMAC_VERSION */
 
                 RegionApplyCFList( Nvm.MacGroup2.Region, &applyCFList );
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 |
+                                    LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
 
                 Nvm.MacGroup2.NetworkActivation = ACTIVATION_TYPE_OTAA;
 
@@ -1407,28 +1585,16 @@ static void ProcessRadioRxDone( void )
             // Intentional fall through
         case FRAME_TYPE_DATA_UNCONFIRMED_DOWN:
             // Check if the received payload size is valid
-            getPhy.UplinkDwellTime = Nvm.MacGroup2.MacParams.DownlinkDwellTime;
-            getPhy.Datarate = MacCtx.McpsIndication.RxDatarate;
-            getPhy.Attribute = PHY_MAX_PAYLOAD;
-
-            // Get the maximum payload length
-            if( Nvm.MacGroup2.MacParams.RepeaterSupport == true )
-            {
-                getPhy.Attribute = PHY_MAX_PAYLOAD_REPEATER;
-            }
-
-            phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
-            if( ( MAX( 0, ( int16_t )( ( int16_t ) size - ( int16_t ) LORAMAC_FRAME_PAYLOAD_OVERHEAD_SIZE ) ) > ( int16_t )phyParam.Value ) ||
+            if( ( MAX( 0, ( int16_t )( ( int16_t ) size - ( int16_t ) LORAMAC_FRAME_PAYLOAD_OVERHEAD_SIZE ) ) > ( int16_t )GetMaxDownlinkPayloadLength( MacCtx.McpsIndication.RxDatarate ) ) ||
                 ( size < LORAMAC_FRAME_PAYLOAD_MIN_SIZE ) )
             {
                 MacCtx.McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
                 PrepareRxDoneAbort( );
                 return;
             }
+            // The frame is parsed and decrypted in place, FRMPayload points into the radio buffer.
             macMsgData.Buffer = payload;
             macMsgData.BufSize = size;
-            macMsgData.FRMPayload = MacCtx.RxPayload;
-            macMsgData.FRMPayloadSize = LORAMAC_PHY_MAXPAYLOAD;
 
             if( LORAMAC_PARSER_SUCCESS != LoRaMacParserData( &macMsgData ) )
             {
@@ -1456,6 +1622,7 @@ static void ProcessRadioRxDone( void )
                     MacCtx.RxStatus.RxSlot = RX_SLOT_WIN_CLASS_B_MULTICAST_SLOT;
                     LoRaMacClassBSetFPendingBit( macMsgData.FHDR.DevAddr, ( uint8_t ) macMsgData.FHDR.FCtrl.Bits.FPending );
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 | LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
             }
 #endif /* LORAMAC_VERSION */
 
@@ -1501,12 +1668,8 @@ static void ProcessRadioRxDone( void )
             }
 
 #if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
-            // Get maximum allowed counter difference
-            getPhy.Attribute = PHY_MAX_FCNT_GAP;
-            phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
-
-            // Get downlink frame counter value
-            macCryptoStatus = GetFCntDown( addrID, fType, &macMsgData, Nvm.MacGroup2.Version, phyParam.Value, &fCntID, &downLinkCounter );
+            // Get downlink frame counter value, with the maximum allowed counter difference
+            macCryptoStatus = GetFCntDown( addrID, fType, &macMsgData, Nvm.MacGroup2.Version, GetMaxFCntGap( ), &fCntID, &downLinkCounter );
             if( macCryptoStatus != LORAMAC_CRYPTO_SUCCESS )
             {
                 if( macCryptoStatus == LORAMAC_CRYPTO_FAIL_FCNT_DUPLICATED )
@@ -1516,6 +1679,7 @@ static void ProcessRadioRxDone( void )
                     if( ( Nvm.MacGroup2.Version.Fields.Minor == 0 ) && ( macHdr.Bits.MType == FRAME_TYPE_DATA_CONFIRMED_DOWN ) && ( Nvm.MacGroup1.LastRxMic == macMsgData.MIC ) )
                     {
                         Nvm.MacGroup1.SrvAckRequested = true;
+                        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
                     }
                 }
                 else if( macCryptoStatus == LORAMAC_CRYPTO_FAIL_MAX_GAP_FCNT )
@@ -1588,6 +1752,9 @@ static void ProcessRadioRxDone( void )
                 return;
             }
 #endif /* LORAMAC_VERSION */
+            // Downlink frame counter, ADR ACK counter and acknowledgement state
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CRYPTO | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 |
+                                LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
 
             MacCtx.McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_OK;
             MacCtx.McpsIndication.Multicast = multicast;
@@ -1754,11 +1921,9 @@ static void ProcessRadioRxDone( void )
 
             break;
         case FRAME_TYPE_PROPRIETARY:
-            memcpy1( MacCtx.RxPayload, &payload[pktHeaderLen], size - pktHeaderLen );
-
             MacCtx.McpsIndication.McpsIndication = MCPS_PROPRIETARY;
             MacCtx.McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_OK;
-            MacCtx.McpsIndication.Buffer = MacCtx.RxPayload;
+            MacCtx.McpsIndication.Buffer = &payload[pktHeaderLen];
             MacCtx.McpsIndication.BufferSize = size - pktHeaderLen;
 
             MacCtx.MacFlags.Bits.McpsInd = 1;
@@ -2047,6 +2212,15 @@ static void LoRaMacHandleRejoinEvents( void )
     if( MacCtx.MacState == LORAMAC_IDLE )
     {
         MlmeReq_t mlmeReq;
+
+        // The rejoin timers queue the requests and count the forced rejoins
+        if( ( Nvm.MacGroup2.IsRejoin0RequestQueued == true ) ||
+            ( Nvm.MacGroup2.IsRejoin1RequestQueued == true ) ||
+            ( Nvm.MacGroup2.IsRejoin2RequestQueued == true ) )
+        {
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+        }
+
         if( IsReJoin0Required( ) == true )
         {
             mlmeReq.Type = MLME_REJOIN_0;
@@ -2227,77 +2401,125 @@ static void LoRaMacHandleNvm( LoRaMacNvmData_t* nvmData )
 {
     uint32_t crc = 0;
     uint16_t notifyFlags = LORAMAC_NVM_NOTIFY_FLAG_NONE;
+    uint16_t checkFlags;
 
     if( MacCtx.MacState != LORAMAC_IDLE )
     {
         return;
     }
 
+    // Skip the CRC of the groups which have not been modified, the timer
+    // events may flag groups from interrupt context
+    CRITICAL_SECTION_BEGIN( );
+    checkFlags = MacCtx.NvmDirtyFlags;
+    MacCtx.NvmDirtyFlags = LORAMAC_NVM_NOTIFY_FLAG_NONE;
+    CRITICAL_SECTION_END( );
+
     // Crypto
-    crc = Crc32( ( uint8_t* ) &nvmData->Crypto, sizeof( nvmData->Crypto ) -
-                                                sizeof( nvmData->Crypto.Crc32 ) );
-    if( crc != nvmData->Crypto.Crc32 )
+    if( ( checkFlags & LORAMAC_NVM_NOTIFY_FLAG_CRYPTO ) != 0 )
     {
-        nvmData->Crypto.Crc32 = crc;
-        notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_CRYPTO;
+        crc = Crc32( ( uint8_t* ) &nvmData->Crypto, sizeof( nvmData->Crypto ) -
+                                                    sizeof( nvmData->Crypto.Crc32 ) );
+        if( crc != nvmData->Crypto.Crc32 )
+        {
+            nvmData->Crypto.Crc32 = crc;
+            notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_CRYPTO;
+        }
     }
 
     // MacGroup1
-    crc = Crc32( ( uint8_t* ) &nvmData->MacGroup1, sizeof( nvmData->MacGroup1 ) -
-                                                   sizeof( nvmData->MacGroup1.Crc32 ) );
-    if( crc != nvmData->MacGroup1.Crc32 )
+    if( ( checkFlags & LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 ) != 0 )
     {
-        nvmData->MacGroup1.Crc32 = crc;
-        notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1;
+        crc = Crc32( ( uint8_t* ) &nvmData->MacGroup1, sizeof( nvmData->MacGroup1 ) -
+                                                       sizeof( nvmData->MacGroup1.Crc32 ) );
+        if( crc != nvmData->MacGroup1.Crc32 )
+        {
+            nvmData->MacGroup1.Crc32 = crc;
+            notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1;
+        }
     }
 
     // MacGroup2
-    crc = Crc32( ( uint8_t* ) &nvmData->MacGroup2, sizeof( nvmData->MacGroup2 ) -
-                                                   sizeof( nvmData->MacGroup2.Crc32 ) );
-    if( crc != nvmData->MacGroup2.Crc32 )
+    if( ( checkFlags & LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 ) != 0 )
     {
-        nvmData->MacGroup2.Crc32 = crc;
-        notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2;
+        crc = Crc32( ( uint8_t* ) &nvmData->MacGroup2, sizeof( nvmData->MacGroup2 ) -
+                                                       sizeof( nvmData->MacGroup2.Crc32 ) );
+        if( crc != nvmData->MacGroup2.Crc32 )
+        {
+            nvmData->MacGroup2.Crc32 = crc;
+            notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2;
+        }
     }
 
     // Secure Element
-    crc = Crc32( ( uint8_t* ) &nvmData->SecureElement, sizeof( nvmData->SecureElement ) -
-                                                       sizeof( nvmData->SecureElement.Crc32 ) );
-    if( crc != nvmData->SecureElement.Crc32 )
+    if( ( checkFlags & LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT ) != 0 )
     {
-        nvmData->SecureElement.Crc32 = crc;
-        notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT;
+        crc = Crc32( ( uint8_t* ) &nvmData->SecureElement, sizeof( nvmData->SecureElement ) -
+                                                           sizeof( nvmData->SecureElement.Crc32 ) );
+        if( crc != nvmData->SecureElement.Crc32 )
+        {
+            nvmData->SecureElement.Crc32 = crc;
+            notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT;
+        }
     }
 
     // Region
-    crc = Crc32( ( uint8_t* ) &nvmData->RegionGroup1, sizeof( nvmData->RegionGroup1 ) -
-                                                sizeof( nvmData->RegionGroup1.Crc32 ) );
-    if( crc != nvmData->RegionGroup1.Crc32 )
+    if( ( checkFlags & LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 ) != 0 )
     {
-        nvmData->RegionGroup1.Crc32 = crc;
-        notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1;
+        crc = Crc32( ( uint8_t* ) &nvmData->RegionGroup1, sizeof( nvmData->RegionGroup1 ) -
+                                                    sizeof( nvmData->RegionGroup1.Crc32 ) );
+        if( crc != nvmData->RegionGroup1.Crc32 )
+        {
+            nvmData->RegionGroup1.Crc32 = crc;
+            notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1;
+        }
     }
 
-    crc = Crc32( ( uint8_t* ) &nvmData->RegionGroup2, sizeof( nvmData->RegionGroup2 ) -
-                                                sizeof( nvmData->RegionGroup2.Crc32 ) );
-    if( crc != nvmData->RegionGroup2.Crc32 )
+    if( ( checkFlags & LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 ) != 0 )
     {
-        nvmData->RegionGroup2.Crc32 = crc;
-        notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2;
+        crc = Crc32( ( uint8_t* ) &nvmData->RegionGroup2, sizeof( nvmData->RegionGroup2 ) -
+                                                    sizeof( nvmData->RegionGroup2.Crc32 ) );
+        if( crc != nvmData->RegionGroup2.Crc32 )
+        {
+            nvmData->RegionGroup2.Crc32 = crc;
+            notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2;
+        }
     }
 
     // ClassB
-    crc = Crc32( ( uint8_t* ) &nvmData->ClassB, sizeof( nvmData->ClassB ) -
-                                                sizeof( nvmData->ClassB.Crc32 ) );
-    if( crc != nvmData->ClassB.Crc32 )
+    if( ( checkFlags & LORAMAC_NVM_NOTIFY_FLAG_CLASS_B ) != 0 )
     {
-        nvmData->ClassB.Crc32 = crc;
-        notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_CLASS_B;
+        crc = Crc32( ( uint8_t* ) &nvmData->ClassB, sizeof( nvmData->ClassB ) -
+                                                    sizeof( nvmData->ClassB.Crc32 ) );
+        if( crc != nvmData->ClassB.Crc32 )
+        {
+            nvmData->ClassB.Crc32 = crc;
+            notifyFlags |= LORAMAC_NVM_NOTIFY_FLAG_CLASS_B;
+        }
     }
 
     CallNvmDataChangeCallback( notifyFlags );
 }
 
+static void LoRaMacNvmSetDirty( uint16_t notifyFlags )
+{
+    CRITICAL_SECTION_BEGIN( );
+    MacCtx.NvmDirtyFlags |= notifyFlags;
+    CRITICAL_SECTION_END( );
+}
+
+static void LoRaMacNvmCheckChannelsMask( const uint16_t* channelsMask )
+{
+    for( uint8_t i = 0; i < REGION_NVM_CHANNELS_MASK_SIZE; i++ )
+    {
+        if( channelsMask[i] != Nvm.RegionGroup2.ChannelsMask[i] )
+        {
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
+            return;
+        }
+    }
+}
+
 #if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
 static bool LoRaMacHandleResponseTimeout( TimerTime_t timeoutInMs, TimerTime_t startTimeInMs )
 {
@@ -2307,6 +2529,7 @@ static bool LoRaMacHandleResponseTimeout( TimerTime_t timeoutInMs, TimerTime_t s
         if( elapsedTime > timeoutInMs )
         {
             Nvm.MacGroup1.SrvAckRequested = false;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
             return true;
         }
     }
@@ -2327,6 +2550,13 @@ void LoRaMacProcess( void )
         LoRaMacEnableRequests( LORAMAC_REQUEST_HANDLING_OFF );
         LoRaMacCheckForRxAbort( );
 
+        // The class B module resets its context when the beacon is lost or not found
+        if( ( MacCtx.MlmeIndication.MlmeIndication == MLME_BEACON_LOST ) ||
+            ( LoRaMacConfirmQueueIsCmdActive( MLME_BEACON_ACQUISITION ) == true ) )
+        {
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
+        }
+
         // An error occurs during transmitting
         if( IsRequestPending( ) > 0 )
         {
@@ -2575,6 +2805,9 @@ static LoRaMacStatus_t SwitchClass( DeviceClass_t deviceClass )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_PARAMETER_INVALID;
 
+    // Device class, RxC channel and class B contexts
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 | LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
+
     switch( Nvm.MacGroup2.DeviceClass )
     {
         case CLASS_A:
@@ -2677,13 +2910,53 @@ static LoRaMacStatus_t SwitchClass( DeviceClass_t deviceClass )
     return status;
 }
 
-static uint8_t GetMaxAppPayloadWithoutFOptsLength( int8_t datarate )
+/*!
+ * \brief Drops the PHY parameters snapshot if the region, the dwell times or
+ *        the repeater support changed since it was built.
+ */
+static void PhyCacheCheck( void )
+{
+    LoRaMacPhyCache_t* cache = &MacCtx.PhyCache;
+
+    if( ( cache->Valid == true ) &&
+        ( cache->Region == Nvm.MacGroup2.Region ) &&
+        ( cache->UplinkDwellTime == Nvm.MacGroup2.MacParams.UplinkDwellTime ) &&
+        ( cache->DownlinkDwellTime == Nvm.MacGroup2.MacParams.DownlinkDwellTime ) &&
+        ( cache->RepeaterSupport == Nvm.MacGroup2.MacParams.RepeaterSupport ) )
+    {
+        return;
+    }
+
+    cache->Valid = true;
+    cache->Region = Nvm.MacGroup2.Region;
+    cache->UplinkDwellTime = Nvm.MacGroup2.MacParams.UplinkDwellTime;
+    cache->DownlinkDwellTime = Nvm.MacGroup2.MacParams.DownlinkDwellTime;
+    cache->RepeaterSupport = Nvm.MacGroup2.MacParams.RepeaterSupport;
+    // Values are fetched from the region again on their next use
+    cache->UplinkMaxPayloadMask = 0;
+    cache->DownlinkMaxPayloadMask = 0;
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
+    cache->MaxFCntGapValid = false;
+#endif /* LORAMAC_VERSION */
+    cache->RebuildCnt++;
+}
+
+/*!
+ * \brief Gets the maximum payload length of a datarate from the region.
+ *
+ * \param [in] datarate        Datarate
+ *
+ * \param [in] dwellTime       Dwell time of the link direction
+ *
+ * \retval                    Max length
+ */
+static uint8_t GetRegionMaxPayloadLength( int8_t datarate, uint8_t dwellTime )
 {
     GetPhyParams_t getPhy;
     PhyParam_t phyParam;
 
     // Setup PHY request
-    getPhy.UplinkDwellTime = Nvm.MacGroup2.MacParams.UplinkDwellTime;
+    getPhy.UplinkDwellTime = dwellTime;
     getPhy.Datarate = datarate;
     getPhy.Attribute = PHY_MAX_PAYLOAD;
 
@@ -2697,6 +2970,72 @@ static uint8_t GetMaxAppPayloadWithoutFOptsLength( int8_t datarate )
     return phyParam.Value;
 }
 
+static uint8_t GetMaxAppPayloadWithoutFOptsLength( int8_t datarate )
+{
+    LoRaMacPhyCache_t* cache = &MacCtx.PhyCache;
+
+    if( ( datarate < 0 ) || ( datarate >= LORAMAC_PHY_CACHE_NB_DR ) )
+    {
+        return GetRegionMaxPayloadLength( datarate, Nvm.MacGroup2.MacParams.UplinkDwellTime );
+    }
+
+    PhyCacheCheck( );
+    if( ( cache->UplinkMaxPayloadMask & ( 1 << datarate ) ) == 0 )
+    {
+        cache->UplinkMaxPayload[datarate] = GetRegionMaxPayloadLength( datarate, Nvm.MacGroup2.MacParams.UplinkDwellTime );
+        cache->UplinkMaxPayloadMask |= 1 << datarate;
+    }
+    return cache->UplinkMaxPayload[datarate];
+}
+
+static uint8_t GetMaxDownlinkPayloadLength( int8_t datarate )
+{
+    LoRaMacPhyCache_t* cache = &MacCtx.PhyCache;
+
+    if( ( datarate < 0 ) || ( datarate >= LORAMAC_PHY_CACHE_NB_DR ) )
+    {
+        return GetRegionMaxPayloadLength( datarate, Nvm.MacGroup2.MacParams.DownlinkDwellTime );
+    }
+
+    PhyCacheCheck( );
+    if( ( cache->DownlinkMaxPayloadMask & ( 1 << datarate ) ) == 0 )
+    {
+        cache->DownlinkMaxPayload[datarate] = GetRegionMaxPayloadLength( datarate, Nvm.MacGroup2.MacParams.DownlinkDwellTime );
+        cache->DownlinkMaxPayloadMask |= 1 << datarate;
+    }
+    return cache->DownlinkMaxPayload[datarate];
+}
+
+static uint32_t GetRetransmitTimeout( void )
+{
+    GetPhyParams_t getPhy;
+
+    // Not cached: the region adds a random delay to the timeout on each call
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
+    getPhy.Attribute = PHY_ACK_TIMEOUT;
+#elif (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    getPhy.Attribute = PHY_RETRANSMIT_TIMEOUT;
+#endif /* LORAMAC_VERSION */
+    return RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy ).Value;
+}
+
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
+static uint32_t GetMaxFCntGap( void )
+{
+    LoRaMacPhyCache_t* cache = &MacCtx.PhyCache;
+    GetPhyParams_t getPhy;
+
+    PhyCacheCheck( );
+    if( cache->MaxFCntGapValid == false )
+    {
+        getPhy.Attribute = PHY_MAX_FCNT_GAP;
+        cache->MaxFCntGap = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy ).Value;
+        cache->MaxFCntGapValid = true;
+    }
+    return cache->MaxFCntGap;
+}
+#endif /* LORAMAC_VERSION */
+
 static bool ValidatePayloadLength( uint8_t lenN, int8_t datarate, uint8_t fOptsLen )
 {
     uint16_t maxN = 0;
@@ -2715,564 +3054,701 @@ static bool ValidatePayloadLength( uint8_t lenN, int8_t datarate, uint8_t fOptsL
     return false;
 }
 
-static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t commandsSize, int8_t snr, LoRaMacRxSlot_t rxSlot )
-{
-    uint8_t status = 0;
-    bool adrBlockFound = false;
-    uint8_t macCmdPayload[2] = { 0x00, 0x00 };
 #if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+/*!
+ * \brief Processes a ResetConf MAC command
+ */
+static uint8_t ProcessResetConf( MacCommandsParseCtx_t* ctx )
+{
     MacCommand_t* macCmd;
+    uint8_t serverMinorVersion = ctx->Cmd[1];
+
+    // Compare own LoRaWAN Version with server's
+    if( Nvm.MacGroup2.Version.Fields.Minor >= serverMinorVersion )
+    {
+        // If they equal remove the sticky ResetInd MAC-Command.
+        if( LoRaMacCommandsGetCmd( MOTE_MAC_RESET_IND, &macCmd) == LORAMAC_COMMANDS_SUCCESS )
+        {
+            LoRaMacCommandsRemoveCmd( macCmd );
+        }
+    }
+    return ctx->CmdSize;
+}
 #endif /* LORAMAC_VERSION */
 
-#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
-    if( ( rxSlot != RX_SLOT_WIN_1 ) && ( rxSlot != RX_SLOT_WIN_2 ) )
+/*!
+ * \brief Processes a LinkCheckAns MAC command
+ */
+static uint8_t ProcessLinkCheckAns( MacCommandsParseCtx_t* ctx )
+{
+    if( LoRaMacConfirmQueueIsCmdActive( MLME_LINK_CHECK ) == true )
     {
-        // Do only parse MAC commands for Class A RX windows
-        return;
+        LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_LINK_CHECK );
+        MacCtx.MlmeConfirm.DemodMargin = ctx->Cmd[1];
+        MacCtx.MlmeConfirm.NbGateways = ctx->Cmd[2];
+    }
+    return ctx->CmdSize;
+}
+
+/*!
+ * \brief Processes a LinkAdrReq MAC command, or a block of them
+ */
+static uint8_t ProcessLinkAdrReq( MacCommandsParseCtx_t* ctx )
+{
+    LinkAdrReqParams_t linkAdrReq;
+    int8_t linkAdrDatarate = DR_0;
+    int8_t linkAdrTxPower = TX_POWER_0;
+    uint8_t linkAdrNbRep = 0;
+    uint8_t linkAdrNbBytesParsed = 0;
+    uint8_t* payload = ctx->Payload;
+    uint8_t commandsSize = ctx->Size;
+    uint8_t macIndex = ctx->Index + 1;
+    uint8_t status = 0;
+
+    // The end node is allowed to process one block of LinkAdrRequests.
+    // It must ignore subsequent blocks
+    if( ctx->AdrBlockFound == true )
+    {
+        return ctx->CmdSize;
     }
+    ctx->AdrBlockFound = true;
+
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
+    // Fill parameter structure
+    linkAdrReq.Payload = &payload[macIndex - 1];
+    linkAdrReq.PayloadSize = commandsSize - ( macIndex - 1 );
+    linkAdrReq.AdrEnabled = Nvm.MacGroup2.AdrCtrlOn;
+    linkAdrReq.UplinkDwellTime = Nvm.MacGroup2.MacParams.UplinkDwellTime;
+    linkAdrReq.CurrentDatarate = Nvm.MacGroup1.ChannelsDatarate;
+    linkAdrReq.CurrentTxPower = Nvm.MacGroup1.ChannelsTxPower;
+    linkAdrReq.CurrentNbRep = Nvm.MacGroup2.MacParams.ChannelsNbTrans;
+    linkAdrReq.Version = Nvm.MacGroup2.Version;
+
+    // Process the ADR requests
+    status = RegionLinkAdrReq( Nvm.MacGroup2.Region, &linkAdrReq, &linkAdrDatarate,
+                               &linkAdrTxPower, &linkAdrNbRep, &linkAdrNbBytesParsed );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 |
+                        LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
+
+    if( ( status & 0x07 ) == 0x07 )
+    {
+        Nvm.MacGroup1.ChannelsDatarate = linkAdrDatarate;
+        Nvm.MacGroup1.ChannelsTxPower = linkAdrTxPower;
+        Nvm.MacGroup2.MacParams.ChannelsNbTrans = linkAdrNbRep;
+    }
+
+    // Add the answers to the buffer
+    for( uint8_t i = 0; i < ( linkAdrNbBytesParsed / 5 ); i++ )
+    {
+        LoRaMacCommandsAddCmd( MOTE_MAC_LINK_ADR_ANS, &status, 1 );
+    }
+    // Update MAC index
+    macIndex += linkAdrNbBytesParsed - 1;
+#elif (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    do
+    {
+        // Fill parameter structure
+        linkAdrReq.Payload = &payload[macIndex - 1];
+        linkAdrReq.AdrEnabled = Nvm.MacGroup2.AdrCtrlOn;
+        linkAdrReq.UplinkDwellTime = Nvm.MacGroup2.MacParams.UplinkDwellTime;
+        linkAdrReq.CurrentDatarate = Nvm.MacGroup1.ChannelsDatarate;
+        linkAdrReq.CurrentTxPower = Nvm.MacGroup1.ChannelsTxPower;
+        linkAdrReq.CurrentNbRep = Nvm.MacGroup2.MacParams.ChannelsNbTrans;
+        linkAdrReq.Version = Nvm.MacGroup2.Version;
+
+        // There is a fundamental difference in reporting the status
+        // of the LinkAdrRequests when ADR is on or off. When ADR is on, every
+        // LinkAdrAns contains the same value. This does not hold when ADR is off,
+        // where every LinkAdrAns requires an individual status.
+        if( Nvm.MacGroup2.AdrCtrlOn == true )
+        {
+            // When ADR is on, the function RegionLinkAdrReq will take care
+            // about the parsing and interpretation of the LinkAdrRequest block and
+            // it provides one status which shall be applied to every LinkAdrAns
+            linkAdrReq.PayloadSize = commandsSize - ( macIndex - 1 );
+        }
+        else
+        {
+            // When ADR is off, this function will loop over the individual LinkAdrRequests
+            // and will call RegionLinkAdrReq for each individually, as every request
+            // requires an individual answer.
+            // When ADR is off, the function RegionLinkAdrReq ignores the new values for
+            // ChannelsDatarate, ChannelsTxPower and ChannelsNbTrans.
+            linkAdrReq.PayloadSize = 5;
+        }
+
+        // Process the ADR requests
+        status = RegionLinkAdrReq( Nvm.MacGroup2.Region, &linkAdrReq, &linkAdrDatarate,
+                                &linkAdrTxPower, &linkAdrNbRep, &linkAdrNbBytesParsed );
+        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 |
+                            LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
+
+        if( ( status & 0x07 ) == 0x07 )
+        {
+            // Set the status that the datarate has been increased
+            if( linkAdrDatarate > Nvm.MacGroup1.ChannelsDatarate )
+            {
+                Nvm.MacGroup2.ChannelsDatarateChangedLinkAdrReq = true;
+            }
+            Nvm.MacGroup1.ChannelsDatarate = linkAdrDatarate;
+            Nvm.MacGroup1.ChannelsTxPower = linkAdrTxPower;
+            Nvm.MacGroup2.MacParams.ChannelsNbTrans = linkAdrNbRep;
+        }
+
+        // Add the answers to the buffer
+        for( uint8_t i = 0; i < ( linkAdrNbBytesParsed / 5 ); i++ )
+        {
+            LoRaMacCommandsAddCmd( MOTE_MAC_LINK_ADR_ANS, &status, 1 );
+        }
+        // Update MAC index
+        macIndex += linkAdrNbBytesParsed - 1;
+
+        // Check to prevent invalid access. The index is left on the next MAC command,
+        // even when it is the last byte of the payload.
+        if( ( macIndex >= commandsSize ) || ( payload[macIndex] != SRV_MAC_LINK_ADR_REQ ) )
+        {
+            break;
+        }
+        macIndex++;
+    } while( true );
 #endif /* LORAMAC_VERSION */
 
-    while( macIndex < commandsSize )
+    // A block always covers at least the first request
+    return MAX( ( uint8_t )( macIndex - ctx->Index ), ctx->CmdSize );
+}
+
+/*!
+ * \brief Processes a DutyCycleReq MAC command
+ */
+static uint8_t ProcessDutyCycleReq( MacCommandsParseCtx_t* ctx )
+{
+    uint8_t macCmdPayload[1] = { 0x00 };
+
+    Nvm.MacGroup2.MaxDCycle = ctx->Cmd[1] & 0x0F;
+    Nvm.MacGroup2.AggregatedDCycle = 1 << Nvm.MacGroup2.MaxDCycle;
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+    LoRaMacCommandsAddCmd( MOTE_MAC_DUTY_CYCLE_ANS, macCmdPayload, 0 );
+    return ctx->CmdSize;
+}
+
+/*!
+ * \brief Processes a RxParamSetupReq MAC command
+ */
+static uint8_t ProcessRxParamSetupReq( MacCommandsParseCtx_t* ctx )
+{
+    RxParamSetupReqParams_t rxParamSetupReq;
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint8_t status = 0x07;
+
+    rxParamSetupReq.DrOffset = ( ctx->Cmd[1] >> 4 ) & 0x07;
+    rxParamSetupReq.Datarate = ctx->Cmd[1] & 0x0F;
+
+#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    if( rxParamSetupReq.Datarate == 0x0F )
+    {
+        // Keep the current datarate
+        rxParamSetupReq.Datarate = Nvm.MacGroup2.MacParams.Rx2Channel.Datarate;
+    }
+#endif
+
+    rxParamSetupReq.Frequency = ( uint32_t ) ctx->Cmd[2];
+    rxParamSetupReq.Frequency |= ( uint32_t ) ctx->Cmd[3] << 8;
+    rxParamSetupReq.Frequency |= ( uint32_t ) ctx->Cmd[4] << 16;
+    rxParamSetupReq.Frequency *= 100;
+
+    // Perform request on region
+    status = RegionRxParamSetupReq( Nvm.MacGroup2.Region, &rxParamSetupReq );
+
+    if( ( status & 0x07 ) == 0x07 )
+    {
+        Nvm.MacGroup2.MacParams.Rx2Channel.Datarate = rxParamSetupReq.Datarate;
+        Nvm.MacGroup2.MacParams.RxCChannel.Datarate = rxParamSetupReq.Datarate;
+        Nvm.MacGroup2.MacParams.Rx2Channel.Frequency = rxParamSetupReq.Frequency;
+        Nvm.MacGroup2.MacParams.RxCChannel.Frequency = rxParamSetupReq.Frequency;
+        Nvm.MacGroup2.MacParams.Rx1DrOffset = rxParamSetupReq.DrOffset;
+        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+    }
+    macCmdPayload[0] = status;
+    LoRaMacCommandsAddCmd( MOTE_MAC_RX_PARAM_SETUP_ANS, macCmdPayload, 1 );
+    return ctx->CmdSize;
+}
+
+/*!
+ * \brief Processes a DevStatusReq MAC command
+ */
+static uint8_t ProcessDevStatusReq( MacCommandsParseCtx_t* ctx )
+{
+    uint8_t macCmdPayload[2] = { 0x00, 0x00 };
+    uint8_t batteryLevel = BAT_LEVEL_NO_MEASURE;
+
+    if( ( MacCtx.MacCallbacks != NULL ) && ( MacCtx.MacCallbacks->GetBatteryLevel != NULL ) )
+    {
+        batteryLevel = MacCtx.MacCallbacks->GetBatteryLevel( );
+    }
+    macCmdPayload[0] = batteryLevel;
+    macCmdPayload[1] = ( uint8_t )( ctx->Snr & 0x3F );
+    LoRaMacCommandsAddCmd( MOTE_MAC_DEV_STATUS_ANS, macCmdPayload, 2 );
+    return ctx->CmdSize;
+}
+
+/*!
+ * \brief Processes a NewChannelReq MAC command
+ */
+static uint8_t ProcessNewChannelReq( MacCommandsParseCtx_t* ctx )
+{
+    NewChannelReqParams_t newChannelReq;
+    ChannelParams_t chParam;
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint8_t status = 0x03;
+
+    newChannelReq.ChannelId = ctx->Cmd[1];
+    newChannelReq.NewChannel = &chParam;
+
+    chParam.Frequency = ( uint32_t ) ctx->Cmd[2];
+    chParam.Frequency |= ( uint32_t ) ctx->Cmd[3] << 8;
+    chParam.Frequency |= ( uint32_t ) ctx->Cmd[4] << 16;
+    chParam.Frequency *= 100;
+    chParam.Rx1Frequency = 0;
+    chParam.DrRange.Value = ctx->Cmd[5];
+
+    status = ( uint8_t )RegionNewChannelReq( Nvm.MacGroup2.Region, &newChannelReq );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
+
+    if( ( int8_t )status >= 0 )
+    {
+        macCmdPayload[0] = status;
+        LoRaMacCommandsAddCmd( MOTE_MAC_NEW_CHANNEL_ANS, macCmdPayload, 1 );
+    }
+    return ctx->CmdSize;
+}
+
+/*!
+ * \brief Processes a RxTimingSetupReq MAC command
+ */
+static uint8_t ProcessRxTimingSetupReq( MacCommandsParseCtx_t* ctx )
+{
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint8_t delay = ctx->Cmd[1] & 0x0F;
+
+    if( delay == 0 )
+    {
+        delay++;
+    }
+    Nvm.MacGroup2.MacParams.ReceiveDelay1 = delay * 1000;
+    Nvm.MacGroup2.MacParams.ReceiveDelay2 = Nvm.MacGroup2.MacParams.ReceiveDelay1 + 1000;
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+    LoRaMacCommandsAddCmd( MOTE_MAC_RX_TIMING_SETUP_ANS, macCmdPayload, 0 );
+    return ctx->CmdSize;
+}
+
+/*!
+ * \brief Processes a TxParamSetupReq MAC command
+ */
+static uint8_t ProcessTxParamSetupReq( MacCommandsParseCtx_t* ctx )
+{
+    TxParamSetupReqParams_t txParamSetupReq;
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint8_t eirpDwellTime = ctx->Cmd[1];
+
+    txParamSetupReq.UplinkDwellTime = 0;
+    txParamSetupReq.DownlinkDwellTime = 0;
+
+    if( ( eirpDwellTime & 0x20 ) == 0x20 )
+    {
+        txParamSetupReq.DownlinkDwellTime = 1;
+    }
+    if( ( eirpDwellTime & 0x10 ) == 0x10 )
+    {
+        txParamSetupReq.UplinkDwellTime = 1;
+    }
+    txParamSetupReq.MaxEirp = eirpDwellTime & 0x0F;
+
+    // Check the status for correctness
+    if( RegionTxParamSetupReq( Nvm.MacGroup2.Region, &txParamSetupReq ) != -1 )
+    {
+        // Accept command
+        Nvm.MacGroup2.MacParams.UplinkDwellTime = txParamSetupReq.UplinkDwellTime;
+        Nvm.MacGroup2.MacParams.DownlinkDwellTime = txParamSetupReq.DownlinkDwellTime;
+        Nvm.MacGroup2.MacParams.MaxEirp = LoRaMacMaxEirpTable[txParamSetupReq.MaxEirp];
+        // Update the datarate in case of the new configuration limits it
+        getPhy.Attribute = PHY_MIN_TX_DR;
+        getPhy.UplinkDwellTime = Nvm.MacGroup2.MacParams.UplinkDwellTime;
+        phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
+        Nvm.MacGroup1.ChannelsDatarate = MAX( Nvm.MacGroup1.ChannelsDatarate, ( int8_t )phyParam.Value );
+        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+
+        // Add command response
+        LoRaMacCommandsAddCmd( MOTE_MAC_TX_PARAM_SETUP_ANS, macCmdPayload, 0 );
+    }
+    return ctx->CmdSize;
+}
+
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+/*!
+ * \brief Processes a RekeyConf MAC command
+ */
+static uint8_t ProcessRekeyConf( MacCommandsParseCtx_t* ctx )
+{
+    MacCommand_t* macCmd;
+    uint8_t serverMinorVersion = ctx->Cmd[1];
+
+    // Compare own LoRaWAN Version with server's
+    if( Nvm.MacGroup2.Version.Fields.Minor >= serverMinorVersion )
     {
-        // Make sure to parse only complete MAC commands
-        if( ( LoRaMacCommandsGetCmdSize( payload[macIndex] ) + macIndex ) > commandsSize )
+        // If they equal remove the sticky RekeyInd MAC-Command.
+        if( LoRaMacCommandsGetCmd( MOTE_MAC_REKEY_IND, &macCmd) == LORAMAC_COMMANDS_SUCCESS )
         {
-            return;
+            LoRaMacCommandsRemoveCmd( macCmd );
         }
+    }
+    return ctx->CmdSize;
+}
+#endif /* LORAMAC_VERSION */
 
-        // Decode Frame MAC commands
-        switch( payload[macIndex++] )
-        {
-#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
-            case SRV_MAC_RESET_CONF:
-            {
-                uint8_t serverMinorVersion = payload[macIndex++];
+/*!
+ * \brief Processes a DlChannelReq MAC command
+ */
+static uint8_t ProcessDlChannelReq( MacCommandsParseCtx_t* ctx )
+{
+    DlChannelReqParams_t dlChannelReq;
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint8_t status = 0x03;
 
-                // Compare own LoRaWAN Version with server's
-                if( Nvm.MacGroup2.Version.Fields.Minor >= serverMinorVersion )
-                {
-                    // If they equal remove the sticky ResetInd MAC-Command.
-                    if( LoRaMacCommandsGetCmd( MOTE_MAC_RESET_IND, &macCmd) == LORAMAC_COMMANDS_SUCCESS )
-                    {
-                        LoRaMacCommandsRemoveCmd( macCmd );
-                    }
-                }
-                break;
-            }
-#endif /* LORAMAC_VERSION */
-            case SRV_MAC_LINK_CHECK_ANS:
-            {
-                if( LoRaMacConfirmQueueIsCmdActive( MLME_LINK_CHECK ) == true )
-                {
-                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_LINK_CHECK );
-                    MacCtx.MlmeConfirm.DemodMargin = payload[macIndex++];
-                    MacCtx.MlmeConfirm.NbGateways = payload[macIndex++];
-                }
-                break;
-            }
-            case SRV_MAC_LINK_ADR_REQ:
-            {
-                LinkAdrReqParams_t linkAdrReq;
-                int8_t linkAdrDatarate = DR_0;
-                int8_t linkAdrTxPower = TX_POWER_0;
-                uint8_t linkAdrNbRep = 0;
-                uint8_t linkAdrNbBytesParsed = 0;
+    dlChannelReq.ChannelId = ctx->Cmd[1];
+    dlChannelReq.Rx1Frequency = ( uint32_t ) ctx->Cmd[2];
+    dlChannelReq.Rx1Frequency |= ( uint32_t ) ctx->Cmd[3] << 8;
+    dlChannelReq.Rx1Frequency |= ( uint32_t ) ctx->Cmd[4] << 16;
+    dlChannelReq.Rx1Frequency *= 100;
 
-                // The end node is allowed to process one block of LinkAdrRequests.
-                // It must ignore subsequent blocks
-#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
-                if( adrBlockFound == false )
-                {
-                    adrBlockFound = true;
-
-                    // Fill parameter structure
-                    linkAdrReq.Payload = &payload[macIndex - 1];
-                    linkAdrReq.PayloadSize = commandsSize - ( macIndex - 1 );
-                    linkAdrReq.AdrEnabled = Nvm.MacGroup2.AdrCtrlOn;
-                    linkAdrReq.UplinkDwellTime = Nvm.MacGroup2.MacParams.UplinkDwellTime;
-                    linkAdrReq.CurrentDatarate = Nvm.MacGroup1.ChannelsDatarate;
-                    linkAdrReq.CurrentTxPower = Nvm.MacGroup1.ChannelsTxPower;
-                    linkAdrReq.CurrentNbRep = Nvm.MacGroup2.MacParams.ChannelsNbTrans;
-                    linkAdrReq.Version = Nvm.MacGroup2.Version;
-
-                    // Process the ADR requests
-                    status = RegionLinkAdrReq( Nvm.MacGroup2.Region, &linkAdrReq, &linkAdrDatarate,
-                                               &linkAdrTxPower, &linkAdrNbRep, &linkAdrNbBytesParsed );
-
-                    if( ( status & 0x07 ) == 0x07 )
-                    {
-                        Nvm.MacGroup1.ChannelsDatarate = linkAdrDatarate;
-                        Nvm.MacGroup1.ChannelsTxPower = linkAdrTxPower;
-                        Nvm.MacGroup2.MacParams.ChannelsNbTrans = linkAdrNbRep;
-                    }
+    status = ( uint8_t )RegionDlChannelReq( Nvm.MacGroup2.Region, &dlChannelReq );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
 
-                    // Add the answers to the buffer
-                    for( uint8_t i = 0; i < ( linkAdrNbBytesParsed / 5 ); i++ )
-                    {
-                        LoRaMacCommandsAddCmd( MOTE_MAC_LINK_ADR_ANS, &status, 1 );
-                    }
-                    // Update MAC index
-                    macIndex += linkAdrNbBytesParsed - 1;
-                }
-#elif (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
-                if( adrBlockFound == false )
-                {
-                    adrBlockFound = true;
+    if( ( int8_t )status >= 0 )
+    {
+        macCmdPayload[0] = status;
+        LoRaMacCommandsAddCmd( MOTE_MAC_DL_CHANNEL_ANS, macCmdPayload, 1 );
+    }
+    return ctx->CmdSize;
+}
 
-                    do
-                    {
-                        // Fill parameter structure
-                        linkAdrReq.Payload = &payload[macIndex - 1];
-                        linkAdrReq.AdrEnabled = Nvm.MacGroup2.AdrCtrlOn;
-                        linkAdrReq.UplinkDwellTime = Nvm.MacGroup2.MacParams.UplinkDwellTime;
-                        linkAdrReq.CurrentDatarate = Nvm.MacGroup1.ChannelsDatarate;
-                        linkAdrReq.CurrentTxPower = Nvm.MacGroup1.ChannelsTxPower;
-                        linkAdrReq.CurrentNbRep = Nvm.MacGroup2.MacParams.ChannelsNbTrans;
-                        linkAdrReq.Version = Nvm.MacGroup2.Version;
-
-                        // There is a fundamental difference in reporting the status
-                        // of the LinkAdrRequests when ADR is on or off. When ADR is on, every
-                        // LinkAdrAns contains the same value. This does not hold when ADR is off,
-                        // where every LinkAdrAns requires an individual status.
-                        if( Nvm.MacGroup2.AdrCtrlOn == true )
-                        {
-                            // When ADR is on, the function RegionLinkAdrReq will take care
-                            // about the parsing and interpretation of the LinkAdrRequest block and
-                            // it provides one status which shall be applied to every LinkAdrAns
-                            linkAdrReq.PayloadSize = commandsSize - ( macIndex - 1 );
-                        }
-                        else
-                        {
-                            // When ADR is off, this function will loop over the individual LinkAdrRequests
-                            // and will call RegionLinkAdrReq for each individually, as every request
-                            // requires an individual answer.
-                            // When ADR is off, the function RegionLinkAdrReq ignores the new values for
-                            // ChannelsDatarate, ChannelsTxPower and ChannelsNbTrans.
-                            linkAdrReq.PayloadSize = 5;
-                        }
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+/*!
+ * \brief Processes an AdrParamSetupReq MAC command
+ */
+static uint8_t ProcessAdrParamSetupReq( MacCommandsParseCtx_t* ctx )
+{
+    /* ADRParamSetupReq Payload:  ADRparam
+     * +----------------+---------------+
+     * | 7:4 Limit_exp  | 3:0 Delay_exp |
+     * +----------------+---------------+
+     */
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint8_t delayExp = 0x0F & ctx->Cmd[1];
+    uint8_t limitExp = 0x0F & ( ctx->Cmd[1] >> 4 );
 
-                        // Process the ADR requests
-                        status = RegionLinkAdrReq( Nvm.MacGroup2.Region, &linkAdrReq, &linkAdrDatarate,
-                                                &linkAdrTxPower, &linkAdrNbRep, &linkAdrNbBytesParsed );
+    // ADR_ACK_ DELAY = 2^Delay_exp
+    Nvm.MacGroup2.MacParams.AdrAckDelay = 0x01 << delayExp;
 
-                        if( ( status & 0x07 ) == 0x07 )
-                        {
-                            // Set the status that the datarate has been increased
-                            if( linkAdrDatarate > Nvm.MacGroup1.ChannelsDatarate )
-                            {
-                                Nvm.MacGroup2.ChannelsDatarateChangedLinkAdrReq = true;
-                            }
-                            Nvm.MacGroup1.ChannelsDatarate = linkAdrDatarate;
-                            Nvm.MacGroup1.ChannelsTxPower = linkAdrTxPower;
-                            Nvm.MacGroup2.MacParams.ChannelsNbTrans = linkAdrNbRep;
-                        }
+    // ADR_ACK_LIMIT = 2^Limit_exp
+    Nvm.MacGroup2.MacParams.AdrAckLimit = 0x01 << limitExp;
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
 
-                        // Add the answers to the buffer
-                        for( uint8_t i = 0; i < ( linkAdrNbBytesParsed / 5 ); i++ )
-                        {
-                            LoRaMacCommandsAddCmd( MOTE_MAC_LINK_ADR_ANS, &status, 1 );
-                        }
-                        // Update MAC index
-                        macIndex += linkAdrNbBytesParsed - 1;
+    LoRaMacCommandsAddCmd( MOTE_MAC_ADR_PARAM_SETUP_ANS, macCmdPayload, 0 );
+    return ctx->CmdSize;
+}
 
-                        // Check to prevent invalid access
-                        if( macIndex >= commandsSize )
-                            break;
+/*!
+ * \brief Processes a ForceRejoinReq MAC command
+ */
+static uint8_t ProcessForceRejoinReq( MacCommandsParseCtx_t* ctx )
+{
+    /* ForceRejoinReq Payload:
+     * +--------------+------------------+-------+----------------+--------+
+     * | 13:11 Period | 10:8 Max_Retries | 7 RFU | 6:4 RejoinType | 3:0 DR |
+     * +--------------+------------------+-------+----------------+--------+
+     */
 
-                    } while( payload[macIndex++] == SRV_MAC_LINK_ADR_REQ );
+    // Parse payload
+    uint8_t period = ( 0x38 & ctx->Cmd[1] ) >> 3;
+    Nvm.MacGroup2.ForceRejoinMaxRetries = 0x07 & ctx->Cmd[1];
+    Nvm.MacGroup2.ForceRejoinType = ( 0x70 & ctx->Cmd[2] ) >> 4;
+    Nvm.MacGroup1.ChannelsDatarate = 0x0F & ctx->Cmd[2];
+
+    // Calc delay between retransmissions: 32 seconds x 2^Period + Rand32
+    uint32_t rejoinCycleInSec = 32 * ( 0x01 << period ) + randr( 0, 32 );
+
+    MacCtx.ForceRejoinCycleTime = 0;
+    Nvm.MacGroup1.ForceRejoinRetriesCounter = 0;
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+    ConvertRejoinCycleTime( rejoinCycleInSec, &MacCtx.ForceRejoinCycleTime );
+    OnForceRejoinReqCycleTimerEvent( NULL );
+    return ctx->CmdSize;
+}
 
-                    if( macIndex < commandsSize )
-                    {
-                        // Decrease the index such that it points to the next MAC command
-                        macIndex--;
-                    }
-                }
-                else
-                {
-                    // Increase the index by the MAC command size (without command)
-                    macIndex += 4;
-                }
-#endif /* LORAMAC_VERSION */
-                break;
-            }
-            case SRV_MAC_DUTY_CYCLE_REQ:
-            {
-                Nvm.MacGroup2.MaxDCycle = payload[macIndex++] & 0x0F;
-                Nvm.MacGroup2.AggregatedDCycle = 1 << Nvm.MacGroup2.MaxDCycle;
-                LoRaMacCommandsAddCmd( MOTE_MAC_DUTY_CYCLE_ANS, macCmdPayload, 0 );
-                break;
-            }
-            case SRV_MAC_RX_PARAM_SETUP_REQ:
-            {
-                RxParamSetupReqParams_t rxParamSetupReq;
-                status = 0x07;
+/*!
+ * \brief Processes a RejoinParamSetupReq MAC command
+ */
+static uint8_t ProcessRejoinParamReq( MacCommandsParseCtx_t* ctx )
+{
+    /* RejoinParamSetupReq Payload:
+     * +----------------+---------------+
+     * | 7:4 MaxTimeN   | 3:0 MaxCountN |
+     * +----------------+---------------+
+     */
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint8_t maxCountN = 0x0F & ctx->Cmd[1];
+    uint8_t maxTimeN = 0x0F & ( ctx->Cmd[1] >> 4 );
+    uint32_t cycleInSec = 0x01 << ( maxTimeN + 10 );
+    uint32_t timeInMs = 0;
+    uint16_t uplinkLimit = 0x01 << ( maxCountN + 4 );
+
+    if( ConvertRejoinCycleTime( cycleInSec, &timeInMs ) == true )
+    {
+        // Calc delay between retransmissions: 2^(maxTimeN+10)
+        Nvm.MacGroup2.Rejoin0CycleInSec = cycleInSec;
+        // Calc number if uplinks without rejoin request: 2^(maxCountN+4)
+        Nvm.MacGroup2.Rejoin0UplinksLimit = uplinkLimit;
+        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+        MacCtx.Rejoin0CycleTime = timeInMs;
+
+        macCmdPayload[0] = 0x01;
+        TimerStop( &MacCtx.Rejoin0CycleTimer );
+        TimerSetValue( &MacCtx.Rejoin0CycleTimer, MacCtx.Rejoin0CycleTime );
+        TimerStart( &MacCtx.Rejoin0CycleTimer );
+    }
+    LoRaMacCommandsAddCmd( MOTE_MAC_REJOIN_PARAM_ANS, macCmdPayload, 1 );
+    return ctx->CmdSize;
+}
 
-                rxParamSetupReq.DrOffset = ( payload[macIndex] >> 4 ) & 0x07;
-                rxParamSetupReq.Datarate = payload[macIndex] & 0x0F;
-                macIndex++;
+/*!
+ * \brief Processes a DeviceModeConf MAC command
+ */
+static uint8_t ProcessDeviceModeConf( MacCommandsParseCtx_t* ctx )
+{
+    MacCommand_t* macCmd;
 
-#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
-                if( rxParamSetupReq.Datarate == 0x0F )
-                {
-                    // Keep the current datarate
-                    rxParamSetupReq.Datarate = Nvm.MacGroup2.MacParams.Rx2Channel.Datarate;
-                }
-#endif
+    // 1 byte payload which we do not handle.
+    if( LoRaMacCommandsGetCmd( MOTE_MAC_DEVICE_MODE_IND, &macCmd) == LORAMAC_COMMANDS_SUCCESS )
+    {
+        LoRaMacCommandsRemoveCmd( macCmd );
+    }
+    return ctx->CmdSize;
+}
+#endif /* LORAMAC_VERSION */
 
-                rxParamSetupReq.Frequency = ( uint32_t ) payload[macIndex++];
-                rxParamSetupReq.Frequency |= ( uint32_t ) payload[macIndex++] << 8;
-                rxParamSetupReq.Frequency |= ( uint32_t ) payload[macIndex++] << 16;
-                rxParamSetupReq.Frequency *= 100;
+/*!
+ * \brief Processes a DeviceTimeAns MAC command
+ */
+static uint8_t ProcessDeviceTimeAns( MacCommandsParseCtx_t* ctx )
+{
+    // The mote time can be updated only when the time is received in classA
+    // receive windows only.
+    if( LoRaMacConfirmQueueIsCmdActive( MLME_DEVICE_TIME ) == true )
+    {
+        LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_DEVICE_TIME );
 
-                // Perform request on region
-                status = RegionRxParamSetupReq( Nvm.MacGroup2.Region, &rxParamSetupReq );
+        SysTime_t gpsEpochTime = { 0 };
+        SysTime_t sysTime = { 0 };
+        SysTime_t sysTimeCurrent = { 0 };
 
-                if( ( status & 0x07 ) == 0x07 )
-                {
-                    Nvm.MacGroup2.MacParams.Rx2Channel.Datarate = rxParamSetupReq.Datarate;
-                    Nvm.MacGroup2.MacParams.RxCChannel.Datarate = rxParamSetupReq.Datarate;
-                    Nvm.MacGroup2.MacParams.Rx2Channel.Frequency = rxParamSetupReq.Frequency;
-                    Nvm.MacGroup2.MacParams.RxCChannel.Frequency = rxParamSetupReq.Frequency;
-                    Nvm.MacGroup2.MacParams.Rx1DrOffset = rxParamSetupReq.DrOffset;
-                }
-                macCmdPayload[0] = status;
-                LoRaMacCommandsAddCmd( MOTE_MAC_RX_PARAM_SETUP_ANS, macCmdPayload, 1 );
-                break;
-            }
-            case SRV_MAC_DEV_STATUS_REQ:
-            {
-                uint8_t batteryLevel = BAT_LEVEL_NO_MEASURE;
-                if( ( MacCtx.MacCallbacks != NULL ) && ( MacCtx.MacCallbacks->GetBatteryLevel != NULL ) )
-                {
-                    batteryLevel = MacCtx.MacCallbacks->GetBatteryLevel( );
-                }
-                macCmdPayload[0] = batteryLevel;
-                macCmdPayload[1] = ( uint8_t )( snr & 0x3F );
-                LoRaMacCommandsAddCmd( MOTE_MAC_DEV_STATUS_ANS, macCmdPayload, 2 );
-                break;
-            }
-            case SRV_MAC_NEW_CHANNEL_REQ:
-            {
-                NewChannelReqParams_t newChannelReq;
-                ChannelParams_t chParam;
-                status = 0x03;
+        gpsEpochTime.Seconds = ( uint32_t )ctx->Cmd[1];
+        gpsEpochTime.Seconds |= ( uint32_t )ctx->Cmd[2] << 8;
+        gpsEpochTime.Seconds |= ( uint32_t )ctx->Cmd[3] << 16;
+        gpsEpochTime.Seconds |= ( uint32_t )ctx->Cmd[4] << 24;
+        gpsEpochTime.SubSeconds = ctx->Cmd[5];
 
-                newChannelReq.ChannelId = payload[macIndex++];
-                newChannelReq.NewChannel = &chParam;
+        // Convert the fractional second received in ms
+        // round( pow( 0.5, 8.0 ) * 1000 ) = 3.90625
+        gpsEpochTime.SubSeconds = ( int16_t )( ( ( int32_t )gpsEpochTime.SubSeconds * 1000 ) >> 8 );
 
-                chParam.Frequency = ( uint32_t ) payload[macIndex++];
-                chParam.Frequency |= ( uint32_t ) payload[macIndex++] << 8;
-                chParam.Frequency |= ( uint32_t ) payload[macIndex++] << 16;
-                chParam.Frequency *= 100;
-                chParam.Rx1Frequency = 0;
-                chParam.DrRange.Value = payload[macIndex++];
+        // Copy received GPS Epoch time into system time
+        sysTime = gpsEpochTime;
+        // Add Unix to Gps epoch offset. The system time is based on Unix time.
+        sysTime.Seconds += UNIX_GPS_EPOCH_OFFSET;
 
-                status = ( uint8_t )RegionNewChannelReq( Nvm.MacGroup2.Region, &newChannelReq );
+        // Compensate time difference between Tx Done time and now
+        sysTimeCurrent = SysTimeGet( );
+        sysTime = SysTimeAdd( sysTimeCurrent, SysTimeSub( sysTime, MacCtx.LastTxSysTime ) );
 
-                if( ( int8_t )status >= 0 )
-                {
-                    macCmdPayload[0] = status;
-                    LoRaMacCommandsAddCmd( MOTE_MAC_NEW_CHANNEL_ANS, macCmdPayload, 1 );
-                }
-                break;
-            }
-            case SRV_MAC_RX_TIMING_SETUP_REQ:
-            {
-                uint8_t delay = payload[macIndex++] & 0x0F;
+        // Apply the new system time.
+        SysTimeSet( sysTime );
+        LoRaMacClassBDeviceTimeAns( );
+        MacCtx.McpsIndication.DeviceTimeAnsReceived = true;
+    }
+    else
+    {
+#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+        // In case of other receive windows the Device Time Answer is not received.
+        MacCtx.McpsIndication.DeviceTimeAnsReceived = false;
+#endif /* LORAMAC_VERSION */
+    }
+    return ctx->CmdSize;
+}
 
-                if( delay == 0 )
-                {
-                    delay++;
-                }
-                Nvm.MacGroup2.MacParams.ReceiveDelay1 = delay * 1000;
-                Nvm.MacGroup2.MacParams.ReceiveDelay2 = Nvm.MacGroup2.MacParams.ReceiveDelay1 + 1000;
-                LoRaMacCommandsAddCmd( MOTE_MAC_RX_TIMING_SETUP_ANS, macCmdPayload, 0 );
-                break;
-            }
-            case SRV_MAC_TX_PARAM_SETUP_REQ:
-            {
-                TxParamSetupReqParams_t txParamSetupReq;
-                GetPhyParams_t getPhy;
-                PhyParam_t phyParam;
-                uint8_t eirpDwellTime = payload[macIndex++];
+/*!
+ * \brief Processes a PingSlotInfoAns MAC command
+ */
+static uint8_t ProcessPingSlotInfoAns( MacCommandsParseCtx_t* ctx )
+{
+    if( LoRaMacConfirmQueueIsCmdActive( MLME_PING_SLOT_INFO ) == true )
+    {
+        LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_PING_SLOT_INFO );
+        // According to the specification, it is not allowed to process this answer in
+        // a ping or multicast slot
+        if( ( MacCtx.RxSlot != RX_SLOT_WIN_CLASS_B_PING_SLOT ) && ( MacCtx.RxSlot != RX_SLOT_WIN_CLASS_B_MULTICAST_SLOT ) )
+        {
+            LoRaMacClassBPingSlotInfoAns( );
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
+        }
+    }
+    return ctx->CmdSize;
+}
 
-                txParamSetupReq.UplinkDwellTime = 0;
-                txParamSetupReq.DownlinkDwellTime = 0;
+/*!
+ * \brief Processes a PingSlotChannelReq MAC command
+ */
+static uint8_t ProcessPingSlotChannelReq( MacCommandsParseCtx_t* ctx )
+{
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint8_t status = 0x03;
+    uint32_t frequency = 0;
+    uint8_t datarate;
+
+    frequency = ( uint32_t )ctx->Cmd[1];
+    frequency |= ( uint32_t )ctx->Cmd[2] << 8;
+    frequency |= ( uint32_t )ctx->Cmd[3] << 16;
+    frequency *= 100;
+    datarate = ctx->Cmd[4] & 0x0F;
+
+    status = LoRaMacClassBPingSlotChannelReq( datarate, frequency );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
+    macCmdPayload[0] = status;
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
+    LoRaMacCommandsAddCmd( MOTE_MAC_PING_SLOT_FREQ_ANS, macCmdPayload, 1 );
+#elif (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    LoRaMacCommandsAddCmd( MOTE_MAC_PING_SLOT_CHANNEL_ANS, macCmdPayload, 1 );
+#endif /* LORAMAC_VERSION */
+    return ctx->CmdSize;
+}
 
-                if( ( eirpDwellTime & 0x20 ) == 0x20 )
-                {
-                    txParamSetupReq.DownlinkDwellTime = 1;
-                }
-                if( ( eirpDwellTime & 0x10 ) == 0x10 )
-                {
-                    txParamSetupReq.UplinkDwellTime = 1;
-                }
-                txParamSetupReq.MaxEirp = eirpDwellTime & 0x0F;
+/*!
+ * \brief Processes a BeaconTimingAns MAC command
+ */
+static uint8_t ProcessBeaconTimingAns( MacCommandsParseCtx_t* ctx )
+{
+    if( LoRaMacConfirmQueueIsCmdActive( MLME_BEACON_TIMING ) == true )
+    {
+        LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_BEACON_TIMING );
+        uint16_t beaconTimingDelay = 0;
+        uint8_t beaconTimingChannel = 0;
 
-                // Check the status for correctness
-                if( RegionTxParamSetupReq( Nvm.MacGroup2.Region, &txParamSetupReq ) != -1 )
-                {
-                    // Accept command
-                    Nvm.MacGroup2.MacParams.UplinkDwellTime = txParamSetupReq.UplinkDwellTime;
-                    Nvm.MacGroup2.MacParams.DownlinkDwellTime = txParamSetupReq.DownlinkDwellTime;
-                    Nvm.MacGroup2.MacParams.MaxEirp = LoRaMacMaxEirpTable[txParamSetupReq.MaxEirp];
-                    // Update the datarate in case of the new configuration limits it
-                    getPhy.Attribute = PHY_MIN_TX_DR;
-                    getPhy.UplinkDwellTime = Nvm.MacGroup2.MacParams.UplinkDwellTime;
-                    phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
-                    Nvm.MacGroup1.ChannelsDatarate = MAX( Nvm.MacGroup1.ChannelsDatarate, ( int8_t )phyParam.Value );
-
-                    // Add command response
-                    LoRaMacCommandsAddCmd( MOTE_MAC_TX_PARAM_SETUP_ANS, macCmdPayload, 0 );
-                }
-                break;
-            }
-#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
-            case SRV_MAC_REKEY_CONF:
-            {
-                uint8_t serverMinorVersion = payload[macIndex++];
+        beaconTimingDelay = ( uint16_t )ctx->Cmd[1];
+        beaconTimingDelay |= ( uint16_t )ctx->Cmd[2] << 8;
+        beaconTimingChannel = ctx->Cmd[3];
 
-                // Compare own LoRaWAN Version with server's
-                if( Nvm.MacGroup2.Version.Fields.Minor >= serverMinorVersion )
-                {
-                    // If they equal remove the sticky RekeyInd MAC-Command.
-                    if( LoRaMacCommandsGetCmd( MOTE_MAC_REKEY_IND, &macCmd) == LORAMAC_COMMANDS_SUCCESS )
-                    {
-                        LoRaMacCommandsRemoveCmd( macCmd );
-                    }
-                }
-                break;
-            }
-#endif /* LORAMAC_VERSION */
-            case SRV_MAC_DL_CHANNEL_REQ:
-            {
-                DlChannelReqParams_t dlChannelReq;
-                status = 0x03;
+        LoRaMacClassBBeaconTimingAns( beaconTimingDelay, beaconTimingChannel, RxDoneParams.LastRxDone );
+    }
+    return ctx->CmdSize;
+}
 
-                dlChannelReq.ChannelId = payload[macIndex++];
-                dlChannelReq.Rx1Frequency = ( uint32_t ) payload[macIndex++];
-                dlChannelReq.Rx1Frequency |= ( uint32_t ) payload[macIndex++] << 8;
-                dlChannelReq.Rx1Frequency |= ( uint32_t ) payload[macIndex++] << 16;
-                dlChannelReq.Rx1Frequency *= 100;
+/*!
+ * \brief Processes a BeaconFreqReq MAC command
+ */
+static uint8_t ProcessBeaconFreqReq( MacCommandsParseCtx_t* ctx )
+{
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint32_t frequency = 0;
 
-                status = ( uint8_t )RegionDlChannelReq( Nvm.MacGroup2.Region, &dlChannelReq );
+    frequency = ( uint32_t )ctx->Cmd[1];
+    frequency |= ( uint32_t )ctx->Cmd[2] << 8;
+    frequency |= ( uint32_t )ctx->Cmd[3] << 16;
+    frequency *= 100;
 
-                if( ( int8_t )status >= 0 )
-                {
-                    macCmdPayload[0] = status;
-                    LoRaMacCommandsAddCmd( MOTE_MAC_DL_CHANNEL_ANS, macCmdPayload, 1 );
-                }
-                break;
-            }
+    if( LoRaMacClassBBeaconFreqReq( frequency ) == true )
+    {
+        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
+        macCmdPayload[0] = 1;
+    }
+    else
+    {
+        macCmdPayload[0] = 0;
+    }
+    LoRaMacCommandsAddCmd( MOTE_MAC_BEACON_FREQ_ANS, macCmdPayload, 1 );
+    return ctx->CmdSize;
+}
+
+/*!
+ * Downlink MAC command handlers, indexed by CID. The size of each command
+ * is given by LoRaMacCommandsGetCmdSize.
+ */
+static const MacCommandHandler_t MacCommandHandlers[LORAMAC_COMMANDS_MAX_CID + 1] =
+{
 #if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
-            case SRV_MAC_ADR_PARAM_SETUP_REQ:
-            {
-                /* ADRParamSetupReq Payload:  ADRparam
-                 * +----------------+---------------+
-                 * | 7:4 Limit_exp  | 3:0 Delay_exp |
-                 * +----------------+---------------+
-                 */
-
-                uint8_t delayExp = 0x0F & payload[macIndex];
-                uint8_t limitExp = 0x0F & ( payload[macIndex] >> 4 );
-                macIndex++;
-
-                // ADR_ACK_ DELAY = 2^Delay_exp
-                Nvm.MacGroup2.MacParams.AdrAckDelay = 0x01 << delayExp;
-
-                // ADR_ACK_LIMIT = 2^Limit_exp
-                Nvm.MacGroup2.MacParams.AdrAckLimit = 0x01 << limitExp;
-
-                LoRaMacCommandsAddCmd( MOTE_MAC_ADR_PARAM_SETUP_ANS, macCmdPayload, 0 );
-                break;
-            }
-            case SRV_MAC_FORCE_REJOIN_REQ:
-            {
-                /* ForceRejoinReq Payload:
-                 * +--------------+------------------+-------+----------------+--------+
-                 * | 13:11 Period | 10:8 Max_Retries | 7 RFU | 6:4 RejoinType | 3:0 DR |
-                 * +--------------+------------------+-------+----------------+--------+
-                 */
-
-                // Parse payload
-                uint8_t period = ( 0x38 & payload[macIndex] ) >> 3;
-                Nvm.MacGroup2.ForceRejoinMaxRetries = 0x07 & payload[macIndex];
-                macIndex++;
-                Nvm.MacGroup2.ForceRejoinType = ( 0x70 & payload[macIndex] ) >> 4;
-                Nvm.MacGroup1.ChannelsDatarate = 0x0F & payload[macIndex];
-                macIndex ++;
-
-                // Calc delay between retransmissions: 32 seconds x 2^Period + Rand32
-                uint32_t rejoinCycleInSec = 32 * ( 0x01 << period ) + randr( 0, 32 );
-
-                MacCtx.ForceRejoinCycleTime = 0;
-                Nvm.MacGroup1.ForceRejoinRetriesCounter = 0;
-                ConvertRejoinCycleTime( rejoinCycleInSec, &MacCtx.ForceRejoinCycleTime );
-                OnForceRejoinReqCycleTimerEvent( NULL );
-                break;
-            }
-            case SRV_MAC_REJOIN_PARAM_REQ:
-            {
-                /* RejoinParamSetupReq Payload:
-                 * +----------------+---------------+
-                 * | 7:4 MaxTimeN   | 3:0 MaxCountN |
-                 * +----------------+---------------+
-                 */
-                uint8_t maxCountN = 0x0F & payload[macIndex];
-                uint8_t maxTimeN = 0x0F & ( payload[macIndex] >> 4 );
-                uint32_t cycleInSec = 0x01 << ( maxTimeN + 10 );
-                uint32_t timeInMs = 0;
-                uint16_t uplinkLimit = 0x01 << ( maxCountN + 4 );
-                macIndex++;
-                macCmdPayload[0] = 0;
-
-                if( ConvertRejoinCycleTime( cycleInSec, &timeInMs ) == true )
-                {
-                    // Calc delay between retransmissions: 2^(maxTimeN+10)
-                    Nvm.MacGroup2.Rejoin0CycleInSec = cycleInSec;
-                    // Calc number if uplinks without rejoin request: 2^(maxCountN+4)
-                    Nvm.MacGroup2.Rejoin0UplinksLimit = uplinkLimit;
-                    MacCtx.Rejoin0CycleTime = timeInMs;
-
-                    macCmdPayload[0] = 0x01;
-                    TimerStop( &MacCtx.Rejoin0CycleTimer );
-                    TimerSetValue( &MacCtx.Rejoin0CycleTimer, MacCtx.Rejoin0CycleTime );
-                    TimerStart( &MacCtx.Rejoin0CycleTimer );
-                }
-                LoRaMacCommandsAddCmd( MOTE_MAC_REJOIN_PARAM_ANS, macCmdPayload, 1 );
-                break;
-             }
-            case SRV_MAC_DEVICE_MODE_CONF:
-            {
-                // 1 byte payload which we do not handle.
-                macIndex++;
-                if( LoRaMacCommandsGetCmd( MOTE_MAC_DEVICE_MODE_IND, &macCmd) == LORAMAC_COMMANDS_SUCCESS )
-                {
-                    LoRaMacCommandsRemoveCmd( macCmd );
-                }
-                break;
-            }
+    [SRV_MAC_RESET_CONF]            = ProcessResetConf,
 #endif /* LORAMAC_VERSION */
-            case SRV_MAC_DEVICE_TIME_ANS:
-            {
-                // The mote time can be updated only when the time is received in classA
-                // receive windows only.
-                if( LoRaMacConfirmQueueIsCmdActive( MLME_DEVICE_TIME ) == true )
-                {
-                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_DEVICE_TIME );
-
-                    SysTime_t gpsEpochTime = { 0 };
-                    SysTime_t sysTime = { 0 };
-                    SysTime_t sysTimeCurrent = { 0 };
-
-                    gpsEpochTime.Seconds = ( uint32_t )payload[macIndex++];
-                    gpsEpochTime.Seconds |= ( uint32_t )payload[macIndex++] << 8;
-                    gpsEpochTime.Seconds |= ( uint32_t )payload[macIndex++] << 16;
-                    gpsEpochTime.Seconds |= ( uint32_t )payload[macIndex++] << 24;
-                    gpsEpochTime.SubSeconds = payload[macIndex++];
-
-                    // Convert the fractional second received in ms
-                    // round( pow( 0.5, 8.0 ) * 1000 ) = 3.90625
-                    gpsEpochTime.SubSeconds = ( int16_t )( ( ( int32_t )gpsEpochTime.SubSeconds * 1000 ) >> 8 );
-
-                    // Copy received GPS Epoch time into system time
-                    sysTime = gpsEpochTime;
-                    // Add Unix to Gps epoch offset. The system time is based on Unix time.
-                    sysTime.Seconds += UNIX_GPS_EPOCH_OFFSET;
-
-                    // Compensate time difference between Tx Done time and now
-                    sysTimeCurrent = SysTimeGet( );
-                    sysTime = SysTimeAdd( sysTimeCurrent, SysTimeSub( sysTime, MacCtx.LastTxSysTime ) );
-
-                    // Apply the new system time.
-                    SysTimeSet( sysTime );
-                    LoRaMacClassBDeviceTimeAns( );
-                    MacCtx.McpsIndication.DeviceTimeAnsReceived = true;
-                }
-                else
-                {
-#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
-                    // In case of other receive windows the Device Time Answer is not received.
-                    MacCtx.McpsIndication.DeviceTimeAnsReceived = false;
+    [SRV_MAC_LINK_CHECK_ANS]        = ProcessLinkCheckAns,
+    [SRV_MAC_LINK_ADR_REQ]          = ProcessLinkAdrReq,
+    [SRV_MAC_DUTY_CYCLE_REQ]        = ProcessDutyCycleReq,
+    [SRV_MAC_RX_PARAM_SETUP_REQ]    = ProcessRxParamSetupReq,
+    [SRV_MAC_DEV_STATUS_REQ]        = ProcessDevStatusReq,
+    [SRV_MAC_NEW_CHANNEL_REQ]       = ProcessNewChannelReq,
+    [SRV_MAC_RX_TIMING_SETUP_REQ]   = ProcessRxTimingSetupReq,
+    [SRV_MAC_TX_PARAM_SETUP_REQ]    = ProcessTxParamSetupReq,
+    [SRV_MAC_DL_CHANNEL_REQ]        = ProcessDlChannelReq,
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+    [SRV_MAC_REKEY_CONF]            = ProcessRekeyConf,
+    [SRV_MAC_ADR_PARAM_SETUP_REQ]   = ProcessAdrParamSetupReq,
 #endif /* LORAMAC_VERSION */
-                }
-                break;
-            }
-            case SRV_MAC_PING_SLOT_INFO_ANS:
-            {
-                if( LoRaMacConfirmQueueIsCmdActive( MLME_PING_SLOT_INFO ) == true )
-                {
-                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_PING_SLOT_INFO );
-                    // According to the specification, it is not allowed to process this answer in
-                    // a ping or multicast slot
-                    if( ( MacCtx.RxSlot != RX_SLOT_WIN_CLASS_B_PING_SLOT ) && ( MacCtx.RxSlot != RX_SLOT_WIN_CLASS_B_MULTICAST_SLOT ) )
-                    {
-                        LoRaMacClassBPingSlotInfoAns( );
-                    }
-                }
-                break;
-            }
-            case SRV_MAC_PING_SLOT_CHANNEL_REQ:
-            {
-                uint8_t status = 0x03;
-                uint32_t frequency = 0;
-                uint8_t datarate;
+    [SRV_MAC_DEVICE_TIME_ANS]       = ProcessDeviceTimeAns,
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+    [SRV_MAC_FORCE_REJOIN_REQ]      = ProcessForceRejoinReq,
+    [SRV_MAC_REJOIN_PARAM_REQ]      = ProcessRejoinParamReq,
+#endif /* LORAMAC_VERSION */
+    [SRV_MAC_PING_SLOT_INFO_ANS]    = ProcessPingSlotInfoAns,
+    [SRV_MAC_PING_SLOT_CHANNEL_REQ] = ProcessPingSlotChannelReq,
+    [SRV_MAC_BEACON_TIMING_ANS]     = ProcessBeaconTimingAns,
+    [SRV_MAC_BEACON_FREQ_REQ]       = ProcessBeaconFreqReq,
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+    [SRV_MAC_DEVICE_MODE_CONF]      = ProcessDeviceModeConf,
+#endif /* LORAMAC_VERSION */
+};
 
-                frequency = ( uint32_t )payload[macIndex++];
-                frequency |= ( uint32_t )payload[macIndex++] << 8;
-                frequency |= ( uint32_t )payload[macIndex++] << 16;
-                frequency *= 100;
-                datarate = payload[macIndex++] & 0x0F;
+static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t commandsSize, int8_t snr, LoRaMacRxSlot_t rxSlot )
+{
+    MacCommandsParseCtx_t ctx;
 
-                status = LoRaMacClassBPingSlotChannelReq( datarate, frequency );
-                macCmdPayload[0] = status;
-#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
-                LoRaMacCommandsAddCmd( MOTE_MAC_PING_SLOT_FREQ_ANS, macCmdPayload, 1 );
-#elif (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
-                LoRaMacCommandsAddCmd( MOTE_MAC_PING_SLOT_CHANNEL_ANS, macCmdPayload, 1 );
+#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    if( ( rxSlot != RX_SLOT_WIN_1 ) && ( rxSlot != RX_SLOT_WIN_2 ) )
+    {
+        // Do only parse MAC commands for Class A RX windows
+        return;
+    }
 #endif /* LORAMAC_VERSION */
-                break;
-            }
-            case SRV_MAC_BEACON_TIMING_ANS:
-            {
-                if( LoRaMacConfirmQueueIsCmdActive( MLME_BEACON_TIMING ) == true )
-                {
-                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_BEACON_TIMING );
-                    uint16_t beaconTimingDelay = 0;
-                    uint8_t beaconTimingChannel = 0;
-
-                    beaconTimingDelay = ( uint16_t )payload[macIndex++];
-                    beaconTimingDelay |= ( uint16_t )payload[macIndex++] << 8;
-                    beaconTimingChannel = payload[macIndex++];
 
-                    LoRaMacClassBBeaconTimingAns( beaconTimingDelay, beaconTimingChannel, RxDoneParams.LastRxDone );
-                }
-                break;
-            }
-            case SRV_MAC_BEACON_FREQ_REQ:
-                {
-                    uint32_t frequency = 0;
+    ctx.Payload = payload;
+    ctx.Size = commandsSize;
+    ctx.Index = macIndex;
+    ctx.Snr = snr;
+    ctx.AdrBlockFound = false;
 
-                    frequency = ( uint32_t )payload[macIndex++];
-                    frequency |= ( uint32_t )payload[macIndex++] << 8;
-                    frequency |= ( uint32_t )payload[macIndex++] << 16;
-                    frequency *= 100;
+    while( ctx.Index < commandsSize )
+    {
+        uint8_t cid = payload[ctx.Index];
+        uint8_t cmdSize = LoRaMacCommandsGetCmdSize( cid );
 
-                    if( LoRaMacClassBBeaconFreqReq( frequency ) == true )
-                    {
-                        macCmdPayload[0] = 1;
-                    }
-                    else
-                    {
-                        macCmdPayload[0] = 0;
-                    }
-                    LoRaMacCommandsAddCmd( MOTE_MAC_BEACON_FREQ_ANS, macCmdPayload, 1 );
-                }
-                break;
-            default:
-                // Unknown command. ABORT MAC commands processing
-                return;
+        // Unknown command or incomplete MAC command. ABORT MAC commands processing
+        if( ( cmdSize == 0 ) || ( MacCommandHandlers[cid] == NULL ) ||
+            ( ( cmdSize + ctx.Index ) > commandsSize ) )
+        {
+            return;
         }
+
+        // Every handler processes at least its own command, which bounds the loop
+        ctx.Cmd = &payload[ctx.Index];
+        ctx.CmdSize = cmdSize;
+        ctx.Index += MacCommandHandlers[cid]( &ctx );
     }
 }
 
@@ -3284,12 +3760,15 @@ static LoRaMacStatus_t Send( LoRaMacHeader_t* macHdr, uint8_t fPort, void* fBuff
     int8_t txPower = Nvm.MacGroup1.ChannelsTxPower;
     uint32_t adrAckCounter = Nvm.MacGroup1.AdrAckCounter;
     CalcNextAdrParams_t adrNext;
+    uint16_t channelsMask[REGION_NVM_CHANNELS_MASK_SIZE];
 
     // Check if we are joined
     if( Nvm.MacGroup2.NetworkActivation == ACTIVATION_TYPE_NONE )
     {
         return LORAMAC_STATUS_NO_NETWORK_JOINED;
     }
+    // Aggregated time off, datarate, TX power and server acknowledgement
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
     if( Nvm.MacGroup2.MaxDCycle == 0 )
     {
         Nvm.MacGroup1.AggregatedTimeOff = 0;
@@ -3325,6 +3804,8 @@ static LoRaMacStatus_t Send( LoRaMacHeader_t* macHdr, uint8_t fPort, void* fBuff
     adrNext.TxPower = Nvm.MacGroup1.ChannelsTxPower;
     adrNext.UplinkDwellTime =  Nvm.MacGroup2.MacParams.UplinkDwellTime;
     adrNext.Region = Nvm.MacGroup2.Region;
+    // The ADR back-off may reactivate the default channels
+    memcpy1( ( uint8_t* )channelsMask, ( uint8_t* )Nvm.RegionGroup2.ChannelsMask, sizeof( channelsMask ) );
 #if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
     adrNext.Version = Nvm.MacGroup2.Version;
     fCtrl.Bits.AdrAckReq = LoRaMacAdrCalcNext( &adrNext, &Nvm.MacGroup1.ChannelsDatarate,
@@ -3334,7 +3815,12 @@ static LoRaMacStatus_t Send( LoRaMacHeader_t* macHdr, uint8_t fPort, void* fBuff
     fCtrl.Bits.AdrAckReq = LoRaMacAdrCalcNext( &adrNext, &Nvm.MacGroup1.ChannelsDatarate,
                                                &Nvm.MacGroup1.ChannelsTxPower,
                                                &Nvm.MacGroup2.MacParams.ChannelsNbTrans, &adrAckCounter );
+    if( Nvm.MacGroup2.MacParams.ChannelsNbTrans != adrNext.NbTrans )
+    {
+        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
+    }
 #endif /* LORAMAC_VERSION */
+    LoRaMacNvmCheckChannelsMask( channelsMask );
 
     // Prepare the frame
     status = PrepareFrame( macHdr, &fCtrl, fPort, fBuffer, fBufferSize );
@@ -3382,6 +3868,7 @@ static LoRaMacStatus_t SendReJoinReq( JoinReqIdentifier_t joinReqType )
         case REJOIN_REQ_1:
         {
             Nvm.MacGroup2.IsRejoinAcceptPending = true;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
 
             MacCtx.TxMsg.Type = LORAMAC_MSG_TYPE_RE_JOIN_1;
             MacCtx.TxMsg.Message.ReJoin1.Buffer = MacCtx.PktBuffer;
@@ -3415,6 +3902,7 @@ static LoRaMacStatus_t SendReJoinReq( JoinReqIdentifier_t joinReqType )
             }
 
             Nvm.MacGroup2.IsRejoinAcceptPending = true;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
 
             MacCtx.TxMsg.Type = LORAMAC_MSG_TYPE_RE_JOIN_0_2;
             MacCtx.TxMsg.Message.ReJoin0or2.Buffer = MacCtx.PktBuffer;
@@ -3586,6 +4074,7 @@ static LoRaMacStatus_t ScheduleTx( bool allowDelayedTx )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_PARAMETER_INVALID;
     NextChanParams_t nextChan;
+    uint16_t channelsMask[REGION_NVM_CHANNELS_MASK_SIZE];
 
     // Check class b collisions
     status = CheckForClassBCollision( );
@@ -3620,8 +4109,11 @@ static LoRaMacStatus_t ScheduleTx( bool allowDelayedTx )
         nextChan.Joined = false;
     }
 
-    // Select channel
+    // Select channel, the region may reactivate the default channels
+    memcpy1( ( uint8_t* )channelsMask, ( uint8_t* )Nvm.RegionGroup2.ChannelsMask, sizeof( channelsMask ) );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 );
     status = RegionNextChannel( Nvm.MacGroup2.Region, &nextChan, &MacCtx.Channel, &MacCtx.DutyCycleWaitTime, &Nvm.MacGroup1.AggregatedTimeOff );
+    LoRaMacNvmCheckChannelsMask( channelsMask );
 
     if( status != LORAMAC_STATUS_OK )
     {
@@ -3667,6 +4159,9 @@ static LoRaMacStatus_t SecureFrame( uint8_t txDr, uint8_t txCh )
     LoRaMacCryptoStatus_t macCryptoStatus = LORAMAC_CRYPTO_ERROR;
     uint32_t fCntUp = 0;
 
+    // Uplink frame counter, DevNonce or RJcount1
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CRYPTO );
+
     switch( MacCtx.TxMsg.Type )
     {
         case LORAMAC_MSG_TYPE_JOIN_REQUEST:
@@ -3728,6 +4223,8 @@ static LoRaMacStatus_t SecureFrame( uint8_t txDr, uint8_t txCh )
 
 static void CalculateBackOff( void )
 {
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
+
     // Make sure that the calculation of the backoff time for the aggregated time off will only be done in
     // case the value is zero. It will be set to zero in the function RegionNextChannel.
     if( Nvm.MacGroup1.AggregatedTimeOff == 0 )
@@ -3821,6 +4318,9 @@ static void ResetMacParameters( bool isRejoin )
     params.Bands = &RegionBands;
 #endif /* LORAMAC_VERSION */
     RegionInitDefaults( Nvm.MacGroup2.Region, &params );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 |
+                        LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 |
+                        LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
 
     // Initialize channel index.
     MacCtx.Channel = 0;
@@ -3877,6 +4377,7 @@ static bool IsReJoin0Required( )
         ( Nvm.MacGroup2.Rejoin0UplinksLimit != 0 ) )
     {
         Nvm.MacGroup1.Rejoin0UplinksCounter = 0;
+        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
         return true;
     }
     return false;
@@ -3937,13 +4438,19 @@ static LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t
     uint32_t fCntUp = 0;
     size_t macCmdsSize = 0;
     uint8_t availableSize = 0;
+    LoRaMacStatus_t status = LORAMAC_STATUS_OK;
 
     if( fBuffer == NULL )
     {
         fBufferSize = 0;
     }
+    if( fBufferSize > ( LORAMAC_PHY_MAXPAYLOAD - LORAMAC_MHDR_FIELD_SIZE ) )
+    {
+        return LORAMAC_STATUS_LENGTH_ERROR;
+    }
 
-    memcpy1( MacCtx.AppData, ( uint8_t* ) fBuffer, fBufferSize );
+    // The frame is assembled in place in PktBuffer, the application payload
+    // is copied only once, to its final position.
     MacCtx.AppDataSize = fBufferSize;
     MacCtx.PktBuffer[0] = macHdr->Value;
 
@@ -3961,7 +4468,7 @@ static LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t
             MacCtx.TxMsg.Message.Data.FHDR.DevAddr = Nvm.MacGroup2.DevAddr;
             MacCtx.TxMsg.Message.Data.FHDR.FCtrl.Value = fCtrl->Value;
             MacCtx.TxMsg.Message.Data.FRMPayloadSize = MacCtx.AppDataSize;
-            MacCtx.TxMsg.Message.Data.FRMPayload = MacCtx.AppData;
+            MacCtx.TxMsg.Message.Data.FRMPayload = MacCtx.PktBuffer + LORAMAC_FRAME_PAYLOAD_OFFSET;
 
             if( LORAMAC_CRYPTO_SUCCESS != LoRaMacCryptoGetFCntUp( &fCntUp ) )
             {
@@ -4007,23 +4514,34 @@ static LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t
                     {
                         return LORAMAC_STATUS_MAC_COMMAD_ERROR;
                     }
-                    return LORAMAC_STATUS_SKIPPED_APP_DATA;
+                    status = LORAMAC_STATUS_SKIPPED_APP_DATA;
                 }
                 // No application payload available therefore add all mac commands to the FRMPayload.
                 else
                 {
-                    if( LoRaMacCommandsSerializeCmds( availableSize, &macCmdsSize, MacCtx.MacCommandsBuffer ) != LORAMAC_COMMANDS_SUCCESS )
+                    // Serialize the MAC commands directly into the FRMPayload field of PktBuffer
+                    if( LoRaMacCommandsSerializeCmds( availableSize, &macCmdsSize, MacCtx.TxMsg.Message.Data.FRMPayload ) != LORAMAC_COMMANDS_SUCCESS )
                     {
                         return LORAMAC_STATUS_MAC_COMMAD_ERROR;
                     }
                     // Force FPort to be zero
                     MacCtx.TxMsg.Message.Data.FPort = 0;
 
-                    MacCtx.TxMsg.Message.Data.FRMPayload = MacCtx.MacCommandsBuffer;
                     MacCtx.TxMsg.Message.Data.FRMPayloadSize = macCmdsSize;
                 }
             }
 
+            if( MacCtx.AppDataSize > 0 )
+            {
+                // The application payload goes behind FOpts, it is encrypted in place by the crypto module
+                MacCtx.TxMsg.Message.Data.FRMPayload += MacCtx.TxMsg.Message.Data.FHDR.FCtrl.Bits.FOptsLen;
+                if( ( LORAMAC_FRAME_PAYLOAD_OFFSET + MacCtx.TxMsg.Message.Data.FHDR.FCtrl.Bits.FOptsLen +
+                      MacCtx.AppDataSize + LORAMAC_MIC_FIELD_SIZE ) > LORAMAC_PHY_MAXPAYLOAD )
+                {
+                    return LORAMAC_STATUS_LENGTH_ERROR;
+                }
+                memcpy1( MacCtx.TxMsg.Message.Data.FRMPayload, ( uint8_t* ) fBuffer, MacCtx.AppDataSize );
+            }
             break;
         case FRAME_TYPE_PROPRIETARY:
             if( ( fBuffer != NULL ) && ( MacCtx.AppDataSize > 0 ) )
@@ -4036,7 +4554,7 @@ static LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t* macHdr, LoRaMacFrameCtrl_t
             return LORAMAC_STATUS_SERVICE_UNKNOWN;
     }
 
-    return LORAMAC_STATUS_OK;
+    return status;
 }
 
 static LoRaMacStatus_t SendFrameOnChannel( uint8_t channel )
@@ -4217,6 +4735,7 @@ static LoRaMacStatus_t RestoreNvmData( void )
 
     memcpy1( ( uint8_t* ) &Nvm, ( uint8_t* ) &NvmBackup, sizeof( LoRaMacNvmData_t ) );
     memset1( ( uint8_t* ) &NvmBackup, 0, sizeof( LoRaMacNvmData_t ) );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_ALL_GROUPS );
 
     // Initialize RxC config parameters.
     MacCtx.RxWindowCConfig.Channel = MacCtx.Channel;
@@ -4393,6 +4912,9 @@ static uint32_t IncreaseAdrAckCounter( uint32_t counter )
 
 static bool StopRetransmission( void )
 {
+    // Rejoin and rekey uplink counters, ADR ACK counter
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
+
 #if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
     // Increase Rejoin Uplinks counter
     if( Nvm.MacGroup2.Rejoin0UplinksLimit != 0 )
@@ -4415,6 +4937,7 @@ static bool StopRetransmission( void )
             if( Nvm.MacGroup1.RekeyIndUplinksCounter == Nvm.MacGroup2.MacParams.AdrAckLimit )
             {
                 Nvm.MacGroup2.NetworkActivation = ACTIVATION_TYPE_NONE;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
                 MacCtx.MacFlags.Bits.MlmeInd = 1;
                 MacCtx.MlmeIndication.MlmeIndication = MLME_REVERT_JOIN;
             }
@@ -4481,6 +5004,7 @@ static void AckTimeoutRetriesProcess( void )
             getPhy.Datarate = Nvm.MacGroup1.ChannelsDatarate;
             phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
             Nvm.MacGroup1.ChannelsDatarate = phyParam.Value;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
         }
     }
 }
@@ -4494,6 +5018,7 @@ static void AckTimeoutRetriesFinalize( void )
         params.NvmGroup1 = &Nvm.RegionGroup1;
         params.NvmGroup2 = &Nvm.RegionGroup2;
         RegionInitDefaults( Nvm.MacGroup2.Region, &params );
+        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
 
         MacCtx.NodeAckRequested = false;
         MacCtx.McpsConfirm.AckReceived = false;
@@ -4542,6 +5067,7 @@ LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t* primitives, LoRaMacC
     // Initialize the module context with zeros
     memset1( ( uint8_t* ) &Nvm, 0x00, sizeof( LoRaMacNvmData_t ) );
     memset1( ( uint8_t* ) &MacCtx, 0x00, sizeof( LoRaMacCtx_t ) );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_ALL_GROUPS );
 
     // Set non zero variables to its default value
 #if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
@@ -4561,6 +5087,7 @@ LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t* primitives, LoRaMacC
     params.NvmGroup2 = &Nvm.RegionGroup2;
     params.Bands = &RegionBands;
     RegionInitDefaults( Nvm.MacGroup2.Region, &params );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
 #endif /* LORAMAC_VERSION */
 
     // Reset to defaults
@@ -4654,6 +5181,7 @@ LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t* primitives, LoRaMacC
     params.NvmGroup1 = &Nvm.RegionGroup1;
     params.NvmGroup2 = &Nvm.RegionGroup2;
     RegionInitDefaults( Nvm.MacGroup2.Region, &params );
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
 #elif (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
     // FPort 224 is enabled by default.
     Nvm.MacGroup2.IsCertPortOn = true;
@@ -4929,6 +5457,8 @@ LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t* mibGet )
             phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
 
             mibGet->Param.ChannelList = phyParam.Channels;
+            // The returned reference allows to modify the channels
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
             break;
         }
         case MIB_RX2_CHANNEL:
@@ -4957,6 +5487,7 @@ LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t* mibGet )
             phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
 
             mibGet->Param.ChannelsDefaultMask = phyParam.ChannelsMask;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
             break;
         }
         case MIB_CHANNELS_MASK:
@@ -4965,6 +5496,7 @@ LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t* mibGet )
             phyParam = RegionGetPhyParam( Nvm.MacGroup2.Region, &getPhy );
 
             mibGet->Param.ChannelsMask = phyParam.ChannelsMask;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
             break;
         }
         case MIB_CHANNELS_NB_TRANS:
@@ -5046,6 +5578,8 @@ LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t* mibGet )
         case MIB_NVM_CTXS:
         {
             mibGet->Param.Contexts = &Nvm;
+            // The returned reference allows to modify any group
+            LoRaMacNvmSetDirty( LORAMAC_NVM_ALL_GROUPS );
             break;
         }
         case MIB_NVM_BKP_CTXS:
@@ -5180,6 +5714,9 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             if( mibSet->Param.NetworkActivation != ACTIVATION_TYPE_OTAA  )
             {
                 Nvm.MacGroup2.NetworkActivation = mibSet->Param.NetworkActivation;
+                // The keys may have been provisioned through the secure element API
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CRYPTO | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 |
+                                    LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {   // Do not allow to set ACTIVATION_TYPE_OTAA since the MAC will set it automatically after a successful join process.
@@ -5193,6 +5730,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             break;
         }
         case MIB_JOIN_EUI:
@@ -5201,16 +5739,19 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             break;
         }
         case MIB_ADR:
         {
             Nvm.MacGroup2.AdrCtrlOn = mibSet->Param.AdrEnable;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_NET_ID:
         {
             Nvm.MacGroup2.NetID = mibSet->Param.NetID;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_DEV_ADDR:
@@ -5223,6 +5764,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             {
                 /* Update Nvm.MacGroup2.devAdr to handle set/get sequence */
                 Nvm.MacGroup2.DevAddr = mibSet->Param.DevAddr;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 | LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             break;
         }
@@ -5234,6 +5776,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5249,6 +5792,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5265,6 +5809,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5280,6 +5825,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5295,6 +5841,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5310,6 +5857,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5325,6 +5873,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5341,6 +5890,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5357,6 +5907,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5372,6 +5923,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5388,6 +5940,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5403,6 +5956,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5418,6 +5972,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5435,6 +5990,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5450,6 +6006,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5465,6 +6022,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5482,6 +6040,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5497,6 +6056,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5512,6 +6072,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5529,6 +6090,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5544,6 +6106,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5559,6 +6122,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 {
                     return LORAMAC_STATUS_CRYPTO_ERROR;
                 }
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
             }
             else
             {
@@ -5570,6 +6134,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
         case MIB_PUBLIC_NETWORK:
         {
             Nvm.MacGroup2.PublicNetwork = mibSet->Param.EnablePublicNetwork;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             Radio.SetPublicNetwork( Nvm.MacGroup2.PublicNetwork );
             Radio.Sleep( );
             break;
@@ -5577,6 +6142,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
         case MIB_REPEATER_SUPPORT:
         {
             Nvm.MacGroup2.MacParams.RepeaterSupport = mibSet->Param.EnableRepeaterSupport;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_RX2_CHANNEL:
@@ -5597,6 +6163,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 else
                 {
                     Nvm.MacGroup2.MacParams.Rx2Channel = mibSet->Param.Rx2Channel;
+                    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
                 }
             }
             break;
@@ -5609,6 +6176,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             if( RegionVerify( Nvm.MacGroup2.Region, &verify, PHY_RX_DR ) == true )
             {
                 Nvm.MacGroup2.MacParamsDefaults.Rx2Channel = mibSet->Param.Rx2DefaultChannel;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             }
             else
             {
@@ -5624,6 +6192,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             if( RegionVerify( Nvm.MacGroup2.Region, &verify, PHY_RX_DR ) == true )
             {
                 Nvm.MacGroup2.MacParams.RxCChannel = mibSet->Param.RxCChannel;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
 
                 if( ( Nvm.MacGroup2.DeviceClass == CLASS_C ) && ( Nvm.MacGroup2.NetworkActivation != ACTIVATION_TYPE_NONE ) )
                 {
@@ -5650,6 +6219,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             if( RegionVerify( Nvm.MacGroup2.Region, &verify, PHY_RX_DR ) == true )
             {
                 Nvm.MacGroup2.MacParamsDefaults.RxCChannel = mibSet->Param.RxCDefaultChannel;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             }
             else
             {
@@ -5666,6 +6236,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
             break;
         }
         case MIB_CHANNELS_MASK:
@@ -5677,6 +6248,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
             break;
         }
         case MIB_CHANNELS_NB_TRANS:
@@ -5685,6 +6257,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 ( mibSet->Param.ChannelsNbTrans <= 15 ) )
             {
                 Nvm.MacGroup2.MacParams.ChannelsNbTrans = mibSet->Param.ChannelsNbTrans;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             }
             else
             {
@@ -5695,26 +6268,31 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
         case MIB_MAX_RX_WINDOW_DURATION:
         {
             Nvm.MacGroup2.MacParams.MaxRxWindow = mibSet->Param.MaxRxWindow;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_RECEIVE_DELAY_1:
         {
             Nvm.MacGroup2.MacParams.ReceiveDelay1 = mibSet->Param.ReceiveDelay1;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_RECEIVE_DELAY_2:
         {
             Nvm.MacGroup2.MacParams.ReceiveDelay2 = mibSet->Param.ReceiveDelay2;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_JOIN_ACCEPT_DELAY_1:
         {
             Nvm.MacGroup2.MacParams.JoinAcceptDelay1 = mibSet->Param.JoinAcceptDelay1;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_JOIN_ACCEPT_DELAY_2:
         {
             Nvm.MacGroup2.MacParams.JoinAcceptDelay2 = mibSet->Param.JoinAcceptDelay2;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_CHANNELS_DEFAULT_DATARATE:
@@ -5724,6 +6302,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             if( RegionVerify( Nvm.MacGroup2.Region, &verify, PHY_DEF_TX_DR ) == true )
             {
                 Nvm.MacGroup2.ChannelsDatarateDefault = verify.DatarateParams.Datarate;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             }
             else
             {
@@ -5739,6 +6318,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             if( RegionVerify( Nvm.MacGroup2.Region, &verify, PHY_TX_DR ) == true )
             {
                 Nvm.MacGroup1.ChannelsDatarate = verify.DatarateParams.Datarate;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
             }
             else
             {
@@ -5753,6 +6333,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             if( RegionVerify( Nvm.MacGroup2.Region, &verify, PHY_DEF_TX_POWER ) == true )
             {
                 Nvm.MacGroup2.ChannelsTxPowerDefault = verify.TxPower;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             }
             else
             {
@@ -5767,6 +6348,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             if( RegionVerify( Nvm.MacGroup2.Region, &verify, PHY_TX_POWER ) == true )
             {
                 Nvm.MacGroup1.ChannelsTxPower = verify.TxPower;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
             }
             else
             {
@@ -5780,6 +6362,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             if( mibSet->Param.SystemMaxRxError <= 500 )
             { // Only apply the new value if in range 0..500 ms else keep current value.
                 Nvm.MacGroup2.MacParams.SystemMaxRxError = Nvm.MacGroup2.MacParamsDefaults.SystemMaxRxError = mibSet->Param.SystemMaxRxError;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             }
             else
             {
@@ -5787,22 +6370,26 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             }
 #else
             Nvm.MacGroup2.MacParams.SystemMaxRxError = Nvm.MacGroup2.MacParamsDefaults.SystemMaxRxError = mibSet->Param.SystemMaxRxError;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
 #endif
             break;
         }
         case MIB_MIN_RX_SYMBOLS:
         {
             Nvm.MacGroup2.MacParams.MinRxSymbols = Nvm.MacGroup2.MacParamsDefaults.MinRxSymbols = mibSet->Param.MinRxSymbols;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_ANTENNA_GAIN:
         {
             Nvm.MacGroup2.MacParams.AntennaGain = mibSet->Param.AntennaGain;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_DEFAULT_ANTENNA_GAIN:
         {
             Nvm.MacGroup2.MacParamsDefaults.AntennaGain = mibSet->Param.DefaultAntennaGain;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_NVM_CTXS:
@@ -5815,6 +6402,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             if( mibSet->Param.AbpLrWanVersion.Fields.Minor <= 1 )
             {
                 Nvm.MacGroup2.Version = mibSet->Param.AbpLrWanVersion;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 | LORAMAC_NVM_NOTIFY_FLAG_CRYPTO );
 
                 if( LORAMAC_CRYPTO_SUCCESS != LoRaMacCryptoSetLrWanVersion( mibSet->Param.AbpLrWanVersion ) )
                 {
@@ -5830,12 +6418,14 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
         case MIB_RXB_C_TIMEOUT:
         {
             Nvm.MacGroup2.MacParams.RxBCTimeout = mibSet->Param.RxBCTimeout;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
 #if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
         case MIB_IS_CERT_FPORT_ON:
         {
             Nvm.MacGroup2.IsCertPortOn = mibSet->Param.IsCertPortOn;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
 #endif /* LORAMAC_VERSION */
@@ -5847,6 +6437,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 ( Nvm.MacGroup2.NetworkActivation == ACTIVATION_TYPE_OTAA ) )
             {
                 Nvm.MacGroup2.Rejoin0CycleInSec = mibSet->Param.Rejoin0CycleInSec;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
                 MacCtx.Rejoin0CycleTime = cycleTime;
                 TimerStop( &MacCtx.Rejoin0CycleTimer );
                 TimerSetValue( &MacCtx.Rejoin0CycleTimer, MacCtx.Rejoin0CycleTime );
@@ -5865,6 +6456,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
                 ( Nvm.MacGroup2.NetworkActivation == ACTIVATION_TYPE_OTAA ) )
             {
                 Nvm.MacGroup2.Rejoin1CycleInSec = mibSet->Param.Rejoin1CycleInSec;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
                 MacCtx.Rejoin0CycleTime = cycleTime;
                 TimerStop( &MacCtx.Rejoin1CycleTimer );
                 TimerSetValue( &MacCtx.Rejoin1CycleTimer, MacCtx.Rejoin1CycleTime );
@@ -5880,21 +6472,25 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
         case MIB_ADR_ACK_LIMIT:
         {
             Nvm.MacGroup2.MacParams.AdrAckLimit = mibSet->Param.AdrAckLimit;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_ADR_ACK_DELAY:
         {
             Nvm.MacGroup2.MacParams.AdrAckDelay = mibSet->Param.AdrAckDelay;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_ADR_ACK_DEFAULT_LIMIT:
         {
             Nvm.MacGroup2.MacParamsDefaults.AdrAckLimit = mibSet->Param.AdrAckLimit;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_ADR_ACK_DEFAULT_DELAY:
         {
             Nvm.MacGroup2.MacParamsDefaults.AdrAckDelay = mibSet->Param.AdrAckDelay;
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
             break;
         }
         case MIB_RSSI_FREE_THRESHOLD:
@@ -5907,6 +6503,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             else
             {
                 Nvm.RegionGroup2.RssiFreeThreshold = mibSet->Param.RssiFreeThreshold;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
             }
 #else
             status = LORAMAC_STATUS_ERROR;
@@ -5923,6 +6520,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
             else
             {
                 Nvm.RegionGroup2.CarrierSenseTime = mibSet->Param.CarrierSenseTime;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
             }
 #else
             status = LORAMAC_STATUS_ERROR;
@@ -5932,6 +6530,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t* mibSet )
         default:
         {
             status = LoRaMacMibClassBSetRequestConfirm( mibSet );
+            LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
             break;
         }
     }
@@ -5961,6 +6560,7 @@ LoRaMacStatus_t LoRaMacChannelAdd( uint8_t id, ChannelParams_t params )
 
     channelAdd.NewChannel = &params;
     channelAdd.ChannelId = id;
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
     return RegionChannelAdd( Nvm.MacGroup2.Region, &channelAdd );
 }
 
@@ -5977,6 +6577,7 @@ LoRaMacStatus_t LoRaMacChannelRemove( uint8_t id )
     }
 
     channelRemove.ChannelId = id;
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
 
     if( RegionChannelsRemove( Nvm.MacGroup2.Region, &channelRemove ) == false )
     {
@@ -5998,6 +6599,9 @@ LoRaMacStatus_t LoRaMacMcChannelSetup( McChannelParams_t *channel )
     }
 
     Nvm.MacGroup2.MulticastChannelList[channel->GroupID].ChannelParams = *channel;
+    // Multicast channel, keys and downlink counter
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CRYPTO | LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 |
+                        LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
     MacCtx.MacFlags.Bits.NvmHandle = 1;
 
     if( channel->IsRemotelySetup == true )
@@ -6048,6 +6652,7 @@ LoRaMacStatus_t LoRaMacMcChannelDelete( AddressIdentifier_t groupID )
     memset1( ( uint8_t* )&channel, 0, sizeof( McChannelParams_t ) );
 
     Nvm.MacGroup2.MulticastChannelList[groupID].ChannelParams = channel;
+    LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
     MacCtx.MacFlags.Bits.NvmHandle = 1;
     return LORAMAC_STATUS_OK;
 }
@@ -6120,6 +6725,7 @@ LoRaMacStatus_t LoRaMacMcChannelSetupRxParams( AddressIdentifier_t groupID, McRx
     {
         // Apply parameters
         Nvm.MacGroup2.MulticastChannelList[groupID].ChannelParams.RxParams = *rxParams;
+        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
         MacCtx.MacFlags.Bits.NvmHandle = 1;
     }
     else
@@ -6180,6 +6786,33 @@ LoRaMacStatus_t LoRaMacProcessMicForDatablock( uint8_t *buffer, uint32_t size, u
     return LORAMAC_STATUS_OK;
 }
 
+LoRaMacStatus_t LoRaMacStartMicForDatablock( CmacStreamCtx_t *ctx, uint32_t size, uint16_t sessionCnt, uint8_t fragIndex, uint32_t descriptor )
+{
+    if( LoRaMacCryptoStartDataBlock( ctx, size, sessionCnt, fragIndex, descriptor ) != LORAMAC_CRYPTO_SUCCESS )
+    {
+        return LORAMAC_STATUS_CRYPTO_ERROR;
+    }
+    return LORAMAC_STATUS_OK;
+}
+
+LoRaMacStatus_t LoRaMacUpdateMicForDatablock( CmacStreamCtx_t *ctx, uint8_t *buffer, uint32_t size )
+{
+    if( LoRaMacCryptoUpdateDataBlock( ctx, buffer, size ) != LORAMAC_CRYPTO_SUCCESS )
+    {
+        return LORAMAC_STATUS_CRYPTO_ERROR;
+    }
+    return LORAMAC_STATUS_OK;
+}
+
+LoRaMacStatus_t LoRaMacFinishMicForDatablock( CmacStreamCtx_t *ctx, uint32_t *mic )
+{
+    if( LoRaMacCryptoFinishDataBlock( ctx, mic ) != LORAMAC_CRYPTO_SUCCESS )
+    {
+        return LORAMAC_STATUS_CRYPTO_ERROR;
+    }
+    return LORAMAC_STATUS_OK;
+}
+
 LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_SERVICE_UNKNOWN;
@@ -6273,6 +6906,8 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest )
                 InitDefaultsParams_t params;
                 params.Type = INIT_TYPE_ACTIVATE_DEFAULT_CHANNELS;
                 RegionInitDefaults( Nvm.MacGroup2.Region, &params );
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 | LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 |
+                                    LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
 
                 Nvm.MacGroup2.NetworkActivation = mlmeRequest->Req.Join.NetworkActivation;
                 queueElement.Status = LORAMAC_EVENT_INFO_STATUS_OK;
@@ -6370,6 +7005,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t* mlmeRequest )
 
                 // LoRaMac will send this command piggy-pack
                 LoRaMacClassBSetPingSlotInfo( mlmeRequest->Req.PingSlotInfo.PingSlot.Fields.Periodicity );
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
                 macCmdPayload[0] = value;
                 status = LORAMAC_STATUS_OK;
                 if( LoRaMacCommandsAddCmd( MOTE_MAC_PING_SLOT_INFO_REQ, macCmdPayload, 1 ) != LORAMAC_COMMANDS_SUCCESS )
@@ -6525,6 +7161,7 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t* mcpsRequest, bool allowDelayedTx
             if( RegionVerify( Nvm.MacGroup2.Region, &verify, PHY_TX_DR ) == true )
             {
                 Nvm.MacGroup1.ChannelsDatarate = verify.DatarateParams.Datarate;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
             }
             else
             {
@@ -6635,6 +7272,7 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t* mcpsRequest, bool allowDelayedTx
             if( RegionVerify( Nvm.MacGroup2.Region, &verify, PHY_TX_DR ) == true )
             {
                 Nvm.MacGroup1.ChannelsDatarate = verify.DatarateParams.Datarate;
+                LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
             }
             else
             {
@@ -6733,6 +7371,11 @@ static void OnForceRejoinReqCycleTimerEvent( void* context )
 }
 #endif /* LORAMAC_VERSION */
 
+uint32_t LoRaMacTestGetPhyCacheRebuildCount( void )
+{
+    return MacCtx.PhyCache.RebuildCnt;
+}
+
 void LoRaMacTestSetDutyCycleOn( bool enable )
 {
     VerifyParams_t verify;
@@ -6742,6 +7385,7 @@ void LoRaMacTestSetDutyCycleOn( bool enable )
     if( RegionVerify( Nvm.MacGroup2.Region, &verify, PHY_DUTY_CYCLE ) == true )
     {
         Nvm.MacGroup2.DutyCycleOn = enable;
+        LoRaMacNvmSetDirty( LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
         // Handle NVM potential changes
         MacCtx.MacFlags.Bits.NvmHandle = 1;
     }
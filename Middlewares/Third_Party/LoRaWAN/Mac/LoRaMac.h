@@ -476,6 +476,50 @@ LoRaMacStatus_t LoRaMacDeInitialization( void );
 
 LoRaMacStatus_t LoRaMacProcessMicForDatablock( uint8_t *buffer, uint32_t size, uint16_t sessionCnt, uint8_t fragIndex, uint32_t descriptor, uint32_t *mic );
 
+/*!
+ * \brief   Starts the MIC of a data block computed as its bytes become available
+ *
+ * \details The data block is then given in order, in parts of any size, to
+ *          \ref LoRaMacUpdateMicForDatablock. The data block needs not be
+ *          memory mapped.
+ *
+ * \param   [out] ctx         - MIC context, released by \ref LoRaMacFinishMicForDatablock
+ * \param   [in] size         - Size of the whole data block
+ * \param   [in] sessionCnt   - Fragmentation session counter
+ * \param   [in] fragIndex    - Fragmentation index
+ * \param   [in] descriptor   - Free user descriptor
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. Possible returns are:
+ *          \ref LORAMAC_STATUS_OK,
+ *          \ref LORAMAC_STATUS_CRYPTO_ERROR.
+ */
+LoRaMacStatus_t LoRaMacStartMicForDatablock( CmacStreamCtx_t *ctx, uint32_t size, uint16_t sessionCnt, uint8_t fragIndex, uint32_t descriptor );
+
+/*!
+ * \brief   Adds the next bytes of a data block to its MIC
+ *
+ * \param   [in,out] ctx      - MIC context
+ * \param   [in] buffer       - Next bytes of the data block
+ * \param   [in] size         - Number of bytes
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. Possible returns are:
+ *          \ref LORAMAC_STATUS_OK,
+ *          \ref LORAMAC_STATUS_CRYPTO_ERROR.
+ */
+LoRaMacStatus_t LoRaMacUpdateMicForDatablock( CmacStreamCtx_t *ctx, uint8_t *buffer, uint32_t size );
+
+/*!
+ * \brief   Ends the MIC of a data block, also to be called to drop an unfinished MIC
+ *
+ * \param   [in,out] ctx      - MIC context
+ * \param   [out] mic         - Computed MIC
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. Possible returns are:
+ *          \ref LORAMAC_STATUS_OK,
+ *          \ref LORAMAC_STATUS_CRYPTO_ERROR.
+ */
+LoRaMacStatus_t LoRaMacFinishMicForDatablock( CmacStreamCtx_t *ctx, uint32_t *mic );
+
 
 /*!
  * \brief   Resets the internal state machine.
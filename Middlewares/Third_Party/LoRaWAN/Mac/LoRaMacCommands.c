@@ -49,6 +49,26 @@
  */
 #define CID_FIELD_SIZE 1
 
+/*!
+ * MAC command descriptor, indexed by CID
+ */
+typedef struct sMacCommandDescriptor
+{
+    /*
+     * Size of the command received from the server, including the CID.
+     * 0 if the command is unknown.
+     */
+    uint8_t SrvCmdSize;
+    /*
+     * The end-device command is sticky
+     */
+    bool IsSticky;
+    /*
+     * The end-device command requires an explicit confirmation
+     */
+    bool IsConfirmationRequired;
+} MacCommandDescriptor_t;
+
 /*!
  *  Mac Commands list structure
  */
@@ -77,6 +97,10 @@ typedef struct sLoRaMacCommandsCtx
      * Buffer to store MAC command elements
      */
     MacCommand_t MacCommandSlots[NUM_OF_MAC_COMMANDS];
+    /*
+     * Free bitmap of MacCommandSlots, a set bit is a free slot
+     */
+    uint32_t MacCommandSlotsFreeMap[SLOT_POOL_MAP_SIZE( NUM_OF_MAC_COMMANDS )];
     /*
      * Size of all MAC commands serialized as buffer
      */
@@ -88,26 +112,88 @@ typedef struct sLoRaMacCommandsCtx
  */
 static LoRaMacCommandsCtx_t CommandsCtx;
 
+/*!
+ * MAC command descriptors. A server command and the end-device command
+ * answering it, or being confirmed by it, share the same CID.
+ */
+static const MacCommandDescriptor_t MacCommandDescriptors[LORAMAC_COMMANDS_MAX_CID + 1] =
+{
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+    // ResetConf: cid + Serv_LoRaWAN_version
+    [SRV_MAC_RESET_CONF]            = { 2, true, true },
+#endif /* LORAMAC_VERSION */
+    // LinkCheckAns: cid + Margin + GwCnt
+    [SRV_MAC_LINK_CHECK_ANS]        = { 3, false, false },
+    // LinkAdrReq: cid + DataRate_TXPower + ChMask (2) + Redundancy
+    [SRV_MAC_LINK_ADR_REQ]          = { 5, false, false },
+    // DutyCycleReq: cid + DutyCyclePL
+    [SRV_MAC_DUTY_CYCLE_REQ]        = { 2, false, false },
+    // RxParamSetupReq: cid + DLsettings + Frequency (3)
+    [SRV_MAC_RX_PARAM_SETUP_REQ]    = { 5, true, false },
+    // DevStatusReq: cid
+    [SRV_MAC_DEV_STATUS_REQ]        = { 1, false, false },
+    // NewChannelReq: cid + ChIndex + Frequency (3) + DrRange
+    [SRV_MAC_NEW_CHANNEL_REQ]       = { 6, false, false },
+    // RxTimingSetupReq: cid + Settings
+    [SRV_MAC_RX_TIMING_SETUP_REQ]   = { 2, true, false },
+    // TxParamSetupReq: cid + EIRP_DwellTime
+    [SRV_MAC_TX_PARAM_SETUP_REQ]    = { 2, true, false },
+    // DlChannelReq: cid + ChIndex + Frequency (3)
+    [SRV_MAC_DL_CHANNEL_REQ]        = { 5, true, false },
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+    // RekeyConf: cid + Serv_LoRaWAN_version
+    [SRV_MAC_REKEY_CONF]            = { 2, true, true },
+    // AdrParamSetupReq: cid + ADRparam
+    [SRV_MAC_ADR_PARAM_SETUP_REQ]   = { 2, false, false },
+#endif /* LORAMAC_VERSION */
+    // DeviceTimeAns: cid + Seconds (4) + Fractional seconds (1)
+    [SRV_MAC_DEVICE_TIME_ANS]       = { 6, false, false },
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+    // ForceRejoinReq: cid + Payload (2)
+    [SRV_MAC_FORCE_REJOIN_REQ]      = { 3, false, false },
+    // RejoinParamSetupReq: cid + Payload (1)
+    [SRV_MAC_REJOIN_PARAM_REQ]      = { 2, false, false },
+#endif /* LORAMAC_VERSION */
+    // PingSlotInfoAns: cid
+    [SRV_MAC_PING_SLOT_INFO_ANS]    = { 1, false, false },
+    // PingSlotChannelReq: cid + Frequency (3) + DR
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01000300 ))
+    [SRV_MAC_PING_SLOT_CHANNEL_REQ] = { 5, false, false },
+#elif (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
+    [SRV_MAC_PING_SLOT_CHANNEL_REQ] = { 5, true, false },
+#endif /* LORAMAC_VERSION */
+    // BeaconTimingAns: cid + TimingDelay (2) + Channel
+    [SRV_MAC_BEACON_TIMING_ANS]     = { 4, false, false },
+    // BeaconFreqReq: cid + Frequency (3)
+    [SRV_MAC_BEACON_FREQ_REQ]       = { 4, false, false },
+#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
+    // DeviceModeConf: cid + Class
+    [SRV_MAC_DEVICE_MODE_CONF]      = { 2, true, true },
+#endif /* LORAMAC_VERSION */
+};
+
 /* Memory management functions */
 
 /*!
- * \brief Determines if a MAC command slot is free
+ * \brief Returns the index of an allocated MAC command slot
  *
  * \param [in]    slot           - Slot to check
- * \retval                       - Status of the operation
+ * \retval                       - Slot index, -1 if it is not an allocated slot
  */
-static bool IsSlotFree( const MacCommand_t* slot )
+static int16_t GetMacCommandSlotIndex( const MacCommand_t* slot )
 {
-    uint8_t* mem = ( uint8_t* )slot;
+    if( ( slot < CommandsCtx.MacCommandSlots ) || ( slot >= &CommandsCtx.MacCommandSlots[NUM_OF_MAC_COMMANDS] ) )
+    {
+        return -1;
+    }
+
+    int16_t index = ( int16_t )( slot - CommandsCtx.MacCommandSlots );
 
-    for( uint16_t size = 0; size < sizeof( MacCommand_t ); size++ )
+    if( SlotPoolIsAllocated( CommandsCtx.MacCommandSlotsFreeMap, index ) == false )
     {
-        if( mem[size] != 0x00 )
-        {
-            return false;
-        }
+        return -1;
     }
-    return true;
+    return index;
 }
 
 /*!
@@ -117,18 +203,14 @@ static bool IsSlotFree( const MacCommand_t* slot )
  */
 static MacCommand_t* MallocNewMacCommandSlot( void )
 {
-    uint8_t itr = 0;
+    int16_t index = SlotPoolAlloc( CommandsCtx.MacCommandSlotsFreeMap, NUM_OF_MAC_COMMANDS );
 
-    while( IsSlotFree( ( const MacCommand_t* )&CommandsCtx.MacCommandSlots[itr] ) == false )
+    if( index < 0 )
     {
-        itr++;
-        if( itr == NUM_OF_MAC_COMMANDS )
-        {
-            return NULL;
-        }
+        return NULL;
     }
 
-    return &CommandsCtx.MacCommandSlots[itr];
+    return &CommandsCtx.MacCommandSlots[index];
 }
 
 /*!
@@ -140,12 +222,14 @@ static MacCommand_t* MallocNewMacCommandSlot( void )
  */
 static bool FreeMacCommandSlot( MacCommand_t* slot )
 {
-    if( slot == NULL )
+    int16_t index = GetMacCommandSlotIndex( slot );
+
+    if( index < 0 )
     {
         return false;
     }
 
-    memset1( ( uint8_t* )slot, 0x00, sizeof( MacCommand_t ) );
+    SlotPoolFree( CommandsCtx.MacCommandSlotsFreeMap, index );
 
     return true;
 }
@@ -197,8 +281,9 @@ static bool LinkedListAdd( MacCommandsList_t* list, MacCommand_t* element )
         list->Last->Next = element;
     }
 
-    // Update the next point of this entry.
+    // Update the next and previous points of this entry.
     element->Next = NULL;
+    element->Prev = list->Last;
 
     // Update the last entry of the list.
     list->Last = element;
@@ -206,42 +291,6 @@ static bool LinkedListAdd( MacCommandsList_t* list, MacCommand_t* element )
     return true;
 }
 
-/*!
- * \brief Return the previous element in the list.
- *
- * \param [in]    list           - List
- * \param [in]    element        - Element where the previous element shall be searched
- * \retval                       - Status of the operation
- */
-static MacCommand_t* LinkedListGetPrevious( MacCommandsList_t* list, MacCommand_t* element )
-{
-    if( ( list == NULL ) || ( element == NULL ) )
-    {
-        return NULL;
-    }
-
-    MacCommand_t* curElement;
-
-    // Start at the head of the list
-    curElement = list->First;
-
-    // When current element is the first of the list, there's no previous element so we can return NULL immediately.
-    if( element != curElement )
-    {
-        // Loop through all elements until the end is reached or the next of current is the current element.
-        while( ( curElement != NULL ) && ( curElement->Next != element ) )
-        {
-            curElement = curElement->Next;
-        }
-    }
-    else
-    {
-        curElement = NULL;
-    }
-
-    return curElement;
-}
-
 /*!
  * \brief Remove an element from the list
  *
@@ -256,24 +305,26 @@ static bool LinkedListRemove( MacCommandsList_t* list, MacCommand_t* element )
         return false;
     }
 
-    MacCommand_t* PrevElement = LinkedListGetPrevious( list, element );
-
     if( list->First == element )
     {
         list->First = element->Next;
     }
+    else
+    {
+        element->Prev->Next = element->Next;
+    }
 
     if( list->Last == element )
     {
-        list->Last = PrevElement;
+        list->Last = element->Prev;
     }
-
-    if( PrevElement != NULL )
+    else
     {
-        PrevElement->Next = element->Next;
+        element->Next->Prev = element->Prev;
     }
 
     element->Next = NULL;
+    element->Prev = NULL;
 
     return true;
 }
@@ -287,24 +338,11 @@ static bool LinkedListRemove( MacCommandsList_t* list, MacCommand_t* element )
  */
 static bool IsSticky( uint8_t cid )
 {
-    switch( cid )
+    if( cid > LORAMAC_COMMANDS_MAX_CID )
     {
-#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
-        case MOTE_MAC_RESET_IND:
-        case MOTE_MAC_REKEY_IND:
-        case MOTE_MAC_DEVICE_MODE_IND:
-#endif /* LORAMAC_VERSION */
-        case MOTE_MAC_DL_CHANNEL_ANS:
-        case MOTE_MAC_RX_PARAM_SETUP_ANS:
-        case MOTE_MAC_RX_TIMING_SETUP_ANS:
-        case MOTE_MAC_TX_PARAM_SETUP_ANS:
-#if (defined( LORAMAC_VERSION ) && (( LORAMAC_VERSION == 0x01000400 ) || ( LORAMAC_VERSION == 0x01010100 )))
-        case MOTE_MAC_PING_SLOT_CHANNEL_ANS:
-#endif /* LORAMAC_VERSION */
-            return true;
-        default:
-            return false;
+        return false;
     }
+    return MacCommandDescriptors[cid].IsSticky;
 }
 
 /*
@@ -316,17 +354,11 @@ static bool IsSticky( uint8_t cid )
  */
 static bool IsConfirmationRequired( uint8_t cid )
 {
-    switch( cid )
+    if( cid > LORAMAC_COMMANDS_MAX_CID )
     {
-#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
-        case MOTE_MAC_RESET_IND:
-        case MOTE_MAC_REKEY_IND:
-        case MOTE_MAC_DEVICE_MODE_IND:
-            return true;
-#endif /* LORAMAC_VERSION */
-        default:
-            return false;
+        return false;
     }
+    return MacCommandDescriptors[cid].IsConfirmationRequired;
 }
 
 LoRaMacCommandStatus_t LoRaMacCommandsInit( void )
@@ -334,6 +366,8 @@ LoRaMacCommandStatus_t LoRaMacCommandsInit( void )
     // Initialize with default
     memset1( ( uint8_t* )&CommandsCtx, 0, sizeof( CommandsCtx ) );
 
+    SlotPoolInit( CommandsCtx.MacCommandSlotsFreeMap, NUM_OF_MAC_COMMANDS );
+
     LinkedListInit( &CommandsCtx.MacCommandList );
 
     return LORAMAC_COMMANDS_SUCCESS;
@@ -380,6 +414,12 @@ LoRaMacCommandStatus_t LoRaMacCommandsRemoveCmd( MacCommand_t* macCmd )
         return LORAMAC_COMMANDS_ERROR_NPE;
     }
 
+    // Only commands held in the slots are in the list
+    if( GetMacCommandSlotIndex( macCmd ) < 0 )
+    {
+        return LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND;
+    }
+
     // Remove the Mac command element from MacCommandList
     if( LinkedListRemove( &CommandsCtx.MacCommandList, macCmd ) == false )
     {
@@ -525,140 +565,10 @@ LoRaMacCommandStatus_t LoRaMacCommandsSerializeCmds( size_t availableSize, size_
 
 uint8_t LoRaMacCommandsGetCmdSize( uint8_t cid )
 {
-    uint8_t cidSize = 0;
-
-    // Decode Frame MAC commands
-    switch( cid )
+    if( cid > LORAMAC_COMMANDS_MAX_CID )
     {
-#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
-        case SRV_MAC_RESET_CONF:
-        {
-            // cid + Serv_LoRaWAN_version
-            cidSize = 2;
-            break;
-        }
-#endif /* LORAMAC_VERSION */
-        case SRV_MAC_LINK_CHECK_ANS:
-        {
-            // cid + Margin + GwCnt
-            cidSize = 3;
-            break;
-        }
-        case SRV_MAC_LINK_ADR_REQ:
-        {
-            // cid + DataRate_TXPower + ChMask (2) + Redundancy
-            cidSize = 5;
-            break;
-        }
-        case SRV_MAC_DUTY_CYCLE_REQ:
-        {
-            // cid + DutyCyclePL
-            cidSize = 2;
-            break;
-        }
-        case SRV_MAC_RX_PARAM_SETUP_REQ:
-        {
-            // cid + DLsettings + Frequency (3)
-            cidSize = 5;
-            break;
-        }
-        case SRV_MAC_DEV_STATUS_REQ:
-        {
-            // cid
-            cidSize = 1;
-            break;
-        }
-        case SRV_MAC_NEW_CHANNEL_REQ:
-        {
-            // cid + ChIndex + Frequency (3) + DrRange
-            cidSize = 6;
-            break;
-        }
-        case SRV_MAC_RX_TIMING_SETUP_REQ:
-        {
-            // cid + Settings
-            cidSize = 2;
-            break;
-        }
-        case SRV_MAC_TX_PARAM_SETUP_REQ:
-        {
-            // cid + EIRP_DwellTime
-            cidSize = 2;
-            break;
-        }
-        case SRV_MAC_DL_CHANNEL_REQ:
-        {
-            // cid + ChIndex + Frequency (3)
-            cidSize = 5;
-            break;
-        }
-#if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
-        case SRV_MAC_REKEY_CONF:
-        {
-            // cid + Serv_LoRaWAN_version
-            cidSize = 2;
-            break;
-        }
-        case SRV_MAC_ADR_PARAM_SETUP_REQ:
-        {
-            // cid + ADRparam
-            cidSize = 2;
-            break;
-        }
-        case SRV_MAC_FORCE_REJOIN_REQ:
-        {
-            // cid + Payload (2)
-            cidSize = 3;
-            break;
-        }
-        case SRV_MAC_REJOIN_PARAM_REQ:
-        {
-            // cid + Payload (1)
-            cidSize = 2;
-            break;
-        }
-        case SRV_MAC_DEVICE_MODE_CONF:
-        {
-            // cid + Class
-            cidSize = 2;
-            break;
-        }
-#endif /* LORAMAC_VERSION */
-        case SRV_MAC_DEVICE_TIME_ANS:
-        {
-            // cid + Seconds (4) + Fractional seconds (1)
-            cidSize = 6;
-            break;
-        }
-        case SRV_MAC_PING_SLOT_INFO_ANS:
-        {
-            // cid
-            cidSize = 1;
-            break;
-        }
-        case SRV_MAC_PING_SLOT_CHANNEL_REQ:
-        {
-            // cid + Frequency (3) + DR
-            cidSize = 5;
-            break;
-        }
-        case SRV_MAC_BEACON_TIMING_ANS:
-        {
-            // cid + TimingDelay (2) + Channel
-            cidSize = 4;
-            break;
-        }
-        case SRV_MAC_BEACON_FREQ_REQ:
-        {
-            // cid + Frequency (3)
-            cidSize = 4;
-            break;
-        }
-        default:
-        {
-            // Unknown command. ABORT MAC commands processing
-            break;
-        }
+        // Unknown command
+        return 0;
     }
-    return cidSize;
+    return MacCommandDescriptors[cid].SrvCmdSize;
 }
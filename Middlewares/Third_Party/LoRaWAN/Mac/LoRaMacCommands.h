@@ -47,6 +47,11 @@ extern "C"
  */
 #define LORAMAC_COMMADS_MAX_NUM_OF_PARAMS   2
 
+/*!
+ * Highest MAC command identifier, see LoRaMacMoteCmd_t and LoRaMacSrvCmd_t
+ */
+#define LORAMAC_COMMANDS_MAX_CID            0x20
+
 /*!
  * LoRaWAN MAC Command element
  */
@@ -58,6 +63,10 @@ struct sMacCommand
      *  The pointer to the next MAC Command element in the list
      */
     MacCommand_t* Next;
+    /*!
+     *  The pointer to the previous MAC Command element in the list
+     */
+    MacCommand_t* Prev;
     /*!
      * MAC command identifier
      */
@@ -193,7 +202,8 @@ LoRaMacCommandStatus_t LoRaMacCommandsSerializeCmds( size_t availableSize, size_
  *
  * \param [in]  cid            - MAC command identifier
  *
- * \retval Size of the command.
+ * \retval Size of the command received from the server, including the CID.
+ *         0 if the command is unknown.
  */
 uint8_t LoRaMacCommandsGetCmdSize( uint8_t cid );
 
@@ -149,9 +149,6 @@ static LoRaMacCryptoStatus_t PayloadEncrypt( uint8_t* buffer, int16_t size, KeyI
         return LORAMAC_CRYPTO_ERROR_NPE;
     }
 
-    uint8_t bufferIndex = 0;
-    uint16_t ctr = 1;
-    uint8_t sBlock[16] = { 0 };
     uint8_t aBlock[16] = { 0 };
 
     aBlock[0] = 0x01;
@@ -168,21 +165,13 @@ static LoRaMacCryptoStatus_t PayloadEncrypt( uint8_t* buffer, int16_t size, KeyI
     aBlock[12] = ( frameCounter >> 16 ) & 0xFF;
     aBlock[13] = ( frameCounter >> 24 ) & 0xFF;
 
-    while( size > 0 )
+    if( size > 0 )
     {
-        aBlock[15] = ctr & 0xFF;
-        ctr++;
-        if( SecureElementAesEncrypt( aBlock, 16, keyID, sBlock ) != SECURE_ELEMENT_SUCCESS )
+        // Ai blocks are numbered from 1, the whole payload is processed under one key schedule
+        if( SecureElementAesCtrXor( keyID, aBlock, 1, buffer, ( uint32_t )size ) != SECURE_ELEMENT_SUCCESS )
         {
             return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
         }
-
-        for( uint8_t i = 0; i < ( ( size > 16 ) ? 16 : size ); i++ )
-        {
-            buffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
-        }
-        size -= 16;
-        bufferIndex += 16;
     }
 
     return LORAMAC_CRYPTO_SUCCESS;
@@ -207,8 +196,6 @@ static LoRaMacCryptoStatus_t FOptsEncrypt( uint16_t size, uint32_t address, uint
         return LORAMAC_CRYPTO_ERROR_NPE;
     }
 
-    uint8_t bufferIndex = 0;
-    uint8_t sBlock[16] = { 0 };
     uint8_t aBlock[16] = { 0 };
 
     aBlock[0] = 0x01;
@@ -258,14 +245,10 @@ static LoRaMacCryptoStatus_t FOptsEncrypt( uint16_t size, uint32_t address, uint
 
     if( size > 0 )
     {
-        if( SecureElementAesEncrypt( aBlock, 16, NWK_S_ENC_KEY, sBlock ) != SECURE_ELEMENT_SUCCESS )
+        if( SecureElementAesCtrXor( NWK_S_ENC_KEY, aBlock, aBlock[15], buffer, size ) != SECURE_ELEMENT_SUCCESS )
         {
             return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
         }
-        for( uint8_t i = 0; i < size; i++ )
-        {
-            buffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
-        }
     }
 
     return LORAMAC_CRYPTO_SUCCESS;
@@ -386,37 +369,20 @@ static LoRaMacCryptoStatus_t ComputeCmacB0( uint8_t* msg, uint16_t len, KeyIdent
  */
 static LoRaMacCryptoStatus_t VerifyCmacB0( uint8_t* msg, uint16_t len, KeyIdentifier_t keyID, bool isAck, uint8_t dir, uint32_t devAddr, uint32_t fCnt, uint32_t expectedCmac )
 {
-    if( msg == 0 )
-    {
-        return LORAMAC_CRYPTO_ERROR_NPE;
-    }
-    if( len > CRYPTO_MAXMESSAGE_SIZE )
-    {
-        return LORAMAC_CRYPTO_ERROR_BUF_SIZE;
-    }
-
-    uint8_t micBuff[CRYPTO_BUFFER_SIZE];
-    memset1( micBuff, 0, CRYPTO_BUFFER_SIZE );
+    uint32_t cmac = 0;
 
-    // Initialize the first Block
-    PrepareB0( len, keyID, isAck, dir, devAddr, fCnt, micBuff );
-
-    // Copy the given data to the mic computation buffer
-    memcpy1( ( micBuff + MIC_BLOCK_BX_SIZE ), msg, len );
-
-    SecureElementStatus_t retval = SECURE_ELEMENT_ERROR;
-    retval = SecureElementVerifyAesCmac( micBuff, ( len + MIC_BLOCK_BX_SIZE ), expectedCmac, keyID );
-
-    if( retval == SECURE_ELEMENT_SUCCESS )
+    // The B0 block is passed apart from the message, the message is not copied
+    LoRaMacCryptoStatus_t retval = ComputeCmacB0( msg, len, keyID, isAck, dir, devAddr, fCnt, &cmac );
+    if( retval != LORAMAC_CRYPTO_SUCCESS )
     {
-        return LORAMAC_CRYPTO_SUCCESS;
+        return retval;
     }
-    else if( retval == SECURE_ELEMENT_FAIL_CMAC )
+
+    if( cmac != expectedCmac )
     {
         return LORAMAC_CRYPTO_FAIL_MIC;
     }
-
-    return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
+    return LORAMAC_CRYPTO_SUCCESS;
 }
 
 #if (defined( LORAMAC_VERSION ) && ( LORAMAC_VERSION == 0x01010100 ))
@@ -1537,11 +1503,11 @@ LoRaMacCryptoStatus_t LoRaMacCryptoSecureMessage( uint32_t fCntUp, uint8_t txDr,
         }
     }
 
-    // Re-serialize message to add the MIC
-    if( LoRaMacSerializerData( macMsg ) != LORAMAC_SERIALIZER_SUCCESS )
-    {
-        return LORAMAC_CRYPTO_ERROR_SERIALIZER;
-    }
+    // Add the MIC, the rest of the message is already serialized
+    macMsg->Buffer[macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE] = macMsg->MIC & 0xFF;
+    macMsg->Buffer[macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE + 1] = ( macMsg->MIC >> 8 ) & 0xFF;
+    macMsg->Buffer[macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE + 2] = ( macMsg->MIC >> 16 ) & 0xFF;
+    macMsg->Buffer[macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE + 3] = ( macMsg->MIC >> 24 ) & 0xFF;
 
     CryptoNvm->FCntList.FCntUp = fCntUp;
 
@@ -1656,6 +1622,43 @@ LoRaMacCryptoStatus_t LoRaMacCryptoComputeDataBlock( uint8_t *buffer, uint32_t s
     return LORAMAC_CRYPTO_SUCCESS;
 }
 
+LoRaMacCryptoStatus_t LoRaMacCryptoStartDataBlock( CmacStreamCtx_t *ctx, uint32_t size, uint16_t sessionCnt, uint8_t fragIndex, uint32_t descriptor )
+{
+    uint8_t micBuff[MIC_BLOCK_BX_SIZE] ALIGN(4);
+
+    if( ctx == 0 )
+    {
+        return LORAMAC_CRYPTO_ERROR_NPE;
+    }
+
+    // Initialize the first Block, it carries the size of the whole data block
+    PrepareB0ForDataBlock( sessionCnt, fragIndex, descriptor, size, micBuff );
+
+    if( SecureElementAesCmacStreamStart( ctx, micBuff, DATABLOCK_INT_KEY ) != SECURE_ELEMENT_SUCCESS )
+    {
+        return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
+    }
+    return LORAMAC_CRYPTO_SUCCESS;
+}
+
+LoRaMacCryptoStatus_t LoRaMacCryptoUpdateDataBlock( CmacStreamCtx_t *ctx, uint8_t *buffer, uint32_t size )
+{
+    if( SecureElementAesCmacStreamUpdate( ctx, buffer, size ) != SECURE_ELEMENT_SUCCESS )
+    {
+        return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
+    }
+    return LORAMAC_CRYPTO_SUCCESS;
+}
+
+LoRaMacCryptoStatus_t LoRaMacCryptoFinishDataBlock( CmacStreamCtx_t *ctx, uint32_t *cmac )
+{
+    if( SecureElementAesCmacStreamFinish( ctx, cmac ) != SECURE_ELEMENT_SUCCESS )
+    {
+        return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
+    }
+    return LORAMAC_CRYPTO_SUCCESS;
+}
+
 LoRaMacCryptoStatus_t LoRaMacCryptoDeriveLifeTimeKey( uint8_t versionMinor, KeyIdentifier_t keyID )
 {
     uint8_t compBase[16] = { 0 };
@@ -314,6 +314,39 @@ LoRaMacCryptoStatus_t LoRaMacCryptoSecureMessage( uint32_t fCntUp, uint8_t txDr,
 LoRaMacCryptoStatus_t LoRaMacCryptoUnsecureMessage( AddressIdentifier_t addrID, uint32_t address, FCntIdentifier_t fCntID, uint32_t fCntDown, LoRaMacMessageData_t* macMsg );
 
 LoRaMacCryptoStatus_t LoRaMacCryptoComputeDataBlock( uint8_t *buffer, uint32_t size, uint16_t sessionCnt, uint8_t fragIndex, uint32_t descriptor, uint32_t *cmac );
+
+/*!
+ * Starts the integrity code of a data block computed over several calls
+ *
+ *  cmac = aes128_cmac(DataBlockIntKey, B0 | data block)
+ *
+ * \param [out]   ctx             - CMAC context, see \ref LoRaMacCryptoFinishDataBlock
+ * \param [in]    size            - Size of the whole data block
+ * \param [in]    sessionCnt      - Fragmentation session counter
+ * \param [in]    fragIndex       - Fragmentation index
+ * \param [in]    descriptor      - Free user descriptor
+ * \retval                        - Status of the operation
+ */
+LoRaMacCryptoStatus_t LoRaMacCryptoStartDataBlock( CmacStreamCtx_t *ctx, uint32_t size, uint16_t sessionCnt, uint8_t fragIndex, uint32_t descriptor );
+
+/*!
+ * Adds the next bytes of the data block to its integrity code
+ *
+ * \param [in,out] ctx            - CMAC context
+ * \param [in]    buffer          - Next bytes of the data block
+ * \param [in]    size            - Number of bytes
+ * \retval                        - Status of the operation
+ */
+LoRaMacCryptoStatus_t LoRaMacCryptoUpdateDataBlock( CmacStreamCtx_t *ctx, uint8_t *buffer, uint32_t size );
+
+/*!
+ * Ends the integrity code of a data block and releases its context
+ *
+ * \param [in,out] ctx            - CMAC context
+ * \param [out]   cmac            - Computed cmac
+ * \retval                        - Status of the operation
+ */
+LoRaMacCryptoStatus_t LoRaMacCryptoFinishDataBlock( CmacStreamCtx_t *ctx, uint32_t *cmac );
    
 /*!
  * Derives the LifeTime keys
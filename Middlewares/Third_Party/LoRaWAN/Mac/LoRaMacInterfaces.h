@@ -1490,6 +1490,12 @@ typedef struct sMcpsIndication
     uint8_t IsUplinkTxPending;
     /*!
      * Pointer to the received data stream
+     *
+     * \remark In class A and B the data is not copied, Buffer points into the
+     *         radio reception buffer. In class C, where the radio keeps
+     *         receiving, it points into a copy of the frame owned by the MAC
+     *         layer. In both cases it is only valid until MacMcpsIndication
+     *         returns, the upper layer must copy the data it needs to keep.
      */
     uint8_t* Buffer;
     /*!
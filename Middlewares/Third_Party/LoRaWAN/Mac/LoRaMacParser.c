@@ -110,10 +110,12 @@ LoRaMacParserStatus_t LoRaMacParserData( LoRaMacMessageData_t* macMsg )
         macMsg->FPort = macMsg->Buffer[bufItr++];
 
         macMsg->FRMPayloadSize = ( macMsg->BufSize - bufItr - LORAMAC_MIC_FIELD_SIZE );
-        memcpy1( macMsg->FRMPayload, &macMsg->Buffer[bufItr], macMsg->FRMPayloadSize );
-        bufItr = bufItr + macMsg->FRMPayloadSize;
     }
 
+    // FRMPayload is a view into the serialized message, the payload is not copied.
+    macMsg->FRMPayload = &macMsg->Buffer[bufItr];
+    bufItr = bufItr + macMsg->FRMPayloadSize;
+
     macMsg->MIC = ( uint32_t ) macMsg->Buffer[( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE )];
     macMsg->MIC |= ( ( uint32_t ) macMsg->Buffer[( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE ) + 1] << 8 );
     macMsg->MIC |= ( ( uint32_t ) macMsg->Buffer[( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE ) + 2] << 16 );
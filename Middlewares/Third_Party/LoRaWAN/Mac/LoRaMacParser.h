@@ -78,6 +78,9 @@ LoRaMacParserStatus_t LoRaMacParserJoinAccept( LoRaMacMessageJoinAccept_t *macMs
 /*!
  * Parse a serialized data message and fills the structured object.
  *
+ * \remark FRMPayload is set to point into macMsg->Buffer, the frame payload
+ *         is not copied. It is only valid as long as Buffer is.
+ *
  * \param [in,out] macMsg      - Data message object
  * \retval                     - Status of the operation
  */
@@ -51,6 +51,14 @@ extern "C"
  */
 void LoRaMacTestSetDutyCycleOn( bool enable );
 
+/*!
+ * \brief   Gets the number of rebuilds of the PHY parameters snapshot
+ * \details This is a test function. It shall be used for debug purposes only,
+ *          to check that the snapshot is not rebuilt on every frame.
+ * \retval  Number of rebuilds since the initialization of the LoRaMac
+ */
+uint32_t LoRaMacTestGetPhyCacheRebuildCount( void );
+
 /*! \} defgroup LORAMACTEST */
 
 #ifdef __cplusplus
@@ -311,6 +311,34 @@ typedef enum eKeyIdentifier
     NO_KEY,
 }KeyIdentifier_t;
 
+/*!
+ * Context of an AES CMAC computed over several calls, only handled by the
+ * secure element
+ */
+typedef struct sCmacStreamCtx
+{
+    /*!
+     * CBC-MAC of the blocks already processed
+     */
+    uint8_t X[16];
+    /*!
+     * Pending bytes of the last block, processed on the next call or at the end
+     */
+    uint8_t Last[16];
+    /*!
+     * Number of pending bytes in Last
+     */
+    uint8_t LastSize;
+    /*!
+     * Key identifier of the CMAC
+     */
+    KeyIdentifier_t KeyID;
+    /*!
+     * KMS session running the CMAC, LORAWAN_KMS == 1 only
+     */
+    uint32_t Session;
+}CmacStreamCtx_t;
+
 /*!
  * LoRaMac Crypto address identifier
  */
@@ -587,6 +587,47 @@
 #define RU864_RX_BEACON_SETUP( )
 #endif
 
+/*!
+ * Binds the region API statically when a single region is linked in the MW code.
+ * The region parameter is then ignored, LoRaMacInitialization having already
+ * rejected any other region through RegionIsActive, and the switch below folds
+ * into a direct call. Set to 0 to keep the switch on the region parameter.
+ * \remark Can be overloaded in lorawan_conf.h
+ */
+#ifndef REGION_SINGLE_STATIC_DISPATCH
+#define REGION_SINGLE_STATIC_DISPATCH               1
+#endif /* REGION_SINGLE_STATIC_DISPATCH */
+
+#if ( REGION_SINGLE_STATIC_DISPATCH == 1 ) && \
+    ( ( defined( REGION_AS923 ) + defined( REGION_AU915 ) + defined( REGION_CN470 ) + defined( REGION_CN779 ) + \
+        defined( REGION_EU433 ) + defined( REGION_EU868 ) + defined( REGION_KR920 ) + defined( REGION_IN865 ) + \
+        defined( REGION_US915 ) + defined( REGION_RU864 ) ) == 1 )
+#if defined( REGION_AS923 )
+#define REGION_SINGLE                               LORAMAC_REGION_AS923
+#elif defined( REGION_AU915 )
+#define REGION_SINGLE                               LORAMAC_REGION_AU915
+#elif defined( REGION_CN470 )
+#define REGION_SINGLE                               LORAMAC_REGION_CN470
+#elif defined( REGION_CN779 )
+#define REGION_SINGLE                               LORAMAC_REGION_CN779
+#elif defined( REGION_EU433 )
+#define REGION_SINGLE                               LORAMAC_REGION_EU433
+#elif defined( REGION_EU868 )
+#define REGION_SINGLE                               LORAMAC_REGION_EU868
+#elif defined( REGION_KR920 )
+#define REGION_SINGLE                               LORAMAC_REGION_KR920
+#elif defined( REGION_IN865 )
+#define REGION_SINGLE                               LORAMAC_REGION_IN865
+#elif defined( REGION_US915 )
+#define REGION_SINGLE                               LORAMAC_REGION_US915
+#else
+#define REGION_SINGLE                               LORAMAC_REGION_RU864
+#endif /* REGION_XXX */
+#define REGION_DISPATCH( region )                   ( ( void )( region ), REGION_SINGLE )
+#else
+#define REGION_DISPATCH( region )                   ( region )
+#endif /* REGION_SINGLE_STATIC_DISPATCH */
+
 bool RegionIsActive( LoRaMacRegion_t region )
 {
     switch( region )
@@ -611,7 +652,7 @@ bool RegionIsActive( LoRaMacRegion_t region )
 PhyParam_t RegionGetPhyParam( LoRaMacRegion_t region, GetPhyParams_t* getPhy )
 {
     PhyParam_t phyParam = { 0 };
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_GET_PHY_PARAM( );
         AU915_GET_PHY_PARAM( );
@@ -632,7 +673,7 @@ PhyParam_t RegionGetPhyParam( LoRaMacRegion_t region, GetPhyParams_t* getPhy )
 
 void RegionSetBandTxDone( LoRaMacRegion_t region, SetBandTxDoneParams_t* txDone )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_SET_BAND_TX_DONE( );
         AU915_SET_BAND_TX_DONE( );
@@ -653,7 +694,7 @@ void RegionSetBandTxDone( LoRaMacRegion_t region, SetBandTxDoneParams_t* txDone
 
 void RegionInitDefaults( LoRaMacRegion_t region, InitDefaultsParams_t* params )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_INIT_DEFAULTS( );
         AU915_INIT_DEFAULTS( );
@@ -674,7 +715,7 @@ void RegionInitDefaults( LoRaMacRegion_t region, InitDefaultsParams_t* params )
 
 bool RegionVerify( LoRaMacRegion_t region, VerifyParams_t* verify, PhyAttribute_t phyAttribute )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_VERIFY( );
         AU915_VERIFY( );
@@ -695,7 +736,7 @@ bool RegionVerify( LoRaMacRegion_t region, VerifyParams_t* verify, PhyAttribute_
 
 void RegionApplyCFList( LoRaMacRegion_t region, ApplyCFListParams_t* applyCFList )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_APPLY_CF_LIST( );
         AU915_APPLY_CF_LIST( );
@@ -716,7 +757,7 @@ void RegionApplyCFList( LoRaMacRegion_t region, ApplyCFListParams_t* applyCFList
 
 bool RegionChanMaskSet( LoRaMacRegion_t region, ChanMaskSetParams_t* chanMaskSet )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_CHAN_MASK_SET( );
         AU915_CHAN_MASK_SET( );
@@ -737,7 +778,7 @@ bool RegionChanMaskSet( LoRaMacRegion_t region, ChanMaskSetParams_t* chanMaskSet
 
 void RegionComputeRxWindowParameters( LoRaMacRegion_t region, int8_t datarate, uint8_t minRxSymbols, uint32_t rxError, RxConfigParams_t *rxConfigParams )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_COMPUTE_RX_WINDOW_PARAMETERS( );
         AU915_COMPUTE_RX_WINDOW_PARAMETERS( );
@@ -758,7 +799,7 @@ void RegionComputeRxWindowParameters( LoRaMacRegion_t region, int8_t datarate, u
 
 bool RegionRxConfig( LoRaMacRegion_t region, RxConfigParams_t* rxConfig, int8_t* datarate )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_RX_CONFIG( );
         AU915_RX_CONFIG( );
@@ -779,7 +820,7 @@ bool RegionRxConfig( LoRaMacRegion_t region, RxConfigParams_t* rxConfig, int8_t*
 
 bool RegionTxConfig( LoRaMacRegion_t region, TxConfigParams_t* txConfig, int8_t* txPower, TimerTime_t* txTimeOnAir )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_TX_CONFIG( );
         AU915_TX_CONFIG( );
@@ -800,7 +841,7 @@ bool RegionTxConfig( LoRaMacRegion_t region, TxConfigParams_t* txConfig, int8_t*
 
 uint8_t RegionLinkAdrReq( LoRaMacRegion_t region, LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, int8_t* txPowOut, uint8_t* nbRepOut, uint8_t* nbBytesParsed )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_LINK_ADR_REQ( );
         AU915_LINK_ADR_REQ( );
@@ -821,7 +862,7 @@ uint8_t RegionLinkAdrReq( LoRaMacRegion_t region, LinkAdrReqParams_t* linkAdrReq
 
 uint8_t RegionRxParamSetupReq( LoRaMacRegion_t region, RxParamSetupReqParams_t* rxParamSetupReq )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_RX_PARAM_SETUP_REQ( );
         AU915_RX_PARAM_SETUP_REQ( );
@@ -842,7 +883,7 @@ uint8_t RegionRxParamSetupReq( LoRaMacRegion_t region, RxParamSetupReqParams_t*
 
 int8_t RegionNewChannelReq( LoRaMacRegion_t region, NewChannelReqParams_t* newChannelReq )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_NEW_CHANNEL_REQ( );
         AU915_NEW_CHANNEL_REQ( );
@@ -863,7 +904,7 @@ int8_t RegionNewChannelReq( LoRaMacRegion_t region, NewChannelReqParams_t* newCh
 
 int8_t RegionTxParamSetupReq( LoRaMacRegion_t region, TxParamSetupReqParams_t* txParamSetupReq )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_TX_PARAM_SETUP_REQ( );
         AU915_TX_PARAM_SETUP_REQ( );
@@ -884,7 +925,7 @@ int8_t RegionTxParamSetupReq( LoRaMacRegion_t region, TxParamSetupReqParams_t* t
 
 int8_t RegionDlChannelReq( LoRaMacRegion_t region, DlChannelReqParams_t* dlChannelReq )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_DL_CHANNEL_REQ( );
         AU915_DL_CHANNEL_REQ( );
@@ -905,7 +946,7 @@ int8_t RegionDlChannelReq( LoRaMacRegion_t region, DlChannelReqParams_t* dlChann
 
 int8_t RegionAlternateDr( LoRaMacRegion_t region, int8_t currentDr, AlternateDrType_t type )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_ALTERNATE_DR( );
         AU915_ALTERNATE_DR( );
@@ -926,7 +967,7 @@ int8_t RegionAlternateDr( LoRaMacRegion_t region, int8_t currentDr, AlternateDrT
 
 LoRaMacStatus_t RegionNextChannel( LoRaMacRegion_t region, NextChanParams_t* nextChanParams, uint8_t* channel, TimerTime_t* time, TimerTime_t* aggregatedTimeOff )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_NEXT_CHANNEL( );
         AU915_NEXT_CHANNEL( );
@@ -947,7 +988,7 @@ LoRaMacStatus_t RegionNextChannel( LoRaMacRegion_t region, NextChanParams_t* nex
 
 LoRaMacStatus_t RegionChannelAdd( LoRaMacRegion_t region, ChannelAddParams_t* channelAdd )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_CHANNEL_ADD( );
         AU915_CHANNEL_ADD( );
@@ -968,7 +1009,7 @@ LoRaMacStatus_t RegionChannelAdd( LoRaMacRegion_t region, ChannelAddParams_t* ch
 
 bool RegionChannelsRemove( LoRaMacRegion_t region, ChannelRemoveParams_t* channelRemove )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_CHANNEL_REMOVE( );
         AU915_CHANNEL_REMOVE( );
@@ -990,7 +1031,7 @@ bool RegionChannelsRemove( LoRaMacRegion_t region, ChannelRemoveParams_t* channe
 #if (defined( REGION_VERSION ) && ( REGION_VERSION == 0x01010003 ))
 void RegionSetContinuousWave( LoRaMacRegion_t region, ContinuousWaveParams_t* continuousWave )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_SET_CONTINUOUS_WAVE( );
         AU915_SET_CONTINUOUS_WAVE( );
@@ -1012,7 +1053,7 @@ void RegionSetContinuousWave( LoRaMacRegion_t region, ContinuousWaveParams_t* co
 
 uint8_t RegionApplyDrOffset( LoRaMacRegion_t region, uint8_t downlinkDwellTime, int8_t dr, int8_t drOffset )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_APPLY_DR_OFFSET( );
         AU915_APPLY_DR_OFFSET( );
@@ -1033,7 +1074,7 @@ uint8_t RegionApplyDrOffset( LoRaMacRegion_t region, uint8_t downlinkDwellTime,
 
 void RegionRxBeaconSetup( LoRaMacRegion_t region, RxBeaconSetup_t* rxBeaconSetup, uint8_t* outDr )
 {
-    switch( region )
+    switch( REGION_DISPATCH( region ) )
     {
         AS923_RX_BEACON_SETUP( );
         AU915_RX_BEACON_SETUP( );
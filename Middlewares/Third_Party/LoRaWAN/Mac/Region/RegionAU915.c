@@ -76,6 +76,11 @@ static RegionNvmDataGroup2_t* RegionNvmGroup2;
 static Band_t* RegionBands;
 #endif /* REGION_VERSION */
 
+/*
+ * Bitmasks of the channels supporting each uplink datarate, built from the channels.
+ */
+static uint16_t DatarateChannels[AU915_TX_MAX_DATARATE + 1][CHANNELS_MASK_SIZE];
+
 static bool VerifyRfFreq( uint32_t freq )
 {
     // Check radio driver support
@@ -433,6 +438,12 @@ void RegionAU915InitDefaults( InitDefaultsParams_t* params )
                 RegionNvmGroup2->Channels[i].Band = 0;
             }
 
+            // Bitmasks of the channels of each datarate
+            for( int8_t dr = AU915_TX_MIN_DATARATE; dr <= AU915_TX_MAX_DATARATE; dr++ )
+            {
+                RegionCommonChanDrMaskBuild( RegionNvmGroup2->Channels, AU915_MAX_NB_CHANNELS, dr, DatarateChannels[dr] );
+            }
+
             // Initialize channels default mask
 #if ( HYBRID_ENABLED == 1 )
             RegionNvmGroup2->ChannelsDefaultMask[0] = HYBRID_DEFAULT_MASK0;
@@ -967,6 +978,14 @@ LoRaMacStatus_t RegionAU915NextChannel( NextChanParams_t* nextChanParams, uint8_
 #endif /* REGION_VERSION */
     countChannelsParams.MaxNbChannels = AU915_MAX_NB_CHANNELS;
     countChannelsParams.JoinChannels = NULL;
+    if( ( nextChanParams->Datarate >= AU915_TX_MIN_DATARATE ) && ( nextChanParams->Datarate <= AU915_TX_MAX_DATARATE ) )
+    {
+        countChannelsParams.DatarateChannels = DatarateChannels[nextChanParams->Datarate];
+    }
+    else
+    {
+        countChannelsParams.DatarateChannels = NULL;
+    }
 
     identifyChannelsParam.AggrTimeOff = nextChanParams->AggrTimeOff;
     identifyChannelsParam.LastAggrTx = nextChanParams->LastAggrTx;
@@ -188,6 +188,12 @@ typedef struct sRegionCN470ChannelPlanCtx
  */
 static RegionNvmDataGroup1_t* RegionNvmGroup1;
 static RegionNvmDataGroup2_t* RegionNvmGroup2;
+
+/*
+ * Bitmasks of the channels supporting each uplink datarate, built from the channels.
+ */
+static uint16_t DatarateChannels[CN470_TX_MAX_DATARATE + 1][CHANNELS_MASK_SIZE];
+
 #if (defined( REGION_VERSION ) && (( REGION_VERSION == 0x02010001 ) || ( REGION_VERSION == 0x02010003 )))
 static Band_t* RegionBands;
 
@@ -746,6 +752,14 @@ void RegionCN470InitDefaults( InitDefaultsParams_t* params )
             // Copy into channels mask remaining
             RegionCommonChanMaskCopy( RegionNvmGroup1->ChannelsMaskRemaining, RegionNvmGroup2->ChannelsMask, CHANNELS_MASK_SIZE );
 #endif /* REGION_VERSION */
+
+            // Bitmasks of the channels of each datarate. The NVM may hold fewer
+            // channels than CN470_MAX_NB_CHANNELS, the bits of the others stay cleared.
+            for( int8_t dr = CN470_TX_MIN_DATARATE; dr <= CN470_TX_MAX_DATARATE; dr++ )
+            {
+                RegionCommonChanDrMaskBuild( RegionNvmGroup2->Channels, MIN( CN470_MAX_NB_CHANNELS, REGION_NVM_MAX_NB_CHANNELS ),
+                                             dr, DatarateChannels[dr] );
+            }
             break;
         }
         case INIT_TYPE_RESET_TO_DEFAULT_CHANNELS:
@@ -1271,6 +1285,14 @@ LoRaMacStatus_t RegionCN470NextChannel( NextChanParams_t* nextChanParams, uint8_
     countChannelsParams.Bands = RegionNvmGroup1->Bands;
     countChannelsParams.MaxNbChannels = CN470_MAX_NB_CHANNELS;
     countChannelsParams.JoinChannels = NULL;
+    if( ( nextChanParams->Datarate >= CN470_TX_MIN_DATARATE ) && ( nextChanParams->Datarate <= CN470_TX_MAX_DATARATE ) )
+    {
+        countChannelsParams.DatarateChannels = DatarateChannels[nextChanParams->Datarate];
+    }
+    else
+    {
+        countChannelsParams.DatarateChannels = NULL;
+    }
 #elif (defined( REGION_VERSION ) && (( REGION_VERSION == 0x02010001 ) || ( REGION_VERSION == 0x02010003 )))
     uint8_t nbEnabledChannels = 0;
     uint8_t nbRestrictedChannels = 0;
@@ -1300,6 +1322,14 @@ LoRaMacStatus_t RegionCN470NextChannel( NextChanParams_t* nextChanParams, uint8_
     countChannelsParams.Bands = RegionBands;
     countChannelsParams.MaxNbChannels = CN470_MAX_NB_CHANNELS;
     countChannelsParams.JoinChannels = NULL;
+    if( ( nextChanParams->Datarate >= CN470_TX_MIN_DATARATE ) && ( nextChanParams->Datarate <= CN470_TX_MAX_DATARATE ) )
+    {
+        countChannelsParams.DatarateChannels = DatarateChannels[nextChanParams->Datarate];
+    }
+    else
+    {
+        countChannelsParams.DatarateChannels = NULL;
+    }
 
     // Apply a different channel selection if the device is not joined yet
     // In this case the device shall not follow the individual channel plans for the
@@ -1310,6 +1340,7 @@ LoRaMacStatus_t RegionCN470NextChannel( NextChanParams_t* nextChanParams, uint8_
         countChannelsParams.Channels = CommonJoinChannels;
         countChannelsParams.MaxNbChannels = CN470_COMMON_JOIN_CHANNELS_SIZE;
         countChannelsParams.JoinChannels = joinChannelsMask;
+        countChannelsParams.DatarateChannels = NULL;
     }
 #endif /* REGION_VERSION */
 
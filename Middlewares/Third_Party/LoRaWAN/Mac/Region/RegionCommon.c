@@ -289,16 +289,78 @@ static uint16_t UpdateTimeCredits( Band_t* band, bool joined, bool dutyCycleEnab
 }
 #endif
 
+/*!
+ * \brief Returns the time credits of a band at the given time, without
+ *        updating the band. Only valid for a joined device with the duty
+ *        cycle enabled.
+ *
+ * \remark In this state the credits of a band only change when the band is
+ *         used for a transmission, see RegionCommonSetBandTxDone, or when
+ *         the band is refilled. The band is then fully described by its last
+ *         update time and its credits at that time, so the scheduler does not
+ *         have to read the timer and write the band for every band and every
+ *         scheduling attempt.
+ *
+ * \param [in] band The band to evaluate.
+ *
+ * \param [in] currentTime The current time.
+ *
+ * \param [out] timeCredits The time credits of the band at currentTime.
+ *
+ * \retval Returns true if the credits have been evaluated, false if the band
+ *         requires a full update with UpdateTimeCredits.
+ */
+static bool PeekTimeCredits( Band_t* band, TimerTime_t currentTime, TimerTime_t* timeCredits )
+{
+    TimerTime_t elapsedTime = 0;
+
+    // The band has never been updated, its maximum credits have to be assigned
+    // or the timer wrapped around since the last update
+    if( ( band->LastBandUpdateTime == 0 ) ||
+        ( band->MaxTimeCredits != DUTY_CYCLE_TIME_PERIOD ) ||
+        ( currentTime < band->LastBandUpdateTime ) )
+    {
+        return false;
+    }
+    elapsedTime = currentTime - band->LastBandUpdateTime;
+
+#if (defined( REGION_VERSION ) && ( REGION_VERSION == 0x02010003 ))
+    // The band has to be refilled for a new observation period
+    if( ( band->LastMaxCreditAssignTime != DUTY_CYCLE_TIME_PERIOD ) ||
+        ( elapsedTime >= DUTY_CYCLE_TIME_PERIOD ) )
+    {
+        return false;
+    }
+    *timeCredits = band->TimeCredits;
+#else
+    // Sliding window, limited to the maximum credits
+    if( ( band->TimeCredits >= band->MaxTimeCredits ) ||
+        ( elapsedTime >= ( band->MaxTimeCredits - band->TimeCredits ) ) )
+    {
+        *timeCredits = band->MaxTimeCredits;
+    }
+    else
+    {
+        *timeCredits = band->TimeCredits + elapsedTime;
+    }
+#endif
+    return true;
+}
+
 static uint8_t CountChannels( uint16_t mask, uint8_t nbBits )
 {
     uint8_t nbActiveBits = 0;
 
-    for( uint8_t j = 0; j < nbBits; j++ )
+    if( nbBits < 16 )
     {
-        if( ( mask & ( 1 << j ) ) == ( 1 << j ) )
-        {
-            nbActiveBits++;
-        }
+        mask &= ( 1 << nbBits ) - 1;
+    }
+
+    // Clear the lowest set bit until none is left
+    while( mask != 0 )
+    {
+        mask &= mask - 1;
+        nbActiveBits++;
     }
     return nbActiveBits;
 }
@@ -380,12 +442,42 @@ void RegionCommonChanMaskCopy( uint16_t* channelsMaskDest, uint16_t* channelsMas
     }
 }
 
+void RegionCommonChanDrMaskBuild( ChannelParams_t* channels, uint8_t nbChannels, int8_t datarate, uint16_t* datarateChannels )
+{
+    for( uint8_t i = 0, k = 0; i < nbChannels; i += 16, k++ )
+    {
+        datarateChannels[k] = 0;
+        for( uint8_t j = 0; ( j < 16 ) && ( ( i + j ) < nbChannels ); j++ )
+        {
+            if( ( channels[i + j].Frequency != 0 ) &&
+                ( RegionCommonValueInRange( datarate, channels[i + j].DrRange.Fields.Min,
+                                            channels[i + j].DrRange.Fields.Max ) == 1 ) )
+            {
+                datarateChannels[k] |= 1 << j;
+            }
+        }
+    }
+}
+
 void RegionCommonSetBandTxDone( Band_t* band, TimerTime_t lastTxAirTime, bool joined, SysTime_t elapsedTimeSinceStartup )
 {
     // Get the band duty cycle. If not joined, the function either returns the join duty cycle
     // or the band duty cycle, whichever is more restrictive.
     uint16_t dutyCycle = GetDutyCycle( band, joined, elapsedTimeSinceStartup );
 
+#if (defined( REGION_VERSION ) && (( REGION_VERSION == 0x01010003 ) || ( REGION_VERSION == 0x02010001 )))
+    TimerTime_t currentTime = TimerGetCurrentTime( );
+    TimerTime_t timeCredits = 0;
+
+    // RegionCommonUpdateBandTimeOff does not synchronize the bands it only
+    // evaluates. Collect the credits of this band before spending them.
+    if( ( joined == true ) && ( PeekTimeCredits( band, currentTime, &timeCredits ) == true ) )
+    {
+        band->TimeCredits = timeCredits;
+        band->LastBandUpdateTime = currentTime;
+    }
+#endif
+
     // Reduce with transmission time
     if( band->TimeCredits > ( lastTxAirTime * dutyCycle ) )
     {
@@ -411,19 +503,37 @@ TimerTime_t RegionCommonUpdateBandTimeOff( bool joined, Band_t* bands,
 
     for( uint8_t i = 0; i < nbBands; i++ )
     {
+        TimerTime_t timeCredits = 0;
+#if (defined( REGION_VERSION ) && ( REGION_VERSION == 0x02010003 ))
+        TimerTime_t elapsedTime = 0;
+#endif
+
+        if( ( joined == true ) && ( dutyCycleEnabled == true ) &&
+            ( PeekTimeCredits( &bands[i], currentTime, &timeCredits ) == true ) )
+        {
+            // The band is up to date, only its credits at currentTime are needed
+            dutyCycle = GetDutyCycle( &bands[i], joined, elapsedTimeSinceStartup );
+#if (defined( REGION_VERSION ) && ( REGION_VERSION == 0x02010003 ))
+            elapsedTime = currentTime - bands[i].LastBandUpdateTime;
+#endif
+        }
+        else
+        {
 #if (defined( REGION_VERSION ) && ( REGION_VERSION == 0x02010003 ))
-        TimerTime_t elapsedTime = TimerGetElapsedTime( bands[i].LastBandUpdateTime );
+            elapsedTime = TimerGetElapsedTime( bands[i].LastBandUpdateTime );
 
-        // Synchronization of bands and credits
-        dutyCycle = UpdateTimeCredits( &bands[i], joined, dutyCycleEnabled,
-                                       lastTxIsJoinRequest, elapsedTimeSinceStartup,
-                                       currentTime, elapsedTime );
+            // Synchronization of bands and credits
+            dutyCycle = UpdateTimeCredits( &bands[i], joined, dutyCycleEnabled,
+                                           lastTxIsJoinRequest, elapsedTimeSinceStartup,
+                                           currentTime, elapsedTime );
 #else
-        // Synchronization of bands and credits
-        dutyCycle = UpdateTimeCredits( &bands[i], joined, dutyCycleEnabled,
-                                       lastTxIsJoinRequest, elapsedTimeSinceStartup,
-                                       currentTime );
+            // Synchronization of bands and credits
+            dutyCycle = UpdateTimeCredits( &bands[i], joined, dutyCycleEnabled,
+                                           lastTxIsJoinRequest, elapsedTimeSinceStartup,
+                                           currentTime );
 #endif
+            timeCredits = bands[i].TimeCredits;
+        }
 
         // Calculate the credit costs for the next transmission
         // with the duty cycle and the expected time on air
@@ -432,7 +542,7 @@ TimerTime_t RegionCommonUpdateBandTimeOff( bool joined, Band_t* bands,
         // Check if the band is ready for transmission. Its ready,
         // when the duty cycle is off, or the TimeCredits of the band
         // is higher than the credit costs for the transmission.
-        if( ( bands[i].TimeCredits > creditCosts ) ||
+        if( ( timeCredits > creditCosts ) ||
             ( ( dutyCycleEnabled == false ) && ( joined == true ) ) )
         {
             bands[i].ReadyForTransmission = true;
@@ -461,7 +571,7 @@ TimerTime_t RegionCommonUpdateBandTimeOff( bool joined, Band_t* bands,
                 }
                 minTimeToWait = MIN( minTimeToWait, observationTimeDiff );
 #else
-                minTimeToWait = MIN( minTimeToWait, ( creditCosts - bands[i].TimeCredits ) );
+                minTimeToWait = MIN( minTimeToWait, ( creditCosts - timeCredits ) );
 #endif
 
                 // This band is a potential candidate for an
@@ -665,6 +775,37 @@ void RegionCommonCountNbOfEnabledChannels( RegionCommonCountNbOfEnabledChannelsP
     uint8_t nbChannelCount = 0;
     uint8_t nbRestrictedChannelsCount = 0;
 
+    if( countNbOfEnabledChannelsParams->DatarateChannels != NULL )
+    {
+        for( uint8_t i = 0, k = 0; i < countNbOfEnabledChannelsParams->MaxNbChannels; i += 16, k++ )
+        {
+            // Frequency and datarate are checked for 16 channels at once
+            uint16_t mask = countNbOfEnabledChannelsParams->ChannelsMask[k] & countNbOfEnabledChannelsParams->DatarateChannels[k];
+
+            if( ( countNbOfEnabledChannelsParams->Joined == false ) &&
+                ( countNbOfEnabledChannelsParams->JoinChannels != NULL ) )
+            {
+                mask &= countNbOfEnabledChannelsParams->JoinChannels[k];
+            }
+            for( uint8_t j = i; mask != 0; j++, mask >>= 1 )
+            {
+                if( ( mask & 0x01 ) == 0 )
+                {
+                    continue;
+                }
+                if( countNbOfEnabledChannelsParams->Bands[countNbOfEnabledChannelsParams->Channels[j].Band].ReadyForTransmission == false )
+                { // Check if the band is available for transmission
+                    nbRestrictedChannelsCount++;
+                    continue;
+                }
+                enabledChannels[nbChannelCount++] = j;
+            }
+        }
+        *nbEnabledChannels = nbChannelCount;
+        *nbRestrictedChannels = nbRestrictedChannelsCount;
+        return;
+    }
+
     for( uint8_t i = 0, k = 0; i < countNbOfEnabledChannelsParams->MaxNbChannels; i += 16, k++ )
     {
         for( uint8_t j = 0; j < 16; j++ )
@@ -284,6 +284,13 @@ typedef struct sRegionCommonCountNbOfEnabledChannelsParams
      * ChannelsMask with a number of MaxNbChannels channels.
      */
     uint16_t* JoinChannels;
+    /*!
+     * A pointer to the bitmask of the channels which are defined and
+     * support the Datarate, see \ref RegionCommonChanDrMaskBuild.
+     * Shall have the same dimension as the ChannelsMask. Optional,
+     * NULL to check the channels one by one.
+     */
+    uint16_t* DatarateChannels;
 }RegionCommonCountNbOfEnabledChannelsParams_t;
 
 typedef struct sRegionCommonIdentifyChannelsParam
@@ -423,10 +430,29 @@ uint8_t RegionCommonCountChannels( uint16_t* channelsMask, uint8_t startIdx, uin
  */
 void RegionCommonChanMaskCopy( uint16_t* channelsMaskDest, uint16_t* channelsMaskSrc, uint8_t len );
 
+/*!
+ * \brief Builds the bitmask of the channels which are defined and support
+ *        a datarate. To be called again each time the channels change.
+ *        This is a generic function and valid for all regions.
+ *
+ * \param [in] channels The channels of the region.
+ *
+ * \param [in] nbChannels The number of channels.
+ *
+ * \param [in] datarate The datarate.
+ *
+ * \param [out] datarateChannels The bitmask, of nbChannels bits.
+ */
+void RegionCommonChanDrMaskBuild( ChannelParams_t* channels, uint8_t nbChannels, int8_t datarate, uint16_t* datarateChannels );
+
 /*!
  * \brief Sets the last tx done property.
  *        This is a generic function and valid for all regions.
  *
+ * \remark The credits of a joined band are synchronized with the current
+ *         time before being spent, as RegionCommonUpdateBandTimeOff does not
+ *         update the bands it can evaluate in place.
+ *
  * \param [in] band The band to be updated.
  *
  * \param [in] lastTxAirTime The time on air of the last TX frame.
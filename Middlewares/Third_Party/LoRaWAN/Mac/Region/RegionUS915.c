@@ -76,6 +76,11 @@ static RegionNvmDataGroup2_t* RegionNvmGroup2;
 static Band_t* RegionBands;
 #endif /* REGION_VERSION */
 
+/*
+ * Bitmasks of the channels supporting each uplink datarate, built from the channels.
+ */
+static uint16_t DatarateChannels[US915_TX_MAX_DATARATE + 1][CHANNELS_MASK_SIZE];
+
 static int8_t LimitTxPower( int8_t txPower, int8_t maxBandTxPower, int8_t datarate, uint16_t* channelsMask )
 {
     int8_t txPowerResult = txPower;
@@ -431,6 +436,12 @@ void RegionUS915InitDefaults( InitDefaultsParams_t* params )
                 RegionNvmGroup2->Channels[i].Band = 0;
             }
 
+            // Bitmasks of the channels of each datarate
+            for( int8_t dr = US915_TX_MIN_DATARATE; dr <= US915_TX_MAX_DATARATE; dr++ )
+            {
+                RegionCommonChanDrMaskBuild( RegionNvmGroup2->Channels, US915_MAX_NB_CHANNELS, dr, DatarateChannels[dr] );
+            }
+
             // Default ChannelsMask
 #if ( HYBRID_ENABLED == 1 )
             RegionNvmGroup2->ChannelsDefaultMask[0] = HYBRID_DEFAULT_MASK0;
@@ -981,6 +992,14 @@ LoRaMacStatus_t RegionUS915NextChannel( NextChanParams_t* nextChanParams, uint8_
 #endif /* REGION_VERSION */
     countChannelsParams.MaxNbChannels = US915_MAX_NB_CHANNELS;
     countChannelsParams.JoinChannels = NULL;
+    if( ( nextChanParams->Datarate >= US915_TX_MIN_DATARATE ) && ( nextChanParams->Datarate <= US915_TX_MAX_DATARATE ) )
+    {
+        countChannelsParams.DatarateChannels = DatarateChannels[nextChanParams->Datarate];
+    }
+    else
+    {
+        countChannelsParams.DatarateChannels = NULL;
+    }
 
     identifyChannelsParam.AggrTimeOff = nextChanParams->AggrTimeOff;
     identifyChannelsParam.LastAggrTx = nextChanParams->LastAggrTx;
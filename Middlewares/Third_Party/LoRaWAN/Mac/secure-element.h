@@ -214,6 +214,36 @@ SecureElementStatus_t SecureElementSetID( SecureElementNvmDevJoinAddrKey_t *KMSK
  */
 SecureElementStatus_t SecureElementComputeAesCmac( uint8_t* micBxBuffer, uint8_t* buffer, uint32_t size, KeyIdentifier_t keyID, uint32_t* cmac );
 
+/*!
+ * Starts a CMAC computed over several calls, the message is then given in
+ * parts to SecureElementAesCmacStreamUpdate
+ *
+ * \param [out] ctx           - CMAC context, owned by the caller until SecureElementAesCmacStreamFinish
+ * \param [in] micBxBuffer    - Buffer containing the initial Bx block, NULL if not used
+ * \param [in] keyID          - Key identifier to determine the AES key to be used
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t SecureElementAesCmacStreamStart( CmacStreamCtx_t* ctx, uint8_t* micBxBuffer, KeyIdentifier_t keyID );
+
+/*!
+ * Adds the next part of the message to a CMAC
+ *
+ * \param [in,out] ctx        - CMAC context
+ * \param [in] buffer         - Data buffer
+ * \param [in] size           - Data buffer size
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t SecureElementAesCmacStreamUpdate( CmacStreamCtx_t* ctx, uint8_t* buffer, uint32_t size );
+
+/*!
+ * Ends a CMAC and releases its context, also to be called to drop a CMAC
+ *
+ * \param [in,out] ctx        - CMAC context
+ * \param [out] cmac          - Computed cmac
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t SecureElementAesCmacStreamFinish( CmacStreamCtx_t* ctx, uint32_t* cmac );
+
 /*!
  * Verifies a CMAC (computes and compare with expected cmac)
  *
@@ -236,6 +266,18 @@ SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t* buffer, uint32_t size
  */
 SecureElementStatus_t SecureElementAesEncrypt( uint8_t* buffer, uint32_t size, KeyIdentifier_t keyID, uint8_t* encBuffer );
 
+/*!
+ * Encrypts or decrypts a buffer in counter mode ( Ai blocks of the LoRaWAN payload encryption )
+ *
+ * \param [in] keyID          - Key identifier to determine the AES key to be used
+ * \param [in] aBlock         - A block template, its last byte is overwritten by the block counter
+ * \param [in] ctrStart       - Counter value of the first block
+ * \param [in,out] buffer     - Data buffer, XORed in place with the key stream
+ * \param [in] size           - Data buffer size
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t SecureElementAesCtrXor( KeyIdentifier_t keyID, uint8_t* aBlock, uint8_t ctrStart, uint8_t* buffer, uint32_t size );
+
 /*!
  * Derives and store a key
  *
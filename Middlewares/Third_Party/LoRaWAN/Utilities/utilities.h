@@ -41,6 +41,7 @@ extern "C"
 #endif
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
 #include "utilities_conf.h"
 
 /* Exported types ------------------------------------------------------------*/
@@ -98,6 +99,13 @@ typedef enum LmnStatus_e
  */
 #define POW2( n ) ( 1 << n )
 
+/*!
+ * \brief Returns the number of 32 bits words of a slot pool free bitmap
+ *
+ * \param [in] nbSlots Number of slots of the pool
+ */
+#define SLOT_POOL_MAP_SIZE( nbSlots ) DIVC( nbSlots, 32 )
+
 /*!
  * Version
  */
@@ -206,6 +214,51 @@ uint32_t Crc32Update( uint32_t crcInit, uint8_t *buffer, uint16_t length );
  */
 uint32_t Crc32Finalize( uint32_t crc );
 
+/*!
+ * \brief Counts the trailing zero bits of a word
+ *
+ * \param [in] value Word to be scanned, must not be 0
+ *
+ * \retval index     Index of the lowest bit set in value
+ */
+uint8_t CountTrailingZeros( uint32_t value );
+
+/*!
+ * \brief Marks all the slots of a pool as free
+ *
+ * \param [out] freeMap Free bitmap of SLOT_POOL_MAP_SIZE( nbSlots ) words
+ * \param [in]  nbSlots Number of slots of the pool
+ */
+void SlotPoolInit( uint32_t *freeMap, uint16_t nbSlots );
+
+/*!
+ * \brief Allocates the lowest free slot of a pool
+ *
+ * \param [in,out] freeMap Free bitmap of the pool
+ * \param [in]     nbSlots Number of slots of the pool
+ *
+ * \retval slot          Index of the allocated slot, -1 if the pool is full
+ */
+int16_t SlotPoolAlloc( uint32_t *freeMap, uint16_t nbSlots );
+
+/*!
+ * \brief Gives a slot back to its pool
+ *
+ * \param [in,out] freeMap Free bitmap of the pool
+ * \param [in]     slot    Index of the slot to free
+ */
+void SlotPoolFree( uint32_t *freeMap, uint16_t slot );
+
+/*!
+ * \brief Checks if a slot of a pool is allocated
+ *
+ * \param [in] freeMap Free bitmap of the pool
+ * \param [in] slot    Index of the slot
+ *
+ * \retval status      true if the slot is allocated
+ */
+bool SlotPoolIsAllocated( const uint32_t *freeMap, uint16_t slot );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,670 @@
+/**
+  ******************************************************************************
+  *
+  *          Portions COPYRIGHT 2020 STMicroelectronics
+  *
+  * @file    radio_sim.c
+  * @author  MCD Application Team
+  * @brief   Virtual radio driver for host builds and deterministic simulations
+  *
+  * The virtual radio implements the Radio driver API on top of the time server
+  * (UTIL_TIMER). Transmissions and reception windows last their real duration
+  * in the time server time base, so a virtual time backend of the time server
+  * (e.g. stm32_timer_if_sim.c) runs the radio events without any hardware.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "radio_sim.h"
+#include "stm32_timer.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/*!
+ * Virtual radio parameters and state
+ */
+typedef struct RadioSim_s
+{
+    RadioState_t State;
+    RadioModems_t Modem;
+    uint32_t Frequency;
+    RadioSimParams_t Tx;
+    bool TxFixLen;
+    bool TxCrcOn;
+    bool TxContinuousWave;
+    RadioSimParams_t Rx;
+    uint16_t RxSymbTimeout;
+    bool RxFixLen;
+    bool RxCrcOn;
+    bool RxContinuous;
+    bool RxReceiving;
+    uint8_t MaxPayloadLength;
+    bool PublicNetwork;
+    uint32_t Seed;
+    int16_t RxRssi;
+    int8_t RxSnr;
+    uint8_t RxSize;
+} RadioSim_t;
+
+/* Private define ------------------------------------------------------------*/
+/*!
+ * Size of the reception buffer
+ */
+#define RADIO_SIM_BUF_SIZE          255
+
+/* Private macro -------------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+static void RadioSimInit( RadioEvents_t *events );
+static RadioState_t RadioSimGetStatus( void );
+static void RadioSimSetModem( RadioModems_t modem );
+static void RadioSimSetChannel( uint32_t freq );
+static bool RadioSimIsChannelFree( uint32_t freq, uint32_t rxBandwidth, int16_t rssiThresh, uint32_t maxCarrierSenseTime );
+static uint32_t RadioSimRandom( void );
+static void RadioSimSetRxConfig( RadioModems_t modem, uint32_t bandwidth,
+                                 uint32_t datarate, uint8_t coderate,
+                                 uint32_t bandwidthAfc, uint16_t preambleLen,
+                                 uint16_t symbTimeout, bool fixLen,
+                                 uint8_t payloadLen,
+                                 bool crcOn, bool freqHopOn, uint8_t hopPeriod,
+                                 bool iqInverted, bool rxContinuous );
+static void RadioSimSetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
+                                 uint32_t bandwidth, uint32_t datarate,
+                                 uint8_t coderate, uint16_t preambleLen,
+                                 bool fixLen, bool crcOn, bool freqHopOn,
+                                 uint8_t hopPeriod, bool iqInverted, uint32_t timeout );
+static bool RadioSimCheckRfFrequency( uint32_t frequency );
+static uint32_t RadioSimTimeOnAir( RadioModems_t modem, uint32_t bandwidth,
+                                   uint32_t datarate, uint8_t coderate,
+                                   uint16_t preambleLen, bool fixLen, uint8_t payloadLen,
+                                   bool crcOn );
+static radio_status_t RadioSimSend( uint8_t *buffer, uint8_t size );
+static void RadioSimSleep( void );
+static void RadioSimStandby( void );
+static void RadioSimRx( uint32_t timeout );
+static void RadioSimStartCad( void );
+static void RadioSimSetTxContinuousWave( uint32_t freq, int8_t power, uint16_t time );
+static int16_t RadioSimRssi( RadioModems_t modem );
+static void RadioSimWrite( uint16_t addr, uint8_t data );
+static uint8_t RadioSimRead( uint16_t addr );
+static void RadioSimWriteRegisters( uint16_t addr, uint8_t *buffer, uint8_t size );
+static void RadioSimReadRegisters( uint16_t addr, uint8_t *buffer, uint8_t size );
+static void RadioSimSetMaxPayloadLength( RadioModems_t modem, uint8_t max );
+static void RadioSimSetPublicNetwork( bool enable );
+static uint32_t RadioSimGetWakeupTime( void );
+static void RadioSimIrqProcess( void );
+static void RadioSimRxBoosted( uint32_t timeout );
+static void RadioSimSetRxDutyCycle( uint32_t rxTime, uint32_t sleepTime );
+static void RadioSimTxPrbs( void );
+static void RadioSimTxCw( int8_t power );
+static int32_t RadioSimSetRxGenericConfig( GenericModems_t modem, RxConfigGeneric_t *config, uint32_t rxContinuous, uint32_t symbTimeout );
+static int32_t RadioSimSetTxGenericConfig( GenericModems_t modem, TxConfigGeneric_t *config, int8_t power, uint32_t timeout );
+static int32_t RadioSimTransmitLongPacket( uint16_t payload_size, uint32_t timeout, void ( *TxLongPacketGetNextChunkCb )( uint8_t **buffer, uint8_t buffer_size ) );
+static int32_t RadioSimReceiveLongPacket( uint8_t boosted_mode, uint32_t timeout, void ( *RxLongStorePacketChunkCb )( uint8_t *buffer, uint8_t chunk_size ) );
+static radio_status_t RadioSimLrFhssSetCfg( const radio_lr_fhss_cfg_params_t *cfg_params );
+static radio_status_t RadioSimLrFhssGetTimeOnAirInMs( const radio_lr_fhss_time_on_air_params_t *params, uint32_t *time_on_air_in_ms );
+
+/*!
+ * \brief Computes the duration of a number of LoRa symbols [ms], rounded up
+ */
+static uint32_t RadioSimLoRaSymbolsTime( uint32_t bandwidth, uint32_t datarate, uint32_t symbols );
+
+/*!
+ * \brief Stops the radio timers and sets the radio in idle state
+ */
+static void RadioSimSetIdle( void );
+
+/*!
+ * \brief Tx timer callback: end of transmission
+ */
+static void RadioSimOnTxTimerEvent( void *context );
+
+/*!
+ * \brief Rx timer callback: end of the reception window or of a received frame
+ */
+static void RadioSimOnRxTimerEvent( void *context );
+
+/*!
+ * \brief Cad timer callback: end of the channel activity detection
+ */
+static void RadioSimOnCadTimerEvent( void *context );
+
+/* Private variables ---------------------------------------------------------*/
+/*!
+ * Radio driver structure initialization
+ */
+const struct Radio_s Radio =
+{
+    RadioSimInit,
+    RadioSimGetStatus,
+    RadioSimSetModem,
+    RadioSimSetChannel,
+    RadioSimIsChannelFree,
+    RadioSimRandom,
+    RadioSimSetRxConfig,
+    RadioSimSetTxConfig,
+    RadioSimCheckRfFrequency,
+    RadioSimTimeOnAir,
+    RadioSimSend,
+    RadioSimSleep,
+    RadioSimStandby,
+    RadioSimRx,
+    RadioSimStartCad,
+    RadioSimSetTxContinuousWave,
+    RadioSimRssi,
+    RadioSimWrite,
+    RadioSimRead,
+    RadioSimWriteRegisters,
+    RadioSimReadRegisters,
+    RadioSimSetMaxPayloadLength,
+    RadioSimSetPublicNetwork,
+    RadioSimGetWakeupTime,
+    RadioSimIrqProcess,
+    RadioSimRxBoosted,
+    RadioSimSetRxDutyCycle,
+    RadioSimTxPrbs,
+    RadioSimTxCw,
+    RadioSimSetRxGenericConfig,
+    RadioSimSetTxGenericConfig,
+    RadioSimTransmitLongPacket,
+    RadioSimReceiveLongPacket,
+    /* LrFhss extended radio functions */
+    RadioSimLrFhssSetCfg,
+    RadioSimLrFhssGetTimeOnAirInMs
+};
+
+static RadioSim_t RadioSim = { .MaxPayloadLength = RADIO_SIM_BUF_SIZE, .PublicNetwork = true, .Seed = 1 };
+
+static RadioEvents_t *RadioEvents;
+
+static const RadioSimObserver_t *RadioSimObserver;
+
+static uint8_t RadioSimBuffer[RADIO_SIM_BUF_SIZE];
+
+static UTIL_TIMER_Object_t RadioSimTxTimer;
+static UTIL_TIMER_Object_t RadioSimRxTimer;
+static UTIL_TIMER_Object_t RadioSimCadTimer;
+
+/* Exported functions --------------------------------------------------------*/
+void RADIO_SIM_SetObserver( const RadioSimObserver_t *observer )
+{
+    RadioSimObserver = observer;
+}
+
+void RADIO_SIM_SetSeed( uint32_t seed )
+{
+    RadioSim.Seed = ( seed != 0 ) ? seed : 1;
+}
+
+bool RADIO_SIM_GetRxParams( RadioSimParams_t *params )
+{
+    if( RadioSim.State != RF_RX_RUNNING )
+    {
+        return false;
+    }
+    if( params != NULL )
+    {
+        *params = RadioSim.Rx;
+    }
+    return true;
+}
+
+bool RADIO_SIM_Deliver( const RadioSimParams_t *params, const uint8_t *payload, uint8_t size, int16_t rssi, int8_t snr )
+{
+    if( ( RadioSim.State != RF_RX_RUNNING ) || ( RadioSim.RxReceiving == true ) ||
+        ( params->Modem != RadioSim.Rx.Modem ) || ( params->Frequency != RadioSim.Rx.Frequency ) ||
+        ( params->Datarate != RadioSim.Rx.Datarate ) || ( size > RadioSim.MaxPayloadLength ) )
+    {
+        return false;
+    }
+    if( ( params->Modem == MODEM_LORA ) &&
+        ( ( params->Bandwidth != RadioSim.Rx.Bandwidth ) || ( params->IqInverted != RadioSim.Rx.IqInverted ) ) )
+    {
+        return false;
+    }
+
+    memcpy( RadioSimBuffer, payload, size );
+    RadioSim.RxSize = size;
+    RadioSim.RxRssi = rssi;
+    RadioSim.RxSnr = snr;
+    RadioSim.RxReceiving = true;
+
+    // The reception window is stopped by the preamble, RxDone comes at the end of the frame
+    UTIL_TIMER_Stop( &RadioSimRxTimer );
+    UTIL_TIMER_SetPeriod( &RadioSimRxTimer,
+                          RadioSimTimeOnAir( params->Modem, params->Bandwidth, params->Datarate,
+                                             params->Coderate, params->PreambleLen, RadioSim.RxFixLen,
+                                             size, RadioSim.RxCrcOn ) );
+    UTIL_TIMER_Start( &RadioSimRxTimer );
+    return true;
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void RadioSimInit( RadioEvents_t *events )
+{
+    RadioEvents = events;
+
+    UTIL_TIMER_Create( &RadioSimTxTimer, 0xFFFFFFFFU, UTIL_TIMER_ONESHOT, RadioSimOnTxTimerEvent, NULL );
+    UTIL_TIMER_Create( &RadioSimRxTimer, 0xFFFFFFFFU, UTIL_TIMER_ONESHOT, RadioSimOnRxTimerEvent, NULL );
+    UTIL_TIMER_Create( &RadioSimCadTimer, 0xFFFFFFFFU, UTIL_TIMER_ONESHOT, RadioSimOnCadTimerEvent, NULL );
+
+    RadioSimSetIdle( );
+}
+
+static RadioState_t RadioSimGetStatus( void )
+{
+    return RadioSim.State;
+}
+
+static void RadioSimSetModem( RadioModems_t modem )
+{
+    RadioSim.Modem = modem;
+}
+
+static void RadioSimSetChannel( uint32_t freq )
+{
+    RadioSim.Frequency = freq;
+}
+
+static bool RadioSimIsChannelFree( uint32_t freq, uint32_t rxBandwidth, int16_t rssiThresh, uint32_t maxCarrierSenseTime )
+{
+    RadioSimSetChannel( freq );
+    return ( RADIO_SIM_NOISE_FLOOR <= rssiThresh );
+}
+
+static uint32_t RadioSimRandom( void )
+{
+    // xorshift32, deterministic for a given seed
+    RadioSim.Seed ^= RadioSim.Seed << 13;
+    RadioSim.Seed ^= RadioSim.Seed >> 17;
+    RadioSim.Seed ^= RadioSim.Seed << 5;
+    return RadioSim.Seed;
+}
+
+static void RadioSimSetRxConfig( RadioModems_t modem, uint32_t bandwidth,
+                                 uint32_t datarate, uint8_t coderate,
+                                 uint32_t bandwidthAfc, uint16_t preambleLen,
+                                 uint16_t symbTimeout, bool fixLen,
+                                 uint8_t payloadLen,
+                                 bool crcOn, bool freqHopOn, uint8_t hopPeriod,
+                                 bool iqInverted, bool rxContinuous )
+{
+    RadioSimSetModem( modem );
+    RadioSim.Rx.Modem = modem;
+    RadioSim.Rx.Bandwidth = bandwidth;
+    RadioSim.Rx.Datarate = datarate;
+    RadioSim.Rx.Coderate = coderate;
+    RadioSim.Rx.PreambleLen = preambleLen;
+    RadioSim.Rx.IqInverted = iqInverted;
+    RadioSim.RxSymbTimeout = symbTimeout;
+    RadioSim.RxFixLen = fixLen;
+    RadioSim.RxCrcOn = crcOn;
+    RadioSim.RxContinuous = rxContinuous;
+    if( fixLen == true )
+    {
+        RadioSim.MaxPayloadLength = payloadLen;
+    }
+}
+
+static void RadioSimSetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
+                                 uint32_t bandwidth, uint32_t datarate,
+                                 uint8_t coderate, uint16_t preambleLen,
+                                 bool fixLen, bool crcOn, bool freqHopOn,
+                                 uint8_t hopPeriod, bool iqInverted, uint32_t timeout )
+{
+    RadioSimSetModem( modem );
+    RadioSim.Tx.Modem = modem;
+    RadioSim.Tx.Power = power;
+    RadioSim.Tx.Bandwidth = bandwidth;
+    RadioSim.Tx.Datarate = datarate;
+    RadioSim.Tx.Coderate = coderate;
+    RadioSim.Tx.PreambleLen = preambleLen;
+    RadioSim.Tx.IqInverted = iqInverted;
+    RadioSim.TxFixLen = fixLen;
+    RadioSim.TxCrcOn = crcOn;
+}
+
+static bool RadioSimCheckRfFrequency( uint32_t frequency )
+{
+    return true;
+}
+
+static uint32_t RadioSimTimeOnAir( RadioModems_t modem, uint32_t bandwidth,
+                                   uint32_t datarate, uint8_t coderate,
+                                   uint16_t preambleLen, bool fixLen, uint8_t payloadLen,
+                                   bool crcOn )
+{
+    uint32_t numerator = 0;
+    uint32_t denominator = 1;
+
+    // Same computation as the SubGHz radio driver
+    switch( modem )
+    {
+    case MODEM_FSK:
+        {
+            numerator   = 1000U * ( ( preambleLen << 3 ) +
+                                    ( ( fixLen == false ) ? 8 : 0 ) + 24 +
+                                    ( ( payloadLen + ( ( crcOn == true ) ? 2 : 0 ) ) << 3 ) );
+            denominator = datarate;
+        }
+        break;
+    case MODEM_LORA:
+        {
+            int32_t crDenom           = coderate + 4;
+            bool    lowDatareOptimize = false;
+
+            // Ensure that the preamble length is at least 12 symbols when using SF5 or SF6
+            if( ( ( datarate == 5 ) || ( datarate == 6 ) ) && ( preambleLen < 12 ) )
+            {
+                preambleLen = 12;
+            }
+
+            if( ( ( bandwidth == 0 ) && ( ( datarate == 11 ) || ( datarate == 12 ) ) ) ||
+                ( ( bandwidth == 1 ) && ( datarate == 12 ) ) )
+            {
+                lowDatareOptimize = true;
+            }
+
+            int32_t ceilDenominator;
+            int32_t ceilNumerator = ( payloadLen << 3 ) +
+                                    ( crcOn ? 16 : 0 ) -
+                                    ( 4 * datarate ) +
+                                    ( fixLen ? 0 : 20 );
+
+            if( datarate <= 6 )
+            {
+                ceilDenominator = 4 * datarate;
+            }
+            else
+            {
+                ceilNumerator += 8;
+
+                if( lowDatareOptimize == true )
+                {
+                    ceilDenominator = 4 * ( datarate - 2 );
+                }
+                else
+                {
+                    ceilDenominator = 4 * datarate;
+                }
+            }
+
+            if( ceilNumerator < 0 )
+            {
+                ceilNumerator = 0;
+            }
+
+            // Perform integral ceil()
+            int32_t intermediate =
+                ( ( ceilNumerator + ceilDenominator - 1 ) / ceilDenominator ) * crDenom + preambleLen + 12;
+
+            if( datarate <= 6 )
+            {
+                intermediate += 2;
+            }
+
+            numerator   = 1000U * ( uint32_t )( ( 4 * intermediate + 1 ) * ( 1 << ( datarate - 2 ) ) );
+            denominator = 125000UL << bandwidth;
+        }
+        break;
+    default:
+        break;
+    }
+    // Perform integral ceil()
+    return ( numerator + denominator - 1 ) / denominator;
+}
+
+static radio_status_t RadioSimSend( uint8_t *buffer, uint8_t size )
+{
+    uint32_t timeOnAir = RadioSimTimeOnAir( RadioSim.Tx.Modem, RadioSim.Tx.Bandwidth, RadioSim.Tx.Datarate,
+                                            RadioSim.Tx.Coderate, RadioSim.Tx.PreambleLen, RadioSim.TxFixLen,
+                                            size, RadioSim.TxCrcOn );
+
+    RadioSimSetIdle( );
+    RadioSim.State = RF_TX_RUNNING;
+    RadioSim.Tx.Frequency = RadioSim.Frequency;
+
+    if( ( RadioSimObserver != NULL ) && ( RadioSimObserver->TxStart != NULL ) )
+    {
+        RadioSimObserver->TxStart( &RadioSim.Tx, buffer, size, timeOnAir );
+    }
+
+    UTIL_TIMER_SetPeriod( &RadioSimTxTimer, timeOnAir );
+    UTIL_TIMER_Start( &RadioSimTxTimer );
+    return RADIO_STATUS_OK;
+}
+
+static void RadioSimSleep( void )
+{
+    RadioSimSetIdle( );
+}
+
+static void RadioSimStandby( void )
+{
+    RadioSimSetIdle( );
+}
+
+static void RadioSimRx( uint32_t timeout )
+{
+    uint32_t window = timeout;
+
+    RadioSimSetIdle( );
+    RadioSim.State = RF_RX_RUNNING;
+    RadioSim.Rx.Frequency = RadioSim.Frequency;
+
+    if( RadioSim.RxContinuous == true )
+    {
+        window = 0;
+    }
+    else if( ( RadioSim.Rx.Modem == MODEM_LORA ) && ( RadioSim.RxSymbTimeout != 0 ) )
+    {
+        // The LoRa symbol timeout closes the window when no preamble is detected
+        uint32_t symbTime = RadioSimLoRaSymbolsTime( RadioSim.Rx.Bandwidth, RadioSim.Rx.Datarate, RadioSim.RxSymbTimeout );
+
+        if( ( window == 0 ) || ( symbTime < window ) )
+        {
+            window = symbTime;
+        }
+    }
+
+    if( window != 0 )
+    {
+        UTIL_TIMER_SetPeriod( &RadioSimRxTimer, window );
+        UTIL_TIMER_Start( &RadioSimRxTimer );
+    }
+
+    // The window is open: the observer may deliver a frame right away
+    if( ( RadioSimObserver != NULL ) && ( RadioSimObserver->RxStart != NULL ) )
+    {
+        RadioSimObserver->RxStart( &RadioSim.Rx, window );
+    }
+}
+
+static void RadioSimStartCad( void )
+{
+    RadioSimSetIdle( );
+    RadioSim.State = RF_CAD;
+    UTIL_TIMER_SetPeriod( &RadioSimCadTimer, RadioSimLoRaSymbolsTime( RadioSim.Rx.Bandwidth, RadioSim.Rx.Datarate, 2 ) );
+    UTIL_TIMER_Start( &RadioSimCadTimer );
+}
+
+static void RadioSimSetTxContinuousWave( uint32_t freq, int8_t power, uint16_t time )
+{
+    RadioSimSetIdle( );
+    RadioSimSetChannel( freq );
+    RadioSim.State = RF_TX_RUNNING;
+    RadioSim.TxContinuousWave = true;
+    // Ends with a TxTimeout, as with the SubGHz radio
+    UTIL_TIMER_SetPeriod( &RadioSimTxTimer, ( uint32_t )time * 1000U );
+    UTIL_TIMER_Start( &RadioSimTxTimer );
+}
+
+static int16_t RadioSimRssi( RadioModems_t modem )
+{
+    return RADIO_SIM_NOISE_FLOOR;
+}
+
+static void RadioSimWrite( uint16_t addr, uint8_t data )
+{
+}
+
+static uint8_t RadioSimRead( uint16_t addr )
+{
+    return 0;
+}
+
+static void RadioSimWriteRegisters( uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+}
+
+static void RadioSimReadRegisters( uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+    memset( buffer, 0, size );
+}
+
+static void RadioSimSetMaxPayloadLength( RadioModems_t modem, uint8_t max )
+{
+    RadioSim.MaxPayloadLength = max;
+}
+
+static void RadioSimSetPublicNetwork( bool enable )
+{
+    RadioSim.PublicNetwork = enable;
+}
+
+static uint32_t RadioSimGetWakeupTime( void )
+{
+    return RADIO_SIM_WAKEUP_TIME;
+}
+
+static void RadioSimIrqProcess( void )
+{
+    // The radio events are notified from the time server callbacks
+}
+
+static void RadioSimRxBoosted( uint32_t timeout )
+{
+    RadioSimRx( timeout );
+}
+
+static void RadioSimSetRxDutyCycle( uint32_t rxTime, uint32_t sleepTime )
+{
+    // The duty cycled reception is seen as a continuous reception
+    RadioSimSetIdle( );
+    RadioSim.State = RF_RX_RUNNING;
+    RadioSim.Rx.Frequency = RadioSim.Frequency;
+}
+
+static void RadioSimTxPrbs( void )
+{
+    RadioSimSetIdle( );
+    RadioSim.State = RF_TX_RUNNING;
+}
+
+static void RadioSimTxCw( int8_t power )
+{
+    RadioSimSetIdle( );
+    RadioSim.State = RF_TX_RUNNING;
+}
+
+static int32_t RadioSimSetRxGenericConfig( GenericModems_t modem, RxConfigGeneric_t *config, uint32_t rxContinuous, uint32_t symbTimeout )
+{
+    return -1;
+}
+
+static int32_t RadioSimSetTxGenericConfig( GenericModems_t modem, TxConfigGeneric_t *config, int8_t power, uint32_t timeout )
+{
+    return -1;
+}
+
+static int32_t RadioSimTransmitLongPacket( uint16_t payload_size, uint32_t timeout, void ( *TxLongPacketGetNextChunkCb )( uint8_t **buffer, uint8_t buffer_size ) )
+{
+    return -1;
+}
+
+static int32_t RadioSimReceiveLongPacket( uint8_t boosted_mode, uint32_t timeout, void ( *RxLongStorePacketChunkCb )( uint8_t *buffer, uint8_t chunk_size ) )
+{
+    return -1;
+}
+
+static radio_status_t RadioSimLrFhssSetCfg( const radio_lr_fhss_cfg_params_t *cfg_params )
+{
+    return RADIO_STATUS_UNSUPPORTED_FEATURE;
+}
+
+static radio_status_t RadioSimLrFhssGetTimeOnAirInMs( const radio_lr_fhss_time_on_air_params_t *params, uint32_t *time_on_air_in_ms )
+{
+    return RADIO_STATUS_UNSUPPORTED_FEATURE;
+}
+
+static uint32_t RadioSimLoRaSymbolsTime( uint32_t bandwidth, uint32_t datarate, uint32_t symbols )
+{
+    uint32_t bandwidthInHz = 125000UL << bandwidth;
+
+    return ( ( symbols * 1000U << datarate ) + bandwidthInHz - 1 ) / bandwidthInHz;
+}
+
+static void RadioSimSetIdle( void )
+{
+    UTIL_TIMER_Stop( &RadioSimTxTimer );
+    UTIL_TIMER_Stop( &RadioSimRxTimer );
+    UTIL_TIMER_Stop( &RadioSimCadTimer );
+    RadioSim.TxContinuousWave = false;
+    RadioSim.RxReceiving = false;
+    RadioSim.State = RF_IDLE;
+}
+
+static void RadioSimOnTxTimerEvent( void *context )
+{
+    // A transmission ends with TxDone, a continuous wave with TxTimeout
+    bool txDone = ( RadioSim.TxContinuousWave == false );
+
+    RadioSim.TxContinuousWave = false;
+    RadioSim.State = RF_IDLE;
+    if( RadioEvents == NULL )
+    {
+        return;
+    }
+    if( txDone == true )
+    {
+        if( RadioEvents->TxDone != NULL )
+        {
+            RadioEvents->TxDone( );
+        }
+    }
+    else if( RadioEvents->TxTimeout != NULL )
+    {
+        RadioEvents->TxTimeout( );
+    }
+}
+
+static void RadioSimOnRxTimerEvent( void *context )
+{
+    if( RadioSim.RxReceiving == true )
+    {
+        RadioSim.RxReceiving = false;
+        if( RadioSim.RxContinuous == false )
+        {
+            RadioSim.State = RF_IDLE;
+        }
+        if( ( RadioEvents != NULL ) && ( RadioEvents->RxDone != NULL ) )
+        {
+            RadioEvents->RxDone( RadioSimBuffer, RadioSim.RxSize, RadioSim.RxRssi, RadioSim.RxSnr );
+        }
+    }
+    else
+    {
+        RadioSim.State = RF_IDLE;
+        if( ( RadioEvents != NULL ) && ( RadioEvents->RxTimeout != NULL ) )
+        {
+            RadioEvents->RxTimeout( );
+        }
+    }
+}
+
+static void RadioSimOnCadTimerEvent( void *context )
+{
+    RadioSim.State = RF_IDLE;
+    if( ( RadioEvents != NULL ) && ( RadioEvents->CadDone != NULL ) )
+    {
+        RadioEvents->CadDone( false );
+    }
+}
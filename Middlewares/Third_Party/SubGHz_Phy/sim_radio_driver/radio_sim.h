@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  *
+  *          Portions COPYRIGHT 2020 STMicroelectronics
+  *
+  * @file    radio_sim.h
+  * @author  MCD Application Team
+  * @brief   Virtual radio driver for host builds and deterministic simulations
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RADIO_SIM_H__
+#define __RADIO_SIM_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/* Includes ------------------------------------------------------------------*/
+#include "radio.h"
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * \brief Wake up time of the virtual radio [ms]
+ */
+#ifndef RADIO_SIM_WAKEUP_TIME
+#define RADIO_SIM_WAKEUP_TIME       ( 1UL )
+#endif /* RADIO_SIM_WAKEUP_TIME */
+
+/*!
+ * \brief RSSI returned by the virtual radio when no frame is received [dBm]
+ */
+#ifndef RADIO_SIM_NOISE_FLOOR
+#define RADIO_SIM_NOISE_FLOOR       ( -120 )
+#endif /* RADIO_SIM_NOISE_FLOOR */
+
+/* Exported types ------------------------------------------------------------*/
+/*!
+ * \brief Modulation of a frame sent or received by the virtual radio
+ */
+typedef struct
+{
+    RadioModems_t Modem;
+    uint32_t Frequency;     //!< RF frequency [Hz]
+    int8_t Power;           //!< TX power [dBm], TX only
+    uint32_t Bandwidth;     //!< LoRa: [0: 125 kHz, 1: 250 kHz, 2: 500 kHz], FSK: [Hz]
+    uint32_t Datarate;      //!< LoRa: spreading factor, FSK: [bits/s]
+    uint8_t Coderate;       //!< LoRa: [1: 4/5, 2: 4/6, 3: 4/7, 4: 4/8]
+    uint16_t PreambleLen;
+    bool IqInverted;
+} RadioSimParams_t;
+
+/*!
+ * \brief Observer of the virtual radio, i.e. the simulated air interface
+ *
+ * \remark The callbacks are called from the virtual radio API, with the
+ *         simulation time of the event. They must not call the radio API,
+ *         RADIO_SIM_Deliver excepted from RxStart.
+ */
+typedef struct
+{
+    /*!
+     * \brief A frame is put on air
+     *
+     * \param [in] params    Modulation of the frame
+     * \param [in] payload   Frame, only valid during the call
+     * \param [in] size      Frame size
+     * \param [in] timeOnAir Duration of the transmission [ms]
+     */
+    void ( *TxStart )( const RadioSimParams_t *params, const uint8_t *payload, uint8_t size, uint32_t timeOnAir );
+    /*!
+     * \brief The radio starts to listen
+     *
+     * \param [in] params    Modulation expected by the receiver
+     * \param [in] window    Duration of the reception window [ms], 0 when continuous
+     */
+    void ( *RxStart )( const RadioSimParams_t *params, uint32_t window );
+} RadioSimObserver_t;
+
+/* Exported functions ------------------------------------------------------- */
+/*!
+ * \brief Registers the observer of the virtual radio
+ *
+ * \param [in] observer Observer, NULL to remove it
+ */
+void RADIO_SIM_SetObserver( const RadioSimObserver_t *observer );
+
+/*!
+ * \brief Seeds the random generator of the virtual radio (Radio.Random)
+ *
+ * \param [in] seed Seed, must not be 0
+ */
+void RADIO_SIM_SetSeed( uint32_t seed );
+
+/*!
+ * \brief Gets the modulation the radio currently listens to
+ *
+ * \param [out] params Modulation expected by the receiver
+ * \retval true when the radio is in reception
+ */
+bool RADIO_SIM_GetRxParams( RadioSimParams_t *params );
+
+/*!
+ * \brief Delivers a frame to the virtual radio
+ *
+ * The frame is received when the radio listens with the same modem, frequency,
+ * bandwidth, datarate and IQ polarity. Call it when the preamble of the frame
+ * reaches the radio: the reception window stops and RxDone is notified after
+ * the time on air of the frame.
+ *
+ * \param [in] params  Modulation of the frame
+ * \param [in] payload Frame, copied by the radio
+ * \param [in] size    Frame size
+ * \param [in] rssi    RSSI reported with the frame [dBm]
+ * \param [in] snr     LoRa SNR reported with the frame [dB]
+ * \retval true when the frame is being received
+ */
+bool RADIO_SIM_Deliver( const RadioSimParams_t *params, const uint8_t *payload, uint8_t size, int16_t rssi, int8_t snr );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RADIO_SIM_H__
@@ -65,6 +65,11 @@
   *     * CFG_EE_BANK1_MAX_NB
   *       Maximum number of data that can be stored in the second bank.
   *
+  *     * CFG_EE_RAM_INDEX (optional, 0 by default)
+  *       When not 0, the flash position of the last update of each virtual
+  *       address is kept in RAM, so that reads and pool transfers do not
+  *       search the flash. It costs 2 bytes of RAM per flash word of a pool.
+  *
   * Notes
   * -----
   * - a corrupted word in FLASH detected by the user software shall be set to 0.
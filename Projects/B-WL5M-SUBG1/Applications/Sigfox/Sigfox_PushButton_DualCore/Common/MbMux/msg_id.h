@@ -123,6 +123,8 @@ typedef enum
   RADIO_RX_ERROR_CB_ID,
   RADIO_FHSS_CHANGE_CHANNEL_CB_ID,
   RADIO_CAD_DONE_CB_ID,
+  /* CmdResp, appended to keep the ids of previous releases */
+  RADIO_BATCH_ID,
   /* USER CODE BEGIN Radio_MsgIdTypeDef */
 
   /* USER CODE END Radio_MsgIdTypeDef */
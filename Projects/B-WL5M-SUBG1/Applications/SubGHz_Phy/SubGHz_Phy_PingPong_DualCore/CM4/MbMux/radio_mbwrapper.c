@@ -27,6 +27,7 @@
 #include "msg_id.h"
 #include "mbmuxif_radio.h"
 #include "sys_app.h"
+#include "stm32_mem.h"
 
 /* USER CODE BEGIN Includes */
 
@@ -43,6 +44,11 @@
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
+/**
+  * @brief header word of a command in the radio batch, followed by its ParamCnt parameters
+  */
+#define RADIO_BATCH_HEADER(msg_id, param_cnt)  ((uint32_t)(msg_id) | ((uint32_t)(param_cnt) << 16))
+
 /* USER CODE BEGIN PD */
 
 /* USER CODE END PD */
@@ -55,11 +61,85 @@
 /* Private variables ---------------------------------------------------------*/
 static RadioEvents_t   radioevents_wrap;
 
+/**
+  * @brief radio commands batch executed by CM0+ on a single RADIO_BATCH_ID command
+  */
+UTIL_MEM_PLACE_IN_SECTION("MB_MEM1") uint32_t aRadioBatchBuff[MAX_PARAM_OF_RADIO_BATCH_FUNCTIONS];/*shared*/
+
+/**
+  * @brief com param of the command being added to the radio batch
+  */
+static MBMUX_ComParam_t radio_batch_com_obj;
+
+/**
+  * @brief set between Radio_Batch_Start and Radio_Batch_Send
+  */
+static bool radio_batch_on = false;
+
+/**
+  * @brief number of words used in the radio batch
+  */
+static uint16_t radio_batch_cnt = 0;
+
+/**
+  * @brief number of commands in the radio batch
+  */
+static uint16_t radio_batch_cmd_nb = 0;
+
+/**
+  * @brief number of commands of the batch sent without waiting for its response
+  */
+static uint16_t radio_batch_async_nb = 0;
+
 /* USER CODE BEGIN PV */
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
+/* **********************************************************************
+ * Command batching functions prototypes
+ ************************************************************************/
+/*!
+ * \brief Gets the com param to fill in with the next radio command
+ *
+ * \param[in] paramSize Max number of words of the command parameters
+ * \retval com param of the radio batch or of the Radio feature Cmd
+ */
+static MBMUX_ComParam_t *RadioGetCmdComPtr(uint32_t paramSize);
+
+/*!
+ * \brief Sends the radio command filled in the com param or adds it to the radio batch
+ *
+ * \param[in] comObj   com param returned by RadioGetCmdComPtr
+ * \param[in] waitResp true when the caller needs the command to be executed (return value
+ *                     or output buffer): the radio batch is then sent and executed
+ */
+static void RadioSendCmd(MBMUX_ComParam_t *comObj, bool waitResp);
+
+/*!
+ * \brief Sends the radio batch to CM0+
+ *
+ * \param[in] waitResp wait for the batch to be executed
+ * \retval return value of the last command of the batch
+ */
+static uint32_t RadioBatchFlush(bool waitResp);
+
+/*!
+ * \brief Gets the com param of the Radio feature Cmd, once the response of the
+ *        batch sent without waiting is received and checked
+ *
+ * \retval com param of the Radio feature Cmd
+ */
+static MBMUX_ComParam_t *RadioGetFeatureCmdComPtr(void);
+
+/*!
+ * \brief Checks that CM0+ executed all the commands of a batch
+ *
+ * \param[in] comObj com param of the batch response
+ * \param[in] cmdNb  number of commands of the batch
+ */
+static void RadioBatchCheck(MBMUX_ComParam_t *comObj, uint16_t cmdNb);
+
 /* **********************************************************************
  * Interrupts functions prototypes
  ************************************************************************/
@@ -547,11 +627,139 @@ void Process_Radio_Notif(MBMUX_ComParam_t *ComObj)
   /* USER CODE END Process_Radio_Notif_2 */
 }
 
+void Radio_Batch_Start(void)
+{
+  /* USER CODE BEGIN Radio_Batch_Start_1 */
+
+  /* USER CODE END Radio_Batch_Start_1 */
+  /* the previous batch may still be executed by CM0+: wait for its response */
+  (void) RadioGetFeatureCmdComPtr();
+  radio_batch_cnt = 0;
+  radio_batch_cmd_nb = 0;
+  radio_batch_on = true;
+  /* USER CODE BEGIN Radio_Batch_Start_2 */
+
+  /* USER CODE END Radio_Batch_Start_2 */
+}
+
+void Radio_Batch_Send(void)
+{
+  /* USER CODE BEGIN Radio_Batch_Send_1 */
+
+  /* USER CODE END Radio_Batch_Send_1 */
+  radio_batch_on = false;
+  /* the response is waited for by the next radio command */
+  (void) RadioBatchFlush(false);
+  /* USER CODE BEGIN Radio_Batch_Send_2 */
+
+  /* USER CODE END Radio_Batch_Send_2 */
+}
+
 /* USER CODE BEGIN EF */
 
 /* USER CODE END EF */
 
 /* Private Functions Definition -----------------------------------------------*/
+static MBMUX_ComParam_t *RadioGetCmdComPtr(uint32_t paramSize)
+{
+  if (radio_batch_on == false)
+  {
+    return RadioGetFeatureCmdComPtr();
+  }
+
+  if ((1 + paramSize) > MAX_PARAM_OF_RADIO_BATCH_FUNCTIONS)
+  {
+    Error_Handler();
+  }
+  if ((radio_batch_cnt + 1 + paramSize) > MAX_PARAM_OF_RADIO_BATCH_FUNCTIONS)
+  {
+    /* batch is full: execute it before adding the command */
+    (void) RadioBatchFlush(true);
+  }
+
+  /* parameters are written after the command header word */
+  radio_batch_com_obj.ParamBuf = &aRadioBatchBuff[radio_batch_cnt + 1];
+  radio_batch_com_obj.ParamCnt = 0;
+  radio_batch_com_obj.ReturnVal = 0;
+  return &radio_batch_com_obj;
+}
+
+static void RadioSendCmd(MBMUX_ComParam_t *comObj, bool waitResp)
+{
+  if (radio_batch_on == false)
+  {
+    MBMUXIF_RadioSendCmd();
+    return;
+  }
+
+  aRadioBatchBuff[radio_batch_cnt] = RADIO_BATCH_HEADER(comObj->MsgId, comObj->ParamCnt);
+  radio_batch_cnt += 1 + comObj->ParamCnt;
+  radio_batch_cmd_nb++;
+
+  if (waitResp == true)
+  {
+    comObj->ReturnVal = RadioBatchFlush(true);
+  }
+}
+
+static uint32_t RadioBatchFlush(bool waitResp)
+{
+  MBMUX_ComParam_t *com_obj;
+  uint32_t *com_buffer;
+  uint16_t i = 0;
+  uint16_t cmd_nb = radio_batch_cmd_nb;
+  uint32_t ret = 0;
+
+  if (radio_batch_cnt == 0)
+  {
+    return ret;
+  }
+
+  com_obj = RadioGetFeatureCmdComPtr();
+  com_obj->MsgId = RADIO_BATCH_ID;
+  com_buffer = com_obj->ParamBuf;
+  com_buffer[i++] = (uint32_t) aRadioBatchBuff;
+  com_buffer[i++] = (uint32_t) radio_batch_cnt;
+  com_obj->ParamCnt = i;
+  radio_batch_cnt = 0;
+  radio_batch_cmd_nb = 0;
+
+  if (waitResp == true)
+  {
+    MBMUXIF_RadioSendCmd();
+    RadioBatchCheck(com_obj, cmd_nb);
+    ret = com_obj->ReturnVal;
+  }
+  else
+  {
+    radio_batch_async_nb = cmd_nb;
+    MBMUXIF_RadioSendCmdAsync();
+  }
+  return ret;
+}
+
+static MBMUX_ComParam_t *RadioGetFeatureCmdComPtr(void)
+{
+  MBMUX_ComParam_t *com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+
+  if (radio_batch_async_nb != 0)
+  {
+    RadioBatchCheck(com_obj, radio_batch_async_nb);
+    radio_batch_async_nb = 0;
+  }
+  return com_obj;
+}
+
+static void RadioBatchCheck(MBMUX_ComParam_t *comObj, uint16_t cmdNb)
+{
+  /* CM0+ stops the batch at the first command returning a non-zero value: only the
+     last command of a batch may return a value, the others are not executed otherwise */
+  if ((comObj->ParamCnt != 1) || (comObj->ParamBuf[0] != cmdNb))
+  {
+    Error_Handler();
+  }
+}
+
 static void RadioInit(RadioEvents_t *events)
 {
   /* USER CODE BEGIN RadioInit_1 */
@@ -572,10 +780,10 @@ static void RadioInit(RadioEvents_t *events)
   radioevents_wrap.FhssChangeChannel = events->FhssChangeChannel;
   radioevents_wrap.CadDone = events->CadDone;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_INIT_ID;
   com_obj->ParamCnt = 0;
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -597,10 +805,10 @@ static RadioState_t RadioGetStatus(void)
   MBMUX_ComParam_t *com_obj;
   uint32_t ret;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_GET_STATUS_ID;
   com_obj->ParamCnt = 0;
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -619,7 +827,7 @@ static void RadioSetModem(RadioModems_t modem)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SET_MODEM_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) modem;
@@ -628,7 +836,7 @@ static void RadioSetModem(RadioModems_t modem)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -646,7 +854,7 @@ static void RadioSetChannel(uint32_t freq)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SET_CHANNEL_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) freq;
@@ -655,7 +863,7 @@ static void RadioSetChannel(uint32_t freq)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -674,7 +882,7 @@ static bool RadioIsChannelFree(uint32_t freq, uint32_t rxBandwidth, int16_t rssi
   uint16_t i = 0;
   uint32_t ret;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_IS_CHANNEL_FREE_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) freq;
@@ -686,7 +894,7 @@ static bool RadioIsChannelFree(uint32_t freq, uint32_t rxBandwidth, int16_t rssi
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -704,10 +912,10 @@ static uint32_t RadioRandom(void)
   MBMUX_ComParam_t *com_obj;
   uint32_t ret;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_RANDOM_ID;
   com_obj->ParamCnt = 0;
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -732,7 +940,7 @@ static void RadioSetRxConfig(RadioModems_t modem, uint32_t bandwidth,
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SET_RX_CONFIG_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) modem;
@@ -754,7 +962,7 @@ static void RadioSetRxConfig(RadioModems_t modem, uint32_t bandwidth,
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -776,7 +984,7 @@ static void RadioSetTxConfig(RadioModems_t modem, int8_t power, uint32_t fdev,
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SET_TX_CONFIG_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) modem;
@@ -797,7 +1005,7 @@ static void RadioSetTxConfig(RadioModems_t modem, int8_t power, uint32_t fdev,
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -816,7 +1024,7 @@ static bool RadioCheckRfFrequency(uint32_t frequency)
   uint16_t i = 0;
   uint32_t ret;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_CHECK_RF_FREQUENCY_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) frequency;
@@ -825,7 +1033,7 @@ static bool RadioCheckRfFrequency(uint32_t frequency)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -848,7 +1056,7 @@ static uint32_t RadioGetTimeOnAir(RadioModems_t modem, uint32_t bandwidth,
   uint16_t i = 0;
   uint32_t ret;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_GET_TIME_ON_AIR_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) modem;
@@ -864,7 +1072,7 @@ static uint32_t RadioGetTimeOnAir(RadioModems_t modem, uint32_t bandwidth,
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -884,7 +1092,7 @@ static radio_status_t RadioSend(uint8_t *buffer, uint8_t size)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SEND_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) buffer;
@@ -894,7 +1102,7 @@ static radio_status_t RadioSend(uint8_t *buffer, uint8_t size)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -911,10 +1119,10 @@ static void RadioSleep(void)
   /* USER CODE END RadioSleep_1 */
   MBMUX_ComParam_t *com_obj;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SLEEP_ID;
   com_obj->ParamCnt = 0;
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -930,10 +1138,10 @@ static void RadioStandby(void)
   /* USER CODE END RadioStandby_1 */
   MBMUX_ComParam_t *com_obj;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_STANDBY_ID;
   com_obj->ParamCnt = 0;
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -951,7 +1159,7 @@ static void RadioRx(uint32_t timeout)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_RX_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) timeout;
@@ -960,7 +1168,7 @@ static void RadioRx(uint32_t timeout)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -976,10 +1184,10 @@ static void RadioStartCad(void)
   /* USER CODE END RadioStartCad_1 */
   MBMUX_ComParam_t *com_obj;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_START_CAD_ID;
   com_obj->ParamCnt = 0;
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -997,7 +1205,7 @@ static void RadioSetTxContinuousWave(uint32_t freq, int8_t power, uint16_t time)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SET_TX_CONTINUOUS_WAVE_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) freq;
@@ -1008,7 +1216,7 @@ static void RadioSetTxContinuousWave(uint32_t freq, int8_t power, uint16_t time)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1027,7 +1235,7 @@ static int16_t RadioRssi(RadioModems_t modem)
   uint16_t i = 0;
   uint32_t ret;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_RSSI_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) modem;
@@ -1036,7 +1244,7 @@ static int16_t RadioRssi(RadioModems_t modem)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -1055,7 +1263,7 @@ static void RadioWrite(uint16_t addr, uint8_t data)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_WRITE_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) addr;
@@ -1065,7 +1273,7 @@ static void RadioWrite(uint16_t addr, uint8_t data)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1084,7 +1292,7 @@ static uint8_t RadioRead(uint16_t addr)
   uint16_t i = 0;
   uint32_t ret;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_READ_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) addr;
@@ -1093,7 +1301,7 @@ static uint8_t RadioRead(uint16_t addr)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -1112,18 +1320,25 @@ static void RadioWriteRegisters(uint16_t addr, uint8_t *buffer, uint8_t size)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(3 + ((size + 3) / 4));
   com_obj->MsgId = RADIO_WRITE_BUFFER_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) addr;
   com_buffer[i++] = (uint32_t) buffer;
   com_buffer[i++] = (uint32_t) size;
+  if (radio_batch_on == true)
+  {
+    /* the batched command may be executed after return: copy the data in the batch */
+    UTIL_MEM_cpy_8(&com_buffer[i], buffer, size);
+    com_buffer[1] = (uint32_t) &com_buffer[i];
+    i += (size + 3) / 4;
+  }
   com_obj->ParamCnt = i;
-  if (i > MAX_PARAM_OF_RADIO_CMD_FUNCTIONS)
+  if ((radio_batch_on == false) && (i > MAX_PARAM_OF_RADIO_CMD_FUNCTIONS))
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1141,7 +1356,7 @@ static void RadioReadRegisters(uint16_t addr, uint8_t *buffer, uint8_t size)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_READ_BUFFER_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) addr;
@@ -1152,7 +1367,7 @@ static void RadioReadRegisters(uint16_t addr, uint8_t *buffer, uint8_t size)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1170,7 +1385,7 @@ static void RadioSetMaxPayloadLength(RadioModems_t modem, uint8_t max)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SET_MAX_PAYLOAD_LENGTH_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) modem;
@@ -1180,7 +1395,7 @@ static void RadioSetMaxPayloadLength(RadioModems_t modem, uint8_t max)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1198,7 +1413,7 @@ static void RadioSetPublicNetwork(bool enable)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SET_PUBLIC_NETWORK_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) enable;
@@ -1207,7 +1422,7 @@ static void RadioSetPublicNetwork(bool enable)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1224,10 +1439,10 @@ static uint32_t RadioGetWakeUpTime(void)
   MBMUX_ComParam_t *com_obj;
   uint32_t ret;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_GET_WAKEUP_TIME_ID;
   com_obj->ParamCnt = 0;
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -1244,10 +1459,10 @@ static void RadioIrqProcess(void)
   /* USER CODE END RadioIrqProcess_1 */
   MBMUX_ComParam_t *com_obj;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_IRQ_PROCESS_ID;
   com_obj->ParamCnt = 0;
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1265,7 +1480,7 @@ static void RadioRxBoosted(uint32_t timeout)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_RX_BOOSTED_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) timeout;
@@ -1274,7 +1489,7 @@ static void RadioRxBoosted(uint32_t timeout)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1292,7 +1507,7 @@ static void RadioSetRxDutyCycle(uint32_t rxTime, uint32_t sleepTime)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SET_RX_DUTY_CYCLE_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) rxTime;
@@ -1302,7 +1517,7 @@ static void RadioSetRxDutyCycle(uint32_t rxTime, uint32_t sleepTime)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1319,14 +1534,14 @@ static void RadioTxPrbs(void)
   MBMUX_ComParam_t *com_obj;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_TX_PRBS_ID;
   com_obj->ParamCnt = i;
   if (i > MAX_PARAM_OF_RADIO_CMD_FUNCTIONS)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1344,7 +1559,7 @@ static void RadioTxCw(int8_t power)
   uint32_t *com_buffer;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_TX_CW_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) power;
@@ -1353,7 +1568,7 @@ static void RadioTxCw(int8_t power)
   {
     Error_Handler();
   }
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, false);
   /* waiting for event */
   /* once event is received and semaphore released: */
   return;
@@ -1373,7 +1588,7 @@ static int32_t RadioSetRxGenericConfig(GenericModems_t modem, RxConfigGeneric_t
   uint32_t ret;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SET_RX_GENERIC_CONFIG_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) modem;
@@ -1381,7 +1596,7 @@ static int32_t RadioSetRxGenericConfig(GenericModems_t modem, RxConfigGeneric_t
   com_buffer[i++] = (uint32_t) rxContinuous;
   com_buffer[i++] = (uint32_t) symbTimeout;
   com_obj->ParamCnt = i;
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -1401,7 +1616,7 @@ static int32_t RadioSetTxGenericConfig(GenericModems_t modem, TxConfigGeneric_t
   uint32_t ret;
   uint16_t i = 0;
 
-  com_obj = MBMUXIF_GetRadioFeatureCmdComPtr();
+  com_obj = RadioGetCmdComPtr(MAX_PARAM_OF_RADIO_CMD_FUNCTIONS);
   com_obj->MsgId = RADIO_SET_TX_GENERIC_CONFIG_ID;
   com_buffer = com_obj->ParamBuf;
   com_buffer[i++] = (uint32_t) modem;
@@ -1409,7 +1624,7 @@ static int32_t RadioSetTxGenericConfig(GenericModems_t modem, TxConfigGeneric_t
   com_buffer[i++] = (uint32_t) power;
   com_buffer[i++] = (uint32_t) timeout;
   com_obj->ParamCnt = i;
-  MBMUXIF_RadioSendCmd();
+  RadioSendCmd(com_obj, true);
   /* waiting for event */
   /* once event is received and semaphore released: */
   ret = com_obj->ReturnVal;
@@ -61,6 +61,23 @@ extern "C" {
   */
 void Process_Radio_Notif(MBMUX_ComParam_t *ComObj);
 
+/**
+  * @brief Starts a radio commands batch: the following Radio calls returning nothing
+  *        are queued, a call returning a value (or ReadRegisters) sends the queued
+  *        commands with it to CM0+ and waits for their execution
+  * @note  Radio_Batch_Start and Radio_Batch_Send shall be called from the same task
+  * @note  CM0+ stops a batch at the first command returning a non-zero value, so only
+  *        void commands are queued. A batch rejected or not fully executed by CM0+
+  *        calls Error_Handler
+  */
+void Radio_Batch_Start(void);
+
+/**
+  * @brief Sends the queued radio commands to CM0+ in a single command, without
+  *        waiting for their execution, and ends the batch
+  */
+void Radio_Batch_Send(void);
+
 /* USER CODE BEGIN EFP */
 
 /* USER CODE END EFP */
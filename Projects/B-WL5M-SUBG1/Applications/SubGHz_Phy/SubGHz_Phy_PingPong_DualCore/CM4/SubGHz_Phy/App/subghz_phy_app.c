@@ -30,6 +30,7 @@
 #include "utilities_def.h"
 #include "app_version.h"
 #include "mbmuxif_sys.h"
+#include "radio_mbwrapper.h"
 /* USER CODE END Includes */
 
 /* External variables ---------------------------------------------------------*/
@@ -200,6 +201,9 @@ void SubghzApp_Init(void)
   /*calculate random delay for synchronization*/
   random_delay = (Radio.Random()) >> 22; /*10bits random e.g. from 0 to 1023 ms*/
 
+  /* Radio configuration commands are sent to CM0PLUS in a single batch */
+  Radio_Batch_Start();
+
   /* Radio Set frequency */
   Radio.SetChannel(RF_FREQUENCY);
 
@@ -251,6 +255,8 @@ void SubghzApp_Init(void)
   /*starts reception*/
   Radio.Rx(RX_TIMEOUT_VALUE + random_delay);
 
+  Radio_Batch_Send();
+
   /*register task to to be run in while(1) after Radio IT*/
   UTIL_SEQ_RegTask((1 << CFG_SEQ_Task_SubGHz_Phy_App_Process), UTIL_SEQ_RFU, PingPong_Process);
   /* USER CODE END SubghzApp_Init_2 */
@@ -349,6 +355,10 @@ static void OnRxError(void)
 /* USER CODE BEGIN PrFD */
 static void PingPong_Process(void)
 {
+  /* Radio commands are sent to CM0PLUS in a single batch: the commands returning a value
+     (Radio.GetWakeupTime, Radio.Send) execute the batch before returning */
+  Radio_Batch_Start();
+
   Radio.Sleep();
 
   switch (State)
@@ -453,6 +463,8 @@ static void PingPong_Process(void)
     default:
       break;
   }
+
+  Radio_Batch_Send();
 }
 
 static void OnledEvent(void *context)
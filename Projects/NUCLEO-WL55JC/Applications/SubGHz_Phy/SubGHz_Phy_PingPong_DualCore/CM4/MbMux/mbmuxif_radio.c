@@ -56,6 +56,11 @@
 /* Private variables ---------------------------------------------------------*/
 static MBMUX_ComParam_t *RadioComObj;
 
+/**
+  * @brief set while the response of a Radio-Cmd sent by MBMUXIF_RadioSendCmdAsync is not received
+  */
+static bool RadioRespPending = false;
+
 /**
   * @brief radio cmd buffer to exchange data between CM4 and CM0+
   */
@@ -158,6 +163,12 @@ MBMUX_ComParam_t *MBMUXIF_GetRadioFeatureCmdComPtr(void)
   {
     Error_Handler(); /* feature isn't registered */
   }
+  if (RadioRespPending == true)
+  {
+    /* com buffer is still used by CM0PLUS */
+    UTIL_SEQ_WaitEvt(1 << CFG_SEQ_Evt_MbRadioRespRcv);
+    RadioRespPending = false;
+  }
   return com_param_ptr;
   /* USER CODE BEGIN MBMUXIF_GetRadioFeatureCmdComPtr_Last */
 
@@ -182,6 +193,24 @@ void MBMUXIF_RadioSendCmd(void)
   /* USER CODE END MBMUXIF_RadioSendCmd_Last */
 }
 
+void MBMUXIF_RadioSendCmdAsync(void)
+{
+  /* USER CODE BEGIN MBMUXIF_RadioSendCmdAsync_1 */
+
+  /* USER CODE END MBMUXIF_RadioSendCmdAsync_1 */
+  if (MBMUX_CommandSnd(FEAT_INFO_RADIO_ID) == 0)
+  {
+    RadioRespPending = true;
+  }
+  else
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN MBMUXIF_RadioSendCmdAsync_Last */
+
+  /* USER CODE END MBMUXIF_RadioSendCmdAsync_Last */
+}
+
 void MBMUXIF_RadioSendAck(void)
 {
   /* USER CODE BEGIN MBMUXIF_RadioSendAck_1 */
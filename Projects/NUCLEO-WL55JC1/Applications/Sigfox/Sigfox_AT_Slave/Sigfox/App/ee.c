@@ -32,6 +32,11 @@
 
 /* USER CODE END EV */
 
+/* RAM index of the virtual addresses, disabled by default */
+#ifndef CFG_EE_RAM_INDEX
+#define CFG_EE_RAM_INDEX           0
+#endif /* !CFG_EE_RAM_INDEX */
+
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
 typedef struct
@@ -51,6 +56,12 @@ typedef struct
   /* Write position inside the current write page */
   uint16_t next_write_offset;
 
+#if (CFG_EE_RAM_INDEX != 0)
+  /* Flash position of the last update of each virtual address, in flash
+     words from the bank base address (0 if the address is not written) */
+  uint16_t *index;
+#endif /* CFG_EE_RAM_INDEX */
+
 } EE_var_t;
 /* USER CODE END PTD */
 
@@ -111,6 +122,22 @@ enum
 #define EE_NEXT_POOL( pv ) \
   (((pv)->current_write_page < (pv)->nb_pages) ? (pv)->nb_pages : 0)
 
+/* Macro to check that an element read from flash is a valid update of the
+   virtual address "addr": in case of failed CRC, data is corrupted */
+#define EE_VALID_ELT( el_, addr_ ) \
+  (((el_) != EE_ERASED) && ((el_) != 0ULL) && \
+   ((((el_) & 0x3FFFFFFFUL) >> 16) == (addr_)) && \
+   (EE_Crc(el_) == (uint16_t)(el_)))
+
+/* Number of virtual addresses kept by a pool transfer (and in RAM index) */
+#define EE_NB_ADDR( bank_size_ ) \
+  (EE_NB_MAX_ELT * ((bank_size_) / (2 * HW_FLASH_PAGE_SIZE)))
+
+/* Macro to check if a RAM index position is in the current write pool */
+#define EE_INDEX_IN_CURRENT_POOL( pv, pos_ ) \
+  ((((pos_) / (HW_FLASH_PAGE_SIZE / HW_FLASH_WIDTH)) < (pv)->nb_pages) == \
+   ((pv)->current_write_page < (pv)->nb_pages))
+
 /* Check Configuration */
 #if (CFG_EE_BANK0_SIZE & ((2 * HW_FLASH_PAGE_SIZE) - 1))
 #error EE: wrong value of CFG_EE_BANK0_SIZE
@@ -129,6 +156,11 @@ enum
       (CFG_EE_BANK1_MAX_NB > 0x4000U)))
 #error EE: CFG_EE_BANK1_MAX_NB too big
 #endif /* CFG_EE_BANK1_SIZE */
+#if ((CFG_EE_RAM_INDEX != 0) && \
+     ((CFG_EE_BANK0_SIZE / HW_FLASH_WIDTH > 0x10000UL) || \
+      (CFG_EE_BANK1_SIZE / HW_FLASH_WIDTH > 0x10000UL)))
+#error EE: bank too big for CFG_EE_RAM_INDEX
+#endif /* CFG_EE_RAM_INDEX */
 
 /* Macro used in CRC computation (one byte CRC step) */
 #define EE_CRC16_STEP( v, x, crc ) \
@@ -150,6 +182,13 @@ enum
 /* Private variables ---------------------------------------------------------*/
 EE_var_t EE_var[CFG_EE_BANK1_SIZE ? 2 : 1];
 
+#if (CFG_EE_RAM_INDEX != 0)
+static uint16_t EE_index0[EE_NB_ADDR(CFG_EE_BANK0_SIZE)];
+#if (CFG_EE_BANK1_SIZE != 0)
+static uint16_t EE_index1[EE_NB_ADDR(CFG_EE_BANK1_SIZE)];
+#endif /* CFG_EE_BANK1_SIZE */
+#endif /* CFG_EE_RAM_INDEX */
+
 /* USER CODE BEGIN PV */
 
 /* USER CODE END PV */
@@ -173,6 +212,12 @@ static uint32_t EE_GetState(const EE_var_t *pv, uint32_t page);
 
 static uint16_t EE_Crc(uint64_t v);
 
+#if (CFG_EE_RAM_INDEX != 0)
+static void EE_IndexScan(EE_var_t *pv, uint32_t first_page, uint32_t last_page);
+
+static int32_t EE_IndexRead(const EE_var_t *pv, uint16_t addr, uint32_t *data);
+#endif /* CFG_EE_RAM_INDEX */
+
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
@@ -189,6 +234,13 @@ int32_t EE_Init(int32_t format, uint32_t base_address)
 
   /* Reset global variables of both banks */
 
+#if (CFG_EE_RAM_INDEX != 0)
+  EE_var[0].index = EE_index0;
+#if (CFG_EE_BANK1_SIZE != 0)
+  EE_var[1].index = EE_index1;
+#endif /* CFG_EE_BANK1_SIZE */
+#endif /* CFG_EE_RAM_INDEX */
+
   EE_Reset(&EE_var[0],
            base_address,
            CFG_EE_BANK0_SIZE / (2 * HW_FLASH_PAGE_SIZE));
@@ -246,6 +298,16 @@ int32_t EE_Read(int32_t bank, uint16_t addr, uint32_t *data)
   /* USER CODE END EE_Read_1 */
   EE_var_t *pv = &EE_var[CFG_EE_BANK1_SIZE && bank];
 
+#if (CFG_EE_RAM_INDEX != 0)
+  /* Get element from its position in RAM index */
+  int32_t status = EE_IndexRead(pv, addr, data);
+
+  if (status != EE_STATE_ERROR)
+  {
+    return status;
+  }
+#endif /* CFG_EE_RAM_INDEX */
+
   /* Read element starting from active page */
   return EE_ReadEl(pv, addr, data, pv->current_write_page);
   /* USER CODE BEGIN EE_Read_2 */
@@ -359,12 +421,23 @@ static void EE_Reset(EE_var_t *pv, uint32_t address, uint8_t nb_pages)
   /* USER CODE BEGIN EE_Reset_1 */
 
   /* USER CODE END EE_Reset_1 */
+#if (CFG_EE_RAM_INDEX != 0)
+  uint32_t i;
+
+#endif /* CFG_EE_RAM_INDEX */
   /* Reset global variables of the bank */
   pv->address = address;
   pv->nb_pages = nb_pages;
   pv->current_write_page = 0;
   pv->nb_written_elements = 0;
   pv->next_write_offset = EE_HEADER_SIZE;
+
+#if (CFG_EE_RAM_INDEX != 0)
+  for (i = 0; i < EE_NB_MAX_ELT * nb_pages; i++)
+  {
+    pv->index[i] = 0;
+  }
+#endif /* CFG_EE_RAM_INDEX */
   /* USER CODE BEGIN EE_Reset_2 */
 
   /* USER CODE END EE_Reset_2 */
@@ -394,14 +467,11 @@ static int32_t EE_Recovery(EE_var_t *pv)
 
       if ((page == 0) || (page == pv->nb_pages))
       {
-        /* Check if state is reliable by checking state of next page */
-        uint32_t next_page = page + 1;
-        /*make sure next page is in range, else modulo*/
-        if (next_page == pv->nb_pages * 2)
-        {
-          next_page = 0;
-        }
-        if (EE_GetState(pv, next_page) != EE_STATE_ERASED)
+        /* Check if state is reliable by checking state of next page of the
+           pool. With single page pools, the next page is the other pool,
+           which is not erased during a transfer: RECEIVE is searched before
+           ACTIVE, so the new pool is found first */
+        if ((pv->nb_pages > 1) && (EE_GetState(pv, page + 1) != EE_STATE_ERASED))
         {
           continue;
         }
@@ -458,6 +528,17 @@ static int32_t EE_Recovery(EE_var_t *pv)
         page--;
       }
 
+#if (CFG_EE_RAM_INDEX != 0)
+      /* Rebuild RAM index: old pool first in case of interrupted transfer,
+         so that elements already transferred point to the new pool */
+      if (state == EE_STATE_RECEIVE)
+      {
+        first_page = EE_NEXT_POOL(pv);
+        EE_IndexScan(pv, first_page, first_page + pv->nb_pages - 1);
+      }
+      EE_IndexScan(pv, page, pv->current_write_page);
+#endif /* CFG_EE_RAM_INDEX */
+
       /* If we have found a RECEIVE page, it means that pool transfer
          has been interrupted by reset */
       if (state == EE_STATE_RECEIVE)
@@ -550,6 +631,29 @@ static int32_t EE_Transfer(EE_var_t *pv, uint16_t addr, uint32_t page)
 
   for (var = 0; var < EE_NB_MAX_ELT * pv->nb_pages; var++)
   {
+#if (CFG_EE_RAM_INDEX != 0)
+    /* Copy the variables whose last update is still in the old pool
+       (the one passed as parameter and the ones already transferred
+       in case of recovery are in the new pool) */
+    uint32_t pos = pv->index[var];
+    uint64_t el;
+
+    if ((pos == 0) || EE_INDEX_IN_CURRENT_POOL(pv, pos))
+    {
+      continue;
+    }
+
+    el = *EE_PTR(pv->address + (pos * HW_FLASH_WIDTH));
+    if (EE_VALID_ELT(el, var))
+    {
+      if (EE_WriteEl(pv, var, (uint32_t)(el >> 32)) != EE_OK)
+      {
+        return EE_WRITE_ERROR;
+      }
+      continue;
+    }
+#endif /* CFG_EE_RAM_INDEX */
+
     /* Check each variable except the one passed as parameter
        (and except the ones already transferred in case of recovery) */
     if ((var != addr) &&
@@ -636,6 +740,15 @@ static int32_t EE_WriteEl(EE_var_t *pv, uint16_t addr, uint32_t data)
     return EE_WRITE_ERROR;
   }
 
+#if (CFG_EE_RAM_INDEX != 0)
+  /* Update position of the virtual address in RAM index */
+  if ((addr != EE_TAG) && ((addr & 0x3FFFUL) < EE_NB_MAX_ELT * pv->nb_pages))
+  {
+    pv->index[addr & 0x3FFFUL] =
+      (uint16_t)((flash_addr - pv->address) / HW_FLASH_WIDTH);
+  }
+#endif /* CFG_EE_RAM_INDEX */
+
   /* Increment global variables relative to write operation done */
   pv->next_write_offset += HW_FLASH_WIDTH;
   pv->nb_written_elements++;
@@ -669,9 +782,7 @@ static int32_t EE_ReadEl(const EE_var_t *pv,
 
       /* Compare the read address with the input address and check CRC:
          in case of failed CRC, data is corrupted and has to be skipped */
-      if ((el != EE_ERASED) && (el != 0ULL) &&
-          (((el & 0x3FFFFFFFUL) >> 16) == addr) &&
-          (EE_Crc(el) == (uint16_t)el))
+      if (EE_VALID_ELT(el, addr))
       {
         /* Get variable data */
         *data = (uint32_t)(el >> 32);
@@ -773,6 +884,67 @@ static uint16_t EE_Crc(uint64_t v)
   /* USER CODE END EE_Crc_2 */
 }
 
+#if (CFG_EE_RAM_INDEX != 0)
+static void EE_IndexScan(EE_var_t *pv, uint32_t first_page, uint32_t last_page)
+{
+  uint32_t page;
+  uint32_t offset;
+  uint32_t addr;
+  uint64_t el;
+
+  /* Elements are scanned in write order: the last valid update of each
+     virtual address is the one kept in RAM index */
+  for (page = first_page; page <= last_page; page++)
+  {
+    for (offset = EE_HEADER_SIZE; offset < HW_FLASH_PAGE_SIZE;
+         offset += HW_FLASH_WIDTH)
+    {
+      el = *EE_PTR(EE_FLASH_ADDR(pv, page) + offset);
+
+      if (el == EE_ERASED)
+      {
+        break;
+      }
+
+      addr = (el & 0x3FFFFFFFUL) >> 16;
+      if ((addr < EE_NB_MAX_ELT * pv->nb_pages) && EE_VALID_ELT(el, addr))
+      {
+        pv->index[addr] = (uint16_t)
+                          (((page * HW_FLASH_PAGE_SIZE) + offset) / HW_FLASH_WIDTH);
+      }
+    }
+  }
+}
+
+static int32_t EE_IndexRead(const EE_var_t *pv, uint16_t addr, uint32_t *data)
+{
+  uint32_t pos;
+  uint64_t el;
+
+  /* Addresses out of RAM index are searched in flash */
+  if (addr >= EE_NB_MAX_ELT * pv->nb_pages)
+  {
+    return EE_STATE_ERROR;
+  }
+
+  pos = pv->index[addr];
+  if (pos == 0)
+  {
+    return EE_NOT_FOUND;
+  }
+
+  /* Check element in flash: a mismatch falls back to the flash search */
+  el = *EE_PTR(pv->address + (pos * HW_FLASH_WIDTH));
+  if (!EE_VALID_ELT(el, addr))
+  {
+    return EE_STATE_ERROR;
+  }
+
+  *data = (uint32_t)(el >> 32);
+  return EE_OK;
+}
+#endif /* CFG_EE_RAM_INDEX */
+
 /* USER CODE BEGIN PrFD */
 
 /* USER CODE END PrFD */
@@ -73,6 +73,14 @@ extern "C" {
   */
 #define CFG_EE_BANK1_MAX_NB            0
 
+/**
+  * @brief RAM index of the virtual addresses (0: disabled, 1: enabled)
+  * @note  O(1) reads, costs 2 bytes of RAM per flash word of a pool
+  */
+#ifndef CFG_EE_RAM_INDEX
+#define CFG_EE_RAM_INDEX               1
+#endif /* !CFG_EE_RAM_INDEX */
+
 /**
   * @brief EEPROM Flash address
   * @note last 2 sector of a 128kBytes device
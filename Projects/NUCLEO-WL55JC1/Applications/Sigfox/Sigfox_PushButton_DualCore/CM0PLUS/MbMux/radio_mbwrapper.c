@@ -48,6 +48,10 @@
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
+/**
+  * @brief return value of a radio batch whose buffer is rejected
+  */
+#define RADIO_BATCH_REJECTED  0xFFFFFFFFU
 
 /* USER CODE BEGIN PD */
 
@@ -106,6 +110,14 @@ static void RadioRxTimeout_mbwrapper(void);
  */
 static void RadioRxError_mbwrapper(void);
 
+/*!
+ * \brief Executes a radio command
+ *
+ * \param[in,out] ComObj com param of the command, updated with the return value
+ * \param[in] com_buffer verified parameters of the command
+ */
+static void Radio_Cmd_Execute(MBMUX_ComParam_t *ComObj, uint32_t *com_buffer);
+
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
@@ -117,15 +129,80 @@ void Process_Radio_Cmd(MBMUX_ComParam_t *ComObj)
 
   /* USER CODE END Process_Radio_Cmd_1 */
   uint32_t *com_buffer = NULL;
-  uint32_t ret_uint;
-  int32_t ret_int;
-  radio_status_t ret_status;
-  RadioState_t state;
+  uint32_t *batch = NULL;
+  uint32_t batch_cnt = 0;
+  uint32_t cmd_cnt = 0;
+  uint32_t i = 0;
+  uint16_t param_cnt;
+  MBMUX_ComParam_t batch_obj;
 
   APP_LOG(TS_ON, VLEVEL_H, ">CM0PLUS(Radio)\r\n");
 
   com_buffer = MBMUX_SEC_VerifySramBufferPtr(ComObj->ParamBuf, ComObj->BufSize);
 
+  if (ComObj->MsgId == RADIO_BATCH_ID)
+  {
+    if ((com_buffer != NULL) && (com_buffer[1] <= MAX_PARAM_OF_RADIO_BATCH_FUNCTIONS))
+    {
+      batch_cnt = com_buffer[1];
+      batch = MBMUX_SEC_VerifySramBufferPtr((uint32_t *) com_buffer[0], batch_cnt * sizeof(uint32_t));
+    }
+    if (batch == NULL)
+    {
+      /* batch rejected: none of its commands is executed */
+      ComObj->ParamCnt = 0;
+      ComObj->ReturnVal = RADIO_BATCH_REJECTED;
+    }
+    else
+    {
+      /* process the commands of the batch in sequence. Only the last one may return
+         a value: the batch stops at the first command returning a non-zero value */
+      batch_obj.ReturnVal = 0;
+      while ((i < batch_cnt) && (batch_obj.ReturnVal == 0))
+      {
+        /* header word: MsgId | ParamCnt << 16, followed by the parameters */
+        param_cnt = (uint16_t)(batch[i] >> 16);
+        if ((i + 1 + param_cnt) > batch_cnt)
+        {
+          break;
+        }
+        batch_obj.MsgId = batch[i] & 0xFFFFU;
+        batch_obj.ParamCnt = param_cnt;
+        Radio_Cmd_Execute(&batch_obj, &batch[i + 1]);
+        cmd_cnt++;
+        i += 1 + param_cnt;
+      }
+      /* prepare response buffer: number of commands executed and return value of the last one */
+      com_buffer[0] = cmd_cnt;
+      ComObj->ParamCnt = 1;
+      ComObj->ReturnVal = batch_obj.ReturnVal; /* */
+    }
+  }
+  else
+  {
+    Radio_Cmd_Execute(ComObj, com_buffer);
+  }
+
+  /* send Response */
+  APP_LOG(TS_ON, VLEVEL_H, "<CM0PLUS(Radio)\r\n");
+  MBMUX_ResponseSnd(FEAT_INFO_RADIO_ID);
+  /* USER CODE BEGIN Process_Radio_Cmd_2 */
+
+  /* USER CODE END Process_Radio_Cmd_2 */
+}
+
+/* USER CODE BEGIN EF */
+
+/* USER CODE END EF */
+
+/* Private Functions Definition -----------------------------------------------*/
+static void Radio_Cmd_Execute(MBMUX_ComParam_t *ComObj, uint32_t *com_buffer)
+{
+  uint32_t ret_uint;
+  int32_t ret_int;
+  radio_status_t ret_status;
+  RadioState_t state;
+
   /* process Command */
   switch (ComObj->MsgId)
   {
@@ -364,20 +441,8 @@ void Process_Radio_Cmd(MBMUX_ComParam_t *ComObj)
     default:
       break;
   }
-
-  /* send Response */
-  APP_LOG(TS_ON, VLEVEL_H, "<CM0PLUS(Radio)\r\n");
-  MBMUX_ResponseSnd(FEAT_INFO_RADIO_ID);
-  /* USER CODE BEGIN Process_Radio_Cmd_2 */
-
-  /* USER CODE END Process_Radio_Cmd_2 */
 }
 
-/* USER CODE BEGIN EF */
-
-/* USER CODE END EF */
-
-/* Private Functions Definition -----------------------------------------------*/
 static void RadioTxDone_mbwrapper(void)
 {
   /* USER CODE BEGIN RadioTxDone_mbwrapper_1 */
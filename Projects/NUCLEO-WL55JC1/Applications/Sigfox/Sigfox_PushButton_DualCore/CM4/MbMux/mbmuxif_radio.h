@@ -65,6 +65,7 @@ int8_t MBMUXIF_RadioInit(void);
 
 /**
   * @brief   gives back the pointer to the com buffer associated to Radio feature Cmd
+  * @note    waits for the response of a pending Radio-Cmd sent by MBMUXIF_RadioSendCmdAsync
   * @retval  return pointer to the com param buffer
   */
 MBMUX_ComParam_t *MBMUXIF_GetRadioFeatureCmdComPtr(void);
@@ -74,6 +75,12 @@ MBMUX_ComParam_t *MBMUXIF_GetRadioFeatureCmdComPtr(void);
   */
 void MBMUXIF_RadioSendCmd(void);
 
+/**
+  * @brief   Sends a Radio-Cmd via Ipcc without waiting for the response
+  * @note    the response is waited for by the next MBMUXIF_GetRadioFeatureCmdComPtr
+  */
+void MBMUXIF_RadioSendCmdAsync(void);
+
 /**
   * @brief   Sends a Radio-Ack  via Ipcc without waiting for the ack
   */
@@ -0,0 +1,223 @@
+ /*******************************************************************************
+ * File Name          : stm32_timer_if_sim.c
+ * Description        : Virtual time backend of the time server and of SysTime,
+ *                      for host builds and deterministic simulations
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2019 STMicroelectronics.
+ * All rights reserved.</center></h2>
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32_timer_if_sim.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/*!
+ * @brief Minimum timeout of the virtual alarm, in ticks
+ * @note The virtual alarm can be set at the current time: a timer started with
+ *       a zero timeout expires on the next TIMER_IF_SIM_RunNextEvent call
+ */
+#define TIMER_IF_SIM_MIN_TIMEOUT    ( 0UL )
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/*!
+ * @brief Virtual clock, in ticks (ms)
+ */
+static uint32_t SimTime = 0;
+
+/*!
+ * @brief Timer Reference of the time server
+ */
+static uint32_t SimTimerContext = 0;
+
+/*!
+ * @brief Expiry time of the armed alarm
+ */
+static uint32_t SimAlarmTime = 0;
+
+/*!
+ * @brief Alarm armed flag
+ */
+static bool SimAlarmArmed = false;
+
+/*!
+ * @brief Virtual backUp registers used by SysTime
+ */
+static uint32_t SimBkUpSeconds = 0;
+static uint32_t SimBkUpSubSeconds = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Exported variables ---------------------------------------------------------*/
+const UTIL_TIMER_Driver_s UTIL_TimerDriver =
+{
+    TIMER_IF_SIM_Init,
+    TIMER_IF_SIM_DeInit,
+
+    TIMER_IF_SIM_StartTimer,
+    TIMER_IF_SIM_StopTimer,
+
+    TIMER_IF_SIM_SetTimerContext,
+    TIMER_IF_SIM_GetTimerContext,
+
+    TIMER_IF_SIM_GetTimerElapsedTime,
+    TIMER_IF_SIM_GetTimerValue,
+    TIMER_IF_SIM_GetMinimumTimeout,
+
+    TIMER_IF_SIM_Convert_ms2Tick,
+    TIMER_IF_SIM_Convert_Tick2ms,
+};
+
+const UTIL_SYSTIM_Driver_s UTIL_SYSTIMDriver =
+{
+    TIMER_IF_SIM_BkUp_Write_Seconds,
+    TIMER_IF_SIM_BkUp_Read_Seconds,
+    TIMER_IF_SIM_BkUp_Write_SubSeconds,
+    TIMER_IF_SIM_BkUp_Read_SubSeconds,
+    TIMER_IF_SIM_GetTime,
+};
+
+/* Exported functions ---------------------------------------------------------*/
+UTIL_TIMER_Status_t TIMER_IF_SIM_Init( void )
+{
+    SimTime = 0;
+    SimTimerContext = 0;
+    SimAlarmArmed = false;
+    SimBkUpSeconds = 0;
+    SimBkUpSubSeconds = 0;
+    return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t TIMER_IF_SIM_DeInit( void )
+{
+    SimAlarmArmed = false;
+    return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t TIMER_IF_SIM_StartTimer( uint32_t timeout )
+{
+    SimAlarmTime = SimTimerContext + timeout;
+    SimAlarmArmed = true;
+    return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t TIMER_IF_SIM_StopTimer( void )
+{
+    SimAlarmArmed = false;
+    return UTIL_TIMER_OK;
+}
+
+uint32_t TIMER_IF_SIM_GetMinimumTimeout( void )
+{
+    return ( TIMER_IF_SIM_MIN_TIMEOUT );
+}
+
+uint32_t TIMER_IF_SIM_Convert_ms2Tick( uint32_t timeMilliSec )
+{
+    return ( timeMilliSec );
+}
+
+uint32_t TIMER_IF_SIM_Convert_Tick2ms( uint32_t tick )
+{
+    return ( tick );
+}
+
+uint32_t TIMER_IF_SIM_GetTimerElapsedTime( void )
+{
+    return ( SimTime - SimTimerContext );
+}
+
+uint32_t TIMER_IF_SIM_GetTimerValue( void )
+{
+    return ( SimTime );
+}
+
+uint32_t TIMER_IF_SIM_SetTimerContext( void )
+{
+    SimTimerContext = SimTime;
+    return ( SimTimerContext );
+}
+
+uint32_t TIMER_IF_SIM_GetTimerContext( void )
+{
+    return ( SimTimerContext );
+}
+
+uint32_t TIMER_IF_SIM_GetTime( uint16_t *mSeconds )
+{
+    if( mSeconds != NULL )
+    {
+        *mSeconds = ( uint16_t )( SimTime % 1000U );
+    }
+    return ( SimTime / 1000U );
+}
+
+void TIMER_IF_SIM_BkUp_Write_Seconds( uint32_t Seconds )
+{
+    SimBkUpSeconds = Seconds;
+}
+
+uint32_t TIMER_IF_SIM_BkUp_Read_Seconds( void )
+{
+    return ( SimBkUpSeconds );
+}
+
+void TIMER_IF_SIM_BkUp_Write_SubSeconds( uint32_t SubSeconds )
+{
+    SimBkUpSubSeconds = SubSeconds;
+}
+
+uint32_t TIMER_IF_SIM_BkUp_Read_SubSeconds( void )
+{
+    return ( SimBkUpSubSeconds );
+}
+
+uint32_t TIMER_IF_SIM_GetNextEventDelay( void )
+{
+    if( SimAlarmArmed == false )
+    {
+        return ( TIMER_IF_SIM_NO_EVENT );
+    }
+    /* intentional wrap around, an alarm in the past is due now */
+    if( ( int32_t )( SimAlarmTime - SimTime ) <= 0 )
+    {
+        return ( 0 );
+    }
+    return ( SimAlarmTime - SimTime );
+}
+
+void TIMER_IF_SIM_Advance( uint32_t ticks )
+{
+    uint32_t delay;
+
+    while( ( ( delay = TIMER_IF_SIM_GetNextEventDelay( ) ) != TIMER_IF_SIM_NO_EVENT ) && ( delay <= ticks ) )
+    {
+        SimTime += delay;
+        ticks -= delay;
+        SimAlarmArmed = false;
+        UTIL_TIMER_IRQ_Handler( );
+    }
+    SimTime += ticks;
+}
+
+bool TIMER_IF_SIM_RunNextEvent( void )
+{
+    uint32_t delay = TIMER_IF_SIM_GetNextEventDelay( );
+
+    if( delay == TIMER_IF_SIM_NO_EVENT )
+    {
+        return false;
+    }
+    SimTime += delay;
+    SimAlarmArmed = false;
+    UTIL_TIMER_IRQ_Handler( );
+    return true;
+}
@@ -0,0 +1,171 @@
+/**
+ ******************************************************************************
+ * File Name          : stm32_timer_if_sim.h
+ * Description        : Virtual time backend of the time server and of SysTime,
+ *                      for host builds and deterministic simulations
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2019 STMicroelectronics.
+ * All rights reserved.</center></h2>
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef STM32_TIMER_IF_SIM_H__
+#define STM32_TIMER_IF_SIM_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include "stm32_timer.h"
+#include "stm32_systime.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * @brief Value returned by TIMER_IF_SIM_GetNextEventDelay when no alarm is armed
+ */
+#define TIMER_IF_SIM_NO_EVENT       ( 0xFFFFFFFFUL )
+
+/* External variables --------------------------------------------------------*/
+/* Exported macros -----------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+
+/*!
+ * @brief Initialize the virtual timer
+ * @note The virtual clock counts milliseconds: one tick is one millisecond.
+ *       It restarts at 0 and only moves when TIMER_IF_SIM_Advance or
+ *       TIMER_IF_SIM_RunNextEvent is called, nothing ever sleeps.
+ */
+UTIL_TIMER_Status_t TIMER_IF_SIM_Init( void );
+
+/*!
+ * @brief Un-initialize the virtual timer
+ */
+UTIL_TIMER_Status_t TIMER_IF_SIM_DeInit( void );
+
+/*!
+ * @brief Start the timer
+ * @note The timer is set at Reference + timeout
+ * @param timeout Duration of the Timer in ticks
+ */
+UTIL_TIMER_Status_t TIMER_IF_SIM_StartTimer( uint32_t timeout );
+
+/*!
+ * @brief Stop the timer
+ */
+UTIL_TIMER_Status_t TIMER_IF_SIM_StopTimer( void );
+
+/*!
+ * @brief Return the minimum timeout the virtual timer is able to handle
+ * @retval minimum value for a timeout
+ */
+uint32_t TIMER_IF_SIM_GetMinimumTimeout( void );
+
+/*!
+ * @brief Get the virtual timer elapsed time since the last Reference was set
+ * @retval Elapsed time in ticks
+ */
+uint32_t TIMER_IF_SIM_GetTimerElapsedTime( void );
+
+/*!
+ * @brief Get the virtual timer value
+ * @retval Virtual time in ticks
+ */
+uint32_t TIMER_IF_SIM_GetTimerValue( void );
+
+/*!
+ * @brief Set the virtual timer Reference
+ * @retval Timer Reference Value in Ticks
+ */
+uint32_t TIMER_IF_SIM_SetTimerContext( void );
+
+/*!
+ * @brief Get the virtual timer Reference
+ * @retval Timer Value in Ticks
+ */
+uint32_t TIMER_IF_SIM_GetTimerContext( void );
+
+/*!
+ * @brief converts time in ms to time in ticks
+ * @param [IN] time in milliseconds
+ * @retval returns time in ticks
+ */
+uint32_t TIMER_IF_SIM_Convert_ms2Tick( uint32_t timeMilliSec );
+
+/*!
+ * @brief converts time in ticks to time in ms
+ * @param [IN] time in ticks
+ * @retval returns time in milliseconds
+ */
+uint32_t TIMER_IF_SIM_Convert_Tick2ms( uint32_t tick );
+
+/*!
+ * @brief Get the virtual calendar time
+ * @param [OUT] mSeconds in ms
+ * @retval returns time seconds
+ */
+uint32_t TIMER_IF_SIM_GetTime( uint16_t *mSeconds );
+
+/*!
+ * @brief write seconds in the virtual backUp register
+ * @param [IN] time in seconds
+ */
+void TIMER_IF_SIM_BkUp_Write_Seconds( uint32_t Seconds );
+
+/*!
+ * @brief reads seconds from the virtual backUp register
+ * @retval Time in seconds
+ */
+uint32_t TIMER_IF_SIM_BkUp_Read_Seconds( void );
+
+/*!
+ * @brief writes SubSeconds in the virtual backUp register
+ * @param [IN] time in SubSeconds
+ */
+void TIMER_IF_SIM_BkUp_Write_SubSeconds( uint32_t SubSeconds );
+
+/*!
+ * @brief reads SubSeconds from the virtual backUp register
+ * @retval Time in SubSeconds
+ */
+uint32_t TIMER_IF_SIM_BkUp_Read_SubSeconds( void );
+
+/*!
+ * @brief Get the delay until the armed alarm expires
+ * @retval Delay in ticks, 0 when the alarm is already due,
+ *         TIMER_IF_SIM_NO_EVENT when no alarm is armed
+ */
+uint32_t TIMER_IF_SIM_GetNextEventDelay( void );
+
+/*!
+ * @brief Move the virtual clock forward
+ * @note The alarm is fired, through UTIL_TIMER_IRQ_Handler, each time it expires
+ *       on the way. The timers started from the fired callbacks are handled in
+ *       the same call when they expire before the end of the interval.
+ * @param [IN] ticks Duration to advance in ticks
+ */
+void TIMER_IF_SIM_Advance( uint32_t ticks );
+
+/*!
+ * @brief Move the virtual clock to the armed alarm and fire it
+ * @note This is the step function of a discrete-event simulation: the caller
+ *       runs its main loop processing (e.g. LoRaMacProcess) between two calls.
+ * @retval false when no alarm is armed, the clock is then left unchanged
+ */
+bool TIMER_IF_SIM_RunNextEvent( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32_TIMER_IF_SIM_H__ */